@@ -0,0 +1,23 @@
+TARGET = cutechess-agent
+DESTDIR = $$PWD
+
+OBJECTS_DIR = .obj/
+MOC_DIR = .moc/
+
+win32 {
+    CONFIG += console
+}
+
+!win32-msvc* {
+	QMAKE_CXXFLAGS += -Wextra -Wshadow
+}
+
+mac {
+    CONFIG -= app_bundle
+}
+
+QT = core network
+CONFIG += c++11
+
+# Code
+include(src/src.pri)
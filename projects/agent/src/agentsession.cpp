@@ -0,0 +1,131 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "agentsession.h"
+#include <QTcpSocket>
+#include <QProcess>
+#include <QTimer>
+
+AgentSession::AgentSession(QTcpSocket* socket, QObject* parent)
+	: QObject(parent),
+	  m_socket(socket),
+	  m_process(new QProcess(this)),
+	  m_killTimer(new QTimer(this)),
+	  m_started(false),
+	  m_finished(false)
+{
+	Q_ASSERT(socket != nullptr);
+
+	m_socket->setParent(this);
+	m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+	m_killTimer->setSingleShot(true);
+	m_killTimer->setInterval(5000);
+	connect(m_killTimer, SIGNAL(timeout()), m_process, SLOT(kill()));
+}
+
+bool AgentSession::start(const QString& command,
+			 const QStringList& arguments,
+			 const QString& workingDirectory)
+{
+	Q_ASSERT(!m_started);
+
+	m_process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	if (!workingDirectory.isEmpty())
+		m_process->setWorkingDirectory(workingDirectory);
+	m_process->start(command, arguments);
+
+	if (!m_process->waitForStarted())
+	{
+		m_error = m_process->errorString();
+		connect(m_socket, SIGNAL(disconnected()),
+			this, SLOT(checkFinished()));
+		m_socket->disconnectFromHost();
+		QMetaObject::invokeMethod(this, "checkFinished",
+					  Qt::QueuedConnection);
+		return false;
+	}
+	m_started = true;
+
+	connect(m_socket, SIGNAL(readyRead()),
+		this, SLOT(onSocketReadyRead()));
+	connect(m_socket, SIGNAL(disconnected()),
+		this, SLOT(onSocketDisconnected()));
+	connect(m_process, SIGNAL(readyReadStandardOutput()),
+		this, SLOT(onEngineReadyRead()));
+	connect(m_process, SIGNAL(finished(int,QProcess::ExitStatus)),
+		this, SLOT(onEngineFinished()));
+
+	// The client may have sent commands already
+	onSocketReadyRead();
+	return true;
+}
+
+bool AgentSession::isStarted() const
+{
+	return m_started;
+}
+
+QString AgentSession::errorString() const
+{
+	return m_error;
+}
+
+void AgentSession::onSocketReadyRead()
+{
+	if (m_process->state() == QProcess::Running)
+		m_process->write(m_socket->readAll());
+}
+
+void AgentSession::onEngineReadyRead()
+{
+	if (m_socket->state() == QAbstractSocket::ConnectedState)
+		m_socket->write(m_process->readAllStandardOutput());
+}
+
+void AgentSession::onSocketDisconnected()
+{
+	if (m_process->state() != QProcess::NotRunning)
+	{
+		// Give the engine a chance to exit cleanly
+		m_process->closeWriteChannel();
+		m_killTimer->start();
+	}
+	checkFinished();
+}
+
+void AgentSession::onEngineFinished()
+{
+	m_killTimer->stop();
+
+	// The engine is gone, so the client can't play with it anymore
+	onEngineReadyRead();
+	if (m_socket->state() != QAbstractSocket::UnconnectedState)
+		m_socket->disconnectFromHost();
+	checkFinished();
+}
+
+void AgentSession::checkFinished()
+{
+	if (m_finished
+	||  m_process->state() != QProcess::NotRunning
+	||  m_socket->state() != QAbstractSocket::UnconnectedState)
+		return;
+
+	m_finished = true;
+	emit finished();
+}
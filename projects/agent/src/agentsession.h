@@ -0,0 +1,84 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef AGENTSESSION_H
+#define AGENTSESSION_H
+
+#include <QObject>
+#include <QStringList>
+class QTcpSocket;
+class QProcess;
+class QTimer;
+
+/*!
+ * \brief An engine process connected to a TCP client.
+ *
+ * The session relays everything the client sends to the engine's
+ * standard input, and the engine's standard output back to the client.
+ * The engine's standard error goes to the agent's own.
+ *
+ * When the client disconnects, the engine's input is closed and the
+ * engine is killed if it doesn't exit in a few seconds. The finished()
+ * signal is emitted when both the engine and the connection are gone.
+ */
+class AgentSession : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*!
+		 * Creates a new session for \a socket.
+		 * The session takes ownership of the socket.
+		 */
+		AgentSession(QTcpSocket* socket, QObject* parent = nullptr);
+
+		/*!
+		 * Starts the engine \a command with \a arguments in
+		 * \a workingDirectory.
+		 *
+		 * Returns true if successful. On failure the connection is
+		 * closed and finished() is emitted later.
+		 */
+		bool start(const QString& command,
+			   const QStringList& arguments,
+			   const QString& workingDirectory);
+		/*! Returns true if the engine was started. */
+		bool isStarted() const;
+		/*! Returns a description of the last error. */
+		QString errorString() const;
+
+	signals:
+		/*! Emitted when the engine and the connection are closed. */
+		void finished();
+
+	private slots:
+		void onSocketReadyRead();
+		void onEngineReadyRead();
+		void onSocketDisconnected();
+		void onEngineFinished();
+		void checkFinished();
+
+	private:
+		QTcpSocket* m_socket;
+		QProcess* m_process;
+		QTimer* m_killTimer;
+		QString m_error;
+		bool m_started;
+		bool m_finished;
+};
+
+#endif // AGENTSESSION_H
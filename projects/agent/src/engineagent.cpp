@@ -0,0 +1,108 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engineagent.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include "agentsession.h"
+
+EngineAgent::EngineAgent(const QString& command,
+			 const QStringList& arguments,
+			 QObject* parent)
+	: QObject(parent),
+	  m_server(new QTcpServer(this)),
+	  m_command(command),
+	  m_arguments(arguments),
+	  m_maxSessions(0),
+	  m_sessionCount(0)
+{
+	connect(m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+void EngineAgent::setWorkingDirectory(const QString& dir)
+{
+	m_workingDirectory = dir;
+}
+
+void EngineAgent::setMaxSessions(int count)
+{
+	m_maxSessions = count;
+}
+
+bool EngineAgent::listen(const QString& host, quint16 port)
+{
+	QHostAddress address(QHostAddress::Any);
+	if (!host.isEmpty() && !address.setAddress(host))
+	{
+		qWarning("Invalid host address: %s", qPrintable(host));
+		return false;
+	}
+
+	return m_server->listen(address, port);
+}
+
+QString EngineAgent::errorString() const
+{
+	return m_server->errorString();
+}
+
+void EngineAgent::onNewConnection()
+{
+	while (m_server->hasPendingConnections())
+	{
+		QTcpSocket* socket = m_server->nextPendingConnection();
+		const QString peer = QString("%1:%2")
+			.arg(socket->peerAddress().toString())
+			.arg(socket->peerPort());
+
+		if (m_maxSessions > 0 && m_sessionCount >= m_maxSessions)
+		{
+			qWarning("Rejecting %s: too many engines running",
+				 qPrintable(peer));
+			socket->disconnectFromHost();
+			connect(socket, SIGNAL(disconnected()),
+				socket, SLOT(deleteLater()));
+			continue;
+		}
+
+		AgentSession* session = new AgentSession(socket, this);
+		connect(session, SIGNAL(finished()),
+			this, SLOT(onSessionFinished()));
+		if (!session->start(m_command, m_arguments, m_workingDirectory))
+		{
+			qWarning("Cannot start engine for %s: %s",
+				 qPrintable(peer),
+				 qPrintable(session->errorString()));
+			continue;
+		}
+
+		m_sessionCount++;
+		qDebug("Started engine for %s", qPrintable(peer));
+	}
+}
+
+void EngineAgent::onSessionFinished()
+{
+	AgentSession* session = qobject_cast<AgentSession*>(QObject::sender());
+	Q_ASSERT(session != nullptr);
+
+	if (session->isStarted())
+		m_sessionCount--;
+	session->deleteLater();
+}
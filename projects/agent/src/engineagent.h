@@ -0,0 +1,75 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEAGENT_H
+#define ENGINEAGENT_H
+
+#include <QObject>
+#include <QStringList>
+class QTcpServer;
+
+/*!
+ * \brief A server that runs a chess engine for each TCP client.
+ *
+ * Every connection gets its own engine process, started with the
+ * command given to the agent. The engine's standard input and output
+ * are relayed over the connection, and the engine is stopped when the
+ * client disconnects.
+ *
+ * Clients can't choose what is run, so an agent only ever starts the
+ * engine it was set up with.
+ */
+class EngineAgent : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new agent for \a command with \a arguments. */
+		EngineAgent(const QString& command,
+			    const QStringList& arguments,
+			    QObject* parent = nullptr);
+
+		/*! Sets the working directory of the engines to \a dir. */
+		void setWorkingDirectory(const QString& dir);
+		/*!
+		 * Sets the maximum number of concurrent engines to \a count.
+		 * The default is 0 (no limit).
+		 */
+		void setMaxSessions(int count);
+
+		/*!
+		 * Starts listening for connections on \a host and \a port.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool listen(const QString& host, quint16 port);
+		/*! Returns a description of the last error. */
+		QString errorString() const;
+
+	private slots:
+		void onNewConnection();
+		void onSessionFinished();
+
+	private:
+		QTcpServer* m_server;
+		QString m_command;
+		QStringList m_arguments;
+		QString m_workingDirectory;
+		int m_maxSessions;
+		int m_sessionCount;
+};
+
+#endif // ENGINEAGENT_H
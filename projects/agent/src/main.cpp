@@ -0,0 +1,115 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include "engineagent.h"
+
+static void printUsage()
+{
+	QTextStream out(stdout);
+	out << "Usage: cutechess-agent [-host ADDR] -port N [-dir DIR] "
+	       "[-max N] [--] COMMAND [ARG...]" << endl << endl;
+	out << "Serves the chess engine COMMAND to cutechess-cli over TCP."
+	    << endl << "Every connection gets its own engine process." << endl
+	    << endl;
+	out << "  -host ADDR	Listen on address ADDR (default: all)" << endl;
+	out << "  -port N	Listen on port N" << endl;
+	out << "  -dir DIR	Run the engines in directory DIR" << endl;
+	out << "  -max N	Run at most N engines at a time" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	setvbuf(stdout, nullptr, _IONBF, 0);
+
+	QCoreApplication app(argc, argv);
+
+	QStringList arguments = QCoreApplication::arguments();
+	arguments.takeFirst(); // application name
+
+	QString host;
+	QString dir;
+	int port = 0;
+	int maxSessions = 0;
+
+	while (!arguments.isEmpty())
+	{
+		const QString arg = arguments.first();
+		if (!arg.startsWith('-'))
+			break;
+		arguments.takeFirst();
+
+		if (arg == "--")
+			break;
+		if (arg == "-help" || arg == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		if (arguments.isEmpty())
+		{
+			qWarning("Missing value for option \"%s\"", qPrintable(arg));
+			return 1;
+		}
+
+		const QString value = arguments.takeFirst();
+		bool ok = true;
+		if (arg == "-host")
+			host = value;
+		else if (arg == "-port")
+			port = value.toInt(&ok);
+		else if (arg == "-dir")
+			dir = value;
+		else if (arg == "-max")
+			maxSessions = value.toInt(&ok);
+		else
+		{
+			qWarning("Unknown option: \"%s\"", qPrintable(arg));
+			return 1;
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qPrintable(arg), qPrintable(value));
+			return 1;
+		}
+	}
+
+	if (port <= 0 || port > 65535 || maxSessions < 0 || arguments.isEmpty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	const QString command = arguments.takeFirst();
+	EngineAgent agent(command, arguments);
+	agent.setWorkingDirectory(dir);
+	agent.setMaxSessions(maxSessions);
+
+	if (!agent.listen(host, quint16(port)))
+	{
+		qWarning("Cannot listen on port %d: %s", port,
+			 qPrintable(agent.errorString()));
+		return 1;
+	}
+
+	return app.exec();
+}
@@ -0,0 +1,6 @@
+DEPENDPATH += $$PWD
+HEADERS += $$PWD/engineagent.h \
+    $$PWD/agentsession.h
+SOURCES += $$PWD/main.cpp \
+    $$PWD/engineagent.cpp \
+    $$PWD/agentsession.cpp
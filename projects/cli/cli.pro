@@ -27,7 +27,7 @@ mac {
     CONFIG -= app_bundle
 }
 
-QT = core
+QT = core network
 
 # Code
 include(src/src.pri)
@@ -0,0 +1,430 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bookbuilder.h"
+#include "pgnblockreader.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QThreadPool>
+#include <polyglotbook.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+
+namespace {
+
+// Number of records read at a time from each run during the merge
+const int s_mergeBufferSize = 16 * 1024;
+
+quint32 encodeMove(const Chess::GenericMove& move)
+{
+	const Chess::Square& src = move.sourceSquare();
+	const Chess::Square& trg = move.targetSquare();
+
+	return (quint32(src.file()) << 20) | (quint32(src.rank()) << 16)
+	     | (quint32(trg.file()) << 12) | (quint32(trg.rank()) << 8)
+	     |  quint32(move.promotion());
+}
+
+Chess::GenericMove decodeMove(quint32 move)
+{
+	return Chess::GenericMove(
+		Chess::Square((move >> 20) & 0xf, (move >> 16) & 0xf),
+		Chess::Square((move >> 12) & 0xf, (move >> 8) & 0xf),
+		move & 0xff);
+}
+
+/*
+ * Gives access to PolyglotBook's entry format.
+ */
+class BookWriter : public PolyglotBook
+{
+	public:
+		void write(QDataStream& out, quint64 key, const Entry& entry)
+		{
+			Map map;
+			map.insert(key, entry);
+			writeEntry(map.constBegin(), out);
+		}
+};
+
+} // anonymous namespace
+
+BookBuilder::BookBuilder()
+	: m_maxPlies(32),
+	  m_minGames(1),
+	  m_tempPath(QDir::tempPath()),
+	  m_memoryLimit(Q_INT64_C(512) * 1024 * 1024),
+	  m_runSize(0),
+	  m_error(false),
+	  m_entryCount(0)
+{
+}
+
+void BookBuilder::setMaxPlies(int plies)
+{
+	Q_ASSERT(plies > 0);
+	m_maxPlies = plies;
+}
+
+void BookBuilder::setMinGames(int count)
+{
+	Q_ASSERT(count > 0);
+	m_minGames = count;
+}
+
+void BookBuilder::setTempPath(const QString& path)
+{
+	m_tempPath = path;
+}
+
+void BookBuilder::setMemoryLimit(qint64 bytes)
+{
+	Q_ASSERT(bytes > 0);
+	m_memoryLimit = bytes;
+}
+
+int BookBuilder::gameCount() const
+{
+	return m_gameCount.load();
+}
+
+qint64 BookBuilder::entryCount() const
+{
+	return m_entryCount;
+}
+
+bool BookBuilder::lessThan(const Record& a, const Record& b)
+{
+	if (a.key != b.key)
+		return a.key < b.key;
+	return a.move < b.move;
+}
+
+void BookBuilder::aggregate(QVector<Record>& records)
+{
+	if (records.isEmpty())
+		return;
+
+	std::sort(records.begin(), records.end(), lessThan);
+
+	int n = 0;
+	for (int i = 1; i < records.size(); i++)
+	{
+		Record& last = records[n];
+		const Record& rec = records.at(i);
+		if (rec.key == last.key && rec.move == last.move)
+		{
+			last.wins += rec.wins;
+			last.draws += rec.draws;
+			last.losses += rec.losses;
+		}
+		else
+			records[++n] = rec;
+	}
+	records.resize(n + 1);
+}
+
+bool BookBuilder::run(QIODevice* input, const QString& fileName)
+{
+	Q_ASSERT(input != nullptr && input->isOpen());
+
+	m_buffer.clear();
+	m_error = false;
+	m_gameCount.store(0);
+	m_entryCount = 0;
+
+	PgnBlockReader reader(input);
+	if (!reader.open())
+		return false;
+
+	// The blocks in flight and the buffer being written to a run
+	// take about as much memory as the buffer of the current run
+	const int threadCount = QThread::idealThreadCount();
+	const int maxBlocks = 2 * threadCount;
+	const qint64 runMemory = qMax(m_memoryLimit / 2, Q_INT64_C(1024) * 1024);
+	m_runSize = int(qMin(runMemory / qint64(sizeof(Record)),
+			     qint64(INT_MAX / 2)));
+	m_freeBlocks.release(maxBlocks);
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount);
+
+	QByteArray block;
+	qint64 lineNumber = 1;
+	while (reader.readBlock(&block, &lineNumber))
+	{
+		m_freeBlocks.acquire();
+		{
+			QMutexLocker locker(&m_mutex);
+			if (m_error)
+			{
+				m_freeBlocks.release();
+				break;
+			}
+		}
+
+		const qint64 blockLine = lineNumber;
+		pool.start(new PgnBlockTask([=]()
+		{
+			processBlock(block, blockLine);
+		}));
+	}
+
+	pool.waitForDone();
+	m_freeBlocks.acquire(maxBlocks);
+
+	if (!m_buffer.isEmpty())
+	{
+		QVector<Record> records;
+		records.swap(m_buffer);
+		writeRun(records);
+	}
+
+	const bool ok = !m_error && merge(fileName);
+	qDeleteAll(m_runs);
+	m_runs.clear();
+
+	return ok;
+}
+
+void BookBuilder::processBlock(const QByteArray& block, qint64 lineNumber)
+{
+	PgnStream in;
+	in.setData(block.constData(), block.size());
+	in.seek(0, lineNumber);
+
+	QVector<Record> records;
+	PgnGame game;
+
+	while (game.read(in, m_maxPlies, false))
+	{
+		const Chess::Result result(game.result());
+		if (game.variant() != "standard"
+		||  result.isNone()
+		||  result.type() == Chess::Result::ResultError)
+			continue;
+		m_gameCount.ref();
+
+		const Chess::Side winner(result.winner());
+		Chess::Side side(game.startingSide());
+		const auto& moves = game.moves();
+		for (const auto& md : moves)
+		{
+			Record rec = { md.key, encodeMove(md.move), 0, 0, 0 };
+			if (winner.isNull())
+				rec.draws = 1;
+			else if (winner == side)
+				rec.wins = 1;
+			else
+				rec.losses = 1;
+			records.append(rec);
+			side = side.opposite();
+		}
+	}
+
+	// Opening positions repeat a lot, so this shrinks the block's
+	// records considerably
+	aggregate(records);
+	commit(records);
+	m_freeBlocks.release();
+}
+
+void BookBuilder::commit(QVector<Record>& records)
+{
+	QMutexLocker locker(&m_mutex);
+	m_buffer += records;
+	if (m_buffer.size() < m_runSize)
+		return;
+
+	// Other threads can fill the next run while this one is written
+	QVector<Record> run;
+	run.swap(m_buffer);
+	locker.unlock();
+
+	writeRun(run);
+}
+
+void BookBuilder::writeRun(QVector<Record>& records)
+{
+	aggregate(records);
+
+	QTemporaryFile* file = new QTemporaryFile(
+		QDir(m_tempPath).filePath("cutechess-book-XXXXXX"));
+	const qint64 size = qint64(records.size()) * sizeof(Record);
+	if (!file->open()
+	||  file->write(reinterpret_cast<const char*>(records.constData()),
+			size) != size
+	||  !file->flush())
+	{
+		qWarning("Could not write temporary file %s",
+			 qPrintable(file->fileName()));
+		delete file;
+
+		QMutexLocker locker(&m_mutex);
+		m_error = true;
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	m_runs.append(file);
+}
+
+bool BookBuilder::merge(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Could not open book file %s", qPrintable(fileName));
+		return false;
+	}
+	QDataStream out(&file);
+
+	struct Run
+	{
+		QTemporaryFile* file;
+		QVector<Record> buffer;
+		int pos;
+	};
+	QVector<Run> runs;
+	for (QTemporaryFile* runFile : m_runs)
+	{
+		runFile->seek(0);
+		runs.append({ runFile, QVector<Record>(), 0 });
+	}
+
+	// Returns the next record of run i, or false at the end
+	auto next = [&](int i, Record* rec) -> bool
+	{
+		Run& run = runs[i];
+		if (run.pos >= run.buffer.size())
+		{
+			run.buffer.resize(s_mergeBufferSize);
+			const qint64 n = run.file->read(
+				reinterpret_cast<char*>(run.buffer.data()),
+				qint64(s_mergeBufferSize) * sizeof(Record));
+			run.buffer.resize(int(qMax(n, qint64(0)) / sizeof(Record)));
+			run.pos = 0;
+			if (run.buffer.isEmpty())
+				return false;
+		}
+		*rec = run.buffer.at(run.pos++);
+		return true;
+	};
+
+	typedef QPair<Record, int> Head;
+	auto greater = [](const Head& a, const Head& b)
+	{
+		return lessThan(b.first, a.first);
+	};
+	std::priority_queue<Head, std::vector<Head>, decltype(greater)>
+		heads(greater);
+	for (int i = 0; i < runs.size(); i++)
+	{
+		Record rec;
+		if (next(i, &rec))
+			heads.push(qMakePair(rec, i));
+	}
+
+	// The records come out sorted, so all moves of a position are
+	// collected before they're written
+	QVector<Record> position;
+	while (!heads.empty())
+	{
+		const Head head(heads.top());
+		heads.pop();
+
+		Record rec;
+		if (next(head.second, &rec))
+			heads.push(qMakePair(rec, head.second));
+
+		const Record& cur = head.first;
+		if (!position.isEmpty() && position.last().key != cur.key)
+		{
+			writePosition(position, out);
+			position.clear();
+		}
+		if (!position.isEmpty() && position.last().move == cur.move)
+		{
+			Record& last = position.last();
+			last.wins += cur.wins;
+			last.draws += cur.draws;
+			last.losses += cur.losses;
+		}
+		else
+			position.append(cur);
+	}
+	writePosition(position, out);
+
+	if (out.status() != QDataStream::Ok || !file.flush())
+	{
+		qWarning("Could not write book file %s", qPrintable(fileName));
+		return false;
+	}
+	return true;
+}
+
+void BookBuilder::writePosition(QVector<Record>& records, QDataStream& out)
+{
+	QVector<OpeningBook::Entry> entries;
+	quint64 maxScore = 0;
+	for (const Record& rec : records)
+	{
+		const quint64 games = quint64(rec.wins) + rec.draws + rec.losses;
+		const quint64 score = 2 * quint64(rec.wins) + rec.draws;
+		if (games < quint64(m_minGames) || score == 0)
+			continue;
+		maxScore = qMax(maxScore, score);
+	}
+	if (maxScore == 0)
+		return;
+
+	const double scale = qMin(1.0, 65535.0 / double(maxScore));
+	for (const Record& rec : records)
+	{
+		const quint64 games = quint64(rec.wins) + rec.draws + rec.losses;
+		const quint64 score = 2 * quint64(rec.wins) + rec.draws;
+		if (games < quint64(m_minGames) || score == 0)
+			continue;
+
+		const quint16 weight = quint16(qBound(1.0, double(score) * scale,
+						      65535.0));
+		const quint32 percent = quint32(10000 * score / (2 * games));
+		const quint32 learn = (quint32(qMin(games, quint64(0xffff))) << 16)
+				    | percent;
+		entries.append({ decodeMove(rec.move), weight, learn });
+	}
+
+	// The most popular moves go first, like in other Polyglot books
+	std::stable_sort(entries.begin(), entries.end(),
+		[](const OpeningBook::Entry& a, const OpeningBook::Entry& b)
+	{
+		return a.weight > b.weight;
+	});
+
+	BookWriter writer;
+	for (const auto& entry : entries)
+		writer.write(out, records.first().key, entry);
+	m_entryCount += entries.size();
+}
@@ -0,0 +1,115 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOKBUILDER_H
+#define BOOKBUILDER_H
+
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QString>
+class QIODevice;
+class QDataStream;
+class QTemporaryFile;
+
+
+/*!
+ * \brief A builder for Polyglot opening books.
+ *
+ * BookBuilder reads games from a PGN stream and creates a Polyglot book
+ * of the moves played in them. The games are parsed on a thread pool,
+ * and each played move becomes a (position key, move, result) record.
+ * The records are sorted and aggregated in memory until the memory
+ * limit is reached, and then written to a temporary file as a sorted
+ * run. Finally the runs are merged into the book, so the size of the
+ * input is only limited by disk space.
+ *
+ * The weight of a book move is its score in half-points, so wins count
+ * twice as much as draws and moves that only lost are left out. Moves
+ * of the same position are scaled down together if their weights don't
+ * fit in 16 bits. The learn field holds the number of games (at most
+ * 65535) in its high 16 bits and the score percentage times 100 in its
+ * low 16 bits.
+ */
+class BookBuilder
+{
+	public:
+		/*! Creates a new book builder. */
+		BookBuilder();
+
+		/*! Sets the maximum number of plies read from each game. */
+		void setMaxPlies(int plies);
+		/*! Sets the minimum number of games for a book move. */
+		void setMinGames(int count);
+		/*!
+		 * Sets the directory for the temporary files to \a path.
+		 * The default is the system's temporary directory.
+		 */
+		void setTempPath(const QString& path);
+		/*! Sets the approximate memory limit to \a bytes. */
+		void setMemoryLimit(qint64 bytes);
+
+		/*!
+		 * Reads the games from \a input, which must be open, and
+		 * writes the book to \a fileName.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool run(QIODevice* input, const QString& fileName);
+
+		/*! Returns the number of games that were used. */
+		int gameCount() const;
+		/*! Returns the number of entries in the book. */
+		qint64 entryCount() const;
+
+	private:
+		struct Record
+		{
+			quint64 key;
+			quint32 move;
+			quint32 wins;
+			quint32 draws;
+			quint32 losses;
+		};
+
+		static bool lessThan(const Record& a, const Record& b);
+		static void aggregate(QVector<Record>& records);
+
+		void processBlock(const QByteArray& block, qint64 lineNumber);
+		void commit(QVector<Record>& records);
+		void writeRun(QVector<Record>& records);
+		bool merge(const QString& fileName);
+		void writePosition(QVector<Record>& records, QDataStream& out);
+
+		int m_maxPlies;
+		int m_minGames;
+		QString m_tempPath;
+		qint64 m_memoryLimit;
+		int m_runSize;
+
+		QSemaphore m_freeBlocks;
+		QMutex m_mutex;
+		QVector<Record> m_buffer;
+		QList<QTemporaryFile*> m_runs;
+		bool m_error;
+		QAtomicInt m_gameCount;
+		qint64 m_entryCount;
+};
+
+#endif // BOOKBUILDER_H
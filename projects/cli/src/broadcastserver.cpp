@@ -0,0 +1,320 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "broadcastserver.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QJsonDocument>
+#include <board/board.h>
+#include <chessgame.h>
+#include <chessplayer.h>
+#include <moveevaluation.h>
+#include <tournament.h>
+
+namespace {
+
+// Longest accepted request header
+const int MaxRequestSize = 8192;
+// Unsent bytes in a viewer's socket that hold back new events
+const qint64 MaxBufferedBytes = 64 * 1024;
+// Events a viewer can fall behind before it's disconnected
+const int MaxQueuedEvents = 10000;
+
+QByteArray serverSentEvent(const char* type, const QVariantMap& data)
+{
+	// Compact JSON has no line breaks, so it fits on one data line
+	QByteArray event("event: ");
+	event += type;
+	event += "\ndata: ";
+	event += QJsonDocument::fromVariant(data).toJson(QJsonDocument::Compact);
+	event += "\n\n";
+	return event;
+}
+
+} // anonymous namespace
+
+BroadcastServer::BroadcastServer(Tournament* tournament, QObject* parent)
+	: QObject(parent),
+	  m_tournament(tournament),
+	  m_server(new QTcpServer(this))
+{
+	Q_ASSERT(tournament != nullptr);
+
+	// The evaluations come from the players in the game threads
+	qRegisterMetaType<MoveEvaluation>("MoveEvaluation");
+
+	connect(m_tournament, SIGNAL(gameStarted(ChessGame*, int, int, int)),
+		this, SLOT(onGameStarted(ChessGame*, int)));
+	connect(m_tournament, SIGNAL(gameFinished(ChessGame*, int, int, int)),
+		this, SLOT(onGameFinished(ChessGame*, int)));
+	connect(m_tournament, SIGNAL(moveAdded(int, int, QString, QString)),
+		this, SLOT(onMoveAdded(int, int, QString, QString)));
+	connect(m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+bool BroadcastServer::listen(const QHostAddress& address, quint16 port)
+{
+	if (!m_server->listen(address, port))
+	{
+		qWarning("Cannot listen for broadcast viewers on port %d: %s",
+			 port, qPrintable(m_server->errorString()));
+		return false;
+	}
+
+	return true;
+}
+
+void BroadcastServer::onGameStarted(ChessGame* game, int number)
+{
+	GameState& state = m_games[number];
+	state.white = game->player(Chess::Side::White)->name();
+	state.black = game->player(Chess::Side::Black)->name();
+	state.fen = game->startingFen().isEmpty()
+		? game->board()->defaultFenString() : game->startingFen();
+
+	for (int i = 0; i < 2; i++)
+	{
+		const Chess::Side side = Chess::Side::Type(i);
+		ChessPlayer* player = game->player(side);
+		m_players[player] = { number, side };
+		// The players are reused by the next games
+		connect(player, SIGNAL(thinking(MoveEvaluation)),
+			this, SLOT(onThinking(MoveEvaluation)),
+			Qt::UniqueConnection);
+	}
+
+	QVariantMap data;
+	data["game"] = number;
+	data["white"] = state.white;
+	data["black"] = state.black;
+	data["fen"] = state.fen;
+	publish(number, serverSentEvent("start", data), false);
+}
+
+void BroadcastServer::onGameFinished(ChessGame* game, int number)
+{
+	for (auto it = m_players.begin(); it != m_players.end(); )
+	{
+		if (it->game == number)
+			it = m_players.erase(it);
+		else
+			++it;
+	}
+	if (!m_games.remove(number))
+		return;
+
+	const Chess::Result result(game->result());
+	QVariantMap data;
+	data["game"] = number;
+	data["result"] = result.toShortString();
+	data["reason"] = result.description();
+	publish(number, serverSentEvent("end", data), false);
+}
+
+void BroadcastServer::onMoveAdded(int number, int ply,
+				  const QString& move, const QString& comment)
+{
+	auto it = m_games.find(number);
+	if (it == m_games.end())
+		return;
+
+	it->moves.append(move);
+	it->eval.clear();
+
+	QVariantMap data;
+	data["game"] = number;
+	data["ply"] = ply;
+	data["move"] = move;
+	if (!comment.isEmpty())
+		data["comment"] = comment;
+	publish(number, serverSentEvent("move", data), false);
+}
+
+void BroadcastServer::onThinking(const MoveEvaluation& eval)
+{
+	// A player's evaluations can arrive after its game is finished
+	const auto player = m_players.constFind(sender());
+	if (player == m_players.constEnd() || eval.isEmpty())
+		return;
+	auto game = m_games.find(player->game);
+	if (game == m_games.end())
+		return;
+
+	QVariantMap data;
+	data["game"] = player->game;
+	data["side"] = player->side == Chess::Side::White ? "white" : "black";
+	data["depth"] = eval.depth();
+	data["score"] = eval.scoreText();
+	data["nodes"] = eval.nodeCount();
+	data["time"] = eval.time();
+	data["pv"] = eval.pv();
+	game->eval = data;
+	publish(player->game, serverSentEvent("eval", data), true);
+}
+
+void BroadcastServer::publish(int game, const QByteArray& event, bool isEval)
+{
+	QList<QTcpSocket*> lagging;
+	for (auto it = m_clients.begin(); it != m_clients.end(); ++it)
+	{
+		Client& client = it.value();
+
+		// A newer evaluation replaces an unsent one, and a move
+		// makes the unsent evaluation of its game obsolete
+		if (isEval)
+			client.evals[game] = event;
+		else
+		{
+			client.evals.remove(game);
+			client.events.append(event);
+		}
+
+		flush(it.key(), client);
+		if (client.events.size() > MaxQueuedEvents)
+			lagging.append(it.key());
+	}
+
+	for (QTcpSocket* socket : lagging)
+	{
+		m_clients.remove(socket);
+		socket->abort();
+	}
+}
+
+void BroadcastServer::flush(QTcpSocket* socket, Client& client)
+{
+	while (socket->bytesToWrite() < MaxBufferedBytes
+	&&     !client.events.isEmpty())
+		socket->write(client.events.takeFirst());
+	while (socket->bytesToWrite() < MaxBufferedBytes
+	&&     !client.evals.isEmpty())
+		socket->write(client.evals.take(client.evals.firstKey()));
+}
+
+QByteArray BroadcastServer::snapshot() const
+{
+	QVariantList games;
+	for (auto it = m_games.constBegin(); it != m_games.constEnd(); ++it)
+	{
+		QVariantMap game;
+		game["game"] = it.key();
+		game["white"] = it->white;
+		game["black"] = it->black;
+		game["fen"] = it->fen;
+		game["moves"] = it->moves;
+		if (!it->eval.isEmpty())
+			game["eval"] = it->eval;
+		games.append(game);
+	}
+
+	QVariantMap data;
+	data["games"] = games;
+	return serverSentEvent("snapshot", data);
+}
+
+void BroadcastServer::onNewConnection()
+{
+	while (m_server->hasPendingConnections())
+	{
+		QTcpSocket* socket = m_server->nextPendingConnection();
+		connect(socket, SIGNAL(readyRead()),
+			this, SLOT(onReadyRead()));
+		connect(socket, SIGNAL(disconnected()),
+			this, SLOT(onDisconnected()));
+		connect(socket, SIGNAL(disconnected()),
+			socket, SLOT(deleteLater()));
+	}
+}
+
+void BroadcastServer::onReadyRead()
+{
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+	if (socket == nullptr)
+		return;
+
+	// Read the request line and headers up to the empty line
+	QByteArray request = socket->property("request").toByteArray();
+	bool complete = false;
+	while (socket->canReadLine())
+	{
+		const QByteArray line = socket->readLine();
+		if (line.trimmed().isEmpty())
+		{
+			complete = true;
+			break;
+		}
+		if (request.isEmpty())
+			request = line.trimmed();
+	}
+	socket->setProperty("request", request);
+
+	if (!complete && socket->bytesAvailable() < MaxRequestSize)
+		return;
+	disconnect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+	const QList<QByteArray> words = request.split(' ');
+	QByteArray status;
+	QByteArray body;
+	if (words.size() < 2 || words.at(0) != "GET")
+	{
+		status = "405 Method Not Allowed";
+		body = "Only GET requests are supported\n";
+	}
+	else if (words.at(1) != "/events")
+	{
+		status = "404 Not Found";
+		body = "Not found\n";
+	}
+	else
+	{
+		// The stream stays open, and the viewer's events are
+		// written as the socket drains
+		socket->write("HTTP/1.1 200 OK\r\n"
+			      "Content-Type: text/event-stream\r\n"
+			      "Cache-Control: no-cache\r\n"
+			      "Access-Control-Allow-Origin: *\r\n"
+			      "Connection: keep-alive\r\n\r\n");
+		socket->write(snapshot());
+		m_clients.insert(socket, Client());
+		connect(socket, SIGNAL(bytesWritten(qint64)),
+			this, SLOT(onBytesWritten()));
+		return;
+	}
+
+	QByteArray response("HTTP/1.1 " + status + "\r\n");
+	response += "Content-Type: text/plain; charset=utf-8\r\n";
+	response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+	response += "Connection: close\r\n\r\n";
+	response += body;
+
+	socket->write(response);
+	socket->disconnectFromHost();
+}
+
+void BroadcastServer::onBytesWritten()
+{
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+	auto it = m_clients.find(socket);
+	if (it != m_clients.end())
+		flush(socket, it.value());
+}
+
+void BroadcastServer::onDisconnected()
+{
+	m_clients.remove(static_cast<QTcpSocket*>(sender()));
+}
@@ -0,0 +1,110 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BROADCASTSERVER_H
+#define BROADCASTSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QStringList>
+#include <QVariantMap>
+#include <QHostAddress>
+#include <board/side.h>
+class ChessGame;
+class Tournament;
+class MoveEvaluation;
+class QTcpServer;
+class QTcpSocket;
+
+/*!
+ * \brief A live broadcast of the games of a tournament.
+ *
+ * BroadcastServer streams the running games to any number of viewers
+ * as Server-Sent Events at "GET /events". A new viewer first gets a
+ * "snapshot" event with the players, starting position, moves and
+ * latest evaluation of every running game, and then "start", "move",
+ * "eval" and "end" events as the games go on. The data of every event
+ * is a JSON object with the game number in "game".
+ *
+ * Every event is serialized once and the same buffer is queued for
+ * every viewer. A viewer that can't keep up doesn't slow down the
+ * games or the other viewers: while its socket has too much unsent
+ * data, only the latest evaluation of each game is kept for it, and
+ * a viewer that falls too far behind on moves is disconnected.
+ */
+class BroadcastServer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new server for the games of \a tournament. */
+		BroadcastServer(Tournament* tournament, QObject* parent = nullptr);
+
+		/*!
+		 * Starts listening for connections on \a port of
+		 * \a address.
+		 *
+		 * Returns false and prints a warning on failure.
+		 */
+		bool listen(const QHostAddress& address, quint16 port);
+
+	private slots:
+		void onGameStarted(ChessGame* game, int number);
+		void onGameFinished(ChessGame* game, int number);
+		void onMoveAdded(int number, int ply,
+				 const QString& move, const QString& comment);
+		void onThinking(const MoveEvaluation& eval);
+		void onNewConnection();
+		void onReadyRead();
+		void onBytesWritten();
+		void onDisconnected();
+
+	private:
+		struct GameState
+		{
+			QString white;
+			QString black;
+			QString fen;
+			QStringList moves;
+			QVariantMap eval;
+		};
+		struct PlayerState
+		{
+			int game;
+			Chess::Side side;
+		};
+		struct Client
+		{
+			QList<QByteArray> events;
+			// The latest unsent evaluation of each game
+			QMap<int, QByteArray> evals;
+		};
+
+		void publish(int game, const QByteArray& event, bool isEval);
+		void flush(QTcpSocket* socket, Client& client);
+		QByteArray snapshot() const;
+
+		Tournament* m_tournament;
+		QTcpServer* m_server;
+		QMap<int, GameState> m_games;
+		QHash<const QObject*, PlayerState> m_players;
+		QHash<QTcpSocket*, Client> m_clients;
+};
+
+#endif // BROADCASTSERVER_H
@@ -17,57 +17,88 @@
 
 #include "econode.h"
 #include "board/board.h"
+#include "board/syzygytablebase.h"
 
 #include "enginematch.h"
+#include <cmath>
 #include <QtMath>
 #include <QMultiMap>
 #include <QTextCodec>
+#include <QTimer>
+#include <QTextStream>
+#include <QSysInfo>
 #include <chessplayer.h>
 #include <playerbuilder.h>
 #include <chessgame.h>
-#include <polyglotbook.h>
+#include <openingbookregistry.h>
 #include <tournament.h>
 #include <gamemanager.h>
 #include <sprt.h>
-#include <jsonparser.h>
-#include <jsonserializer.h>
+#include <memorystats.h>
+#include <bootstrapratings.h>
+#include "tournamentjournal.h"
+
+namespace {
+
+QString formatTime(qint64 msecs)
+{
+	const qint64 secs = msecs / 1000;
+	return QString("%1:%2:%3")
+		.arg(secs / 3600, 2, 10, QChar('0'))
+		.arg((secs / 60) % 60, 2, 10, QChar('0'))
+		.arg(secs % 60, 2, 10, QChar('0'));
+}
+
+} // anonymous namespace
 
 EngineMatch::EngineMatch(Tournament* tournament, QObject* parent)
 	: QObject(parent),
 	  m_tournament(tournament),
 	  m_debug(false),
+	  m_memoryDebug(false),
+	  m_sharedGameManager(false),
 	  m_ratingInterval(0),
+	  m_bootstrapInterval(false),
 	  m_bookMode(OpeningBook::Ram),
+	  m_journal(nullptr),
+	  m_reportTimer(new QTimer(this)),
 	  m_eloKfactor(15.0)
 {
 	Q_ASSERT(tournament != nullptr);
 
+	// The schedule and crosstable files are rewritten at most
+	// once per interval
+	m_reportTimer->setSingleShot(true);
+	m_reportTimer->setInterval(10000);
+	connect(m_reportTimer, SIGNAL(timeout()),
+		this, SLOT(writeReports()));
+
 	m_startTime.start();
 }
 
 EngineMatch::~EngineMatch()
 {
-	qDeleteAll(m_books);
+	delete m_journal;
 }
 
-OpeningBook* EngineMatch::addOpeningBook(const QString& fileName)
+const OpeningBook* EngineMatch::addOpeningBook(const QString& fileName)
 {
 	if (fileName.isEmpty())
 		return nullptr;
 
 	if (m_books.contains(fileName))
-		return m_books[fileName];
+		return m_books[fileName].data();
 
-	PolyglotBook* book = new PolyglotBook(m_bookMode);
-	if (!book->read(fileName))
+	// Engines that use the same book file share one instance
+	auto book = OpeningBookRegistry::polyglotBook(fileName, m_bookMode);
+	if (book.isNull())
 	{
-		delete book;
 		qWarning("Can't read opening book file %s", qPrintable(fileName));
 		return nullptr;
 	}
 
 	m_books[fileName] = book;
-	return book;
+	return book.data();
 }
 
 void EngineMatch::start()
@@ -96,20 +127,43 @@ void EngineMatch::setDebugMode(bool debug)
 	m_debug = debug;
 }
 
+void EngineMatch::setMemoryDebug(bool enabled)
+{
+	m_memoryDebug = enabled;
+}
+
+void EngineMatch::setSharedGameManager(bool shared)
+{
+	m_sharedGameManager = shared;
+}
+
 void EngineMatch::setRatingInterval(int interval)
 {
 	Q_ASSERT(interval >= 0);
 	m_ratingInterval = interval;
 }
 
+void EngineMatch::setBootstrapInterval(bool enabled)
+{
+	m_bootstrapInterval = enabled;
+}
+
 void EngineMatch::setBookMode(OpeningBook::AccessMode mode)
 {
 	m_bookMode = mode;
 }
 
-void EngineMatch::setTournamentFile(QString& tournamentFile)
+void EngineMatch::setTournamentFile(QString& tournamentFile,
+				    const QString& progressFile)
 {
 	m_tournamentFile = tournamentFile;
+	delete m_journal;
+	m_journal = new TournamentJournal(progressFile);
+}
+
+void EngineMatch::setProgress(const QVariantList& progress)
+{
+	m_progress = progress;
 }
 
 void EngineMatch::setEloKfactor(qreal eloKfactor)
@@ -117,8 +171,31 @@ void EngineMatch::setEloKfactor(qreal eloKfactor)
 	m_eloKfactor = eloKfactor;
 }
 
-void EngineMatch::generateSchedule(QVariantList& pList)
+void EngineMatch::setReportInterval(int msecs)
+{
+	Q_ASSERT(msecs >= 0);
+	m_reportTimer->setInterval(msecs);
+}
+
+void EngineMatch::scheduleReports()
+{
+	if (!m_reportTimer->isActive())
+		m_reportTimer->start();
+}
+
+void EngineMatch::writeReports()
 {
+	m_reportTimer->stop();
+	if (m_journal == nullptr || m_progress.isEmpty())
+		return;
+
+	writeSchedule();
+	writeCrossTable();
+}
+
+void EngineMatch::writeSchedule()
+{
+	const QVariantList& pList = m_progress;
 	QVariantMap pMap;
 
 	QList< QPair<QString, QString> > pairings = m_tournament->getPairings();
@@ -257,51 +334,6 @@ void EngineMatch::generateSchedule(QVariantList& pList)
 	}
 }
 
-struct CrossTableData
-{
-public:
-
-	CrossTableData(QString engineName, int elo = 0) :
-		m_score(0),
-		m_neustadtlScore(0),
-		m_rating(elo),
-		m_gamesPlayedAsWhite(0),
-		m_gamesPlayedAsBlack(0),
-		m_winsAsWhite(0),
-		m_winsAsBlack(0),
-		m_elo(0)
-	{
-		m_engineName = engineName;
-	};
-
-	CrossTableData() :
-		m_score(0),
-		m_neustadtlScore(0),
-		m_rating(0),
-		m_gamesPlayedAsWhite(0),
-		m_gamesPlayedAsBlack(0),
-		m_winsAsWhite(0),
-		m_winsAsBlack(0),
-		m_elo(0)
-	{
-
-	};
-
-	bool isEmpty() { return m_engineName.isEmpty(); }
-
-	QString m_engineName;
-	QString m_engineAbbrev;
-	double m_score;
-	double m_neustadtlScore;
-	int m_rating;
-	int m_gamesPlayedAsWhite;
-	int m_gamesPlayedAsBlack;
-	int m_winsAsWhite;
-	int m_winsAsBlack;
-	int m_elo;
-	QMap<QString, QString> m_tableData;
-};
-
 bool sortCrossTableDataByScore(const CrossTableData &s1, const CrossTableData &s2)
 {
 	if (s1.m_score == s2.m_score) {
@@ -322,18 +354,14 @@ bool sortCrossTableDataByScore(const CrossTableData &s1, const CrossTableData &s
 	return s1.m_score > s2.m_score;
 }
 
-void EngineMatch::generateCrossTable(QVariantList& pList)
+void EngineMatch::initCrossTable()
 {
 	const int playerCount = m_tournament->playerCount();
-	QMap<QString, CrossTableData> ctMap;
 	QStringList abbrevList;
-	int roundLength = 2;
-	int maxName = 6;
 
 	// ensure names and abbreviations
 	for (int i = 0; i < playerCount; i++) {
 		CrossTableData ctd(m_tournament->playerAt(i).builder()->name(), m_tournament->playerAt(i).builder()->rating());
-		if (ctd.m_engineName.length() > maxName) maxName = ctd.m_engineName.length();
 
 		int n = 1;
 		QString abbrev;
@@ -343,46 +371,74 @@ void EngineMatch::generateCrossTable(QVariantList& pList)
 		}
 		ctd.m_engineAbbrev = abbrev;
 		abbrevList.append(abbrev);
-		ctMap.insert(ctd.m_engineName, ctd);
+		m_crossTable.insert(ctd.m_engineName, ctd);
 	}
 
-	// calculate scores and crosstable strings
-	for (int i = 0; i < pList.size(); i++) {
-		QVariantMap pMap = pList.at(i).toMap();
-		if (pMap.contains("white") && pMap.contains("black") && pMap.contains("result")) {
-			QString whiteName = pMap["white"].toString();
-			QString blackName = pMap["black"].toString();
-			QString result = pMap["result"].toString();
-			CrossTableData& whiteData = ctMap[whiteName];
-			CrossTableData& blackData = ctMap[blackName];
-			QString& whiteDataString = whiteData.m_tableData[blackName];
-			QString& blackDataString = blackData.m_tableData[whiteName];
+	// games finished before the tournament was resumed
+	for (int i = 0; i < m_progress.size(); i++)
+		addCrossTableResult(m_progress.at(i).toMap());
+}
 
-			if (result == "*") {
-				continue; // game in progress or invalid or something
-			}
-			if (result == "1-0") {
-				whiteData.m_score += 1;
-				whiteData.m_winsAsWhite++;
-				whiteDataString += "1";
-				blackDataString += "0";
-			} else if (result == "0-1") {
-				blackData.m_score += 1;
-				blackData.m_winsAsBlack++;
-				whiteDataString += "0";
-				blackDataString += "1";
-			} else if (result == "1/2-1/2") {
-				whiteData.m_score += 0.5;
-				blackData.m_score += 0.5;
-				whiteDataString += "=";
-				blackDataString += "=";
-			}
-			if (whiteDataString.length() > roundLength) roundLength = whiteDataString.length();
-			if (blackDataString.length() > roundLength) roundLength = blackDataString.length();
-			whiteData.m_gamesPlayedAsWhite++;
-			blackData.m_gamesPlayedAsBlack++;
+void EngineMatch::addCrossTableResult(const QVariantMap& pMap)
+{
+	if (pMap.contains("white") && pMap.contains("black") && pMap.contains("result")) {
+		QString whiteName = pMap["white"].toString();
+		QString blackName = pMap["black"].toString();
+		QString result = pMap["result"].toString();
+
+		if (result == "*") {
+			return; // game in progress or invalid or something
+		}
+
+		CrossTableData& whiteData = m_crossTable[whiteName];
+		CrossTableData& blackData = m_crossTable[blackName];
+		QString& whiteDataString = whiteData.m_tableData[blackName];
+		QString& blackDataString = blackData.m_tableData[whiteName];
+
+		if (result == "1-0") {
+			whiteData.m_score += 1;
+			whiteData.m_winsAsWhite++;
+			whiteDataString += "1";
+			blackDataString += "0";
+		} else if (result == "0-1") {
+			blackData.m_score += 1;
+			blackData.m_winsAsBlack++;
+			whiteDataString += "0";
+			blackDataString += "1";
+		} else if (result == "1/2-1/2") {
+			whiteData.m_score += 0.5;
+			blackData.m_score += 0.5;
+			whiteDataString += "=";
+			blackDataString += "=";
+		}
+		whiteData.m_gamesPlayedAsWhite++;
+		blackData.m_gamesPlayedAsBlack++;
+	}
+}
+
+void EngineMatch::writeCrossTable()
+{
+	const int playerCount = m_tournament->playerCount();
+	if (m_crossTable.isEmpty())
+		initCrossTable();
+
+	// the scores are kept up to date, everything else is
+	// calculated from them when the file is written
+	QMap<QString, CrossTableData> ctMap(m_crossTable);
+	int roundLength = 2;
+	int maxName = 6;
+	QMapIterator<QString, CrossTableData> it(ctMap);
+	while (it.hasNext()) {
+		it.next();
+		const CrossTableData& ctd = it.value();
+		if (ctd.m_engineName.length() > maxName) maxName = ctd.m_engineName.length();
+		QMapIterator<QString, QString> td(ctd.m_tableData);
+		while (td.hasNext()) {
+			td.next();
+			if (td.value().length() > roundLength) roundLength = td.value().length();
 		}
 	}
+
 	// calculate SB and ratings sum
 	QMapIterator<QString, CrossTableData> ct(ctMap);
 	qreal largestSB = 1.0;
@@ -395,15 +451,13 @@ void EngineMatch::generateCrossTable(QVariantList& pList)
 		qreal sb = 0.0;
 		while (td.hasNext()) {
 			td.next();
-			QString::ConstIterator c = td.value().begin();
-			while (c != td.value().end()) {
-				if (*c == QChar('1')) {
-					sb += ctMap[td.key()].m_score;
-				} else if (*c == QChar('=')) {
-					sb += ctMap[td.key()].m_score / 2.;
-				}
-				c++;
-			}
+			// one lookup per opponent instead of one per game
+			const QString& results = td.value();
+			const int wins = results.count(QChar('1'));
+			const int draws = results.count(QChar('='));
+			const auto opponent = m_crossTable.constFind(td.key());
+			if (opponent != m_crossTable.constEnd())
+				sb += (wins + draws / 2.) * opponent->m_score;
 		}
 		ctd.m_neustadtlScore = sb;
 		if (ctd.m_neustadtlScore > largestSB) largestSB = ctd.m_neustadtlScore;
@@ -434,9 +488,9 @@ void EngineMatch::generateCrossTable(QVariantList& pList)
 		}
 	}
 
-	if (playerCount == 2) {
+	if (playerCount == 2 && !m_progress.isEmpty()) {
 		roundLength = 2;
-		QVariantMap pMap = pList.at(0).toMap();
+		QVariantMap pMap = m_progress.at(0).toMap();
 		if (pMap.contains("white") && pMap.contains("black")) {
 			QString whiteName = pMap["white"].toString();
 			QString blackName = pMap["black"].toString();
@@ -518,7 +572,7 @@ void EngineMatch::generateCrossTable(QVariantList& pList)
 				crossTableBodyText += " ";
 				int rl = roundLength;
 				while(rl--) crossTableBodyText += "\u00B7";
-			} else crossTableBodyText += QString(" %1").arg(i->m_tableData[j->m_engineName], -roundLength);
+			} else crossTableBodyText += QString(" %1").arg(i->m_tableData.value(j->m_engineName), -roundLength);
 		}
 		crossTableBodyText += "\n";
 	}
@@ -547,35 +601,9 @@ void EngineMatch::onGameStarted(ChessGame* game, int number)
 	       m_tournament->finalGameCount(),
 	       qPrintable(game->player(Chess::Side::White)->name()),
 	       qPrintable(game->player(Chess::Side::Black)->name()));
+	m_throughput.addGameStart(number, m_startTime.elapsed());
 
-	if (!m_tournamentFile.isEmpty()) {
-		QVariantMap tfMap;
-		if (QFile::exists(m_tournamentFile)) {
-			QFile input(m_tournamentFile);
-			if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
-				qWarning("cannot open tournament configuration file: %s", qPrintable(m_tournamentFile));
-				return;
-			}
-
-			QTextStream stream(&input);
-			JsonParser jsonParser(stream);
-			tfMap = jsonParser.parse().toMap();
-		}
-
-		QVariantList pList;
-		if (!tfMap.isEmpty()) {
-			if (tfMap.contains("matchProgress")) {
-				pList = tfMap["matchProgress"].toList();
-				int length = pList.length();
-				if (length >= number) {
-					qWarning("game %d already exists, deleting", number);
-					while(length-- >= number) {
-						pList.removeLast();
-					}
-				}
-			}
-		}
-
+	if (m_journal != nullptr) {
 		QVariantMap pMap;
 		pMap.insert("index", number);
 		pMap.insert("white", game->player(Chess::Side::White)->name());
@@ -584,20 +612,15 @@ void EngineMatch::onGameStarted(ChessGame* game, int number)
 		pMap.insert("startTime", qdt.toString("HH:mm:ss' on 'yyyy.MM.dd"));
 		pMap.insert("result", "*");
 		pMap.insert("terminationDetails", "in progress");
-		pList.append(pMap);
-		tfMap.insert("matchProgress", pList);
-		{
-			QFile output(m_tournamentFile);
-			if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
-				qWarning("cannot open tournament configuration file: %s", qPrintable(m_tournamentFile));
-			} else {
-				QTextStream out(&output);
-				JsonSerializer serializer(tfMap);
-				serializer.serialize(out);
-			}
-		}
-		generateSchedule(pList);
-		generateCrossTable(pList);
+		if (m_tournament->timeControlScale() != 1.0)
+			pMap.insert("timeControlScale",
+				    m_tournament->timeControlScale());
+		if (m_progress.size() >= number
+		&&  m_progress.at(number - 1).toMap().value("result") != "*")
+			qWarning("game %d already exists, replacing", number);
+		TournamentJournal::setEntry(m_progress, number, pMap);
+		m_journal->append(number, pMap);
+		scheduleReports();
 	}
 }
 
@@ -611,93 +634,90 @@ void EngineMatch::onGameFinished(ChessGame* game, int number)
 	       qPrintable(game->player(Chess::Side::White)->name()),
 	       qPrintable(game->player(Chess::Side::Black)->name()),
 	       qPrintable(result.toVerboseString()));
+	m_throughput.addGameEnd(number, m_startTime.elapsed(),
+				game->moves().size());
+	if (m_memoryDebug)
+		qDebug("Memory after game %d: %s", number,
+		       qPrintable(MemoryStats::report()));
 
-	if (!m_tournamentFile.isEmpty()) {
-		QVariantMap tfMap;
-
-		if (QFile::exists(m_tournamentFile)) {
-			QFile input(m_tournamentFile);
-			if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
-				qWarning("cannot open tournament configuration file: %s", qPrintable(m_tournamentFile));
-			} else {
-				QTextStream stream(&input);
-				JsonParser jsonParser(stream);
-				tfMap = jsonParser.parse().toMap();
-			}
-
-			QVariantMap pMap;
-			QVariantList pList;
-
-			if (!tfMap.isEmpty()) {
-				if (tfMap.contains("matchProgress")) {
-					pList = tfMap["matchProgress"].toList();
-					int length = pList.length();
-					if (length < number) {
-						qWarning("game %d doesn't exist", number);
-					} else
-						pMap = pList.at(number-1).toMap();
-				}
+	if (m_journal != nullptr) {
+		QVariantMap pMap;
+		if (m_progress.size() < number)
+			qWarning("game %d doesn't exist", number);
+		else
+			pMap = m_progress.at(number - 1).toMap();
+
+		if (!pMap.isEmpty()) {
+			pMap.insert("result", result.toShortString());
+			pMap.insert("terminationDetails", result.shortDescription());
+			PgnGame *pgn = game->pgn();
+			if (pgn) {
+				// const EcoInfo eco = pgn->eco();
+				QString val;
+				val = pgn->tagValue("ECO");
+				if (!val.isEmpty()) pMap.insert("ECO", val);
+				val = pgn->tagValue("Opening");
+				if (!val.isEmpty()) pMap.insert("opening", val);
+				val = pgn->tagValue("Variation");
+				if (!val.isEmpty()) pMap.insert("variation", val);
+				// TODO: after TCEC is over, change this to moveCount, since that's what it is
+				pMap.insert("plyCount", (game->moves().size() + 1) / 2);
 			}
-
-			if (!pMap.isEmpty()) {
-				pMap.insert("result", result.toShortString());
-				pMap.insert("terminationDetails", result.shortDescription());
-				PgnGame *pgn = game->pgn();
-				if (pgn) {
-					// const EcoInfo eco = pgn->eco();
-					QString val;
-					val = pgn->tagValue("ECO");
-					if (!val.isEmpty()) pMap.insert("ECO", val);
-					val = pgn->tagValue("Opening");
-					if (!val.isEmpty()) pMap.insert("opening", val);
-					val = pgn->tagValue("Variation");
-					if (!val.isEmpty()) pMap.insert("variation", val);
-					// TODO: after TCEC is over, change this to moveCount, since that's what it is
-					pMap.insert("plyCount", (game->moves().size() + 1) / 2);
-				}
-				pMap.insert("finalFen", game->board()->fenString());
-
-				MoveEvaluation eval;
-				QString sScore;
-				const Chess::Side sides[] = { Chess::Side::White, Chess::Side::Black, Chess::Side::NoSide };
-
-				for (int i = 0; sides[i] != Chess::Side::NoSide; i++) {
-					Chess::Side side = sides[i];
-					eval = game->player(side)->evaluation();
-					int score = eval.score();
-					int absScore = qAbs(score);
-
-					// Detect mate-in-n scores
-					if (absScore > 9900
-						&& (absScore = 1000 - (absScore % 1000)) < 100)
-					{
-						sScore = score < 0 ? "-" : "";
-						sScore += "M" + QString::number(absScore);
-					}
-					else
-						sScore = QString::number(double(score) / 100.0, 'f', 2);
-
-					if (side == Chess::Side::White)
-						pMap.insert("whiteEval", sScore);
-					else
-						pMap.insert("blackEval", sScore);
+			pMap.insert("finalFen", game->board()->fenString());
+
+			MoveEvaluation eval;
+			QString sScore;
+			const Chess::Side sides[] = { Chess::Side::White, Chess::Side::Black, Chess::Side::NoSide };
+
+			for (int i = 0; sides[i] != Chess::Side::NoSide; i++) {
+				Chess::Side side = sides[i];
+				eval = game->player(side)->evaluation();
+				int score = eval.score();
+				int absScore = qAbs(score);
+
+				// Detect mate-in-n scores
+				if (absScore > 9900
+					&& (absScore = 1000 - (absScore % 1000)) < 100)
+				{
+					sScore = score < 0 ? "-" : "";
+					sScore += "M" + QString::number(absScore);
 				}
+				else
+					sScore = QString::number(double(score) / 100.0, 'f', 2);
 
-				pMap.insert("gameDuration", game->gameDuration());
-				pList.replace(number-1, pMap);
-				tfMap.insert("matchProgress", pList);
+				if (side == Chess::Side::White)
+					pMap.insert("whiteEval", sScore);
+				else
+					pMap.insert("blackEval", sScore);
+			}
 
-				QFile output(m_tournamentFile);
-				if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
-					qWarning("cannot open tournament configuration file: %s", qPrintable(m_tournamentFile));
-				} else {
-					QTextStream out(&output);
-					JsonSerializer serializer(tfMap);
-					serializer.serialize(out);
+			pMap.insert("gameDuration", game->gameDuration());
+
+			for (int i = 0; sides[i] != Chess::Side::NoSide; i++) {
+				Chess::Side side = sides[i];
+				ProcessUsage usage = game->resourceUsage(side);
+				if (usage.isNull())
+					continue;
+
+				QVariantMap uMap;
+				uMap.insert("cpuTime", usage.cpuTime());
+				uMap.insert("thinkingTime", game->thinkingTime(side));
+				if (usage.peakMemory() >= 0)
+					uMap.insert("peakRss", usage.peakMemory());
+				if (usage.voluntarySwitches() >= 0) {
+					uMap.insert("voluntarySwitches", usage.voluntarySwitches());
+					uMap.insert("involuntarySwitches", usage.involuntarySwitches());
 				}
-				generateSchedule(pList);
-				generateCrossTable(pList);
+				pMap.insert(side == Chess::Side::White ? "whiteUsage" : "blackUsage", uMap);
 			}
+			m_progress.replace(number - 1, pMap);
+			m_journal->append(number, pMap);
+
+			if (m_crossTable.isEmpty())
+				initCrossTable();
+			else
+				addCrossTableResult(pMap);
+			scheduleReports();
 		}
 	}
 
@@ -716,20 +736,56 @@ void EngineMatch::onGameFinished(ChessGame* game, int number)
 
 	if (m_ratingInterval != 0
 	&&  (m_tournament->finishedGameCount() % m_ratingInterval) == 0)
+	{
 		printRanking();
+		printThroughput();
+		if (m_bootstrapInterval && m_tournament->updateBootstrapRatings())
+			printBootstrap();
+	}
 }
 
 void EngineMatch::onTournamentFinished()
 {
 	if (m_ratingInterval == 0
 	||  m_tournament->finishedGameCount() % m_ratingInterval != 0)
+	{
 		printRanking();
+		printThroughput();
+	}
+
+	if (m_journal != nullptr)
+		m_journal->rewrite(m_progress);
+	if (m_reportTimer->isActive())
+		writeReports();
 
 	QString error = m_tournament->errorString();
 	if (!error.isEmpty())
 		qWarning("%s", qPrintable(error));
 
+	printSearchStats();
+	printTimeStats();
+	printOpeningStats();
+	// The tournament computes the final bootstrap when it finishes
+	printBootstrap();
+	if (m_memoryDebug)
+		qDebug("Memory: %s", qPrintable(MemoryStats::report()));
+
+	const quint64 tbProbes = SyzygyTablebase::cacheProbes();
+	if (tbProbes > 0)
+	{
+		const quint64 tbHits = SyzygyTablebase::cacheHits();
+		qDebug("Tablebase cache: %llu of %llu probes hit (%.1f%%)",
+		       static_cast<unsigned long long>(tbHits),
+		       static_cast<unsigned long long>(tbProbes),
+		       100.0 * tbHits / tbProbes);
+	}
+
 	qDebug("Finished match");
+	if (m_sharedGameManager)
+	{
+		emit finished();
+		return;
+	}
 	connect(m_tournament->gameManager(), SIGNAL(finished()),
 		this, SIGNAL(finished()));
 	m_tournament->gameManager()->finish();
@@ -744,3 +800,205 @@ void EngineMatch::printRanking()
 {
 	qDebug("%s", qPrintable(m_tournament->results()));
 }
+
+void EngineMatch::printThroughput()
+{
+	if (m_throughput.gameCount() == 0)
+		return;
+
+	const qint64 now = m_startTime.elapsed();
+	QString str = QString("Throughput: %1 games/hour, duration %2 avg, "
+			      "%3 median, %4 p90, %5 plies/game")
+		.arg(m_throughput.gamesPerHour(now), 0, 'f', 1)
+		.arg(formatTime(m_throughput.averageDuration()))
+		.arg(formatTime(m_throughput.durationPercentile(50) * 1000))
+		.arg(formatTime(m_throughput.durationPercentile(90) * 1000))
+		.arg(m_throughput.averagePlies(), 0, 'f', 1);
+
+	// The setup time tells how long a free slot waits for the
+	// next game's engines
+	const qint64 setupTime = m_throughput.averageSetupTime();
+	if (setupTime >= 0)
+		str += QString(", %1 s setup between games")
+			.arg(setupTime / 1000.0, 0, 'f', 1);
+
+	const int remaining = m_tournament->finalGameCount()
+			    - m_tournament->finishedGameCount();
+	const qint64 eta = m_throughput.eta(now, remaining);
+	if (remaining > 0 && eta >= 0)
+		str += QString(", ETA %1 for %2 games")
+			.arg(formatTime(eta))
+			.arg(remaining);
+
+	qDebug("%s", qPrintable(str));
+}
+
+void EngineMatch::printBootstrap()
+{
+	const BootstrapRatings* bootstrap = m_tournament->bootstrapRatings();
+	if (bootstrap->sampleCount() == 0)
+		return;
+
+	const int playerCount = qMin(bootstrap->playerCount(),
+				     m_tournament->playerCount());
+	int maxName = 4;
+	for (int i = 0; i < playerCount; i++)
+		maxName = qMax(maxName, m_tournament->playerAt(i).name().length());
+
+	QString str = QString("Bootstrap 95% intervals, %1 resamples:")
+		.arg(bootstrap->sampleCount());
+	for (int i = 0; i < playerCount; i++)
+	{
+		const double median = bootstrap->percentile(i, 50.0);
+		if (std::isnan(median))
+			continue;
+
+		str += QString("\n%1 %2 [%3, %4]")
+			.arg(m_tournament->playerAt(i).name(), -maxName)
+			.arg(median, 7, 'f', 1)
+			.arg(bootstrap->percentile(i, 2.5), 0, 'f', 1)
+			.arg(bootstrap->percentile(i, 97.5), 0, 'f', 1);
+	}
+	qDebug("%s", qPrintable(str));
+}
+
+void EngineMatch::printOpeningStats()
+{
+	int openings = 0, repeated = 0, drawn = 0, decisive = 0;
+	for (const Tournament::OpeningStats& stats : m_tournament->openingStats())
+	{
+		if (stats.games == 0)
+			continue;
+		openings++;
+		if (stats.games > 1)
+			repeated++;
+		if (stats.isAlwaysDrawn())
+			drawn++;
+		else if (stats.isAlwaysDecisive())
+			decisive++;
+	}
+
+	// Openings played only once can't be judged
+	if (repeated == 0)
+		return;
+	qDebug("Openings: %d played, %d always drawn, %d always decisive",
+	       openings, drawn, decisive);
+}
+
+void EngineMatch::printTimeStats()
+{
+	bool header = false;
+
+	for (int i = 0; i < m_tournament->playerCount(); i++)
+	{
+		const TournamentPlayer& player = m_tournament->playerAt(i);
+		const MoveTimeStats& stats = player.timeStats();
+		if (stats.moveCount() == 0)
+			continue;
+
+		if (!header)
+		{
+			qDebug("Time usage statistics:");
+			header = true;
+		}
+
+		qDebug("%s: %d moves, %.1f%% of the clock per move, "
+		       "at least %d ms left",
+		       qPrintable(player.name()),
+		       stats.moveCount(),
+		       100.0 * stats.timeFractionSum() / stats.moveCount(),
+		       stats.minTimeLeft());
+
+		QStringList buckets;
+		for (int j = 0; j < MoveTimeStats::BucketCount; j++)
+		{
+			const int limit = MoveTimeStats::timeBucketLimit(j);
+			const QString range = limit > 0
+				? QString("<%1%").arg(limit)
+				: QString(">=%1%").arg(MoveTimeStats::timeBucketLimit(j - 1));
+			buckets << QString("%1 %2").arg(range).arg(stats.timeBucket(j));
+		}
+		qDebug("  Move time of clock: %s", qPrintable(buckets.join(", ")));
+
+		if (stats.overheadCount() > 0)
+		{
+			buckets.clear();
+			for (int j = 0; j < MoveTimeStats::BucketCount; j++)
+			{
+				const int limit = MoveTimeStats::overheadBucketLimit(j);
+				const QString range = limit > 0
+					? QString("<%1ms").arg(limit)
+					: QString(">=%1ms").arg(MoveTimeStats::overheadBucketLimit(j - 1));
+				buckets << QString("%1 %2").arg(range).arg(stats.overheadBucket(j));
+			}
+			qDebug("  Overhead: %lld ms average, %d ms max: %s",
+			       static_cast<long long>(stats.overheadSum()
+						      / stats.overheadCount()),
+			       stats.maxOverhead(),
+			       qPrintable(buckets.join(", ")));
+		}
+
+		if (stats.nearForfeits() > 0)
+			qWarning("%s had less than %d ms left after %d moves",
+				 qPrintable(player.name()),
+				 MoveTimeStats::NearForfeitTime,
+				 stats.nearForfeits());
+	}
+}
+
+void EngineMatch::printSearchStats()
+{
+	bool header = false;
+
+	for (int i = 0; i < m_tournament->playerCount(); i++)
+	{
+		const TournamentPlayer& player = m_tournament->playerAt(i);
+		if (player.searchedMoves() == 0
+		&&  player.ponderedMoves() == 0
+		&&  player.stopCount() == 0)
+			continue;
+
+		if (!header)
+		{
+#if QT_VERSION >= 0x050600
+			qDebug("Search statistics on host %s:",
+			       qPrintable(QSysInfo::machineHostName()));
+#else
+			qDebug("Search statistics:");
+#endif
+			header = true;
+		}
+
+		qDebug("%s: %d moves, %llu nodes, %llu nps",
+		       qPrintable(player.name()),
+		       player.searchedMoves(),
+		       static_cast<unsigned long long>(player.nodeCount()),
+		       static_cast<unsigned long long>(player.nps()));
+		if (player.ponderedMoves() > 0)
+			qDebug("%s: %d of %d pondered moves hit (%.1f%%)",
+			       qPrintable(player.name()),
+			       player.ponderHits(),
+			       player.ponderedMoves(),
+			       100.0 * player.ponderHits() / player.ponderedMoves());
+		if (player.stopCount() > 0)
+			qDebug("%s: %d stops, %d ms average, %d ms max latency",
+			       qPrintable(player.name()),
+			       player.stopCount(),
+			       player.averageStopLatency(),
+			       player.maxStopLatency());
+		if (player.stopTimeouts() > 0)
+			qWarning("%s was terminated %d times for not stopping "
+				 "in time",
+				 qPrintable(player.name()),
+				 player.stopTimeouts());
+
+		// Moves that searched past a "nodes" or "plies" limit make
+		// fixed-node results incomparable between hosts
+		if (player.limitOvershoots() > 0)
+			qWarning("%s exceeded the search limit in %d moves "
+				 "(by up to %llu nodes)",
+				 qPrintable(player.name()),
+				 player.limitOvershoots(),
+				 static_cast<unsigned long long>(player.maxNodeOvershoot()));
+	}
+}
@@ -20,13 +20,64 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSharedPointer>
 #include <QString>
+#include <QVariant>
 #include <QElapsedTimer>
 #include <openingbook.h>
+#include <throughputstats.h>
 
 class ChessGame;
 class OpeningBook;
 class Tournament;
+class TournamentJournal;
+class QTimer;
+
+struct CrossTableData
+{
+public:
+
+	CrossTableData(QString engineName, int elo = 0) :
+		m_score(0),
+		m_neustadtlScore(0),
+		m_rating(elo),
+		m_gamesPlayedAsWhite(0),
+		m_gamesPlayedAsBlack(0),
+		m_winsAsWhite(0),
+		m_winsAsBlack(0),
+		m_elo(0)
+	{
+		m_engineName = engineName;
+	};
+
+	CrossTableData() :
+		m_score(0),
+		m_neustadtlScore(0),
+		m_rating(0),
+		m_gamesPlayedAsWhite(0),
+		m_gamesPlayedAsBlack(0),
+		m_winsAsWhite(0),
+		m_winsAsBlack(0),
+		m_elo(0)
+	{
+
+	};
+
+	bool isEmpty() { return m_engineName.isEmpty(); }
+
+	QString m_engineName;
+	QString m_engineAbbrev;
+	double m_score;
+	double m_neustadtlScore;
+	int m_rating;
+	int m_gamesPlayedAsWhite;
+	int m_gamesPlayedAsBlack;
+	int m_winsAsWhite;
+	int m_winsAsBlack;
+	int m_elo;
+	QMap<QString, QString> m_tableData;
+};
+
 
 
 class EngineMatch : public QObject
@@ -37,12 +88,22 @@ class EngineMatch : public QObject
 		EngineMatch(Tournament* tournament, QObject* parent = nullptr);
 		virtual ~EngineMatch();
 
-		OpeningBook* addOpeningBook(const QString& fileName);
+		const OpeningBook* addOpeningBook(const QString& fileName);
 		void setDebugMode(bool debug);
+		void setMemoryDebug(bool enabled);
 		void setRatingInterval(int interval);
+		void setBootstrapInterval(bool enabled);
 		void setBookMode(OpeningBook::AccessMode mode);
-		void setTournamentFile(QString &tournamentFile);
+		void setTournamentFile(QString &tournamentFile,
+				       const QString& progressFile);
+		void setProgress(const QVariantList& progress);
 		void setEloKfactor(qreal eloKfactor);
+		void setReportInterval(int msecs);
+		/*!
+		 * If \a shared is true the game manager is also used by
+		 * other matches, and it's left running when this match ends.
+		 */
+		void setSharedGameManager(bool shared);
 
 		void start();
 		void stop();
@@ -55,19 +116,40 @@ class EngineMatch : public QObject
 		void onGameFinished(ChessGame* game, int number);
 		void onTournamentFinished();
 		void print(const QString& msg);
+		void writeReports();
 
 	private:
 		void printRanking();
-		void generateSchedule(QVariantList& pList);
-		void generateCrossTable(QVariantList& pList);
+		void printSearchStats();
+		void printTimeStats();
+		void printThroughput();
+		void printOpeningStats();
+		void printBootstrap();
+		void writeSchedule();
+		void initCrossTable();
+		void addCrossTableResult(const QVariantMap& pMap);
+		void writeCrossTable();
+		void scheduleReports();
 
 		Tournament* m_tournament;
 		bool m_debug;
+		bool m_memoryDebug;
+		bool m_sharedGameManager;
 		int m_ratingInterval;
+		bool m_bootstrapInterval;
 		OpeningBook::AccessMode m_bookMode;
-		QMap<QString, OpeningBook*> m_books;
+		QMap<QString, QSharedPointer<const OpeningBook> > m_books;
 		QElapsedTimer m_startTime;
+		ThroughputStats m_throughput;
 		QString m_tournamentFile;
+		// The progress of the tournament is kept in memory, and
+		// the changes to it are appended to the journal
+		QVariantList m_progress;
+		TournamentJournal* m_journal;
+		// The crosstable without the Sonneborn-Berger scores and
+		// Elo, which are calculated when it's written
+		QMap<QString, CrossTableData> m_crossTable;
+		QTimer* m_reportTimer;
 		qreal m_eloKfactor;
 };
 
@@ -0,0 +1,270 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "epdtest.h"
+#include <QTextStream>
+#include <board/board.h>
+#include <board/boardfactory.h>
+#include <chessgame.h>
+#include <epdrecord.h>
+#include <enginebuilder.h>
+#include <gameadjudicator.h>
+#include <gamemanager.h>
+#include <humanbuilder.h>
+#include <pgngame.h>
+
+
+EpdTest::EpdTest(GameManager* manager, const QString& variant,
+		 QObject* parent)
+	: QObject(parent),
+	  m_manager(manager),
+	  m_variant(variant),
+	  m_board(Chess::BoardFactory::create(variant)),
+	  m_engine(nullptr),
+	  m_opponent(new HumanBuilder("EPD")),
+	  m_positionCount(0),
+	  m_finishedCount(0),
+	  m_solvedCount(0),
+	  m_stopping(false)
+{
+	Q_ASSERT(manager != nullptr);
+	Q_ASSERT(m_board != nullptr);
+	m_board->initialize();
+}
+
+EpdTest::~EpdTest()
+{
+	delete m_board;
+	delete m_engine;
+	delete m_opponent;
+}
+
+void EpdTest::setEngine(const EngineConfiguration& config,
+			const TimeControl& timeControl)
+{
+	delete m_engine;
+	m_engine = new EngineBuilder(config);
+	m_timeControl = timeControl;
+}
+
+bool EpdTest::open(const QString& fileName)
+{
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	m_stream.setDevice(&m_file);
+	return true;
+}
+
+int EpdTest::positionCount() const
+{
+	return m_finishedCount;
+}
+
+int EpdTest::solvedCount() const
+{
+	return m_solvedCount;
+}
+
+void EpdTest::start()
+{
+	Q_ASSERT(m_engine != nullptr);
+
+	m_time.start();
+	connect(m_manager, SIGNAL(ready()),
+		this, SLOT(startNextPosition()));
+	startNextPosition();
+}
+
+void EpdTest::stop()
+{
+	if (m_stopping)
+		return;
+
+	m_stopping = true;
+	disconnect(m_manager, SIGNAL(ready()),
+		   this, SLOT(startNextPosition()));
+	checkFinished();
+}
+
+bool EpdTest::readPosition(Position* position)
+{
+	while (!m_stream.atEnd())
+	{
+		EpdRecord epd;
+		if (!epd.parse(m_stream))
+			continue;
+
+		// Positions without a solution can't be scored
+		if (!epd.hasOpcode("bm") && !epd.hasOpcode("am"))
+			continue;
+		if (!m_board->setFenString(epd.fen()))
+		{
+			qWarning("Invalid EPD position: %s", qPrintable(epd.fen()));
+			continue;
+		}
+
+		position->number = ++m_positionCount;
+		position->id = epd.operands("id").value(0);
+		position->fen = epd.fen();
+		position->bestMoves = epd.operands("bm");
+		position->avoidMoves = epd.operands("am");
+		return true;
+	}
+
+	return false;
+}
+
+void EpdTest::startNextPosition()
+{
+	if (m_stopping)
+		return;
+
+	Position position;
+	if (!readPosition(&position))
+	{
+		stop();
+		return;
+	}
+
+	Chess::Board* board = Chess::BoardFactory::create(m_variant);
+	Q_ASSERT(board != nullptr);
+	ChessGame* game = new ChessGame(board, new PgnGame());
+
+	connect(game, SIGNAL(finished(ChessGame*)),
+		this, SLOT(onGameFinished(ChessGame*)));
+	connect(game, SIGNAL(startFailed(ChessGame*)),
+		this, SLOT(onGameStartFailed(ChessGame*)));
+
+	// Each position is a game that ends after the engine's move
+	GameAdjudicator adjudicator;
+	adjudicator.setMaximumPlyCount(1);
+	game->setAdjudicator(adjudicator);
+	game->setTimeControl(m_timeControl);
+	game->setStartingFen(position.fen);
+	game->pgn()->setEvent("EPD test");
+	m_positions[game] = position;
+
+	const Chess::Side side(position.fen.section(' ', 1, 1));
+	const bool white = (side == Chess::Side::White);
+	m_manager->newGame(game,
+			   white ? m_engine : m_opponent,
+			   white ? m_opponent : m_engine,
+			   GameManager::Enqueue,
+			   GameManager::ReusePlayers);
+}
+
+bool EpdTest::isSolution(const Position& position,
+			 const Chess::GenericMove& move)
+{
+	if (!m_board->setFenString(position.fen))
+		return false;
+
+	auto contains = [&](const QStringList& moves)
+	{
+		for (const QString& str : moves)
+		{
+			const Chess::Move m(m_board->moveFromString(str));
+			if (m.isNull())
+				qWarning("Invalid move in position %d: %s",
+					 position.number, qPrintable(str));
+			else if (m_board->genericMove(m) == move)
+				return true;
+		}
+		return false;
+	};
+
+	if (!position.bestMoves.isEmpty() && !contains(position.bestMoves))
+		return false;
+	return !contains(position.avoidMoves);
+}
+
+void EpdTest::onGameFinished(ChessGame* game)
+{
+	Q_ASSERT(m_positions.contains(game));
+	const Position position = m_positions.take(game);
+	PgnGame* pgn = game->pgn();
+
+	QString moveString = "(none)";
+	QString searchInfo;
+	bool solved = false;
+	if (!pgn->moves().isEmpty())
+	{
+		const PgnGame::MoveData& md = pgn->moves().first();
+		moveString = md.moveString;
+		solved = isSolution(position, md.move);
+		if (!md.eval.isNull())
+			searchInfo = QString(", depth %1, %2 nodes, %3 ms")
+				     .arg(md.eval.depth)
+				     .arg(md.eval.nodes)
+				     .arg(md.eval.moveTime);
+	}
+
+	m_finishedCount++;
+	if (solved)
+		m_solvedCount++;
+
+	QString expected;
+	if (!position.bestMoves.isEmpty())
+		expected = "bm " + position.bestMoves.join(' ');
+	if (!position.avoidMoves.isEmpty())
+	{
+		if (!expected.isEmpty())
+			expected += "; ";
+		expected += "am " + position.avoidMoves.join(' ');
+	}
+
+	QString name = QString::number(position.number);
+	if (!position.id.isEmpty())
+		name += " (" + position.id + ")";
+	QTextStream(stdout) << name << ": " << moveString
+			    << (solved ? " solved" : " not solved")
+			    << " [" << expected << "]" << searchInfo
+			    << ", score " << m_solvedCount << "/"
+			    << m_finishedCount << endl;
+
+	delete pgn;
+	game->deleteLater();
+	checkFinished();
+}
+
+void EpdTest::onGameStartFailed(ChessGame* game)
+{
+	qWarning("%s", qPrintable(game->errorString()));
+
+	m_positions.remove(game);
+	delete game->pgn();
+	game->deleteLater();
+	if (m_stopping)
+		checkFinished();
+	else
+		stop();
+}
+
+void EpdTest::checkFinished()
+{
+	if (!m_stopping || !m_positions.isEmpty())
+		return;
+
+	QTextStream(stdout) << "Solved " << m_solvedCount << " of "
+			    << m_finishedCount << " positions in "
+			    << m_time.elapsed() << " ms" << endl;
+
+	connect(m_manager, SIGNAL(finished()), this, SIGNAL(finished()));
+	m_manager->finish();
+}
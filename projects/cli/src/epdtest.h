@@ -0,0 +1,125 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EPDTEST_H
+#define EPDTEST_H
+
+#include <QObject>
+#include <QFile>
+#include <QTextStream>
+#include <QMap>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <timecontrol.h>
+#include <engineconfiguration.h>
+namespace Chess { class Board; class GenericMove; }
+class ChessGame;
+class GameManager;
+class PlayerBuilder;
+
+
+/*!
+ * \brief A runner for EPD test suites.
+ *
+ * EpdTest reads positions with "bm" (best move) or "am" (avoid move)
+ * opcodes from an EPD file and has an engine search each of them with
+ * a fixed time or node budget. Each position is played as a one-move
+ * game by a GameManager, so as many engine instances search different
+ * positions in parallel as the manager's concurrency allows, and the
+ * idle engines are reused for the next positions.
+ *
+ * The solutions are reported as soon as each search finishes, and the
+ * positions are read from the file only when a game slot is free.
+ */
+class EpdTest : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*!
+		 * Creates a new test that plays its games with \a manager
+		 * in \a variant.
+		 */
+		EpdTest(GameManager* manager, const QString& variant,
+			QObject* parent = nullptr);
+		/*! Destroys the test and its player builders. */
+		virtual ~EpdTest();
+
+		/*!
+		 * Sets the engine to \a config, searching with time
+		 * control \a timeControl.
+		 */
+		void setEngine(const EngineConfiguration& config,
+			       const TimeControl& timeControl);
+		/*!
+		 * Opens the EPD file \a fileName.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName);
+
+		/*! Returns the number of positions searched. */
+		int positionCount() const;
+		/*! Returns the number of positions solved. */
+		int solvedCount() const;
+
+	public slots:
+		/*! Starts the test. */
+		void start();
+		/*! Stops reading new positions and waits for the searches. */
+		void stop();
+
+	signals:
+		/*! This signal is emitted when all the searches are done. */
+		void finished();
+
+	private slots:
+		void startNextPosition();
+		void onGameFinished(ChessGame* game);
+		void onGameStartFailed(ChessGame* game);
+
+	private:
+		struct Position
+		{
+			int number;
+			QString id;
+			QString fen;
+			QStringList bestMoves;
+			QStringList avoidMoves;
+		};
+
+		bool readPosition(Position* position);
+		bool isSolution(const Position& position,
+				const Chess::GenericMove& move);
+		void checkFinished();
+
+		GameManager* m_manager;
+		QString m_variant;
+		Chess::Board* m_board;
+		PlayerBuilder* m_engine;
+		PlayerBuilder* m_opponent;
+		TimeControl m_timeControl;
+		QFile m_file;
+		QTextStream m_stream;
+		QMap<ChessGame*, Position> m_positions;
+		QElapsedTimer m_time;
+		int m_positionCount;
+		int m_finishedCount;
+		int m_solvedCount;
+		bool m_stopping;
+};
+
+#endif // EPDTEST_H
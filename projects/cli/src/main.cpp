@@ -23,7 +23,12 @@
 #include <QTextStream>
 #include <QStringList>
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
 #include <QMetaType>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QThread>
 
 #include <mersenne.h>
 #include <enginemanager.h>
@@ -31,35 +36,69 @@
 #include <gamemanager.h>
 #include <tournament.h>
 #include <tournamentfactory.h>
+#include <board/board.h>
 #include <board/boardfactory.h>
 #include <enginefactory.h>
+#include <enginehandshakecache.h>
+#include <cpuaffinity.h>
+#include <cgroup.h>
+#include <tracer.h>
 #include <enginetextoption.h>
 #include <openingsuite.h>
 #include <sprt.h>
 #include <board/syzygytablebase.h>
 #include <board/result.h>
-#include <jsonparser.h>
-#include <jsonserializer.h>
+#include <jsonreader.h>
 #include <econode.h>
 #include <pgnstream.h>
+#include <gamearchive.h>
+#include <trainingdata.h>
+#include <gzipdevice.h>
+#include <pgngamefilter.h>
+#include <ratingsdatabase.h>
+#include <hostcalibration.h>
 
 #include "cutechesscoreapp.h"
 #include "matchparser.h"
 #include "enginematch.h"
+#include "pgntool.h"
+#include "pgnverifier.h"
+#include "epdtest.h"
+#include "metricsserver.h"
+#include "broadcastserver.h"
+#include "bookbuilder.h"
+#include "tournamentjournal.h"
+#include "matchgroup.h"
 
 namespace {
 
 EngineMatch* s_match = nullptr;
+MatchGroup* s_matchGroup = nullptr;
+QString s_traceFile;
 
 void sigintHandler(int param)
 {
 	Q_UNUSED(param);
 	if (s_match != nullptr)
 		s_match->stop();
+	else if (s_matchGroup != nullptr)
+		QMetaObject::invokeMethod(s_matchGroup, "stop",
+					  Qt::QueuedConnection);
 	else
 		abort();
 }
 
+int writeTrace(int ret)
+{
+	if (s_traceFile.isEmpty())
+		return ret;
+
+	if (!Tracer::write(s_traceFile))
+		qWarning("Cannot write trace file: %s",
+			 qPrintable(s_traceFile));
+	return ret;
+}
+
 
 struct EngineData
 {
@@ -67,29 +106,27 @@ struct EngineData
 	TimeControl tc;
 	QString book;
 	int bookDepth;
+	int concurrency;
 
 	bool operator==(const EngineData& data) const { return this->config.name() == data.config.name(); }
 };
 
 bool readEngineConfig(const QString& name, EngineConfiguration& config)
 {
-	const auto app = CuteChessCoreApplication::instance();
-	const auto engines = app->engineManager()->engines();
-	for (const auto& engine : engines)
-	{
-		if (engine.name() == name)
-		{
-			config = engine;
-			return true;
-		}
-	}
-	return false;
+	const auto manager = CuteChessCoreApplication::instance()->engineManager();
+	const int index = manager->engineIndex(name);
+	if (index < 0)
+		return false;
+
+	config = manager->engineAt(index);
+	return true;
 }
 
 OpeningSuite* parseOpenings(const MatchParser::Option& option, Tournament* tournament)
 {
 	QMap<QString, QString> params =
-		option.toMap("file|format=pgn|order=sequential|plies=1024|start=1");
+		option.toMap("file|format=pgn|order=sequential|plies=1024|start=1|"
+			     "index=none|slice=1/1");
 	bool ok = !params.isEmpty();
 
 	OpeningSuite::Format format = OpeningSuite::EpdFormat;
@@ -119,6 +156,15 @@ OpeningSuite* parseOpenings(const MatchParser::Option& option, Tournament* tourn
 	int plies = params["plies"].toInt();
 	int start = params["start"].toInt();
 
+	const QString slice = params["slice"];
+	int sliceIndex = slice.section('/', 0, 0).toInt();
+	int sliceCount = slice.section('/', 1).toInt();
+	if (ok && (sliceCount <= 0 || sliceIndex <= 0 || sliceIndex > sliceCount))
+	{
+		qWarning("Invalid opening slice: \"%s\"", qPrintable(slice));
+		ok = false;
+	}
+
 	ok = ok && plies > 0 && start > 0;
 	if (ok)
 	{
@@ -128,6 +174,9 @@ OpeningSuite* parseOpenings(const MatchParser::Option& option, Tournament* tourn
 							   format,
 							   order,
 							   start - 1);
+		if (params["index"] != "none")
+			suite->setIndexFileName(params["index"]);
+		suite->setSlice(sliceIndex - 1, sliceCount);
 		if (order == OpeningSuite::RandomOrder)
 			qDebug("Indexing opening suite...");
 		ok = suite->initialize();
@@ -138,6 +187,107 @@ OpeningSuite* parseOpenings(const MatchParser::Option& option, Tournament* tourn
 	return nullptr;
 }
 
+bool parseConcurrency(const QString& value, GameManager* manager)
+{
+	// A range of limits that adapt to the host load
+	if (value == "auto")
+	{
+		manager->setAdaptiveConcurrency(1, QThread::idealThreadCount());
+		return true;
+	}
+	if (value.contains('-'))
+	{
+		bool minOk = false;
+		bool maxOk = false;
+		int minimum = value.section('-', 0, 0).toInt(&minOk);
+		int maximum = value.section('-', 1).toInt(&maxOk);
+		if (!minOk || !maxOk || minimum <= 0 || maximum < minimum)
+			return false;
+
+		manager->setAdaptiveConcurrency(minimum, maximum);
+		return true;
+	}
+
+	bool ok = false;
+	int concurrency = value.toInt(&ok);
+	if (!ok || concurrency <= 0)
+		return false;
+
+	manager->setConcurrency(concurrency);
+	return true;
+}
+
+bool initializeTablebases(const QString& path)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	if (!SyzygyTablebase::initialize(path)
+	||  !SyzygyTablebase::tbAvailable(3))
+	{
+		qWarning("Could not load Syzygy tablebases");
+		return false;
+	}
+
+	qDebug("Initialized Syzygy tablebases in %lld ms", timer.elapsed());
+	return true;
+}
+
+bool preloadTablebases(const QString& value)
+{
+	// Either a piece count or a list of materials
+	bool isCount = false;
+	int pieces = value.toInt(&isCount);
+	QStringList materials;
+	if (!isCount)
+	{
+		pieces = 0;
+		materials = value.split(',', QString::SkipEmptyParts);
+		if (materials.isEmpty())
+			return false;
+	}
+	else if (pieces < 3)
+		return false;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	qint64 bytes = 0;
+	int count = SyzygyTablebase::preload(pieces, materials, &bytes);
+	qDebug("Preloaded %d tablebase files (%lld MB) in %lld ms",
+	       count, bytes / (1024 * 1024), timer.elapsed());
+
+	return true;
+}
+
+bool parsePlies(const QString& value, QList<int>& plies)
+{
+	// A list of plies and ply ranges, "end" is the final position
+	const QStringList items = value.split(',', QString::SkipEmptyParts);
+	for (const QString& item : items)
+	{
+		if (item == "end")
+		{
+			plies.append(-1);
+			continue;
+		}
+
+		const QStringList range = item.split('-');
+		bool ok = false;
+		const int minPly = range.first().toInt(&ok);
+		int maxPly = minPly;
+		if (ok && range.size() == 2)
+			maxPly = range.last().toInt(&ok);
+		if (!ok || range.size() > 2 || minPly < 0 || maxPly < minPly)
+			return false;
+
+		for (int ply = minPly; ply <= maxPly; ply++)
+			plies.append(ply);
+	}
+
+	return !plies.isEmpty();
+}
+
 bool parseEngine(const QStringList& args, EngineData& data)
 {
 	for (const auto& arg : args)
@@ -239,6 +389,18 @@ bool parseEngine(const QStringList& args, EngineData& data)
 			}
 			data.tc.setExpiryMargin(margin);
 		}
+		// Latency compensation
+		else if (name == "latencycomp")
+		{
+			bool ok = false;
+			int compensation = val.toInt(&ok);
+			if (!ok || compensation < 0)
+			{
+				qWarning() << "Invalid latency compensation:" << val;
+				return false;
+			}
+			data.tc.setLatencyCompensation(compensation);
+		}
 		else if (name == "book")
 			data.book = val;
 		else if (name == "bookdepth")
@@ -250,6 +412,15 @@ bool parseEngine(const QStringList& args, EngineData& data)
 			}
 			data.bookDepth = val.toInt();
 		}
+		else if (name == "concurrency")
+		{
+			if (val.toInt() <= 0)
+			{
+				qWarning() << "Invalid engine concurrency:" << val;
+				return false;
+			}
+			data.concurrency = val.toInt();
+		}
 		else if (name == "whitepov")
 		{
 			data.config.setWhiteEvalPov(true);
@@ -276,11 +447,51 @@ bool parseEngine(const QStringList& args, EngineData& data)
 		{
 			data.config.setPondering(true);
 		}
+		else if (name == "compactpos")
+		{
+			data.config.setCompactPositions(true);
+		}
+		else if (name == "thinkinterval")
+		{
+			bool ok = false;
+			int interval = val.toInt(&ok);
+			if (!ok || interval < 0)
+			{
+				qWarning() << "Invalid thinking interval:" << val;
+				return false;
+			}
+			data.config.setThinkingInterval(interval);
+		}
+		// Time to stop searching at the end of a game
+		else if (name == "stoptimeout")
+		{
+			bool ok = false;
+			int timeout = val.toInt(&ok);
+			if (!ok || timeout <= 0)
+			{
+				qWarning() << "Invalid stop timeout:" << val;
+				return false;
+			}
+			data.config.setStopTimeout(timeout);
+		}
 		// Custom engine option
 		else if (name.startsWith("option."))
 			data.config.setOption(name.section('.', 1), val);
 		else if (name == "stderr")
 			data.config.setStderrFile(val);
+		// Size at which the stderr file is rotated
+		else if (name == "stderrmax")
+		{
+			const qint64 size = Cgroup::parseSize(val);
+			if (size <= 0)
+			{
+				qWarning() << "Invalid stderr file size:" << val;
+				return false;
+			}
+			data.config.setStderrMaxSize(size);
+		}
+		else if (name == "remote")
+			data.config.setRemoteAddress(val);
 		else
 		{
 			qWarning() << "Invalid engine option:" << name;
@@ -295,26 +506,41 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 {
 	MatchParser parser(args);
 	parser.addOption("-srand", QVariant::UInt, 1, 1);
+	parser.addOption("-replaygame", QVariant::Int, 1, 1);
 	parser.addOption("-tournament", QVariant::String, 1, 1);
 	parser.addOption("-engine", QVariant::StringList, 1, -1, true);
 	parser.addOption("-each", QVariant::StringList, 1);
 	parser.addOption("-variant", QVariant::String, 1, 1);
-	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-concurrency", QVariant::String, 1, 1);
 	parser.addOption("-draw", QVariant::StringList);
 	parser.addOption("-resign", QVariant::StringList);
+	parser.addOption("-mate", QVariant::StringList);
+	parser.addOption("-maxmoves", QVariant::Int, 1, 1);
 	parser.addOption("-tb", QVariant::String, 1, 1);
 	parser.addOption("-tbpieces", QVariant::Int, 1, 1);
 	parser.addOption("-tbignore50", QVariant::Bool, 0, 0);
+	parser.addOption("-tbpreload", QVariant::String, 1, 1);
 	parser.addOption("-event", QVariant::String, 1, 1);
 	parser.addOption("-games", QVariant::Int, 1, 1);
 	parser.addOption("-rounds", QVariant::Int, 1, 1);
-	parser.addOption("-sprt", QVariant::StringList);
+	parser.addOption("-sprt", QVariant::StringList, 4, -1, true);
 	parser.addOption("-ratinginterval", QVariant::Int, 1, 1);
-	parser.addOption("-debug", QVariant::Bool, 0, 0);
+	parser.addOption("-bootstrap", QVariant::StringList, 1, 2);
+	parser.addOption("-metrics", QVariant::StringList);
+	parser.addOption("-broadcast", QVariant::StringList);
+	parser.addOption("-calibrate", QVariant::StringList);
+	parser.addOption("-reportinterval", QVariant::Int, 1, 1);
+	parser.addOption("-trace", QVariant::String, 1, 1);
+	parser.addOption("-debug", QVariant::StringList, 0, 2);
 	parser.addOption("-openings", QVariant::StringList);
 	parser.addOption("-bookmode", QVariant::String);
-	parser.addOption("-pgnout", QVariant::StringList, 1, 2);
-	parser.addOption("-epdout", QVariant::String, 1, 1);
+	parser.addOption("-pgnout", QVariant::StringList, 1, 3);
+	parser.addOption("-epdout", QVariant::StringList, 1, 3);
+	parser.addOption("-dataout", QVariant::StringList);
+	parser.addOption("-eventlog", QVariant::String, 1, 1);
+	parser.addOption("-openingstats", QVariant::String, 1, 1);
+	parser.addOption("-binout", QVariant::String, 1, 1);
+	parser.addOption("-outputsync", QVariant::String, 1, 1);
 	parser.addOption("-repeat", QVariant::Int, 0, 1);
 	parser.addOption("-noswap", QVariant::Bool, 0, 0);
 	parser.addOption("-recover", QVariant::Bool, 0, 0);
@@ -322,12 +548,22 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	parser.addOption("-wait", QVariant::Int, 1, 1);
 	parser.addOption("-seeds", QVariant::UInt, 1, 1);
 	parser.addOption("-livepgnout", QVariant::StringList, 1, 2);
+	parser.addOption("-liveinterval", QVariant::Int, 1, 1);
+	parser.addOption("-liveevents", QVariant::String, 1, 1);
 	parser.addOption("-tournamentfile", QVariant::String, 1, 1);
 	parser.addOption("-resume", QVariant::Bool, 0, 0);
 	parser.addOption("-ecopgn", QVariant::String, 1, 1);
 	parser.addOption("-bergerschedule", QVariant::Bool, 0, 0);
 	parser.addOption("-kfactor", QVariant::Double, 1, 1);
 	parser.addOption("-reloadconf", QVariant::Bool, 0, 0);
+	parser.addOption("-enginecache", QVariant::String, 1, 1);
+	parser.addOption("-resultcache", QVariant::String, 1, 1);
+	parser.addOption("-prestart", QVariant::Bool, 0, 0);
+	parser.addOption("-affinity", QVariant::StringList, 1);
+	parser.addOption("-cgroup", QVariant::StringList, 1, 3);
+	parser.addOption("-cpubudget", QVariant::Bool, 0, 0);
+	parser.addOption("-workers", QVariant::String, 1, 1);
+	parser.addOption("-lookahead", QVariant::Int, 1, 1);
 
 	if (!parser.parse())
 		return nullptr;
@@ -335,9 +571,17 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	GameManager* gameManager = CuteChessCoreApplication::instance()->gameManager();
 
 	QVariantMap tfMap, tMap, eMap;
+	QVariantList progress;
+	QString progressFile;
 	QVariantList eList;
 	bool wantsResume = false;
-	bool wantsDebug = parser.takeOption("-debug").toBool();
+	const QVariant debugValue = parser.takeOption("-debug");
+	QString debugLogDir;
+	bool autoAffinity = false;
+	bool cpuBudget = false;
+	double tcScale = 1.0;
+	QList<CpuAffinity::CpuSet> cpuSets;
+	QString tbPreload;
 
 	QString ecoPgn = parser.takeOption("-ecopgn").toString();
 	if (!ecoPgn.isEmpty())
@@ -371,11 +615,15 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 				}
 
 				QTextStream stream(&input);
-				JsonParser jsonParser(stream);
+				JsonReader reader(stream);
 				// we don't want to use the tournament file at all unless wantResume == true
 				wantsResume = parser.takeOption("-resume").toBool();
 				if (wantsResume) {
-					tfMap = jsonParser.parse().toMap();
+					reader.readNext();
+					tfMap = reader.readValue().toMap();
+					if (reader.hasError())
+						qWarning("%s", qPrintable(QString("bad tournament configuration file line %1 in %2: %3")
+							.arg(reader.errorLineNumber()).arg(tournamentFile).arg(reader.errorString()))); // clazy:exclude=qstring-arg
 					if (tfMap.contains("tournamentSettings"))
 						tMap = tfMap["tournamentSettings"].toMap();
 					if (tfMap.contains("engineSettings"))
@@ -384,6 +632,13 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 						usingTournamentFile = true;
 				}
 			}
+
+			// The progress is kept in a file of its own, which is
+			// relative to the tournament file
+			progressFile = TournamentJournal::progressFileName(tournamentFile);
+			if (tfMap.contains("matchProgressFile"))
+				progressFile = QFileInfo(tournamentFile).dir()
+					.filePath(tfMap["matchProgressFile"].toString());
 	}
 
 	QString ttype;
@@ -427,11 +682,25 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	}
 	if (srand) {
 		Mersenne::initialize(srand);
+		tournament->setSeed(srand);
 		tMap.insert("srand", srand);
 	}
 
+	// Rerun a single game with the setup it had in the full run
+	const int replayGame = parser.takeOption("-replaygame").toInt();
+	if (replayGame > 0)
+	{
+		if (!srand)
+		{
+			qWarning("-replaygame needs the -srand seed of the original run");
+			delete tournament;
+			return nullptr;
+		}
+		tournament->setReplayGame(replayGame);
+	}
+
 	EngineMatch* match = new EngineMatch(tournament, &app);
-	if (!tournamentFile.isEmpty()) match->setTournamentFile(tournamentFile);
+	if (!tournamentFile.isEmpty()) match->setTournamentFile(tournamentFile, progressFile);
 
 	QList<EngineData> engines;
 	QStringList eachOptions;
@@ -461,6 +730,8 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 				tournament->setPgnOutput(tMap["pgnOutput"].toString(), (PgnGame::PgnMode)tMap["pgnOutMode"].toInt());
 			else
 				tournament->setPgnOutput(tMap["pgnOutput"].toString());
+			if (tMap.contains("pgnOutOrdered"))
+				tournament->setPgnOutputOrdered(tMap["pgnOutOrdered"].toBool());
 		}
 		if (tMap.contains("livePgnOutput")) {
 			if (tMap.contains("livePgnOutMode"))
@@ -468,14 +739,38 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			else
 				tournament->setLivePgnOutput(tMap["livePgnOutput"].toString());
 		}
-		if (tMap.contains("epdOutput"))
-			tournament->setEpdOutput(tMap["epdOutput"].toString());
+		if (tMap.contains("livePgnInterval"))
+			tournament->setLivePgnInterval(tMap["livePgnInterval"].toInt());
+		if (tMap.contains("liveEventOutput"))
+			tournament->setLiveEventOutput(tMap["liveEventOutput"].toString());
+		if (tMap.contains("epdOutput")) {
+			QList<int> plies;
+			for (const QVariant& ply : tMap["epdOutPlies"].toList())
+				plies.append(ply.toInt());
+			tournament->setEpdOutput(tMap["epdOutput"].toString(),
+						 plies,
+						 tMap["epdOutUnique"].toBool());
+		}
+		if (tMap.contains("eventLogOutput"))
+			tournament->setEventLogOutput(tMap["eventLogOutput"].toString());
+		if (tMap.contains("dataOutput")) {
+			QVariantMap dMap = tMap["dataOutput"].toMap();
+			tournament->setDataOutput(dMap["file"].toString(),
+						  dMap["skipFlags"].toInt(),
+						  dMap["sampleRate"].toDouble());
+		}
+		if (tMap.contains("openingStatsOutput"))
+			tournament->setOpeningStatsOutput(tMap["openingStatsOutput"].toString());
+		if (tMap.contains("binaryOutput"))
+			tournament->setBinaryOutput(tMap["binaryOutput"].toString());
+		if (tMap.contains("outputSync"))
+			tournament->setOutputSyncPolicy((GameWriter::SyncPolicy)tMap["outputSync"].toInt());
 		if (tMap.contains("pgnCleanupEnabled"))
 			tournament->setPgnCleanupEnabled(tMap["pgnCleanupEnabled"].toBool());
 		if (tMap.contains("openingRepetitions"))
 			tournament->setOpeningRepetitions(tMap["openingRepetitions"].toInt());
 		if (tMap.contains("concurrency"))
-			gameManager->setConcurrency(tMap["concurrency"].toInt());
+			parseConcurrency(tMap["concurrency"].toString(), gameManager);
 		if (tMap.contains("drawAdjudication")) {
 			QVariantMap dMap = tMap["drawAdjudication"].toMap();
 			if (dMap.contains("movenumber") &&
@@ -496,6 +791,17 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 				adjudicator.setResignThreshold(rMap["movecount"].toInt(), -(rMap["score"].toInt()));
 			}
 		}
+		if (tMap.contains("mateAdjudication")) {
+			QVariantMap mMap = tMap["mateAdjudication"].toMap();
+			if (mMap.contains("movecount") &&
+				mMap.contains("distance"))
+			{
+				adjudicator.setMateThreshold(mMap["movecount"].toInt(),
+							     mMap["distance"].toInt());
+			}
+		}
+		if (tMap.contains("maxMoves"))
+			adjudicator.setMaximumGameLength(tMap["maxMoves"].toInt());
 
 		if (tMap.contains("swapSides"))
 			tournament->setSwapSides(tMap["swapSides"].toBool());
@@ -503,11 +809,10 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 		if (tMap.contains("tb")) {
 			adjudicator.setTablebaseAdjudication(true);
 
-			bool ok = SyzygyTablebase::initialize(tMap["tb"].toString()) &&
-				 SyzygyTablebase::tbAvailable(3);
-			if (!ok)
-				qWarning("Could not load Syzygy tablebases");
+			initializeTablebases(tMap["tb"].toString());
 		}
+		if (tMap.contains("tbPreload"))
+			tbPreload = tMap["tbPreload"].toString();
 		if (tMap.contains("tbPieces")) {
 			int value = tMap["tbPieces"].toInt();
 			if (value > 2)
@@ -536,6 +841,7 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 				QStringList eData = eList.at(e).toStringList();
 				EngineData engine;
 				engine.bookDepth = 1000;
+				engine.concurrency = 0;
 				ok = parseEngine(eData, engine);
 				if (ok)
 					engines.append(engine);
@@ -545,27 +851,30 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			eachOptions = eMap["each"].toStringList();
 		}
 
-		if (tfMap.contains("matchProgress")) {
-			if (!wantsResume) {
-				tfMap.remove("matchProgress");
-			} else {
-				QVariantList pList;
-				int nextGame = 0;
-
-				pList = tfMap["matchProgress"].toList();
-				QVariantList::iterator p;
-				for (p = pList.begin(); p != pList.end(); ++p) {
-					QVariantMap pMap = p->toMap();
-					if (pMap["result"] == "*") {
-						pList.erase(p, pList.end());
-						break;
-					}
+		if (wantsResume) {
+			// Older tournament files keep the progress inline,
+			// with a journal of the games after the last snapshot
+			progress = tfMap.take("matchProgress").toList();
+			TournamentJournal(TournamentJournal::legacyFileName(tournamentFile))
+				.replay(progress);
+
+			TournamentJournal journal(progressFile);
+			int records = journal.replay(progress);
+			if (records > 0)
+				qDebug("Replayed %d records from %s", records,
+				       qPrintable(journal.fileName()));
+
+			QVariantList::iterator p;
+			for (p = progress.begin(); p != progress.end(); ++p) {
+				QVariantMap pMap = p->toMap();
+				if (pMap["result"] == "*") {
+					progress.erase(p, progress.end());
+					break;
 				}
-				tfMap.insert("matchProgress", pList);
-				nextGame = pList.size();
-				if (nextGame > 0)
-					tournament->setResume(nextGame);
 			}
+			int nextGame = progress.size();
+			if (nextGame > 0)
+				tournament->setResume(nextGame);
 		}
 	} else { // !usingTournamentFile
 		const auto options = parser.options();
@@ -581,6 +890,7 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			{
 				EngineData engine;
 				engine.bookDepth = 1000;
+				engine.concurrency = 0;
 				ok = parseEngine(value.toStringList(), engine);
 				if (ok) {
 					if (!engines.contains(engine))
@@ -605,11 +915,9 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			}
 			else if (name == "-concurrency")
 			{
-				ok = value.toInt() > 0;
-				if (ok) {
-					gameManager->setConcurrency(value.toInt());
-					tMap.insert("concurrency", value.toInt());
-				}
+				ok = parseConcurrency(value.toString(), gameManager);
+				if (ok)
+					tMap.insert("concurrency", value.toString());
 			}
 			// Threshold for draw adjudication
 			else if (name == "-draw")
@@ -651,18 +959,49 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 					tMap.insert("resignAdjudication", rMap);
 				}
 			}
+			// Threshold for mate score adjudication
+			else if (name == "-mate")
+			{
+				QMap<QString, QString> params = option.toMap("movecount|distance");
+				bool countOk = false;
+				bool distanceOk = false;
+				int moveCount = params["movecount"].toInt(&countOk);
+				int distance = params["distance"].toInt(&distanceOk);
+
+				ok = (countOk && distanceOk && moveCount >= 0 && distance >= 0);
+				if (ok) {
+					adjudicator.setMateThreshold(moveCount, distance);
+					QVariantMap mMap;
+					mMap.insert("movecount", moveCount);
+					mMap.insert("distance", distance);
+					tMap.insert("mateAdjudication", mMap);
+				}
+			}
+			// Maximum game length adjudication
+			else if (name == "-maxmoves")
+			{
+				ok = value.toInt() >= 0;
+				if (ok)
+				{
+					adjudicator.setMaximumGameLength(value.toInt());
+					tMap.insert("maxMoves", value.toInt());
+				}
+			}
 			// Syzygy tablebase adjudication
 			else if (name == "-tb")
 			{
 				adjudicator.setTablebaseAdjudication(true);
 				QString path = value.toString();
 
-				ok = SyzygyTablebase::initialize(path) &&
-					 SyzygyTablebase::tbAvailable(3);
+				ok = initializeTablebases(path);
 				if (ok)
 					tMap.insert("tb", path);
-				else
-					qWarning("Could not load Syzygy tablebases");
+			}
+			// Tablebase files read before the games start
+			else if (name == "-tbpreload")
+			{
+				tbPreload = value.toString();
+				tMap.insert("tbPreload", tbPreload);
 			}
 			// Syzygy tablebase pieces
 			else if (name == "-tbpieces")
@@ -720,22 +1059,113 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			// SPRT-based stopping rule
 			else if (name == "-sprt")
 			{
-				QMap<QString, QString> params = option.toMap("elo0|elo1|alpha|beta");
+				QMap<QString, QString> params = option.toMap("elo0|elo1|alpha|beta|model=trinomial|name=default|stop=any");
 				bool sprtOk[4];
 				double elo0 = params["elo0"].toDouble(sprtOk);
 				double elo1 = params["elo1"].toDouble(sprtOk + 1);
 				double alpha = params["alpha"].toDouble(sprtOk + 2);
 				double beta = params["beta"].toDouble(sprtOk + 3);
-
-				ok = (sprtOk[0] && sprtOk[1] && sprtOk[2] && sprtOk[3]);
+				const QString model = params["model"];
+				const QString stop = params["stop"];
+				const QString sprtName = params["name"];
+
+				Sprt::StopPolicy policy = Sprt::StopOnDecision;
+				if (stop == "h0")
+					policy = Sprt::StopOnH0;
+				else if (stop == "h1")
+					policy = Sprt::StopOnH1;
+				else if (stop == "no")
+					policy = Sprt::NeverStop;
+
+				ok = (sprtOk[0] && sprtOk[1] && sprtOk[2] && sprtOk[3]
+				      && (model == "trinomial" || model == "pentanomial")
+				      && (policy != Sprt::StopOnDecision || stop == "any"));
+				// Each monitor can only be set once
+				Sprt* sprt = nullptr;
+				if (ok)
+				{
+					sprt = tournament->addSprt(sprtName == "default"
+						? QString() : sprtName, policy);
+					ok = (sprt != nullptr);
+				}
 				if (ok) {
-					tournament->sprt()->initialize(elo0, elo1, alpha, beta);
+					sprt->initialize(elo0, elo1, alpha, beta);
+					if (model == "pentanomial")
+						sprt->setModel(Sprt::Pentanomial);
 					QVariantMap sMap;
 					sMap.insert("elo0", elo0);
 					sMap.insert("elo1", elo1);
 					sMap.insert("alpha", alpha);
 					sMap.insert("beta", beta);
-					tMap.insert("sprt", sMap);
+					sMap.insert("model", model);
+					sMap.insert("stop", stop);
+					if (sprtName == "default")
+						tMap.insert("sprt", sMap);
+					else
+					{
+						QVariantMap monitors = tMap.value("sprtMonitors").toMap();
+						monitors.insert(sprtName, sMap);
+						tMap.insert("sprtMonitors", monitors);
+					}
+				}
+			}
+			// HTTP endpoint for live metrics
+			else if (name == "-metrics")
+			{
+				QMap<QString, QString> params =
+					option.toMap("port|address=127.0.0.1");
+				const int port = params["port"].toInt(&ok);
+				const QHostAddress address(params["address"]);
+
+				ok = ok && port > 0 && port <= 65535
+				     && !address.isNull();
+				if (ok)
+				{
+					auto server = new MetricsServer(tournament, match);
+					ok = server->listen(address, quint16(port));
+				}
+			}
+			// Live stream of the games for viewers
+			else if (name == "-broadcast")
+			{
+				QMap<QString, QString> params =
+					option.toMap("port|address=127.0.0.1");
+				const int port = params["port"].toInt(&ok);
+				const QHostAddress address(params["address"]);
+
+				ok = ok && port > 0 && port <= 65535
+				     && !address.isNull();
+				if (ok)
+				{
+					auto server = new BroadcastServer(tournament, match);
+					ok = server->listen(address, quint16(port));
+				}
+			}
+			// Scale the time controls to the speed of the host
+			else if (name == "-calibrate")
+			{
+				QMap<QString, QString> params =
+					option.toMap("ref|bench=perft|time=2000");
+				const qint64 reference = params["ref"].toLongLong(&ok);
+				const int msecs = params["time"].toInt();
+				const QString bench = params["bench"];
+
+				ok = ok && reference > 0 && msecs > 0;
+				if (ok)
+				{
+					const qint64 speed = (bench == "perft")
+						? HostCalibration::perftSpeed(msecs)
+						: HostCalibration::benchSpeed(bench, 300000);
+					ok = speed > 0;
+					if (ok)
+					{
+						tcScale = HostCalibration::scaleFactor(speed,
+										       reference);
+						tournament->setTimeControlScale(tcScale);
+						qDebug("Host speed %lld nps, reference %lld nps: "
+						       "time controls scaled by %.3f",
+						       speed, reference, tcScale);
+					}
 				}
 			}
 			// Interval for rating list updates
@@ -744,6 +1174,35 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 				match->setRatingInterval(value.toInt());
 				tMap.insert("ratingInterval", value.toInt());
 			}
+			// Bootstrap confidence intervals of the ratings
+			else if (name == "-bootstrap")
+			{
+				QMap<QString, QString> params =
+					option.toMap("samples|interval=no");
+				const int samples = params["samples"].toInt(&ok);
+				const QString interval = params["interval"];
+
+				ok = ok && samples > 0
+				     && (interval == "yes" || interval == "no");
+				if (ok)
+				{
+					tournament->setBootstrapSamples(samples);
+					match->setBootstrapInterval(interval == "yes");
+				}
+			}
+			// Interval for rewriting the schedule and crosstable
+			else if (name == "-reportinterval")
+			{
+				ok = value.toInt() >= 0;
+				if (ok)
+					match->setReportInterval(value.toInt() * 1000);
+			}
+			// Chrome trace of the game phases
+			else if (name == "-trace")
+			{
+				s_traceFile = value.toString();
+				Tracer::setEnabled(true);
+			}
 			// Use an opening suite
 			else if (name == "-openings")
 				openingsOption = option;
@@ -753,18 +1212,23 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			else if (name == "-pgnout")
 			{
 				PgnGame::PgnMode mode = PgnGame::Verbose;
+				bool ordered = true;
 				QStringList list = value.toStringList();
-				if (list.size() == 2)
+				for (int i = 1; i < list.size(); i++)
 				{
-					if (list.at(1) == "min")
+					if (list.at(i) == "min")
 						mode = PgnGame::Minimal;
+					else if (list.at(i) == "unordered")
+						ordered = false;
 					else
 						ok = false;
 				}
 				if (ok) {
 					tournament->setPgnOutput(list.at(0), mode);
+					tournament->setPgnOutputOrdered(ordered);
 					tMap.insert("pgnOutput", list.at(0));
 					tMap.insert("pgnOutMode", mode);
+					tMap.insert("pgnOutOrdered", ordered);
 				}
 			}
 			// TCEC live PGN file
@@ -785,12 +1249,123 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 					tMap.insert("livePgnOutMode", mode);
 				}
 			}
+			// Minimum time between two live PGN rewrites
+			else if (name == "-liveinterval")
+			{
+				int interval = value.toInt(&ok);
+				if (ok && interval >= 0)
+				{
+					tournament->setLivePgnInterval(interval);
+					tMap.insert("livePgnInterval", interval);
+				}
+				else
+					ok = false;
+			}
+			// Append-only stream of live game events
+			else if (name == "-liveevents")
+			{
+				QString fileName = value.toString();
+				tournament->setLiveEventOutput(fileName);
+				tMap.insert("liveEventOutput", fileName);
+			}
 			// FEN/EPD output file to save positions
 			else if (name == "-epdout")
+			{
+				QList<int> plies;
+				bool unique = false;
+				QStringList list = value.toStringList();
+				for (int i = 1; i < list.size(); i++)
+				{
+					if (list.at(i) == "unique")
+						unique = true;
+					else if (!list.at(i).startsWith("plies=")
+					     ||  !parsePlies(list.at(i).mid(6), plies))
+						ok = false;
+				}
+				if (ok) {
+					tournament->setEpdOutput(list.at(0), plies, unique);
+					QVariantList pList;
+					for (int ply : plies)
+						pList.append(ply);
+					tMap.insert("epdOutput", list.at(0));
+					tMap.insert("epdOutPlies", pList);
+					tMap.insert("epdOutUnique", unique);
+				}
+			}
+			// Positions with search data for training
+			else if (name == "-dataout")
+			{
+				QMap<QString, QString> params =
+					option.toMap("file|sample=1|book=no|check=yes|tb=yes");
+				ok = !params.isEmpty();
+
+				for (const char* key : { "book", "check", "tb" })
+				{
+					if (ok && params[key] != "yes" && params[key] != "no")
+						ok = false;
+				}
+
+				int skipFlags = 0;
+				if (params["book"] == "no")
+					skipFlags |= TrainingData::BookMove;
+				if (params["check"] == "no")
+					skipFlags |= TrainingData::InCheck;
+				if (params["tb"] == "no")
+					skipFlags |= TrainingData::TablebaseRange;
+
+				double sampleRate = params.value("sample").toDouble();
+				if (sampleRate <= 0.0 || sampleRate > 1.0)
+					ok = false;
+
+				if (ok)
+				{
+					tournament->setDataOutput(params["file"],
+								  skipFlags,
+								  sampleRate);
+					QVariantMap dMap;
+					dMap.insert("file", params["file"]);
+					dMap.insert("skipFlags", skipFlags);
+					dMap.insert("sampleRate", sampleRate);
+					tMap.insert("dataOutput", dMap);
+				}
+			}
+			// JSON lines log of tournament events
+			else if (name == "-eventlog")
+			{
+				QString fileName = value.toString();
+				tournament->setEventLogOutput(fileName);
+				tMap.insert("eventLogOutput", fileName);
+			}
+			// Results of the games of every opening
+			else if (name == "-openingstats")
+			{
+				QString fileName = value.toString();
+				tournament->setOpeningStatsOutput(fileName);
+				tMap.insert("openingStatsOutput", fileName);
+			}
+			// Binary archive file where the games should be saved
+			else if (name == "-binout")
 			{
 				QString fileName = value.toString();
-				tournament->setEpdOutput(fileName);
-				tMap.insert("epdOutput", fileName);
+				tournament->setBinaryOutput(fileName);
+				tMap.insert("binaryOutput", fileName);
+			}
+			// When the output files are synced to disk
+			else if (name == "-outputsync")
+			{
+				GameWriter::SyncPolicy policy = GameWriter::NoSync;
+				QString val = value.toString();
+				if (val == "close")
+					policy = GameWriter::SyncOnClose;
+				else if (val == "batch")
+					policy = GameWriter::SyncEachBatch;
+				else if (val != "none")
+					ok = false;
+				if (ok)
+				{
+					tournament->setOutputSyncPolicy(policy);
+					tMap.insert("outputSync", policy);
+				}
 			}
 			// Play every opening twice (default), or multiple times
 			else if (name == "-repeat")
@@ -874,6 +1449,82 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 				tournament->setReloadEngines(flag);
 				tMap.insert("reloadConfiguration", flag);
 			}
+			// Cache the engines' protocol handshakes
+			else if (name == "-enginecache")
+				EngineHandshakeCache::setFileName(value.toString());
+			// Reuse the games of earlier runs
+			else if (name == "-resultcache")
+				tournament->setResultCache(value.toString());
+			// Start restarting engines before they are needed
+			else if (name == "-prestart")
+				gameManager->setPrestartEngines(true);
+			// Keep pondering engines from oversubscribing the CPUs
+			else if (name == "-cpubudget")
+				cpuBudget = true;
+			// Bind the engines of each game slot to a set of CPUs
+			else if (name == "-affinity")
+			{
+				const QStringList list = value.toStringList();
+				if (list.size() == 1 && list.first() == "auto")
+					autoAffinity = true;
+				else
+				{
+					for (const QString& str : list)
+					{
+						auto set = CpuAffinity::parse(str);
+						if (set.isEmpty())
+						{
+							ok = false;
+							break;
+						}
+						cpuSets << set;
+					}
+				}
+				if (ok && !CpuAffinity::isSupported())
+					qWarning("CPU affinity is not supported "
+						 "on this platform");
+			}
+			// Confine the engines of each game slot to a cgroup
+			else if (name == "-cgroup")
+			{
+				QMap<QString, QString> params =
+					option.toMap("path|cpu=0|memory=0");
+				const int cpuQuota = params["cpu"].toInt(&ok);
+				const QString memory = params["memory"];
+				const qint64 memoryLimit = Cgroup::parseSize(memory);
+
+				ok = ok && !params["path"].isEmpty() && cpuQuota >= 0
+				     && (memoryLimit > 0 || memory == "0");
+				if (ok && !gameManager->setCgroups(params["path"],
+								   cpuQuota,
+								   memoryLimit))
+				{
+					qWarning("Cannot use cgroup %s",
+						 qPrintable(params["path"]));
+					ok = false;
+				}
+			}
+			// Play many games in each of a few worker threads
+			else if (name == "-workers")
+			{
+				if (value.toString() == "auto")
+					gameManager->setWorkerThreads(
+						GameManager::defaultWorkerThreads());
+				else
+				{
+					int count = value.toString().toInt(&ok);
+					ok = ok && count > 0;
+					if (ok)
+						gameManager->setWorkerThreads(count);
+				}
+			}
+			// Start first the games whose engines are already running
+			else if (name == "-lookahead")
+			{
+				ok = value.toInt() > 0;
+				if (ok)
+					gameManager->setLookahead(value.toInt());
+			}
 			else
 				qFatal("Unknown argument: \"%s\"", qPrintable(name));
 
@@ -903,8 +1554,45 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 
 	bool ok = true;
 
-	// Debugging mode. Prints all engine input and output.
-	if (wantsDebug)
+	if (!tbPreload.isEmpty())
+	{
+		if (!tMap.contains("tb"))
+		{
+			qWarning("-tbpreload needs -tb");
+			ok = false;
+		}
+		else if (!preloadTablebases(tbPreload))
+		{
+			qWarning("Invalid tablebase preload: %s",
+				 qPrintable(tbPreload));
+			ok = false;
+		}
+	}
+
+	// Debugging mode. Prints all engine input and output, or writes
+	// it to a log file per engine. The memory usage can be reported
+	// after every game too.
+	QStringList debugArgs;
+	if (debugValue.type() == QVariant::StringList)
+	{
+		debugArgs = debugValue.toStringList();
+		if (debugArgs.removeAll("memory") > 0)
+			match->setMemoryDebug(true);
+	}
+	if (!debugArgs.isEmpty())
+	{
+		MatchParser::Option option = { "-debug", debugArgs };
+		debugLogDir = option.toMap("file").value("file");
+		if (debugLogDir.isEmpty())
+			ok = false;
+		else if (!QDir().mkpath(debugLogDir))
+		{
+			qWarning("Cannot create directory %s",
+				 qPrintable(debugLogDir));
+			ok = false;
+		}
+	}
+	else if (debugValue.toBool())
 		match->setDebugMode(true);
 
 	if (tMap.contains("eloKfactor"))
@@ -921,6 +1609,39 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 		}
 	}
 
+	// A pondering engine keeps thinking on the opponent's time, so
+	// each game keeps two CPUs busy instead of one
+	bool pondering = false;
+	const auto& ponderEngines = engines;
+	for (const auto& engine : ponderEngines)
+		pondering = pondering || engine.config.pondering();
+	const int cpuLimit = qMax(1, QThread::idealThreadCount() / 2);
+	if (pondering && gameManager->maxConcurrency() > cpuLimit)
+	{
+		if (cpuBudget)
+		{
+			gameManager->limitConcurrency(cpuLimit);
+			qDebug("Concurrency limited to %d games for pondering",
+			       cpuLimit);
+		}
+		else
+			qWarning("Pondering engines need two CPUs per game; "
+				 "use -cpubudget to limit concurrency to %d",
+				 cpuLimit);
+	}
+
+	// Spread the game slots evenly over the NUMA nodes
+	if (autoAffinity)
+		cpuSets = CpuAffinity::split(CpuAffinity::nodes(),
+					     gameManager->maxConcurrency());
+	if (!cpuSets.isEmpty() && CpuAffinity::isSupported())
+	{
+		for (int i = 0; i < cpuSets.size(); i++)
+			qDebug("Game slot %d: CPUs %s", i + 1,
+			       qPrintable(CpuAffinity::toString(cpuSets.at(i))));
+		gameManager->setCpuAffinity(cpuSets);
+	}
+
 	const auto& constEngines = engines;
 	for (const auto& engine : constEngines)
 	{
@@ -931,7 +1652,8 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			break;
 		}
 
-		if (engine.config.command().isEmpty())
+		if (engine.config.command().isEmpty()
+		&&  engine.config.remoteAddress().isEmpty())
 		{
 			ok = false;
 			qCritical("missing chess engine command");
@@ -945,10 +1667,19 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			break;
 		}
 
-		tournament->addPlayer(new EngineBuilder(engine.config),
-				      engine.tc,
+		TimeControl tc(engine.tc);
+		if (tcScale != 1.0)
+			tc.scale(tcScale);
+
+		auto builder = new EngineBuilder(engine.config);
+		builder->setDebugLogDirectory(debugLogDir);
+		tournament->addPlayer(builder,
+				      tc,
 				      match->addOpeningBook(engine.book),
 				      engine.bookDepth);
+		if (engine.concurrency > 0)
+			tournament->gameManager()->setPlayerConcurrency(
+				builder, engine.concurrency);
 	}
 
 	if (!openingsOption.name.isEmpty()) {
@@ -967,6 +1698,8 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 			match->setBookMode(OpeningBook::Ram);
 		else if (val == "disk")
 			match->setBookMode(OpeningBook::Disk);
+		else if (val == "mapped")
+			match->setBookMode(OpeningBook::Mapped);
 		else
 			ok = false;
 	}
@@ -977,7 +1710,20 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 		ok = false;
 	}
 
-	if (!ok)
+	// The pentanomial model pairs the two games of each opening
+	for (int i = 0; i < tournament->sprtCount(); i++)
+	{
+		const Sprt* sprt = tournament->sprtAt(i);
+		if (!sprt->isNull() && sprt->model() == Sprt::Pentanomial
+		&&  tMap.value("openingRepetitions").toInt() != 2)
+		{
+			qWarning("The pentanomial SPRT model needs \"-repeat 2\"");
+			ok = false;
+			break;
+		}
+	}
+
+	if (!ok)
 	{
 		delete match;
 		delete tournament;
@@ -985,12 +1731,6 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	}
 
 	if (!tournamentFile.isEmpty() && !tMap.isEmpty()) {
-		QFile output(tournamentFile);
-		if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
-			qWarning("cannot open tournament configuration file: %s", qPrintable(tournamentFile));
-			return 0;
-		}
-
 		if (!wantsResume || !tMap.contains("eventDate")) {
 			QString eventDate = QDate::currentDate().toString("yyyy.MM.dd");
 			tournament->setEventDate(eventDate);
@@ -1001,9 +1741,19 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 		eMap.insert("engines", eList);
 		tfMap.insert("engineSettings", eMap);
 
-		QTextStream out(&output);
-		JsonSerializer serializer(tfMap);
-		serializer.serialize(out);
+		tfMap.remove("matchProgress");
+		tfMap.insert("matchProgressFile", QFileInfo(tournamentFile).dir()
+			     .relativeFilePath(progressFile));
+
+		// The tournament file only changes here; the progress
+		// store is compacted and then appended to
+		if (!TournamentJournal::writeSnapshot(tournamentFile, tfMap))
+			return 0;
+		if (!TournamentJournal(progressFile).rewrite(progress))
+			return 0;
+		TournamentJournal(TournamentJournal::legacyFileName(tournamentFile))
+			.remove();
+		match->setProgress(progress);
 	}
 
 	tournament->setAdjudicator(adjudicator);
@@ -1011,8 +1761,770 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	return match;
 }
 
+quint64 perft(Chess::Board* board, int depth)
+{
+	Chess::MoveList moves;
+	board->legalMoves(moves);
+	if (depth <= 1 || moves.isEmpty())
+		return moves.size();
+
+	quint64 nodeCount = 0;
+	for (const auto& move : moves)
+	{
+		board->makeMove(move);
+		nodeCount += perft(board, depth - 1);
+		board->undoMove();
+	}
+
+	return nodeCount;
+}
+
+int runPerft(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-perft", QVariant::Int, 1, 1);
+	parser.addOption("-variant", QVariant::String, 1, 1);
+	parser.addOption("-fen", QVariant::String, 1);
+	parser.addOption("-divide", QVariant::Bool, 0, 0);
+	if (!parser.parse())
+		return 1;
+
+	int depth = parser.takeOption("-perft").toInt();
+	if (depth < 1)
+	{
+		qWarning("Invalid perft depth: %d", depth);
+		return 1;
+	}
+
+	QString variant = parser.takeOption("-variant").toString();
+	if (variant.isEmpty())
+		variant = "standard";
+	if (!Chess::BoardFactory::variants().contains(variant))
+	{
+		qWarning("Unknown chess variant: %s", qPrintable(variant));
+		return 1;
+	}
+
+	QScopedPointer<Chess::Board> board(Chess::BoardFactory::create(variant));
+	QString fen = parser.takeOption("-fen").toString();
+	if (fen.isEmpty())
+		fen = board->defaultFenString();
+	if (!board->setFenString(fen))
+	{
+		qWarning("Invalid FEN string: %s", qPrintable(fen));
+		return 1;
+	}
+
+	bool divide = parser.takeOption("-divide").toBool();
+	QTextStream out(stdout);
+	QElapsedTimer timer;
+	timer.start();
+
+	quint64 nodeCount = 0;
+	if (divide)
+	{
+		const auto moves = board->legalMoves();
+		for (const auto& move : moves)
+		{
+			QString str = board->moveString(move,
+							Chess::Board::LongAlgebraic);
+			board->makeMove(move);
+			quint64 count = (depth > 1) ? perft(board.data(), depth - 1) : 1;
+			board->undoMove();
+
+			out << str << ": " << count << endl;
+			nodeCount += count;
+		}
+		out << endl;
+	}
+	else
+		nodeCount = perft(board.data(), depth);
+
+	qint64 elapsed = timer.elapsed();
+	out << "Nodes: " << nodeCount << endl;
+	out << "Time: " << elapsed << " ms" << endl;
+	if (elapsed > 0)
+		out << "Nodes per second: " << nodeCount * 1000 / elapsed << endl;
+
+	return 0;
+}
+
+int runConvert(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-convert", QVariant::StringList, 2, 2);
+	if (!parser.parse())
+		return 1;
+
+	const QStringList files = parser.takeOption("-convert").toStringList();
+	const QString& input = files.at(0);
+	const QString& output = files.at(1);
+	int count = 0;
+
+	if (GameArchive::isArchive(input))
+	{
+		// Binary archive to PGN
+		GameArchive archive;
+		if (!archive.open(input))
+		{
+			qWarning("Could not open game archive %s", qPrintable(input));
+			return 1;
+		}
+
+		// A ".gz" suffix selects compressed output
+		const bool compress = GzipDevice::isGzipFileName(output);
+		QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
+		if (!compress)
+			mode |= QIODevice::Text;
+
+		QFile file(output);
+		GzipDevice gzip(&file);
+		if (!file.open(mode)
+		||  (compress && !gzip.open(QIODevice::WriteOnly)))
+		{
+			qWarning("Could not open PGN file %s", qPrintable(output));
+			return 1;
+		}
+
+		QTextStream out(compress ? static_cast<QIODevice*>(&gzip) : &file);
+		PgnGame game;
+		for (; count < archive.gameCount(); count++)
+		{
+			if (!archive.readGame(count, game) || !game.write(out))
+			{
+				qWarning("Could not convert game %d", count + 1);
+				return 1;
+			}
+		}
+		out.flush();
+		gzip.close();
+	}
+	else
+	{
+		// PGN to binary archive
+		// Compressed input is detected by PgnStream, but it
+		// must not go through text mode newline conversion
+		QIODevice::OpenMode mode = QIODevice::ReadOnly;
+		if (!GzipDevice::isGzipFileName(input))
+			mode |= QIODevice::Text;
+
+		QFile file(input);
+		if (!file.open(mode))
+		{
+			qWarning("Could not open PGN file %s", qPrintable(input));
+			return 1;
+		}
+
+		GameArchive archive;
+		if (!archive.open(output, QIODevice::WriteOnly))
+		{
+			qWarning("Could not open game archive %s", qPrintable(output));
+			return 1;
+		}
+
+		PgnStream in;
+		if (!in.setMappedFile(&file))
+			in.setDevice(&file);
+
+		PgnGame game;
+		while (game.read(in, INT_MAX - 1, false))
+		{
+			if (!archive.writeGame(game))
+			{
+				qWarning("Could not convert game %d", count + 1);
+				return 1;
+			}
+			count++;
+		}
+	}
+
+	QTextStream(stdout) << "Converted " << count << " games" << endl;
+	return 0;
+}
+
+int runPgnTool(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-pgntool", QVariant::StringList, 2, 2);
+	parser.addOption("-event", QVariant::String, 1, 1);
+	parser.addOption("-site", QVariant::String, 1, 1);
+	parser.addOption("-player", QVariant::StringList, 1, 2);
+	parser.addOption("-opponent", QVariant::String, 1, 1);
+	parser.addOption("-result", QVariant::String, 1, 1);
+	parser.addOption("-min", QVariant::Bool, 0, 0);
+	parser.addOption("-epd", QVariant::Bool, 0, 0);
+	parser.addOption("-plies", QVariant::StringList, 1, 2);
+	parser.addOption("-dedup", QVariant::Bool, 0, 0);
+	parser.addOption("-trusted", QVariant::Bool, 0, 0);
+	if (!parser.parse())
+		return 1;
+
+	const QStringList files = parser.takeOption("-pgntool").toStringList();
+	const QString& input = files.at(0);
+	const QString& output = files.at(1);
+
+	PgnGameFilter filter;
+	filter.setEvent(parser.takeOption("-event").toString());
+	filter.setSite(parser.takeOption("-site").toString());
+	filter.setOpponent(parser.takeOption("-opponent").toString());
+
+	const QStringList player = parser.takeOption("-player").toStringList();
+	if (!player.isEmpty())
+	{
+		Chess::Side side;
+		const QString color = player.value(1);
+		if (color == "white")
+			side = Chess::Side::White;
+		else if (color == "black")
+			side = Chess::Side::Black;
+		else if (!color.isEmpty())
+		{
+			qWarning("Invalid player color: %s", qPrintable(color));
+			return 1;
+		}
+		filter.setPlayer(player.at(0), side);
+	}
+
+	const QString result = parser.takeOption("-result").toString();
+	if (result == "1-0")
+		filter.setResult(PgnGameFilter::WhiteWins);
+	else if (result == "0-1")
+		filter.setResult(PgnGameFilter::BlackWins);
+	else if (result == "1/2-1/2")
+		filter.setResult(PgnGameFilter::Draw);
+	else if (result == "*")
+		filter.setResult(PgnGameFilter::Unfinished);
+	else if (result == "decisive")
+		filter.setResult(PgnGameFilter::EitherPlayerWins);
+	else if (result == "win")
+		filter.setResult(PgnGameFilter::FirstPlayerWins);
+	else if (result == "loss")
+		filter.setResult(PgnGameFilter::FirstPlayerLoses);
+	else if (!result.isEmpty())
+	{
+		qWarning("Invalid result: %s", qPrintable(result));
+		return 1;
+	}
+
+	PgnTool tool;
+	tool.setFilter(filter);
+	if (parser.takeOption("-min").toBool())
+		tool.setPgnMode(PgnGame::Minimal);
+	bool epd = parser.takeOption("-epd").toBool();
+
+	const QStringList plies = parser.takeOption("-plies").toStringList();
+	if (!plies.isEmpty())
+	{
+		bool ok = false;
+		const int minPly = plies.at(0).toInt(&ok);
+		int maxPly = minPly;
+		if (ok && plies.size() > 1)
+			maxPly = plies.at(1).toInt(&ok);
+		if (!ok || minPly < 0 || maxPly < minPly)
+		{
+			qWarning("Invalid ply range: %s", qPrintable(plies.join(' ')));
+			return 1;
+		}
+		tool.setPlyRange(minPly, maxPly);
+		epd = true;
+	}
+	if (epd)
+		tool.setOutputFormat(PgnTool::EpdOutput);
+	tool.setUniqueGames(parser.takeOption("-dedup").toBool());
+	tool.setTrustedMoves(parser.takeOption("-trusted").toBool());
+
+	// Compressed files must not go through text mode newline conversion
+	QIODevice::OpenMode inMode = QIODevice::ReadOnly;
+	if (!GzipDevice::isGzipFileName(input))
+		inMode |= QIODevice::Text;
+	QFile inFile(input);
+	if (!inFile.open(inMode))
+	{
+		qWarning("Could not open PGN file %s", qPrintable(input));
+		return 1;
+	}
+
+	const bool compress = GzipDevice::isGzipFileName(output);
+	QIODevice::OpenMode outMode = QIODevice::WriteOnly | QIODevice::Truncate;
+	if (!compress)
+		outMode |= QIODevice::Text;
+	QFile outFile(output);
+	GzipDevice gzip(&outFile);
+	if (!outFile.open(outMode)
+	||  (compress && !gzip.open(QIODevice::WriteOnly)))
+	{
+		qWarning("Could not open output file %s", qPrintable(output));
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	const bool ok = tool.run(&inFile,
+		compress ? static_cast<QIODevice*>(&gzip) : &outFile);
+	gzip.close();
+	outFile.close();
+	if (!ok)
+		return 1;
+
+	if (epd)
+		QTextStream(stdout) << "Wrote " << tool.outputCount()
+				    << " positions from " << tool.inputCount()
+				    << " games in " << timer.elapsed() << " ms"
+				    << endl;
+	else
+		QTextStream(stdout) << "Wrote " << tool.outputCount() << " of "
+				    << tool.inputCount() << " games in "
+				    << timer.elapsed() << " ms" << endl;
+	return 0;
+}
+
+int runVerify(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-verify", QVariant::String, 1, 1);
+	parser.addOption("-draw", QVariant::StringList);
+	parser.addOption("-resign", QVariant::StringList);
+	parser.addOption("-mate", QVariant::StringList);
+	parser.addOption("-maxmoves", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return 1;
+
+	const QString input = parser.takeOption("-verify").toString();
+	GameAdjudicator adjudicator;
+
+	// The adjudication options have the same syntax as in a match
+	const auto options = parser.options();
+	for (const MatchParser::Option& option : options)
+	{
+		bool ok = true;
+		if (option.name == "-draw")
+		{
+			QMap<QString, QString> params =
+				option.toMap("movenumber|movecount|score");
+			bool numOk = false;
+			bool countOk = false;
+			bool scoreOk = false;
+			int moveNumber = params["movenumber"].toInt(&numOk);
+			int moveCount = params["movecount"].toInt(&countOk);
+			int score = params["score"].toInt(&scoreOk);
+
+			ok = (numOk && countOk && scoreOk);
+			if (ok)
+				adjudicator.setDrawThreshold(moveNumber, moveCount, score);
+		}
+		else if (option.name == "-resign")
+		{
+			QMap<QString, QString> params = option.toMap("movecount|score");
+			bool countOk = false;
+			bool scoreOk = false;
+			int moveCount = params["movecount"].toInt(&countOk);
+			int score = params["score"].toInt(&scoreOk);
+
+			ok = (countOk && scoreOk);
+			if (ok)
+				adjudicator.setResignThreshold(moveCount, -score);
+		}
+		else if (option.name == "-mate")
+		{
+			QMap<QString, QString> params = option.toMap("movecount|distance");
+			bool countOk = false;
+			bool distanceOk = false;
+			int moveCount = params["movecount"].toInt(&countOk);
+			int distance = params["distance"].toInt(&distanceOk);
+
+			ok = (countOk && distanceOk && moveCount >= 0 && distance >= 0);
+			if (ok)
+				adjudicator.setMateThreshold(moveCount, distance);
+		}
+		else if (option.name == "-maxmoves")
+		{
+			ok = option.value.toInt() >= 0;
+			if (ok)
+				adjudicator.setMaximumGameLength(option.value.toInt());
+		}
+
+		if (!ok)
+		{
+			QString val;
+			if (option.value.type() == QVariant::StringList)
+				val = option.value.toStringList().join(" ");
+			else
+				val = option.value.toString();
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qPrintable(option.name), qPrintable(val));
+			return 1;
+		}
+	}
+
+	QIODevice::OpenMode inMode = QIODevice::ReadOnly;
+	if (!GzipDevice::isGzipFileName(input))
+		inMode |= QIODevice::Text;
+	QFile inFile(input);
+	if (!inFile.open(inMode))
+	{
+		qWarning("Could not open PGN file %s", qPrintable(input));
+		return 1;
+	}
+
+	QFile outFile;
+	if (!outFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text))
+		return 1;
+
+	PgnVerifier verifier;
+	verifier.setAdjudicator(adjudicator);
+
+	QElapsedTimer timer;
+	timer.start();
+	const bool ok = verifier.run(&inFile, &outFile);
+	outFile.close();
+	if (!ok)
+		return 1;
+
+	QTextStream(stdout) << "Verified " << verifier.gameCount()
+			    << " games in " << timer.elapsed() << " ms, "
+			    << verifier.mismatchCount() << " mismatches"
+			    << endl;
+	return verifier.mismatchCount() > 0 ? 2 : 0;
+}
+
+int runEpdTest(const QStringList& args, CuteChessCoreApplication& app)
+{
+	MatchParser parser(args);
+	parser.addOption("-epdtest", QVariant::String, 1, 1);
+	parser.addOption("-engine", QVariant::StringList, 1);
+	parser.addOption("-variant", QVariant::String, 1, 1);
+	parser.addOption("-concurrency", QVariant::String, 1, 1);
+	if (!parser.parse())
+		return 1;
+
+	QString variant = parser.takeOption("-variant").toString();
+	if (variant.isEmpty())
+		variant = "standard";
+	if (!Chess::BoardFactory::variants().contains(variant))
+	{
+		qWarning("Unknown chess variant: %s", qPrintable(variant));
+		return 1;
+	}
+
+	EngineData engine;
+	engine.bookDepth = 0;
+	engine.concurrency = 0;
+	if (!parseEngine(parser.takeOption("-engine").toStringList(), engine))
+		return 1;
+	if (engine.config.command().isEmpty()
+	&&  engine.config.remoteAddress().isEmpty())
+	{
+		qCritical("missing chess engine command");
+		return 1;
+	}
+	if (engine.config.protocol().isEmpty())
+	{
+		qWarning("Missing chess protocol");
+		return 1;
+	}
+
+	// Each position needs a fixed search budget, and a node or
+	// depth limit alone doesn't need a clock
+	TimeControl& tc = engine.tc;
+	if (tc.timePerMove() == 0 && tc.timePerTc() == 0
+	&&  (tc.nodeLimit() > 0 || tc.plyLimit() > 0))
+		tc.setInfinity(true);
+	if (!tc.isValid()
+	||  (tc.timePerMove() == 0 && tc.nodeLimit() == 0
+	     && tc.plyLimit() == 0))
+	{
+		qWarning("The EPD test needs an 'st', 'nodes' or 'depth' limit");
+		return 1;
+	}
+
+	GameManager* manager = app.gameManager();
+	const QString concurrency = parser.takeOption("-concurrency").toString();
+	if (!concurrency.isEmpty() && !parseConcurrency(concurrency, manager))
+	{
+		qWarning("Invalid concurrency: %s", qPrintable(concurrency));
+		return 1;
+	}
+
+	EpdTest test(manager, variant);
+	test.setEngine(engine.config, engine.tc);
+	const QString fileName = parser.takeOption("-epdtest").toString();
+	if (!test.open(fileName))
+	{
+		qWarning("Could not open EPD file %s", qPrintable(fileName));
+		return 1;
+	}
+
+	QObject::connect(&test, SIGNAL(finished()), &app, SLOT(quit()));
+	QMetaObject::invokeMethod(&test, "start", Qt::QueuedConnection);
+	return app.exec();
+}
+
 } // anonymous namespace
 
+// Splits a job line into arguments at whitespace. Double quotes
+// group words into one argument and are removed.
+QStringList splitJobLine(const QString& line)
+{
+	QStringList args;
+	QString arg;
+	bool quoted = false;
+	bool hasArg = false;
+
+	for (const QChar c : line)
+	{
+		if (c == '"')
+		{
+			quoted = !quoted;
+			hasArg = true;
+		}
+		else if (c.isSpace() && !quoted)
+		{
+			if (hasArg)
+				args << arg;
+			arg.clear();
+			hasArg = false;
+		}
+		else
+		{
+			arg += c;
+			hasArg = true;
+		}
+	}
+	if (hasArg)
+		args << arg;
+
+	return args;
+}
+
+int runJobs(const QStringList& args, CuteChessCoreApplication& app)
+{
+	MatchParser parser(args);
+	parser.addOption("-jobs", QVariant::String, 1, 1);
+	parser.addOption("-concurrency", QVariant::String, 1, 1);
+	if (!parser.parse())
+		return 1;
+
+	const QString fileName = parser.takeOption("-jobs").toString();
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning("Could not open job file %s", qPrintable(fileName));
+		return 1;
+	}
+
+	// Each line of the file holds the options of one match, and
+	// the matches take turns in the shared game slots
+	GameManager* manager = app.gameManager();
+	MatchGroup group(manager);
+	int concurrency = 1;
+	int lineNumber = 0;
+	QTextStream in(&file);
+	while (!in.atEnd())
+	{
+		const QString line = in.readLine().trimmed();
+		lineNumber++;
+		if (line.isEmpty() || line.startsWith('#'))
+			continue;
+
+		EngineMatch* match = parseMatch(splitJobLine(line), app);
+		if (match == nullptr)
+		{
+			qWarning("Invalid job on line %d of %s",
+				 lineNumber, qPrintable(fileName));
+			return 1;
+		}
+		group.addMatch(match);
+		concurrency = qMax(concurrency, manager->concurrency());
+	}
+	if (group.matchCount() == 0)
+	{
+		qWarning("No jobs in %s", qPrintable(fileName));
+		return 1;
+	}
+
+	// The jobs' own -concurrency options don't limit the others
+	const QString globalConcurrency = parser.takeOption("-concurrency").toString();
+	if (globalConcurrency.isEmpty())
+		manager->setConcurrency(concurrency);
+	else if (!parseConcurrency(globalConcurrency, manager))
+	{
+		qWarning("Invalid concurrency: %s", qPrintable(globalConcurrency));
+		return 1;
+	}
+
+	s_matchGroup = &group;
+	QObject::connect(&group, SIGNAL(finished()), &app, SLOT(quit()));
+	group.start();
+	const int ret = app.exec();
+	s_matchGroup = nullptr;
+	return writeTrace(ret);
+}
+
+int runBuildBook(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-buildbook", QVariant::StringList, 2, 2);
+	parser.addOption("-plies", QVariant::Int, 1, 1);
+	parser.addOption("-mingames", QVariant::Int, 1, 1);
+	parser.addOption("-tempdir", QVariant::String, 1, 1);
+	parser.addOption("-memory", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return 1;
+
+	const QStringList files = parser.takeOption("-buildbook").toStringList();
+	const QString& input = files.at(0);
+	const QString& output = files.at(1);
+
+	BookBuilder builder;
+	const QVariant plies = parser.takeOption("-plies");
+	if (plies.isValid())
+	{
+		if (plies.toInt() <= 0)
+		{
+			qWarning("Invalid ply count: %s",
+				 qPrintable(plies.toString()));
+			return 1;
+		}
+		builder.setMaxPlies(plies.toInt());
+	}
+
+	const QVariant minGames = parser.takeOption("-mingames");
+	if (minGames.isValid())
+	{
+		if (minGames.toInt() <= 0)
+		{
+			qWarning("Invalid game count: %s",
+				 qPrintable(minGames.toString()));
+			return 1;
+		}
+		builder.setMinGames(minGames.toInt());
+	}
+
+	const QVariant memory = parser.takeOption("-memory");
+	if (memory.isValid())
+	{
+		if (memory.toInt() <= 0)
+		{
+			qWarning("Invalid memory limit: %s",
+				 qPrintable(memory.toString()));
+			return 1;
+		}
+		builder.setMemoryLimit(qint64(memory.toInt()) * 1024 * 1024);
+	}
+
+	const QString tempDir = parser.takeOption("-tempdir").toString();
+	if (!tempDir.isEmpty())
+		builder.setTempPath(tempDir);
+
+	// Compressed files must not go through text mode newline conversion
+	QIODevice::OpenMode inMode = QIODevice::ReadOnly;
+	if (!GzipDevice::isGzipFileName(input))
+		inMode |= QIODevice::Text;
+	QFile inFile(input);
+	if (!inFile.open(inMode))
+	{
+		qWarning("Could not open PGN file %s", qPrintable(input));
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	if (!builder.run(&inFile, output))
+		return 1;
+
+	QTextStream(stdout) << "Wrote " << builder.entryCount()
+			    << " book entries from " << builder.gameCount()
+			    << " games in " << timer.elapsed() << " ms" << endl;
+	return 0;
+}
+
+int runRatings(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-ratings", QVariant::String, 1, 1);
+	parser.addOption("-ingest", QVariant::StringList, 1);
+	parser.addOption("-list", QVariant::Bool, 0, 0);
+	if (!parser.parse())
+		return 1;
+
+	const QString fileName = parser.takeOption("-ratings").toString();
+	const QStringList journals = parser.takeOption("-ingest").toStringList();
+	const bool list = parser.takeOption("-list").toBool();
+
+	QElapsedTimer timer;
+	timer.start();
+	RatingsDatabase db;
+	if (!db.load(fileName))
+		return 1;
+
+	QTextStream out(stdout);
+	if (!journals.isEmpty())
+	{
+		int gameCount = 0;
+		for (const QString& journal : journals)
+		{
+			if (!QFile::exists(journal))
+			{
+				qWarning("Could not open journal %s",
+					 qPrintable(journal));
+				return 1;
+			}
+
+			QVariantList progress;
+			TournamentJournal(journal).replay(progress);
+			const QString source = QFileInfo(journal).absoluteFilePath();
+			for (int i = 0; i < progress.size(); i++)
+			{
+				const QVariantMap game = progress.at(i).toMap();
+				const Chess::Result result(game.value("result").toString());
+				if (db.addGame(source, i + 1,
+					       game.value("white").toString(),
+					       game.value("black").toString(),
+					       result))
+					gameCount++;
+			}
+		}
+
+		if (gameCount > 0)
+		{
+			if (!db.solve())
+				qWarning("The ratings did not converge");
+			if (!db.save(fileName))
+				return 1;
+		}
+		out << "Added " << gameCount << " games from "
+		    << journals.size() << " journals in "
+		    << timer.elapsed() << " ms" << endl;
+	}
+
+	if (!list && !journals.isEmpty())
+		return 0;
+
+	out << QString("%1 %2 %3 %4 %5 %6")
+		.arg("Rank", 4)
+		.arg("Name", -25)
+		.arg("Elo", 7)
+		.arg("Games", 7)
+		.arg("Score", 7)
+		.arg("Draws", 7) << endl;
+
+	const QVector<int> ranking = db.ranking();
+	for (int i = 0; i < ranking.size(); i++)
+	{
+		const RatingsDatabase::Player& player = db.player(ranking.at(i));
+		const double games = qMax(player.games, 1);
+		out << QString("%1 %2 %3 %4 %5% %6%")
+			.arg(i + 1, 4)
+			.arg(player.name, -25)
+			.arg(player.rating, 7, 'f', 0)
+			.arg(player.games, 7)
+			.arg(player.points * 50.0 / games, 6, 'f', 1)
+			.arg(player.draws * 100.0 / games, 6, 'f', 1) << endl;
+	}
+
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	// Register types for signal / slot connections
@@ -1047,12 +2559,28 @@ int main(int argc, char* argv[])
 		}
 		else if (arg == "--engines" || arg == "-engines")
 		{
-			const auto engines = app.engineManager()->engines();
-			for (const auto& engine : engines)
-				out << engine.name() << endl;
+			const auto manager = app.engineManager();
+			for (int i = 0; i < manager->engineCount(); i++)
+				out << manager->engineNameAt(i) << endl;
 
 			return 0;
 		}
+		else if (arg == "-perft")
+			return runPerft(arguments);
+		else if (arg == "-convert")
+			return runConvert(arguments);
+		else if (arg == "-pgntool")
+			return runPgnTool(arguments);
+		else if (arg == "-verify")
+			return runVerify(arguments);
+		else if (arg == "-epdtest")
+			return runEpdTest(arguments, app);
+		else if (arg == "-jobs")
+			return runJobs(arguments, app);
+		else if (arg == "-buildbook")
+			return runBuildBook(arguments);
+		else if (arg == "-ratings")
+			return runRatings(arguments);
 		else if (arg == "--help" || arg == "-help")
 		{
 			QFile file(":/help.txt");
@@ -1068,5 +2596,5 @@ int main(int argc, char* argv[])
 	QObject::connect(s_match, SIGNAL(finished()), &app, SLOT(quit()));
 
 	s_match->start();
-	return app.exec();
+	return writeTrace(app.exec());
 }
@@ -0,0 +1,83 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "matchgroup.h"
+#include <gamemanager.h>
+#include "enginematch.h"
+
+MatchGroup::MatchGroup(GameManager* manager, QObject* parent)
+	: QObject(parent),
+	  m_manager(manager)
+{
+	Q_ASSERT(manager != nullptr);
+}
+
+void MatchGroup::addMatch(EngineMatch* match)
+{
+	Q_ASSERT(match != nullptr);
+
+	match->setParent(this);
+	match->setSharedGameManager(true);
+	m_matches.append(match);
+}
+
+int MatchGroup::matchCount() const
+{
+	return m_matches.size();
+}
+
+void MatchGroup::start()
+{
+	if (m_matches.isEmpty())
+	{
+		onMatchFinished();
+		return;
+	}
+
+	const QList<EngineMatch*> matches(m_matches);
+	for (EngineMatch* match : matches)
+	{
+		connect(match, SIGNAL(finished()),
+			this, SLOT(onMatchFinished()));
+		match->start();
+	}
+}
+
+void MatchGroup::stop()
+{
+	const QList<EngineMatch*> matches(m_matches);
+	for (EngineMatch* match : matches)
+		match->stop();
+}
+
+void MatchGroup::onMatchFinished()
+{
+	// A finished match is no longer stopped with the others
+	EngineMatch* match = qobject_cast<EngineMatch*>(sender());
+	if (match != nullptr)
+	{
+		disconnect(match, SIGNAL(finished()),
+			   this, SLOT(onMatchFinished()));
+		m_matches.removeOne(match);
+	}
+	if (!m_matches.isEmpty())
+		return;
+
+	connect(m_manager, SIGNAL(finished()),
+		this, SIGNAL(finished()));
+	m_manager->finish();
+}
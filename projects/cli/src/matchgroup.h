@@ -0,0 +1,73 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATCHGROUP_H
+#define MATCHGROUP_H
+
+#include <QObject>
+#include <QList>
+class EngineMatch;
+class GameManager;
+
+
+/*!
+ * \brief A set of matches run concurrently by one game manager.
+ *
+ * The matches share the game slots of the manager, which hands out
+ * the free slots fairly between them. A match that ends releases its
+ * slots to the others, and the manager is finished only when every
+ * match has ended.
+ */
+class MatchGroup : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new group that plays its games with \a manager. */
+		MatchGroup(GameManager* manager, QObject* parent = nullptr);
+
+		/*!
+		 * Adds \a match to the group.
+		 * The group takes ownership of \a match.
+		 */
+		void addMatch(EngineMatch* match);
+		/*! Returns the number of matches that haven't ended. */
+		int matchCount() const;
+
+	public slots:
+		/*! Starts all matches. */
+		void start();
+		/*! Stops all matches that are still running. */
+		void stop();
+
+	signals:
+		/*!
+		 * This signal is emitted when all matches have ended and
+		 * the game manager has finished.
+		 */
+		void finished();
+
+	private slots:
+		void onMatchFinished();
+
+	private:
+		GameManager* m_manager;
+		// The matches that haven't ended
+		QList<EngineMatch*> m_matches;
+};
+
+#endif // MATCHGROUP_H
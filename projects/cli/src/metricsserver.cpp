@@ -0,0 +1,387 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metricsserver.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QStringList>
+#include <chessgame.h>
+#include <gamemanager.h>
+#include <tournament.h>
+#include <tournamentplayer.h>
+#include <sprt.h>
+#include <memorystats.h>
+
+namespace {
+
+// Longest accepted request header
+const int MaxRequestSize = 8192;
+
+QString escapeLabel(const QString& value)
+{
+	QString ret(value);
+	ret.replace('\\', "\\\\");
+	ret.replace('"', "\\\"");
+	ret.replace('\n', "\\n");
+	return ret;
+}
+
+void addHeader(QStringList& lines, const QString& name,
+	       const QString& type, const QString& help)
+{
+	lines << QString("# HELP %1 %2").arg(name, help)
+	      << QString("# TYPE %1 %2").arg(name, type);
+}
+
+// Adds the cumulative buckets of a MoveTimeStats histogram, with
+// the bucket limits divided by scale
+void addHistogram(QStringList& lines, const QString& name,
+		  const QString& label, int (*limit)(int),
+		  const QVector<int>& counts, double scale,
+		  double sum, int count)
+{
+	int total = 0;
+	for (int i = 0; i < counts.size(); i++)
+	{
+		total += counts.at(i);
+		const QString le = limit(i) > 0
+			? QString::number(limit(i) / scale)
+			: QString("+Inf");
+		lines << QString("%1_bucket{%2,le=\"%3\"} %4")
+			 .arg(name, label, le).arg(total);
+	}
+	lines << QString("%1_sum{%2} %3").arg(name, label).arg(sum)
+	      << QString("%1_count{%2} %3").arg(name, label).arg(count);
+}
+
+} // anonymous namespace
+
+MetricsServer::MetricsServer(Tournament* tournament, QObject* parent)
+	: QObject(parent),
+	  m_tournament(tournament),
+	  m_server(new QTcpServer(this)),
+	  m_gamesStarted(0),
+	  m_gamesFinished(0),
+	  m_durationSum(0.0),
+	  m_durationCount(0)
+{
+	Q_ASSERT(tournament != nullptr);
+
+	m_clock.start();
+	connect(m_tournament, SIGNAL(gameStarted(ChessGame*, int, int, int)),
+		this, SLOT(onGameStarted(ChessGame*, int)));
+	connect(m_tournament, SIGNAL(gameFinished(ChessGame*, int, int, int)),
+		this, SLOT(onGameFinished(ChessGame*, int, int, int)));
+	connect(m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+bool MetricsServer::listen(const QHostAddress& address, quint16 port)
+{
+	if (!m_server->listen(address, port))
+	{
+		qWarning("Cannot listen for metrics requests on port %d: %s",
+			 port, qPrintable(m_server->errorString()));
+		return false;
+	}
+
+	return true;
+}
+
+void MetricsServer::addEngineCount(QVector<int>& counts, int player)
+{
+	if (player < 0)
+		return;
+	if (counts.size() <= player)
+		counts.resize(m_tournament->playerCount());
+	counts[player]++;
+}
+
+void MetricsServer::onGameStarted(ChessGame* game, int number)
+{
+	Q_UNUSED(game);
+
+	m_gamesStarted++;
+	m_startTimes[number] = m_clock.elapsed();
+}
+
+void MetricsServer::onGameFinished(ChessGame* game, int number,
+				   int whiteIndex, int blackIndex)
+{
+	m_gamesFinished++;
+	auto it = m_startTimes.find(number);
+	if (it != m_startTimes.end())
+	{
+		m_durationSum += (m_clock.elapsed() - it.value()) / 1000.0;
+		m_durationCount++;
+		m_startTimes.erase(it);
+	}
+
+	const Chess::Result result(game->result());
+	const Chess::Side loser(result.loser());
+	int loserIndex = -1;
+	if (loser == Chess::Side::White)
+		loserIndex = whiteIndex;
+	else if (loser == Chess::Side::Black)
+		loserIndex = blackIndex;
+
+	switch (result.type())
+	{
+	case Chess::Result::Timeout:
+		addEngineCount(m_timeForfeits, loserIndex);
+		break;
+	case Chess::Result::Disconnection:
+	case Chess::Result::StalledConnection:
+		addEngineCount(m_crashes, loserIndex);
+		break;
+	default:
+		break;
+	}
+}
+
+QString MetricsServer::metrics() const
+{
+	QStringList lines;
+	const GameManager* manager = m_tournament->gameManager();
+
+	addHeader(lines, "cutechess_games_started_total", "counter",
+		  "Games started.");
+	lines << QString("cutechess_games_started_total %1").arg(m_gamesStarted);
+	addHeader(lines, "cutechess_games_finished_total", "counter",
+		  "Games finished.");
+	lines << QString("cutechess_games_finished_total %1").arg(m_gamesFinished);
+	addHeader(lines, "cutechess_games_active", "gauge",
+		  "Games being played.");
+	lines << QString("cutechess_games_active %1").arg(manager->activeGameCount());
+	addHeader(lines, "cutechess_games_queued", "gauge",
+		  "Games waiting for a game slot.");
+	lines << QString("cutechess_games_queued %1").arg(manager->queuedGameCount());
+	addHeader(lines, "cutechess_game_slots", "gauge",
+		  "Maximum number of concurrent games.");
+	lines << QString("cutechess_game_slots %1").arg(manager->concurrency());
+	addHeader(lines, "cutechess_game_duration_seconds", "summary",
+		  "Wall clock duration of the finished games.");
+	lines << QString("cutechess_game_duration_seconds_sum %1")
+		 .arg(m_durationSum, 0, 'f', 3)
+	      << QString("cutechess_game_duration_seconds_count %1")
+		 .arg(m_durationCount);
+
+	const int playerCount = m_tournament->playerCount();
+	QStringList results, forfeits, crashes, nps;
+	QStringList moveTimes, overheads, nearForfeits;
+	for (int i = 0; i < playerCount; i++)
+	{
+		const TournamentPlayer& player(m_tournament->playerAt(i));
+		const QString label = QString("engine=\"%1\"")
+				      .arg(escapeLabel(player.name()));
+
+		results << QString("cutechess_engine_games_total{%1,result=\"win\"} %2")
+			   .arg(label).arg(player.wins())
+			<< QString("cutechess_engine_games_total{%1,result=\"loss\"} %2")
+			   .arg(label).arg(player.losses())
+			<< QString("cutechess_engine_games_total{%1,result=\"draw\"} %2")
+			   .arg(label).arg(player.draws());
+		forfeits << QString("cutechess_engine_time_forfeits_total{%1} %2")
+			    .arg(label).arg(m_timeForfeits.value(i));
+		crashes << QString("cutechess_engine_crashes_total{%1} %2")
+			   .arg(label).arg(m_crashes.value(i));
+		nps << QString("cutechess_engine_nps{%1} %2")
+		       .arg(label).arg(player.nps());
+
+		const MoveTimeStats& stats = player.timeStats();
+		QVector<int> timeCounts, overheadCounts;
+		for (int j = 0; j < MoveTimeStats::BucketCount; j++)
+		{
+			timeCounts << stats.timeBucket(j);
+			overheadCounts << stats.overheadBucket(j);
+		}
+		addHistogram(moveTimes, "cutechess_engine_move_time_ratio", label,
+			     &MoveTimeStats::timeBucketLimit, timeCounts, 100.0,
+			     stats.timeFractionSum(), stats.moveCount());
+		addHistogram(overheads, "cutechess_engine_move_overhead_seconds",
+			     label, &MoveTimeStats::overheadBucketLimit,
+			     overheadCounts, 1000.0, stats.overheadSum() / 1000.0,
+			     stats.overheadCount());
+		nearForfeits << QString("cutechess_engine_near_forfeits_total{%1} %2")
+				.arg(label).arg(stats.nearForfeits());
+	}
+	addHeader(lines, "cutechess_engine_games_total", "counter",
+		  "Finished games of each engine by result.");
+	lines << results;
+	addHeader(lines, "cutechess_engine_time_forfeits_total", "counter",
+		  "Games lost on time by each engine.");
+	lines << forfeits;
+	addHeader(lines, "cutechess_engine_crashes_total", "counter",
+		  "Games lost by each engine by a crash or a stalled connection.");
+	lines << crashes;
+	addHeader(lines, "cutechess_engine_nps", "gauge",
+		  "Average search speed of each engine in nodes per second.");
+	lines << nps;
+	addHeader(lines, "cutechess_engine_move_time_ratio", "histogram",
+		  "Move times of each engine relative to its clock.");
+	lines << moveTimes;
+	addHeader(lines, "cutechess_engine_move_overhead_seconds", "histogram",
+		  "Measured move time minus the search time reported by "
+		  "each engine.");
+	lines << overheads;
+	addHeader(lines, "cutechess_engine_near_forfeits_total", "counter",
+		  QString("Moves that left each engine less than %1 ms.")
+		  .arg(MoveTimeStats::NearForfeitTime));
+	lines << nearForfeits;
+
+	int openings = 0, drawn = 0, decisive = 0;
+	for (const Tournament::OpeningStats& stats : m_tournament->openingStats())
+	{
+		if (stats.games == 0)
+			continue;
+		openings++;
+		if (stats.isAlwaysDrawn())
+			drawn++;
+		else if (stats.isAlwaysDecisive())
+			decisive++;
+	}
+	addHeader(lines, "cutechess_openings", "gauge",
+		  "Openings with finished games, and those of them whose "
+		  "games were all drawn or all decisive.");
+	lines << QString("cutechess_openings{state=\"played\"} %1").arg(openings)
+	      << QString("cutechess_openings{state=\"always_drawn\"} %1").arg(drawn)
+	      << QString("cutechess_openings{state=\"always_decisive\"} %1").arg(decisive);
+
+	QStringList memory, memoryPeaks;
+	for (int i = 0; i < MemoryStats::SubsystemCount; i++)
+	{
+		const auto subsystem = MemoryStats::Subsystem(i);
+		const QString label = QString("subsystem=\"%1\"")
+				      .arg(MemoryStats::name(subsystem));
+		memory << QString("cutechess_memory_bytes{%1} %2")
+			  .arg(label).arg(MemoryStats::current(subsystem));
+		memoryPeaks << QString("cutechess_memory_peak_bytes{%1} %2")
+			       .arg(label).arg(MemoryStats::peak(subsystem));
+	}
+	addHeader(lines, "cutechess_memory_bytes", "gauge",
+		  "Estimated memory held by each subsystem.");
+	lines << memory;
+	addHeader(lines, "cutechess_memory_peak_bytes", "gauge",
+		  "Most estimated memory held by each subsystem at once.");
+	lines << memoryPeaks;
+	const qint64 peakRss = MemoryStats::processPeakMemory();
+	if (peakRss >= 0)
+	{
+		addHeader(lines, "cutechess_process_peak_resident_bytes", "gauge",
+			  "Peak resident set size of the cutechess-cli process.");
+		lines << QString("cutechess_process_peak_resident_bytes %1")
+			 .arg(peakRss * 1024);
+	}
+
+	// Named SPRT monitors are told apart by a label
+	QStringList sprtLlr, sprtLower, sprtUpper;
+	for (int i = 0; i < m_tournament->sprtCount(); i++)
+	{
+		const Sprt* sprt = m_tournament->sprtAt(i);
+		if (sprt->isNull())
+			continue;
+
+		const QString name = m_tournament->sprtName(i);
+		const QString label = name.isEmpty() ? QString()
+			: QString("{monitor=\"%1\"}").arg(escapeLabel(name));
+		const Sprt::Status status = sprt->status();
+		sprtLlr << QString("cutechess_sprt_llr%1 %2")
+			   .arg(label).arg(status.llr);
+		sprtLower << QString("cutechess_sprt_lower_bound%1 %2")
+			     .arg(label).arg(status.lBound);
+		sprtUpper << QString("cutechess_sprt_upper_bound%1 %2")
+			     .arg(label).arg(status.uBound);
+	}
+	if (!sprtLlr.isEmpty())
+	{
+		addHeader(lines, "cutechess_sprt_llr", "gauge",
+			  "Log-likelihood ratio of the SPRT.");
+		lines << sprtLlr;
+		addHeader(lines, "cutechess_sprt_lower_bound", "gauge",
+			  "Lower bound of the SPRT log-likelihood ratio.");
+		lines << sprtLower;
+		addHeader(lines, "cutechess_sprt_upper_bound", "gauge",
+			  "Upper bound of the SPRT log-likelihood ratio.");
+		lines << sprtUpper;
+	}
+
+	return lines.join('\n') + '\n';
+}
+
+void MetricsServer::onNewConnection()
+{
+	while (m_server->hasPendingConnections())
+	{
+		QTcpSocket* socket = m_server->nextPendingConnection();
+		connect(socket, SIGNAL(readyRead()),
+			this, SLOT(onReadyRead()));
+		connect(socket, SIGNAL(disconnected()),
+			socket, SLOT(deleteLater()));
+	}
+}
+
+void MetricsServer::onReadyRead()
+{
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+	if (socket == nullptr)
+		return;
+
+	// Read the request line and headers up to the empty line
+	QByteArray request = socket->property("request").toByteArray();
+	bool complete = false;
+	while (socket->canReadLine())
+	{
+		const QByteArray line = socket->readLine();
+		if (line.trimmed().isEmpty())
+		{
+			complete = true;
+			break;
+		}
+		if (request.isEmpty())
+			request = line.trimmed();
+	}
+	socket->setProperty("request", request);
+
+	if (!complete && socket->bytesAvailable() < MaxRequestSize)
+		return;
+	disconnect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+	const QList<QByteArray> words = request.split(' ');
+	QByteArray status("200 OK");
+	QByteArray body;
+	if (words.size() < 2 || words.at(0) != "GET")
+	{
+		status = "405 Method Not Allowed";
+		body = "Only GET requests are supported\n";
+	}
+	else if (words.at(1) != "/metrics")
+	{
+		status = "404 Not Found";
+		body = "Not found\n";
+	}
+	else
+		body = metrics().toUtf8();
+
+	QByteArray response("HTTP/1.1 " + status + "\r\n");
+	response += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+	response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+	response += "Connection: close\r\n\r\n";
+	response += body;
+
+	socket->write(response);
+	socket->disconnectFromHost();
+}
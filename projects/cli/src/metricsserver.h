@@ -0,0 +1,84 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QHostAddress>
+class ChessGame;
+class Tournament;
+class QTcpServer;
+
+
+/*!
+ * \brief An HTTP endpoint with the live metrics of a tournament.
+ *
+ * MetricsServer answers "GET /metrics" requests with the state of a
+ * running tournament in the Prometheus text format: the started and
+ * finished games, the game slots in use and the games waiting for a
+ * slot, the game durations, each engine's results, time forfeits,
+ * crashes, search speed and time usage, and the SPRT status.
+ *
+ * The counters are only updated when games start and finish, and the
+ * rest is read from the tournament when the metrics are requested.
+ */
+class MetricsServer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new server for the metrics of \a tournament. */
+		MetricsServer(Tournament* tournament, QObject* parent = nullptr);
+
+		/*!
+		 * Starts listening for connections on \a port of
+		 * \a address.
+		 *
+		 * Returns false and prints a warning on failure.
+		 */
+		bool listen(const QHostAddress& address, quint16 port);
+		/*! Returns the metrics in the Prometheus text format. */
+		QString metrics() const;
+
+	private slots:
+		void onGameStarted(ChessGame* game, int number);
+		void onGameFinished(ChessGame* game, int number,
+				    int whiteIndex, int blackIndex);
+		void onNewConnection();
+		void onReadyRead();
+
+	private:
+		void addEngineCount(QVector<int>& counts, int player);
+
+		Tournament* m_tournament;
+		QTcpServer* m_server;
+		QElapsedTimer m_clock;
+		int m_gamesStarted;
+		int m_gamesFinished;
+		// Start times of the running games by game number
+		QHash<int, qint64> m_startTimes;
+		double m_durationSum;
+		int m_durationCount;
+		QVector<int> m_timeForfeits;
+		QVector<int> m_crashes;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,78 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnblockreader.h"
+#include <QIODevice>
+
+PgnBlockReader::PgnBlockReader(QIODevice* input)
+	: m_input(input),
+	  m_device(input),
+	  m_gzip(input),
+	  m_lineNumber(1),
+	  m_atEnd(false)
+{
+	Q_ASSERT(input != nullptr && input->isOpen());
+}
+
+int PgnBlockReader::blockSize()
+{
+	return 4 * 1024 * 1024;
+}
+
+bool PgnBlockReader::open()
+{
+	if (GzipDevice::isGzip(m_input))
+	{
+		if (!m_gzip.open(QIODevice::ReadOnly))
+			return false;
+		m_device = &m_gzip;
+	}
+
+	return true;
+}
+
+bool PgnBlockReader::readBlock(QByteArray* block, qint64* lineNumber)
+{
+	Q_ASSERT(block != nullptr);
+	Q_ASSERT(lineNumber != nullptr);
+
+	while (!m_atEnd)
+	{
+		const QByteArray data(m_device->read(blockSize()));
+		m_atEnd = data.isEmpty();
+		m_buffer += data;
+
+		// The last game in the buffer may continue in the next read
+		int size = m_buffer.size();
+		if (!m_atEnd)
+		{
+			size = m_buffer.lastIndexOf("\n[Event ") + 1;
+			if (size <= 0)
+				continue;
+		}
+		if (size == 0)
+			break;
+
+		*block = m_buffer.left(size);
+		m_buffer.remove(0, size);
+		*lineNumber = m_lineNumber;
+		m_lineNumber += block->count('\n');
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,86 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNBLOCKREADER_H
+#define PGNBLOCKREADER_H
+
+#include <functional>
+#include <QByteArray>
+#include <QRunnable>
+#include <gzipdevice.h>
+class QIODevice;
+
+/*!
+ * \brief A reader that splits a PGN stream into blocks of whole games.
+ *
+ * The blocks can be parsed independently of each other, eg. on
+ * multiple threads. Each block starts at the beginning of a game and
+ * is roughly blockSize() bytes long unless a single game is longer.
+ * Gzip-compressed input is decompressed transparently.
+ */
+class PgnBlockReader
+{
+	public:
+		/*! Creates a new reader for \a input, which must be open. */
+		explicit PgnBlockReader(QIODevice* input);
+
+		/*! Returns the approximate size of the blocks in bytes. */
+		static int blockSize();
+
+		/*!
+		 * Prepares the input for reading.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open();
+		/*!
+		 * Reads the next block to \a block and sets \a lineNumber to
+		 * the line number where it starts.
+		 *
+		 * Returns false if the end of the input was reached.
+		 */
+		bool readBlock(QByteArray* block, qint64* lineNumber);
+
+	private:
+		QIODevice* m_input;
+		QIODevice* m_device;
+		GzipDevice m_gzip;
+		QByteArray m_buffer;
+		qint64 m_lineNumber;
+		bool m_atEnd;
+};
+
+/*! \brief A QRunnable that processes a block by calling a function. */
+class PgnBlockTask : public QRunnable
+{
+	public:
+		/*! Creates a new task that calls \a function. */
+		explicit PgnBlockTask(const std::function<void ()>& function)
+			: m_function(function)
+		{
+		}
+
+		// Inherited from QRunnable
+		void run() override
+		{
+			m_function();
+		}
+
+	private:
+		std::function<void ()> m_function;
+};
+
+#endif // PGNBLOCKREADER_H
@@ -0,0 +1,283 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgntool.h"
+#include "pgnblockreader.h"
+#include <climits>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <board/board.h>
+#include <pgngameentry.h>
+#include <pgnstream.h>
+#include <pgntagpool.h>
+
+namespace {
+
+quint64 mixHash(quint64 hash, quint64 value)
+{
+	return hash ^ (value + Q_UINT64_C(0x9e3779b97f4a7c15)
+		       + (hash << 6) + (hash >> 2));
+}
+
+// A hash of the game's starting position and move sequence
+quint64 gameHash(const PgnGame& game)
+{
+	quint64 hash = mixHash(qHash(game.variant()),
+			       qHash(game.startingFenString()));
+	const auto& moves = game.moves();
+	for (const auto& md : moves)
+		hash = mixHash(hash, md.key);
+	if (!moves.isEmpty())
+		hash = mixHash(hash, qHash(moves.last().moveString));
+
+	return mixHash(hash, quint64(moves.size()));
+}
+
+} // anonymous namespace
+
+PgnTool::PgnTool()
+	: m_format(PgnOutput),
+	  m_pgnMode(PgnGame::Verbose),
+	  m_unique(false),
+	  m_trustedMoves(false),
+	  m_minPly(-1),
+	  m_maxPly(-1),
+	  m_output(nullptr),
+	  m_nextBlock(0),
+	  m_outputCount(0),
+	  m_writeError(false)
+{
+}
+
+void PgnTool::setFilter(const PgnGameFilter& filter)
+{
+	m_filter = filter;
+}
+
+void PgnTool::setOutputFormat(OutputFormat format)
+{
+	m_format = format;
+}
+
+void PgnTool::setPgnMode(PgnGame::PgnMode mode)
+{
+	m_pgnMode = mode;
+}
+
+void PgnTool::setUniqueGames(bool enabled)
+{
+	m_unique = enabled;
+}
+
+void PgnTool::setPlyRange(int minPly, int maxPly)
+{
+	Q_ASSERT(minPly < 0 || maxPly >= minPly);
+
+	m_minPly = minPly;
+	m_maxPly = maxPly;
+}
+
+void PgnTool::setTrustedMoves(bool enabled)
+{
+	m_trustedMoves = enabled;
+}
+
+int PgnTool::inputCount() const
+{
+	return m_inputCount.load();
+}
+
+int PgnTool::outputCount() const
+{
+	return m_outputCount;
+}
+
+bool PgnTool::run(QIODevice* input, QIODevice* output)
+{
+	Q_ASSERT(input != nullptr && input->isOpen());
+	Q_ASSERT(output != nullptr && output->isOpen());
+
+	m_output = output;
+	m_pending.clear();
+	m_hashes.clear();
+	m_nextBlock = 0;
+	m_outputCount = 0;
+	m_writeError = false;
+	m_inputCount.store(0);
+
+	PgnBlockReader reader(input);
+	if (!reader.open())
+		return false;
+
+	// Each block in flight holds its input and output in memory
+	const int threadCount = QThread::idealThreadCount();
+	const int maxBlocks = 2 * threadCount;
+	m_freeBlocks.release(maxBlocks);
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount);
+
+	QByteArray block;
+	qint64 lineNumber = 1;
+	int index = 0;
+
+	while (reader.readBlock(&block, &lineNumber))
+	{
+		m_freeBlocks.acquire();
+		{
+			QMutexLocker locker(&m_mutex);
+			if (m_writeError)
+			{
+				m_freeBlocks.release();
+				break;
+			}
+		}
+
+		const qint64 blockLine = lineNumber;
+		const int blockIndex = index++;
+		pool.start(new PgnBlockTask([=]()
+		{
+			processBlock(block, blockLine, blockIndex);
+		}));
+	}
+
+	pool.waitForDone();
+	m_freeBlocks.acquire(maxBlocks);
+
+	return !m_writeError;
+}
+
+void PgnTool::processBlock(const QByteArray& block, qint64 lineNumber,
+			   int index)
+{
+	PgnStream in;
+	in.setTrustedMoves(m_trustedMoves);
+	in.setData(block.constData(), block.size());
+	in.seek(0, lineNumber);
+
+	QVector<Item> items;
+	PgnGame game;
+
+	forever
+	{
+		// The tags are enough for filtering, so the moves are only
+		// parsed for matching games
+		PgnTagPool pool;
+		PgnGameEntry entry(&pool);
+		if (!entry.read(in))
+			break;
+		m_inputCount.ref();
+
+		if (!entry.match(m_filter))
+			continue;
+		if (!in.seek(entry.pos(), entry.lineNumber()))
+			break;
+		if (!game.read(in, INT_MAX - 1, false))
+			continue;
+
+		if (!processGame(game, items))
+			qWarning("Could not convert the game at line %lld",
+				 entry.lineNumber());
+	}
+
+	commit(index, items);
+}
+
+bool PgnTool::processGame(const PgnGame& game, QVector<Item>& items) const
+{
+	Item item;
+	if (m_format == PgnOutput)
+	{
+		QTextStream out(&item.data);
+		if (!game.write(out, m_pgnMode))
+			return false;
+		out.flush();
+		item.hash = gameHash(game);
+		items.append(item);
+		return true;
+	}
+
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return false;
+
+	const auto& moves = game.moves();
+	int lastPly = moves.size();
+	if (m_minPly >= 0)
+		lastPly = qMin(lastPly, m_maxPly);
+
+	// Positions are only added if the whole game is valid
+	const int count = items.size();
+	for (int ply = 0; ply <= lastPly; ply++)
+	{
+		if (ply > 0)
+		{
+			const Chess::Move move(board->moveFromGenericMove(
+				moves.at(ply - 1).move));
+			if (move.isNull())
+			{
+				items.resize(count);
+				return false;
+			}
+			board->makeMove(move);
+		}
+
+		if (m_minPly >= 0 ? ply < m_minPly : ply < lastPly)
+			continue;
+
+		item.data = board->fenString().toLatin1() + '\n';
+		item.hash = board->key();
+		items.append(item);
+	}
+
+	return true;
+}
+
+void PgnTool::commit(int index, const QVector<Item>& items)
+{
+	QMutexLocker locker(&m_mutex);
+	m_pending.insert(index, items);
+
+	// Write the blocks in input order
+	while (!m_pending.isEmpty() && m_pending.firstKey() == m_nextBlock)
+	{
+		const QVector<Item> ready(m_pending.take(m_nextBlock++));
+		for (const Item& item : ready)
+		{
+			if (m_writeError)
+				break;
+			if (m_unique)
+			{
+				if (!m_hashes.insert(item.hash))
+					continue;
+			}
+
+			if (m_output->write(item.data) != item.data.size())
+			{
+				qWarning("Could not write the output");
+				m_writeError = true;
+			}
+			else
+				m_outputCount++;
+		}
+		m_freeBlocks.release();
+	}
+}
@@ -0,0 +1,143 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNTOOL_H
+#define PGNTOOL_H
+
+#include <QMap>
+#include <QVector>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <pgngame.h>
+#include <pgngamefilter.h>
+#include <keyset.h>
+class QIODevice;
+
+
+/*!
+ * \brief A filter and converter for large PGN files.
+ *
+ * PgnTool reads games from a PGN stream, keeps the ones that match a
+ * PgnGameFilter and writes them in PGN or EPD format. It works as a
+ * pipeline: the calling thread reads the input in blocks that end at
+ * a game boundary, a thread pool parses and filters the blocks, and
+ * the results are written in input order as soon as they're ready.
+ * The number of blocks in flight is limited, so memory use does not
+ * depend on the size of the input.
+ *
+ * Games are first read as PgnGameEntry objects, which only parses the
+ * tags. Only the games that pass the filter are parsed in full.
+ *
+ * In EPD mode PgnTool can also extract the positions within a range
+ * of plies from each game, eg. for building opening suites. Duplicate
+ * games or positions are detected by their 64-bit hash keys, which
+ * are stored in a KeySet.
+ */
+class PgnTool
+{
+	public:
+		/*! The output format. */
+		enum OutputFormat
+		{
+			PgnOutput,	//!< PGN games
+			EpdOutput	//!< Positions from each game
+		};
+
+		/*! Creates a new tool that copies all games as PGN. */
+		PgnTool();
+
+		/*! Sets the filter for the input games to \a filter. */
+		void setFilter(const PgnGameFilter& filter);
+		/*! Sets the output format to \a format. */
+		void setOutputFormat(OutputFormat format);
+		/*! Sets the PGN output mode to \a mode. */
+		void setPgnMode(PgnGame::PgnMode mode);
+		/*!
+		 * If \a enabled is true, games that repeat the moves of an
+		 * earlier game are skipped. In EPD mode games are compared
+		 * by their final positions.
+		 */
+		void setUniqueGames(bool enabled);
+		/*!
+		 * Sets the range of plies from which positions are written
+		 * in EPD mode to \a minPly...\a maxPly. Ply 0 is the
+		 * starting position. Games that end before \a minPly are
+		 * skipped.
+		 *
+		 * By default only the final position of each game is
+		 * written. Setting \a minPly to -1 restores the default.
+		 */
+		void setPlyRange(int minPly, int maxPly);
+		/*!
+		 * If \a enabled is true, the moves of the input games are
+		 * known to be legal, eg. because Cute Chess wrote them, and
+		 * they are read without most legality tests.
+		 *
+		 * \sa PgnStream::setTrustedMoves()
+		 */
+		void setTrustedMoves(bool enabled);
+
+		/*!
+		 * Reads the games from \a input and writes the results to
+		 * \a output. Both devices must be open.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool run(QIODevice* input, QIODevice* output);
+
+		/*! Returns the number of games that were read. */
+		int inputCount() const;
+		/*!
+		 * Returns the number of games that were written, or the
+		 * number of positions in EPD mode.
+		 */
+		int outputCount() const;
+
+	private:
+		struct Item
+		{
+			quint64 hash;
+			QByteArray data;
+		};
+
+		void processBlock(const QByteArray& block, qint64 lineNumber,
+				  int index);
+		bool processGame(const PgnGame& game,
+				 QVector<Item>& items) const;
+		void commit(int index, const QVector<Item>& items);
+
+		PgnGameFilter m_filter;
+		OutputFormat m_format;
+		PgnGame::PgnMode m_pgnMode;
+		bool m_unique;
+		bool m_trustedMoves;
+		int m_minPly;
+		int m_maxPly;
+
+		QIODevice* m_output;
+		QSemaphore m_freeBlocks;
+		QMutex m_mutex;
+		QMap<int, QVector<Item> > m_pending;
+		KeySet m_hashes;
+		int m_nextBlock;
+		int m_outputCount;
+		bool m_writeError;
+		QAtomicInt m_inputCount;
+};
+
+#endif // PGNTOOL_H
@@ -0,0 +1,308 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnverifier.h"
+#include "pgnblockreader.h"
+#include <climits>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <board/board.h>
+#include <moveevaluation.h>
+#include <pgngameentry.h>
+#include <pgnstream.h>
+#include <pgntagpool.h>
+
+namespace {
+
+// Parses a score like "0.25", "-1.50" or "M7" (mate in 7 plies)
+bool parseScore(const QString& str, int* score)
+{
+	QString s(str);
+	int sign = 1;
+	if (s.startsWith('-') || s.startsWith('+'))
+	{
+		if (s.at(0) == '-')
+			sign = -1;
+		s.remove(0, 1);
+	}
+
+	bool ok = false;
+	if (s.startsWith('M'))
+	{
+		// The inverse of the mate score formatting in PgnGame
+		const int plies = s.mid(1).toInt(&ok);
+		*score = sign * (100000 - plies);
+	}
+	else
+		*score = sign * qRound(s.toDouble(&ok) * 100.0);
+
+	return ok;
+}
+
+} // anonymous namespace
+
+PgnVerifier::PgnVerifier()
+	: m_output(nullptr),
+	  m_nextBlock(0),
+	  m_writeError(false)
+{
+}
+
+void PgnVerifier::setAdjudicator(const GameAdjudicator& adjudicator)
+{
+	m_adjudicator = adjudicator;
+}
+
+int PgnVerifier::gameCount() const
+{
+	return m_gameCount.load();
+}
+
+int PgnVerifier::mismatchCount() const
+{
+	return m_mismatchCount.load();
+}
+
+bool PgnVerifier::parseEval(const QString& comment,
+			    Chess::Side side,
+			    MoveEvaluation* eval)
+{
+	Q_ASSERT(eval != nullptr);
+
+	// Verbose comments: "d=12, pd=e5, mt=..., wv=0.25, ..."
+	if (comment.startsWith("d="))
+	{
+		bool depthOk = false;
+		bool scoreOk = false;
+		int depth = 0;
+		int score = 0;
+
+		const QStringList fields = comment.split(", ");
+		for (const QString& field : fields)
+		{
+			if (field.startsWith("d="))
+				depth = field.mid(2).toInt(&depthOk);
+			else if (field.startsWith("wv="))
+			{
+				QString value = field.mid(3);
+				if (value.endsWith(','))
+					value.chop(1);
+				scoreOk = parseScore(value, &score);
+			}
+		}
+		if (!depthOk || !scoreOk)
+			return false;
+
+		eval->setDepth(depth);
+		eval->setScore(side == Chess::Side::White ? score : -score);
+		return true;
+	}
+
+	// Short comments: "+0.25/12 0.5s"
+	const int slash = comment.indexOf('/');
+	if (slash <= 0)
+		return false;
+
+	int score = 0;
+	bool ok = false;
+	const int depth = comment.mid(slash + 1).section(' ', 0, 0).toInt(&ok);
+	if (!ok || !parseScore(comment.left(slash), &score))
+		return false;
+
+	eval->setDepth(depth);
+	eval->setScore(score);
+	return true;
+}
+
+bool PgnVerifier::run(QIODevice* input, QIODevice* output)
+{
+	Q_ASSERT(input != nullptr && input->isOpen());
+	Q_ASSERT(output != nullptr && output->isOpen());
+
+	m_output = output;
+	m_pending.clear();
+	m_nextBlock = 0;
+	m_writeError = false;
+	m_gameCount.store(0);
+	m_mismatchCount.store(0);
+
+	PgnBlockReader reader(input);
+	if (!reader.open())
+		return false;
+
+	const int threadCount = QThread::idealThreadCount();
+	const int maxBlocks = 2 * threadCount;
+	m_freeBlocks.release(maxBlocks);
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount);
+
+	QByteArray block;
+	qint64 lineNumber = 1;
+	int index = 0;
+
+	while (reader.readBlock(&block, &lineNumber))
+	{
+		m_freeBlocks.acquire();
+		{
+			QMutexLocker locker(&m_mutex);
+			if (m_writeError)
+			{
+				m_freeBlocks.release();
+				break;
+			}
+		}
+
+		const qint64 blockLine = lineNumber;
+		const int blockIndex = index++;
+		pool.start(new PgnBlockTask([=]()
+		{
+			processBlock(block, blockLine, blockIndex);
+		}));
+	}
+
+	pool.waitForDone();
+	m_freeBlocks.acquire(maxBlocks);
+
+	return !m_writeError;
+}
+
+void PgnVerifier::processBlock(const QByteArray& block, qint64 lineNumber,
+			       int index)
+{
+	PgnStream in;
+	in.setData(block.constData(), block.size());
+	in.seek(0, lineNumber);
+
+	QStringList lines;
+	PgnGame game;
+
+	forever
+	{
+		// The entry gives the line number where the game starts
+		PgnTagPool pool;
+		PgnGameEntry entry(&pool);
+		if (!entry.read(in))
+			break;
+		m_gameCount.ref();
+
+		QString error;
+		if (!in.seek(entry.pos(), entry.lineNumber()))
+			break;
+		if (!game.read(in, INT_MAX - 1, false))
+			error = "the game could not be read";
+		else
+			error = verifyGame(game);
+
+		if (error.isEmpty())
+			continue;
+
+		m_mismatchCount.ref();
+		lines.append(QString("Line %1: %2 - %3: %4\n")
+			     .arg(entry.lineNumber())
+			     .arg(game.playerName(Chess::Side::White))
+			     .arg(game.playerName(Chess::Side::Black))
+			     .arg(error));
+	}
+
+	commit(index, lines);
+}
+
+QString PgnVerifier::verifyGame(const PgnGame& game) const
+{
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return "invalid starting position";
+
+	GameAdjudicator adjudicator(m_adjudicator);
+	const auto& moves = game.moves();
+	Chess::Result expected;
+
+	for (int i = 0; i < moves.size(); i++)
+	{
+		const PgnGame::MoveData& md = moves.at(i);
+		const Chess::Side side = board->sideToMove();
+		const Chess::Move move(board->moveFromGenericMove(md.move));
+		if (move.isNull() || !board->isLegalMove(move))
+			return QString("illegal move %1 at ply %2")
+				.arg(md.moveString).arg(i + 1);
+
+		// Check the rules in the same order as ChessGame does
+		board->makeMove(move);
+		expected = board->result();
+		if (expected.isNone())
+		{
+			MoveEvaluation eval;
+			parseEval(md.comment, side, &eval);
+			adjudicator.addEval(board.data(), eval);
+			expected = adjudicator.result();
+		}
+
+		if (!expected.isNone() && i < moves.size() - 1)
+			return QString("the game continues after \"%1\" at ply %2")
+				.arg(expected.description()).arg(i + 1);
+	}
+
+	const QString result = game.tagValue("Result");
+	const bool adjudicated =
+		(game.tagValue("Termination") == "adjudication");
+
+	// Resignations, time forfeits, etc. can't be verified
+	if (expected.isNone())
+	{
+		if (adjudicated)
+			return "the adjudication could not be reproduced";
+		return QString();
+	}
+
+	if (adjudicated != (expected.type() == Chess::Result::Adjudication)
+	||  result != expected.toShortString())
+		return QString("the result %1 should be %2 (%3)")
+			.arg(result)
+			.arg(expected.toShortString())
+			.arg(expected.description());
+
+	return QString();
+}
+
+void PgnVerifier::commit(int index, const QStringList& lines)
+{
+	QMutexLocker locker(&m_mutex);
+	m_pending.insert(index, lines);
+
+	// Report the mismatches in input order
+	while (!m_pending.isEmpty() && m_pending.firstKey() == m_nextBlock)
+	{
+		const QStringList ready(m_pending.take(m_nextBlock++));
+		for (const QString& line : ready)
+		{
+			if (m_writeError)
+				break;
+
+			const QByteArray data(line.toUtf8());
+			if (m_output->write(data) != data.size())
+			{
+				qWarning("Could not write the output");
+				m_writeError = true;
+			}
+		}
+		m_freeBlocks.release();
+	}
+}
@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNVERIFIER_H
+#define PGNVERIFIER_H
+
+#include <QMap>
+#include <QStringList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <pgngame.h>
+#include <gameadjudicator.h>
+class QIODevice;
+class MoveEvaluation;
+
+
+/*!
+ * \brief A verifier for archived PGN games.
+ *
+ * PgnVerifier replays the games of a PGN stream and checks that they
+ * were played and terminated correctly: every move must be legal, a
+ * game must end when the rules of its variant end it, and its result
+ * must match the final position. The evaluations recorded in the move
+ * comments are fed to a GameAdjudicator, so adjudicated games must be
+ * adjudicated on the same move with the same result, and games that
+ * should have been adjudicated are reported as well.
+ *
+ * Like PgnTool the verifier reads the input in blocks of whole games,
+ * which are checked on a thread pool. Mismatches are reported in input
+ * order.
+ */
+class PgnVerifier
+{
+	public:
+		/*! Creates a new verifier that adjudicates nothing. */
+		PgnVerifier();
+
+		/*!
+		 * Sets the adjudication rules that were used in the
+		 * games to \a adjudicator.
+		 */
+		void setAdjudicator(const GameAdjudicator& adjudicator);
+
+		/*!
+		 * Verifies the games from \a input, which must be open, and
+		 * writes a line for each mismatch to \a output.
+		 *
+		 * Returns true if all games were read; otherwise returns
+		 * false.
+		 */
+		bool run(QIODevice* input, QIODevice* output);
+
+		/*! Returns the number of games that were verified. */
+		int gameCount() const;
+		/*! Returns the number of games with a mismatch. */
+		int mismatchCount() const;
+
+		/*!
+		 * Parses the evaluation of a move by \a side from the move
+		 * comment \a comment into \a eval.
+		 *
+		 * Returns false if the comment has no evaluation, eg. for
+		 * book moves.
+		 */
+		static bool parseEval(const QString& comment,
+				      Chess::Side side,
+				      MoveEvaluation* eval);
+
+	private:
+		void processBlock(const QByteArray& block, qint64 lineNumber,
+				  int index);
+		QString verifyGame(const PgnGame& game) const;
+		void commit(int index, const QStringList& lines);
+
+		GameAdjudicator m_adjudicator;
+		QIODevice* m_output;
+		QSemaphore m_freeBlocks;
+		QMutex m_mutex;
+		QMap<int, QStringList> m_pending;
+		int m_nextBlock;
+		bool m_writeError;
+		QAtomicInt m_gameCount;
+		QAtomicInt m_mismatchCount;
+};
+
+#endif // PGNVERIFIER_H
@@ -1,8 +1,26 @@
 DEPENDPATH += $$PWD
 HEADERS += $$PWD/enginematch.h \
     $$PWD/cutechesscoreapp.h \
-    $$PWD/matchparser.h
+    $$PWD/matchparser.h \
+    $$PWD/pgntool.h \
+    $$PWD/pgnverifier.h \
+    $$PWD/epdtest.h \
+    $$PWD/metricsserver.h \
+    $$PWD/broadcastserver.h \
+    $$PWD/pgnblockreader.h \
+    $$PWD/bookbuilder.h \
+    $$PWD/tournamentjournal.h \
+    $$PWD/matchgroup.h
 SOURCES += $$PWD/main.cpp \
     $$PWD/cutechesscoreapp.cpp \
     $$PWD/enginematch.cpp \
-    $$PWD/matchparser.cpp
+    $$PWD/matchparser.cpp \
+    $$PWD/pgntool.cpp \
+    $$PWD/pgnverifier.cpp \
+    $$PWD/epdtest.cpp \
+    $$PWD/metricsserver.cpp \
+    $$PWD/broadcastserver.cpp \
+    $$PWD/pgnblockreader.cpp \
+    $$PWD/bookbuilder.cpp \
+    $$PWD/tournamentjournal.cpp \
+    $$PWD/matchgroup.cpp
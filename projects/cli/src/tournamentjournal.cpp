@@ -0,0 +1,210 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tournamentjournal.h"
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QTextStream>
+#include <jsonserializer.h>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool syncFile(QFile& file)
+{
+	if (!file.flush())
+		return false;
+#ifdef Q_OS_WIN
+	return _commit(file.handle()) == 0;
+#else
+	return fsync(file.handle()) == 0;
+#endif
+}
+
+QString baseName(const QString& tournamentFile)
+{
+	QString base(tournamentFile);
+	if (base.endsWith(".json"))
+		base.chop(5);
+	return base;
+}
+
+QByteArray record(int index, const QVariantMap& game)
+{
+	QVariantMap map(game);
+	map.insert("index", index);
+	QByteArray line = QJsonDocument::fromVariant(map)
+			  .toJson(QJsonDocument::Compact);
+	line += '\n';
+	return line;
+}
+
+} // anonymous namespace
+
+TournamentJournal::TournamentJournal(const QString& fileName)
+	: m_fileName(fileName),
+	  m_file(fileName)
+{
+}
+
+QString TournamentJournal::progressFileName(const QString& tournamentFile)
+{
+	return baseName(tournamentFile) + "_progress.jsonl";
+}
+
+QString TournamentJournal::legacyFileName(const QString& tournamentFile)
+{
+	return baseName(tournamentFile) + "_journal.jsonl";
+}
+
+QString TournamentJournal::fileName() const
+{
+	return m_fileName;
+}
+
+bool TournamentJournal::append(int index, const QVariantMap& game)
+{
+	if (!m_file.isOpen()
+	&&  !m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		qWarning("cannot open tournament journal: %s",
+			 qPrintable(m_fileName));
+		return false;
+	}
+
+	const QByteArray line = record(index, game);
+	if (m_file.write(line) != line.size() || !syncFile(m_file))
+	{
+		qWarning("cannot write tournament journal: %s",
+			 qPrintable(m_fileName));
+		return false;
+	}
+
+	return true;
+}
+
+int TournamentJournal::replay(QVariantList& progress) const
+{
+	QFile input(m_fileName);
+	if (!input.open(QIODevice::ReadOnly))
+		return 0;
+
+	int count = 0;
+	while (!input.atEnd())
+	{
+		const QByteArray line = input.readLine();
+
+		// Only the last record can be incomplete
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+		if (error.error != QJsonParseError::NoError || !doc.isObject())
+		{
+			if (!input.atEnd())
+				qWarning("invalid record in tournament journal: %s",
+					 qPrintable(m_fileName));
+			continue;
+		}
+
+		const QVariantMap record = doc.toVariant().toMap();
+		const int index = record.value("index").toInt();
+		if (index <= 0)
+			continue;
+
+		setEntry(progress, index, record);
+		count++;
+	}
+
+	return count;
+}
+
+bool TournamentJournal::rewrite(const QVariantList& progress)
+{
+	m_file.close();
+
+	QSaveFile output(m_fileName);
+	if (!output.open(QIODevice::WriteOnly))
+	{
+		qWarning("cannot open tournament journal: %s",
+			 qPrintable(m_fileName));
+		return false;
+	}
+
+	for (int i = 0; i < progress.size(); i++)
+		output.write(record(i + 1, progress.at(i).toMap()));
+	if (!output.flush() || !output.commit())
+	{
+		qWarning("cannot write tournament journal: %s",
+			 qPrintable(m_fileName));
+		return false;
+	}
+
+	return true;
+}
+
+void TournamentJournal::remove()
+{
+	m_file.close();
+	if (QFile::exists(m_fileName) && !QFile::remove(m_fileName))
+		qWarning("cannot remove tournament journal: %s",
+			 qPrintable(m_fileName));
+}
+
+void TournamentJournal::setEntry(QVariantList& progress,
+				 int index,
+				 const QVariantMap& game)
+{
+	Q_ASSERT(index > 0);
+
+	while (progress.size() < index)
+	{
+		QVariantMap pMap;
+		pMap.insert("index", progress.size() + 1);
+		pMap.insert("result", "*");
+		pMap.insert("terminationDetails", "in progress");
+		progress.append(pMap);
+	}
+	progress.replace(index - 1, game);
+}
+
+bool TournamentJournal::writeSnapshot(const QString& fileName,
+				      const QVariantMap& data)
+{
+	QSaveFile output(fileName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open tournament configuration file: %s",
+			 qPrintable(fileName));
+		return false;
+	}
+
+	QTextStream out(&output);
+	JsonSerializer serializer(data);
+	serializer.serialize(out);
+	out.flush();
+	if (!output.commit())
+	{
+		qWarning("cannot write tournament configuration file: %s",
+			 qPrintable(fileName));
+		return false;
+	}
+
+	return true;
+}
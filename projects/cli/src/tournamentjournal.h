@@ -0,0 +1,103 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TOURNAMENTJOURNAL_H
+#define TOURNAMENTJOURNAL_H
+
+#include <QFile>
+#include <QString>
+#include <QVariant>
+
+/*!
+ * \brief An append-only store of a tournament's progress.
+ *
+ * The tournament file only holds the tournament's configuration, and
+ * refers to this store by the "matchProgressFile" key. Each game
+ * start and finish is appended to the store as one line of compact
+ * JSON and synced to disk, so recording a game doesn't depend on the
+ * number of games played. The store is read in one streaming pass
+ * when a tournament is resumed, and it's compacted to one record per
+ * game at the start and end of a run.
+ *
+ * A record torn by a crash is always the last one, and is ignored.
+ */
+class TournamentJournal
+{
+	public:
+		/*! Creates a progress store in the file \a fileName. */
+		TournamentJournal(const QString& fileName);
+
+		/*!
+		 * Returns the default progress file name of the
+		 * tournament file \a tournamentFile.
+		 */
+		static QString progressFileName(const QString& tournamentFile);
+		/*!
+		 * Returns the name of the journal that older versions
+		 * kept next to a tournament file with an inline
+		 * "matchProgress" list.
+		 */
+		static QString legacyFileName(const QString& tournamentFile);
+
+		/*! Returns the file name of the journal. */
+		QString fileName() const;
+
+		/*!
+		 * Appends the progress entry \a game of the game with
+		 * index \a index to the journal, and syncs it to disk.
+		 */
+		bool append(int index, const QVariantMap& game);
+		/*!
+		 * Applies the store's records to \a progress, the list
+		 * of progress entries in game order.
+		 *
+		 * Returns the number of records applied.
+		 */
+		int replay(QVariantList& progress) const;
+		/*!
+		 * Replaces the store's records with one record for each
+		 * entry in \a progress. The file is replaced atomically.
+		 */
+		bool rewrite(const QVariantList& progress);
+		/*! Removes the store's file. */
+		void remove();
+
+		/*!
+		 * Sets the entry of the game with index \a index in
+		 * \a progress to \a game.
+		 *
+		 * Games don't always start in order, so missing entries
+		 * before \a index are added as games in progress.
+		 */
+		static void setEntry(QVariantList& progress,
+				     int index,
+				     const QVariantMap& game);
+
+		/*!
+		 * Replaces the file \a fileName with \a data atomically:
+		 * the data is written to a temporary file which is then
+		 * renamed.
+		 */
+		static bool writeSnapshot(const QString& fileName,
+					  const QVariantMap& data);
+
+	private:
+		QString m_fileName;
+		QFile m_file;
+};
+
+#endif // TOURNAMENTJOURNAL_H
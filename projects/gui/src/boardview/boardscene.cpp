@@ -24,6 +24,9 @@
 #include <QGraphicsPolygonItem>
 #include <QGraphicsTextItem>
 #include <QSettings>
+#include <QCoreApplication>
+#include <QScopedPointer>
+#include <QtConcurrentRun>
 #include <algorithm>
 #include <board/board.h>
 #include "graphicsboard.h"
@@ -35,20 +38,53 @@ namespace {
 
 const qreal s_squareSize = 50;
 
+/*
+ * All scenes share one renderer, so the pieces of different boards
+ * also share their rasterized pixmaps.
+ */
+QSvgRenderer* sharedRenderer()
+{
+	static QSvgRenderer* renderer =
+		new QSvgRenderer(QString(":/default.svg"),
+				 QCoreApplication::instance());
+	return renderer;
+}
+
+/*
+ * Generates the legal moves of \a board, which is deleted afterwards.
+ * This runs in a worker thread, so it must not touch the scene.
+ */
+QList<Chess::GenericMove> legalGenericMoves(Chess::Board* board)
+{
+	QScopedPointer<Chess::Board> owner(board);
+	QList<Chess::GenericMove> ret;
+	if (!board->result().isNone())
+		return ret;
+
+	const auto moves = board->legalMoves();
+	for (const auto& move : moves)
+		ret << board->genericMove(move);
+	return ret;
+}
+
 } // anonymous namespace
 
 BoardScene::BoardScene(QObject* parent)
 	: QGraphicsScene(parent),
 	  m_board(nullptr),
+	  m_animated(true),
 	  m_direction(Forward),
 	  m_squares(nullptr),
 	  m_reserve(nullptr),
 	  m_chooser(nullptr),
 	  m_anim(nullptr),
-	  m_renderer(new QSvgRenderer(QString(":/default.svg"), this)),
+	  m_renderer(sharedRenderer()),
+	  m_movesPending(false),
 	  m_highlightPiece(nullptr),
 	  m_moveArrows(nullptr)
 {
+	connect(&m_movesWatcher, SIGNAL(finished()),
+		this, SLOT(onMovesReady()));
 }
 
 BoardScene::~BoardScene()
@@ -71,6 +107,9 @@ void BoardScene::setBoard(Chess::Board* board)
 	clear();
 	m_history.clear();
 	m_transition.clear();
+	m_targets.clear();
+	m_moves.clear();
+	m_movesPending = false;
 	m_squares = nullptr;
 	m_reserve = nullptr;
 	m_chooser = nullptr;
@@ -79,6 +118,18 @@ void BoardScene::setBoard(Chess::Board* board)
 	m_board = board;
 }
 
+bool BoardScene::isAnimated() const
+{
+	return m_animated;
+}
+
+void BoardScene::setAnimated(bool animated)
+{
+	m_animated = animated;
+	if (!animated)
+		stopAnimation();
+}
+
 void BoardScene::populate()
 {
 	Q_ASSERT(m_board != nullptr);
@@ -169,9 +220,38 @@ void BoardScene::undoMove()
 	m_moveArrows = nullptr;
 
 	m_board->undoMove();
+
+	// After setPosition() there are no transitions for the
+	// earlier moves, so the pieces are just synchronized
+	if (m_history.isEmpty())
+	{
+		syncPieces();
+		updateMoves();
+		return;
+	}
 	applyTransition(m_history.takeLast(), Backward);
 }
 
+void BoardScene::setPosition(const Chess::BoardSnapshot& snapshot)
+{
+	Q_ASSERT(m_board != nullptr);
+	Q_ASSERT(m_squares != nullptr);
+
+	stopAnimation();
+	delete m_moveArrows;
+	m_moveArrows = nullptr;
+
+	if (!m_board->restore(snapshot))
+	{
+		qWarning("BoardScene: cannot restore snapshot");
+		return;
+	}
+	m_history.clear();
+
+	syncPieces();
+	updateMoves();
+}
+
 void BoardScene::cancelUserMove()
 {
 	GraphicsPiece* piece = qgraphicsitem_cast<GraphicsPiece*>(mouseGrabberItem());
@@ -215,7 +295,7 @@ void BoardScene::flip()
 		m_moveArrows->setRotation(angle);
 	}
 
-	group->start(QAbstractAnimation::DeleteWhenStopped);
+	startAnimation(group);
 }
 
 void BoardScene::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
@@ -242,6 +322,7 @@ void BoardScene::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
 void BoardScene::mousePressEvent(QGraphicsSceneMouseEvent* event)
 {
 	stopAnimation();
+	waitForMoves();
 
 	if (m_chooser != nullptr)
 	{
@@ -281,14 +362,14 @@ void BoardScene::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
 
 void BoardScene::onTransitionFinished()
 {
-	const auto drops = m_transition.drops();
+	const auto& drops = m_transition.drops();
 	if (m_direction == Backward)
 	{
 		for (const auto& drop : drops)
 			m_reserve->addPiece(m_squares->takePieceAt(drop.target));
 	}
 
-	const auto moves = m_transition.moves();
+	const auto& moves = m_transition.moves();
 	for (const auto& move : moves)
 	{
 		if (m_direction == Forward)
@@ -304,7 +385,7 @@ void BoardScene::onTransitionFinished()
 					     m_reserve->takePiece(drop.piece));
 	}
 
-	const auto squares = m_transition.squares();
+	const auto& squares = m_transition.squares();
 	for (const auto& square : squares)
 	{
 		Chess::Piece type = m_board->pieceAt(square);
@@ -312,7 +393,7 @@ void BoardScene::onTransitionFinished()
 			m_squares->setSquare(square, createPiece(type));
 	}
 
-	const auto reserve = m_transition.reserve();
+	const auto& reserve = m_transition.reserve();
 	for (const auto& piece : reserve)
 	{
 		int count = m_reserve->pieceCount(piece);
@@ -546,11 +627,16 @@ void BoardScene::applyTransition(const Chess::BoardTransition& transition,
 	m_transition = transition;
 	m_direction = direction;
 
+	// The moves are generated again when the transition finishes
+	m_targets.clear();
+	m_moves.clear();
+	m_movesPending = false;
+
 	QParallelAnimationGroup* group = new QParallelAnimationGroup;
 	connect(group, SIGNAL(finished()), this, SLOT(onTransitionFinished()));
 	m_anim = group;
 
-	const auto drops = transition.drops();
+	const auto& drops = transition.drops();
 	if (direction == Backward)
 	{
 		for (const auto& drop : drops)
@@ -560,7 +646,7 @@ void BoardScene::applyTransition(const Chess::BoardTransition& transition,
 		}
 	}
 
-	const auto moves = transition.moves();
+	const auto& moves = transition.moves();
 	for (const auto& move : moves)
 	{
 		Chess::Square source = move.source;
@@ -593,21 +679,85 @@ void BoardScene::applyTransition(const Chess::BoardTransition& transition,
 		}
 	}
 
-	group->start(QAbstractAnimation::DeleteWhenStopped);
+	startAnimation(group);
+}
+
+void BoardScene::startAnimation(QAbstractAnimation* anim)
+{
+	m_anim = anim;
+	anim->start(QAbstractAnimation::DeleteWhenStopped);
+
+	// Without animation the pieces jump straight to their targets
+	if (!m_animated)
+		stopAnimation();
+}
+
+void BoardScene::syncPieces()
+{
+	for (int x = 0; x < m_board->width(); x++)
+	{
+		for (int y = 0; y < m_board->height(); y++)
+		{
+			Chess::Square sq(x, y);
+			Chess::Piece type(m_board->pieceAt(sq));
+			if (type != m_squares->pieceTypeAt(sq))
+				m_squares->setSquare(sq, createPiece(type));
+		}
+	}
+
+	if (m_reserve == nullptr)
+		return;
+
+	const auto types = m_board->reservePieceTypes();
+	for (const auto& piece : types)
+	{
+		int count = m_reserve->pieceCount(piece);
+		int newCount = m_board->reserveCount(piece);
+
+		while (newCount > count)
+		{
+			m_reserve->addPiece(createPiece(piece));
+			count++;
+		}
+		while (newCount < count)
+		{
+			delete m_reserve->takePiece(piece);
+			count--;
+		}
+	}
 }
 
 void BoardScene::updateMoves()
 {
 	m_targets.clear();
 	m_moves.clear();
-	if (!m_board->result().isNone())
+
+	// A newer future replaces the old one in the watcher, so the
+	// results of an outdated position are never delivered
+	m_movesPending = true;
+	m_movesWatcher.setFuture(QtConcurrent::run(legalGenericMoves,
+						   m_board->copy()));
+}
+
+void BoardScene::waitForMoves()
+{
+	if (!m_movesPending)
 		return;
 
-	const auto moves = m_board->legalMoves();
-	for (const auto& move : moves)
+	m_movesWatcher.waitForFinished();
+	onMovesReady();
+}
+
+void BoardScene::onMovesReady()
+{
+	if (!m_movesPending || m_squares == nullptr)
+		return;
+	m_movesPending = false;
+
+	m_moves = m_movesWatcher.result();
+	const auto moves = m_moves;
+	for (const auto& gmove : moves)
 	{
-		Chess::GenericMove gmove(m_board->genericMove(move));
-		m_moves << gmove;
 		GraphicsPiece* piece = nullptr;
 
 		if (gmove.sourceSquare().isValid())
@@ -21,6 +21,7 @@
 #include <QGraphicsScene>
 #include <QMultiMap>
 #include <QPointer>
+#include <QFutureWatcher>
 #include <board/square.h>
 #include <board/genericmove.h>
 #include <board/boardtransition.h>
@@ -28,6 +29,7 @@
 namespace Chess
 {
 	class Board;
+	class BoardSnapshot;
 	class Move;
 	class Side;
 	class Piece;
@@ -52,6 +54,10 @@ class PieceChooser;
  *
  * BoardScene is that class that connects to the players and game
  * objects to synchronize the graphical side with the internals.
+ *
+ * The legal moves of each new position are generated in a worker
+ * thread, on a copy of the board, so that slow move generation
+ * in complex variants doesn't block the user interface.
  */
 class BoardScene : public QGraphicsScene
 {
@@ -73,6 +79,15 @@ class BoardScene : public QGraphicsScene
 		 */
 		void setBoard(Chess::Board* board);
 
+		/*! Returns true if moves are animated; the default is true. */
+		bool isAnimated() const;
+		/*!
+		 * If \a animated is false, moves and flips are shown
+		 * without animation. This saves painting when many scenes
+		 * are shown at once.
+		 */
+		void setAnimated(bool animated);
+
 	public slots:
 		/*!
 		 * Clears the scene, creates a new board, and populates
@@ -89,8 +104,22 @@ class BoardScene : public QGraphicsScene
 		void makeMove(const Chess::Move& move);
 		/*! Makes the move \a move in the scene. */
 		void makeMove(const Chess::GenericMove& move);
-		/*! Reverses the last move that was made in the scene. */
+		/*!
+		 * Reverses the last move that was made in the scene.
+		 *
+		 * Moves that were made before the last call to
+		 * setPosition() are undone without animation.
+		 */
 		void undoMove();
+		/*!
+		 * Returns the internal board to the position in \a snapshot
+		 * and updates the pieces to match it without animation.
+		 *
+		 * Unlike makeMove() and undoMove() this only renders the
+		 * final position, so it's the fast way to jump to a
+		 * distant ply.
+		 */
+		void setPosition(const Chess::BoardSnapshot& snapshot);
 		/*! Flips the board, with animation. */
 		void flip();
 		/*!
@@ -118,6 +147,7 @@ class BoardScene : public QGraphicsScene
 	private slots:
 		void onTransitionFinished();
 		void onPromotionChosen(const Chess::Piece& promotion);
+		void onMovesReady();
 
 	private:
 		void cancelUserMove();
@@ -142,8 +172,12 @@ class BoardScene : public QGraphicsScene
 		void applyTransition(const Chess::BoardTransition& transition,
 				     MoveDirection direction);
 		void updateMoves();
+		void waitForMoves();
+		void syncPieces();
+		void startAnimation(QAbstractAnimation* anim);
 
 		Chess::Board* m_board;
+		bool m_animated;
 		MoveDirection m_direction;
 		Chess::BoardTransition m_transition;
 		QList<Chess::BoardTransition> m_history;
@@ -155,6 +189,8 @@ class BoardScene : public QGraphicsScene
 		QSvgRenderer* m_renderer;
 		QMultiMap<GraphicsPiece*, Chess::Square> m_targets;
 		QList<Chess::GenericMove> m_moves;
+		QFutureWatcher< QList<Chess::GenericMove> > m_movesWatcher;
+		bool m_movesPending;
 		Chess::GenericMove m_promotionMove;
 		GraphicsPiece* m_highlightPiece;
 		QGraphicsItemGroup* m_moveArrows;
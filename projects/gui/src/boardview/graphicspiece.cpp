@@ -16,7 +16,10 @@
 */
 
 #include "graphicspiece.h"
+#include <QPainter>
+#include <QPixmapCache>
 #include <QSvgRenderer>
+#include <QtMath>
 
 
 GraphicsPiece::GraphicsPiece(const Chess::Piece& piece,
@@ -69,7 +72,40 @@ void GraphicsPiece::paint(QPainter* painter,
 	}
 	bounds.moveCenter(m_rect.center());
 
-	m_renderer->render(painter, m_elementId, bounds);
+	// The SVG is rasterized once for each renderer, element and
+	// pixel size, and the pixmap is shared by all the pieces that
+	// look the same. A new theme means a new renderer, and pixmaps
+	// of the old one age out of the cache.
+	const QTransform transform(painter->deviceTransform());
+	const qreal scale = qSqrt(transform.m11() * transform.m11() +
+				  transform.m12() * transform.m12());
+	const QSize size((bounds.size() * scale).toSize());
+	if (size.isEmpty())
+		return;
+
+	const QString key(QString("cutechess/piece/%1/%2/%3x%4")
+		.arg(quintptr(m_renderer))
+		.arg(m_elementId)
+		.arg(size.width())
+		.arg(size.height()));
+
+	QPixmap pixmap;
+	if (!QPixmapCache::find(key, &pixmap))
+	{
+		pixmap = QPixmap(size);
+		pixmap.fill(Qt::transparent);
+
+		QPainter pixmapPainter(&pixmap);
+		pixmapPainter.setRenderHint(QPainter::Antialiasing);
+		m_renderer->render(&pixmapPainter, m_elementId,
+				   QRectF(QPointF(0, 0), QSizeF(size)));
+		pixmapPainter.end();
+
+		QPixmapCache::insert(key, pixmap);
+	}
+
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->drawPixmap(bounds, pixmap, QRectF(pixmap.rect()));
 }
 
 Chess::Piece GraphicsPiece::pieceType() const
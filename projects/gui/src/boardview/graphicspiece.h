@@ -28,7 +28,9 @@ class QSvgRenderer;
  * A GraphicsPiece object is a chess piece that can be easily
  * dragged and animated in a QGraphicsScene. Scalable Vector
  * Graphics (SVG) are used to ensure that the pieces look good
- * at any resolution, and a shared SVG renderer is used.
+ * at any resolution, and a shared SVG renderer is used. Each
+ * picture is rasterized once per pixel size into a QPixmapCache
+ * entry shared by all the pieces that look the same.
  *
  * For convenience reasons the boundingRect() of a piece should
  * be equal to that of a square on the chessboard.
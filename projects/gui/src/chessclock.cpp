@@ -16,15 +16,76 @@
 */
 
 #include "chessclock.h"
+#include <QBasicTimer>
 #include <QTimerEvent>
+#include <QSettings>
 #include <QLabel>
 #include <QVBoxLayout>
+#include <QVector>
 
+namespace {
+
+/*
+ * The display tick shared by all running clocks. A short interval
+ * keeps the clocks close to the true second; a clock is repainted
+ * only when its text changes.
+ */
+class ClockTicker : public QObject
+{
+	public:
+		static ClockTicker* instance()
+		{
+			static ClockTicker ticker;
+			return &ticker;
+		}
+
+		void add(ChessClock* clock)
+		{
+			if (m_clocks.contains(clock))
+				return;
+			m_clocks.append(clock);
+			if (!m_timer.isActive())
+				m_timer.start(m_interval, this);
+		}
+
+		void remove(ChessClock* clock)
+		{
+			m_clocks.removeOne(clock);
+			if (m_clocks.isEmpty())
+				m_timer.stop();
+		}
+
+	protected:
+		virtual void timerEvent(QTimerEvent* event)
+		{
+			if (event->timerId() != m_timer.timerId())
+				return;
+
+			for (ChessClock* clock : m_clocks)
+			{
+				if (clock->isVisible())
+					clock->tick();
+			}
+		}
+
+	private:
+		ClockTicker()
+			: m_interval(qBound(10, QSettings().value(
+				"ui/clock_update_interval", 100).toInt(), 1000))
+		{
+		}
+
+		int m_interval;
+		QBasicTimer m_timer;
+		QVector<ChessClock*> m_clocks;
+};
+
+} // anonymous namespace
 
 ChessClock::ChessClock(QWidget* parent)
 	: QWidget(parent),
 	  m_totalTime(0),
-	  m_timerId(-1),
+	  m_running(false),
 	  m_infiniteTime(false),
 	  m_nameLabel(new QLabel()),
 	  m_timeLabel(new QLabel())
@@ -44,6 +105,11 @@ ChessClock::ChessClock(QWidget* parent)
 	setLayout(layout);
 }
 
+ChessClock::~ChessClock()
+{
+	stopTimer();
+}
+
 void ChessClock::setPlayerName(const QString& name)
 {
 	if (name.isEmpty())
@@ -59,6 +125,7 @@ void ChessClock::setInfiniteTime(bool infinite)
 		return;
 
 	stopTimer();
+	m_timeText.clear();
 	m_timeLabel->setText(QString::fromUtf8("<h1>\xE2\x88\x9E</h1>"));
 }
 
@@ -79,7 +146,10 @@ void ChessClock::setTime(int totalTime)
 	if (totalTime <= -500)
 		str.append("-");
 	str.append(timeLeft.toString(format));
+	if (str == m_timeText)
+		return;
 
+	m_timeText = str;
 	m_timeLabel->setText(QString("<h1>%1</h1>").arg(str));
 }
 
@@ -96,7 +166,8 @@ void ChessClock::start(int totalTime)
 	{
 		m_time.start();
 		m_totalTime = totalTime;
-		m_timerId = startTimer(1000);
+		m_running = true;
+		ClockTicker::instance()->add(this);
 		setTime(totalTime);
 	}
 }
@@ -110,20 +181,23 @@ void ChessClock::stop()
 		setTime(m_totalTime - m_time.elapsed());
 }
 
-void ChessClock::timerEvent(QTimerEvent* event)
+void ChessClock::tick()
 {
-	if (!event)
-		return;
-	
-	if (event->timerId() == m_timerId)
+	if (m_running)
 		setTime(m_totalTime - m_time.elapsed());
 }
 
+void ChessClock::showEvent(QShowEvent* event)
+{
+	QWidget::showEvent(event);
+	tick();
+}
+
 void ChessClock::stopTimer()
 {
-	if (m_timerId != -1)
+	if (m_running)
 	{
-		killTimer(m_timerId);
-		m_timerId = -1;
+		ClockTicker::instance()->remove(this);
+		m_running = false;
 	}
 }
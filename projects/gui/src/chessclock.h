@@ -21,15 +21,25 @@
 #include <QWidget>
 #include <QTime>
 
-class QTimerEvent;
 class QLabel;
 
+/*!
+ * \brief A widget that shows a player's name and remaining time.
+ *
+ * The running clocks of the application share one display tick, so
+ * they are all updated in the same pass and stay in phase. Clocks
+ * that are not visible are skipped and caught up when shown.
+ */
 class ChessClock: public QWidget
 {
 	Q_OBJECT
 	
 	public:
 		ChessClock(QWidget* parent = nullptr);
+		virtual ~ChessClock();
+
+		/*! Updates the displayed time of a running clock. */
+		void tick();
 	
 	public slots:
 		void setPlayerName(const QString& name);
@@ -39,14 +49,15 @@ class ChessClock: public QWidget
 		void stop();
 	
 	protected:
-		virtual void timerEvent(QTimerEvent* event);
+		virtual void showEvent(QShowEvent* event);
 	
 	private:
 		void stopTimer();
 
 		int m_totalTime;
-		int m_timerId;
+		bool m_running;
 		bool m_infiniteTime;
+		QString m_timeText;
 		QTime m_time;
 		QLabel* m_nameLabel;
 		QLabel* m_timeLabel;
@@ -22,6 +22,9 @@
 #include <QTime>
 #include <QFileInfo>
 #include <QSettings>
+#include <QTimer>
+#include <QtConcurrentRun>
+#include <QThreadPool>
 
 #include <mersenne.h>
 #include <enginemanager.h>
@@ -30,6 +33,8 @@
 #include <chessgame.h>
 #include <timecontrol.h>
 #include <humanbuilder.h>
+#include <econode.h>
+#include <worker.h>
 
 #include "mainwindow.h"
 #include "settingsdlg.h"
@@ -54,8 +59,12 @@ CuteChessApplication::CuteChessApplication(int& argc, char* argv[])
 	  m_gameDatabaseManager(nullptr),
 	  m_gameDatabaseDialog(nullptr),
 	  m_gameWall(nullptr),
-	  m_initialWindowCreated(false)
+	  m_initialWindowCreated(false),
+	  m_traceStartup(false)
 {
+	m_startupTimer.start();
+	m_traceStartup = arguments().contains(QLatin1String("--trace-startup"));
+
 	Mersenne::initialize(QTime(0,0,0).msecsTo(QTime::currentTime()));
 
 	// Set the application icon
@@ -78,12 +87,13 @@ CuteChessApplication::CuteChessApplication(int& argc, char* argv[])
 
 	// Use Ini format on all platforms
 	QSettings::setDefaultFormat(QSettings::IniFormat);
+	traceStartup("application");
 
 	// Load the engines
 	engineManager()->loadEngines(configPath() + QLatin1String("/engines.json"));
+	traceStartup("engines");
 
-	// Read the game database state
-	gameDatabaseManager()->readState(configPath() + QLatin1String("/gamedb.bin"));
+	// The game database state is read when the database is first used
 
 	connect(this, SIGNAL(lastWindowClosed()), this, SLOT(onLastWindowClosed()));
 	connect(this, SIGNAL(aboutToQuit()), this, SLOT(onAboutToQuit()));
@@ -102,6 +112,13 @@ CuteChessApplication* CuteChessApplication::instance()
 	return static_cast<CuteChessApplication*>(QApplication::instance());
 }
 
+void CuteChessApplication::traceStartup(const char* phase)
+{
+	if (m_traceStartup)
+		qDebug("startup: %-16s %6lld ms", phase,
+		       m_startupTimer.elapsed());
+}
+
 QString CuteChessApplication::userName()
 {
 	#ifdef Q_OS_WIN32
@@ -169,6 +186,13 @@ MainWindow* CuteChessApplication::newGameWindow(ChessGame* game)
 	MainWindow* mainWindow = new MainWindow(game);
 	m_gameWindows.prepend(mainWindow);
 	mainWindow->show();
+
+	if (!m_initialWindowCreated)
+	{
+		traceStartup("main window");
+		// Let the window paint itself before anything else
+		QTimer::singleShot(0, this, SLOT(initializeDeferred()));
+	}
 	m_initialWindowCreated = true;
 
 	return mainWindow;
@@ -202,11 +226,24 @@ void CuteChessApplication::showGameWindow(int index)
 GameDatabaseManager* CuteChessApplication::gameDatabaseManager()
 {
 	if (m_gameDatabaseManager == nullptr)
+	{
 		m_gameDatabaseManager = new GameDatabaseManager(this);
+		m_gameDatabaseManager->readState(configPath() + QLatin1String("/gamedb.bin"));
+		traceStartup("game database");
+	}
 
 	return m_gameDatabaseManager;
 }
 
+void CuteChessApplication::initializeDeferred()
+{
+	traceStartup("event loop");
+
+	// The first move of a game needs the ECO tree; build it in
+	// the background so that the move isn't delayed
+	QtConcurrent::run(static_cast<void (*)()>(&EcoNode::initialize));
+}
+
 void CuteChessApplication::showSettingsDialog()
 {
 	if (m_settingsDialog == nullptr)
@@ -272,8 +309,13 @@ void CuteChessApplication::onLastWindowClosed()
 
 void CuteChessApplication::onAboutToQuit()
 {
-	if (gameDatabaseManager()->isModified())
-		gameDatabaseManager()->writeState(configPath() + QLatin1String("/gamedb.bin"));
+	// Don't let the imports outlive the application
+	if (m_gameDatabaseManager != nullptr)
+		m_gameDatabaseManager->cancelImports();
+	Worker::threadPool()->waitForDone();
+
+	if (m_gameDatabaseManager != nullptr && m_gameDatabaseManager->isModified())
+		m_gameDatabaseManager->writeState(configPath() + QLatin1String("/gamedb.bin"));
 }
 
 void CuteChessApplication::showDialog(QWidget* dlg)
@@ -20,6 +20,7 @@
 
 #include <QApplication>
 #include <QPointer>
+#include <QElapsedTimer>
 
 class EngineManager;
 class GameManager;
@@ -48,6 +49,13 @@ class CuteChessApplication : public QApplication
 		void showGameWindow(int index);
 		TournamentResultsDialog* tournamentResultsDialog();
 
+		/*!
+		 * Prints the time elapsed since the application started
+		 * with \a phase if the "--trace-startup" argument was
+		 * given.
+		 */
+		void traceStartup(const char* phase);
+
 		static CuteChessApplication* instance();
 		static QString userName();
 
@@ -73,8 +81,11 @@ class CuteChessApplication : public QApplication
 		GameDatabaseDialog* m_gameDatabaseDialog;
 		QPointer<GameWall> m_gameWall;
 		bool m_initialWindowCreated;
+		QElapsedTimer m_startupTimer;
+		bool m_traceStartup;
 
 	private slots:
+		void initializeDeferred();
 		void onLastWindowClosed();
 		void onAboutToQuit();
 };
@@ -103,9 +103,8 @@ QVariant EngineConfigurationModel::data(const QModelIndex& index, int role) cons
 			return QBrush(Qt::red);
 
 		int count = 0;
-		const auto& engines = m_engineManager->engines();
-		for (const EngineConfiguration& engine2: engines)
-			if (engine.name() == engine2.name())
+		for (int i = 0; i < m_engineManager->engineCount(); i++)
+			if (engine.name() == m_engineManager->engineNameAt(i))
 				if (++count > 1)
 					return QBrush(Qt::gray);
 
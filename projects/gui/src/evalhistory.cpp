@@ -25,7 +25,15 @@
 EvalHistory::EvalHistory(QWidget *parent)
 	: QWidget(parent),
 	  m_plot(new QCustomPlot(this)),
-	  m_game(nullptr)
+	  m_tbGraph(nullptr),
+	  m_game(nullptr),
+	  m_maxPly(-1),
+	  m_replotPending(false),
+	  m_hasData(false),
+	  m_minX(0.0),
+	  m_maxX(0.0),
+	  m_minY(0.0),
+	  m_maxY(0.0)
 {
 	auto x = m_plot->xAxis;
 	auto y = m_plot->yAxis;
@@ -46,6 +54,12 @@ EvalHistory::EvalHistory(QWidget *parent)
 	setLayout(layout);
 
 	setMinimumHeight(120);
+
+	// Coalesce score updates into at most four replots per second
+	m_replotTimer.setSingleShot(true);
+	m_replotTimer.setInterval(250);
+	connect(&m_replotTimer, SIGNAL(timeout()),
+		this, SLOT(onReplotTimeout()));
 }
 
 void EvalHistory::setGame(ChessGame* game)
@@ -53,9 +67,13 @@ void EvalHistory::setGame(ChessGame* game)
 	if (m_game)
 		m_game->disconnect(this);
 	m_game = game;
+	m_replotTimer.stop();
 	m_plot->clearGraphs();
+	m_tbGraph = nullptr;
+	resetBounds();
 	if (!game)
 	{
+		m_maxPly = 0;
 		replot(0);
 		return;
 	}
@@ -80,14 +98,16 @@ void EvalHistory::setGame(ChessGame* game)
 	cBlack.setAlpha(128);
 	m_plot->graph(1)->setBrush(QBrush(cBlack));
 
+	// Min/max-decimate the points that share a pixel column
+	m_plot->graph(0)->setAdaptiveSampling(true);
+	m_plot->graph(1)->setAdaptiveSampling(true);
+
 	const auto& scores = game->scores();
-	int ply = -1;
+	int ply = scores.size() - 1;
 
-	for (auto it = scores.constBegin(); it != scores.constEnd(); ++it)
-	{
-		ply = it.key();
-		addData(ply, it.value());
-	}
+	for (int i = 0; i < scores.size(); i++)
+		addData(i, scores.at(i).score);
+	m_maxPly = ply;
 	replot(ply);
 }
 
@@ -103,10 +123,63 @@ void EvalHistory::addData(int ply, int score)
 		y = -y;
 
 	m_plot->graph(side)->addData(x, y);
+	updateBounds(x, y);
+}
+
+void EvalHistory::updateBounds(double x, double y)
+{
+	if (!m_hasData)
+	{
+		m_minX = m_maxX = x;
+		m_minY = m_maxY = y;
+		m_hasData = true;
+		return;
+	}
+	m_minX = qMin(m_minX, x);
+	m_maxX = qMax(m_maxX, x);
+	m_minY = qMin(m_minY, y);
+	m_maxY = qMax(m_maxY, y);
+}
+
+void EvalHistory::addTablebaseScore(int ply, int score)
+{
+	if (m_tbGraph == nullptr)
+	{
+		// The tablebase results are dots on top of the engines'
+		// evaluations
+		m_tbGraph = m_plot->addGraph();
+		m_tbGraph->setLineStyle(QCPGraph::lsNone);
+		m_tbGraph->setScatterStyle(QCPScatterStyle(
+			QCPScatterStyle::ssDisc, QColor("#3a6ea5"), 5));
+	}
+
+	const double x = double(ply + 2) / 2;
+	const double y = qBound(-15.0, double(score) / 100.0, 15.0);
+	m_tbGraph->data()->remove(x);
+	m_tbGraph->addData(x, y);
+	updateBounds(x, y);
+
+	m_maxPly = qMax(m_maxPly, ply);
+	if (!m_replotTimer.isActive())
+		m_replotTimer.start();
+}
+
+void EvalHistory::resetBounds()
+{
+	m_hasData = false;
+	m_minX = m_maxX = 0.0;
+	m_minY = m_maxY = 0.0;
 }
 
 void EvalHistory::replot(int maxPly)
 {
+	if (!isVisible())
+	{
+		m_replotPending = true;
+		return;
+	}
+	m_replotPending = false;
+
 	if (maxPly == -1)
 	{
 		auto ticker = new QCPAxisTickerFixed;
@@ -120,13 +193,44 @@ void EvalHistory::replot(int maxPly)
 		auto ticker = m_plot->xAxis->ticker().dynamicCast<QCPAxisTickerFixed>();
 		Q_ASSERT(!ticker.isNull());
 		ticker->setTickStep(double(step));
-		m_plot->rescaleAxes();
+
+		// The data bounds are tracked in addData(), so there's
+		// no need to scan every point like rescaleAxes() does
+		if (m_hasData)
+		{
+			auto setRange = [](QCPAxis* axis, double lower, double upper)
+			{
+				if (lower == upper)
+				{
+					const double size = axis->range().size();
+					lower -= size / 2.0;
+					upper += size / 2.0;
+				}
+				axis->setRange(lower, upper);
+			};
+			setRange(m_plot->xAxis, m_minX, m_maxX);
+			setRange(m_plot->yAxis, m_minY, m_maxY);
+		}
 	}
-	m_plot->replot();
+	m_plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void EvalHistory::showEvent(QShowEvent* event)
+{
+	QWidget::showEvent(event);
+	if (m_replotPending)
+		replot(m_maxPly);
 }
 
 void EvalHistory::onScore(int ply, int score)
 {
 	addData(ply, score);
-	replot(ply);
+	m_maxPly = qMax(m_maxPly, ply);
+	if (!m_replotTimer.isActive())
+		m_replotTimer.start();
+}
+
+void EvalHistory::onReplotTimeout()
+{
+	replot(m_maxPly);
 }
@@ -20,8 +20,10 @@
 
 #include <QWidget>
 #include <QPointer>
+#include <QTimer>
 
 class QCustomPlot;
+class QCPGraph;
 class ChessGame;
 
 /*!
@@ -29,6 +31,11 @@ class ChessGame;
  *
  * The fullmove number is on the X axis and score (from white's
  * perspective) is on the Y axis.
+ *
+ * New scores are appended to the graphs as they arrive, but the
+ * plot is redrawn at most a few times per second, and only while
+ * the widget is visible. Long games are min/max-decimated to the
+ * widget's width when drawn.
  */
 class EvalHistory : public QWidget
 {
@@ -43,15 +50,39 @@ class EvalHistory : public QWidget
 		 */
 		void setGame(ChessGame* game);
 
+	public slots:
+		/*!
+		 * Plots the tablebase score \a score of the position after
+		 * move \a ply, replacing the previous score of the ply.
+		 * The score is in centipawns from white's point of view.
+		 */
+		void addTablebaseScore(int ply, int score);
+
+	protected:
+		// Inherited from QWidget
+		virtual void showEvent(QShowEvent* event);
+
 	private slots:
 		void onScore(int ply, int score);
+		void onReplotTimeout();
 
 	private:
 		void addData(int ply, int score);
+		void updateBounds(double x, double y);
 		void replot(int maxPly);
+		void resetBounds();
 
 		QCustomPlot* m_plot;
+		QCPGraph* m_tbGraph;
 		QPointer<ChessGame> m_game;
+		QTimer m_replotTimer;
+		int m_maxPly;
+		bool m_replotPending;
+		bool m_hasData;
+		double m_minX;
+		double m_maxX;
+		double m_minY;
+		double m_maxY;
 };
 
 #endif // EVALHISTORY_H
@@ -22,15 +22,29 @@
 #include <QVBoxLayout>
 #include <QVector>
 #include <QTime>
+#include <QTimer>
 #include <chessplayer.h>
 
+namespace {
+
+// The minimum interval between table updates
+const int s_updateInterval = 200;
+
+} // anonymous namespace
+
 EvalWidget::EvalWidget(QWidget *parent)
 	: QWidget(parent),
 	  m_player(nullptr),
 	  m_statsTable(new QTableWidget(1, 5, this)),
 	  m_pvTable(new QTableWidget(0, 5, this)),
+	  m_updateTimer(new QTimer(this)),
+	  m_multiPv(false),
 	  m_depth(-1)
 {
+	m_updateTimer->setSingleShot(true);
+	m_updateTimer->setInterval(s_updateInterval);
+	connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(flushEvals()));
+
 	m_statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 	auto hHeader = m_statsTable->horizontalHeader();
 	auto vHeader = m_statsTable->verticalHeader();
@@ -69,6 +83,8 @@ EvalWidget::EvalWidget(QWidget *parent)
 
 void EvalWidget::clear()
 {
+	m_updateTimer->stop();
+	m_pendingEvals.clear();
 	m_statsTable->clearContents();
 	m_depth = -1;
 	m_pv.clear();
@@ -79,7 +95,10 @@ void EvalWidget::clear()
 void EvalWidget::setPlayer(ChessPlayer* player)
 {
 	if (player != m_player || !player)
+	{
 		clear();
+		m_multiPv = false;
+	}
 	if (m_player)
 		m_player->disconnect(this);
 	m_player = player;
@@ -93,6 +112,57 @@ void EvalWidget::setPlayer(ChessPlayer* player)
 }
 
 void EvalWidget::onEval(const MoveEvaluation& eval)
+{
+	const int pvNumber = qMax(eval.pvNumber(), 1);
+
+	// Every depth of the primary PV gets a row in the history, so
+	// it's shown before it's replaced by a deeper one
+	if (!m_multiPv && pvNumber == 1 && m_pendingEvals.contains(1)
+	&&  m_pendingEvals.value(1).depth() != eval.depth())
+		showEval(m_pendingEvals.take(1));
+
+	m_pendingEvals[pvNumber] = eval;
+	if (!m_updateTimer->isActive())
+		m_updateTimer->start();
+}
+
+void EvalWidget::flushEvals()
+{
+	const auto evals = m_pendingEvals;
+	m_pendingEvals.clear();
+	for (const MoveEvaluation& eval : evals)
+		showEval(eval);
+}
+
+void EvalWidget::showEval(const MoveEvaluation& eval)
+{
+	showStats(eval);
+
+	const int pvNumber = qMax(eval.pvNumber(), 1);
+	if (pvNumber > 1 && !m_multiPv)
+	{
+		// Switch from the history to one row per PV
+		m_multiPv = true;
+		m_pvTable->clearContents();
+		m_pvTable->setRowCount(0);
+	}
+
+	if (m_multiPv)
+	{
+		if (m_pvTable->rowCount() < pvNumber)
+			m_pvTable->setRowCount(pvNumber);
+		setPvRow(pvNumber - 1, eval);
+		return;
+	}
+
+	if (eval.depth() != m_depth || (eval.pv() != m_pv && !m_pv.isEmpty()))
+		m_pvTable->insertRow(0);
+	m_depth = eval.depth();
+	m_pv = eval.pv();
+	setPvRow(0, eval);
+}
+
+void EvalWidget::showStats(const MoveEvaluation& eval)
 {
 	auto nps = eval.nps();
 	if (nps)
@@ -129,7 +199,10 @@ void EvalWidget::onEval(const MoveEvaluation& eval)
 		item->setText(QString("%1%").arg(rate, 0, 'f', 1));
 		m_statsTable->setItem(0, PonderHitHeader, item);
 	}
+}
 
+void EvalWidget::setPvRow(int row, const MoveEvaluation& eval)
+{
 	QString depth;
 	if (eval.depth())
 	{
@@ -165,11 +238,6 @@ void EvalWidget::onEval(const MoveEvaluation& eval)
 	for (int i = 0; i < 4; i++)
 		items[i]->setTextAlignment(Qt::AlignVCenter | Qt::AlignRight);
 
-	if (eval.depth() != m_depth || (eval.pv() != m_pv && !m_pv.isEmpty()))
-		m_pvTable->insertRow(0);
-	m_depth = eval.depth();
-	m_pv = eval.pv();
-
 	for (int i = 0; i < items.size(); i++)
-		m_pvTable->setItem(0, i, items.at(i));
+		m_pvTable->setItem(row, i, items.at(i));
 }
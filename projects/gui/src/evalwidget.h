@@ -20,13 +20,20 @@
 
 #include <QWidget>
 #include <QPointer>
+#include <QMap>
 #include <moveevaluation.h>
 
 class QTableWidget;
+class QTimer;
 class ChessPlayer;
 
 /*!
  * \brief A widget that shows the engine's thinking in realtime.
+ *
+ * The primary PV is shown as a history of one row per depth. Once
+ * the engine reports more than one PV, the table has one row per PV
+ * instead. Updates are collected and shown a few times per second,
+ * so a fast engine with many PVs can't flood the event loop.
  */
 class EvalWidget : public QWidget
 {
@@ -45,6 +52,7 @@ class EvalWidget : public QWidget
 	private slots:
 		void clear();
 		void onEval(const MoveEvaluation& eval);
+		void flushEvals();
 
 	private:
 		enum StatHeaders
@@ -56,9 +64,17 @@ class EvalWidget : public QWidget
 			TbHeader
 		};
 
+		void showEval(const MoveEvaluation& eval);
+		void showStats(const MoveEvaluation& eval);
+		void setPvRow(int row, const MoveEvaluation& eval);
+
 		QPointer<ChessPlayer> m_player;
 		QTableWidget* m_statsTable;
 		QTableWidget* m_pvTable;
+		QTimer* m_updateTimer;
+		// The latest update of each PV that isn't shown yet
+		QMap<int, MoveEvaluation> m_pendingEvals;
+		bool m_multiPv;
 		int m_depth;
 		QString m_pv;
 };
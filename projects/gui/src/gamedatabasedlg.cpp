@@ -18,20 +18,33 @@
 #include "gamedatabasedlg.h"
 #include "ui_gamedatabasedlg.h"
 
+#include <algorithm>
 #include <QVBoxLayout>
 #include <QMessageBox>
+#include <QHeaderView>
+#include <QTableWidget>
+#include <QScopedPointer>
 #include <QtAlgorithms>
 #include <QModelIndex>
 #include <QFileDialog>
 #include <QInputDialog>
+#include <QSettings>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <pgnstream.h>
 #include <pgngame.h>
 #include <pgngameentry.h>
+#include <pgnentryindex.h>
+#include <pgnduplicatefinder.h>
 #include <polyglotbook.h>
+#include <positionindex.h>
+#include <openingtree.h>
+#include <board/board.h>
 
 #include "pgndatabasemodel.h"
 #include "pgngameentrymodel.h"
+#include "pgnentryindexmodel.h"
 #include "gamedatabasemanager.h"
 #include "boardview/boardview.h"
 #include "boardview/boardscene.h"
@@ -55,36 +68,46 @@ class PgnGameIterator
 
 	private:
 		const GameDatabaseDialog* m_dlg;
+		const PgnEntryIndex* m_entryIndex;
 		int m_dbIndex;
 		int m_gameIndex;
-		int m_gameCount;
+		QVector<int> m_indexes;
 		QFile m_file;
 		PgnStream m_in;
 };
 
 PgnGameIterator::PgnGameIterator(const GameDatabaseDialog* dlg)
 	: m_dlg(dlg),
+	  m_entryIndex(dlg->selectedEntryIndex()),
 	  m_dbIndex(-1),
-	  m_gameIndex(0),
-	  m_gameCount(dlg->m_pgnGameEntryModel->entryCount())
+	  m_gameIndex(0)
 {
+	if (m_entryIndex == nullptr)
+		m_indexes = dlg->m_pgnGameEntryModel->sourceIndexes();
 }
 
 int PgnGameIterator::count() const
 {
-	return m_gameCount;
+	if (m_entryIndex != nullptr)
+		return m_entryIndex->count();
+	return m_indexes.size();
 }
 
 bool PgnGameIterator::hasNext() const
 {
-	return m_gameIndex < m_gameCount;
+	return m_gameIndex < count();
 }
 
 PgnGame PgnGameIterator::next(bool* ok, int depth)
 {
 	Q_ASSERT(hasNext());
 
-	int newDbIndex = m_dlg->databaseIndexFromGame(m_gameIndex);
+	// An indexed database is always the only selected database
+	const int sourceIndex = m_entryIndex != nullptr ?
+		m_gameIndex : m_indexes.at(m_gameIndex);
+	int newDbIndex = m_entryIndex != nullptr ?
+		m_dlg->m_selectedDatabases.firstKey() :
+		m_dlg->databaseIndexFromSource(sourceIndex);
 	Q_ASSERT(newDbIndex != -1);
 
 	if (newDbIndex != m_dbIndex)
@@ -111,8 +134,21 @@ PgnGame PgnGameIterator::next(bool* ok, int depth)
 		return game;
 	}
 
-	const PgnGameEntry* entry = m_dlg->m_pgnGameEntryModel->entryAt(m_gameIndex++);
-	*ok = m_in.seek(entry->pos(), entry->lineNumber()) && game.read(m_in, depth);
+	qint64 pos;
+	qint64 lineNumber;
+	if (m_entryIndex != nullptr)
+	{
+		pos = m_entryIndex->pos(sourceIndex);
+		lineNumber = m_entryIndex->lineNumber(sourceIndex);
+	}
+	else
+	{
+		const PgnGameEntry* entry = m_dlg->m_pgnGameEntryModel->sourceEntry(sourceIndex);
+		pos = entry->pos();
+		lineNumber = entry->lineNumber();
+	}
+	m_gameIndex++;
+	*ok = m_in.seek(pos, lineNumber) && game.read(m_in, depth);
 
 	return game;
 }
@@ -128,8 +164,10 @@ class BookExportTask : public ThreadedTask
 			       int maxDepth,
 			       QWidget* parent);
 
+		virtual ~BookExportTask();
+
 	protected:
-		virtual void run();
+		void work() override;
 
 	private:
 		PgnGameIterator* m_it;
@@ -149,10 +187,15 @@ BookExportTask::BookExportTask(PgnGameIterator* it,
 	  m_file(file),
 	  m_depth(maxDepth)
 {
-	m_file->moveToThread(this);
 }
 
-void BookExportTask::run()
+BookExportTask::~BookExportTask()
+{
+	delete m_it;
+	delete m_file;
+}
+
+void BookExportTask::work()
 {
 	QDataStream out(m_file);
 	PolyglotBook openingBook;
@@ -179,68 +222,296 @@ void BookExportTask::run()
 	// even if cancel was requested.
 	emit statusMessageChanged(tr("Writing opening book to disk"));
 	out << &openingBook;
-
-	delete m_it;
-	delete m_file;
+	m_file->close();
 
 	emit progressValueChanged(i);
 }
 
 
+// A selected game and its place in its database file
+struct PgnExportItem
+{
+	int dbIndex;
+	qint64 pos;
+	qint64 lineNumber;
+	// Where the next game of the file begins, or -1 at the end
+	qint64 end;
+	quint64 moveHash;
+};
+
+// A run of selected games from the same database file
+struct PgnExportChunk
+{
+	int begin;
+	int end;
+};
+
+struct PgnExportResult
+{
+	QByteArray text;
+	int gameCount;
+};
+
+/*
+ * Converts a chunk of export items to PGN text. Each call opens the
+ * database file itself, so the chunks can be written in parallel.
+ */
+struct PgnChunkWriter
+{
+	PgnChunkWriter(const QVector<PgnExportItem>& items,
+		       const QStringList& fileNames,
+		       bool raw)
+		: m_items(items),
+		  m_fileNames(fileNames),
+		  m_raw(raw) { }
+
+	typedef PgnExportResult result_type;
+
+	PgnExportResult operator()(const PgnExportChunk& chunk) const
+	{
+		PgnExportResult result;
+		result.gameCount = 0;
+
+		const QString& fileName(
+			m_fileNames.at(m_items.at(chunk.begin).dbIndex));
+		if (fileName.isEmpty())
+			return result;
+		QFile file(fileName);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+			return result;
+
+		if (m_raw)
+			copyGames(chunk, file, result);
+		else
+			rewriteGames(chunk, file, result);
+		return result;
+	}
+
+	// Copies the bytes of each game without parsing them
+	void copyGames(const PgnExportChunk& chunk,
+		       QFile& file,
+		       PgnExportResult& result) const
+	{
+		for (int i = chunk.begin; i < chunk.end; i++)
+		{
+			const PgnExportItem& item(m_items.at(i));
+			const qint64 end = item.end < 0 ? file.size() : item.end;
+			if (end <= item.pos || !file.seek(item.pos))
+				continue;
+
+			const QByteArray bytes(file.read(end - item.pos));
+			if (bytes.trimmed().isEmpty())
+				continue;
+			result.text += bytes;
+			if (!bytes.endsWith("\n\n"))
+				result.text += bytes.endsWith('\n') ? "\n" : "\n\n";
+			result.gameCount++;
+		}
+	}
+
+	void rewriteGames(const PgnExportChunk& chunk,
+			  QFile& file,
+			  PgnExportResult& result) const
+	{
+		PgnStream in(&file);
+		QTextStream out(&result.text, QIODevice::WriteOnly);
+		for (int i = chunk.begin; i < chunk.end; i++)
+		{
+			const PgnExportItem& item(m_items.at(i));
+			PgnGame game;
+			if (in.seek(item.pos, item.lineNumber) && game.read(in))
+			{
+				out << game;
+				result.gameCount++;
+			}
+		}
+		out.flush();
+	}
+
+	QVector<PgnExportItem> m_items;
+	QStringList m_fileNames;
+	bool m_raw;
+};
+
 class PgnExportTask : public ThreadedTask
 {
 	Q_OBJECT
 
 	public:
-		PgnExportTask(PgnGameIterator* it,
+		PgnExportTask(const GameDatabaseDialog* dlg,
+			      const QVector<PgnExportItem>& items,
 			      QFile* file,
+			      bool raw,
 			      QWidget* parent);
 
+		virtual ~PgnExportTask();
+
+		/*! Leaves out the duplicates of earlier games if \a enabled. */
+		void setSkipDuplicates(bool enabled);
+
+		/*! Returns the games selected in \a dlg. */
+		static QVector<PgnExportItem> exportItems(const GameDatabaseDialog* dlg);
+
 	protected:
-		virtual void run();
+		void work() override;
 
 	private:
-		PgnGameIterator* m_it;
+		void removeDuplicates();
+
+		QVector<PgnExportItem> m_items;
+		QStringList m_fileNames;
 		QFile* m_file;
+		bool m_raw;
+		bool m_skipDuplicates;
 };
 
-PgnExportTask::PgnExportTask(PgnGameIterator* it,
+PgnExportTask::PgnExportTask(const GameDatabaseDialog* dlg,
+			     const QVector<PgnExportItem>& items,
 			     QFile* file,
+			     bool raw,
 			     QWidget* parent)
 	: ThreadedTask(tr("Export Games"),
-		       tr("Writing %1 games to file").arg(it->count()),
-		       0, it->count(),
+		       tr("Writing %1 games to file").arg(items.size()),
+		       0, items.size(),
 		       parent),
-	  m_it(it),
-	  m_file(file)
+	  m_items(items),
+	  m_file(file),
+	  m_raw(raw),
+	  m_skipDuplicates(false)
+{
+	for (const PgnDatabase* db : dlg->m_dbManager->databases())
+	{
+		if (db->status() == PgnDatabase::Ok)
+			m_fileNames.append(db->fileName());
+		else
+			m_fileNames.append(QString());
+	}
+}
+
+PgnExportTask::~PgnExportTask()
+{
+	delete m_file;
+}
+
+QVector<PgnExportItem> PgnExportTask::exportItems(const GameDatabaseDialog* dlg)
+{
+	QVector<PgnExportItem> items;
+
+	// An indexed database is always the only selected database
+	const PgnEntryIndex* entryIndex = dlg->selectedEntryIndex();
+	if (entryIndex != nullptr)
+	{
+		const int dbIndex = dlg->m_selectedDatabases.firstKey();
+		const int count = entryIndex->count();
+		items.reserve(count);
+		for (int i = 0; i < count; i++)
+		{
+			PgnExportItem item = {
+				dbIndex,
+				entryIndex->pos(i),
+				entryIndex->lineNumber(i),
+				i + 1 < count ? entryIndex->pos(i + 1) : -1,
+				entryIndex->moveHash(i)
+			};
+			items.append(item);
+		}
+		return items;
+	}
+
+	// The source entries of the selected databases are in file
+	// order, so a game ends where the next entry of its file begins
+	const PgnGameEntryModel* model = dlg->m_pgnGameEntryModel;
+	const QVector<int> indexes(model->sourceIndexes());
+	items.reserve(indexes.size());
+	for (int sourceIndex : indexes)
+	{
+		const int dbIndex = dlg->databaseIndexFromSource(sourceIndex);
+		const PgnGameEntry* entry = model->sourceEntry(sourceIndex);
+		PgnExportItem item = {
+			dbIndex,
+			entry->pos(),
+			entry->lineNumber(),
+			-1,
+			entry->moveHash()
+		};
+		if (dlg->databaseIndexFromSource(sourceIndex + 1) == dbIndex)
+			item.end = model->sourceEntry(sourceIndex + 1)->pos();
+		items.append(item);
+	}
+
+	return items;
+}
+
+void PgnExportTask::setSkipDuplicates(bool enabled)
 {
-	m_file->moveToThread(this);
+	m_skipDuplicates = enabled;
 }
 
-void PgnExportTask::run()
+void PgnExportTask::removeDuplicates()
 {
-	QTextStream out(m_file);
+	emit statusMessageChanged(tr("Looking for duplicate games"));
+
+	PgnDuplicateFinder finder;
+	for (const PgnExportItem& item : m_items)
+		finder.addGame(m_fileNames.at(item.dbIndex), item.pos,
+			       item.lineNumber, item.moveHash);
+	if (finder.run() == 0)
+		return;
+
+	QVector<PgnExportItem> items;
+	items.reserve(m_items.size());
+	for (int i = 0; i < m_items.size(); i++)
+	{
+		if (!finder.isDuplicate(i))
+			items.append(m_items.at(i));
+	}
+	m_items = items;
+	emit statusMessageChanged(tr("Writing %1 games to file").arg(m_items.size()));
+}
 
+void PgnExportTask::work()
+{
+	static const int chunkSize = 1024;
+
+	if (m_skipDuplicates)
+		removeDuplicates();
+
+	// Split the games into chunks that don't cross database files
+	QVector<PgnExportChunk> chunks;
+	int begin = 0;
+	for (int i = 1; i <= m_items.size(); i++)
+	{
+		if (i == m_items.size() || i - begin >= chunkSize
+		||  m_items.at(i).dbIndex != m_items.at(begin).dbIndex)
+		{
+			PgnExportChunk chunk = { begin, i };
+			chunks.append(chunk);
+			begin = i;
+		}
+	}
+
+	// The chunks are converted in batches to limit the memory held
+	// by finished chunks, and written to the file in order
+	const PgnChunkWriter writer(m_items, m_fileNames, m_raw);
+	const int batchSize = 4 * qMax(1, QThread::idealThreadCount());
 	int i = 0;
-	while (m_it->hasNext())
+	for (int first = 0; first < chunks.size(); first += batchSize)
 	{
-		bool ok;
-		PgnGame game(m_it->next(&ok));
+		if (cancelRequested())
+			break;
 
-		if (ok)
+		const QVector<PgnExportChunk> batch(chunks.mid(first, batchSize));
+		QFuture<PgnExportResult> results(QtConcurrent::mapped(batch, writer));
+		for (int j = 0; j < batch.size(); j++)
 		{
-			out << game;
-			if (++i % 512 == 0)
-			{
-				if (cancelRequested())
-					break;
-				emit progressValueChanged(i);
-			}
+			const PgnExportResult result(results.resultAt(j));
+			m_file->write(result.text);
+			i += result.gameCount;
+			emit progressValueChanged(i);
 		}
 	}
 
-	delete m_it;
-	delete m_file;
+	m_file->close();
 
 	emit progressValueChanged(i);
 }
@@ -249,9 +520,11 @@ void PgnExportTask::run()
 GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget* parent)
 	: QDialog(parent, Qt::Window),
 	  m_gameViewer(nullptr),
+	  m_openingTreeTable(nullptr),
 	  m_dbManager(dbManager),
 	  m_pgnDatabaseModel(nullptr),
 	  m_pgnGameEntryModel(nullptr),
+	  m_pgnEntryIndexModel(nullptr),
 	  ui(new Ui::GameDatabaseDialog)
 {
 	Q_ASSERT(dbManager != nullptr);
@@ -268,17 +541,38 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 	new ModelTest(m_pgnGameEntryModel, this);
 	#endif
 
+	// Indexed databases are too large for filtering, so they
+	// have their own lazy model
+	m_pgnEntryIndexModel = new PgnEntryIndexModel(this);
+	#ifdef QT_DEBUG
+	new ModelTest(m_pgnEntryIndexModel, this);
+	#endif
+
 	ui->m_databasesListView->setModel(m_pgnDatabaseModel);
 	ui->m_databasesListView->setAlternatingRowColors(true);
 	ui->m_databasesListView->setUniformRowHeights(true);
 
-	ui->m_gamesListView->setModel(m_pgnGameEntryModel);
+	setGamesModel(m_pgnGameEntryModel);
 	ui->m_gamesListView->setAlternatingRowColors(true);
 	ui->m_gamesListView->setUniformRowHeights(true);
 
 	m_gameViewer = new GameViewer(Qt::Horizontal);
 	ui->m_viewerLayout->insertWidget(0, m_gameViewer);
 
+	// The opening tree shows the moves played in the viewed position
+	m_openingTreeTable = new QTableWidget(0, 5, this);
+	m_openingTreeTable->setHorizontalHeaderLabels(QStringList()
+		<< tr("Move") << tr("Games") << tr("Score") << tr("Draws")
+		<< tr("Avg. Elo"));
+	m_openingTreeTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_openingTreeTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+	m_openingTreeTable->verticalHeader()->hide();
+	m_openingTreeTable->horizontalHeader()->setStretchLastSection(true);
+	m_openingTreeTable->hide();
+	ui->m_viewerLayout->addWidget(m_openingTreeTable);
+	connect(m_gameViewer, SIGNAL(moveSelected(int)),
+		this, SLOT(updateOpeningTree()));
+
 	ui->m_splitter->setSizes(QList<int>() << 100 << 500 << 300);
 
 	connect(ui->m_importBtn, &QPushButton::clicked, this, [=]()
@@ -291,12 +585,11 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 	});
 	connect(ui->m_exportBtn, &QPushButton::clicked, this, [=]()
 	{
-		auto dlg = new QFileDialog(this, tr("Export game collection"), QString(),
-			tr("Portable Game Notation (*.pgn)"));
-		connect(dlg, &QFileDialog::fileSelected, this, &GameDatabaseDialog::exportPgn);
-		dlg->setAttribute(Qt::WA_DeleteOnClose);
-		dlg->setAcceptMode(QFileDialog::AcceptSave);
-		dlg->open();
+		selectExportFile(false);
+	});
+	connect(ui->m_exportUniqueBtn, &QPushButton::clicked, this, [=]()
+	{
+		selectExportFile(true);
 	});
 	connect(ui->m_createOpeningBookBtn, SIGNAL(clicked(bool)), this,
 		SLOT(createOpeningBook()));
@@ -305,10 +598,6 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 		SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)),
 		this, SLOT(databaseSelectionChanged(const QItemSelection&, const QItemSelection&)));
 
-	connect(ui->m_gamesListView->selectionModel(),
-		SIGNAL(currentChanged(const QModelIndex&, const QModelIndex&)),
-		this, SLOT(gameSelectionChanged(const QModelIndex&, const QModelIndex&)));
-
 	connect(ui->m_searchEdit, SIGNAL(textEdited(const QString&)),
 		this, SLOT(updateSearch(const QString&)));
 
@@ -318,10 +607,17 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 	connect(ui->m_advancedSearchBtn, SIGNAL(clicked()),
 		this, SLOT(onAdvancedSearch()));
 
+	connect(ui->m_positionSearchBtn, SIGNAL(clicked()),
+		this, SLOT(onPositionSearch()));
+
 	connect(m_pgnGameEntryModel, SIGNAL(modelReset()), this,
 		SLOT(updateUi()));
 	connect(m_pgnGameEntryModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
 		this, SLOT(updateUi()));
+	connect(m_pgnEntryIndexModel, SIGNAL(modelReset()), this,
+		SLOT(updateUi()));
+	connect(m_pgnEntryIndexModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+		this, SLOT(updateUi()));
 
 	m_searchTimer.setSingleShot(true);
 	connect(&m_searchTimer, SIGNAL(timeout()), this, SLOT(onSearchTimeout()));
@@ -341,8 +637,32 @@ void GameDatabaseDialog::databaseSelectionChanged(const QItemSelection& selected
 
 	const auto selectedIndexes = selected.indexes();
 	for (const QModelIndex& index : selectedIndexes)
+	{
+		// The games are loaded when the database is first browsed.
+		// A missing index is rebuilt after the selection has
+		// been handled.
+		if (!m_dbManager->loadDatabase(index.row()))
+			QMetaObject::invokeMethod(m_dbManager, "importDatabaseAgain",
+						  Qt::QueuedConnection,
+						  Q_ARG(int, index.row()));
 		m_selectedDatabases[index.row()] = m_dbManager->databases().at(index.row());
+	}
+	updateOpeningTree();
+
+	const PgnEntryIndex* entryIndex = selectedEntryIndex();
+	m_pgnEntryIndexModel->setIndex(entryIndex);
+	if (entryIndex != nullptr)
+	{
+		m_pgnGameEntryModel->setEntries(QList<const PgnGameEntry*>());
+		setGamesModel(m_pgnEntryIndexModel);
+		ui->m_searchEdit->setEnabled(false);
+		ui->m_advancedSearchBtn->setEnabled(false);
+		ui->m_positionSearchBtn->setEnabled(false);
+		return;
+	}
 
+	setGamesModel(m_pgnGameEntryModel);
+	ui->m_searchEdit->setEnabled(true);
 	if (m_selectedDatabases.isEmpty())
 	{
 		m_pgnGameEntryModel->setEntries(QList<const PgnGameEntry*>());
@@ -356,6 +676,7 @@ void GameDatabaseDialog::databaseSelectionChanged(const QItemSelection& selected
 
 	m_pgnGameEntryModel->setEntries(entries);
 	ui->m_advancedSearchBtn->setEnabled(true);
+	ui->m_positionSearchBtn->setEnabled(true);
 }
 
 void GameDatabaseDialog::gameSelectionChanged(const QModelIndex& current,
@@ -374,9 +695,20 @@ void GameDatabaseDialog::gameSelectionChanged(const QModelIndex& current,
 
 	PgnGame game;
 	PgnDatabase::Status status;
-	const PgnGameEntry* entry = m_pgnGameEntryModel->entryAt(current.row());
+	if (ui->m_gamesListView->model() == m_pgnEntryIndexModel)
+	{
+		const PgnEntryIndex* index = selectedDatabase->entryIndex();
+		const int row = m_pgnEntryIndexModel->indexRow(current.row());
+		status = selectedDatabase->game(index->pos(row),
+						index->lineNumber(row), &game);
+	}
+	else
+	{
+		const PgnGameEntry* entry = m_pgnGameEntryModel->entryAt(current.row());
+		status = selectedDatabase->game(entry, &game);
+	}
 
-	if ((status = selectedDatabase->game(entry, &game)) != PgnDatabase::Ok)
+	if (status != PgnDatabase::Ok)
 	{
 		if (status == PgnDatabase::DoesNotExist)
 		{
@@ -435,6 +767,7 @@ void GameDatabaseDialog::gameSelectionChanged(const QModelIndex& current,
 	ui->m_resultLabel->setText(game.tagValue("Result"));
 
 	m_gameViewer->setGame(&game);
+	updateOpeningTree();
 }
 
 void GameDatabaseDialog::updateSearch(const QString& terms)
@@ -461,25 +794,206 @@ void GameDatabaseDialog::onAdvancedSearch()
 	ui->m_clearBtn->setEnabled(true);
 }
 
+void GameDatabaseDialog::onPositionSearch()
+{
+	const Chess::Board* board = m_gameViewer->board();
+	if (board == nullptr || m_selectedDatabases.isEmpty())
+		return;
+
+	// The selected databases' entries are in the model back to back
+	const auto databases = m_selectedDatabases.values();
+	int entryCount = 0;
+	for (const PgnDatabase* db : databases)
+		entryCount += db->entries().count();
+
+	QBitArray mask(entryCount);
+	QStringList unindexed;
+	int offset = 0;
+	for (const PgnDatabase* db : databases)
+	{
+		const int count = db->entries().count();
+		PositionIndex index;
+		if (index.open(db->positionIndexFileName(), db->fileName()))
+		{
+			const auto hits = index.find(board->key());
+			for (const PositionIndex::Hit& hit : hits)
+			{
+				if (int(hit.game) < count)
+					mask.setBit(offset + int(hit.game));
+			}
+		}
+		else
+			unindexed << db->displayName();
+		offset += count;
+	}
+
+	if (!unindexed.isEmpty())
+		QMessageBox::warning(this, tr("Position Search"),
+			tr("These databases don't have an up-to-date position "
+			   "index:\n%1\n\nEnable position indexes in the "
+			   "settings and import the databases again.")
+			.arg(unindexed.join('\n')));
+
+	ui->m_searchEdit->setText(tr("[Position search]"));
+	ui->m_searchEdit->setEnabled(false);
+	m_pgnGameEntryModel->setFilter(PgnGameFilter(), mask);
+	ui->m_clearBtn->setEnabled(true);
+}
+
+void GameDatabaseDialog::updateOpeningTree()
+{
+	m_openingTreeTable->setRowCount(0);
+
+	// The moves of the position in every selected database. The
+	// trees are mapped files, so opening them is cheap.
+	Chess::Board* board = m_gameViewer->board();
+	QMap<quint32, OpeningTree::Continuation> continuations;
+	bool hasTree = false;
+	const auto databases = m_selectedDatabases.values();
+	for (const PgnDatabase* db : databases)
+	{
+		OpeningTree tree;
+		if (!tree.open(db->openingTreeFileName(), db->fileName()))
+			continue;
+		hasTree = true;
+		if (board == nullptr)
+			continue;
+
+		const auto moves = tree.find(board->key());
+		for (const OpeningTree::Continuation& move : moves)
+		{
+			auto it = continuations.find(move.childKey);
+			if (it == continuations.end())
+				continuations.insert(move.childKey, move);
+			else
+				it->add(move);
+		}
+	}
+	m_openingTreeTable->setVisible(hasTree);
+	if (continuations.isEmpty())
+		return;
+
+	// The moves are found by the keys of the positions they lead to
+	struct Row
+	{
+		QString move;
+		OpeningTree::Continuation stats;
+	};
+	QVector<Row> rows;
+	QScopedPointer<Chess::Board> copy(board->copy());
+	const auto legalMoves = copy->legalMoves();
+	for (const Chess::Move& move : legalMoves)
+	{
+		const QString san(copy->moveString(move,
+			Chess::Board::StandardAlgebraic));
+		copy->makeMove(move);
+		const auto it = continuations.constFind(quint32(copy->key()));
+		copy->undoMove();
+		if (it != continuations.constEnd())
+			rows.append({ san, it.value() });
+	}
+	std::stable_sort(rows.begin(), rows.end(),
+		[](const Row& a, const Row& b)
+	{
+		return a.stats.games > b.stats.games;
+	});
+
+	const bool white = (copy->sideToMove() == Chess::Side::White);
+	m_openingTreeTable->setRowCount(rows.size());
+	for (int i = 0; i < rows.size(); i++)
+	{
+		const OpeningTree::Continuation& stats = rows.at(i).stats;
+		const quint32 wins = white ? stats.whiteWins : stats.blackWins();
+		const double score = (wins + stats.draws / 2.0) / stats.games;
+		const int elo = stats.averageElo();
+
+		const QStringList columns = QStringList()
+			<< rows.at(i).move
+			<< QString::number(stats.games)
+			<< QString("%1%").arg(score * 100.0, 0, 'f', 1)
+			<< QString("%1%").arg(100.0 * stats.draws / stats.games,
+					      0, 'f', 1)
+			<< (elo > 0 ? QString::number(elo) : QString());
+		for (int j = 0; j < columns.size(); j++)
+		{
+			auto item = new QTableWidgetItem(columns.at(j));
+			if (j > 0)
+				item->setTextAlignment(Qt::AlignVCenter | Qt::AlignRight);
+			m_openingTreeTable->setItem(i, j, item);
+		}
+	}
+}
+
 int GameDatabaseDialog::databaseIndexFromGame(int game) const
 {
 	if (m_selectedDatabases.isEmpty())
 		return -1;
+	if (ui->m_gamesListView->model() == m_pgnEntryIndexModel)
+		return m_selectedDatabases.firstKey();
+
+	return databaseIndexFromSource(m_pgnGameEntryModel->sourceIndex(game));
+}
 
-	game = m_pgnGameEntryModel->sourceIndex(game);
+int GameDatabaseDialog::databaseIndexFromSource(int index) const
+{
+	if (m_selectedDatabases.isEmpty())
+		return -1;
 
 	QMap<int, PgnDatabase*>::const_iterator it;
 	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
 	{
-		game -= it.value()->entries().count();
-		if (game < 0)
+		index -= it.value()->entries().count();
+		if (index < 0)
 			return it.key();
 	}
 
 	return -1;
 }
 
-void GameDatabaseDialog::exportPgn(const QString& fileName)
+const PgnEntryIndex* GameDatabaseDialog::selectedEntryIndex() const
+{
+	// An indexed database is only shown on its own; when several
+	// databases are selected only their in-memory entries are shown
+	if (m_selectedDatabases.size() != 1)
+		return nullptr;
+	return m_selectedDatabases.first()->entryIndex();
+}
+
+void GameDatabaseDialog::setGamesModel(QAbstractItemModel* model)
+{
+	QTreeView* view = ui->m_gamesListView;
+	if (view->model() == model)
+		return;
+
+	QItemSelectionModel* oldSelectionModel = view->selectionModel();
+	view->setModel(model);
+	delete oldSelectionModel;
+
+	// Only the index model can sort all the games
+	view->setSortingEnabled(model == m_pgnEntryIndexModel);
+	if (model == m_pgnEntryIndexModel)
+		view->sortByColumn(-1, Qt::AscendingOrder);
+
+	connect(view->selectionModel(),
+		SIGNAL(currentChanged(const QModelIndex&, const QModelIndex&)),
+		this, SLOT(gameSelectionChanged(const QModelIndex&, const QModelIndex&)));
+	updateUi();
+}
+
+void GameDatabaseDialog::selectExportFile(bool skipDuplicates)
+{
+	auto dlg = new QFileDialog(this, tr("Export game collection"), QString(),
+		tr("Portable Game Notation (*.pgn)"));
+	connect(dlg, &QFileDialog::fileSelected, this, [=](const QString& fileName)
+	{
+		exportPgn(fileName, skipDuplicates);
+	});
+	dlg->setAttribute(Qt::WA_DeleteOnClose);
+	dlg->setAcceptMode(QFileDialog::AcceptSave);
+	dlg->open();
+}
+
+void GameDatabaseDialog::exportPgn(const QString& fileName, bool skipDuplicates)
 {
 	QFile* file = new QFile(fileName);
 	if (!file->open(QIODevice::WriteOnly | QIODevice::Append))
@@ -491,8 +1005,11 @@ void GameDatabaseDialog::exportPgn(const QString& fileName)
 		return;
 	}
 
-	PgnExportTask* task = new PgnExportTask(new PgnGameIterator(this),
-						file, this);
+	const bool raw = QSettings().value("games/raw_pgn_export", false).toBool();
+	PgnExportTask* task = new PgnExportTask(this,
+		PgnExportTask::exportItems(this), file, raw, this);
+	task->setSkipDuplicates(skipDuplicates);
+	task->setPriority(Worker::InteractivePriority);
 	task->start();
 }
 
@@ -523,14 +1040,16 @@ void GameDatabaseDialog::createOpeningBook()
 
 	BookExportTask* task = new BookExportTask(new PgnGameIterator(this),
 						  file, depth, this);
+	task->setPriority(Worker::InteractivePriority);
 	task->start();
 }
 
 void GameDatabaseDialog::updateUi()
 {
-	bool enable = m_pgnGameEntryModel->rowCount() > 0;
+	bool enable = ui->m_gamesListView->model()->rowCount() > 0;
 	ui->m_createOpeningBookBtn->setEnabled(enable);
 	ui->m_exportBtn->setEnabled(enable);
+	ui->m_exportUniqueBtn->setEnabled(enable);
 }
 
 #include "gamedatabasedlg.moc"
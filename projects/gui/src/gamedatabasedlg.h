@@ -27,8 +27,12 @@
 class GameDatabaseManager;
 class PgnDatabaseModel;
 class PgnGameEntryModel;
+class PgnEntryIndexModel;
+class PgnEntryIndex;
+class QAbstractItemModel;
 class PgnDatabase;
 class GameViewer;
+class QTableWidget;
 
 namespace Ui {
 	class GameDatabaseDialog;
@@ -58,20 +62,29 @@ class GameDatabaseDialog : public QDialog
 		void updateSearch(const QString& terms = QString());
 		void onSearchTimeout();
 		void onAdvancedSearch();
-		void exportPgn(const QString& filename);
+		void onPositionSearch();
+		void updateOpeningTree();
 		void createOpeningBook();
 		void updateUi();
 
 	private:
 		friend class PgnGameIterator;
+		friend class PgnExportTask;
 		int databaseIndexFromGame(int game) const;
+		int databaseIndexFromSource(int index) const;
+		const PgnEntryIndex* selectedEntryIndex() const;
+		void setGamesModel(QAbstractItemModel* model);
+		void selectExportFile(bool skipDuplicates);
+		void exportPgn(const QString& fileName, bool skipDuplicates);
 
 		GameViewer* m_gameViewer;
+		QTableWidget* m_openingTreeTable;
 		QVector<PgnGame::MoveData> m_moves;
 
 		GameDatabaseManager* m_dbManager;
 		PgnDatabaseModel* m_pgnDatabaseModel;
 		PgnGameEntryModel* m_pgnGameEntryModel;
+		PgnEntryIndexModel* m_pgnEntryIndexModel;
 		QMap<int, PgnDatabase*> m_selectedDatabases;
 
 		QTimer m_searchTimer;
@@ -17,11 +17,14 @@
 
 #include "gamedatabasemanager.h"
 
+#include <QDir>
 #include <QFileInfo>
 #include <QDataStream>
-#include <QThreadPool>
+#include <QSettings>
 
 #include <pgngameentry.h>
+#include <pgntagpool.h>
+#include <pgnentryindex.h>
 
 #include "pgndatabase.h"
 #include "pgnimporter.h"
@@ -29,7 +32,16 @@
 #include "cutechessapp.h"
 
 #define GAME_DATABASE_STATE_MAGIC   0xDEADD00D
-#define GAME_DATABASE_STATE_VERSION 1
+#define GAME_DATABASE_STATE_VERSION 3
+
+namespace {
+
+int entryIndexThreshold()
+{
+	return QSettings().value("games/entry_index_threshold", 1000000).toInt();
+}
+
+} // anonymous namespace
 
 GameDatabaseManager::GameDatabaseManager(QObject* parent)
 	: QObject(parent),
@@ -64,18 +76,14 @@ bool GameDatabaseManager::writeState(const QString& fileName)
 	// Write the number of databases
 	out << (qint32)m_databases.count();
 
-	// Write the contents of the databases
+	// Write the databases. Their game entries are in the entry
+	// index files that were written when they were imported.
 	// TODO: use qAsConst() from Qt 5.7
 	foreach (const PgnDatabase* db, m_databases)
 	{
 		out << db->fileName();
 		out << db->lastModified();
 		out << db->displayName();
-		out << (qint32)db->entries().count();
-
-		const auto entries = db->entries();
-		for (const PgnGameEntry* entry : entries)
-			entry->write(out);
 	}
 
 	m_modified = false;
@@ -107,10 +115,11 @@ bool GameDatabaseManager::readState(const QString& fileName)
 	quint32 version;
 	in >> version;
 
-	if (version < GAME_DATABASE_STATE_VERSION ||
+	// Versions 1 and 2 store the game entries in the state file,
+	// and they are converted to entry index files
+	if (version < 1 ||
 	    version > GAME_DATABASE_STATE_VERSION)
 	{
-		// TODO: Add backward compatibility
 		qWarning("GameDatabaseManager: state file version mismatch");
 		return false;
 	}
@@ -124,6 +133,7 @@ bool GameDatabaseManager::readState(const QString& fileName)
 	QDateTime dbLastModified;
 	QString dbDisplayName;
 	QList<PgnDatabase*> readDatabases;
+	bool modified = version < GAME_DATABASE_STATE_VERSION;
 
 	for (int i = 0; i < dbCount; i++)
 	{
@@ -131,43 +141,74 @@ bool GameDatabaseManager::readState(const QString& fileName)
 		in >> dbLastModified;
 		in >> dbDisplayName;
 
+		// Read the entries of an old state file. A count of -1
+		// means that the entries are already in an index file.
+		QList<const PgnGameEntry*> entries;
+		PgnTagPool* tagPool = nullptr;
+		if (version < 3)
+		{
+			qint32 dbEntryCount;
+			in >> dbEntryCount;
+
+			tagPool = new PgnTagPool;
+			for (int j = 0; j < dbEntryCount; j++)
+			{
+				PgnGameEntry* entry = new PgnGameEntry(tagPool);
+				entry->read(in);
+				entries << entry;
+			}
+		}
+
 		// Check if the database exists
 		QFileInfo fileInfo(dbFileName);
 		if (!fileInfo.exists())
 		{
-			m_modified = true;
+			qDeleteAll(entries);
+			delete tagPool;
+			modified = true;
 			continue;
 		}
 
-		// Check if the database has been modified
-		if (fileInfo.lastModified() > dbLastModified)
+		PgnDatabase* db = new PgnDatabase(dbFileName);
+		db->setLastModified(dbLastModified);
+		db->setDisplayName(dbDisplayName);
+
+		// Check if the database has been modified. Only the
+		// header of the entry index is checked here; the index
+		// is mapped when the database is first browsed.
+		bool valid = fileInfo.lastModified() <= dbLastModified;
+		if (valid && !entries.isEmpty())
+		{
+			QDir().mkpath(QFileInfo(db->entryIndexFileName()).absolutePath());
+			valid = PgnEntryIndex::write(db->entryIndexFileName(),
+						     entries, dbFileName);
+		}
+		else if (valid)
+			valid = PgnEntryIndex().open(db->entryIndexFileName(),
+						     dbFileName);
+
+		if (!valid)
 		{
-			m_modified = true;
+			qDeleteAll(entries);
+			delete tagPool;
+			delete db;
+			modified = true;
 			importPgnFile(dbFileName);
 			continue;
 		}
 
-		qint32 dbEntryCount;
-		in >> dbEntryCount;
-
-		// Read the entries
-		QList<const PgnGameEntry*> entries;
-		for (int j = 0; j < dbEntryCount; j++)
+		if (!entries.isEmpty())
 		{
-			PgnGameEntry* entry = new PgnGameEntry;
-			entry->read(in);
-			entries << entry;
+			db->setTagPool(tagPool);
+			db->setEntries(entries);
 		}
-
-		PgnDatabase* db = new PgnDatabase(dbFileName);
-		db->setEntries(entries);
-		db->setLastModified(dbLastModified);
-		db->setDisplayName(dbDisplayName);
+		else
+			delete tagPool;
 
 		readDatabases << db;
 	}
 
-	m_modified = false;
+	m_modified = modified;
 
 	m_databases = readDatabases;
 	emit databasesReset();
@@ -178,6 +219,11 @@ bool GameDatabaseManager::readState(const QString& fileName)
 void GameDatabaseManager::importPgnFile(const QString& fileName)
 {
 	PgnImporter* pgnImporter = new PgnImporter(fileName);
+	pgnImporter->setPositionIndexEnabled(
+		QSettings().value("games/position_index", false).toBool());
+	pgnImporter->setEntryIndexThreshold(entryIndexThreshold());
+	pgnImporter->setPriority(Worker::BackgroundPriority);
+	pgnImporter->setGroupToken(m_importToken);
 	connect(pgnImporter, SIGNAL(databaseRead(PgnDatabase*)),
 		this, SLOT(addDatabase(PgnDatabase*)));
 
@@ -186,7 +232,13 @@ void GameDatabaseManager::importPgnFile(const QString& fileName)
 	dlg->raise();
 	dlg->activateWindow();
 
-	QThreadPool::globalInstance()->start(pgnImporter);
+	pgnImporter->start();
+}
+
+void GameDatabaseManager::cancelImports()
+{
+	m_importToken.cancel();
+	m_importToken = CancelToken();
 }
 
 void GameDatabaseManager::addDatabase(PgnDatabase* database)
@@ -199,6 +251,12 @@ void GameDatabaseManager::addDatabase(PgnDatabase* database)
 void GameDatabaseManager::removeDatabase(int index)
 {
 	emit databaseAboutToBeRemoved(index);
+
+	PgnDatabase* db = m_databases.at(index);
+	QFile::remove(db->positionIndexFileName());
+	QFile::remove(db->openingTreeFileName());
+	db->setEntryIndex(nullptr);
+	QFile::remove(db->entryIndexFileName());
 	m_databases.removeAt(index);
 	m_modified = true;
 }
@@ -211,6 +269,11 @@ void GameDatabaseManager::importDatabaseAgain(int index)
 	importPgnFile(fileName);
 }
 
+bool GameDatabaseManager::loadDatabase(int index)
+{
+	return m_databases.at(index)->load(entryIndexThreshold());
+}
+
 bool GameDatabaseManager::isModified() const
 {
 	return m_modified;
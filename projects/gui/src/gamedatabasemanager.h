@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include <QList>
+#include <worker.h>
 
 class PgnImporter;
 class PgnDatabase;
@@ -57,6 +58,15 @@ class GameDatabaseManager : public QObject
 		 */
 		bool readState(const QString& fileName);
 
+		/*!
+		 * Loads the games of the database at \a index if they're
+		 * not loaded yet. The databases read by readState() are
+		 * loaded when they're first needed.
+		 *
+		 * Returns false if the games can't be loaded.
+		 */
+		bool loadDatabase(int index);
+
 		/*! Returns true if the current state has been modified. */
 		bool isModified() const;
 
@@ -84,6 +94,13 @@ class GameDatabaseManager : public QObject
 		 * \sa importStarted
 		 */
 		void importPgnFile(const QString& fileName);
+		/*!
+		 * Cancels all imports that are queued or running.
+		 *
+		 * The imports finish in the background; wait for
+		 * Worker::threadPool() to be done with them before exiting.
+		 */
+		void cancelImports();
 	signals:
 		/*!
 		 * Emitted when database is added at \a index.
@@ -110,6 +127,7 @@ class GameDatabaseManager : public QObject
 	private:
 		QList<PgnDatabase*> m_databases;
 		bool m_modified;
+		CancelToken m_importToken;
 
 };
 
@@ -24,7 +24,7 @@
 #include <board/syzygytablebase.h>
 #include <engineconfiguration.h>
 #include <openingsuite.h>
-#include <polyglotbook.h>
+#include <openingbookregistry.h>
 #include "timecontroldlg.h"
 
 GameSettingsWidget::GameSettingsWidget(QWidget *parent)
@@ -99,6 +99,7 @@ GameSettingsWidget::GameSettingsWidget(QWidget *parent)
 		ui->m_polyglotDepthSpin->setEnabled(!str.isEmpty());
 		ui->m_ramAccessRadio->setEnabled(!str.isEmpty());
 		ui->m_diskAccessRadio->setEnabled(!str.isEmpty());
+		ui->m_mappedAccessRadio->setEnabled(!str.isEmpty());
 	});
 
 	readSettings();
@@ -176,23 +177,19 @@ int GameSettingsWidget::openingSuiteDepth() const
 	return ui->m_openingSuiteDepthSpin->value();
 }
 
-OpeningBook* GameSettingsWidget::openingBook() const
+QSharedPointer<const OpeningBook> GameSettingsWidget::openingBook() const
 {
 	QString file = ui->m_polyglotFileEdit->text();
 	if (file.isEmpty())
-		return nullptr;
+		return QSharedPointer<const OpeningBook>();
 
 	auto mode = OpeningBook::Ram;
 	if (ui->m_diskAccessRadio->isChecked())
 		mode = OpeningBook::Disk;
-	auto book = new PolyglotBook(mode);
-	if (!book->read(file))
-	{
-		delete book;
-		return nullptr;
-	}
+	else if (ui->m_mappedAccessRadio->isChecked())
+		mode = OpeningBook::Mapped;
 
-	return book;
+	return OpeningBookRegistry::polyglotBook(file, mode);
 }
 
 int GameSettingsWidget::bookDepth() const
@@ -239,6 +236,8 @@ void GameSettingsWidget::readSettings()
 	ui->m_polyglotDepthSpin->setValue(s.value("depth", 10).toInt());
 	if (s.value("disk_access").toBool())
 		ui->m_diskAccessRadio->setChecked(true);
+	else if (s.value("mapped_access").toBool())
+		ui->m_mappedAccessRadio->setChecked(true);
 	s.endGroup();
 
 	s.beginGroup("draw_adjudication");
@@ -312,6 +311,10 @@ void GameSettingsWidget::enableSettingsUpdates()
 	{
 		QSettings().setValue("games/opening_book/disk_access", checked);
 	});
+	connect(ui->m_mappedAccessRadio, &QRadioButton::toggled, [=](bool checked)
+	{
+		QSettings().setValue("games/opening_book/mapped_access", checked);
+	});
 
 	connect(ui->m_drawMoveNumberSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
 		[=](int moveNumber)
@@ -19,6 +19,7 @@
 #define GAMESETTINGSWIDGET_H
 
 #include <QWidget>
+#include <QSharedPointer>
 #include <timecontrol.h>
 #include <gameadjudicator.h>
 
@@ -46,7 +47,7 @@ class GameSettingsWidget : public QWidget
 		GameAdjudicator adjudicator() const;
 		OpeningSuite* openingSuite() const;
 		int openingSuiteDepth() const;
-		OpeningBook* openingBook() const;
+		QSharedPointer<const OpeningBook> openingBook() const;
 		int bookDepth() const;
 		bool isValid() const;
 
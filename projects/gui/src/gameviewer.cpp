@@ -24,10 +24,18 @@
 #include <pgngame.h>
 #include <chessgame.h>
 #include <chessplayer.h>
+#include <board/board.h>
 #include "boardview/boardscene.h"
 #include "boardview/boardview.h"
 #include "chessclock.h"
 
+namespace {
+
+// Number of plies between the snapshots used for seeking
+const int s_snapshotInterval = 16;
+
+} // anonymous namespace
+
 GameViewer::GameViewer(Qt::Orientation orientation,
                        QWidget* parent,
                        bool addChessClock)
@@ -133,6 +141,10 @@ GameViewer::GameViewer(Qt::Orientation orientation,
 	setLayout(layout);
 }
 
+GameViewer::~GameViewer()
+{
+}
+
 ChessClock* GameViewer::chessClock(Chess::Side side)
 {
 	return m_chessClock[side];
@@ -172,11 +184,16 @@ void GameViewer::setGame(const PgnGame* pgn)
 
 	disconnectGame();
 
+	m_snapshots.clear();
+	m_seekBoard.reset();
+
 	auto board = pgn->createBoard();
 	if (board)
 	{
 		m_boardScene->setBoard(board);
 		m_boardScene->populate();
+		m_snapshots.append(board->snapshot());
+		m_seekBoard.reset(board->copy());
 	}
 	else
 	{
@@ -240,8 +257,7 @@ void GameViewer::viewFirstMoveClicked()
 
 void GameViewer::viewFirstMove()
 {
-	while (m_moveIndex > 0)
-		viewPreviousMove();
+	viewPosition(0);
 }
 
 void GameViewer::viewPreviousMoveClicked()
@@ -279,6 +295,10 @@ void GameViewer::viewNextMove()
 {
 	m_boardScene->makeMove(m_moves.at(m_moveIndex++));
 
+	if (m_moveIndex % s_snapshotInterval == 0
+	&&  m_snapshots.size() == m_moveIndex / s_snapshotInterval)
+		m_snapshots.append(m_boardScene->board()->snapshot());
+
 	m_viewPreviousMoveBtn->setEnabled(true);
 	m_viewFirstMoveBtn->setEnabled(true);
 
@@ -303,8 +323,7 @@ void GameViewer::viewLastMoveClicked()
 
 void GameViewer::viewLastMove()
 {
-	while (m_moveIndex < m_moves.count())
-		viewNextMove();
+	viewPosition(m_moves.count());
 }
 
 void GameViewer::viewPositionClicked(int index)
@@ -318,12 +337,70 @@ void GameViewer::viewPosition(int index)
 	if (m_moves.isEmpty())
 		return;
 
+	// Distant positions are reached through the snapshots, and
+	// only the final move is shown with a transition
+	if (qAbs(index - m_moveIndex) > 1 && !m_snapshots.isEmpty())
+	{
+		if (index == 0)
+		{
+			seekPosition(0);
+			return;
+		}
+		seekPosition(index - 1);
+		viewNextMove();
+		return;
+	}
+
 	while (index < m_moveIndex)
 		viewPreviousMove();
 	while (index > m_moveIndex)
 		viewNextMove();
 }
 
+void GameViewer::seekPosition(int index)
+{
+	Q_ASSERT(index >= 0 && index <= m_moves.count());
+	Q_ASSERT(!m_snapshots.isEmpty());
+
+	int ply = qMin(index / s_snapshotInterval, m_snapshots.size() - 1)
+		* s_snapshotInterval;
+	if (!m_seekBoard->restore(m_snapshots.at(ply / s_snapshotInterval)))
+		return;
+
+	// The plies in between are made on a board of our own, so
+	// they don't cost any transitions or animations in the scene
+	while (ply < index)
+	{
+		const auto& move = m_moves.at(ply++);
+		m_seekBoard->makeMove(m_seekBoard->moveFromGenericMove(move));
+
+		if (ply % s_snapshotInterval == 0
+		&&  m_snapshots.size() == ply / s_snapshotInterval)
+			m_snapshots.append(m_seekBoard->snapshot());
+	}
+
+	m_boardScene->setPosition(m_seekBoard->snapshot());
+	m_moveIndex = index;
+	updateControls();
+}
+
+void GameViewer::updateControls()
+{
+	const bool atStart = m_moveIndex <= 0;
+	const bool atEnd = m_moveIndex >= m_moves.count();
+
+	m_viewFirstMoveBtn->setEnabled(!atStart);
+	m_viewPreviousMoveBtn->setEnabled(!atStart);
+	m_viewNextMoveBtn->setEnabled(!atEnd);
+	m_viewLastMoveBtn->setEnabled(!atEnd);
+
+	m_boardView->setEnabled(atEnd && !m_game.isNull()
+				&& !m_game->isFinished()
+				&& m_game->playerToMove()->isHuman());
+
+	m_moveNumberSlider->setSliderPosition(m_moveIndex);
+}
+
 void GameViewer::viewMove(int index)
 {
 	Q_ASSERT(index >= 0);
@@ -333,15 +410,14 @@ void GameViewer::viewMove(int index)
 	{
 		// We backtrack one move too far and then make one
 		// move forward to highlight the correct move
+		if (m_moveIndex - index > 1 && !m_snapshots.isEmpty())
+			seekPosition(index);
 		while (index < m_moveIndex)
 			viewPreviousMove();
 		viewNextMove();
 	}
 	else
-	{
-		while (index + 1 > m_moveIndex)
-			viewNextMove();
-	}
+		viewPosition(index + 1);
 }
 
 void GameViewer::onFenChanged(const QString& fen)
@@ -357,6 +433,10 @@ void GameViewer::onFenChanged(const QString& fen)
 	m_moveNumberSlider->setMaximum(0);
 
 	m_boardScene->setFenString(fen);
+
+	m_snapshots.clear();
+	if (!m_seekBoard.isNull())
+		m_snapshots.append(m_boardScene->board()->snapshot());
 }
 
 void GameViewer::onMoveMade(const Chess::GenericMove& move)
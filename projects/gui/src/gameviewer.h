@@ -21,8 +21,10 @@
 #include <QWidget>
 #include <QVector>
 #include <QPointer>
+#include <QScopedPointer>
 #include <board/side.h>
 #include <board/genericmove.h>
+#include <board/boardsnapshot.h>
 class QToolButton;
 class QSlider;
 class ChessGame;
@@ -43,6 +45,8 @@ class GameViewer : public QWidget
 		explicit GameViewer(Qt::Orientation orientation = Qt::Horizontal,
 		                    QWidget* parent = nullptr,
 		                    bool addChessClock = false);
+		/*! Destroys the game viewer. */
+		virtual ~GameViewer();
 
 		void setGame(ChessGame* game);
 		void setGame(const PgnGame* pgn);
@@ -73,6 +77,8 @@ class GameViewer : public QWidget
 		void viewNextMove();
 		void viewLastMove();
 		void viewPosition(int index);
+		void seekPosition(int index);
+		void updateControls();
 
 		BoardScene* m_boardScene;
 		BoardView* m_boardView;
@@ -87,6 +93,13 @@ class GameViewer : public QWidget
 		QPointer<ChessGame> m_game;
 		QVector<Chess::GenericMove> m_moves;
 		int m_moveIndex;
+		/*!
+		 * Snapshots of every s_snapshotInterval'th position,
+		 * starting from the initial one. They're taken lazily
+		 * as positions are visited.
+		 */
+		QVector<Chess::BoardSnapshot> m_snapshots;
+		QScopedPointer<Chess::Board> m_seekBoard;
 };
 
 #endif // GAMEVIEWER_H
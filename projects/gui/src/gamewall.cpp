@@ -17,6 +17,7 @@
 
 #include "gamewall.h"
 
+#include <QPainter>
 #include <QPointer>
 
 #include <chessplayer.h>
@@ -39,8 +40,22 @@ class GameWallWidget : public QWidget
 		virtual ~GameWallWidget();
 
 		void setGame(ChessGame* game);
+		/*! Repaints the board if it has changed since the last frame. */
+		void flush();
+
+	signals:
+		/*! Emitted when the board needs to be repainted. */
+		void changed();
+
+	protected:
+		virtual void enterEvent(QEvent* event);
+		virtual void leaveEvent(QEvent* event);
+
+	private slots:
+		void onSceneChanged();
 
 	private:
+		bool m_dirty;
 		ChessClock* m_clocks[2];
 		BoardScene* m_scene;
 		BoardView* m_view;
@@ -48,7 +63,8 @@ class GameWallWidget : public QWidget
 };
 
 GameWallWidget::GameWallWidget(QWidget* parent)
-	: QWidget(parent)
+	: QWidget(parent),
+	  m_dirty(false)
 {
 	QHBoxLayout* clockLayout = new QHBoxLayout();
 	for (int i = 0; i < 2; i++)
@@ -64,8 +80,17 @@ GameWallWidget::GameWallWidget(QWidget* parent)
 	clockLayout->insertSpacing(1, 20);
 
 	m_scene = new BoardScene(this);
+	m_scene->setAnimated(false);
 	m_view = new BoardView(m_scene);
 
+	// The wall decides when the board is repainted. The pieces are
+	// cached as pixmaps anyway, so antialiasing is only lost on the
+	// move arrows.
+	m_view->setViewportUpdateMode(QGraphicsView::NoViewportUpdate);
+	m_view->setRenderHint(QPainter::Antialiasing, false);
+	connect(m_scene, SIGNAL(changed(QList<QRectF>)),
+		this, SLOT(onSceneChanged()));
+
 	QVBoxLayout* mainLayout = new QVBoxLayout();
 	mainLayout->addLayout(clockLayout);
 	mainLayout->addWidget(m_view);
@@ -78,6 +103,38 @@ GameWallWidget::~GameWallWidget()
 {
 }
 
+void GameWallWidget::onSceneChanged()
+{
+	if (m_dirty)
+		return;
+
+	m_dirty = true;
+	emit changed();
+}
+
+void GameWallWidget::flush()
+{
+	if (!m_dirty)
+		return;
+
+	// Hidden boards are painted when they're exposed again
+	m_dirty = false;
+	if (!m_view->visibleRegion().isEmpty())
+		m_view->viewport()->update();
+}
+
+void GameWallWidget::enterEvent(QEvent* event)
+{
+	QWidget::enterEvent(event);
+	m_scene->setAnimated(true);
+}
+
+void GameWallWidget::leaveEvent(QEvent* event)
+{
+	QWidget::leaveEvent(event);
+	m_scene->setAnimated(false);
+}
+
 void GameWallWidget::setGame(ChessGame* game)
 {
 	game->lockThread();
@@ -142,6 +199,11 @@ GameWall::GameWall(GameManager* manager, QWidget *parent)
 
 	setLayout(new TileLayout());
 
+	// Repaint the changed boards at most 30 times per second
+	m_frameTimer.setSingleShot(true);
+	m_frameTimer.setInterval(1000 / 30);
+	connect(&m_frameTimer, SIGNAL(timeout()), this, SLOT(paintFrame()));
+
 	const auto activeGames = manager->activeGames();
 	for (ChessGame* game : activeGames)
 	{
@@ -162,6 +224,7 @@ GameWallWidget* GameWall::getFreeWidget()
 
 	auto widget = new GameWallWidget(this);
 	layout()->addWidget(widget);
+	connect(widget, SIGNAL(changed()), this, SLOT(scheduleFrame()));
 
 	return widget;
 }
@@ -186,4 +249,20 @@ void GameWall::removeGame(ChessGame* game)
 	m_gamesToRemove.append(m_games.take(game));
 }
 
+void GameWall::scheduleFrame()
+{
+	if (!m_frameTimer.isActive())
+		m_frameTimer.start();
+}
+
+void GameWall::paintFrame()
+{
+	const auto& games = m_games;
+	for (GameWallWidget* widget : games)
+		widget->flush();
+	const auto& freeWidgets = m_gamesToRemove;
+	for (GameWallWidget* widget : freeWidgets)
+		widget->flush();
+}
+
 #include "gamewall.moc"
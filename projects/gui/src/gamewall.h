@@ -21,11 +21,19 @@
 #include <QDialog>
 #include <QMap>
 #include <QList>
+#include <QTimer>
 
 class ChessGame;
 class GameManager;
 class GameWallWidget;
 
+/*!
+ * \brief A wall of boards that shows all running games.
+ *
+ * The boards of the wall only repaint on a shared frame timer, so
+ * a move or a clock change in many games at once is painted in a
+ * single pass. Moves are animated only on the board under the mouse.
+ */
 class GameWall : public QWidget
 {
 	Q_OBJECT
@@ -38,11 +46,16 @@ class GameWall : public QWidget
 		void addGame(ChessGame* game);
 		void removeGame(ChessGame* game);
 
+	private slots:
+		void scheduleFrame();
+		void paintFrame();
+
 	private:
 		GameWallWidget* getFreeWidget();
 
 		QMap<ChessGame*, GameWallWidget*> m_games;
 		QList<GameWallWidget*> m_gamesToRemove;
+		QTimer m_frameTimer;
 };
 
 #endif // GAMEWALL_H
@@ -24,7 +24,7 @@
 ImportProgressDialog::ImportProgressDialog(PgnImporter* pgnImporter,
 					   QWidget* parent)
 	: QDialog(parent),
-	  m_lastUpdateSecs(0),
+	  m_lastUpdateMsecs(0),
 	  m_importError(false),
 	  ui(new Ui::ImportProgressDialog)
 {
@@ -57,23 +57,27 @@ ImportProgressDialog::~ImportProgressDialog()
 void ImportProgressDialog::updateImportStatus(const QTime& startTime,
                                              int numReadGames, qint64 numReadBytes)
 {
-	int elapsed = startTime.secsTo(QTime::currentTime());
-	if (elapsed == 0)
+	const int elapsed = startTime.msecsTo(QTime::currentTime());
+	if (elapsed <= 0 || numReadBytes <= 0)
 		return;
 
-	// Update the status once a second
-	if (elapsed <= m_lastUpdateSecs)
+	// Update the status a few times per second
+	if (elapsed < m_lastUpdateMsecs + 250)
 		return;
 
-	m_lastUpdateSecs = elapsed;
+	m_lastUpdateMsecs = elapsed;
 
 	ui->m_importProgressBar->setMinimum(0);
 	ui->m_importProgressBar->setMaximum(100);
 	ui->m_importProgressBar->setValue(int((double(numReadBytes) / m_totalFileSize) * 100));
 
-	int remainingSecs = (m_totalFileSize - numReadBytes) / (numReadBytes / elapsed);
+	const double seconds = elapsed / 1000.0;
+	const double bytesPerSec = numReadBytes / seconds;
+	int remainingSecs = int((m_totalFileSize - numReadBytes) / bytesPerSec);
 
-	ui->m_statusLabel->setText(QString(tr("%1 games/sec - %2")).arg((int)numReadGames / elapsed)
+	ui->m_statusLabel->setText(tr("%1 games/sec - %2 MB/sec - %3")
+	    .arg(int(numReadGames / seconds))
+	    .arg(bytesPerSec / (1024 * 1024), 0, 'f', 1)
 	    .arg(humaniseTime(remainingSecs)));
 }
 
@@ -50,7 +50,7 @@ class ImportProgressDialog : public QDialog
 	private:
 		QString humaniseTime(int sec);
 		qint64 m_totalFileSize;
-		int m_lastUpdateSecs;
+		int m_lastUpdateMsecs;
 		bool m_importError;
 		Ui::ImportProgressDialog* ui;
 };
@@ -42,6 +42,7 @@ int main(int argc, char* argv[])
 	QTranslator translator;
 	translator.load(QLocale(), "cutechess", "_", "translations", ".qm");
 	app.installTranslator(&translator);
+	app.traceStartup("translations");
 
 	QStringList arguments = app.arguments();
 	arguments.takeFirst(); // application name
@@ -63,6 +64,10 @@ int main(int argc, char* argv[])
 
 			return 0;
 		}
+		else if (arguments.first() == QLatin1String("--trace-startup"))
+		{
+			// Handled by CuteChessApplication
+		}
 		else
 		{
 			out << "Unknown argument: " << arguments.first() << endl;
@@ -54,6 +54,7 @@
 #include "gametabbar.h"
 #include "evalhistory.h"
 #include "evalwidget.h"
+#include "tablebaseannotator.h"
 #include "boardview/boardscene.h"
 #include "tournamentresultsdlg.h"
 
@@ -96,6 +97,7 @@ MainWindow::MainWindow(ChessGame* game)
 	m_evalHistory = new EvalHistory(this);
 	m_evalWidgets[0] = new EvalWidget(this);
 	m_evalWidgets[1] = new EvalWidget(this);
+	m_tbAnnotator = new TablebaseAnnotator(this);
 
 	QVBoxLayout* mainLayout = new QVBoxLayout();
 	mainLayout->addWidget(m_gameViewer);
@@ -120,6 +122,10 @@ MainWindow::MainWindow(ChessGame* game)
 		this, SLOT(editMoveComment(int, QString)));
 	connect(m_gameViewer, SIGNAL(moveSelected(int)),
 		m_moveList, SLOT(selectMove(int)));
+	connect(m_tbAnnotator, SIGNAL(annotated(int, QString)),
+		m_moveList, SLOT(setAnnotation(int, QString)));
+	connect(m_tbAnnotator, SIGNAL(scoreChanged(int, int)),
+		m_evalHistory, SLOT(addTablebaseScore(int, int)));
 
 	connect(CuteChessApplication::instance()->gameManager(),
 		SIGNAL(finished()), this, SLOT(onGameManagerFinished()),
@@ -539,8 +545,18 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 
 	m_engineDebugLog->clear();
 
+	QSettings s;
+	m_engineDebugLog->setMaximumLineCount(
+		s.value("ui/engine_debug_log_lines", 10000).toInt());
+	if (s.value("ui/hide_engine_info_lines", false).toBool())
+		m_engineDebugLog->setLineFilter(QRegExp("^<.*\\(\\d+\\): info "));
+	else
+		m_engineDebugLog->setLineFilter(QRegExp());
+
 	m_moveList->setGame(m_game, gameData.m_pgn);
 	m_evalHistory->setGame(m_game);
+	// Only the games that are viewed, not played, are annotated
+	m_tbAnnotator->setGame(m_game == nullptr ? gameData.m_pgn : nullptr);
 
 	if (m_game == nullptr)
 	{
@@ -578,7 +594,7 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 		m_players[i] = player;
 
 		connect(player, SIGNAL(debugMessage(QString)),
-			m_engineDebugLog, SLOT(appendPlainText(QString)));
+			m_engineDebugLog, SLOT(appendLine(QString)));
 
 		auto clock = m_gameViewer->chessClock(side);
 
@@ -765,6 +781,25 @@ void MainWindow::onGameFinished(ChessGame* game)
 			game->pgn()->write(fileName);
 			//TODO: reaction on error
 	}
+
+	if (!tab.m_tournament
+	&&  QSettings().value("ui/archive_finished_games", false).toBool())
+		archiveGame(tIndex);
+}
+
+void MainWindow::archiveGame(int index)
+{
+	TabData& tab = m_tabs[index];
+	ChessGame* game = tab.m_game;
+	Q_ASSERT(game != nullptr);
+
+	// The tab keeps only the PGN game, which the game viewer turns
+	// back into a board when the tab is shown. Deleting the game
+	// releases its board, players and thread slot.
+	tab.m_game = nullptr;
+	if (game == m_game)
+		setCurrentGame(tab);
+	game->deleteLater();
 }
 
 void MainWindow::newTournament()
@@ -781,8 +816,6 @@ void MainWindow::newTournament()
 		this, SLOT(onTournamentFinished()));
 	connect(t, SIGNAL(gameStarted(ChessGame*, int, int, int)),
 		this, SLOT(addGame(ChessGame*)));
-	connect(t, SIGNAL(gameFinished(ChessGame*, int, int, int)),
-		resultsDialog, SLOT(update()));
 	connect(t, SIGNAL(gameFinished(ChessGame*, int, int, int)),
 		this, SLOT(onGameFinished(ChessGame*)));
 	t->start();
@@ -945,6 +978,7 @@ void MainWindow::editMoveComment(int ply, const QString& comment)
 		PgnGame* pgn(m_tabs.at(m_tabBar->currentIndex()).m_pgn);
 		PgnGame::MoveData md(pgn->moves().at(ply));
 		md.comment = text;
+		md.eval = PgnGame::EvalData();
 		pgn->setMove(ply, md);
 		unlockCurrentGame();
 
@@ -41,6 +41,7 @@ class Tournament;
 class GameTabBar;
 class EvalHistory;
 class EvalWidget;
+class TablebaseAnnotator;
 
 /**
  * MainWindow
@@ -114,6 +115,7 @@ class MainWindow : public QMainWindow
 		bool askToSave();
 		void setCurrentGame(const TabData& gameData);
 		void removeGame(int index);
+		void archiveGame(int index);
 		int tabIndex(ChessGame* game) const;
 		int tabIndex(Tournament* tournament, bool freeTab = false) const;
 		void addDefaultWindowMenu();
@@ -158,6 +160,7 @@ class MainWindow : public QMainWindow
 
 		EvalHistory* m_evalHistory;
 		EvalWidget* m_evalWidgets[2];
+		TablebaseAnnotator* m_tbAnnotator;
 
 		QPointer<ChessGame> m_game;
 		QPointer<ChessPlayer> m_players[2];
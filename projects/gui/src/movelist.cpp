@@ -22,6 +22,7 @@
 #include <QTimer>
 #include <QKeyEvent>
 #include <chessgame.h>
+#include <algorithm>
 
 
 MoveList::MoveList(QWidget* parent)
@@ -31,7 +32,9 @@ MoveList::MoveList(QWidget* parent)
 	  m_startingSide(0),
 	  m_selectedMove(-1),
 	  m_moveToBeSelected(-1),
-	  m_selectionTimer(new QTimer(this))
+	  m_selectionTimer(new QTimer(this)),
+	  m_commentTimer(new QTimer(this)),
+	  m_pendingCommentCount(0)
 {
 	m_moveList = new QTextBrowser(this);
 	m_moveList->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -61,6 +64,17 @@ MoveList::MoveList(QWidget* parent)
 	connect(m_selectionTimer, SIGNAL(timeout()),
 		this, SLOT(selectChosenMove()));
 
+	m_commentTimer->setSingleShot(true);
+	m_commentTimer->setInterval(20);
+	connect(m_commentTimer, SIGNAL(timeout()),
+		this, SLOT(renderVisibleComments()));
+
+	QScrollBar* sb = m_moveList->verticalScrollBar();
+	connect(sb, SIGNAL(valueChanged(int)),
+		m_commentTimer, SLOT(start()));
+	connect(sb, SIGNAL(rangeChanged(int, int)),
+		m_commentTimer, SLOT(start()));
+
 	m_moveList->document()->setIndentWidth(18);
 
 	QTextCharFormat format(m_moveList->currentCharFormat());
@@ -75,10 +89,16 @@ void MoveList::insertMove(int ply,
 			  const QString& comment,
 			  QTextCursor cursor)
 {
+	// Comments are rendered later by renderVisibleComments(), so
+	// appending a move only adds its number and SAN string to the
+	// last block of the document
 	Move move = {
 		MoveNumberToken(ply, m_startingSide),
 		MoveToken(ply, san),
-		MoveCommentToken(ply, comment)
+		MoveCommentToken(ply, QString()),
+		comment,
+		comment,
+		QString()
 	};
 
 	bool editAsBlock = cursor.isNull();
@@ -91,14 +111,104 @@ void MoveList::insertMove(int ply,
 
 	move.number.insert(cursor);
 	move.move.insert(cursor);
-	move.comment.insert(cursor);
 
 	m_moves.append(move);
+	if (!comment.isEmpty())
+	{
+		m_pendingCommentCount++;
+		scheduleCommentRendering();
+	}
 
 	if (editAsBlock)
 		cursor.endEditBlock();
 }
 
+void MoveList::renderComment(int ply, const QString& comment)
+{
+	QTextCursor c(m_moveList->textCursor());
+	Move& move(m_moves[ply]);
+
+	// A comment that was never inserted goes right after its move
+	MoveCommentToken& commentToken(move.comment);
+	int oldLength = commentToken.length();
+	if (commentToken.position() == -1)
+		c.setPosition(move.move.position() + move.move.length());
+	else
+		commentToken.select(c);
+	commentToken.setValue(comment);
+	commentToken.insert(c);
+
+	int newLength = commentToken.length();
+	int diff = newLength - oldLength;
+	if (diff == 0)
+		return;
+
+	for (int i = ply + 1; i < m_moves.size(); i++)
+	{
+		m_moves[i].number.move(diff);
+		if (i == ply + 1)
+		{
+			MoveNumberToken& nextNumber(m_moves[i].number);
+			oldLength = nextNumber.length();
+			nextNumber.select(c);
+			nextNumber.insert(c);
+			newLength = nextNumber.length();
+			diff += (newLength - oldLength);
+		}
+		m_moves[i].move.move(diff);
+		m_moves[i].comment.move(diff);
+	}
+}
+
+void MoveList::scheduleCommentRendering()
+{
+	if (!m_commentTimer->isActive())
+		m_commentTimer->start();
+}
+
+void MoveList::renderVisibleComments()
+{
+	if (m_pendingCommentCount <= 0 || !m_moveList->isVisible())
+		return;
+
+	const QWidget* viewport = m_moveList->viewport();
+	const int first = m_moveList->cursorForPosition(QPoint(0, 0)).position();
+	const int last = m_moveList->cursorForPosition(
+		QPoint(viewport->width() - 1, viewport->height() - 1)).position();
+
+	// The moves are in document order, so the first visible one
+	// can be found with a binary search. A move's comment follows
+	// it, so the comment of the move before it may be visible too.
+	auto it = std::lower_bound(m_moves.constBegin(), m_moves.constEnd(), first,
+		[](const Move& move, int pos)
+		{
+			return move.move.position() + move.move.length() <= pos;
+		});
+	int ply = qMax(0, int(it - m_moves.constBegin()) - 1);
+
+	QScrollBar* sb = m_moveList->verticalScrollBar();
+	const bool atEnd = sb->value() == sb->maximum();
+
+	QTextCursor c(m_moveList->textCursor());
+	c.beginEditBlock();
+	for (; ply < m_moves.size(); ply++)
+	{
+		if (m_moves.at(ply).move.position() > last)
+			break;
+		if (m_moves.at(ply).pendingComment.isEmpty())
+			continue;
+
+		const QString comment(m_moves.at(ply).pendingComment);
+		m_moves[ply].pendingComment.clear();
+		m_pendingCommentCount--;
+		renderComment(ply, comment);
+	}
+	c.endEditBlock();
+
+	if (atEnd)
+		sb->setValue(sb->maximum());
+}
+
 void MoveList::setGame(ChessGame* game, PgnGame* pgn)
 {
 	if (m_game != nullptr)
@@ -116,6 +226,8 @@ void MoveList::setGame(ChessGame* game, PgnGame* pgn)
 	m_selectedMove = -1;
 	m_moveToBeSelected = -1;
 	m_selectionTimer->stop();
+	m_commentTimer->stop();
+	m_pendingCommentCount = 0;
 
 	QTextCursor cursor(m_moveList->textCursor());
 	cursor.beginEditBlock();
@@ -123,9 +235,12 @@ void MoveList::setGame(ChessGame* game, PgnGame* pgn)
 
 	m_startingSide = pgn->startingSide();
 	m_moveCount = 0;
+	const QStringList comments(pgn->comments());
 	for (const PgnGame::MoveData& md : pgn->moves())
 	{
-		insertMove(m_moveCount++, md.moveString, md.comment, cursor);
+		insertMove(m_moveCount, md.moveString, comments.at(m_moveCount),
+			   cursor);
+		m_moveCount++;
 	}
 	cursor.endEditBlock();
 
@@ -147,7 +262,9 @@ bool MoveList::eventFilter(QObject* obj, QEvent* event)
 {
 	if (obj == m_moveList)
 	{
-		if (event->type() == QEvent::KeyPress)
+		if (event->type() == QEvent::Show)
+			scheduleCommentRendering();
+		else if (event->type() == QEvent::KeyPress)
 		{
 			QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
 			int index = m_moveToBeSelected;
@@ -203,34 +320,48 @@ void MoveList::setMove(int ply,
 	Q_UNUSED(sanString);
 	Q_ASSERT(ply < m_moves.size());
 
-	QTextCursor c(m_moveList->textCursor());
-
-	MoveCommentToken& commentToken(m_moves[ply].comment);
-	int oldLength = commentToken.length();
-	commentToken.setValue(comment);
-	commentToken.select(c);
-	commentToken.insert(c);
+	m_moves[ply].text = comment;
+	updateComment(ply);
+}
 
-	int newLength = commentToken.length();
-	int diff = newLength - oldLength;
-	if (diff == 0)
+void MoveList::setAnnotation(int ply, const QString& annotation)
+{
+	if (ply < 0 || ply >= m_moves.size()
+	||  m_moves.at(ply).annotation == annotation)
 		return;
 
-	for (int i = ply + 1; i < m_moves.size(); i++)
+	m_moves[ply].annotation = annotation;
+	updateComment(ply);
+}
+
+void MoveList::updateComment(int ply)
+{
+	Move& moveData(m_moves[ply]);
+	QString comment(moveData.text);
+	if (!moveData.annotation.isEmpty())
 	{
-		m_moves[i].number.move(diff);
-		if (i == ply + 1)
-		{
-			MoveNumberToken& nextNumber(m_moves[i].number);
-			oldLength = nextNumber.length();
-			nextNumber.select(c);
-			nextNumber.insert(c);
-			newLength = nextNumber.length();
-			diff += (newLength - oldLength);
-		}
-		m_moves[i].move.move(diff);
-		m_moves[i].comment.move(diff);
+		if (!comment.isEmpty())
+			comment += ' ';
+		comment += moveData.annotation;
 	}
+
+	// A comment that's still waiting to be rendered is just replaced
+	if (!moveData.pendingComment.isEmpty())
+	{
+		moveData.pendingComment = comment;
+		if (comment.isEmpty())
+			m_pendingCommentCount--;
+		return;
+	}
+	if (moveData.comment.position() == -1 && !comment.isEmpty())
+	{
+		moveData.pendingComment = comment;
+		m_pendingCommentCount++;
+		scheduleCommentRendering();
+		return;
+	}
+
+	renderComment(ply, comment);
 }
 
 void MoveList::selectChosenMove()
@@ -292,7 +423,7 @@ void MoveList::onLinkClicked(const QUrl& url)
 	}
 	else if (url.scheme() == "comment")
 	{
-		emit commentClicked(ply, move.comment.toString());
+		emit commentClicked(ply, move.text);
 		return;
 	}
 	else
@@ -66,6 +66,12 @@ class MoveList : public QWidget
 			     const Chess::GenericMove& move,
 			     const QString& sanString,
 			     const QString& comment);
+		/*!
+		 * Shows \a annotation after the comment of the move at
+		 * \a ply. The annotation isn't part of the comment, so
+		 * it's not edited or saved with it.
+		 */
+		void setAnnotation(int ply, const QString& annotation);
 
 	signals:
 		/*! Emitted when the user clicks move \a num. */
@@ -83,6 +89,7 @@ class MoveList : public QWidget
 				const QString& comment);
 		void onLinkClicked(const QUrl& url);
 		void selectChosenMove();
+		void renderVisibleComments();
 
 	private:
 		struct Move
@@ -90,12 +97,24 @@ class MoveList : public QWidget
 			MoveNumberToken number;
 			MoveToken move;
 			MoveCommentToken comment;
+			/*!
+			 * A comment that hasn't been rendered yet because
+			 * the move hasn't been visible in the viewport.
+			 */
+			QString pendingComment;
+			/*! The move's own comment, without the annotation. */
+			QString text;
+			/*! An annotation shown after the comment. */
+			QString annotation;
 		};
 
 		void insertMove(int ply,
 				const QString& san,
 				const QString& comment,
 				QTextCursor cursor = QTextCursor());
+		void renderComment(int ply, const QString& comment);
+		void updateComment(int ply);
+		void scheduleCommentRendering();
 
 		QTextBrowser* m_moveList;
 		QPointer<ChessGame> m_game;
@@ -106,6 +125,8 @@ class MoveList : public QWidget
 		int m_moveToBeSelected;
 		QTextCharFormat m_defaultTextFormat;
 		QTimer* m_selectionTimer;
+		QTimer* m_commentTimer;
+		int m_pendingCommentCount;
 };
 
 #endif // MOVE_LIST_H
@@ -126,7 +126,6 @@ ChessGame* NewGameDialog::createGame() const
 	if (book)
 	{
 		int depth = ui->m_gameSettings->bookDepth();
-		game->setBookOwnership(true);
 
 		for (int i = 0; i < 2; i++)
 		{
@@ -272,7 +272,6 @@ Tournament* NewTournamentDialog::createTournament(GameManager* gameManager) cons
 	t->setOpeningSuite(ui->m_gameSettings->openingSuite());
 	t->setOpeningDepth(ui->m_gameSettings->openingSuiteDepth());
 
-	t->setOpeningBookOwnership(true);
 	auto book = ui->m_gameSettings->openingBook();
 	int bookDepth = ui->m_gameSettings->bookDepth();
 
@@ -17,10 +17,17 @@
 
 #include "pgndatabase.h"
 #include <pgnstream.h>
+#include <pgntagpool.h>
+#include <pgnentryindex.h>
 #include <QFileInfo>
+#include <QCryptographicHash>
+#include "cutechessapp.h"
 
 PgnDatabase::PgnDatabase(const QString& fileName, QObject* parent)
 	: QObject(parent),
+	  m_tagPool(nullptr),
+	  m_entryIndex(nullptr),
+	  m_loaded(false),
 	  m_fileName(fileName),
 	  m_displayName(QFileInfo(fileName).completeBaseName())
 {
@@ -29,12 +36,15 @@ PgnDatabase::PgnDatabase(const QString& fileName, QObject* parent)
 PgnDatabase::~PgnDatabase()
 {
 	qDeleteAll(m_entries);
+	delete m_tagPool;
+	delete m_entryIndex;
 }
 
 void PgnDatabase::setEntries(const QList<const PgnGameEntry*>& entries)
 {
 	qDeleteAll(m_entries);
 	m_entries = entries;
+	m_loaded = true;
 }
 
 QList<const PgnGameEntry*> PgnDatabase::entries() const
@@ -42,11 +52,89 @@ QList<const PgnGameEntry*> PgnDatabase::entries() const
 	return m_entries;
 }
 
+void PgnDatabase::setTagPool(PgnTagPool* tagPool)
+{
+	if (tagPool != m_tagPool)
+		delete m_tagPool;
+	m_tagPool = tagPool;
+}
+
+void PgnDatabase::setEntryIndex(PgnEntryIndex* index)
+{
+	if (index != m_entryIndex)
+		delete m_entryIndex;
+	m_entryIndex = index;
+	if (index != nullptr)
+		m_loaded = true;
+}
+
+const PgnEntryIndex* PgnDatabase::entryIndex() const
+{
+	return m_entryIndex;
+}
+
+bool PgnDatabase::isLoaded() const
+{
+	return m_loaded;
+}
+
+bool PgnDatabase::load(int entryIndexThreshold)
+{
+	if (m_loaded)
+		return true;
+
+	PgnEntryIndex* index = new PgnEntryIndex;
+	if (!index->open(entryIndexFileName(), m_fileName))
+	{
+		delete index;
+		return false;
+	}
+
+	if (entryIndexThreshold > 0 && index->count() >= entryIndexThreshold)
+	{
+		setEntryIndex(index);
+		return true;
+	}
+
+	PgnTagPool* tagPool = new PgnTagPool;
+	setEntries(index->entries(tagPool));
+	setTagPool(tagPool);
+	delete index;
+
+	return true;
+}
+
 QString PgnDatabase::fileName() const
 {
 	return m_fileName;
 }
 
+QString PgnDatabase::configFileName(const QString& dirName,
+				   const QString& suffix) const
+{
+	const QByteArray hash(QCryptographicHash::hash(
+		QFileInfo(m_fileName).absoluteFilePath().toUtf8(),
+		QCryptographicHash::Sha1).toHex());
+
+	return CuteChessApplication::instance()->configPath()
+		+ '/' + dirName + '/' + QString::fromLatin1(hash) + suffix;
+}
+
+QString PgnDatabase::positionIndexFileName() const
+{
+	return configFileName("positions", ".cpi");
+}
+
+QString PgnDatabase::openingTreeFileName() const
+{
+	return configFileName("openings", ".cot");
+}
+
+QString PgnDatabase::entryIndexFileName() const
+{
+	return configFileName("entries", ".cei");
+}
+
 PgnDatabase::Status PgnDatabase::status() const
 {
 	QFileInfo info(m_fileName);
@@ -85,6 +173,14 @@ PgnDatabase::Status PgnDatabase::game(const PgnGameEntry* entry,
 				      PgnGame* game)
 {
 	Q_ASSERT(entry != nullptr);
+
+	return this->game(entry->pos(), entry->lineNumber(), game);
+}
+
+PgnDatabase::Status PgnDatabase::game(qint64 pos,
+				      qint64 lineNumber,
+				      PgnGame* game)
+{
 	Q_ASSERT(game != nullptr);
 
 	Status status = this->status();
@@ -96,7 +192,7 @@ PgnDatabase::Status PgnDatabase::game(const PgnGameEntry* entry,
 		return Unreadable;
 
 	PgnStream in(&file);
-	if (!in.seek(entry->pos(), entry->lineNumber()) || !game->read(in))
+	if (!in.seek(pos, lineNumber) || !game->read(in))
 		return Corrupted;
 
 	return Ok;
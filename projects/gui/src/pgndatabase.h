@@ -25,6 +25,8 @@
 #include <pgngame.h>
 #include <pgngameentry.h>
 class PgnStream;
+class PgnTagPool;
+class PgnEntryIndex;
 
 /*!
  * \brief PGN database
@@ -73,8 +75,70 @@ class PgnDatabase : public QObject
 		 */
 		QList<const PgnGameEntry*> entries() const;
 
+		/*!
+		 * Sets the pool that stores the tag values of the game
+		 * entries to \a tagPool.
+		 *
+		 * The database takes ownership of \a tagPool, and the
+		 * entries must not outlive it.
+		 */
+		void setTagPool(PgnTagPool* tagPool);
+
+		/*!
+		 * Sets the mapped index of the games in this database to
+		 * \a index.
+		 *
+		 * A database that has an entry index doesn't need to keep
+		 * its game entries in memory; entries() can be empty, and
+		 * the games are read with the positions in the index.
+		 *
+		 * The database takes ownership of \a index.
+		 */
+		void setEntryIndex(PgnEntryIndex* index);
+		/*!
+		 * Returns the mapped index of the games in this database,
+		 * or 0 if the games are only in entries().
+		 */
+		const PgnEntryIndex* entryIndex() const;
+
+		/*!
+		 * Returns true if the game entries or the entry index of
+		 * this database are loaded.
+		 */
+		bool isLoaded() const;
+		/*!
+		 * Loads the games of this database from its entry index
+		 * file if they're not loaded yet.
+		 *
+		 * If the index has fewer than \a entryIndexThreshold games,
+		 * or if \a entryIndexThreshold is zero, the games are read
+		 * into entries() and the file is closed. Otherwise the index
+		 * stays mapped as entryIndex().
+		 *
+		 * Returns false if the index file can't be opened.
+		 */
+		bool load(int entryIndexThreshold);
+
 		/*! Returns the file name of this database. */
 		QString fileName() const;
+		/*!
+		 * Returns the name of the PositionIndex file of this
+		 * database. The file is in the configuration directory,
+		 * and it may not exist.
+		 */
+		QString positionIndexFileName() const;
+		/*!
+		 * Returns the name of the OpeningTree file of this
+		 * database. The file is in the configuration directory,
+		 * and it may not exist.
+		 */
+		QString openingTreeFileName() const;
+		/*!
+		 * Returns the name of the PgnEntryIndex file of this
+		 * database. The file is in the configuration directory,
+		 * and it may not exist.
+		 */
+		QString entryIndexFileName() const;
 
 		/*! Returns the current status of this database. */
 		Status status() const;
@@ -119,9 +183,22 @@ class PgnDatabase : public QObject
 		 * \note \a game must be allocated by the caller and must not be NULL.
 		 */
 		Status game(const PgnGameEntry* entry, PgnGame* game);
+		/*!
+		 * Reads \a game from the database, starting at stream
+		 * position \a pos and line number \a lineNumber.
+		 *
+		 * \note \a game must be allocated by the caller and must not be NULL.
+		 */
+		Status game(qint64 pos, qint64 lineNumber, PgnGame* game);
 
 	private:
+		QString configFileName(const QString& dirName,
+				       const QString& suffix) const;
+
 		QList<const PgnGameEntry*> m_entries;
+		PgnTagPool* m_tagPool;
+		PgnEntryIndex* m_entryIndex;
+		bool m_loaded;
 		QDateTime m_lastModified;
 		QString m_fileName;
 		QString m_displayName;
@@ -0,0 +1,185 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnentryindexmodel.h"
+#include <pgnentryindex.h>
+
+namespace {
+
+const int s_columnCount = 7;
+
+} // anonymous namespace
+
+PgnEntryIndexModel::PgnEntryIndexModel(QObject* parent)
+	: QAbstractItemModel(parent),
+	  m_index(nullptr),
+	  m_entryCount(0),
+	  m_sortColumn(-1),
+	  m_sortOrder(Qt::AscendingOrder),
+	  m_rows(4096)
+{
+}
+
+void PgnEntryIndexModel::setIndex(const PgnEntryIndex* index)
+{
+	beginResetModel();
+	m_index = index;
+	m_entryCount = 0;
+	m_rows.clear();
+	endResetModel();
+
+	fetchMore(QModelIndex());
+}
+
+int PgnEntryIndexModel::indexRow(int row) const
+{
+	Q_ASSERT(m_index != nullptr);
+
+	if (m_sortColumn < 0)
+		return row;
+	if (m_sortOrder == Qt::DescendingOrder)
+		row = m_index->count() - 1 - row;
+
+	return m_index->sortedRow(PgnGameEntry::TagType(m_sortColumn), row);
+}
+
+QModelIndex PgnEntryIndexModel::index(int row, int column,
+				      const QModelIndex& parent) const
+{
+	if (!hasIndex(row, column, parent))
+		return QModelIndex();
+
+	return createIndex(row, column);
+}
+
+QModelIndex PgnEntryIndexModel::parent(const QModelIndex& index) const
+{
+	Q_UNUSED(index);
+
+	return QModelIndex();
+}
+
+int PgnEntryIndexModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return m_entryCount;
+}
+
+int PgnEntryIndexModel::columnCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return s_columnCount;
+}
+
+QVariant PgnEntryIndexModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid())
+		return QVariant();
+
+	if (index.row() >= m_entryCount || index.row() < 0)
+		return QVariant();
+
+	if (role == Qt::DisplayRole || role == Qt::EditRole)
+	{
+		// The cache is keyed by the row in the index, so it
+		// stays valid when the model is sorted
+		const int row = indexRow(index.row());
+		QStringList* tags = m_rows.object(row);
+		if (tags == nullptr)
+		{
+			tags = new QStringList;
+			for (int i = 0; i < s_columnCount; i++)
+				tags->append(m_index->tagValue(row,
+					PgnGameEntry::TagType(i)));
+			m_rows.insert(row, tags);
+		}
+
+		return tags->at(index.column());
+	}
+
+	return QVariant();
+}
+
+QVariant PgnEntryIndexModel::headerData(int section,
+					Qt::Orientation orientation,
+					int role) const
+{
+	if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
+	{
+		switch (section)
+		{
+		case 0:
+			return tr("Event");
+		case 1:
+			return tr("Site");
+		case 2:
+			return tr("Date");
+		case 3:
+			return tr("Round");
+		case 4:
+			return tr("White");
+		case 5:
+			return tr("Black");
+		case 6:
+			return tr("Result");
+		default:
+			return QVariant();
+		}
+	}
+
+	return QVariant();
+}
+
+void PgnEntryIndexModel::sort(int column, Qt::SortOrder order)
+{
+	if (m_index == nullptr || column >= s_columnCount)
+		return;
+
+	// The fetched rows stay fetched, they just show other games
+	beginResetModel();
+	m_sortColumn = column;
+	m_sortOrder = order;
+	endResetModel();
+}
+
+bool PgnEntryIndexModel::canFetchMore(const QModelIndex& parent) const
+{
+	Q_UNUSED(parent);
+
+	return m_index != nullptr && m_entryCount < m_index->count();
+}
+
+void PgnEntryIndexModel::fetchMore(const QModelIndex& parent)
+{
+	Q_UNUSED(parent);
+
+	if (m_index == nullptr)
+		return;
+
+	int remainder = m_index->count() - m_entryCount;
+	int entriesToFetch = qMin(1024, remainder);
+	if (entriesToFetch <= 0)
+		return;
+
+	beginInsertRows(QModelIndex(), m_entryCount, m_entryCount + entriesToFetch - 1);
+	m_entryCount += entriesToFetch;
+	endInsertRows();
+}
@@ -0,0 +1,81 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGN_ENTRY_INDEX_MODEL_H
+#define PGN_ENTRY_INDEX_MODEL_H
+
+#include <QAbstractItemModel>
+#include <QCache>
+#include <QStringList>
+class PgnEntryIndex;
+
+/*!
+ * \brief Supplies the games of a PgnEntryIndex to views.
+ *
+ * The model is meant for databases with millions of games. Rows
+ * are fetched into the model on demand, the tags of recently viewed
+ * rows are cached, and sorting uses the sort orders stored in the
+ * index. The memory used by the model depends on the rows that are
+ * viewed, not on the size of the database.
+ */
+class PgnEntryIndexModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+	public:
+		/*! Constructs an empty model with the given \a parent. */
+		PgnEntryIndexModel(QObject* parent = nullptr);
+
+		/*!
+		 * Associates \a index with this model. The sort order of
+		 * the model is kept.
+		 *
+		 * \note \a index must stay open while the model uses it.
+		 */
+		void setIndex(const PgnEntryIndex* index);
+		/*!
+		 * Returns the row in the index that corresponds to
+		 * \a row in the model.
+		 */
+		int indexRow(int row) const;
+
+		// Inherited from QAbstractItemModel
+		virtual QModelIndex index(int row, int column,
+					  const QModelIndex& parent = QModelIndex()) const;
+		virtual QModelIndex parent(const QModelIndex& index) const;
+		virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+		virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+		virtual QVariant data(const QModelIndex& index, int role) const;
+		virtual QVariant headerData(int section, Qt::Orientation orientation,
+					    int role = Qt::DisplayRole) const;
+		virtual void sort(int column,
+				  Qt::SortOrder order = Qt::AscendingOrder);
+
+	protected:
+		// Inherited from QAbstractItemModel
+		virtual bool canFetchMore(const QModelIndex& parent) const;
+		virtual void fetchMore(const QModelIndex& parent);
+
+	private:
+		const PgnEntryIndex* m_index;
+		int m_entryCount;
+		int m_sortColumn;
+		Qt::SortOrder m_sortOrder;
+		mutable QCache<int, QStringList> m_rows;
+};
+
+#endif // PGN_ENTRY_INDEX_MODEL_H
@@ -16,94 +16,195 @@
 */
 
 #include "pgngameentrymodel.h"
-#include <QtConcurrentFilter>
+#include <QtConcurrentMap>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
 #include <pgngameentry.h>
+#include <pgntagpool.h>
 
+namespace {
 
-struct EntryContains
+/*
+ * Creates the tag matchers of a filter for each tag pool when
+ * they're first needed by a filtering thread. This keeps the
+ * pool lookups off the GUI thread.
+ */
+class TagMatcherCache
+{
+	public:
+		explicit TagMatcherCache(const PgnGameFilter& filter)
+			: m_filter(filter) {}
+
+		PgnTagMatcher matcher(const PgnTagPool* pool)
+		{
+			QMutexLocker locker(&m_mutex);
+
+			auto it = m_matchers.constFind(pool);
+			if (it == m_matchers.constEnd())
+				it = m_matchers.insert(pool,
+					PgnTagMatcher(m_filter, *pool));
+			return it.value();
+		}
+
+	private:
+		PgnGameFilter m_filter;
+		QMutex m_mutex;
+		QHash<const PgnTagPool*, PgnTagMatcher> m_matchers;
+};
+
+} // anonymous namespace
+
+struct PgnGameEntryModel::ChunkFilter
 {
-	EntryContains(const QList<const PgnGameEntry*>& entries,
-		      const PgnGameFilter& filter)
-		: m_entries(entries), m_filter(filter) { }
+	ChunkFilter(const QList<const PgnGameEntry*>& entries,
+		    const PgnGameFilter& filter,
+		    const QBitArray& sourceMask)
+		: m_entries(entries),
+		  m_sourceMask(sourceMask),
+		  m_matchers(new TagMatcherCache(filter)) { }
 
-	typedef bool result_type;
+	typedef QVector<int> result_type;
 
-	inline bool operator()(int index)
+	QVector<int> operator()(const Chunk& chunk)
 	{
-		return m_entries.at(index)->match(m_filter);
+		QVector<int> matches;
+		const PgnTagMatcher matcher(
+			m_matchers->matcher(m_entries.at(chunk.begin)->tagPool()));
+
+		for (int i = chunk.begin; i < chunk.end; i++)
+		{
+			if (!m_sourceMask.isNull()
+			&&  (i >= m_sourceMask.size() || !m_sourceMask.testBit(i)))
+				continue;
+			if (m_entries.at(i)->match(matcher))
+				matches.append(i);
+		}
+
+		return matches;
 	}
 
 	const QList<const PgnGameEntry*>& m_entries;
-	PgnGameFilter m_filter;
+	QBitArray m_sourceMask;
+	QSharedPointer<TagMatcherCache> m_matchers;
 };
 
 
 PgnGameEntryModel::PgnGameEntryModel(QObject* parent)
 	: QAbstractItemModel(parent),
+	  m_nextChunk(0),
 	  m_entryCount(0)
 {
 	connect(&m_watcher, SIGNAL(resultsReadyAt(int,int)),
 		this, SLOT(onResultsReady()));
 }
 
+PgnGameEntryModel::~PgnGameEntryModel()
+{
+	// The filtering threads use the entry list of this model
+	m_watcher.cancel();
+	m_watcher.waitForFinished();
+}
+
 const PgnGameEntry* PgnGameEntryModel::entryAt(int row) const
 {
-	return m_entries.at(m_filtered.resultAt(row));
+	return m_entries.at(m_matches.at(row));
 }
 
 int PgnGameEntryModel::sourceIndex(int row) const
 {
-	return m_filtered.resultAt(row);
+	return m_matches.at(row);
+}
+
+QVector<int> PgnGameEntryModel::sourceIndexes() const
+{
+	return m_matches;
+}
+
+const PgnGameEntry* PgnGameEntryModel::sourceEntry(int index) const
+{
+	return m_entries.at(index);
 }
 
 int PgnGameEntryModel::entryCount() const
 {
-	return m_filtered.resultCount();
+	return m_matches.size();
+}
+
+bool PgnGameEntryModel::isFiltering() const
+{
+	return m_watcher.isRunning();
 }
 
 void PgnGameEntryModel::setEntries(const QList<const PgnGameEntry*>& entries)
 {
+	static const int chunkSize = 4096;
+
 	m_watcher.cancel();
 	m_watcher.waitForFinished();
 
 	m_entries = entries;
 
-	if (entries.size() > m_indexes.size())
+	// Split the entries into chunks that don't cross tag pools
+	m_chunks.clear();
+	int begin = 0;
+	for (int i = 1; i <= entries.size(); i++)
 	{
-		m_indexes.reserve(entries.size());
-		for (int i = m_indexes.size(); i < entries.size(); i++)
-			m_indexes.append(i);
+		if (i == entries.size() || i - begin >= chunkSize
+		||  entries.at(i)->tagPool() != entries.at(begin)->tagPool())
+		{
+			Chunk chunk = { begin, i };
+			m_chunks.append(chunk);
+			begin = i;
+		}
 	}
 
-	applyFilter(m_filter);
+	m_sourceMask = QBitArray();
+	applyFilter();
 }
 
 void PgnGameEntryModel::onResultsReady()
 {
-	if (m_entryCount < 1024)
+	// Chunks can finish out of order, but their matches are
+	// added in order
+	const int oldCount = m_matches.size();
+	while (m_nextChunk < m_chunks.size()
+	&&     m_filtered.isResultReadyAt(m_nextChunk))
+		m_matches += m_filtered.resultAt(m_nextChunk++);
+
+	if (m_matches.size() != oldCount && m_entryCount < 1024)
 		fetchMore(QModelIndex());
 }
 
-void PgnGameEntryModel::applyFilter(const PgnGameFilter& filter)
+void PgnGameEntryModel::applyFilter()
 {
 	beginResetModel();
 	m_entryCount = 0;
+	m_nextChunk = 0;
+	m_matches.clear();
 
-	m_filtered = QtConcurrent::filtered(m_indexes.constBegin(),
-					    m_indexes.constBegin() + m_entries.size(),
-					    EntryContains(m_entries, filter));
+	m_filtered = QtConcurrent::mapped(m_chunks,
+					  ChunkFilter(m_entries, m_filter,
+						      m_sourceMask));
 
 	m_watcher.setFuture(m_filtered);
 	endResetModel();
 }
 
-void PgnGameEntryModel::setFilter(const PgnGameFilter& filter)
+void PgnGameEntryModel::setFilter(const PgnGameFilter& filter,
+				  const QBitArray& sourceMask)
 {
 	m_watcher.cancel();
 	m_watcher.waitForFinished();
 
 	m_filter = filter;
-	applyFilter(filter);
+	m_sourceMask = sourceMask;
+	applyFilter();
+}
+
+void PgnGameEntryModel::cancelFilter()
+{
+	m_watcher.cancel();
 }
 
 QModelIndex PgnGameEntryModel::index(int row, int column,
@@ -127,7 +228,7 @@ int PgnGameEntryModel::rowCount(const QModelIndex& parent) const
 	if (parent.isValid())
 		return 0;
 
-	return qMin(m_entryCount, m_filtered.resultCount());
+	return m_entryCount;
 }
 
 int PgnGameEntryModel::columnCount(const QModelIndex& parent) const
@@ -143,7 +244,7 @@ QVariant PgnGameEntryModel::data(const QModelIndex& index, int role) const
 	if (!index.isValid())
 		return QVariant();
 
-	if (index.row() >= m_filtered.resultCount() || index.row() < 0)
+	if (index.row() >= m_entryCount || index.row() < 0)
 		return QVariant();
 
 	if (role == Qt::DisplayRole || role == Qt::EditRole)
@@ -188,14 +289,14 @@ bool PgnGameEntryModel::canFetchMore(const QModelIndex& parent) const
 {
 	Q_UNUSED(parent);
 
-	return m_entryCount < m_filtered.resultCount();
+	return m_entryCount < m_matches.size();
 }
 
 void PgnGameEntryModel::fetchMore(const QModelIndex& parent)
 {
 	Q_UNUSED(parent);
 
-	int remainder = m_filtered.resultCount() - m_entryCount;
+	int remainder = m_matches.size() - m_entryCount;
 	int entriesToFetch = qMin(1024, remainder);
 	if (entriesToFetch <= 0)
 		return;
@@ -20,6 +20,8 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QVector>
+#include <QBitArray>
 #include <QFuture>
 #include <QFutureWatcher>
 #include <pgngamefilter.h>
@@ -27,6 +29,11 @@ class PgnGameEntry;
 
 /*!
  * \brief Supplies PGN game entry information to views.
+ *
+ * The entries are filtered in chunks on the global thread pool.
+ * Matching entries are added to the model as soon as their chunk is
+ * done, and changing the filter or the entries cancels the current
+ * search.
  */
 class PgnGameEntryModel : public QAbstractItemModel
 {
@@ -35,6 +42,8 @@ class PgnGameEntryModel : public QAbstractItemModel
 	public:
 		/*! Constructs a PGN game entry model with the given \a parent. */
 		PgnGameEntryModel(QObject* parent = nullptr);
+		/*! Cancels filtering and destroys the model. */
+		virtual ~PgnGameEntryModel();
 
 		/*! Returns the PGN entry at \a row. */
 		const PgnGameEntry* entryAt(int row) const;
@@ -43,14 +52,28 @@ class PgnGameEntryModel : public QAbstractItemModel
 		 * current filter.
 		 *
 		 * \note Unlike rowCount() this method also includes entries that are
-		 * not yet fetched into the model.
+		 * not yet fetched into the model. While the filter is
+		 * still running the count grows.
 		 */
 		int entryCount() const;
+		/*! Returns true if the entries are still being filtered. */
+		bool isFiltering() const;
 		/*!
 		 * Returns the index in the source data that corresponds to
 		 * \a row in the model.
 		 */
 		int sourceIndex(int row) const;
+		/*!
+		 * Returns the source indexes of the entries that have
+		 * matched the filter so far, including entries that are not
+		 * yet fetched into the model.
+		 *
+		 * The returned vector is a snapshot that can be used in
+		 * another thread while the filter is still running.
+		 */
+		QVector<int> sourceIndexes() const;
+		/*! Returns the PGN entry at \a index in the source data. */
+		const PgnGameEntry* sourceEntry(int index) const;
 		/*! Associates a list of PGN game entries with this model. */
 		void setEntries(const QList<const PgnGameEntry*>& entries);
 
@@ -65,8 +88,20 @@ class PgnGameEntryModel : public QAbstractItemModel
 					    int role = Qt::DisplayRole) const;
 
 	public slots:
-		/*! Sets the filter for filtering the contents of the database. */
-		void setFilter(const PgnGameFilter& filter);
+		/*!
+		 * Sets the filter for filtering the contents of the database.
+		 *
+		 * If \a sourceMask is not null, only the source entries whose
+		 * bits are set in it can match. Setting new entries removes
+		 * the mask.
+		 */
+		void setFilter(const PgnGameFilter& filter,
+			       const QBitArray& sourceMask = QBitArray());
+		/*!
+		 * Stops filtering. The entries that matched so far
+		 * stay in the model.
+		 */
+		void cancelFilter();
 
 	protected:
 		// Inherited from QAbstractItemModel
@@ -77,14 +112,26 @@ class PgnGameEntryModel : public QAbstractItemModel
 		void onResultsReady();
 
 	private:
-		void applyFilter(const PgnGameFilter& filter);
+		/*! A range of entries that share a tag pool. */
+		struct Chunk
+		{
+			int begin;
+			int end;
+		};
+
+		struct ChunkFilter;
+
+		void applyFilter();
 
 		QList<const PgnGameEntry*> m_entries;
-		QVector<int> m_indexes;
+		QVector<Chunk> m_chunks;
+		QVector<int> m_matches;
+		int m_nextChunk;
 		int m_entryCount;
-		QFuture<int> m_filtered;
-		QFutureWatcher<int> m_watcher;
+		QFuture<QVector<int>> m_filtered;
+		QFutureWatcher<QVector<int>> m_watcher;
 		PgnGameFilter m_filter;
+		QBitArray m_sourceMask;
 };
 
 #endif // PGN_GAME_ENTRY_MODEL_H
@@ -17,16 +17,30 @@
 
 #include "pgnimporter.h"
 
+#include <climits>
+#include <limits>
+#include <QAtomicInteger>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 
+#include <pgnindexer.h>
 #include <pgnstream.h>
+#include <pgngame.h>
 #include <pgngameentry.h>
+#include <pgntagpool.h>
+#include <pgnentryindex.h>
+#include <positionindex.h>
+#include <openingtree.h>
+#include <board/board.h>
 #include "pgndatabase.h"
 
 PgnImporter::PgnImporter(const QString& fileName)
 	: Worker(QString("PGN import: %1").arg(fileName)),
-	  m_fileName(fileName)
+	  m_fileName(fileName),
+	  m_positionIndexEnabled(false),
+	  m_entryIndexThreshold(0)
 {
 }
 
@@ -35,12 +49,22 @@ QString PgnImporter::fileName() const
 	return m_fileName;
 }
 
+void PgnImporter::setPositionIndexEnabled(bool enabled)
+{
+	m_positionIndexEnabled = enabled;
+}
+
+void PgnImporter::setEntryIndexThreshold(int gameCount)
+{
+	m_entryIndexThreshold = gameCount;
+}
+
 void PgnImporter::work()
 {
 	QFile file(m_fileName);
 	QFileInfo fileInfo(m_fileName);
-	static const int updateInterval = 1024;
-	int numReadGames = 0;
+	// Progress is reported a few times per second at most
+	static const qint64 updateInterval = 250;
 
 	if (!fileInfo.exists())
 	{
@@ -54,26 +78,149 @@ void PgnImporter::work()
 		return;
 	}
 
-	PgnStream pgnStream(&file);
-	QList<const PgnGameEntry*> games;
+	// All chunks share one pool, so each distinct tag value
+	// is stored only once in the database
+	PgnTagPool* tagPool = new PgnTagPool;
+	QAtomicInt numReadGames(0);
+	QAtomicInteger<qint64> numReadBytes(0);
+	QAtomicInteger<qint64> nextUpdate(updateInterval);
+	QElapsedTimer timer;
+	timer.start();
+	auto readGames = [&](PgnStream& stream,
+			     const PgnIndexer::Chunk& chunk,
+			     QList<const PgnGameEntry*>& games)
+	{
+		qint64 lastPos = chunk.begin;
+		forever
+		{
+			PgnGameEntry* game = new PgnGameEntry(tagPool);
+			if (cancelRequested() || !game->read(stream)
+			||  game->pos() >= chunk.end)
+			{
+				delete game;
+				break;
+			}
+
+			games << game;
+
+			const qint64 pos = stream.pos();
+			const qint64 bytes = numReadBytes.fetchAndAddRelaxed(
+				pos - lastPos) + pos - lastPos;
+			lastPos = pos;
+
+			// Only one thread reports each update
+			const int count = numReadGames.fetchAndAddRelaxed(1) + 1;
+			if (count % 64 != 0)
+				continue;
+			const qint64 now = timer.elapsed();
+			const qint64 next = nextUpdate.load();
+			if (now >= next
+			&&  nextUpdate.testAndSetOrdered(next, now + updateInterval))
+				emit databaseReadStatus(startTime(), count, bytes);
+		}
+	};
+
+	// The position index and the opening tree need the moves, so
+	// the games are read again after their tags
+	PositionIndexWriter positions;
+	OpeningTreeWriter openings;
+	auto indexGames = [&](PgnStream& stream,
+			      const QList<const PgnGameEntry*>& entries,
+			      int firstGame)
+	{
+		PgnGame game;
+		for (int i = 0; i < entries.size(); i++)
+		{
+			const PgnGameEntry* entry = entries.at(i);
+			if (cancelRequested())
+				break;
+			if (!stream.seek(entry->pos(), entry->lineNumber()))
+				continue;
+
+			game.read(stream, INT_MAX - 1, false);
+			const quint64 finalKey = stream.board()->key();
+			positions.addGame(quint32(firstGame + i), game, finalKey);
+			openings.addGame(game, finalKey);
+		}
+	};
 
-	forever
+	QList<const PgnGameEntry*> games;
+	PgnIndexer indexer(&file);
+	if (indexer.isValid())
 	{
-		PgnGameEntry* game = new PgnGameEntry;
-		if (cancelRequested() || !game->read(pgnStream))
+		const auto chunks = indexer.chunks();
+		QVector<QList<const PgnGameEntry*>> chunkGames(chunks.size());
+		indexer.scan(chunks, [&](PgnStream& stream,
+					 const PgnIndexer::Chunk& chunk,
+					 int index)
+		{
+			readGames(stream, chunk, chunkGames[index]);
+		});
+
+		QVector<int> firstGames;
+		for (const auto& list : chunkGames)
 		{
-			delete game;
-			break;
+			firstGames.append(games.size());
+			games += list;
 		}
 
-		games << game;
-		numReadGames++;
+		if (m_positionIndexEnabled && !cancelRequested())
+		{
+			indexer.scan(chunks, [&](PgnStream& stream,
+						 const PgnIndexer::Chunk& chunk,
+						 int index)
+			{
+				Q_UNUSED(chunk);
+				indexGames(stream, chunkGames.at(index),
+					   firstGames.at(index));
+			});
+		}
+	}
+	else
+	{
+		PgnStream pgnStream(&file);
+		const PgnIndexer::Chunk all =
+			{ 0, std::numeric_limits<qint64>::max(), 1 };
+		readGames(pgnStream, all, games);
 
-		if (numReadGames % updateInterval == 0)
-			emit databaseReadStatus(startTime(), numReadGames,
-			    pgnStream.pos());
+		if (m_positionIndexEnabled && !cancelRequested())
+			indexGames(pgnStream, games, 0);
 	}
+
 	PgnDatabase* db = new PgnDatabase(m_fileName);
+	if (m_positionIndexEnabled && !cancelRequested())
+	{
+		const QString indexFileName(db->positionIndexFileName());
+		QDir().mkpath(QFileInfo(indexFileName).absolutePath());
+		positions.write(indexFileName, m_fileName);
+
+		const QString treeFileName(db->openingTreeFileName());
+		QDir().mkpath(QFileInfo(treeFileName).absolutePath());
+		openings.write(treeFileName, m_fileName);
+	}
+
+	// The entry index is where GameDatabaseManager stores the
+	// entries between sessions. Huge databases are also viewed
+	// through it, so their entries don't have to stay in memory.
+	const QString indexFileName(db->entryIndexFileName());
+	QDir().mkpath(QFileInfo(indexFileName).absolutePath());
+	if (PgnEntryIndex::write(indexFileName, games, m_fileName)
+	&&  m_entryIndexThreshold > 0 && games.size() >= m_entryIndexThreshold)
+	{
+		PgnEntryIndex* index = new PgnEntryIndex;
+		if (index->open(indexFileName, m_fileName))
+		{
+			db->setEntryIndex(index);
+			qDeleteAll(games);
+			games.clear();
+			delete tagPool;
+			tagPool = nullptr;
+		}
+		else
+			delete index;
+	}
+
+	db->setTagPool(tagPool);
 	db->setEntries(games);
 	db->setLastModified(fileInfo.lastModified());
 
@@ -46,6 +46,24 @@ class PgnImporter : public Worker
 		PgnImporter(const QString& fileName);
 		/*! Returns the file name of the database to be imported. */
 		QString fileName() const;
+		/*!
+		 * If \a enabled is true, a PositionIndex and an OpeningTree
+		 * of the games are built after the tags are read. The
+		 * default is false.
+		 *
+		 * \sa PgnDatabase::positionIndexFileName(),
+		 * PgnDatabase::openingTreeFileName()
+		 */
+		void setPositionIndexEnabled(bool enabled);
+		/*!
+		 * Sets the number of games from which the game entries are
+		 * kept in a mapped PgnEntryIndex instead of memory to
+		 * \a gameCount. Zero, the default, keeps all the entries
+		 * in memory. The index file is written in either case.
+		 *
+		 * \sa PgnDatabase::entryIndexFileName()
+		 */
+		void setEntryIndexThreshold(int gameCount);
 
 	protected:
 		void work() override;
@@ -54,7 +72,9 @@ class PgnImporter : public Worker
 		/*! Emitted when \a database is read. */
 		void databaseRead(PgnDatabase* database);
 		/*!
-		 * Emitted periodically to give progress information about the import.
+		 * Emitted a few times per second to give progress information
+		 * about the import. The signal can be emitted from any of the
+		 * threads that read the database.
 		 *
 		 * The import was initiated at \a started and so far \a numReadGames games
 		 * and \a numReadBytes bytes have been read.
@@ -63,6 +83,8 @@ class PgnImporter : public Worker
 
 	private:
 		QString m_fileName;
+		bool m_positionIndexEnabled;
+		int m_entryIndexThreshold;
 
 };
 
@@ -38,6 +38,11 @@ int PgnToken::length() const
 	return m_end - m_begin;
 }
 
+int PgnToken::position() const
+{
+	return m_begin;
+}
+
 void PgnToken::insert(QTextCursor& cursor)
 {
 	if (isEmpty())
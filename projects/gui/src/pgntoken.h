@@ -40,6 +40,11 @@ class PgnToken
 		bool isEmpty() const;
 		/*! Returns the token's length. */
 		int length() const;
+		/*!
+		 * Returns the token's position in the document, or -1 if
+		 * the token hasn't been inserted.
+		 */
+		int position() const;
 		/*! Returns the token as a string. */
 		virtual QString toString() const = 0;
 		/*!
@@ -22,18 +22,137 @@
 #include <QFileInfo>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QTemporaryFile>
+#include <QTextBlock>
 #include <QTextStream>
 
 PlainTextLog::PlainTextLog(QWidget* parent)
-	: QPlainTextEdit(parent)
+	: QPlainTextEdit(parent),
+	  m_spillFile(nullptr)
 {
-	setReadOnly(true);
+	init();
 }
 
 PlainTextLog::PlainTextLog(const QString& text, QWidget* parent)
-	: QPlainTextEdit(text, parent)
+	: QPlainTextEdit(text, parent),
+	  m_spillFile(nullptr)
+{
+	init();
+}
+
+PlainTextLog::~PlainTextLog()
+{
+	delete m_spillFile;
+}
+
+void PlainTextLog::init()
 {
 	setReadOnly(true);
+
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(100);
+	connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+void PlainTextLog::setMaximumLineCount(int count)
+{
+	flush();
+
+	// Lines that don't fit under the new limit are spilled first
+	const int lineCount = document()->isEmpty() ? 0 : document()->blockCount();
+	if (count > 0 && lineCount > count)
+	{
+		QString spilled;
+		QTextBlock block = document()->begin();
+		for (int i = 0; i < lineCount - count; i++)
+		{
+			spilled += block.text() + '\n';
+			block = block.next();
+		}
+		spill(spilled);
+	}
+
+	setMaximumBlockCount(count);
+}
+
+void PlainTextLog::setLineFilter(const QRegExp& filter)
+{
+	m_filter = filter;
+}
+
+void PlainTextLog::appendLine(const QString& line)
+{
+	if (!m_filter.isEmpty() && m_filter.indexIn(line) != -1)
+		return;
+
+	m_pending.append(line);
+	if (!m_flushTimer.isActive())
+		m_flushTimer.start();
+}
+
+void PlainTextLog::flush()
+{
+	m_flushTimer.stop();
+	if (m_pending.isEmpty())
+		return;
+
+	// The document drops its first lines when it grows over the
+	// limit, so they are copied to the spill file first. Queued
+	// lines that wouldn't fit at all go straight to the file.
+	const int maxLineCount = maximumBlockCount();
+	if (maxLineCount > 0)
+	{
+		const int lineCount = document()->isEmpty() ? 0 : document()->blockCount();
+		int overflow = lineCount + m_pending.size() - maxLineCount;
+
+		QString spilled;
+		QTextBlock block = document()->begin();
+		for (int i = 0; i < qMin(lineCount, overflow); i++)
+		{
+			spilled += block.text() + '\n';
+			block = block.next();
+		}
+
+		overflow -= lineCount;
+		for (int i = 0; i < overflow; i++)
+			spilled += m_pending.at(i) + '\n';
+		if (overflow > 0)
+			m_pending.erase(m_pending.begin(), m_pending.begin() + overflow);
+
+		if (!spilled.isEmpty())
+			spill(spilled);
+	}
+
+	appendPlainText(m_pending.join('\n'));
+	m_pending.clear();
+}
+
+void PlainTextLog::spill(const QString& text)
+{
+	if (m_spillFile == nullptr)
+	{
+		m_spillFile = new QTemporaryFile;
+		if (!m_spillFile->open())
+		{
+			qWarning("Can't open a spill file for the log");
+			delete m_spillFile;
+			m_spillFile = nullptr;
+			return;
+		}
+	}
+
+	// Same encoding as the QTextStream in saveLogToFile()
+	m_spillFile->write(text.toLocal8Bit());
+}
+
+void PlainTextLog::clear()
+{
+	m_pending.clear();
+	m_flushTimer.stop();
+	delete m_spillFile;
+	m_spillFile = nullptr;
+
+	QPlainTextEdit::clear();
 }
 
 void PlainTextLog::contextMenuEvent(QContextMenuEvent* event)
@@ -108,6 +227,17 @@ void PlainTextLog::saveLogToFile(const QString& fileName)
 		return;
 	}
 
+	flush();
+
+	// The spilled lines come before the ones in the document
+	if (m_spillFile != nullptr)
+	{
+		m_spillFile->seek(0);
+		while (!m_spillFile->atEnd())
+			file.write(m_spillFile->read(64 * 1024));
+		m_spillFile->seek(m_spillFile->size());
+	}
+
 	QTextStream out(&file);
 	out << toPlainText();
 }
@@ -19,12 +19,21 @@
 #define PLAIN_TEXT_LOG_H
 
 #include <QPlainTextEdit>
+#include <QRegExp>
+#include <QStringList>
+#include <QTimer>
 
 class QContextMenuEvent;
 class QAction;
+class QTemporaryFile;
 
 /*!
  * \brief Widget that is used to display log messages in plain text.
+ *
+ * Lines added with appendLine() are queued and added to the document
+ * in batches a few times per second. The document can be limited to
+ * a maximum number of lines; older lines are moved to a temporary
+ * spill file, and they are included when the log is saved.
  */
 class PlainTextLog : public QPlainTextEdit
 {
@@ -38,8 +47,25 @@ class PlainTextLog : public QPlainTextEdit
 		 * given \a parent.
 		 */
 		PlainTextLog(const QString& text, QWidget* parent = nullptr);
+		/*! Destroys the log and its spill file. */
+		virtual ~PlainTextLog();
+
+		/*!
+		 * Sets the maximum number of lines shown in the log to
+		 * \a count. Zero, the default, means no limit.
+		 */
+		void setMaximumLineCount(int count);
+		/*!
+		 * Sets a filter for appendLine(). Lines that match
+		 * \a filter are dropped. An empty filter keeps all lines.
+		 */
+		void setLineFilter(const QRegExp& filter);
 
 	public slots:
+		/*! Queues \a line to be added to the end of the log. */
+		void appendLine(const QString& line);
+		/*! Clears the log, the queued lines and the spill file. */
+		void clear();
 		/*! Save the log to file \a filename. */
 		void saveLogToFile(const QString& fileName);
 
@@ -47,6 +73,17 @@ class PlainTextLog : public QPlainTextEdit
 		// Inherited from QPlainTextEdit
 		virtual void contextMenuEvent(QContextMenuEvent* event);
 
+	private slots:
+		void flush();
+
+	private:
+		void init();
+		void spill(const QString& text);
+
+		QStringList m_pending;
+		QTimer m_flushTimer;
+		QRegExp m_filter;
+		QTemporaryFile* m_spillFile;
 };
 
 #endif // PLAIN_TEXT_LOG_H
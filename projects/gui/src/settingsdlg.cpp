@@ -43,6 +43,12 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 		QSettings().setValue("ui/close_unused_initial_tab", checked);
 	});
 
+	connect(ui->m_archiveFinishedGamesCheck, &QCheckBox::toggled,
+		this, [=](bool checked)
+	{
+		QSettings().setValue("ui/archive_finished_games", checked);
+	});
+
 	connect(ui->m_useFullUserNameCheck, &QCheckBox::toggled,
 		this, [=](bool checked)
 	{
@@ -74,6 +80,30 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 		QSettings().setValue("games/default_pgn_output_file", defaultPgnFile);
 	});
 
+	connect(ui->m_positionIndexCheck, &QCheckBox::toggled,
+		this, [=](bool checked)
+	{
+		QSettings().setValue("games/position_index", checked);
+	});
+
+	connect(ui->m_rawPgnExportCheck, &QCheckBox::toggled,
+		this, [=](bool checked)
+	{
+		QSettings().setValue("games/raw_pgn_export", checked);
+	});
+
+	connect(ui->m_engineDebugLogLinesSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+		this, [=](int value)
+	{
+		QSettings().setValue("ui/engine_debug_log_lines", value);
+	});
+
+	connect(ui->m_hideEngineInfoLinesCheck, &QCheckBox::toggled,
+		this, [=](bool checked)
+	{
+		QSettings().setValue("ui/hide_engine_info_lines", checked);
+	});
+
 	connect(ui->m_tournamentDefaultPgnOutFileEdit, &QLineEdit::textChanged,
 		[=](const QString& tourFile)
 	{
@@ -190,6 +220,12 @@ void SettingsDialog::readSettings()
 	ui->m_playersSidesOnClocksCheck->setChecked(
 		s.value("display_players_sides_on_clocks", false).toBool());
 	ui->m_tbPathEdit->setText(s.value("tb_path").toString());
+	ui->m_engineDebugLogLinesSpin->setValue(
+		s.value("engine_debug_log_lines", 10000).toInt());
+	ui->m_hideEngineInfoLinesCheck->setChecked(
+		s.value("hide_engine_info_lines", false).toBool());
+	ui->m_archiveFinishedGamesCheck->setChecked(
+		s.value("archive_finished_games", false).toBool());
 	s.endGroup();
 
 	s.beginGroup("pgn");
@@ -199,6 +235,10 @@ void SettingsDialog::readSettings()
 	s.beginGroup("games");
 	ui->m_defaultPgnOutFileEdit
 		->setText(s.value("default_pgn_output_file").toString());
+	ui->m_positionIndexCheck->setChecked(
+		s.value("position_index", false).toBool());
+	ui->m_rawPgnExportCheck->setChecked(
+		s.value("raw_pgn_export", false).toBool());
 	s.endGroup();
 
 	s.beginGroup("tournament");
@@ -14,6 +14,7 @@ HEADERS += $$PWD/chessclock.h \
     $$PWD/importprogressdlg.h \
     $$PWD/pgndatabase.h \
     $$PWD/pgngameentrymodel.h \
+    $$PWD/pgnentryindexmodel.h \
     $$PWD/pgndatabasemodel.h \
     $$PWD/engineoptiondelegate.h \
     $$PWD/engineoptionmodel.h \
@@ -40,8 +41,10 @@ HEADERS += $$PWD/chessclock.h \
     $$PWD/settingsdlg.h \
     $$PWD/enginemanagementwidget.h \
     $$PWD/tournamentresultsdlg.h \
+    $$PWD/tournamentresultsmodel.h \
     $$PWD/gamesettingswidget.h \
-    $$PWD/tournamentsettingswidget.h
+    $$PWD/tournamentsettingswidget.h \
+    $$PWD/tablebaseannotator.h
 SOURCES += $$PWD/main.cpp \
     $$PWD/chessclock.cpp \
     $$PWD/engineconfigurationmodel.cpp \
@@ -57,6 +60,7 @@ SOURCES += $$PWD/main.cpp \
     $$PWD/importprogressdlg.cpp \
     $$PWD/pgndatabase.cpp \
     $$PWD/pgngameentrymodel.cpp \
+    $$PWD/pgnentryindexmodel.cpp \
     $$PWD/pgndatabasemodel.cpp \
     $$PWD/engineoptiondelegate.cpp \
     $$PWD/engineoptionmodel.cpp \
@@ -83,5 +87,7 @@ SOURCES += $$PWD/main.cpp \
     $$PWD/settingsdlg.cpp \
     $$PWD/enginemanagementwidget.cpp \
     $$PWD/tournamentresultsdlg.cpp \
+    $$PWD/tournamentresultsmodel.cpp \
     $$PWD/gamesettingswidget.cpp \
-    $$PWD/tournamentsettingswidget.cpp
+    $$PWD/tournamentsettingswidget.cpp \
+    $$PWD/tablebaseannotator.cpp
@@ -0,0 +1,170 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tablebaseannotator.h"
+#include <QPair>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QVector>
+#include <pgngame.h>
+#include <board/board.h>
+#include <board/boardsnapshot.h>
+#include <board/syzygytablebase.h>
+
+namespace {
+
+// The score of a tablebase win in centipawns, above the evaluations
+// that are usually plotted so that the wins stand out
+const int s_winScore = 1000;
+
+} // anonymous namespace
+
+class TablebaseAnnotationTask : public Worker
+{
+	Q_OBJECT
+
+	public:
+		TablebaseAnnotationTask(int generation,
+					Chess::Board* board,
+					const QVector<Chess::GenericMove>& moves)
+			: Worker(TablebaseAnnotator::tr("Tablebase annotation")),
+			  m_generation(generation),
+			  m_board(board),
+			  m_moves(moves)
+		{
+		}
+
+	signals:
+		void probed(int generation, int ply, const QString& text, int score);
+
+	protected:
+		virtual void work()
+		{
+			QVector< QPair<int, Chess::BoardSnapshot> > wins;
+
+			for (int ply = 0; ply < m_moves.size(); ply++)
+			{
+				if (cancelRequested())
+					return;
+
+				const Chess::Move move(m_board->moveFromGenericMove(m_moves.at(ply)));
+				if (move.isNull())
+					break;
+				m_board->makeMove(move);
+
+				const Chess::Result result(m_board->tablebaseResult());
+				if (result.isNone())
+					continue;
+				report(ply, result, -1);
+				if (!result.isDraw())
+					wins.append(qMakePair(ply, m_board->snapshot()));
+			}
+
+			// The DTZ probes are slower and serialized between
+			// threads, so they come after all the WDL results
+			for (const auto& win : wins)
+			{
+				if (cancelRequested())
+					return;
+				if (!m_board->restore(win.second))
+					continue;
+
+				unsigned int dtz = 0;
+				const Chess::Result result(m_board->tablebaseResult(&dtz));
+				if (!result.isNone())
+					report(win.first, result, int(dtz));
+			}
+		}
+
+	private:
+		void report(int ply, const Chess::Result& result, int dtz)
+		{
+			QString text(TablebaseAnnotator::tr("TB %1")
+				     .arg(result.toShortString()));
+			if (dtz >= 0 && !result.isDraw())
+				text += TablebaseAnnotator::tr(", DTZ %1").arg(dtz);
+
+			int score = 0;
+			if (result.winner() == Chess::Side::White)
+				score = s_winScore;
+			else if (result.winner() == Chess::Side::Black)
+				score = -s_winScore;
+
+			emit probed(m_generation, ply, text, score);
+		}
+
+		int m_generation;
+		QScopedPointer<Chess::Board> m_board;
+		QVector<Chess::GenericMove> m_moves;
+};
+
+
+TablebaseAnnotator::TablebaseAnnotator(QObject* parent)
+	: QObject(parent),
+	  m_generation(0)
+{
+	// Otherwise the tablebases are only initialized for new games
+	const QString path(QSettings().value("ui/tb_path").toString());
+	if (!path.isEmpty() && !SyzygyTablebase::tbAvailable(3))
+		SyzygyTablebase::initialize(path);
+}
+
+TablebaseAnnotator::~TablebaseAnnotator()
+{
+	m_cancelToken.cancel();
+}
+
+void TablebaseAnnotator::setGame(const PgnGame* pgn)
+{
+	m_cancelToken.cancel();
+	m_generation++;
+
+	if (pgn == nullptr
+	||  pgn->moves().isEmpty()
+	||  !SyzygyTablebase::tbAvailable(3))
+		return;
+
+	Chess::Board* board = pgn->createBoard();
+	if (board == nullptr)
+		return;
+
+	QVector<Chess::GenericMove> moves;
+	moves.reserve(pgn->moves().size());
+	for (const PgnGame::MoveData& md : pgn->moves())
+		moves.append(md.move);
+
+	auto task = new TablebaseAnnotationTask(m_generation, board, moves);
+	task->setPriority(Worker::BackgroundPriority);
+	m_cancelToken = task->cancelToken();
+	connect(task, SIGNAL(probed(int, int, QString, int)),
+		this, SLOT(onProbed(int, int, QString, int)));
+	task->start();
+}
+
+void TablebaseAnnotator::onProbed(int generation,
+				  int ply,
+				  const QString& text,
+				  int score)
+{
+	if (generation != m_generation)
+		return;
+
+	emit annotated(ply, text);
+	emit scoreChanged(ply, score);
+}
+
+#include "tablebaseannotator.moc"
@@ -0,0 +1,78 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TABLEBASEANNOTATOR_H
+#define TABLEBASEANNOTATOR_H
+
+#include <QObject>
+#include <worker.h>
+class PgnGame;
+
+/*!
+ * \brief Annotates the moves of a viewed game with tablebase results
+ *
+ * TablebaseAnnotator replays a game in the background and probes every
+ * position that is in the tablebases' range. The thread-safe WDL tables
+ * are probed first, and the DTZ tables of the won positions after that,
+ * because DTZ probes are serialized between threads. The probes go
+ * through the shared probe cache.
+ *
+ * Each result is reported with the annotated() and scoreChanged()
+ * signals as soon as it's available, so even a long game never blocks
+ * the viewer. Results from a game that was replaced by setGame() are
+ * discarded.
+ */
+class TablebaseAnnotator : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*!
+		 * Creates a new annotator. The tablebases are initialized
+		 * from the user's settings if that hasn't been done yet.
+		 */
+		explicit TablebaseAnnotator(QObject* parent = nullptr);
+		/*! Cancels the annotation and destroys the annotator. */
+		virtual ~TablebaseAnnotator();
+
+		/*!
+		 * Starts annotating \a pgn and cancels the previous game.
+		 * A null \a pgn only cancels the previous game.
+		 */
+		void setGame(const PgnGame* pgn);
+
+	signals:
+		/*!
+		 * Emitted when the position after move \a ply has been
+		 * probed. \a text is the annotation, eg. "TB 1-0, DTZ 23".
+		 */
+		void annotated(int ply, const QString& text);
+		/*!
+		 * Emitted with the score of the position after move \a ply,
+		 * in centipawns from white's point of view.
+		 */
+		void scoreChanged(int ply, int score);
+
+	private slots:
+		void onProbed(int generation, int ply, const QString& text, int score);
+
+	private:
+		CancelToken m_cancelToken;
+		int m_generation;
+};
+
+#endif // TABLEBASEANNOTATOR_H
@@ -23,8 +23,7 @@ ThreadedTask::ThreadedTask(const QString& title,
 			   int minimum,
 			   int maximum,
 			   QWidget* parent)
-	: QThread(parent),
-	  m_cancel(false),
+	: Worker(title),
 	  m_statusMessage(labelText),
 	  m_taskStart(QTime::currentTime())
 {
@@ -40,6 +39,10 @@ ThreadedTask::ThreadedTask(const QString& title,
 
 	m_lastUpdate = 0;
 
+	// The task lives in the GUI thread, so it's destroyed there
+	// once the pool is done with it
+	setAutoDelete(false);
+	connect(this, SIGNAL(started()), this, SLOT(onStarted()));
 	connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
 	connect(this, SIGNAL(destroyed()), m_dlg, SLOT(deleteLater()));
 	connect(this, SIGNAL(progressValueChanged(int)),
@@ -53,14 +56,11 @@ ThreadedTask::~ThreadedTask()
 {
 }
 
-void ThreadedTask::cancel()
+void ThreadedTask::onStarted()
 {
-	m_cancel = true;
-}
-
-bool ThreadedTask::cancelRequested() const
-{
-	return m_cancel;
+	// The task may have waited in the pool's queue
+	m_taskStart = QTime::currentTime();
+	m_lastUpdate = 0;
 }
 
 void ThreadedTask::updateProgress(int value)
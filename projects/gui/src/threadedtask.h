@@ -18,28 +18,29 @@
 #ifndef THREADEDTASK_H
 #define THREADEDTASK_H
 
-#include <QThread>
 #include <QTime>
+#include <worker.h>
 class QWidget;
 class QProgressDialog;
 
 /*!
- * \brief A long task that is executed in its own thread.
+ * \brief A long task with a progress dialog.
  *
  * ThreadedTask is the base class for tasks that can take a long
- * time and should be executed in a separate thread. ThreadedTask
+ * time and should be executed in the background. ThreadedTask
  * automatically creates a progress dialog with a "cancel" button
- * for the task.
+ * for the task. The task is run by the shared Worker thread pool
+ * when start() is called.
  *
  * The ThreadedTask class should be extended by reimplementing
- * QThread::run() and checking for cancellation by calling
+ * Worker::work() and checking for cancellation by calling
  * cancelRequested() periodically. The subclass should also notify
  * the progress dialog by emitting the progressValueChanged() signal.
  *
  * ThreadedTask destroys itself and the progress dialog automatically
  * after the task is finished or cancelled.
  */
-class ThreadedTask : public QThread
+class ThreadedTask : public Worker
 {
 	Q_OBJECT
 
@@ -63,7 +64,7 @@ class ThreadedTask : public QThread
 
 	signals:
 		/*!
-		 * The reimplementation of QThread::run() should emit this
+		 * The reimplementation of Worker::work() should emit this
 		 * signal periodically to keep the progress dialog informed
 		 * of progress.
 		 */
@@ -75,15 +76,6 @@ class ThreadedTask : public QThread
 		void statusMessageChanged(const QString& message);
 
 	protected:
-		/*!
-		 * Returns true if the user had pressed the "cancel" button
-		 * on the progress dialog; otherwise returns false.
-		 *
-		 * The reimplementation of QThread::run() should check this
-		 * value periodically and return if cancel was requested.
-		 */
-		bool cancelRequested() const;
-
 		/*!
 		 * Returns human-readable version of the given time \a
 		 * sec.
@@ -91,16 +83,11 @@ class ThreadedTask : public QThread
 		QString humaniseTime(int sec) const;
 	
 	private slots:
-		// Yes, QThread subclasses shouldn't normally have slots
-		// because they're executed in the wrong thread. But in this
-		// case it doesn't matter because we're just setting a flag.
-		void cancel();
-
+		void onStarted();
 		void updateProgress(int value);
 		void setStatusMessage(const QString& msg);
 
 	private:
-		bool m_cancel;
 		QString m_statusMessage;
 		QTime m_taskStart;
 		int m_lastUpdate;
@@ -22,14 +22,43 @@
 #include <QPlainTextEdit>
 #include <QBoxLayout>
 #include <QFont>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSplitter>
+#include <QTableView>
+#include <QTimer>
 
 #include <tournament.h>
+#include "tournamentresultsmodel.h"
+
+namespace {
+
+// The minimum interval between rating and report updates
+const int s_updateInterval = 1000;
+
+} // anonymous namespace
 
 TournamentResultsDialog::TournamentResultsDialog(QWidget* parent)
-	: QDialog(parent)
+	: QDialog(parent),
+	  m_resultsModel(new TournamentResultsModel(this)),
+	  m_progressLabel(new QLabel(this)),
+	  m_updateTimer(new QTimer(this)),
+	  m_reportPending(false)
 {
 	setWindowTitle(tr("Tournament Results"));
 
+	m_updateTimer->setSingleShot(true);
+	m_updateTimer->setInterval(s_updateInterval);
+	connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(updateReport()));
+
+	auto resultsView = new QTableView(this);
+	resultsView->setModel(m_resultsModel);
+	resultsView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	resultsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+	resultsView->verticalHeader()->hide();
+	resultsView->horizontalHeader()->setSectionResizeMode(
+		TournamentResultsModel::NameColumn, QHeaderView::Stretch);
+
 	m_resultsEdit = new QPlainTextEdit(this);
 	m_resultsEdit->setReadOnly(true);
 
@@ -38,12 +67,17 @@ TournamentResultsDialog::TournamentResultsDialog(QWidget* parent)
 	font.setPointSize(font.pointSize() - 1);
 	m_resultsEdit->document()->setDefaultFont(font);
 
+	auto splitter = new QSplitter(Qt::Vertical, this);
+	splitter->addWidget(resultsView);
+	splitter->addWidget(m_resultsEdit);
+
 	auto layout = new QBoxLayout(QBoxLayout::TopToBottom);
-	layout->addWidget(m_resultsEdit);
+	layout->addWidget(splitter);
+	layout->addWidget(m_progressLabel);
 	layout->setContentsMargins(0, 0, 0, 0);
 
 	setLayout(layout);
-	resize(700, 400);
+	resize(700, 500);
 }
 
 TournamentResultsDialog::~TournamentResultsDialog()
@@ -52,14 +86,74 @@ TournamentResultsDialog::~TournamentResultsDialog()
 
 void TournamentResultsDialog::setTournament(Tournament* tournament)
 {
+	if (m_tournament)
+		m_tournament->disconnect(this);
+	m_tournament = tournament;
+	m_updateTimer->stop();
+
 	setWindowTitle(tournament->name());
-	m_resultsEdit->setPlainText(tournament->results());
+	m_resultsModel->setTournament(tournament);
+	connect(tournament, SIGNAL(gameFinished(ChessGame*, int, int, int)),
+		this, SLOT(onGameFinished(ChessGame*, int, int, int)));
+	connect(tournament, SIGNAL(finished()), this, SLOT(update()));
+	update();
 }
 
 void TournamentResultsDialog::update()
 {
-	auto tournament = qobject_cast<Tournament*>(QObject::sender());
-	Q_ASSERT(tournament != nullptr);
+	m_updateTimer->stop();
+	updateReport();
+}
+
+void TournamentResultsDialog::showEvent(QShowEvent* event)
+{
+	QDialog::showEvent(event);
+	if (m_reportPending)
+		update();
+}
+
+void TournamentResultsDialog::onGameFinished(ChessGame* game,
+					     int number,
+					     int whiteIndex,
+					     int blackIndex)
+{
+	Q_UNUSED(game);
+	Q_UNUSED(number);
+
+	// The standings of the two players are cheap to refresh; the
+	// ratings and the full report are rebuilt by the timer
+	m_resultsModel->updatePlayer(whiteIndex);
+	m_resultsModel->updatePlayer(blackIndex);
+	updateProgress();
+
+	if (!m_updateTimer->isActive())
+		m_updateTimer->start();
+}
+
+void TournamentResultsDialog::updateProgress()
+{
+	if (!m_tournament)
+		return;
+
+	m_progressLabel->setText(tr("%1 of %2 games finished.")
+		.arg(m_tournament->finishedGameCount())
+		.arg(m_tournament->finalGameCount()));
+}
+
+void TournamentResultsDialog::updateReport()
+{
+	m_resultsModel->updateRatings();
+	updateProgress();
+
+	// Nobody sees the report while the dialog is hidden
+	if (!isVisible() || !m_tournament)
+	{
+		m_reportPending = !m_tournament.isNull();
+		return;
+	}
+	m_reportPending = false;
+
+	auto tournament = m_tournament.data();
 	QString text;
 
 	// A quick fix, copied from the CLI side.
@@ -81,8 +175,5 @@ void TournamentResultsDialog::update()
 	}
 
 	text += tournament->results();
-	text += tr("\n\n%1 of %2 games finished.")
-		.arg(tournament->finishedGameCount())
-		.arg(tournament->finalGameCount());
 	m_resultsEdit->setPlainText(text);
 }
@@ -19,9 +19,14 @@
 #define TOURNAMENTRESULTSDLG_H
 
 #include <QDialog>
+#include <QPointer>
 
 class QPlainTextEdit;
+class QLabel;
+class QTimer;
+class ChessGame;
 class Tournament;
+class TournamentResultsModel;
 
 class TournamentResultsDialog : public QDialog
 {
@@ -32,14 +37,38 @@ class TournamentResultsDialog : public QDialog
 	    TournamentResultsDialog(QWidget* parent = nullptr);
 	    virtual ~TournamentResultsDialog();
 
-	    /*! Sets \a tournament as the current tournament. */
+	    /*!
+	     * Sets \a tournament as the current tournament.
+	     *
+	     * The standings are updated as the tournament's games
+	     * finish.
+	     */
 	    void setTournament(Tournament* tournament);
 
 	public slots:
+		/*! Updates the results right away. */
 		void update();
 
+	protected:
+		// Inherited from QDialog
+		virtual void showEvent(QShowEvent* event);
+
+	private slots:
+		void onGameFinished(ChessGame* game,
+				    int number,
+				    int whiteIndex,
+				    int blackIndex);
+		void updateReport();
+
 	private:
+		void updateProgress();
+
+		QPointer<Tournament> m_tournament;
+		TournamentResultsModel* m_resultsModel;
+		QLabel* m_progressLabel;
 		QPlainTextEdit* m_resultsEdit;
+		QTimer* m_updateTimer;
+		bool m_reportPending;
 };
 
 #endif // TOURNAMENTRESULTSDLG_H
@@ -0,0 +1,198 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tournamentresultsmodel.h"
+
+#include <cmath>
+#include <limits>
+
+#include <tournament.h>
+#include <elo.h>
+
+TournamentResultsModel::TournamentResultsModel(QObject* parent)
+	: QAbstractItemModel(parent),
+	  m_tournament(nullptr)
+{
+}
+
+void TournamentResultsModel::setTournament(Tournament* tournament)
+{
+	beginResetModel();
+	m_tournament = tournament;
+	m_rows.clear();
+	if (tournament != nullptr)
+	{
+		m_rows.resize(tournament->playerCount());
+		for (int i = 0; i < m_rows.size(); i++)
+			readPlayer(i, m_rows[i]);
+	}
+	endResetModel();
+
+	updateRatings();
+}
+
+void TournamentResultsModel::readPlayer(int index, Row& row) const
+{
+	const TournamentPlayer& player = m_tournament->playerAt(index);
+	row.name = player.name();
+	row.wins = player.wins();
+	row.losses = player.losses();
+	row.draws = player.draws();
+	row.score = player.score();
+	row.dirty = true;
+}
+
+void TournamentResultsModel::updatePlayer(int index)
+{
+	if (m_tournament == nullptr || index < 0 || index >= m_rows.size())
+		return;
+
+	readPlayer(index, m_rows[index]);
+	emit dataChanged(this->index(index, NameColumn),
+			 this->index(index, ScoreColumn));
+}
+
+void TournamentResultsModel::updateRatings()
+{
+	for (int i = 0; i < m_rows.size(); i++)
+	{
+		Row& row = m_rows[i];
+		if (!row.dirty)
+			continue;
+
+		row.dirty = false;
+		if (row.wins + row.losses + row.draws == 0)
+		{
+			row.elo = std::numeric_limits<qreal>::quiet_NaN();
+			row.error = row.elo;
+		}
+		else
+		{
+			Elo elo(row.wins, row.losses, row.draws);
+			row.elo = elo.diff();
+			row.error = elo.errorMargin();
+		}
+		emit dataChanged(index(i, EloColumn), index(i, ErrorColumn));
+	}
+}
+
+QModelIndex TournamentResultsModel::index(int row, int column,
+					  const QModelIndex& parent) const
+{
+	if (!hasIndex(row, column, parent))
+		return QModelIndex();
+
+	return createIndex(row, column);
+}
+
+QModelIndex TournamentResultsModel::parent(const QModelIndex& index) const
+{
+	Q_UNUSED(index);
+
+	return QModelIndex();
+}
+
+int TournamentResultsModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return m_rows.size();
+}
+
+int TournamentResultsModel::columnCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return ColumnCount;
+}
+
+QVariant TournamentResultsModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid())
+		return QVariant();
+
+	if (role == Qt::TextAlignmentRole && index.column() != NameColumn)
+		return int(Qt::AlignVCenter | Qt::AlignRight);
+	if (role != Qt::DisplayRole)
+		return QVariant();
+
+	const Row& row = m_rows.at(index.row());
+	const int games = row.wins + row.losses + row.draws;
+	switch (index.column())
+	{
+	case NameColumn:
+		return row.name;
+	case GamesColumn:
+		return games;
+	case WinsColumn:
+		return row.wins;
+	case LossesColumn:
+		return row.losses;
+	case DrawsColumn:
+		return row.draws;
+	case PointsColumn:
+		return QString::number(row.score / 2.0, 'f', 1);
+	case ScoreColumn:
+		if (games == 0)
+			return QVariant();
+		return QString::number(row.score * 50.0 / games, 'f', 1) + '%';
+	case EloColumn:
+		if (!std::isfinite(row.elo))
+			return QVariant();
+		return QString::number(row.elo, 'f', 1);
+	case ErrorColumn:
+		if (!std::isfinite(row.error))
+			return QVariant();
+		return QString::number(row.error, 'f', 1);
+	default:
+		return QVariant();
+	}
+}
+
+QVariant TournamentResultsModel::headerData(int section,
+					    Qt::Orientation orientation,
+					    int role) const
+{
+	if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+		return QVariant();
+
+	switch (section)
+	{
+	case NameColumn:
+		return tr("Name");
+	case GamesColumn:
+		return tr("Games");
+	case WinsColumn:
+		return tr("Wins");
+	case LossesColumn:
+		return tr("Losses");
+	case DrawsColumn:
+		return tr("Draws");
+	case PointsColumn:
+		return tr("Points");
+	case ScoreColumn:
+		return tr("Score");
+	case EloColumn:
+		return tr("Elo");
+	case ErrorColumn:
+		return tr("+/-");
+	default:
+		return QVariant();
+	}
+}
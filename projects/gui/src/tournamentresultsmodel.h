@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TOURNAMENT_RESULTS_MODEL_H
+#define TOURNAMENT_RESULTS_MODEL_H
+
+#include <QAbstractItemModel>
+#include <QVector>
+class Tournament;
+
+/*!
+ * \brief Supplies the standings of a tournament to views.
+ *
+ * The model keeps a copy of each player's score so that a finished
+ * game only updates, and repaints, the rows of its two players. The
+ * Elo columns are recalculated separately by updateRatings(), which
+ * can be called less often.
+ */
+class TournamentResultsModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+	public:
+		/*! The columns of the model. */
+		enum Column
+		{
+			NameColumn,
+			GamesColumn,
+			WinsColumn,
+			LossesColumn,
+			DrawsColumn,
+			PointsColumn,
+			ScoreColumn,
+			EloColumn,
+			ErrorColumn,
+			ColumnCount
+		};
+
+		/*! Constructs a model with the given \a parent. */
+		TournamentResultsModel(QObject* parent = nullptr);
+
+		/*!
+		 * Associates \a tournament with this model and reads
+		 * the current score of every player.
+		 */
+		void setTournament(Tournament* tournament);
+		/*!
+		 * Reads the score of player \a index from the tournament
+		 * and updates its row.
+		 */
+		void updatePlayer(int index);
+		/*!
+		 * Recalculates the Elo ratings of the players whose score
+		 * has changed since the last call.
+		 */
+		void updateRatings();
+
+		// Inherited from QAbstractItemModel
+		virtual QModelIndex index(int row, int column,
+					  const QModelIndex& parent = QModelIndex()) const;
+		virtual QModelIndex parent(const QModelIndex& index) const;
+		virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+		virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+		virtual QVariant data(const QModelIndex& index, int role) const;
+		virtual QVariant headerData(int section, Qt::Orientation orientation,
+					    int role = Qt::DisplayRole) const;
+
+	private:
+		struct Row
+		{
+			QString name;
+			int wins;
+			int losses;
+			int draws;
+			int score;
+			qreal elo;
+			qreal error;
+			bool dirty;
+		};
+
+		void readPlayer(int index, Row& row) const;
+
+		Tournament* m_tournament;
+		QVector<Row> m_rows;
+};
+
+#endif // TOURNAMENT_RESULTS_MODEL_H
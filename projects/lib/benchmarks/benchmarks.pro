@@ -1,2 +1,4 @@
 TEMPLATE = subdirs
-SUBDIRS = pgngame
+SUBDIRS = pgngame board fen movegen polyglotbook mockengine tournament
+
+tournament.depends = mockengine
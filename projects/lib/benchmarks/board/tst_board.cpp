@@ -0,0 +1,181 @@
+#include <QtTest/QtTest>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+
+class tst_Board: public QObject
+{
+	Q_OBJECT
+
+	public:
+		tst_Board();
+
+	private slots:
+		void perft_data() const;
+		void perft();
+
+		void legalMoves_data() const;
+		void legalMoves();
+
+		void moveFromString_data() const;
+		void moveFromString();
+
+		void cleanupTestCase();
+
+	private:
+		void setVariant(const QString& variant);
+		Chess::Board* m_board;
+};
+
+
+tst_Board::tst_Board()
+	: m_board(nullptr)
+{
+}
+
+void tst_Board::cleanupTestCase()
+{
+	delete m_board;
+}
+
+void tst_Board::setVariant(const QString& variant)
+{
+	if (m_board == nullptr || m_board->variant() != variant)
+	{
+		delete m_board;
+		m_board = Chess::BoardFactory::create(variant);
+	}
+	QVERIFY(m_board != nullptr);
+}
+
+static quint64 perftVal(Chess::Board* board, int depth)
+{
+	quint64 nodeCount = 0;
+	Chess::MoveList moves;
+	board->legalMoves(moves);
+	if (depth <= 1 || moves.isEmpty())
+		return moves.size();
+
+	for (const auto& move : moves)
+	{
+		board->makeMove(move);
+		nodeCount += perftVal(board, depth - 1);
+		board->undoMove();
+	}
+
+	return nodeCount;
+}
+
+void tst_Board::perft_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<int>("depth");
+
+	// The starting position of every variant
+	const auto variants = Chess::BoardFactory::variants();
+	for (const auto& variant : variants)
+	{
+		Chess::Board* board = Chess::BoardFactory::create(variant);
+		QTest::newRow(qPrintable(variant))
+			<< variant
+			<< board->defaultFenString()
+			<< 3;
+		delete board;
+	}
+
+	QTest::newRow("standard kiwipete")
+		<< "standard"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
+		<< 4;
+	QTest::newRow("crazyhouse middlegame")
+		<< "crazyhouse"
+		<< "r1b2rk1/pppp1ppp/2n5/2b1p3/2B1P1n1/2NP1N2/PPP2PPP/R1BQK2R[QNp] w KQ - 0 8"
+		<< 3;
+}
+
+void tst_Board::perft()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(int, depth);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+	QBENCHMARK
+	{
+		perftVal(m_board, depth);
+	}
+}
+
+void tst_Board::legalMoves_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+
+	QTest::newRow("standard startpos")
+		<< "standard"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	QTest::newRow("standard kiwipete")
+		<< "standard"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+	QTest::newRow("standard check")
+		<< "standard"
+		<< "rnbqkbnr/ppp2ppp/8/1B1pp3/4P3/8/PPPP1PPP/RNBQK1NR b KQkq - 1 3";
+	QTest::newRow("capablanca startpos")
+		<< "capablanca"
+		<< "rnabqkbcnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNABQKBCNR w KQkq - 0 1";
+}
+
+void tst_Board::legalMoves()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+	QBENCHMARK
+	{
+		m_board->legalMoves();
+	}
+}
+
+void tst_Board::moveFromString_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("moves");
+
+	QTest::newRow("standard game")
+		<< "standard"
+		<< "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O "
+		   "h3 Nb8 d4 Nbd7 c4 c6 cxb5 axb5 Nc3 Bb7 Bg5 b4 Nb1 h6 "
+		   "Bh4 c5 dxe5 Nxe4 Bxe7 Qxe7 exd6 Qf6 Nbd2 Nxd6 Nc4 Nxc4 "
+		   "Bxc4 Nb6 Ne5 Rae8 Bxf7+ Rxf7 Nxf7 Rxe1+ Qxe1 Kxf7 Qe3 Qg5 "
+		   "Qxg5 hxg5 b3 Ke6 a3 Kd6 axb4 cxb4 Ra5 Nd5 f3 Bc8 Kf2 Bf5";
+	QTest::newRow("crazyhouse game")
+		<< "crazyhouse"
+		<< "e4 e6 d4 d5 exd5 exd5 Nf3 Nf6 Bd3 Bd6 O-O O-O Bg5 Bg4 "
+		   "Bxf6 Qxf6 N@h6+ gxh6 P@g3 N@f4";
+}
+
+void tst_Board::moveFromString()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, moves);
+
+	setVariant(variant);
+	const QStringList moveStrings = moves.split(' ');
+	QBENCHMARK
+	{
+		m_board->reset();
+		for (const QString& str : moveStrings)
+		{
+			Chess::Move move = m_board->moveFromString(str);
+			Q_ASSERT(!move.isNull());
+			m_board->makeMove(move);
+		}
+	}
+}
+
+QTEST_MAIN(tst_Board)
+#include "tst_board.moc"
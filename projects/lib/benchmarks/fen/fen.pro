@@ -0,0 +1,4 @@
+include(../benchmarks.pri)
+
+TARGET = tst_fen
+SOURCES += tst_fen.cpp
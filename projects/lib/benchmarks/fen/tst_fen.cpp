@@ -0,0 +1,107 @@
+#include <QtTest/QtTest>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+
+class tst_Fen: public QObject
+{
+	Q_OBJECT
+
+	public:
+		tst_Fen();
+
+	private slots:
+		void setFenString_data() const;
+		void setFenString();
+
+		void fenString_data() const;
+		void fenString();
+
+		void cleanupTestCase();
+
+	private:
+		void setVariant(const QString& variant);
+		Chess::Board* m_board;
+};
+
+
+tst_Fen::tst_Fen()
+	: m_board(nullptr)
+{
+}
+
+void tst_Fen::cleanupTestCase()
+{
+	delete m_board;
+}
+
+void tst_Fen::setVariant(const QString& variant)
+{
+	if (m_board == nullptr || m_board->variant() != variant)
+	{
+		delete m_board;
+		m_board = Chess::BoardFactory::create(variant);
+	}
+	QVERIFY(m_board != nullptr);
+}
+
+static void addFenRows()
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+
+	QTest::newRow("standard startpos")
+		<< "standard"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	QTest::newRow("standard kiwipete")
+		<< "standard"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+	QTest::newRow("standard endgame")
+		<< "standard"
+		<< "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1";
+	QTest::newRow("crazyhouse middlegame")
+		<< "crazyhouse"
+		<< "r1b2rk1/pppp1ppp/2n5/2b1p3/2B1P1n1/2NP1N2/PPP2PPP/R1BQK2R[QNp] w KQ - 0 8";
+	QTest::newRow("capablanca startpos")
+		<< "capablanca"
+		<< "rnabqkbcnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNABQKBCNR w KQkq - 0 1";
+}
+
+void tst_Fen::setFenString_data() const
+{
+	addFenRows();
+}
+
+void tst_Fen::setFenString()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+	QBENCHMARK
+	{
+		m_board->setFenString(fen);
+	}
+}
+
+void tst_Fen::fenString_data() const
+{
+	addFenRows();
+}
+
+void tst_Fen::fenString()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+	QBENCHMARK
+	{
+		m_board->fenString();
+	}
+}
+
+QTEST_MAIN(tst_Fen)
+#include "tst_fen.moc"
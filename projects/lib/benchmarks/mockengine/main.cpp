@@ -0,0 +1,255 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <board/board.h>
+#include <board/boardfactory.h>
+#include <mersenne.h>
+
+/*
+ * A mock chess engine for measuring the overhead of Cute Chess itself.
+ *
+ * The engine speaks both UCI and Xboard, picking the protocol from the
+ * first command it gets, and answers every search instantly with a
+ * random legal move. Before each move it can send a flood of thinking
+ * output, set with the "InfoLines" option, to load the GUI's parser.
+ */
+class MockEngine
+{
+	public:
+		MockEngine();
+		~MockEngine();
+
+		bool processLine(const QString& line);
+
+	private:
+		enum Protocol
+		{
+			NoProtocol,
+			Uci,
+			Xboard
+		};
+
+		void write(const QString& line);
+		void setVariant(const QString& variant);
+		void setPosition(const QString& fen, const QStringList& moves);
+		bool makeMove(const QString& move);
+		void search();
+
+		bool processUci(const QString& command, const QStringList& args);
+		bool processXboard(const QString& command, const QStringList& args);
+
+		Protocol m_protocol;
+		Chess::Board* m_board;
+		int m_infoLines;
+		bool m_force;
+		Chess::Side m_side;
+};
+
+MockEngine::MockEngine()
+	: m_protocol(NoProtocol),
+	  m_board(nullptr),
+	  m_infoLines(0),
+	  m_force(false),
+	  m_side(Chess::Side::Black)
+{
+	setVariant("standard");
+}
+
+MockEngine::~MockEngine()
+{
+	delete m_board;
+}
+
+void MockEngine::write(const QString& line)
+{
+	std::fputs(line.toLatin1().constData(), stdout);
+	std::fputc('\n', stdout);
+	std::fflush(stdout);
+}
+
+void MockEngine::setVariant(const QString& variant)
+{
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	if (board == nullptr)
+		return;
+
+	delete m_board;
+	m_board = board;
+	m_board->reset();
+}
+
+void MockEngine::setPosition(const QString& fen, const QStringList& moves)
+{
+	if (fen.isEmpty() || !m_board->setFenString(fen))
+		m_board->reset();
+	for (const QString& move : moves)
+	{
+		if (!makeMove(move))
+			break;
+	}
+}
+
+bool MockEngine::makeMove(const QString& move)
+{
+	const Chess::Move tmp(m_board->moveFromString(move));
+	if (tmp.isNull())
+		return false;
+
+	m_board->makeMove(tmp);
+	return true;
+}
+
+void MockEngine::search()
+{
+	const QVector<Chess::Move> moves(m_board->legalMoves());
+	if (moves.isEmpty())
+		return;
+
+	const Chess::Move move(moves.at(Mersenne::random() % moves.size()));
+	const QString str(m_board->moveString(move, Chess::Board::LongAlgebraic));
+
+	for (int i = 1; i <= m_infoLines; i++)
+	{
+		const int score = int(Mersenne::random() % 101) - 50;
+		if (m_protocol == Uci)
+			write(QString("info depth %1 score cp %2 nodes %3 pv %4")
+			      .arg(i).arg(score).arg(i * 1000).arg(str));
+		else
+			write(QString("%1 %2 0 %3 %4")
+			      .arg(i).arg(score).arg(i * 1000).arg(str));
+	}
+
+	if (m_protocol == Uci)
+		write("bestmove " + str);
+	else
+	{
+		m_board->makeMove(move);
+		write("move " + str);
+	}
+}
+
+bool MockEngine::processUci(const QString& command, const QStringList& args)
+{
+	if (command == "uci")
+	{
+		write("id name MockEngine");
+		write("id author Cute Chess");
+		write("option name InfoLines type spin default 0 min 0 max 100000");
+		write("uciok");
+	}
+	else if (command == "isready")
+		write("readyok");
+	else if (command == "setoption")
+	{
+		const int nameIndex = args.indexOf("name");
+		const int valueIndex = args.indexOf("value");
+		if (nameIndex == -1 || valueIndex <= nameIndex + 1)
+			return true;
+
+		const QString name = args.mid(nameIndex + 1,
+			valueIndex - nameIndex - 1).join(" ");
+		const QString value = args.mid(valueIndex + 1).join(" ");
+		if (name == "InfoLines")
+			m_infoLines = qMax(0, value.toInt());
+	}
+	else if (command == "position")
+	{
+		const int movesIndex = args.indexOf("moves");
+		const QStringList moves = movesIndex == -1
+			? QStringList() : args.mid(movesIndex + 1);
+		QString fen;
+		if (args.value(0) == "fen")
+			fen = args.mid(1, movesIndex == -1 ? -1 : movesIndex - 1).join(" ");
+		setPosition(fen, moves);
+	}
+	else if (command == "go")
+		search();
+	else if (command == "quit")
+		return false;
+
+	return true;
+}
+
+bool MockEngine::processXboard(const QString& command, const QStringList& args)
+{
+	if (command == "protover")
+		write("feature ping=1 setboard=1 usermove=1 san=0 colors=0 "
+		      "sigint=0 sigterm=0 reuse=1 myname=\"MockEngine\" "
+		      "option=\"InfoLines -spin 0 0 100000\" done=1");
+	else if (command == "new")
+	{
+		setVariant("standard");
+		m_force = false;
+		m_side = Chess::Side::Black;
+	}
+	else if (command == "variant")
+		setVariant(args.value(0));
+	else if (command == "setboard")
+		setPosition(args.join(" "), QStringList());
+	else if (command == "force")
+		m_force = true;
+	else if (command == "go")
+	{
+		m_force = false;
+		m_side = m_board->sideToMove();
+		search();
+	}
+	else if (command == "usermove")
+	{
+		if (makeMove(args.value(0))
+		&&  !m_force && m_board->sideToMove() == m_side)
+			search();
+	}
+	else if (command == "ping")
+		write("pong " + args.value(0));
+	else if (command == "option")
+	{
+		const QString option = args.join(" ");
+		if (option.startsWith("InfoLines="))
+			m_infoLines = qMax(0, option.section('=', 1).toInt());
+	}
+	else if (command == "quit")
+		return false;
+
+	return true;
+}
+
+bool MockEngine::processLine(const QString& line)
+{
+	QStringList args = line.split(' ', QString::SkipEmptyParts);
+	if (args.isEmpty())
+		return true;
+	const QString command = args.takeFirst();
+
+	if (m_protocol == NoProtocol)
+	{
+		if (command == "uci")
+			m_protocol = Uci;
+		else if (command == "xboard")
+			m_protocol = Xboard;
+		else
+			return command != "quit";
+	}
+
+	if (m_protocol == Uci)
+		return processUci(command, args);
+	return processXboard(command, args);
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	Mersenne::initialize(quint32(QCoreApplication::applicationPid()));
+
+	MockEngine engine;
+	std::string line;
+	while (std::getline(std::cin, line))
+	{
+		if (!engine.processLine(QString::fromStdString(line).trimmed()))
+			break;
+	}
+
+	return 0;
+}
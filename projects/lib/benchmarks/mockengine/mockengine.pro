@@ -0,0 +1,13 @@
+TEMPLATE = app
+TARGET = mockengine
+
+win32:config += CONSOLE
+CONFIG -= app_bundle
+QT = core
+
+include(../../lib.pri)
+
+OBJECTS_DIR = .obj
+MOC_DIR = .moc
+
+SOURCES += main.cpp
@@ -0,0 +1,4 @@
+include(../benchmarks.pri)
+
+TARGET = tst_movegen
+SOURCES += tst_movegen.cpp
@@ -0,0 +1,241 @@
+#include <QtTest/QtTest>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+/*
+ * Move generation benchmarks for every variant.
+ *
+ * Each operation is measured separately on the same positions, so a
+ * regression can be traced to move generation, making and undoing
+ * moves, legality checks, SAN or FEN. Run with "-csv" or "-xml" to
+ * get machine-readable results. The perft benchmarks report their
+ * node count, which turns the time per iteration into nodes/second.
+ */
+class tst_MoveGen: public QObject
+{
+	Q_OBJECT
+
+	public:
+		tst_MoveGen();
+
+	private slots:
+		void generate_data() const;
+		void generate();
+
+		void makeUndo_data() const;
+		void makeUndo();
+
+		void legality_data() const;
+		void legality();
+
+		void san_data() const;
+		void san();
+
+		void fen_data() const;
+		void fen();
+
+		void perft_data() const;
+		void perft();
+
+		void cleanupTestCase();
+
+	private:
+		void setPosition(const QString& variant, const QString& fen);
+		Chess::Board* m_board;
+};
+
+
+tst_MoveGen::tst_MoveGen()
+	: m_board(nullptr)
+{
+}
+
+void tst_MoveGen::cleanupTestCase()
+{
+	delete m_board;
+}
+
+void tst_MoveGen::setPosition(const QString& variant, const QString& fen)
+{
+	if (m_board == nullptr || m_board->variant() != variant)
+	{
+		delete m_board;
+		m_board = Chess::BoardFactory::create(variant);
+	}
+	QVERIFY(m_board != nullptr);
+	QVERIFY(m_board->setFenString(fen));
+}
+
+static quint64 perftVal(Chess::Board* board, int depth)
+{
+	quint64 nodeCount = 0;
+	Chess::MoveList moves;
+	board->legalMoves(moves);
+	if (depth <= 1 || moves.isEmpty())
+		return moves.size();
+
+	for (const auto& move : moves)
+	{
+		board->makeMove(move);
+		nodeCount += perftVal(board, depth - 1);
+		board->undoMove();
+	}
+
+	return nodeCount;
+}
+
+// The starting position of every variant and some of the middlegame
+// positions of the chessboard perft tests
+static void addPositions()
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+
+	const auto variants = Chess::BoardFactory::variants();
+	for (const auto& variant : variants)
+	{
+		Chess::Board* board = Chess::BoardFactory::create(variant);
+		QTest::newRow(qPrintable(variant))
+			<< variant
+			<< board->defaultFenString();
+		delete board;
+	}
+
+	QTest::newRow("standard kiwipete")
+		<< "standard"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+	QTest::newRow("capablanca goth2")
+		<< "capablanca"
+		<< "r1b1c2rk1/p4a1ppp/1ppq2pn2/3p1p4/3A1Pn3/1PN3PN2/P1PQP1BPPP/3RC2RK1 w - - 0 1";
+	QTest::newRow("atomic pos2")
+		<< "atomic"
+		<< "r4b1r/2kb1N2/p2Bpnp1/8/2Pp3p/1P1PPP2/P5PP/R3K2R b KQ - 0 1";
+	QTest::newRow("crazyhouse promo1")
+		<< "crazyhouse"
+		<< "3q1bkr/2p1pBp1/q1n3p1/1N2p3/1Pp5/P4Q~2/BBPp1PPP/R2K2NR[RPPn] b - - 0 28";
+	QTest::newRow("horde3")
+		<< "horde"
+		<< "rnbqkbnr/6p1/2p1Pp1P/P1PPPP2/Pp4PP/1p2PPPP/1P2PPPP/PP1nPPPP b kq a3 0 18";
+	QTest::newRow("grid pos2")
+		<< "grid"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+}
+
+void tst_MoveGen::generate_data() const
+{
+	addPositions();
+}
+
+void tst_MoveGen::generate()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setPosition(variant, fen);
+	Chess::MoveList moves;
+	QBENCHMARK
+	{
+		m_board->legalMoves(moves);
+	}
+}
+
+void tst_MoveGen::makeUndo_data() const
+{
+	addPositions();
+}
+
+void tst_MoveGen::makeUndo()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setPosition(variant, fen);
+	const auto moves = m_board->legalMoves();
+	QBENCHMARK
+	{
+		for (const auto& move : moves)
+		{
+			m_board->makeMove(move);
+			m_board->undoMove();
+		}
+	}
+}
+
+void tst_MoveGen::legality_data() const
+{
+	addPositions();
+}
+
+void tst_MoveGen::legality()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setPosition(variant, fen);
+	const auto moves = m_board->legalMoves();
+	QBENCHMARK
+	{
+		for (const auto& move : moves)
+			m_board->isLegalMove(move);
+	}
+}
+
+void tst_MoveGen::san_data() const
+{
+	addPositions();
+}
+
+void tst_MoveGen::san()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setPosition(variant, fen);
+	const auto moves = m_board->legalMoves();
+	QBENCHMARK
+	{
+		for (const auto& move : moves)
+			m_board->moveString(move, Chess::Board::StandardAlgebraic);
+	}
+}
+
+void tst_MoveGen::fen_data() const
+{
+	addPositions();
+}
+
+void tst_MoveGen::fen()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setPosition(variant, fen);
+	const QString str = m_board->fenString();
+	QBENCHMARK
+	{
+		m_board->setFenString(str);
+		m_board->fenString();
+	}
+}
+
+void tst_MoveGen::perft_data() const
+{
+	addPositions();
+}
+
+void tst_MoveGen::perft()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setPosition(variant, fen);
+	quint64 nodes = 0;
+	QBENCHMARK
+	{
+		nodes = perftVal(m_board, 3);
+	}
+	qDebug() << "nodes:" << nodes;
+}
+
+QTEST_MAIN(tst_MoveGen)
+#include "tst_movegen.moc"
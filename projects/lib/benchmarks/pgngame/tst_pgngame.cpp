@@ -1,8 +1,21 @@
 #include <QtTest/QtTest>
 #include <pgnstream.h>
 #include <pgngame.h>
+#include <pgngameentry.h>
+#include <pgntagpool.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
 
-
+/*
+ * PGN parsing and writing benchmarks.
+ *
+ * Besides the two embedded games, the corpus benchmarks run on 1000
+ * and 100000 generated games, and on the file named by the
+ * CUTECHESS_PGN_CORPUS environment variable if it's set. Tokenizing,
+ * indexing the tags, full parsing with move validation and writing are
+ * measured separately, and each prints its throughput in games/sec
+ * and MB/sec.
+ */
 class tst_PgnGame: public QObject
 {
 	Q_OBJECT
@@ -10,8 +23,168 @@ class tst_PgnGame: public QObject
 	private slots:
 		void parser_data() const;
 		void parser();
+		void mappedParser_data() const;
+		void mappedParser();
+
+		void tokenizer_data() const;
+		void tokenizer();
+		void entryIndex_data() const;
+		void entryIndex();
+		void fullParse_data() const;
+		void fullParse();
+		void writer_data() const;
+		void writer();
+
+	private:
+		void addCorpora() const;
+		const QByteArray& corpus(const QString& name);
+
+		QMap<QString, QByteArray> m_corpora;
+};
+
+namespace {
+
+/*
+ * A device that discards its output and counts the bytes written.
+ */
+class NullDevice : public QIODevice
+{
+	public:
+		NullDevice()
+			: m_size(0)
+		{
+			open(QIODevice::WriteOnly);
+		}
+
+		qint64 bytesWritten() const
+		{
+			return m_size;
+		}
+
+	protected:
+		qint64 readData(char* data, qint64 maxSize) override
+		{
+			Q_UNUSED(data);
+			Q_UNUSED(maxSize);
+			return -1;
+		}
+
+		qint64 writeData(const char* data, qint64 size) override
+		{
+			Q_UNUSED(data);
+			m_size += size;
+			return size;
+		}
+
+	private:
+		qint64 m_size;
+};
+
+/*
+ * Keeps track of the time spent in the benchmarked code.
+ */
+class Throughput
+{
+	public:
+		Throughput()
+			: m_nsecs(0),
+			  m_games(0),
+			  m_bytes(0)
+		{
+		}
+
+		void start()
+		{
+			m_timer.start();
+		}
+
+		void stop(qint64 games, qint64 bytes)
+		{
+			m_nsecs += m_timer.nsecsElapsed();
+			m_games += games;
+			m_bytes += bytes;
+		}
+
+		void report() const
+		{
+			if (m_nsecs <= 0)
+				return;
+
+			const double secs = double(m_nsecs) / 1e9;
+			qDebug("%.0f games/sec, %.1f MB/sec",
+			       double(m_games) / secs,
+			       double(m_bytes) / (1024.0 * 1024.0) / secs);
+		}
+
+	private:
+		QElapsedTimer m_timer;
+		qint64 m_nsecs;
+		qint64 m_games;
+		qint64 m_bytes;
 };
 
+// Generates a PGN file of random games with engine-like comments
+QByteArray generateCorpus(int gameCount)
+{
+	QByteArray data;
+	QTextStream out(&data);
+	QScopedPointer<Chess::Board> board(
+		Chess::BoardFactory::create("standard"));
+	quint32 x = 31337;
+
+	for (int i = 0; i < gameCount; i++)
+	{
+		PgnGame game;
+		game.setEvent("Benchmark");
+		game.setSite("?");
+		game.setRound(i + 1);
+		game.setPlayerName(Chess::Side::White, "Engine A");
+		game.setPlayerName(Chess::Side::Black, "Engine B");
+		board->reset();
+
+		x = x * 1103515245 + 12345;
+		const int maxPlies = 40 + (x >> 16) % 120;
+		Chess::Result result;
+		for (int ply = 0; ply < maxPlies; ply++)
+		{
+			Chess::MoveList moves;
+			board->legalMoves(moves);
+			if (moves.isEmpty())
+				break;
+
+			x = x * 1103515245 + 12345;
+			const Chess::Move move(moves.at((x >> 16) % moves.size()));
+
+			PgnGame::MoveData md;
+			md.key = board->key();
+			md.move = board->genericMove(move);
+			md.moveString = board->moveString(
+				move, Chess::Board::StandardAlgebraic);
+			if ((x >> 8) % 2 == 0)
+				md.comment = QString("%1/%2 %3s")
+					     .arg(double(int(x % 400) - 200) / 100.0)
+					     .arg(ply / 4 + 8)
+					     .arg(x % 30);
+			game.addMove(md, false);
+			board->makeMove(move);
+
+			result = board->result();
+			if (!result.isNone())
+				break;
+		}
+		if (result.isNone())
+			result = Chess::Result(Chess::Result::Draw);
+		game.setResult(result);
+
+		game.write(out, PgnGame::Verbose);
+	}
+
+	out.flush();
+	return data;
+}
+
+} // anonymous namespace
+
 void tst_PgnGame::parser_data() const
 {
 	QTest::addColumn<QByteArray>("pgn");
@@ -99,5 +272,192 @@ void tst_PgnGame::parser()
 	}
 }
 
+void tst_PgnGame::mappedParser_data() const
+{
+	parser_data();
+}
+
+void tst_PgnGame::mappedParser()
+{
+	QFETCH(QByteArray, pgn);
+
+	QTemporaryFile file;
+	QVERIFY(file.open());
+	QCOMPARE(file.write(pgn), qint64(pgn.size()));
+	QVERIFY(file.flush());
+
+	PgnStream stream;
+	QVERIFY(stream.setMappedFile(&file));
+	PgnGame game;
+	QBENCHMARK
+	{
+		QVERIFY(game.read(stream));
+		stream.rewind();
+	}
+}
+
+void tst_PgnGame::addCorpora() const
+{
+	QTest::addColumn<QString>("name");
+
+	QTest::newRow("1k") << QString("1k");
+	QTest::newRow("100k") << QString("100k");
+	if (qEnvironmentVariableIsSet("CUTECHESS_PGN_CORPUS"))
+		QTest::newRow("file") << QString("file");
+}
+
+const QByteArray& tst_PgnGame::corpus(const QString& name)
+{
+	auto it = m_corpora.find(name);
+	if (it != m_corpora.end())
+		return *it;
+
+	QByteArray data;
+	if (name == "1k")
+		data = generateCorpus(1000);
+	else if (name == "100k")
+		data = generateCorpus(100000);
+	else
+	{
+		QFile file(qgetenv("CUTECHESS_PGN_CORPUS"));
+		if (file.open(QIODevice::ReadOnly))
+			data = file.readAll();
+		else
+			qWarning("Could not open PGN corpus %s",
+				 qPrintable(file.fileName()));
+	}
+
+	return *m_corpora.insert(name, data);
+}
+
+void tst_PgnGame::tokenizer_data() const
+{
+	addCorpora();
+}
+
+void tst_PgnGame::tokenizer()
+{
+	QFETCH(QString, name);
+	const QByteArray& pgn = corpus(name);
+	QVERIFY(!pgn.isEmpty());
+
+	PgnStream stream(&pgn);
+	Throughput throughput;
+	QBENCHMARK
+	{
+		stream.rewind();
+		throughput.start();
+		int games = 0;
+		while (stream.nextGame())
+		{
+			while (stream.readNext() != PgnStream::NoToken)
+				;
+			games++;
+		}
+		throughput.stop(games, pgn.size());
+	}
+	throughput.report();
+}
+
+void tst_PgnGame::entryIndex_data() const
+{
+	addCorpora();
+}
+
+void tst_PgnGame::entryIndex()
+{
+	QFETCH(QString, name);
+	const QByteArray& pgn = corpus(name);
+	QVERIFY(!pgn.isEmpty());
+
+	PgnStream stream(&pgn);
+	Throughput throughput;
+	QBENCHMARK
+	{
+		stream.rewind();
+		throughput.start();
+		PgnTagPool pool;
+		QList<PgnGameEntry*> entries;
+		forever
+		{
+			PgnGameEntry* entry = new PgnGameEntry(&pool);
+			if (!entry->read(stream))
+			{
+				delete entry;
+				break;
+			}
+			entries.append(entry);
+		}
+		throughput.stop(entries.size(), pgn.size());
+		qDeleteAll(entries);
+	}
+	throughput.report();
+}
+
+void tst_PgnGame::fullParse_data() const
+{
+	addCorpora();
+}
+
+void tst_PgnGame::fullParse()
+{
+	QFETCH(QString, name);
+	const QByteArray& pgn = corpus(name);
+	QVERIFY(!pgn.isEmpty());
+
+	PgnStream stream(&pgn);
+	PgnGame game;
+	Throughput throughput;
+	QBENCHMARK
+	{
+		stream.rewind();
+		throughput.start();
+		int games = 0;
+		while (game.read(stream))
+			games++;
+		throughput.stop(games, pgn.size());
+	}
+	throughput.report();
+}
+
+void tst_PgnGame::writer_data() const
+{
+	addCorpora();
+}
+
+void tst_PgnGame::writer()
+{
+	QFETCH(QString, name);
+	const QByteArray& pgn = corpus(name);
+	QVERIFY(!pgn.isEmpty());
+
+	// Keeping every game in memory would take too much space, so
+	// the first games are written repeatedly
+	PgnStream stream(&pgn);
+	QVector<PgnGame> games;
+	int gameCount = 0;
+	PgnGame game;
+	while (game.read(stream))
+	{
+		if (games.size() < 1000)
+			games.append(game);
+		gameCount++;
+	}
+	QVERIFY(!games.isEmpty());
+
+	Throughput throughput;
+	QBENCHMARK
+	{
+		NullDevice device;
+		QTextStream out(&device);
+		throughput.start();
+		for (int i = 0; i < gameCount; i++)
+			games.at(i % games.size()).write(out, PgnGame::Verbose);
+		out.flush();
+		throughput.stop(gameCount, device.bytesWritten());
+	}
+	throughput.report();
+}
+
 QTEST_MAIN(tst_PgnGame)
 #include "tst_pgngame.moc"
@@ -0,0 +1,4 @@
+include(../benchmarks.pri)
+
+TARGET = tst_polyglotbook
+SOURCES += tst_polyglotbook.cpp
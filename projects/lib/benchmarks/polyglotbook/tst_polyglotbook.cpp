@@ -0,0 +1,147 @@
+#include <QtTest/QtTest>
+#include <polyglotbook.h>
+#include <pgngame.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+/*
+ * Opening book probing benchmarks.
+ *
+ * A book is generated from random games, so no data files are needed,
+ * and probed in each access mode. The board's key() is the Polyglot
+ * key, updated incrementally with each move, so a probe is just the
+ * book lookup and the conversion of the book move. The time per
+ * iteration is the cost of one probe.
+ */
+class tst_PolyglotBook: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+
+		void entries_data() const;
+		void entries();
+		void probe_data() const;
+		void probe();
+
+	private:
+		void addModes() const;
+
+		QTemporaryFile m_file;
+		QVector<quint64> m_keys;
+		QStringList m_fens;
+};
+
+void tst_PolyglotBook::initTestCase()
+{
+	QScopedPointer<Chess::Board> board(
+		Chess::BoardFactory::create("standard"));
+	PolyglotBook book(OpeningBook::Ram);
+	quint32 x = 4242;
+
+	for (int i = 0; i < 20000; i++)
+	{
+		PgnGame game;
+		game.setVariant("standard");
+		game.setResult(Chess::Result(Chess::Result::Draw));
+		board->reset();
+
+		for (int ply = 0; ply < 16; ply++)
+		{
+			Chess::MoveList moves;
+			board->legalMoves(moves);
+			if (moves.isEmpty())
+				break;
+
+			// Favor the first moves to get a realistic tree
+			x = x * 1103515245 + 12345;
+			int index = (x >> 16) % moves.size();
+			if ((x >> 8) % 4 != 0)
+				index %= qMin(moves.size(), 3);
+			const Chess::Move move(moves.at(index));
+
+			if (i % 20 == 0)
+			{
+				m_keys.append(board->key());
+				m_fens.append(board->fenString());
+			}
+			PgnGame::MoveData md = { board->key(),
+						 board->genericMove(move),
+						 QString(), QString(),
+						 PgnGame::EvalData() };
+			game.addMove(md, false);
+			board->makeMove(move);
+		}
+		book.import(game, 16);
+	}
+
+	QVERIFY(m_file.open());
+	m_file.close();
+	QVERIFY(book.write(m_file.fileName()));
+	QVERIFY(!m_keys.isEmpty());
+}
+
+void tst_PolyglotBook::addModes() const
+{
+	QTest::addColumn<int>("mode");
+
+	QTest::newRow("ram") << int(OpeningBook::Ram);
+	QTest::newRow("disk") << int(OpeningBook::Disk);
+	QTest::newRow("mapped") << int(OpeningBook::Mapped);
+}
+
+void tst_PolyglotBook::entries_data() const
+{
+	addModes();
+}
+
+void tst_PolyglotBook::entries()
+{
+	QFETCH(int, mode);
+
+	PolyglotBook book(OpeningBook::AccessMode(mode));
+	QVERIFY(book.read(m_file.fileName()));
+
+	int i = 0;
+	QBENCHMARK
+	{
+		book.entries(m_keys.at(i));
+		i = (i + 1) % m_keys.size();
+	}
+}
+
+void tst_PolyglotBook::probe_data() const
+{
+	addModes();
+}
+
+void tst_PolyglotBook::probe()
+{
+	QFETCH(int, mode);
+
+	PolyglotBook book(OpeningBook::AccessMode(mode));
+	QVERIFY(book.read(m_file.fileName()));
+
+	// The positions are set up beforehand, as they are in a game
+	QVector<Chess::Board*> boards;
+	for (int i = 0; i < m_fens.size(); i++)
+	{
+		Chess::Board* board = Chess::BoardFactory::create("standard");
+		boards.append(board);
+		QVERIFY(board->setFenString(m_fens.at(i)));
+	}
+
+	int i = 0;
+	QBENCHMARK
+	{
+		Chess::Board* board = boards.at(i);
+		board->moveFromGenericMove(book.move(board->key()));
+		i = (i + 1) % boards.size();
+	}
+
+	qDeleteAll(boards);
+}
+
+QTEST_MAIN(tst_PolyglotBook)
+#include "tst_polyglotbook.moc"
@@ -0,0 +1,9 @@
+include(../benchmarks.pri)
+
+TARGET = tst_tournament
+SOURCES += tst_tournament.cpp
+
+# The games are played by the mock engine built next to the benchmark
+MOCKENGINE = $$OUT_PWD/../mockengine/mockengine
+win32:MOCKENGINE = $${MOCKENGINE}.exe
+DEFINES += MOCKENGINE=\\\"$$MOCKENGINE\\\"
@@ -0,0 +1,177 @@
+#include <QtTest/QtTest>
+#include <gamemanager.h>
+#include <enginemanager.h>
+#include <enginebuilder.h>
+#include <engineconfiguration.h>
+#include <tournament.h>
+#include <tournamentfactory.h>
+#include <gameadjudicator.h>
+#include <chessgame.h>
+#include <timecontrol.h>
+#include <processusage.h>
+#include <memorystats.h>
+
+/*
+ * End-to-end benchmarks of Cute Chess's own overhead.
+ *
+ * A full round-robin tournament is played between two instances of the
+ * mock engine, which answers every search instantly with a random legal
+ * move. All of the measured time is then spent by Cute Chess and the
+ * operating system: starting and initializing engines, writing "go"
+ * commands, parsing the engines' output (optionally a flood of "info"
+ * lines) and forwarding the moves to the opponent.
+ *
+ * Besides the wall time of the tournament, each row reports the games
+ * per second, the CPU time of this process per game, and the average
+ * time per ply, which is the latency from sending "go" to forwarding
+ * the engine's move. The memory report at the end of each row shows
+ * the peak memory of this process and of the accounted subsystems.
+ */
+class GameTimer: public QObject
+{
+	Q_OBJECT
+
+	public:
+		GameTimer()
+			: m_gameTime(0),
+			  m_plies(0)
+		{
+			m_timer.start();
+		}
+
+		qint64 elapsed() const
+		{
+			return m_timer.elapsed();
+		}
+
+		// Returns the average time per ply in milliseconds
+		double plyTime() const
+		{
+			return m_plies > 0 ? m_gameTime / 1e6 / m_plies : 0.0;
+		}
+
+	public slots:
+		void onGameStarted(ChessGame* game, int number)
+		{
+			Q_UNUSED(game);
+			m_startTimes[number] = m_timer.nsecsElapsed();
+		}
+
+		void onGameFinished(ChessGame* game, int number)
+		{
+			m_gameTime += m_timer.nsecsElapsed() - m_startTimes.take(number);
+			m_plies += game->moves().size();
+		}
+
+	private:
+		QElapsedTimer m_timer;
+		QHash<int, qint64> m_startTimes;
+		qint64 m_gameTime;
+		qint64 m_plies;
+};
+
+class tst_Tournament: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void tournament_data() const;
+		void tournament();
+};
+
+void tst_Tournament::initTestCase()
+{
+	if (!QFile::exists(MOCKENGINE))
+		QSKIP("The mock engine hasn't been built");
+}
+
+void tst_Tournament::tournament_data() const
+{
+	QTest::addColumn<QString>("protocol");
+	QTest::addColumn<int>("concurrency");
+	QTest::addColumn<int>("infoLines");
+
+	const QStringList protocols = QStringList() << "uci" << "xboard";
+	for (const QString& protocol : protocols)
+	{
+		for (int concurrency : { 1, 4, 16 })
+		{
+			for (int infoLines : { 0, 200 })
+			{
+				const QString name = QString("%1, %2 slots, %3 info lines")
+					.arg(protocol).arg(concurrency).arg(infoLines);
+				QTest::newRow(qPrintable(name))
+					<< protocol << concurrency << infoLines;
+			}
+		}
+	}
+}
+
+void tst_Tournament::tournament()
+{
+	QFETCH(QString, protocol);
+	QFETCH(int, concurrency);
+	QFETCH(int, infoLines);
+
+	const int gameCount = 32;
+	EngineManager engineManager;
+	GameManager manager;
+	manager.setConcurrency(concurrency);
+
+	// Random games are long, so they're cut short as draws
+	GameAdjudicator adjudicator;
+	adjudicator.setMaximumGameLength(100);
+
+	Tournament* tournament = TournamentFactory::create("round-robin",
+							   &manager,
+							   &engineManager,
+							   this);
+	QVERIFY(tournament != nullptr);
+	tournament->setGamesPerEncounter(gameCount);
+	tournament->setAdjudicator(adjudicator);
+	for (int i = 0; i < 2; i++)
+	{
+		EngineConfiguration config(QString("mock%1").arg(i + 1),
+					   MOCKENGINE, protocol);
+		config.setOption("InfoLines", infoLines);
+		tournament->addPlayer(new EngineBuilder(config),
+				      TimeControl("40/60"));
+	}
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	const ProcessUsage startUsage = ProcessUsage::sample(pid);
+	QSignalSpy finishedSpy(tournament, SIGNAL(finished()));
+	GameTimer timer;
+	connect(tournament, SIGNAL(gameStarted(ChessGame*, int, int, int)),
+		&timer, SLOT(onGameStarted(ChessGame*, int)));
+	connect(tournament, SIGNAL(gameFinished(ChessGame*, int, int, int)),
+		&timer, SLOT(onGameFinished(ChessGame*, int)));
+	QBENCHMARK_ONCE
+	{
+		tournament->start();
+		QVERIFY(finishedSpy.wait(600000));
+	}
+	const qint64 elapsed = timer.elapsed();
+	const ProcessUsage usage = ProcessUsage::sample(pid).since(startUsage);
+
+	QCOMPARE(tournament->finishedGameCount(), gameCount);
+	qDebug("%.2f games/s, %.1f ms CPU per game, %.3f ms per ply",
+	       gameCount * 1000.0 / qMax(Q_INT64_C(1), elapsed),
+	       usage.isNull() ? -1.0 : double(usage.cpuTime()) / gameCount,
+	       timer.plyTime());
+	qDebug("Memory: %s", qPrintable(MemoryStats::report()));
+
+	// Every game has been written, so no PGN games are held back
+	QCOMPARE(MemoryStats::current(MemoryStats::PgnBuffer), Q_INT64_C(0));
+
+	// Let the idle engines quit before the manager is destroyed
+	QSignalSpy managerSpy(&manager, SIGNAL(finished()));
+	manager.finish();
+	if (managerSpy.isEmpty())
+		QVERIFY(managerSpy.wait(30000));
+	delete tournament;
+}
+
+QTEST_MAIN(tst_Tournament)
+#include "tst_tournament.moc"
@@ -38,8 +38,12 @@ class QTextStream;
  * JsonParser parses JSON data from a text stream and
  * converts it into a QVariant.
  *
+ * For large documents JsonReader is faster, and it doesn't need to
+ * hold the whole tree in memory.
+ *
  * JSON specification: http://json.org/
  * \sa JsonSerializer
+ * \sa JsonReader
  */
 class LIB_EXPORT JsonParser
 {
@@ -0,0 +1,494 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "jsonreader.h"
+#include <QTextStream>
+
+namespace {
+
+// Number of characters read from the stream at a time
+const qint64 s_blockSize = 64 * 1024;
+
+bool isTerminator(const QChar& c)
+{
+	return c.isSpace() || c == ',' || c == ':' || c == ']' || c == '}';
+}
+
+} // anonymous namespace
+
+
+JsonReader::JsonReader(QTextStream& stream)
+	: m_stream(stream),
+	  m_bufferOffset(0),
+	  m_pos(0),
+	  m_tokenOffset(0),
+	  m_state(ExpectValue),
+	  m_tokenType(NoToken),
+	  m_error(false),
+	  m_currentLine(1),
+	  m_errorLine(0)
+{
+}
+
+JsonReader::TokenType JsonReader::tokenType() const
+{
+	return m_tokenType;
+}
+
+QString JsonReader::text() const
+{
+	return m_text;
+}
+
+QVariant JsonReader::value() const
+{
+	return m_value;
+}
+
+int JsonReader::depth() const
+{
+	return m_containers.size();
+}
+
+qint64 JsonReader::tokenOffset() const
+{
+	return m_tokenOffset;
+}
+
+qint64 JsonReader::characterOffset() const
+{
+	return m_bufferOffset + m_pos;
+}
+
+bool JsonReader::hasError() const
+{
+	return m_error;
+}
+
+QString JsonReader::errorString() const
+{
+	return m_errorString;
+}
+
+qint64 JsonReader::errorLineNumber() const
+{
+	return m_errorLine;
+}
+
+void JsonReader::setError(const QString& message)
+{
+	if (m_error)
+		return;
+
+	m_error = true;
+	m_errorString = message;
+	m_errorLine = m_currentLine;
+	m_tokenType = Invalid;
+}
+
+bool JsonReader::fill()
+{
+	if (m_pos < m_buffer.size())
+		return true;
+
+	m_bufferOffset += m_buffer.size();
+	m_buffer = m_stream.read(s_blockSize);
+	m_pos = 0;
+	return !m_buffer.isEmpty();
+}
+
+bool JsonReader::peekChar(QChar& c)
+{
+	if (!fill())
+		return false;
+
+	c = m_buffer.at(m_pos);
+	return true;
+}
+
+bool JsonReader::nextChar(QChar& c)
+{
+	if (!fill())
+		return false;
+
+	c = m_buffer.at(m_pos++);
+	if (c == '\n')
+		m_currentLine++;
+	return true;
+}
+
+void JsonReader::skipSpace()
+{
+	QChar c;
+	while (peekChar(c) && c.isSpace())
+		nextChar(c);
+}
+
+JsonReader::TokenType JsonReader::setToken(TokenType type)
+{
+	m_tokenType = type;
+	return type;
+}
+
+JsonReader::TokenType JsonReader::readNext()
+{
+	if (m_error)
+		return Invalid;
+
+	m_text.clear();
+	m_value = QVariant();
+
+	if (m_state == Finished)
+		return setToken(EndDocument);
+
+	skipSpace();
+	QChar c;
+	if (!peekChar(c))
+	{
+		setError(tr("Reached EOF unexpectedly"));
+		return Invalid;
+	}
+	m_tokenOffset = characterOffset();
+
+	switch (m_state)
+	{
+	case ExpectValueOrEnd:
+		if (c == ']')
+		{
+			nextChar(c);
+			return endContainer(EndArray);
+		}
+		return readValueToken();
+	case ExpectNameOrEnd:
+		if (c == '}')
+		{
+			nextChar(c);
+			return endContainer(EndObject);
+		}
+		return readName();
+	case ExpectName:
+		return readName();
+	case ExpectCommaOrEnd:
+		{
+			nextChar(c);
+			const bool inObject = (m_containers.last() == StartObject);
+			if (c == ',')
+			{
+				m_state = inObject ? ExpectName : ExpectValue;
+				return readNext();
+			}
+			if (inObject && c == '}')
+				return endContainer(EndObject);
+			if (!inObject && c == ']')
+				return endContainer(EndArray);
+
+			setError(tr("Expected comma or closing bracket instead of: %1")
+				 .arg(c));
+			return Invalid;
+		}
+	default:
+		return readValueToken();
+	}
+}
+
+JsonReader::TokenType JsonReader::endContainer(TokenType type)
+{
+	m_containers.removeLast();
+	m_state = m_containers.isEmpty() ? Finished : ExpectCommaOrEnd;
+	return setToken(type);
+}
+
+JsonReader::TokenType JsonReader::readValueToken()
+{
+	QChar c;
+	peekChar(c);
+
+	switch (c.toLatin1())
+	{
+	case '{':
+		nextChar(c);
+		m_containers.append(StartObject);
+		m_state = ExpectNameOrEnd;
+		return setToken(StartObject);
+	case '[':
+		nextChar(c);
+		m_containers.append(StartArray);
+		m_state = ExpectValueOrEnd;
+		return setToken(StartArray);
+	case '\"':
+		nextChar(c);
+		if (!readString())
+			return Invalid;
+		m_value = m_text;
+		m_state = m_containers.isEmpty() ? Finished : ExpectCommaOrEnd;
+		return setToken(String);
+	case ',':
+	case ':':
+	case ']':
+	case '}':
+		setError(tr("Invalid value: %1").arg(c));
+		return Invalid;
+	default:
+		return readLiteral();
+	}
+}
+
+JsonReader::TokenType JsonReader::readName()
+{
+	QChar c;
+	nextChar(c);
+	if (c != '\"')
+	{
+		setError(tr("Invalid key: %1").arg(c));
+		return Invalid;
+	}
+	if (!readString())
+		return Invalid;
+
+	skipSpace();
+	if (!nextChar(c) || c != ':')
+	{
+		setError(tr("Expected colon instead of: %1").arg(c));
+		return Invalid;
+	}
+
+	m_state = ExpectValue;
+	return setToken(Name);
+}
+
+JsonReader::TokenType JsonReader::readLiteral()
+{
+	QChar c;
+	while (peekChar(c) && !isTerminator(c))
+	{
+		m_text += c;
+		m_pos++;
+	}
+
+	TokenType type = Invalid;
+	if (m_text == "true" || m_text == "false")
+	{
+		type = Bool;
+		m_value = (m_text == "true");
+	}
+	else if (m_text == "null")
+		type = Null;
+	else if (m_text.at(0).isDigit() || m_text.at(0) == '-')
+	{
+		bool ok = false;
+		if (m_text.contains('.')
+		||  m_text.contains('e') || m_text.contains('E'))
+		{
+			m_value = m_text.toDouble(&ok);
+			if (!ok)
+			{
+				setError(tr("Invalid fraction: %1").arg(m_text));
+				return Invalid;
+			}
+		}
+		else
+		{
+			const int val = m_text.toInt(&ok);
+			if (ok)
+				m_value = val;
+			else
+			{
+				const qlonglong longval = m_text.toLongLong(&ok);
+				if (!ok)
+				{
+					setError(tr("Invalid integer: %1").arg(m_text));
+					return Invalid;
+				}
+				m_value = longval;
+			}
+		}
+		type = Number;
+	}
+	else
+	{
+		setError(tr("Unknown token: %1").arg(m_text));
+		return Invalid;
+	}
+
+	m_state = m_containers.isEmpty() ? Finished : ExpectCommaOrEnd;
+	return setToken(type);
+}
+
+bool JsonReader::readString()
+{
+	m_text.clear();
+
+	forever
+	{
+		if (!fill())
+		{
+			setError(tr("Reached EOF unexpectedly"));
+			return false;
+		}
+
+		// Copy the characters up to the next quote or escape
+		// character in one go
+		const QChar* data = m_buffer.constData();
+		const int size = m_buffer.size();
+		const int start = m_pos;
+		while (m_pos < size && data[m_pos] != '\"' && data[m_pos] != '\\')
+		{
+			if (data[m_pos] == '\n')
+				m_currentLine++;
+			m_pos++;
+		}
+		m_text.append(data + start, m_pos - start);
+		if (m_pos >= size)
+			continue;
+
+		if (data[m_pos++] == '\"')
+			return true;
+
+		QChar c;
+		if (!nextChar(c))
+		{
+			setError(tr("Reached EOF unexpectedly"));
+			return false;
+		}
+		switch (c.toLatin1())
+		{
+		case '\"':
+		case '\\':
+		case '/':
+			m_text += c;
+			break;
+		case 'b':
+			m_text += '\b';
+			break;
+		case 'f':
+			m_text += '\f';
+			break;
+		case 'n':
+			m_text += '\n';
+			break;
+		case 'r':
+			m_text += '\r';
+			break;
+		case 't':
+			m_text += '\t';
+			break;
+		case 'u':
+			{
+				QString unicode;
+				for (int i = 0; i < 4; i++)
+				{
+					if (!nextChar(c))
+					{
+						setError(tr("Reached EOF unexpectedly"));
+						return false;
+					}
+					unicode += c;
+				}
+
+				bool ok = false;
+				const int code = unicode.toInt(&ok, 16);
+				if (!ok)
+				{
+					setError(tr("Invalid unicode value: \\u%1")
+						 .arg(unicode));
+					return false;
+				}
+				m_text += QChar(code);
+			}
+			break;
+		default:
+			setError(tr("Unknown escape sequence: \\%1").arg(c));
+			return false;
+		}
+	}
+}
+
+QVariant JsonReader::readValue()
+{
+	switch (m_tokenType)
+	{
+	case StartObject:
+		{
+			QVariantMap map;
+			forever
+			{
+				TokenType type = readNext();
+				if (type == EndObject)
+					return map;
+				if (type != Name)
+					return QVariant();
+
+				const QString name(m_text);
+				if (readNext() == Invalid)
+					return QVariant();
+				const QVariant value(readValue());
+				if (m_error)
+					return QVariant();
+				map.insert(name, value);
+			}
+		}
+	case StartArray:
+		{
+			QVariantList list;
+			forever
+			{
+				TokenType type = readNext();
+				if (type == EndArray)
+					return list;
+				if (type == Invalid)
+					return QVariant();
+
+				const QVariant value(readValue());
+				if (m_error)
+					return QVariant();
+				list.append(value);
+			}
+		}
+	case String:
+	case Number:
+	case Bool:
+	case Null:
+		return m_value;
+	case Invalid:
+		return QVariant();
+	default:
+		setError(tr("Expected a value"));
+		return QVariant();
+	}
+}
+
+bool JsonReader::skipValue()
+{
+	if (m_tokenType != StartObject && m_tokenType != StartArray)
+		return !m_error;
+
+	const int level = depth();
+	while (depth() >= level)
+	{
+		if (readNext() == Invalid)
+			return false;
+	}
+	return true;
+}
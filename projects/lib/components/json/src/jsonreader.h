@@ -0,0 +1,174 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QVariant>
+#include <QVector>
+#include <QCoreApplication>
+
+class QTextStream;
+
+
+/*!
+ * \brief A streaming JSON (JavaScript Object Notation) reader.
+ *
+ * JsonReader is a pull parser: each call to readNext() reads one
+ * token from the stream, so a document can be processed without
+ * building a QVariant tree of all of it. Large arrays can be
+ * handled one element at a time, and values that aren't needed can
+ * be skipped with skipValue(). readValue() converts the current
+ * value into a QVariant when a tree is wanted after all.
+ *
+ * The stream is read in large blocks, which makes JsonReader much
+ * faster than JsonParser even when the whole document is read.
+ *
+ * JSON specification: http://json.org/
+ * \sa JsonParser
+ * \sa JsonWriter
+ */
+class LIB_EXPORT JsonReader
+{
+	Q_DECLARE_TR_FUNCTIONS(JsonReader)
+
+	public:
+		/*! The type of a token. */
+		enum TokenType
+		{
+			NoToken,	//!< Nothing has been read yet
+			Invalid,	//!< An error occured
+			StartObject,	//!< Beginning of an object
+			EndObject,	//!< End of an object
+			StartArray,	//!< Beginning of an array
+			EndArray,	//!< End of an array
+			Name,		//!< The name of an object member
+			String,		//!< A string value
+			Number,		//!< A number value
+			Bool,		//!< A boolean value
+			Null,		//!< A null value
+			EndDocument	//!< The top-level value has been read
+		};
+
+		/*! Creates a new reader that reads data from \a stream. */
+		explicit JsonReader(QTextStream& stream);
+
+		/*!
+		 * Reads the next token and returns its type.
+		 *
+		 * Returns \a Invalid if a parsing error occurs, and
+		 * \a EndDocument after the top-level value.
+		 */
+		TokenType readNext();
+		/*! Returns the type of the current token. */
+		TokenType tokenType() const;
+		/*!
+		 * Returns the text of the current token: the member name
+		 * of a \a Name token, or the contents of a \a String,
+		 * \a Number, \a Bool or \a Null token.
+		 */
+		QString text() const;
+		/*!
+		 * Returns the value of the current \a String, \a Number
+		 * or \a Bool token. Other tokens have a null value.
+		 */
+		QVariant value() const;
+		/*! Returns the number of objects and arrays that are open. */
+		int depth() const;
+		/*!
+		 * Returns the offset of the current token in characters
+		 * from the start of the stream.
+		 */
+		qint64 tokenOffset() const;
+		/*!
+		 * Returns the offset of the first character after the
+		 * current token, or after the value that readValue() or
+		 * skipValue() last read.
+		 */
+		qint64 characterOffset() const;
+
+		/*!
+		 * Reads the value that begins with the current token and
+		 * returns it as a QVariant, in the same form as
+		 * JsonParser::parse() would.
+		 *
+		 * Objects and arrays are read up to and including their
+		 * closing bracket. Returns a null QVariant on error.
+		 */
+		QVariant readValue();
+		/*!
+		 * Skips the value that begins with the current token.
+		 *
+		 * Returns false if a parsing error occurs.
+		 */
+		bool skipValue();
+
+		/*! Returns true if a parsing error occured. */
+		bool hasError() const;
+		/*! Returns a detailed description of the error. */
+		QString errorString() const;
+		/*! Returns the line number on which the error occured. */
+		qint64 errorLineNumber() const;
+
+	private:
+		enum State
+		{
+			ExpectValue,
+			ExpectValueOrEnd,
+			ExpectName,
+			ExpectNameOrEnd,
+			ExpectCommaOrEnd,
+			Finished
+		};
+
+		bool fill();
+		bool peekChar(QChar& c);
+		bool nextChar(QChar& c);
+		void skipSpace();
+		TokenType readValueToken();
+		TokenType readName();
+		TokenType readLiteral();
+		TokenType endContainer(TokenType type);
+		TokenType setToken(TokenType type);
+		bool readString();
+		void setError(const QString& message);
+
+		QTextStream& m_stream;
+		QString m_buffer;
+		qint64 m_bufferOffset;
+		int m_pos;
+		qint64 m_tokenOffset;
+		State m_state;
+		TokenType m_tokenType;
+		QString m_text;
+		QVariant m_value;
+		QVector<TokenType> m_containers;
+		bool m_error;
+		qint64 m_currentLine;
+		qint64 m_errorLine;
+		QString m_errorString;
+};
+
+#endif // JSONREADER_H
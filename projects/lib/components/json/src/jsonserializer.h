@@ -47,19 +47,37 @@ class QTextStream;
  * - QVariant::StringList (JSON array)
  * - any other type that can be converted into a string by QVariant
  *
+ * By default the output is indented for readability. In compact
+ * format everything is written on one line, eg. for JSON lines
+ * files.
+ *
+ * The data is written through a JsonWriter, which can also be used
+ * directly to write large arrays one element at a time.
+ *
  * JSON specification: http://json.org/
  * \sa JsonParser
+ * \sa JsonWriter
  */
 class LIB_EXPORT JsonSerializer
 {
 	Q_DECLARE_TR_FUNCTIONS(JsonSerializer)
 
 	public:
-		/*! Creates a new serializer that operates on \a data. */
-		JsonSerializer(const QVariant& data);
+		/*! The output format. */
+		enum Format
+		{
+			Indented,	//!< One value per line, indented
+			Compact		//!< No whitespace between values
+		};
+
+		/*!
+		 * Creates a new serializer that operates on \a data
+		 * and writes it in \a format.
+		 */
+		JsonSerializer(const QVariant& data, Format format = Indented);
 		/*!
 		 * Converts the data into JSON format and writes it to
-		 * \a stream.
+		 * \a stream, followed by a newline.
 		 *
 		 * Returns false if an invalid or unsupported variant type
 		 * is encountered. Otherwise returns true.
@@ -72,13 +90,11 @@ class LIB_EXPORT JsonSerializer
 		QString errorString() const;
 
 	private:
-		bool serializeNode(QTextStream& stream,
-				   const QVariant& node,
-				   int indentLevel);
 		void setError(const QString& message);
 
 		bool m_error;
 		const QVariant m_data;
+		Format m_format;
 		QString m_errorString;
 };
 
@@ -0,0 +1,269 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "jsonwriter.h"
+#include <QTextStream>
+
+namespace {
+
+bool needsEscape(const QChar& c)
+{
+	return c == '\"' || c == '\\' || c.unicode() < 32 || c.unicode() >= 128;
+}
+
+} // anonymous namespace
+
+
+JsonWriter::JsonWriter(QTextStream& stream, Format format)
+	: m_stream(stream),
+	  m_format(format),
+	  m_afterName(false),
+	  m_error(false)
+{
+}
+
+bool JsonWriter::hasError() const
+{
+	return m_error;
+}
+
+QString JsonWriter::errorString() const
+{
+	return m_errorString;
+}
+
+void JsonWriter::setError(const QString& message)
+{
+	if (m_error)
+		return;
+	m_error = true;
+	m_errorString = message;
+}
+
+void JsonWriter::beginValue()
+{
+	// A member's value follows its name on the same line
+	if (m_afterName)
+	{
+		m_afterName = false;
+		return;
+	}
+	if (m_counts.isEmpty())
+		return;
+
+	if (m_counts.last()++ > 0)
+	{
+		m_stream << ',';
+		if (m_format == Indented)
+			m_stream << '\n';
+	}
+	if (m_format == Indented)
+		m_stream << QString(m_counts.size(), '\t');
+}
+
+void JsonWriter::endValue()
+{
+	if (m_counts.isEmpty())
+		m_stream << '\n';
+}
+
+void JsonWriter::writeStartObject()
+{
+	beginValue();
+	m_stream << '{';
+	if (m_format == Indented)
+		m_stream << '\n';
+	m_counts.append(0);
+}
+
+void JsonWriter::writeEndObject()
+{
+	Q_ASSERT(!m_counts.isEmpty());
+
+	const int count = m_counts.takeLast();
+	if (m_format == Indented)
+	{
+		if (count > 0)
+			m_stream << '\n';
+		m_stream << QString(m_counts.size(), '\t');
+	}
+	m_stream << '}';
+	endValue();
+}
+
+void JsonWriter::writeStartArray()
+{
+	beginValue();
+	m_stream << '[';
+	if (m_format == Indented)
+		m_stream << '\n';
+	m_counts.append(0);
+}
+
+void JsonWriter::writeEndArray()
+{
+	Q_ASSERT(!m_counts.isEmpty());
+
+	const int count = m_counts.takeLast();
+	if (m_format == Indented)
+	{
+		if (count > 0)
+			m_stream << '\n';
+		m_stream << QString(m_counts.size(), '\t');
+	}
+	m_stream << ']';
+	endValue();
+}
+
+void JsonWriter::writeName(const QString& name)
+{
+	Q_ASSERT(!m_counts.isEmpty());
+	Q_ASSERT(!m_afterName);
+
+	beginValue();
+	writeString(name);
+	m_stream << (m_format == Compact ? ":" : " : ");
+	m_afterName = true;
+}
+
+bool JsonWriter::writeValue(const QVariant& value)
+{
+	switch (value.type())
+	{
+	case QVariant::Map:
+		{
+			writeStartObject();
+			const QVariantMap map(value.toMap());
+			for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+			{
+				writeName(it.key());
+				if (!writeValue(it.value()))
+					return false;
+			}
+			writeEndObject();
+		}
+		return true;
+	case QVariant::List:
+	case QVariant::StringList:
+		{
+			writeStartArray();
+			const QVariantList list(value.toList());
+			for (const QVariant& item : list)
+			{
+				if (!writeValue(item))
+					return false;
+			}
+			writeEndArray();
+		}
+		return true;
+	default:
+		break;
+	}
+
+	if (value.type() != QVariant::Invalid
+	&&  value.type() != QVariant::String
+	&&  value.type() != QVariant::ByteArray
+	&&  !value.canConvert(QVariant::String))
+	{
+		setError(tr("Invalid variant type: %1").arg(value.typeName()));
+		return false;
+	}
+
+	beginValue();
+	switch (value.type())
+	{
+	case QVariant::Invalid:
+		m_stream << "null";
+		break;
+	case QVariant::String:
+	case QVariant::ByteArray:
+		writeString(value.toString());
+		break;
+	default:
+		m_stream << value.toString();
+		break;
+	}
+	endValue();
+
+	return true;
+}
+
+void JsonWriter::writeString(const QString& str)
+{
+	m_stream << '\"';
+
+	// Runs of characters that need no escaping are written as is
+	const QChar* data = str.constData();
+	const int size = str.size();
+	int start = 0;
+	for (int i = 0; i < size; i++)
+	{
+		const QChar c = data[i];
+		if (!needsEscape(c))
+			continue;
+
+		if (i > start)
+			m_stream << str.midRef(start, i - start);
+		start = i + 1;
+
+		switch (c.unicode())
+		{
+		case '\"':
+			m_stream << "\\\"";
+			break;
+		case '\\':
+			m_stream << "\\\\";
+			break;
+		case '\b':
+			m_stream << "\\b";
+			break;
+		case '\f':
+			m_stream << "\\f";
+			break;
+		case '\n':
+			m_stream << "\\n";
+			break;
+		case '\r':
+			m_stream << "\\r";
+			break;
+		case '\t':
+			m_stream << "\\t";
+			break;
+		default:
+			if (c.unicode() >= 128)
+			{
+				QString u(QString::number(c.unicode(), 16));
+				m_stream << "\\u" << u.rightJustified(4, '0');
+			}
+			else
+				m_stream << c;
+			break;
+		}
+	}
+	if (start < size)
+		m_stream << str.midRef(start);
+
+	m_stream << '\"';
+}
@@ -0,0 +1,118 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <QCoreApplication>
+
+class QTextStream;
+
+
+/*!
+ * \brief A streaming JSON (JavaScript Object Notation) writer.
+ *
+ * JsonWriter writes JSON data to a text stream as it's produced,
+ * so a large array can be written one element at a time without
+ * first collecting it into a QVariant tree:
+ *
+ * \code
+ * JsonWriter writer(stream);
+ * writer.writeStartObject();
+ * writer.writeName("games");
+ * writer.writeStartArray();
+ * for (const auto& game : games)
+ *	writer.writeValue(game);
+ * writer.writeEndArray();
+ * writer.writeEndObject();
+ * \endcode
+ *
+ * The output is identical to JsonSerializer's output for the same
+ * data, including the newline after the top-level value.
+ *
+ * JSON specification: http://json.org/
+ * \sa JsonSerializer
+ * \sa JsonReader
+ */
+class LIB_EXPORT JsonWriter
+{
+	Q_DECLARE_TR_FUNCTIONS(JsonWriter)
+
+	public:
+		/*! The output format. */
+		enum Format
+		{
+			Indented,	//!< One value per line, indented
+			Compact		//!< No whitespace between values
+		};
+
+		/*! Creates a new writer that writes to \a stream in \a format. */
+		explicit JsonWriter(QTextStream& stream, Format format = Indented);
+
+		/*! Begins a new object. */
+		void writeStartObject();
+		/*! Closes the current object. */
+		void writeEndObject();
+		/*! Begins a new array. */
+		void writeStartArray();
+		/*! Closes the current array. */
+		void writeEndArray();
+		/*!
+		 * Writes the member name \a name in the current object.
+		 * The member's value must be written next.
+		 */
+		void writeName(const QString& name);
+		/*!
+		 * Writes \a value, which can be a tree of the types
+		 * supported by JsonSerializer.
+		 *
+		 * Returns false if an invalid or unsupported variant type
+		 * is encountered. Otherwise returns true.
+		 */
+		bool writeValue(const QVariant& value);
+
+		/*! Returns true if an error occured. */
+		bool hasError() const;
+		/*! Returns a detailed description of the error. */
+		QString errorString() const;
+
+	private:
+		void beginValue();
+		void endValue();
+		void writeString(const QString& str);
+		void setError(const QString& message);
+
+		QTextStream& m_stream;
+		Format m_format;
+		QVector<int> m_counts;
+		bool m_afterName;
+		bool m_error;
+		QString m_errorString;
+};
+
+#endif // JSONWRITER_H
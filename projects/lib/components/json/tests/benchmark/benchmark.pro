@@ -0,0 +1,4 @@
+TARGET = tst_jsonbenchmark
+
+include(../tests.pri)
+SOURCES += tst_jsonbenchmark.cpp
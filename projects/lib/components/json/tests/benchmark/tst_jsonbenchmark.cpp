@@ -0,0 +1,167 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <QtTest/QtTest>
+#include <jsonparser.h>
+#include <jsonreader.h>
+#include <jsonserializer.h>
+#include <jsonwriter.h>
+
+/*
+ * Compares the QVariant tree based JsonParser and JsonSerializer with
+ * the streaming JsonReader and JsonWriter on a tournament file with
+ * a large "matchProgress" array.
+ */
+class tst_JsonBenchmark: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+
+		void parseTree() const;
+		void readTree() const;
+		void readStream() const;
+		void serializeTree() const;
+		void writeStream() const;
+
+	private:
+		QVariantMap game(int index) const;
+
+		QVariantMap m_data;
+		QString m_json;
+};
+
+
+QVariantMap tst_JsonBenchmark::game(int index) const
+{
+	QVariantMap game;
+	game["index"] = index;
+	game["white"] = "Engine A";
+	game["black"] = "Engine B";
+	game["startingFen"] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	game["result"] = (index % 3 == 0) ? "1/2-1/2" : "1-0";
+	game["terminationDetails"] = "White mates";
+	game["gameDuration"] = "00:01:23";
+	game["finalFen"] = "6k1/5ppp/8/8/8/8/5PPP/3R2K1 b - - 1 40";
+	return game;
+}
+
+void tst_JsonBenchmark::initTestCase()
+{
+	QVariantList progress;
+	for (int i = 1; i <= 20000; i++)
+		progress << game(i);
+
+	QVariantMap settings;
+	settings["concurrency"] = 4;
+	settings["rounds"] = 10000;
+	settings["event"] = "Benchmark";
+
+	m_data["tournamentSettings"] = settings;
+	m_data["matchProgress"] = progress;
+
+	QTextStream stream(&m_json, QIODevice::WriteOnly);
+	JsonSerializer serializer(m_data);
+	QVERIFY(serializer.serialize(stream));
+}
+
+void tst_JsonBenchmark::parseTree() const
+{
+	QBENCHMARK
+	{
+		QString json(m_json);
+		QTextStream stream(&json, QIODevice::ReadOnly);
+		JsonParser parser(stream);
+		const QVariant data(parser.parse());
+		QVERIFY(!parser.hasError());
+	}
+}
+
+void tst_JsonBenchmark::readTree() const
+{
+	QBENCHMARK
+	{
+		QString json(m_json);
+		QTextStream stream(&json, QIODevice::ReadOnly);
+		JsonReader reader(stream);
+		reader.readNext();
+		const QVariant data(reader.readValue());
+		QVERIFY(!reader.hasError());
+	}
+}
+
+void tst_JsonBenchmark::readStream() const
+{
+	QBENCHMARK
+	{
+		QString json(m_json);
+		QTextStream stream(&json, QIODevice::ReadOnly);
+		JsonReader reader(stream);
+		int count = 0;
+		while (reader.readNext() != JsonReader::EndDocument)
+		{
+			QVERIFY(!reader.hasError());
+			if (reader.tokenType() == JsonReader::Name
+			&&  reader.text() == "index")
+				count++;
+		}
+		QCOMPARE(count, 20000);
+	}
+}
+
+void tst_JsonBenchmark::serializeTree() const
+{
+	QBENCHMARK
+	{
+		QString json;
+		QTextStream stream(&json, QIODevice::WriteOnly);
+		JsonSerializer serializer(m_data);
+		QVERIFY(serializer.serialize(stream));
+	}
+}
+
+void tst_JsonBenchmark::writeStream() const
+{
+	QBENCHMARK
+	{
+		QString json;
+		QTextStream stream(&json, QIODevice::WriteOnly);
+		JsonWriter writer(stream);
+		writer.writeStartObject();
+		writer.writeName("matchProgress");
+		writer.writeStartArray();
+		for (int i = 1; i <= 20000; i++)
+			writer.writeValue(game(i));
+		writer.writeEndArray();
+		writer.writeName("tournamentSettings");
+		writer.writeValue(m_data.value("tournamentSettings"));
+		writer.writeEndObject();
+		QVERIFY(!writer.hasError());
+	}
+}
+
+QTEST_MAIN(tst_JsonBenchmark)
+#include "tst_jsonbenchmark.moc"
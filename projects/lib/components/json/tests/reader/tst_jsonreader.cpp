@@ -0,0 +1,231 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <QtTest/QtTest>
+#include <jsonparser.h>
+#include <jsonreader.h>
+
+class tst_JsonReader: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void tokens() const;
+		void skipValue() const;
+		void offsets() const;
+
+		void values_data() const;
+		void values() const;
+
+		void invalid_data() const;
+		void invalid() const;
+
+		void errorLine() const;
+		void longString() const;
+};
+
+
+void tst_JsonReader::tokens() const
+{
+	QString input("{ \"name\" : \"foo\", \"list\" : [1, 2.5, true, null] }");
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+
+	QCOMPARE(reader.tokenType(), JsonReader::NoToken);
+	QCOMPARE(reader.readNext(), JsonReader::StartObject);
+	QCOMPARE(reader.depth(), 1);
+	QCOMPARE(reader.readNext(), JsonReader::Name);
+	QCOMPARE(reader.text(), QString("name"));
+	QCOMPARE(reader.readNext(), JsonReader::String);
+	QCOMPARE(reader.value(), QVariant("foo"));
+	QCOMPARE(reader.readNext(), JsonReader::Name);
+	QCOMPARE(reader.text(), QString("list"));
+	QCOMPARE(reader.readNext(), JsonReader::StartArray);
+	QCOMPARE(reader.depth(), 2);
+	QCOMPARE(reader.readNext(), JsonReader::Number);
+	QCOMPARE(reader.value(), QVariant(1));
+	QCOMPARE(reader.readNext(), JsonReader::Number);
+	QCOMPARE(reader.value(), QVariant(2.5));
+	QCOMPARE(reader.readNext(), JsonReader::Bool);
+	QCOMPARE(reader.value(), QVariant(true));
+	QCOMPARE(reader.readNext(), JsonReader::Null);
+	QVERIFY(reader.value().isNull());
+	QCOMPARE(reader.readNext(), JsonReader::EndArray);
+	QCOMPARE(reader.depth(), 1);
+	QCOMPARE(reader.readNext(), JsonReader::EndObject);
+	QCOMPARE(reader.depth(), 0);
+	QCOMPARE(reader.readNext(), JsonReader::EndDocument);
+	QVERIFY(!reader.hasError());
+}
+
+void tst_JsonReader::skipValue() const
+{
+	QString input("{ \"a\" : [1, {\"b\" : [[]]}], \"c\" : \"d\" }");
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+
+	QCOMPARE(reader.readNext(), JsonReader::StartObject);
+	QCOMPARE(reader.readNext(), JsonReader::Name);
+	QCOMPARE(reader.readNext(), JsonReader::StartArray);
+	QVERIFY(reader.skipValue());
+	QCOMPARE(reader.tokenType(), JsonReader::EndArray);
+	QCOMPARE(reader.depth(), 1);
+	QCOMPARE(reader.readNext(), JsonReader::Name);
+	QCOMPARE(reader.text(), QString("c"));
+	QCOMPARE(reader.readNext(), JsonReader::String);
+	QVERIFY(reader.skipValue());
+	QCOMPARE(reader.readNext(), JsonReader::EndObject);
+}
+
+void tst_JsonReader::offsets() const
+{
+	// The whitespace pushes the values past the first block
+	QString input = "[" + QString(70000, ' ') + "{\"a\": 1}, \"xy\" ]";
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+
+	QCOMPARE(reader.readNext(), JsonReader::StartArray);
+	QCOMPARE(reader.tokenOffset(), qint64(0));
+	QCOMPARE(reader.readNext(), JsonReader::StartObject);
+	QCOMPARE(reader.tokenOffset(), qint64(70001));
+	QVERIFY(reader.skipValue());
+	QCOMPARE(reader.characterOffset(), qint64(70009));
+	QCOMPARE(reader.readNext(), JsonReader::String);
+	QCOMPARE(reader.tokenOffset(), qint64(70011));
+	QCOMPARE(reader.characterOffset(), qint64(70015));
+	QCOMPARE(input.mid(70001, 8), QString("{\"a\": 1}"));
+}
+
+void tst_JsonReader::values_data() const
+{
+	QTest::addColumn<QString>("input");
+
+	QTest::newRow("null") << "null";
+	QTest::newRow("true") << "true";
+	QTest::newRow("false") << "false";
+	QTest::newRow("int") << "1234567890";
+	QTest::newRow("negative int") << "-1234567890";
+	QTest::newRow("64-bit int") << "3567830610840546163";
+	QTest::newRow("double") << "-0.012";
+	QTest::newRow("string") << "\"Path = \\\"C:\\\\Program files\\\\foo\\\"\"";
+	QTest::newRow("escapes") << "\"\\/\\b\\f\\n\\r\\t\"";
+	QTest::newRow("unicode") << "\"\\u2654\\u2659 x\"";
+	QTest::newRow("empty object") << "{ }";
+	QTest::newRow("empty array") << "[ ]";
+	QTest::newRow("object")
+		<< "{ \"foo\" : \"bar\", \"number\" : -25, \"state\" : null }";
+	QTest::newRow("nested")
+		<< "[\n\t{ \"a\" : [1, 2, [3]] },\n\t{ \"b\" : {} },\n\t\"c\"\n]";
+}
+
+void tst_JsonReader::values() const
+{
+	QFETCH(QString, input);
+
+	QTextStream parserStream(&input, QIODevice::ReadOnly);
+	JsonParser parser(parserStream);
+	const QVariant expected(parser.parse());
+	QVERIFY(!parser.hasError());
+
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+	reader.readNext();
+	const QVariant data(reader.readValue());
+	QVERIFY(!reader.hasError());
+
+	QCOMPARE(data.type(), expected.type());
+	QCOMPARE(data, expected);
+	QCOMPARE(reader.readNext(), JsonReader::EndDocument);
+}
+
+void tst_JsonReader::invalid_data() const
+{
+	QTest::addColumn<QString>("input");
+
+	QTest::newRow("empty") << "";
+	QTest::newRow("invalid #1") << "random text";
+	QTest::newRow("invalid #2") << "\"endquote missing";
+	QTest::newRow("invalid #3") << "+256";
+	QTest::newRow("invalid #4") << "256x";
+	QTest::newRow("invalid #5") << "100.3.4";
+	QTest::newRow("invalid #6") << "\"\\u005 \"";
+	QTest::newRow("invalid #7") << "\"\\uffgg\"";
+	QTest::newRow("invalid #8") << "{";
+	QTest::newRow("invalid #9") << "[";
+	QTest::newRow("invalid #10") << "}";
+	QTest::newRow("invalid #11") << "]";
+	QTest::newRow("invalid #12") << "{ ]";
+	QTest::newRow("invalid #13") << "[ }";
+	QTest::newRow("invalid #14") << "{ null }";
+	QTest::newRow("invalid #15") << "{ \"id\" : 1, }";
+	QTest::newRow("invalid #16") << "{ \"id\" : ,0 }";
+	QTest::newRow("invalid #17") << "[ , ]";
+	QTest::newRow("invalid #18") << "[ \"id\" : 1 ]";
+	QTest::newRow("invalid #19") << "[ null, ]";
+	QTest::newRow("invalid #20") << "[ 1 2 ]";
+}
+
+void tst_JsonReader::invalid() const
+{
+	QFETCH(QString, input);
+
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+	reader.readNext();
+	const QVariant data(reader.readValue());
+
+	QVERIFY(data.isNull());
+	QVERIFY(reader.hasError());
+	QVERIFY(!reader.errorString().isEmpty());
+	QCOMPARE(reader.readNext(), JsonReader::Invalid);
+}
+
+void tst_JsonReader::errorLine() const
+{
+	QString input("[\n\t1,\n\t2,\n}");
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+
+	reader.readNext();
+	reader.readValue();
+	QVERIFY(reader.hasError());
+	QCOMPARE(reader.errorLineNumber(), qint64(4));
+}
+
+void tst_JsonReader::longString() const
+{
+	// The string spans several blocks read from the stream
+	QString text(200000, 'x');
+	text[100000] = '\n';
+	QString input = "\"" + text + "\\n\"";
+	QTextStream stream(&input, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+
+	QCOMPARE(reader.readNext(), JsonReader::String);
+	QCOMPARE(reader.text(), text + "\n");
+}
+
+QTEST_MAIN(tst_JsonReader)
+#include "tst_jsonreader.moc"
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = parser serializer
+SUBDIRS = parser serializer reader writer benchmark
@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <QtTest/QtTest>
+#include <QSize>
+#include <jsonserializer.h>
+#include <jsonwriter.h>
+
+class tst_JsonWriter: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void streaming_data() const;
+		void streaming() const;
+		void scalar() const;
+		void invalidType() const;
+};
+
+
+void tst_JsonWriter::streaming_data() const
+{
+	QTest::addColumn<int>("format");
+
+	QTest::newRow("indented") << int(JsonWriter::Indented);
+	QTest::newRow("compact") << int(JsonWriter::Compact);
+}
+
+void tst_JsonWriter::streaming() const
+{
+	QFETCH(int, format);
+
+	QVariantMap game;
+	game["index"] = 1;
+	game["result"] = "1-0";
+	game["terminationDetails"] = "White mates";
+
+	QVariantList games;
+	games << game << game << QVariantMap() << QVariantList();
+
+	QVariantMap settings;
+	settings["rounds"] = 2;
+	settings["event"] = "Test \"event\"\n";
+
+	QVariantMap data;
+	data["settings"] = settings;
+	data["matchProgress"] = games;
+	data["empty"] = QVariantList();
+
+	QString expected;
+	QTextStream expectedStream(&expected, QIODevice::WriteOnly);
+	JsonSerializer serializer(data, format == JsonWriter::Compact
+					? JsonSerializer::Compact
+					: JsonSerializer::Indented);
+	QVERIFY(serializer.serialize(expectedStream));
+	expectedStream.flush();
+
+	// The same data, with the array written one element at a time
+	QString str;
+	QTextStream stream(&str, QIODevice::WriteOnly);
+	JsonWriter writer(stream, JsonWriter::Format(format));
+	writer.writeStartObject();
+	writer.writeName("empty");
+	writer.writeStartArray();
+	writer.writeEndArray();
+	writer.writeName("matchProgress");
+	writer.writeStartArray();
+	for (const QVariant& item : games)
+		QVERIFY(writer.writeValue(item));
+	writer.writeEndArray();
+	writer.writeName("settings");
+	QVERIFY(writer.writeValue(settings));
+	writer.writeEndObject();
+	stream.flush();
+
+	QVERIFY(!writer.hasError());
+	QCOMPARE(str, expected);
+}
+
+void tst_JsonWriter::scalar() const
+{
+	QString str;
+	QTextStream stream(&str, QIODevice::WriteOnly);
+	JsonWriter writer(stream);
+	QVERIFY(writer.writeValue(QString("\\u2654 %1").arg(QChar(0x2654))));
+	stream.flush();
+
+	QCOMPARE(str, QString("\"\\\\u2654 \\u2654\"\n"));
+}
+
+void tst_JsonWriter::invalidType() const
+{
+	QString str;
+	QTextStream stream(&str, QIODevice::WriteOnly);
+	JsonWriter writer(stream);
+
+	QVERIFY(!writer.writeValue(QSize(1, 2)));
+	QVERIFY(writer.hasError());
+	QVERIFY(!writer.errorString().isEmpty());
+}
+
+QTEST_MAIN(tst_JsonWriter)
+#include "tst_jsonwriter.moc"
@@ -1,2 +1,4 @@
 INCLUDEPATH += $$PWD/src $$PWD/components/json/src
 LIBS += -lcutechess -L$$PWD
+QT += network
+win32:LIBS += -lpsapi
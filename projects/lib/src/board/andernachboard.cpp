@@ -94,6 +94,11 @@ bool AndernachBoard::switchesSides(const Move& move) const
 	&&     pieceAt(move.sourceSquare()).type() != King;
 }
 
+bool AndernachBoard::variantHasLegalMoveGenerator() const
+{
+	return false;
+}
+
 
 
 AntiAndernachBoard::AntiAndernachBoard()
@@ -46,6 +46,11 @@ bool AntiBoard::hasCastling() const
 	return false;
 }
 
+bool AntiBoard::variantHasLegalMoveGenerator() const
+{
+	return false;
+}
+
 bool AntiBoard::kingsCountAssertion( int whiteKings,
 				     int blackKings) const
 {
@@ -57,7 +62,7 @@ bool AntiBoard::kingsCountAssertion( int whiteKings,
 
 void AntiBoard::addPromotions(int sourceSquare,
 				int targetSquare,
-				QVarLengthArray<Move>& moves) const
+				MoveList& moves) const
 {
 	StandardBoard::addPromotions(sourceSquare, targetSquare, moves);
 	moves.append(Move(sourceSquare, targetSquare, King));
@@ -88,7 +93,7 @@ bool AntiBoard::vIsLegalMove(const Move& move)
 	{
 		m_testKey = key();
 		m_canCapture = false;
-		QVarLengthArray<Move> moves;
+		MoveList moves;
 		generateMoves(moves);
 
 		// search for any legal capture move
@@ -106,6 +111,41 @@ bool AntiBoard::vIsLegalMove(const Move& move)
 	return !m_canCapture;
 }
 
+bool AntiBoard::generateLegalMoves(MoveList& moves, bool firstOnly)
+{
+	generateMoves(moves);
+
+	// Captures are compulsory, so the quiet moves are only
+	// tested if there are no legal captures
+	int count = 0;
+	for (int i = 0; i < moves.size(); i++)
+	{
+		if (captureType(moves[i]) != Piece::NoPiece
+		&&  StandardBoard::vIsLegalMove(moves[i]))
+		{
+			moves[count++] = moves[i];
+			if (firstOnly)
+				break;
+		}
+	}
+
+	m_testKey = key();
+	m_canCapture = (count > 0);
+
+	for (int i = 0; i < moves.size() && !m_canCapture; i++)
+	{
+		if (StandardBoard::vIsLegalMove(moves[i]))
+		{
+			moves[count++] = moves[i];
+			if (firstOnly)
+				break;
+		}
+	}
+	moves.resize(count);
+
+	return true;
+}
+
 Result AntiBoard::vResultOfStalemate() const
 {
 	Side winner = sideToMove();
@@ -68,9 +68,11 @@ class LIB_EXPORT AntiBoard : public StandardBoard
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool inCheck(Side side, int square = 0) const;
 		virtual bool vIsLegalMove(const Move& move);
+		virtual bool generateLegalMoves(MoveList& moves, bool firstOnly);
+		virtual bool variantHasLegalMoveGenerator() const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray<Move>& moves) const;
+					   MoveList& moves) const;
 
 		/*! Rules stalemate outcome. */
 		virtual Result vResultOfStalemate() const;
@@ -25,8 +25,6 @@ namespace Chess {
 AtomicBoard::AtomicBoard()
 	: WesternBoard(new WesternZobrist())
 {
-	for (int i = 0; i < 8; i++)
-		m_offsets[i] = 0;
 }
 
 Board* AtomicBoard::copy() const
@@ -49,19 +47,9 @@ bool AtomicBoard::kingCanCapture() const
 	return false;
 }
 
-void AtomicBoard::vInitialize()
+bool AtomicBoard::variantHasBitboards() const
 {
-	int arwidth = width() + 2;
-	m_offsets[0] = -arwidth - 1;
-	m_offsets[1] = -arwidth;
-	m_offsets[2] = -arwidth + 1;
-	m_offsets[3] = -1;
-	m_offsets[4] = 1;
-	m_offsets[5] = arwidth - 1;
-	m_offsets[6] = arwidth;
-	m_offsets[7] = arwidth + 1;
-
-	WesternBoard::vInitialize();
+	return true;
 }
 
 bool AtomicBoard::vSetFenString(const QStringList& fen)
@@ -70,20 +58,20 @@ bool AtomicBoard::vSetFenString(const QStringList& fen)
 	return WesternBoard::vSetFenString(fen);
 }
 
-bool AtomicBoard::inCheck(Side side, int square) const
+Bitboard AtomicBoard::blastZone(int square) const
 {
-	if (square == 0)
-	{
-		int kingSq = kingSquare(side);
+	// The squares next to a square are the squares a king attacks
+	int bit = Bitboards::bitIndex(square);
+	return (bit != -1) ? Bitboards::kingAttacks(bit) : 0;
+}
 
-		// If the kings touch, there's no check
-		for (int i = 0; i < 8; i++)
-		{
-			Piece pc = pieceAt(kingSq + m_offsets[i]);
-			if (pc.type() == King)
-				return false;
-		}
-	}
+bool AtomicBoard::inCheck(Side side, int square) const
+{
+	// If the kings touch, there's no check
+	if (square == 0
+	&&  (blastZone(kingSquare(side))
+	     & pieceBitboard(side.opposite(), King)) != 0)
+		return false;
 
 	return WesternBoard::inCheck(side, square);
 }
@@ -94,22 +82,15 @@ bool AtomicBoard::vIsLegalMove(const Move& move)
 
 	if (captureType(move) != Piece::NoPiece)
 	{
-		bool explodeOppKing = false;
-		int target = move.targetSquare();
-		for (int i = 0; i < 8; i++)
-		{
-			Piece pc = pieceAt(target + m_offsets[i]);
-			if (pc.type() == King)
-			{
-				// Can't explode your own king
-				if (pc.side() == sideToMove())
-					return false;
-				explodeOppKing = true;
-			}
-		}
+		Side side = sideToMove();
+		Bitboard blast = blastZone(move.targetSquare());
+
+		// Can't explode your own king
+		if (blast & pieceBitboard(side, King))
+			return false;
 		// The move is always legal if the enemy king
 		// is in the blast zone and own king is safe
-		if (explodeOppKing)
+		if (blast & pieceBitboard(side.opposite(), King))
 			return true;
 	}
 
@@ -121,6 +102,7 @@ void AtomicBoard::vMakeMove(const Move& move, BoardTransition* transition)
 	MoveData md;
 	md.isCapture = (captureType(move) != Piece::NoPiece);
 	md.piece = pieceAt(move.sourceSquare());
+	md.explodedCount = 0;
 
 	WesternBoard::vMakeMove(move, transition);
 
@@ -128,14 +110,17 @@ void AtomicBoard::vMakeMove(const Move& move, BoardTransition* transition)
 	{
 		int target = move.targetSquare();
 		setSquare(target, Piece::NoPiece);
-		for (int i = 0; i < 8; i++)
+
+		// Pawns survive the explosion
+		Bitboard blast = blastZone(target) & occupiedBitboard()
+			       & ~pieceBitboard(Side::White, Pawn)
+			       & ~pieceBitboard(Side::Black, Pawn);
+		while (blast)
 		{
-			int sq = target + m_offsets[i];
-			Piece& pc = md.captures[i];
-			pc = pieceAt(sq);
-			if (pc.isWall() || pc.type() == Pawn)
-				continue;
-			
+			int sq = Bitboards::squareIndex(Bitboards::popLsb(blast));
+			md.explodedSquares[md.explodedCount] = sq;
+			md.explodedPieces[md.explodedCount++] = pieceAt(sq);
+
 			removeCastlingRights(sq);
 			setSquare(sq, Piece::NoPiece);
 
@@ -149,7 +134,6 @@ void AtomicBoard::vMakeMove(const Move& move, BoardTransition* transition)
 void AtomicBoard::vUndoMove(const Move& move)
 {
 	int source = move.sourceSquare();
-	int target = move.targetSquare();
 
 	WesternBoard::vUndoMove(move);
 
@@ -157,17 +141,21 @@ void AtomicBoard::vUndoMove(const Move& move)
 	if (md.isCapture)
 	{
 		setSquare(source, md.piece);
-		for (int i = 0; i < 8; i++)
-		{
-			int sq = target + m_offsets[i];
-			if (md.captures[i].isValid())
-				setSquare(sq, md.captures[i]);
-		}
+		for (int i = 0; i < md.explodedCount; i++)
+			setSquare(md.explodedSquares[i], md.explodedPieces[i]);
 	}
 
 	m_history.pop_back();
 }
 
+void AtomicBoard::vRestore(const Board& other)
+{
+	WesternBoard::vRestore(other);
+
+	const AtomicBoard& board = static_cast<const AtomicBoard&>(other);
+	m_history = board.m_history;
+}
+
 Result AtomicBoard::result()
 {
 	Side side(sideToMove());
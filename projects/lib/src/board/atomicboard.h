@@ -44,7 +44,7 @@ class LIB_EXPORT AtomicBoard : public WesternBoard
 
 	protected:
 		// Inherited from WesternBoard
-		virtual void vInitialize();
+		virtual bool variantHasBitboards() const;
 		virtual bool inCheck(Side side, int square = 0) const;
 		virtual bool kingCanCapture() const;
 		virtual bool vSetFenString(const QStringList& fen);
@@ -52,17 +52,21 @@ class LIB_EXPORT AtomicBoard : public WesternBoard
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
+		virtual void vRestore(const Board& other);
 
 	private:
 		struct MoveData
 		{
 			bool isCapture;
 			Piece piece;
-			Piece captures[8];
+			int explodedCount;
+			int explodedSquares[8];
+			Piece explodedPieces[8];
 		};
 
+		Bitboard blastZone(int square) const;
+
 		QVector<MoveData> m_history;
-		int m_offsets[8];
 };
 
 } // namespace Chess
@@ -0,0 +1,310 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bitboard.h"
+#include <QMutex>
+#include <QMutexLocker>
+#if defined(Q_PROCESSOR_X86_64) && (defined(Q_CC_GNU) || defined(Q_CC_MSVC))
+#define BITBOARD_PEXT
+#include <immintrin.h>
+#endif
+
+namespace {
+
+QMutex s_mutex;
+
+// Returns the squares reached by stepping (df, dr) once from
+// (file, rank), or 0 if the step leaves the board.
+Chess::Bitboard step(int file, int rank, int df, int dr)
+{
+	file += df;
+	rank += dr;
+	if (file < 0 || file > 7 || rank < 0 || rank > 7)
+		return 0;
+	return Q_UINT64_C(1) << (rank * 8 + file);
+}
+
+// A xorshift64* generator for finding the magic numbers. The seed is
+// fixed so that the tables are always the same.
+class MagicRandom
+{
+	public:
+		MagicRandom() : m_state(Q_UINT64_C(0x9e3779b97f4a7c15)) {}
+
+		quint64 next()
+		{
+			m_state ^= m_state >> 12;
+			m_state ^= m_state << 25;
+			m_state ^= m_state >> 27;
+			return m_state * Q_UINT64_C(2685821657736338717);
+		}
+		// Returns a random number with only a few bits set, which
+		// makes a good magic candidate.
+		quint64 sparse()
+		{
+			return next() & next() & next();
+		}
+
+	private:
+		quint64 m_state;
+};
+
+} // anonymous namespace
+
+namespace Chess {
+
+bool Bitboards::s_initialized = false;
+bool Bitboards::s_usePext = false;
+int Bitboards::s_bitIndex[120];
+int Bitboards::s_squareIndex[64];
+Bitboard Bitboards::s_knightAttacks[64];
+Bitboard Bitboards::s_kingAttacks[64];
+Bitboard Bitboards::s_pawnAttacks[2][64];
+Bitboard Bitboards::s_rays[DirectionCount][64];
+Bitboards::Magic Bitboards::s_bishopMagics[64];
+Bitboards::Magic Bitboards::s_rookMagics[64];
+Bitboard Bitboards::s_bishopTable[5248];
+Bitboard Bitboards::s_rookTable[102400];
+Bitboard Bitboards::s_between[64][64];
+Bitboard Bitboards::s_line[64][64];
+
+void Bitboards::initialize()
+{
+	QMutexLocker locker(&s_mutex);
+
+	if (s_initialized)
+		return;
+
+	// The mailbox is 10 squares wide with two wall ranks above
+	// and below the board, and rank 8 is stored first.
+	for (int i = 0; i < 120; i++)
+		s_bitIndex[i] = -1;
+	for (int rank = 0; rank < 8; rank++)
+	{
+		for (int file = 0; file < 8; file++)
+		{
+			int square = (9 - rank) * 10 + 1 + file;
+			int bit = rank * 8 + file;
+			s_bitIndex[square] = bit;
+			s_squareIndex[bit] = square;
+		}
+	}
+
+	static const int knightSteps[8][2] = {
+		{ 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 },
+		{ -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 }
+	};
+	static const int raySteps[DirectionCount][2] = {
+		{ 0, 1 }, { 1, 0 }, { 1, 1 }, { -1, 1 },
+		{ 0, -1 }, { -1, 0 }, { 1, -1 }, { -1, -1 }
+	};
+
+	for (int bit = 0; bit < 64; bit++)
+	{
+		int file = bit % 8;
+		int rank = bit / 8;
+
+		Bitboard knight = 0;
+		for (const auto& s: knightSteps)
+			knight |= step(file, rank, s[0], s[1]);
+		s_knightAttacks[bit] = knight;
+
+		Bitboard king = 0;
+		for (const auto& s: raySteps)
+			king |= step(file, rank, s[0], s[1]);
+		s_kingAttacks[bit] = king;
+
+		s_pawnAttacks[Side::White][bit] = step(file, rank, -1, 1)
+						| step(file, rank, 1, 1);
+		s_pawnAttacks[Side::Black][bit] = step(file, rank, -1, -1)
+						| step(file, rank, 1, -1);
+
+		for (int dir = 0; dir < DirectionCount; dir++)
+		{
+			Bitboard ray = 0;
+			int df = raySteps[dir][0];
+			int dr = raySteps[dir][1];
+			for (int i = 1; i < 8; i++)
+			{
+				Bitboard b = step(file, rank, df * i, dr * i);
+				if (b == 0)
+					break;
+				ray |= b;
+			}
+			s_rays[dir][bit] = ray;
+		}
+	}
+
+	static const Direction bishopDirs[] = {
+		NorthEast, NorthWest, SouthEast, SouthWest, DirectionCount
+	};
+	static const Direction rookDirs[] = {
+		North, East, South, West, DirectionCount
+	};
+
+	// Lines and the squares between two aligned squares. The
+	// opposite of direction 'dir' is 'opposite[dir]'.
+	static const Direction opposite[DirectionCount] = {
+		South, West, SouthWest, SouthEast,
+		North, East, NorthWest, NorthEast
+	};
+	for (int bit1 = 0; bit1 < 64; bit1++)
+	{
+		for (int bit2 = 0; bit2 < 64; bit2++)
+		{
+			s_between[bit1][bit2] = 0;
+			s_line[bit1][bit2] = 0;
+		}
+		for (int dir = 0; dir < DirectionCount; dir++)
+		{
+			Bitboard ray = s_rays[dir][bit1];
+			Bitboard fullLine = ray
+					  | s_rays[opposite[dir]][bit1]
+					  | bit(bit1);
+			for (Bitboard b = ray; b != 0; )
+			{
+				int bit2 = popLsb(b);
+				s_between[bit1][bit2] = (ray ^ s_rays[dir][bit2])
+							& ~bit(bit2);
+				s_line[bit1][bit2] = fullLine;
+			}
+		}
+	}
+
+	s_usePext = cpuHasPext();
+	initMagics(bishopDirs, s_bishopMagics, s_bishopTable);
+	initMagics(rookDirs, s_rookMagics, s_rookTable);
+
+	s_initialized = true;
+}
+
+Bitboard Bitboards::rayAttacks(Direction dir, int bit, Bitboard occupied)
+{
+	Bitboard attacks = s_rays[dir][bit];
+	Bitboard blockers = attacks & occupied;
+	if (blockers != 0)
+	{
+		int first = (dir < South) ? lsb(blockers) : msb(blockers);
+		attacks ^= s_rays[dir][first];
+	}
+	return attacks;
+}
+
+void Bitboards::initMagics(const Direction* dirs,
+			   Magic* magics,
+			   Bitboard* table)
+{
+	static const Bitboard rank1 = Q_UINT64_C(0x00000000000000ff);
+	static const Bitboard rank8 = Q_UINT64_C(0xff00000000000000);
+	static const Bitboard fileA = Q_UINT64_C(0x0101010101010101);
+	static const Bitboard fileH = Q_UINT64_C(0x8080808080808080);
+
+	MagicRandom random;
+	Bitboard occupancy[4096];
+	Bitboard reference[4096];
+	int epoch[4096] = {};
+	int attempt = 0;
+
+	for (int bit = 0; bit < 64; bit++)
+	{
+		Magic& m = magics[bit];
+
+		// The edge squares don't affect the attacks unless the
+		// piece is on the same edge
+		Bitboard edges = ((rank1 | rank8) & ~(rank1 << (bit / 8 * 8)))
+			       | ((fileA | fileH) & ~(fileA << (bit % 8)));
+		Bitboard mask = 0;
+		for (int i = 0; dirs[i] != DirectionCount; i++)
+			mask |= s_rays[dirs[i]][bit];
+		m.mask = mask & ~edges;
+		m.shift = 64 - popCount(m.mask);
+		m.attacks = table;
+
+		// Enumerate all subsets of the mask with the
+		// Carry-Rippler trick
+		int size = 0;
+		Bitboard b = 0;
+		do
+		{
+			occupancy[size] = b;
+			reference[size] = 0;
+			for (int i = 0; dirs[i] != DirectionCount; i++)
+				reference[size] |= rayAttacks(dirs[i], bit, b);
+			if (s_usePext)
+				m.attacks[pext(b, m.mask)] = reference[size];
+			size++;
+			b = (b - m.mask) & m.mask;
+		} while (b != 0);
+		table += size;
+
+		if (s_usePext)
+			continue;
+
+		// Find a magic number that maps every occupancy to an
+		// index without destructive collisions
+		for (int i = 0; i < size; )
+		{
+			m.magic = 0;
+			while (popCount((m.mask * m.magic) >> 56) < 6)
+				m.magic = random.sparse();
+
+			attempt++;
+			for (i = 0; i < size; i++)
+			{
+				int index = magicIndex(m, occupancy[i]);
+				if (epoch[index] < attempt)
+				{
+					epoch[index] = attempt;
+					m.attacks[index] = reference[i];
+				}
+				else if (m.attacks[index] != reference[i])
+					break;
+			}
+		}
+	}
+}
+
+bool Bitboards::cpuHasPext()
+{
+#if defined(BITBOARD_PEXT) && defined(Q_CC_MSVC)
+	int regs[4];
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 8)) != 0;
+#elif defined(BITBOARD_PEXT)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("bmi2");
+#else
+	return false;
+#endif
+}
+
+#if defined(BITBOARD_PEXT) && defined(Q_CC_GNU)
+__attribute__((target("bmi2")))
+#endif
+quint64 Bitboards::pext(quint64 value, quint64 mask)
+{
+#if defined(BITBOARD_PEXT)
+	return _pext_u64(value, mask);
+#else
+	Q_UNUSED(value);
+	Q_UNUSED(mask);
+	Q_UNREACHABLE();
+	return 0;
+#endif
+}
+
+} // namespace Chess
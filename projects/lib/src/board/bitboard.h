@@ -0,0 +1,286 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#include "side.h"
+#if defined(Q_CC_MSVC)
+#include <intrin.h>
+#endif
+
+namespace Chess {
+
+/*!
+ * A set of squares on an 8x8 board.
+ *
+ * Bit 0 is the a1 square, bit 7 is h1 and bit 63 is h8.
+ */
+typedef quint64 Bitboard;
+
+/*!
+ * \brief Precomputed attack tables for 8x8 bitboards
+ *
+ * Bitboards provides the square mapping between the padded
+ * 10x12 mailbox used by Board and the 64-bit bitboard layout,
+ * and attack sets for the standard chess movement types.
+ *
+ * Sliding attacks are looked up from precomputed tables indexed
+ * by the relevant occupancy of the line. On x86-64 CPUs with the
+ * BMI2 instruction set the index is computed with PEXT, otherwise
+ * with "fancy" magic multiplication. The choice is made at run
+ * time by initialize().
+ *
+ * \note initialize() must be called before any of the lookup
+ * functions are used.
+ */
+class LIB_EXPORT Bitboards
+{
+	public:
+		/*!
+		 * Initializes the attack tables.
+		 *
+		 * This function is thread-safe and can be called more than once.
+		 */
+		static void initialize();
+
+		/*!
+		 * Returns the bit index of mailbox square \a square, or -1 if
+		 * \a square is a wall square.
+		 */
+		static int bitIndex(int square);
+		/*! Returns the mailbox square index of bit \a bit. */
+		static int squareIndex(int bit);
+		/*! Returns a bitboard that only contains bit \a bit. */
+		static Bitboard bit(int bit);
+
+		/*! Returns the number of squares in \a b. */
+		static int popCount(Bitboard b);
+		/*! Returns the lowest bit index in \a b, which must not be empty. */
+		static int lsb(Bitboard b);
+		/*! Returns the highest bit index in \a b, which must not be empty. */
+		static int msb(Bitboard b);
+		/*! Removes the lowest bit from \a b and returns its index. */
+		static int popLsb(Bitboard& b);
+
+		/*! Returns the squares attacked by a knight on \a bit. */
+		static Bitboard knightAttacks(int bit);
+		/*! Returns the squares attacked by a king on \a bit. */
+		static Bitboard kingAttacks(int bit);
+		/*! Returns the squares attacked by a pawn of \a side on \a bit. */
+		static Bitboard pawnAttacks(Side side, int bit);
+		/*!
+		 * Returns the squares attacked by a bishop on \a bit when
+		 * the squares in \a occupied are occupied.
+		 */
+		static Bitboard bishopAttacks(int bit, Bitboard occupied);
+		/*!
+		 * Returns the squares attacked by a rook on \a bit when
+		 * the squares in \a occupied are occupied.
+		 */
+		static Bitboard rookAttacks(int bit, Bitboard occupied);
+
+		/*!
+		 * Returns the squares between \a bit1 and \a bit2, exclusive,
+		 * or 0 if they aren't on the same rank, file or diagonal.
+		 */
+		static Bitboard between(int bit1, int bit2);
+		/*!
+		 * Returns all the squares of the rank, file or diagonal that
+		 * goes through \a bit1 and \a bit2, or 0 if there's no such
+		 * line.
+		 */
+		static Bitboard line(int bit1, int bit2);
+
+	private:
+		enum Direction
+		{
+			North,
+			East,
+			NorthEast,
+			NorthWest,
+			South,
+			West,
+			SouthEast,
+			SouthWest,
+			DirectionCount
+		};
+
+		struct Magic
+		{
+			Bitboard mask;
+			Bitboard magic;
+			Bitboard* attacks;
+			int shift;
+		};
+
+		Bitboards();
+		static Bitboard rayAttacks(Direction dir, int bit, Bitboard occupied);
+		static void initMagics(const Direction* dirs,
+				       Magic* magics,
+				       Bitboard* table);
+		static int magicIndex(const Magic& magic, Bitboard occupied);
+		static quint64 pext(quint64 value, quint64 mask);
+		static bool cpuHasPext();
+
+		static bool s_initialized;
+		static bool s_usePext;
+		static int s_bitIndex[120];
+		static int s_squareIndex[64];
+		static Bitboard s_knightAttacks[64];
+		static Bitboard s_kingAttacks[64];
+		static Bitboard s_pawnAttacks[2][64];
+		static Bitboard s_rays[DirectionCount][64];
+		static Magic s_bishopMagics[64];
+		static Magic s_rookMagics[64];
+		static Bitboard s_bishopTable[5248];
+		static Bitboard s_rookTable[102400];
+		static Bitboard s_between[64][64];
+		static Bitboard s_line[64][64];
+};
+
+inline int Bitboards::bitIndex(int square)
+{
+	Q_ASSERT(square >= 0 && square < 120);
+	return s_bitIndex[square];
+}
+
+inline int Bitboards::squareIndex(int bit)
+{
+	Q_ASSERT(bit >= 0 && bit < 64);
+	return s_squareIndex[bit];
+}
+
+inline Bitboard Bitboards::bit(int bit)
+{
+	Q_ASSERT(bit >= 0 && bit < 64);
+	return Q_UINT64_C(1) << bit;
+}
+
+inline int Bitboards::popCount(Bitboard b)
+{
+#if defined(Q_CC_GNU)
+	return __builtin_popcountll(b);
+#elif defined(Q_CC_MSVC) && defined(Q_PROCESSOR_X86_64)
+	return int(__popcnt64(b));
+#else
+	int count = 0;
+	for (; b != 0; b &= b - 1)
+		count++;
+	return count;
+#endif
+}
+
+inline int Bitboards::lsb(Bitboard b)
+{
+	Q_ASSERT(b != 0);
+#if defined(Q_CC_GNU)
+	return __builtin_ctzll(b);
+#elif defined(Q_CC_MSVC) && defined(Q_PROCESSOR_X86_64)
+	unsigned long index;
+	_BitScanForward64(&index, b);
+	return int(index);
+#else
+	int index = 0;
+	while (!(b & 1))
+	{
+		b >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+inline int Bitboards::msb(Bitboard b)
+{
+	Q_ASSERT(b != 0);
+#if defined(Q_CC_GNU)
+	return 63 - __builtin_clzll(b);
+#elif defined(Q_CC_MSVC) && defined(Q_PROCESSOR_X86_64)
+	unsigned long index;
+	_BitScanReverse64(&index, b);
+	return int(index);
+#else
+	int index = 0;
+	while (b >>= 1)
+		index++;
+	return index;
+#endif
+}
+
+inline int Bitboards::popLsb(Bitboard& b)
+{
+	int index = lsb(b);
+	b &= b - 1;
+	return index;
+}
+
+inline Bitboard Bitboards::knightAttacks(int bit)
+{
+	Q_ASSERT(s_initialized);
+	return s_knightAttacks[bit];
+}
+
+inline Bitboard Bitboards::kingAttacks(int bit)
+{
+	Q_ASSERT(s_initialized);
+	return s_kingAttacks[bit];
+}
+
+inline Bitboard Bitboards::pawnAttacks(Side side, int bit)
+{
+	Q_ASSERT(s_initialized);
+	Q_ASSERT(!side.isNull());
+	return s_pawnAttacks[side][bit];
+}
+
+inline int Bitboards::magicIndex(const Magic& magic, Bitboard occupied)
+{
+	if (s_usePext)
+		return int(pext(occupied, magic.mask));
+	return int(((occupied & magic.mask) * magic.magic) >> magic.shift);
+}
+
+inline Bitboard Bitboards::bishopAttacks(int bit, Bitboard occupied)
+{
+	Q_ASSERT(s_initialized);
+	const Magic& magic = s_bishopMagics[bit];
+	return magic.attacks[magicIndex(magic, occupied)];
+}
+
+inline Bitboard Bitboards::rookAttacks(int bit, Bitboard occupied)
+{
+	Q_ASSERT(s_initialized);
+	const Magic& magic = s_rookMagics[bit];
+	return magic.attacks[magicIndex(magic, occupied)];
+}
+
+inline Bitboard Bitboards::between(int bit1, int bit2)
+{
+	Q_ASSERT(s_initialized);
+	return s_between[bit1][bit2];
+}
+
+inline Bitboard Bitboards::line(int bit1, int bit2)
+{
+	Q_ASSERT(s_initialized);
+	return s_line[bit1][bit2];
+}
+
+} // namespace Chess
+#endif // BITBOARD_H
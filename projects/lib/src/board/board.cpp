@@ -53,17 +53,26 @@ QDebug operator<<(QDebug dbg, const Board* board)
 
 Board::Board(Zobrist* zobrist)
 	: m_initialized(false),
+	  m_hasBitboards(false),
 	  m_width(0),
 	  m_height(0),
 	  m_side(Side::White),
 	  m_startingSide(Side::White),
 	  m_maxPieceSymbolLength(1),
 	  m_key(0),
+	  m_canMoveKey(0),
+	  m_canMoveValid(false),
+	  m_canMove(false),
+	  m_trustedSan(false),
 	  m_zobrist(zobrist),
-	  m_sharedZobrist(zobrist)
+	  m_sharedZobrist(zobrist),
+	  m_pieceTypeCount(0),
+	  m_memory(MemoryStats::Boards)
 {
 	Q_ASSERT(zobrist != nullptr);
 
+	m_sideBitboard[Side::White] = 0;
+	m_sideBitboard[Side::Black] = 0;
 	setPieceType(Piece::NoPiece, QString(), QString());
 }
 
@@ -86,6 +95,11 @@ bool Board::variantHasOptionalPromotions() const
 	return false;
 }
 
+bool Board::variantHasBitboards() const
+{
+	return false;
+}
+
 QList<Piece> Board::reservePieceTypes() const
 {
 	return QList<Piece>();
@@ -125,7 +139,35 @@ void Board::initialize()
 		if (pd.symbol.length() > m_maxPieceSymbolLength)
 			m_maxPieceSymbolLength = pd.symbol.length();
 
+	m_symbolTypes.fill(Piece::NoPiece, 256);
+	for (int i = m_pieceData.size() - 1; i > 0; i--)
+	{
+		const QString& symbol = m_pieceData[i].symbol;
+		if (symbol.length() == 1 && symbol.at(0).unicode() < 256)
+			m_symbolTypes[symbol.at(0).unicode()] = i;
+	}
+
 	m_zobrist->initialize((m_width + 2) * (m_height + 4), m_pieceData.size());
+	m_pieceCounts.resize(m_pieceTypeCount * 2);
+	for (int i = 0; i < m_pieceCounts.size(); i++)
+		m_pieceCounts[i] = 0;
+
+	m_hasBitboards = (variantHasBitboards()
+			  && m_width == 8 && m_height == 8);
+	if (m_hasBitboards)
+	{
+		Bitboards::initialize();
+		m_pieceBitboards.resize(m_pieceTypeCount * 2);
+		clearBitboards();
+	}
+}
+
+void Board::clearBitboards()
+{
+	m_sideBitboard[Side::White] = 0;
+	m_sideBitboard[Side::Black] = 0;
+	for (int i = 0; i < m_pieceBitboards.size(); i++)
+		m_pieceBitboards[i] = 0;
 }
 
 int Board::maxPieceSymbolLength() const
@@ -140,7 +182,10 @@ void Board::setPieceType(int type,
 			 const QString& gsymbol)
 {
 	if (type >= m_pieceData.size())
+	{
 		m_pieceData.resize(type + 1);
+		m_pieceTypeCount = m_pieceData.size();
+	}
 
 	const QString& graphicalSymbol = gsymbol.isEmpty() ? symbol : gsymbol;
 
@@ -160,6 +205,21 @@ QString Board::pieceSymbol(Piece piece) const
 	return m_pieceData[type].symbol.toLower();
 }
 
+void Board::appendPieceSymbol(QString& str, Piece piece) const
+{
+	int type = piece.type();
+	if (type <= 0 || type >= m_pieceData.size())
+		return;
+
+	const QString& symbol = m_pieceData[type].symbol;
+	if (piece.side() == upperCaseSide())
+		str += symbol;
+	else if (symbol.size() == 1)
+		str += symbol.at(0).toLower();
+	else
+		str += symbol.toLower();
+}
+
 Piece Board::pieceFromSymbol(const QString& pieceSymbol) const
 {
 	if (pieceSymbol.isEmpty())
@@ -185,6 +245,22 @@ Piece Board::pieceFromSymbol(const QString& pieceSymbol) const
 	return Piece(side.opposite(), code);
 }
 
+Piece Board::pieceFromSymbol(QChar pieceSymbol) const
+{
+	QChar symbol = pieceSymbol.toUpper();
+	if (symbol.unicode() >= m_symbolTypes.size())
+		return pieceFromSymbol(QString(pieceSymbol));
+
+	int code = m_symbolTypes[symbol.unicode()];
+	if (code == Piece::NoPiece)
+		return code;
+
+	Side side(upperCaseSide());
+	if (pieceSymbol == symbol)
+		return Piece(side, code);
+	return Piece(side.opposite(), code);
+}
+
 QString Board::pieceString(int pieceType) const
 {
 	if (pieceType <= 0 || pieceType >= m_pieceData.size())
@@ -240,31 +316,6 @@ void Board::removeFromReserve(const Piece& piece)
 	xorKey(m_zobrist->reservePiece(piece, --count));
 }
 
-Square Board::chessSquare(int index) const
-{
-	int arwidth = m_width + 2;
-	int file = (index % arwidth) - 1;
-	int rank = (m_height - 1) - ((index / arwidth) - 2);
-	return Square(file, rank);
-}
-
-int Board::squareIndex(const Square& square) const
-{
-	if (!isValidSquare(square))
-		return 0;
-
-	int rank = (m_height - 1) - square.rank();
-	return (rank + 2) * (m_width + 2) + 1 + square.file();
-}
-
-bool Board::isValidSquare(const Chess::Square& square) const
-{
-	if (!square.isValid()
-	||  square.file() >= m_width || square.rank() >= m_height)
-		return false;
-	return true;
-}
-
 QString Board::squareString(int index) const
 {
 	return squareString(chessSquare(index));
@@ -434,6 +485,20 @@ Move Board::moveFromString(const QString& str)
 	return move;
 }
 
+Move Board::moveFromTrustedSanString(const QString& str)
+{
+	m_trustedSan = true;
+	const Move move(moveFromSanString(str));
+	m_trustedSan = false;
+
+	return move;
+}
+
+bool Board::isTrustedSanString() const
+{
+	return m_trustedSan;
+}
+
 Move Board::moveFromGenericMove(const GenericMove& move) const
 {
 	int source = squareIndex(move.sourceSquare());
@@ -473,6 +538,7 @@ QStringList Board::pieceList(Side side) const
 QString Board::fenString(FenNotation notation) const
 {
 	QString fen;
+	fen.reserve(m_width * m_height + m_height + 32);
 
 	// Squares
 	int i = (m_width + 2) * 2;
@@ -494,12 +560,14 @@ QString Board::fenString(FenNotation notation) const
 			if (nempty > 0
 			&&  (!pc.isEmpty() || x == m_width - 1))
 			{
-				fen += QString::number(nempty);
+				if (nempty >= 10)
+					fen += QChar('0' + nempty / 10);
+				fen += QChar('0' + nempty % 10);
 				nempty = 0;
 			}
 
 			if (pc.isValid())
-				fen += pieceSymbol(pc);
+				appendPieceSymbol(fen, pc);
 			i++;
 		}
 		i++;
@@ -508,7 +576,8 @@ QString Board::fenString(FenNotation notation) const
 	// Hand pieces
 	if (variantHasDrops())
 	{
-		QString str;
+		fen += '[';
+		int start = fen.size();
 		for (i = Side::White; i <= Side::Black; i++)
 		{
 			Side side = Side::Type(i);
@@ -516,16 +585,18 @@ QString Board::fenString(FenNotation notation) const
 			{
 				int count = m_reserve[i].at(j);
 				for (int k = 0; k < count; k++)
-					str += pieceSymbol(Piece(side, j));
+					appendPieceSymbol(fen, Piece(side, j));
 			}
 		}
-		if (str.isEmpty())
-			str = "-";
-		fen += QString("[%1]").arg(str);
+		if (fen.size() == start)
+			fen += '-';
+		fen += ']';
 	}
 
 	// Side to move
-	fen += QString(" %1 ").arg(m_side.symbol());
+	fen += ' ';
+	fen += m_side.symbol();
+	fen += ' ';
 
 	return fen + vFenString(notation);
 }
@@ -550,11 +621,14 @@ bool Board::setFenString(const QString& fen)
 	for (int i = 0; i < m_squares.size(); i++)
 		m_squares[i] = Piece::WallPiece;
 	m_key = 0;
+	for (int i = 0; i < m_pieceCounts.size(); i++)
+		m_pieceCounts[i] = 0;
+	if (m_hasBitboards)
+		clearBitboards();
 
 	// Get the board contents (squares)
 	int handPieceIndex = -1;
 	int maxsymlen = maxPieceSymbolLength();
-	QString pieceStr;
 	for (int i = 0; i < token->length(); i++)
 	{
 		QChar c = token->at(i);
@@ -562,9 +636,6 @@ bool Board::setFenString(const QString& fen)
 		// Move to the next rank
 		if (c == '/')
 		{
-			if (!pieceStr.isEmpty())
-				return false;
-
 			// Reject the FEN string if the rank didn't
 			// have exactly 'm_width' squares.
 			if (square - rankEndSquare != m_width)
@@ -584,9 +655,6 @@ bool Board::setFenString(const QString& fen)
 		// Add empty squares
 		if (c.isDigit())
 		{
-			if (!pieceStr.isEmpty())
-				return false;
-
 			int j;
 			int nempty;
 			if (i < (token->length() - 1) && token->at(i + 1).isDigit())
@@ -613,8 +681,8 @@ bool Board::setFenString(const QString& fen)
 		// read ahead for multi-character symbols
 		for (int l = qMin(maxsymlen, token->length() - i); l > 0; l--)
 		{
-			pieceStr = token->mid(i, l);
-			Piece piece = pieceFromSymbol(pieceStr);
+			Piece piece = (l == 1) ? pieceFromSymbol(c)
+					       : pieceFromSymbol(token->mid(i, l));
 			if (piece.isValid())
 			{
 				setSquare(k++, piece);
@@ -623,7 +691,6 @@ bool Board::setFenString(const QString& fen)
 			}
 		}
 
-		pieceStr.clear();
 		square++;
 	}
 
@@ -674,6 +741,13 @@ bool Board::setFenString(const QString& fen)
 	m_moveHistory.clear();
 	m_startingFen = fen;
 
+	// Estimated when a game starts, so a long game shows up when
+	// the board is reused
+	m_memory.setBytes(sizeof(Board)
+			  + m_squares.capacity() * sizeof(Piece)
+			  + m_moveHistory.capacity() * sizeof(MoveData)
+			  + m_startingFen.capacity() * sizeof(QChar));
+
 	// Let subclasses handle the rest of the FEN string
 	if (token != strList.end())
 		++token;
@@ -700,7 +774,7 @@ void Board::makeMove(const Move& move, BoardTransition* transition)
 	Q_ASSERT(!m_side.isNull());
 	Q_ASSERT(!move.isNull());
 
-	MoveData md = { move, m_key };
+	MoveData md = { move, m_key, -1 };
 
 	vMakeMove(move, transition);
 
@@ -721,16 +795,68 @@ void Board::undoMove()
 	m_moveHistory.pop_back();
 }
 
-void Board::generateMoves(QVarLengthArray<Move>& moves, int pieceType) const
+BoardSnapshot Board::snapshot() const
+{
+	return BoardSnapshot(copy());
+}
+
+bool Board::restore(const BoardSnapshot& snapshot)
+{
+	const Board* other = snapshot.m_board.data();
+	if (other == nullptr
+	||  other->m_side.isNull()
+	||  other->variant() != variant())
+		return false;
+
+	initialize();
+
+	m_side = other->m_side;
+	m_startingSide = other->m_startingSide;
+	m_startingFen = other->m_startingFen;
+	m_key = other->m_key;
+	m_squares = other->m_squares;
+	m_moveHistory = other->m_moveHistory;
+	m_reserve[Side::White] = other->m_reserve[Side::White];
+	m_reserve[Side::Black] = other->m_reserve[Side::Black];
+	m_sideBitboard[Side::White] = other->m_sideBitboard[Side::White];
+	m_sideBitboard[Side::Black] = other->m_sideBitboard[Side::Black];
+	m_pieceBitboards = other->m_pieceBitboards;
+	m_pieceCounts = other->m_pieceCounts;
+
+	vRestore(*other);
+	return true;
+}
+
+void Board::vRestore(const Board& other)
+{
+	Q_UNUSED(other);
+}
+
+void Board::generateMoves(MoveList& moves, int pieceType) const
 {
 	Q_ASSERT(!m_side.isNull());
 
+	moves.clear();
+	if (m_hasBitboards)
+	{
+		Bitboard pieces = (pieceType == Piece::NoPiece)
+			? m_sideBitboard[m_side]
+			: pieceBitboard(m_side, pieceType);
+		while (pieces != 0)
+		{
+			int sq = Bitboards::squareIndex(Bitboards::popLsb(pieces));
+			generateMovesForPiece(moves, m_squares[sq].type(), sq);
+		}
+
+		generateDropMoves(moves, pieceType);
+		return;
+	}
+
 	// Cut the wall squares (the ones with a value of WallPiece) off
 	// from the squares to iterate over. It bumps the speed up a bit.
 	unsigned begin = (m_width + 2) * 2;
 	unsigned end = m_squares.size() - begin;
 
-	moves.clear();
 	for (unsigned sq = begin; sq < end; sq++)
 	{
 		Piece tmp = m_squares[sq];
@@ -742,7 +868,7 @@ void Board::generateMoves(QVarLengthArray<Move>& moves, int pieceType) const
 	generateDropMoves(moves, pieceType);
 }
 
-void Board::generateDropMoves(QVarLengthArray<Move>& moves, int pieceType) const
+void Board::generateDropMoves(MoveList& moves, int pieceType) const
 {
 	const QVector<int>& pieces(m_reserve[m_side]);
 	if (pieces.isEmpty())
@@ -763,7 +889,7 @@ void Board::generateDropMoves(QVarLengthArray<Move>& moves, int pieceType) const
 
 void Board::generateHoppingMoves(int sourceSquare,
 				 const QVarLengthArray<int>& offsets,
-				 QVarLengthArray<Move>& moves) const
+				 MoveList& moves) const
 {
 	Side opSide = sideToMove().opposite();
 	for (int i = 0; i < offsets.size(); i++)
@@ -779,7 +905,7 @@ void Board::generateHoppingMoves(int sourceSquare,
 
 void Board::generateSlidingMoves(int sourceSquare,
 				 const QVarLengthArray<int>& offsets,
-				 QVarLengthArray<Move>& moves) const
+				 MoveList& moves) const
 {
 	Side side = sideToMove();
 	for (int i = 0; i < offsets.size(); i++)
@@ -803,7 +929,7 @@ bool Board::moveExists(const Move& move) const
 	Q_ASSERT(!move.isNull());
 
 	int source = move.sourceSquare();
-	QVarLengthArray<Move> moves;
+	MoveList moves;
 
 	if (source == 0)
 		generateDropMoves(moves, move.promotion());
@@ -844,23 +970,55 @@ bool Board::vIsLegalMove(const Move& move)
 	return isLegal;
 }
 
+bool Board::generateLegalMoves(MoveList& moves, bool firstOnly)
+{
+	Q_UNUSED(moves);
+	Q_UNUSED(firstOnly);
+	return false;
+}
+
 bool Board::isLegalMove(const Move& move)
 {
 	return !move.isNull() && moveExists(move) && vIsLegalMove(move);
 }
 
-int Board::repeatCount() const
+int Board::repeatCount()
 {
-	if (plyCount() < 4)
+	int ply = plyCount();
+	if (ply < 4)
 		return 0;
 
+	MoveData& md = m_moveHistory[ply - 1];
+	if (md.repeatCount != -1)
+		return md.repeatCount;
+
+	// A position can't repeat across an irreversible move. In drop
+	// variants captured pieces can return to the board, so the
+	// whole game has to be searched.
+	int first = 0;
+	int reversible = reversibleMoveCount();
+	if (reversible >= 0 && !variantHasDrops())
+		first = qMax(0, ply - reversible);
+
+	// Only the positions with the same side to move can match.
+	// If an earlier occurrence of the position has a cached count,
+	// the rest of the history doesn't have to be searched.
 	int repeatCount = 0;
-	for (int i = plyCount() - 1; i >= 0; i--)
+	for (int i = ply - 2; i >= first; i -= 2)
 	{
-		if (m_moveHistory.at(i).key == m_key)
-			repeatCount++;
+		if (m_moveHistory.at(i).key != m_key)
+			continue;
+
+		repeatCount++;
+		int cached = (i > 0) ? m_moveHistory.at(i - 1).repeatCount : 0;
+		if (cached != -1)
+		{
+			repeatCount += cached;
+			break;
+		}
 	}
 
+	md.repeatCount = repeatCount;
 	return repeatCount;
 }
 
@@ -882,33 +1040,63 @@ bool Board::isRepetition(const Chess::Move& move)
 
 bool Board::canMove()
 {
-	QVarLengthArray<Move> moves;
-	generateMoves(moves);
+	if (m_canMoveValid && m_canMoveKey == m_key)
+		return m_canMove;
 
-	for (int i = 0; i < moves.size(); i++)
+	MoveList moves;
+	bool found = false;
+	if (generateLegalMoves(moves, true))
+		found = !moves.isEmpty();
+	else
 	{
-		if (vIsLegalMove(moves[i]))
-			return true;
+		generateMoves(moves);
+		for (int i = 0; i < moves.size() && !found; i++)
+			found = vIsLegalMove(moves[i]);
 	}
 
-	return false;
+	m_canMoveKey = m_key;
+	m_canMoveValid = true;
+	m_canMove = found;
+	return found;
 }
 
 QVector<Move> Board::legalMoves()
 {
-	QVarLengthArray<Move> moves;
-	QVector<Move> legalMoves;
+	MoveList moves;
+	legalMoves(moves);
 
-	generateMoves(moves);
+	QVector<Move> legalMoves;
 	legalMoves.reserve(moves.size());
-
 	for (int i = moves.size() - 1; i >= 0; i--)
+		legalMoves << moves[i];
+
+	return legalMoves;
+}
+
+void Board::legalMoves(MoveList& moves)
+{
+	moves.clear();
+
+	// A position known to have no moves, eg. after result()
+	if (m_canMoveValid && m_canMoveKey == m_key && !m_canMove)
+		return;
+
+	if (!generateLegalMoves(moves, false))
 	{
-		if (vIsLegalMove(moves[i]))
-			legalMoves << moves[i];
+		generateMoves(moves);
+
+		int count = 0;
+		for (int i = 0; i < moves.size(); i++)
+		{
+			if (vIsLegalMove(moves[i]))
+				moves[count++] = moves[i];
+		}
+		moves.resize(count);
 	}
 
-	return legalMoves;
+	m_canMoveKey = m_key;
+	m_canMoveValid = true;
+	m_canMove = !moves.isEmpty();
 }
 
 Result Board::tablebaseResult(unsigned int* dtm) const
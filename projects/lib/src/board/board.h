@@ -30,6 +30,9 @@
 #include "genericmove.h"
 #include "zobrist.h"
 #include "result.h"
+#include "bitboard.h"
+#include "boardsnapshot.h"
+#include <memorystats.h>
 class QStringList;
 
 
@@ -52,6 +55,10 @@ class BoardTransition;
  * The board representation is (width + 2) x (height + 4), so a
  * traditional 8x8 board would be 10x12, and stored in a one-dimensional
  * vector with 10 * 12 = 120 elements.
+ *
+ * Variants played on an 8x8 board can also keep a copy of the position
+ * in 64-bit bitboards, which is updated by setSquare().
+ * \sa variantHasBitboards()
  */
 class LIB_EXPORT Board
 {
@@ -110,7 +117,13 @@ class LIB_EXPORT Board
 		Board(Zobrist* zobrist);
 		/*! Destructs the Board object. */
 		virtual ~Board();
-		/*! Creates and returns a deep copy of this board. */
+		/*!
+		 * Creates and returns a deep copy of this board.
+		 *
+		 * The immutable data of the variant, like the piece
+		 * definitions and the zobrist keys, is shared between the
+		 * copies, so only the position and its history are copied.
+		 */
 		virtual Board* copy() const = 0;
 
 		/*! Returns the name of the chess variant. */
@@ -151,7 +164,15 @@ class LIB_EXPORT Board
 		virtual int height() const = 0;
 		/*! Returns the variant's default starting FEN string. */
 		virtual QString defaultFenString() const = 0;
-		/*! Returns the zobrist key for the current position. */
+		/*!
+		 * Returns the zobrist key for the current position.
+		 *
+		 * The key is updated incrementally with each move, so this
+		 * function costs nothing. For standard chess, Fischer Random
+		 * chess and the other variants that use Polyglot-compatible
+		 * keys, it is the Polyglot hash of the position and can be
+		 * used for book lookups as is.
+		 */
 		quint64 key() const;
 		/*!
 		 * Initializes the board.
@@ -203,13 +224,28 @@ class LIB_EXPORT Board
 		Side startingSide() const;
 		/*! Returns the piece at \a square. */
 		Piece pieceAt(const Square& square) const;
+		/*!
+		 * Returns the number of pieces of type \a pieceType that
+		 * \a side has on the board.
+		 *
+		 * If \a pieceType is Piece::NoPiece (default), pieces of every
+		 * type are counted. If \a side is Side::NoSide (default), the
+		 * pieces of both sides are counted. The counts are kept up to
+		 * date as the pieces move, so the board isn't scanned.
+		 */
+		int pieceCount(Side side = Side::NoSide,
+			       int pieceType = Piece::NoPiece) const;
 		/*! Returns the number of halfmoves (plies) played. */
 		int plyCount() const;
 		/*!
 		 * Returns the number of times the current position was
 		 * reached previously in the game.
+		 *
+		 * Only the positions since the last irreversible move are
+		 * searched, and the result is cached for the current ply,
+		 * so calling this function after every move is cheap.
 		 */
-		int repeatCount() const;
+		int repeatCount();
 		/*!
 		 * Returns the number of consecutive reversible moves made.
 		 *
@@ -227,6 +263,13 @@ class LIB_EXPORT Board
 		QString pieceSymbol(Piece piece) const;
 		/*! Converts \a pieceSymbol into a Piece object. */
 		Piece pieceFromSymbol(const QString& pieceSymbol) const;
+		/*!
+		 * Converts a one-character \a pieceSymbol into a Piece object.
+		 *
+		 * This overload uses a lookup table, so it's faster than
+		 * the one that takes a string.
+		 */
+		Piece pieceFromSymbol(QChar pieceSymbol) const;
 		/*! Returns the internationalized name of \a pieceType. */
 		QString pieceString(int pieceType) const;
 		/*! Returns symbol for graphical representation of \a piece. */
@@ -243,6 +286,27 @@ class LIB_EXPORT Board
 		void makeMove(const Move& move, BoardTransition* transition = nullptr);
 		/*! Reverses the last move. */
 		void undoMove();
+		/*!
+		 * Returns a snapshot of the current position.
+		 *
+		 * The snapshot includes the move history, so moves can still
+		 * be undone and repetitions detected after the board has been
+		 * restored to the snapshot.
+		 *
+		 * \sa restore()
+		 */
+		BoardSnapshot snapshot() const;
+		/*!
+		 * Returns the board to the position saved in \a snapshot.
+		 *
+		 * Unlike replaying the moves from the starting position, this
+		 * doesn't depend on the number of plies played.
+		 *
+		 * Returns false if \a snapshot is null or was taken on a
+		 * board of another variant or a board without a position;
+		 * otherwise returns true.
+		 */
+		bool restore(const BoardSnapshot& snapshot);
 
 		/*!
 		 * Converts a Move into a string.
@@ -261,6 +325,21 @@ class LIB_EXPORT Board
 		 * \sa moveString()
 		 */
 		Move moveFromString(const QString& str);
+		/*!
+		 * Converts a SAN string \a str that is known to describe a
+		 * legal move, eg. because Cute Chess wrote it, into a Move.
+		 *
+		 * The string is matched against the pseudo-legal moves, and
+		 * the legality of the move is only tested if the string
+		 * matches more than one of them. Castling moves aren't
+		 * tested at all.
+		 *
+		 * \note Returns a null move if \a str matches no move, but
+		 * an illegal move that matches a single pseudo-legal move
+		 * is not detected.
+		 * \sa moveFromString()
+		 */
+		Move moveFromTrustedSanString(const QString& str);
 		/*!
 		 * Converts a GenericMove into a Move.
 		 *
@@ -285,6 +364,13 @@ class LIB_EXPORT Board
 		bool isRepetition(const Move& move);
 		/*! Returns a vector of legal moves in the current position. */
 		QVector<Move> legalMoves();
+		/*!
+		 * Fills \a moves with the legal moves in the current position.
+		 *
+		 * Unlike the other overload this function doesn't allocate
+		 * memory.
+		 */
+		void legalMoves(MoveList& moves);
 		/*!
 		 * Returns the result of the game, or Result::NoResult if
 		 * the game is in progress.
@@ -331,6 +417,35 @@ class LIB_EXPORT Board
 				  const QString & gsymbol = QString());
 		/*! Returns true if \pieceType can move like \a movement. */
 		bool pieceHasMovement(int pieceType, unsigned movement) const;
+		/*!
+		 * Returns the number of piece types, including Piece::NoPiece.
+		 * All piece types are smaller than this value.
+		 */
+		int pieceTypeCount() const;
+		/*!
+		 * Returns true if the position should also be kept in bitboards.
+		 *
+		 * Bitboards are only supported on 8x8 boards. The subclass
+		 * must make sure that its move generator gives the same
+		 * results with and without bitboards.
+		 * The default value is false.
+		 *
+		 * \sa hasBitboards()
+		 */
+		virtual bool variantHasBitboards() const;
+		/*!
+		 * Returns true if bitboards are kept in sync with the board.
+		 *
+		 * This is the value of variantHasBitboards() cached by
+		 * initialize(), and can be called on every move.
+		 */
+		bool hasBitboards() const;
+		/*! Returns a bitboard of all the pieces on the board. */
+		Bitboard occupiedBitboard() const;
+		/*! Returns a bitboard of the pieces of \a side. */
+		Bitboard sideBitboard(Side side) const;
+		/*! Returns a bitboard of the pieces of type \a pieceType of \a side. */
+		Bitboard pieceBitboard(Side side, int pieceType) const;
 
 		/*!
 		 * Makes \a move on the board.
@@ -404,6 +519,19 @@ class LIB_EXPORT Board
 		 * function reads the rest of the string, if any.
 		 */
 		virtual bool vSetFenString(const QStringList& fen) = 0;
+		/*!
+		 * Copies the variant-specific state of \a other to this board.
+		 *
+		 * This function is called by restore() after the base class has
+		 * restored the squares, side to move, hand pieces and history.
+		 * \a other is always a board of the same variant. Subclasses
+		 * that keep track of a position or its history in their own
+		 * members must reimplement this function and call the base
+		 * implementation.
+		 *
+		 * The default implementation does nothing.
+		 */
+		virtual void vRestore(const Board& other);
 
 		/*!
 		 * Generates pseudo-legal moves for pieces of type \a pieceType.
@@ -412,7 +540,7 @@ class LIB_EXPORT Board
 		 * for every piece type.
 		 * \sa legalMoves()
 		 */
-		void generateMoves(QVarLengthArray<Move>& moves,
+		void generateMoves(MoveList& moves,
 				   int pieceType = Piece::NoPiece) const;
 		/*!
 		 * Generates piece drops for pieces of type \a pieceType.
@@ -421,7 +549,7 @@ class LIB_EXPORT Board
 		 * for every piece type.
 		 * \sa generateMoves()
 		 */
-		void generateDropMoves(QVarLengthArray<Move>& moves, int pieceType) const;
+		void generateDropMoves(MoveList& moves, int pieceType) const;
 		/*!
 		 * Generates pseudo-legal moves for a piece of \a pieceType
 		 * at square \a square.
@@ -429,7 +557,7 @@ class LIB_EXPORT Board
 		 * \note It doesn't matter if \a square doesn't contain a piece of
 		 * \a pieceType, the move generator ignores it.
 		 */
-		virtual void generateMovesForPiece(QVarLengthArray<Move>& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const = 0;
 		/*!
@@ -441,7 +569,7 @@ class LIB_EXPORT Board
 		 */
 		void generateHoppingMoves(int sourceSquare,
 					  const QVarLengthArray<int>& offsets,
-					  QVarLengthArray<Move>& moves) const;
+					  MoveList& moves) const;
 		/*!
 		 * Generates sliding moves for a piece.
 		 *
@@ -451,7 +579,7 @@ class LIB_EXPORT Board
 		 */
 		void generateSlidingMoves(int sourceSquare,
 					  const QVarLengthArray<int>& offsets,
-					  QVarLengthArray<Move>& moves) const;
+					  MoveList& moves) const;
 		/*!
 		 * Returns true if the current position is a legal position.
 		 * If the position isn't legal it usually means that the last
@@ -470,6 +598,20 @@ class LIB_EXPORT Board
 		 * after \a move is legal.
 		 */
 		virtual bool vIsLegalMove(const Move& move);
+		/*!
+		 * Generates the legal moves in the current position without
+		 * testing the pseudo-legal moves one by one with vIsLegalMove().
+		 * If \a firstOnly is true, the generator may stop after the
+		 * first legal move it finds.
+		 *
+		 * Returns false if the variant doesn't have a legal move
+		 * generator, in which case \a moves is left untouched and the
+		 * caller has to filter the pseudo-legal moves itself.
+		 * The default implementation always returns false.
+		 *
+		 * \sa legalMoves(), canMove()
+		 */
+		virtual bool generateLegalMoves(MoveList& moves, bool firstOnly);
 		/*!
 		 * Returns the type of piece captured by \a move.
 		 * Returns Piece::NoPiece if \a move is not a capture.
@@ -477,12 +619,26 @@ class LIB_EXPORT Board
 		virtual int captureType(const Move& move) const;
 		/*! Updates the zobrist position key with \a key. */
 		void xorKey(quint64 key);
+		/*!
+		 * Returns true if the SAN string being converted by
+		 * moveFromSanString() is known to describe a legal move.
+		 *
+		 * \sa moveFromTrustedSanString()
+		 */
+		bool isTrustedSanString() const;
 		/*!
 		 * Returns true if a pseudo-legal move \a move exists.
 		 * \sa isLegalMove()
 		 */
 		bool moveExists(const Move& move) const;
-		/*! Returns true if the side to move has any legal moves. */
+		/*!
+		 * Returns true if the side to move has any legal moves.
+		 *
+		 * The search stops at the first legal move, and the answer
+		 * is kept for the current position key, so calling this
+		 * function or legalMoves() again in the same position
+		 * doesn't repeat the work.
+		 */
 		bool canMove();
 		/*!
 		 * Returns the size of the board array, including the padding
@@ -527,10 +683,22 @@ class LIB_EXPORT Board
 		{
 			Move move;
 			quint64 key;
+			// Cached repeatCount() of the position after the
+			// move, or -1 if not known yet
+			int repeatCount;
 		};
 		friend LIB_EXPORT QDebug operator<<(QDebug dbg, const Board* board);
 
+		void updateBitboards(int square, Piece oldPiece, Piece newPiece);
+		void clearBitboards();
+		/*!
+		 * Appends the symbol of \a piece to \a str without
+		 * creating a temporary string for single-character symbols.
+		 */
+		void appendPieceSymbol(QString& str, Piece piece) const;
+
 		bool m_initialized;
+		bool m_hasBitboards;
 		int m_width;
 		int m_height;
 		Side m_side;
@@ -538,12 +706,27 @@ class LIB_EXPORT Board
 		QString m_startingFen;
 		int m_maxPieceSymbolLength;
 		quint64 m_key;
+		quint64 m_canMoveKey;
+		bool m_canMoveValid;
+		bool m_canMove;
+		bool m_trustedSan;
 		Zobrist* m_zobrist;
 		QSharedPointer<Zobrist> m_sharedZobrist;
-		QVarLengthArray<PieceData> m_pieceData;
+		// The piece definitions don't change after the board has
+		// been constructed, so copies of the board share them.
+		QVector<PieceData> m_pieceData;
+		// Piece types by their one-character Latin-1 symbols
+		QVector<int> m_symbolTypes;
 		QVarLengthArray<Piece> m_squares;
 		QVector<MoveData> m_moveHistory;
 		QVector<int> m_reserve[2];
+		int m_pieceTypeCount;
+		Bitboard m_sideBitboard[2];
+		QVarLengthArray<Bitboard, 32> m_pieceBitboards;
+		// Usage: 'm_pieceCounts[side * m_pieceTypeCount + type]'
+		// The Piece::NoPiece slot holds the side's total count.
+		QVarLengthArray<int, 32> m_pieceCounts;
+		MemoryAccount m_memory;
 };
 
 
@@ -579,6 +762,24 @@ inline void Board::xorKey(quint64 key)
 	m_key ^= key;
 }
 
+inline Square Board::chessSquare(int index) const
+{
+	return Square::fromIndex(index, m_width, m_height);
+}
+
+inline int Board::squareIndex(const Square& square) const
+{
+	if (!isValidSquare(square))
+		return 0;
+	return square.index(m_width, m_height);
+}
+
+inline bool Board::isValidSquare(const Square& square) const
+{
+	return square.isValid()
+	    && square.file() < m_width && square.rank() < m_height;
+}
+
 inline Piece Board::pieceAt(int square) const
 {
 	return m_squares[square];
@@ -588,13 +789,89 @@ inline void Board::setSquare(int square, Piece piece)
 {
 	Piece& old = m_squares[square];
 	if (old.isValid())
+	{
 		xorKey(m_zobrist->piece(old, square));
+		m_pieceCounts[old.side() * m_pieceTypeCount]--;
+		m_pieceCounts[old.side() * m_pieceTypeCount + old.type()]--;
+	}
 	if (piece.isValid())
+	{
 		xorKey(m_zobrist->piece(piece, square));
+		m_pieceCounts[piece.side() * m_pieceTypeCount]++;
+		m_pieceCounts[piece.side() * m_pieceTypeCount + piece.type()]++;
+	}
+	if (m_hasBitboards)
+		updateBitboards(square, old, piece);
 
 	old = piece;
 }
 
+inline void Board::updateBitboards(int square, Piece oldPiece, Piece newPiece)
+{
+	// Wall squares are never part of a bitboard
+	if (!oldPiece.isValid() && !newPiece.isValid())
+		return;
+
+	int bit = Bitboards::bitIndex(square);
+	Q_ASSERT(bit != -1);
+	Bitboard mask = Bitboards::bit(bit);
+
+	if (oldPiece.isValid())
+	{
+		m_sideBitboard[oldPiece.side()] &= ~mask;
+		m_pieceBitboards[oldPiece.side() * m_pieceTypeCount
+				 + oldPiece.type()] &= ~mask;
+	}
+	if (newPiece.isValid())
+	{
+		m_sideBitboard[newPiece.side()] |= mask;
+		m_pieceBitboards[newPiece.side() * m_pieceTypeCount
+				 + newPiece.type()] |= mask;
+	}
+}
+
+inline int Board::pieceCount(Side side, int pieceType) const
+{
+	Q_ASSERT(pieceType >= 0 && pieceType < m_pieceTypeCount);
+	if (side.isNull())
+	{
+		return m_pieceCounts[pieceType]
+		     + m_pieceCounts[m_pieceTypeCount + pieceType];
+	}
+	return m_pieceCounts[side * m_pieceTypeCount + pieceType];
+}
+
+inline int Board::pieceTypeCount() const
+{
+	return m_pieceTypeCount;
+}
+
+inline bool Board::hasBitboards() const
+{
+	return m_hasBitboards;
+}
+
+inline Bitboard Board::occupiedBitboard() const
+{
+	Q_ASSERT(m_hasBitboards);
+	return m_sideBitboard[Side::White] | m_sideBitboard[Side::Black];
+}
+
+inline Bitboard Board::sideBitboard(Side side) const
+{
+	Q_ASSERT(m_hasBitboards);
+	Q_ASSERT(!side.isNull());
+	return m_sideBitboard[side];
+}
+
+inline Bitboard Board::pieceBitboard(Side side, int pieceType) const
+{
+	Q_ASSERT(m_hasBitboards);
+	Q_ASSERT(!side.isNull());
+	Q_ASSERT(pieceType > 0 && pieceType < m_pieceTypeCount);
+	return m_pieceBitboards[side * m_pieceTypeCount + pieceType];
+}
+
 inline int Board::plyCount() const
 {
 	return m_moveHistory.size();
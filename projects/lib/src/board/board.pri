@@ -45,7 +45,9 @@ SOURCES += $$PWD/board.cpp \
     $$PWD/courierboard.cpp \
     $$PWD/boardfactory.cpp \
     $$PWD/boardtransition.cpp \
-    $$PWD/syzygytablebase.cpp
+    $$PWD/syzygytablebase.cpp \
+    $$PWD/bitboard.cpp \
+    $$PWD/boardsnapshot.cpp
 HEADERS += $$PWD/board.h \
     $$PWD/move.h \
     $$PWD/piece.h \
@@ -94,4 +96,6 @@ HEADERS += $$PWD/board.h \
     $$PWD/courierboard.h \
     $$PWD/boardfactory.h \
     $$PWD/boardtransition.h \
-    $$PWD/syzygytablebase.h
+    $$PWD/syzygytablebase.h \
+    $$PWD/bitboard.h \
+    $$PWD/boardsnapshot.h
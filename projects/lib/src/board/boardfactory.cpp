@@ -16,6 +16,8 @@
 */
 
 #include "boardfactory.h"
+#include <QHash>
+#include <QMutex>
 #include "andernachboard.h"
 #include "antiboard.h"
 #include "atomicboard.h"
@@ -110,7 +112,28 @@ ClassRegistry<Board>* BoardFactory::registry()
 
 Board* BoardFactory::create(const QString& variant)
 {
-	return registry()->create(variant);
+	// One initialized board of each variant is kept as a prototype.
+	// The prototypes are never modified or deleted, so they can be
+	// copied without holding the lock.
+	static QMutex mutex;
+	static QHash<QString, const Board*> prototypes;
+
+	const Board* prototype = nullptr;
+	{
+		QMutexLocker locker(&mutex);
+		prototype = prototypes.value(variant);
+		if (prototype == nullptr)
+		{
+			Board* board = registry()->create(variant);
+			if (board == nullptr)
+				return nullptr;
+			board->initialize();
+			prototype = board;
+			prototypes.insert(variant, prototype);
+		}
+	}
+
+	return prototype->copy();
 }
 
 QStringList BoardFactory::variants()
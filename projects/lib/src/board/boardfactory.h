@@ -34,6 +34,10 @@ class LIB_EXPORT BoardFactory
 		/*!
 		 * Creates and returns a new Board of variant \a variant.
 		 * Returns 0 if \a variant is not supported.
+		 *
+		 * The board is an initialized copy of a prototype that is
+		 * created on the first call for each variant, so the piece
+		 * tables are only built once.
 		 */
 		static Board* create(const QString& variant);
 		/*! Returns a list of supported chess variants. */
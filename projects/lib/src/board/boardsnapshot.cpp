@@ -0,0 +1,57 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "boardsnapshot.h"
+#include "board.h"
+
+namespace Chess {
+
+BoardSnapshot::BoardSnapshot()
+{
+}
+
+BoardSnapshot::BoardSnapshot(const Board* board)
+	: m_board(board)
+{
+}
+
+bool BoardSnapshot::isNull() const
+{
+	return m_board.isNull();
+}
+
+int BoardSnapshot::plyCount() const
+{
+	if (m_board.isNull())
+		return 0;
+	return m_board->plyCount();
+}
+
+quint64 BoardSnapshot::key() const
+{
+	if (m_board.isNull())
+		return 0;
+	return m_board->key();
+}
+
+const Board* BoardSnapshot::board() const
+{
+	return m_board.data();
+}
+
+} // namespace Chess
@@ -0,0 +1,82 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BOARDSNAPSHOT_H
+#define BOARDSNAPSHOT_H
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <QSharedPointer>
+
+namespace Chess {
+
+class Board;
+
+/*!
+ * \brief A saved position of a chessboard
+ *
+ * A BoardSnapshot stores the position of a board, including its move
+ * history, so that the board can later be returned to that position
+ * with Board::restore() without replaying the moves in between.
+ * Snapshots can be taken every few plies to make seeking in long
+ * games fast.
+ *
+ * Snapshots are implicitly shared, so copying them is cheap.
+ *
+ * A snapshot is also a read-only view of the position: board()
+ * gives access to the const functions of the saved board, eg. for
+ * FEN export, tablebase probing or opening book queries. The saved
+ * board is never modified, so a snapshot can be handed to another
+ * thread while the original board keeps moving.
+ *
+ * \sa Board::snapshot()
+ * \sa Board::restore()
+ */
+class LIB_EXPORT BoardSnapshot
+{
+	public:
+		/*! Creates a null snapshot. */
+		BoardSnapshot();
+
+		/*! Returns true if the snapshot is null. */
+		bool isNull() const;
+		/*! Returns the number of plies played in the saved position. */
+		int plyCount() const;
+		/*! Returns the zobrist key of the saved position. */
+		quint64 key() const;
+		/*!
+		 * Returns the saved board, or 0 if the snapshot is null.
+		 *
+		 * The board stays valid for as long as a copy of the
+		 * snapshot exists.
+		 */
+		const Board* board() const;
+
+	private:
+		friend class Board;
+
+		explicit BoardSnapshot(const Board* board);
+
+		QSharedPointer<const Board> m_board;
+};
+
+} // namespace Chess
+
+Q_DECLARE_METATYPE(Chess::BoardSnapshot)
+
+#endif // BOARDSNAPSHOT_H
@@ -16,6 +16,7 @@
 */
 
 #include "boardtransition.h"
+#include <algorithm>
 
 namespace Chess {
 
@@ -39,22 +40,22 @@ void BoardTransition::clear()
 	m_reserve.clear();
 }
 
-QList<BoardTransition::Move> BoardTransition::moves() const
+const BoardTransition::MoveList& BoardTransition::moves() const
 {
 	return m_moves;
 }
 
-QList<BoardTransition::Drop> BoardTransition::drops() const
+const BoardTransition::DropList& BoardTransition::drops() const
 {
 	return m_drops;
 }
 
-QList<Square> BoardTransition::squares() const
+const BoardTransition::SquareList& BoardTransition::squares() const
 {
 	return m_squares;
 }
 
-QList<Piece> BoardTransition::reserve() const
+const BoardTransition::PieceList& BoardTransition::reserve() const
 {
 	return m_reserve;
 }
@@ -79,13 +80,15 @@ void BoardTransition::addDrop(const Piece& piece, const Square& target)
 
 void BoardTransition::addSquare(const Square& square)
 {
-	if (!m_squares.contains(square))
+	if (std::find(m_squares.begin(), m_squares.end(), square)
+	    == m_squares.end())
 		m_squares.append(square);
 }
 
 void BoardTransition::addReservePiece(const Piece& piece)
 {
-	if (!m_reserve.contains(piece))
+	if (std::find(m_reserve.begin(), m_reserve.end(), piece)
+	    == m_reserve.end())
 		m_reserve.append(piece);
 }
 
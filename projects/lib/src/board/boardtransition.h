@@ -18,7 +18,7 @@
 #ifndef BOARDTRANSITION_H
 #define BOARDTRANSITION_H
 
-#include <QList>
+#include <QVarLengthArray>
 #include "square.h"
 #include "piece.h"
 
@@ -34,6 +34,11 @@ namespace Chess {
  * state of a graphical board, and the former can be used to
  * display or animate the actual chessmove.
  *
+ * The lists are preallocated for the largest transitions of the
+ * supported variants (eg. an atomic explosion), so recording a
+ * move doesn't allocate memory. Boards only record a transition
+ * when one is passed to Board::makeMove().
+ *
  * \sa Board::makeMove()
  */
 class LIB_EXPORT BoardTransition
@@ -58,6 +63,15 @@ class LIB_EXPORT BoardTransition
 			Square target;	//!< Target square of the drop
 		};
 
+		/*! A list of "moves". */
+		typedef QVarLengthArray<Move, 4> MoveList;
+		/*! A list of piece drops. */
+		typedef QVarLengthArray<Drop, 2> DropList;
+		/*! A list of changed squares. */
+		typedef QVarLengthArray<Square, 16> SquareList;
+		/*! A list of changed piece reserves. */
+		typedef QVarLengthArray<Piece, 4> PieceList;
+
 		/*! Creates a new empty BoardTransition object. */
 		BoardTransition();
 
@@ -72,13 +86,13 @@ class LIB_EXPORT BoardTransition
 		 * One chessmove can involve several moving pieces, and
 		 * the actual chessmove may not be on the returned list.
 		 */
-		QList<Move> moves() const;
+		const MoveList& moves() const;
 		/*! Returns a list of piece drops. */
-		QList<Drop> drops() const;
+		const DropList& drops() const;
 		/*! Returns a list of changed squares. */
-		QList<Square> squares() const;
+		const SquareList& squares() const;
 		/*! Returns a list of changed piece reserves. */
-		QList<Piece> reserve() const;
+		const PieceList& reserve() const;
 
 		/*! Adds a new "move" from \a source to \a target. */
 		void addMove(const Square& source, const Square& target);
@@ -100,10 +114,10 @@ class LIB_EXPORT BoardTransition
 		void addReservePiece(const Piece& piece);
 
 	private:
-		QList<Move> m_moves;
-		QList<Drop> m_drops;
-		QList<Square> m_squares;
-		QList<Piece> m_reserve;
+		MoveList m_moves;
+		DropList m_drops;
+		SquareList m_squares;
+		PieceList m_reserve;
 };
 
 } // namespace Chess
@@ -49,7 +49,7 @@ QString CapablancaBoard::defaultFenString() const
 
 void CapablancaBoard::addPromotions(int sourceSquare,
 				int targetSquare,
-				QVarLengthArray<Move>& moves) const
+				MoveList& moves) const
 {
 	WesternBoard::addPromotions(sourceSquare, targetSquare, moves);
 
@@ -57,4 +57,9 @@ void CapablancaBoard::addPromotions(int sourceSquare,
 	moves.append(Move(sourceSquare, targetSquare, Chancellor));
 }
 
+bool CapablancaBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 } // namespace Chess
@@ -53,7 +53,8 @@ class LIB_EXPORT CapablancaBoard : public WesternBoard
 		// Inherited from WesternBoard
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray<Move>& moves) const;
+					   MoveList& moves) const;
+		virtual bool variantHasLegalMoveGenerator() const;
 };
 
 } // namespace Chess
@@ -59,10 +59,15 @@ int ChancellorBoard::castlingFile(WesternBoard::CastlingSide castlingSide) const
 	return castlingSide == QueenSide ? 2 : 6; // c-file and g-file
 }
 
-void ChancellorBoard::addPromotions(int sourceSquare, int targetSquare, QVarLengthArray< Move >& moves) const
+void ChancellorBoard::addPromotions(int sourceSquare, int targetSquare, MoveList& moves) const
 {
 	WesternBoard::addPromotions(sourceSquare, targetSquare, moves);
 	moves.append(Move(sourceSquare, targetSquare, Chancellor));
 }
 
+bool ChancellorBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 } // namespace Chess
@@ -77,7 +77,7 @@ void CourierBoard::vInitialize()
 	m_wazirOffsets[3] = m_arwidth;
 }
 
-void CourierBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
+void CourierBoard::generateMovesForPiece(MoveList& moves,
 					  int pieceType,
 					  int square) const
 {
@@ -70,6 +70,16 @@ int CrazyhouseBoard::reserveType(int pieceType) const
 	return pieceType;
 }
 
+bool CrazyhouseBoard::variantHasBitboards() const
+{
+	return true;
+}
+
+bool CrazyhouseBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 int CrazyhouseBoard::normalPieceType(int type)
 {
 	switch (type)
@@ -216,12 +226,29 @@ bool CrazyhouseBoard::pawnDropOkOnRank(int rank) const
 	return rank > 0 && rank < height() - 1;
 }
 
-void CrazyhouseBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
+void CrazyhouseBoard::generateMovesForPiece(MoveList& moves,
 					    int pieceType,
 					    int square) const
 {
 	// Generate drops
-	if (square == 0)
+	if (square == 0 && hasBitboards())
+	{
+		Bitboard targets = dropTargets();
+		if (pieceType == Pawn)
+		{
+			for (int rank = 0; rank < 8; rank++)
+			{
+				if (!pawnDropOkOnRank(rank))
+					targets &= ~(Bitboard(0xFF) << (rank * 8));
+			}
+		}
+		while (targets != 0)
+		{
+			int target = Bitboards::squareIndex(Bitboards::popLsb(targets));
+			moves.append(Move(0, target, pieceType));
+		}
+	}
+	else if (square == 0)
 	{
 		const int size = arraySize();
 		for (int i = 0; i < size; i++)
@@ -70,12 +70,14 @@ class LIB_EXPORT CrazyhouseBoard : public WesternBoard
 
 		// Inherited from WesternBoard
 		virtual int reserveType(int pieceType) const;
+		virtual bool variantHasBitboards() const;
+		virtual bool variantHasLegalMoveGenerator() const;
 		virtual QString sanMoveString(const Move& move);
 		virtual Move moveFromSanString(const QString& str);
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
-		virtual void generateMovesForPiece(QVarLengthArray<Move>& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 
@@ -51,7 +51,7 @@ bool ExtinctionBoard::kingsCountAssertion(int, int) const
 
 void ExtinctionBoard::addPromotions(int sourceSquare,
 				int targetSquare,
-				QVarLengthArray<Move>& moves) const
+				MoveList& moves) const
 {
 	if (m_allPromotions)
 		StandardBoard::addPromotions(sourceSquare, targetSquare, moves);
@@ -63,6 +63,11 @@ bool ExtinctionBoard::inCheck(Side, int) const
 	return false;
 }
 
+bool ExtinctionBoard::variantHasLegalMoveGenerator() const
+{
+	return false;
+}
+
 Piece ExtinctionBoard::extinctPiece(Side side) const
 {
 	for (const int type: m_pieceSet)
@@ -19,72 +19,30 @@
 
 namespace Chess {
 
-GenericMove::GenericMove()
-	: m_promotion(0)
-{
-}
-
 GenericMove::GenericMove(const Square& sourceSquare,
 			 const Square& targetSquare,
 			 int promotion)
-	: m_sourceSquare(sourceSquare),
-	  m_targetSquare(targetSquare),
-	  m_promotion(promotion)
-{
-}
-
-bool GenericMove::operator==(const GenericMove& other) const
-{
-	if (m_sourceSquare == other.m_sourceSquare
-	&&  m_targetSquare == other.m_targetSquare
-	&&  m_promotion == other.m_promotion)
-		return true;
-	return false;
-}
-
-bool GenericMove::operator!=(const GenericMove& other) const
-{
-	if (m_sourceSquare != other.m_sourceSquare
-	||  m_targetSquare != other.m_targetSquare
-	||  m_promotion != other.m_promotion)
-		return true;
-	return false;
-}
-
-bool GenericMove::isNull() const
-{
-	bool validSource = (m_sourceSquare.isValid() || m_promotion);
-	return !(validSource && m_targetSquare.isValid());
-}
-
-Square GenericMove::sourceSquare() const
-{
-	return m_sourceSquare;
-}
-
-Square GenericMove::targetSquare() const
-{
-	return m_targetSquare;
-}
-
-int GenericMove::promotion() const
+	: m_data(packSquare(sourceSquare) |
+		 (packSquare(targetSquare) << 12) |
+		 (quint32(promotion) << 24))
 {
-	return m_promotion;
+	Q_ASSERT(promotion >= 0 && promotion <= 0xFF);
 }
 
 void GenericMove::setSourceSquare(const Square& square)
 {
-	m_sourceSquare = square;
+	m_data = (m_data & ~0xFFFu) | packSquare(square);
 }
 
 void GenericMove::setTargetSquare(const Square& square)
 {
-	m_targetSquare = square;
+	m_data = (m_data & ~(0xFFFu << 12)) | (packSquare(square) << 12);
 }
 
 void GenericMove::setPromotion(int pieceType)
 {
-	m_promotion = pieceType;
+	Q_ASSERT(pieceType >= 0 && pieceType <= 0xFF);
+	m_data = (m_data & 0xFFFFFFu) | (quint32(pieceType) << 24);
 }
 
 } // namespace Chess
@@ -29,31 +29,76 @@ namespace Chess {
  * When a move is made by a human or retrieved from an opening book of any
  * kind, it will be in this format. Later it can be converted to Chess::Move
  * by a Chess::Board object.
+ *
+ * The squares and the promotion type are packed into 32 bits, so
+ * stored move histories (eg. in PgnGame) stay small. Each file and
+ * rank must be below 63, and the promotion type below 256; other
+ * files and ranks are stored as invalid.
+ *
+ * The packed value is also the move's identity: two moves are equal
+ * if their data() values are equal, and qHash() hashes that value,
+ * so moves can be used as cheap QHash and QSet keys.
  */
 class LIB_EXPORT GenericMove
 {
 	public:
 		/*! Constructs a new null (empty) move. */
-		GenericMove();
+		constexpr GenericMove()
+			: m_data(0)
+		{
+		}
 		/*! Constructs and initializes a new move. */
 		GenericMove(const Square& sourceSquare,
 			    const Square& targetSquare,
 			    int promotion);
 
+		/*!
+		 * Returns the move whose packed representation is \a data.
+		 * \sa data()
+		 */
+		static constexpr GenericMove fromData(quint32 data)
+		{
+			return GenericMove(data, 0);
+		}
+		/*! Returns the packed 32-bit representation of the move. */
+		constexpr quint32 data() const
+		{
+			return m_data;
+		}
+
 		/*! Returns true if \a other is the same as this move. */
-		bool operator==(const GenericMove& other) const;
+		constexpr bool operator==(const GenericMove& other) const
+		{
+			return m_data == other.m_data;
+		}
 		/*! Returns true if \a other is different from this move. */
-		bool operator!=(const GenericMove& other) const;
+		constexpr bool operator!=(const GenericMove& other) const
+		{
+			return m_data != other.m_data;
+		}
 
 		/*! Returns true if this is a null move. */
-		bool isNull() const;
+		constexpr bool isNull() const
+		{
+			return !((sourceSquare().isValid() || promotion() != 0)
+				 && targetSquare().isValid());
+		}
 
 		/*! The source square. */
-		Square sourceSquare() const;
+		constexpr Square sourceSquare() const
+		{
+			return unpackSquare(m_data);
+		}
 		/*! The target square. */
-		Square targetSquare() const;
+		constexpr Square targetSquare() const
+		{
+			return unpackSquare(m_data >> 12);
+		}
 		/*! Type of the promotion piece. */
-		int promotion() const;
+		constexpr int promotion() const
+		{
+			return int(m_data >> 24);
+		}
 
 		/*! Sets the source square to \a square. */
 		void setSourceSquare(const Square& square);
@@ -63,13 +108,49 @@ class LIB_EXPORT GenericMove
 		void setPromotion(int pieceType);
 
 	private:
-		Square m_sourceSquare;
-		Square m_targetSquare;
-		int m_promotion;
+		/*
+		 * Layout of m_data:
+		 * bits 0-11:  source square
+		 * bits 12-23: target square
+		 * bits 24-31: promotion type
+		 *
+		 * A square is stored as (file + 1) | ((rank + 1) << 6), so an
+		 * invalid file or rank is 0 and a null move is all zeros.
+		 */
+
+		// Tagged so it can't be mistaken for a public constructor
+		constexpr GenericMove(quint32 data, int)
+			: m_data(data)
+		{
+		}
+
+		static constexpr quint32 packCoordinate(int value)
+		{
+			return (value >= 0 && value < 63) ? quint32(value + 1) : 0;
+		}
+		static constexpr quint32 packSquare(const Square& square)
+		{
+			return packCoordinate(square.file())
+			     | (packCoordinate(square.rank()) << 6);
+		}
+		static constexpr Square unpackSquare(quint32 data)
+		{
+			return Square(int(data & 0x3F) - 1,
+				      int((data >> 6) & 0x3F) - 1);
+		}
+
+		quint32 m_data;
 };
 
+/*! Returns the hash value of \a move. */
+inline uint qHash(const GenericMove& move, uint seed = 0)
+{
+	return ::qHash(move.data(), seed);
+}
+
 } // namespace Chess
 
+Q_DECLARE_TYPEINFO(Chess::GenericMove, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(Chess::GenericMove)
 
 #endif // GENERICMOVE_H
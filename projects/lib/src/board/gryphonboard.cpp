@@ -117,6 +117,14 @@ void GryphonBoard::vUndoMove(const Move& move)
 	WesternBoard::vUndoMove(move);
 }
 
+void GryphonBoard::vRestore(const Board& other)
+{
+	WesternBoard::vRestore(other);
+
+	const GryphonBoard& board = static_cast<const GryphonBoard&>(other);
+	m_pieceStack = board.m_pieceStack;
+}
+
 bool GryphonBoard::isLegalPosition()
 {
 	if (!WesternBoard::isLegalPosition())
@@ -137,7 +145,7 @@ bool GryphonBoard::isLegalPosition()
 	return true;
 }
 
-void GryphonBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
+void GryphonBoard::generateMovesForPiece(MoveList& moves,
 					 int pieceType,
 					 int square) const
 {
@@ -179,14 +187,14 @@ QString SimplifiedGryphonBoard::defaultFenString() const
 	return "4k3/pppppppp/8/8/8/8/PPPPPPPP/4K3 w - - 0 1";
 }
 
-void SimplifiedGryphonBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
+void SimplifiedGryphonBoard::generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const
 {
 	if (pieceType != King)
 		return GryphonBoard::generateMovesForPiece(moves, pieceType, square);
 
-	QVarLengthArray< Move > newmoves;
+	MoveList newmoves;
 	GryphonBoard::generateMovesForPiece(newmoves, King, square);
 
 	for (const Move move: newmoves)
@@ -221,6 +229,15 @@ void SimplifiedGryphonBoard::vUndoMove(const Move& move)
 		m_captures[sideToMove()]--;
 }
 
+void SimplifiedGryphonBoard::vRestore(const Board& other)
+{
+	GryphonBoard::vRestore(other);
+
+	const SimplifiedGryphonBoard& board = static_cast<const SimplifiedGryphonBoard&>(other);
+	m_captures[Side::White] = board.m_captures[Side::White];
+	m_captures[Side::Black] = board.m_captures[Side::Black];
+}
+
 
 
 CircularGryphonBoard::CircularGryphonBoard()
@@ -299,7 +316,7 @@ int ChangeOverBoard::successorType(int type, bool reversed) const
 /*
  * This variant does not have the restriction to two sets of regular pieces.
  */
-void ChangeOverBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
+void ChangeOverBoard::generateMovesForPiece(MoveList& moves,
 					    int pieceType,
 					    int square) const
 {
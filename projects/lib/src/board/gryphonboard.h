@@ -62,8 +62,9 @@ class LIB_EXPORT GryphonBoard : public WesternBoard
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
+		virtual void vRestore(const Board& other);
 		virtual bool isLegalPosition();
-		virtual void generateMovesForPiece(QVarLengthArray< Move >& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 
@@ -111,12 +112,13 @@ class LIB_EXPORT SimplifiedGryphonBoard : public GryphonBoard
 		virtual QString defaultFenString() const;
 
 	protected:
-		virtual void generateMovesForPiece(QVarLengthArray< Move >& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
+		virtual void vRestore(const Board& other);
 
 	private:
 		int m_captures[2];
@@ -197,7 +199,7 @@ class LIB_EXPORT ChangeOverBoard : public CircularGryphonBoard
 	protected:
 		virtual int successorType(int type,
 					  bool reversed = false) const;
-		virtual void generateMovesForPiece(QVarLengthArray< Move >& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 		virtual bool isLegalPosition();
@@ -48,7 +48,7 @@ QString JanusBoard::defaultFenString() const
 
 void JanusBoard::addPromotions(int sourceSquare,
 				int targetSquare,
-				QVarLengthArray<Move>& moves) const
+				MoveList& moves) const
 {
 	WesternBoard::addPromotions(sourceSquare, targetSquare, moves);
 	moves.append(Move(sourceSquare, targetSquare, Janus));
@@ -105,4 +105,9 @@ Move JanusBoard::moveFromSanString(const QString& str)
 	return WesternBoard::moveFromSanString(str); // normal king moves
 }
 
+bool JanusBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 } // namespace Chess
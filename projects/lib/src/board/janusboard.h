@@ -62,10 +62,11 @@ class LIB_EXPORT JanusBoard : public WesternBoard
 		// Inherited from WesternBoard
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray<Move>& moves) const;
+					   MoveList& moves) const;
 		virtual int castlingFile(CastlingSide castlingSide) const;
 		virtual QString sanMoveString(const Move& move);
 		virtual Move moveFromSanString(const QString& str);
+		virtual bool variantHasLegalMoveGenerator() const;
 };
 
 } // namespace Chess
@@ -49,13 +49,13 @@ class LIB_EXPORT KnightMateBoard : public WesternBoard
 			Mann = King + 1	//!< Mann (Commoner, moves like a chess king)
 		};
 		// Inherited from WesternBoard
-		void virtual generateMovesForPiece(QVarLengthArray<Move>& moves,
+		void virtual generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 		virtual bool inCheck(Side side, int square = 0) const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray<Move>& moves) const;
+					   MoveList& moves) const;
 		virtual Move moveFromSanString(const QString& str);
 };
 
@@ -58,7 +58,7 @@ bool LosersBoard::vIsLegalMove(const Move& move)
 		m_captureKey = key();
 		m_canCapture = false;
 
-		QVarLengthArray<Move> moves;
+		MoveList moves;
 		generateMoves(moves);
 
 		for (int i = 0; i < moves.size(); i++)
@@ -77,6 +77,41 @@ bool LosersBoard::vIsLegalMove(const Move& move)
 	return WesternBoard::vIsLegalMove(move);
 }
 
+bool LosersBoard::generateLegalMoves(MoveList& moves, bool firstOnly)
+{
+	generateMoves(moves);
+
+	// Captures are compulsory, so the quiet moves are only
+	// tested if there are no legal captures
+	int count = 0;
+	for (int i = 0; i < moves.size(); i++)
+	{
+		if (captureType(moves[i]) != Piece::NoPiece
+		&&  WesternBoard::vIsLegalMove(moves[i]))
+		{
+			moves[count++] = moves[i];
+			if (firstOnly)
+				break;
+		}
+	}
+
+	m_captureKey = key();
+	m_canCapture = (count > 0);
+
+	for (int i = 0; i < moves.size() && !m_canCapture; i++)
+	{
+		if (WesternBoard::vIsLegalMove(moves[i]))
+		{
+			moves[count++] = moves[i];
+			if (firstOnly)
+				break;
+		}
+	}
+	moves.resize(count);
+
+	return true;
+}
+
 Result LosersBoard::result()
 {
 	Side winner;
@@ -91,14 +126,7 @@ Result LosersBoard::result()
 	}
 
 	// Lost all pieces
-	int pieceCount = 0;
-	for (int i = 0; i < arraySize(); i++)
-	{
-		if (pieceAt(i).side() == sideToMove()
-		&&  ++pieceCount > 1)
-			break;
-	}
-	if (pieceCount <= 1)
+	if (pieceCount(sideToMove()) <= 1)
 	{
 		winner = sideToMove();
 		str = tr("%1 lost all pieces").arg(winner.toString());
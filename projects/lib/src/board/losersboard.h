@@ -47,6 +47,7 @@ class LIB_EXPORT LosersBoard : public WesternBoard
 		// Inherited from WesternBoard
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool vIsLegalMove(const Move& move);
+		virtual bool generateLegalMoves(MoveList& moves, bool firstOnly);
 
 	private:
 		bool m_canCapture;
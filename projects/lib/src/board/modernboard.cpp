@@ -60,7 +60,7 @@ int ModernBoard::castlingFile(WesternBoard::CastlingSide castlingSide) const
 	return castlingSide == QueenSide ? 2 : 6; // c-file and g-file
 }
 
-void ModernBoard::addPromotions(int sourceSquare, int targetSquare, QVarLengthArray< Move >& moves) const
+void ModernBoard::addPromotions(int sourceSquare, int targetSquare, MoveList& moves) const
 {
 	WesternBoard::addPromotions(sourceSquare, targetSquare, moves);
 	moves.append(Move(sourceSquare, targetSquare, Minister));
@@ -96,4 +96,9 @@ Move ModernBoard::moveFromSanString(const QString& str)
 	return WesternBoard::moveFromSanString(str);
 }
 
+bool ModernBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 } // namespace Chess
@@ -65,7 +65,8 @@ class LIB_EXPORT ModernBoard : public WesternBoard
 		virtual int castlingFile(CastlingSide castlingSide) const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray< Move >& moves) const;
+					   MoveList& moves) const;
+		virtual bool variantHasLegalMoveGenerator() const;
 };
 
 } // namespace Chess
@@ -20,6 +20,7 @@
 
 #include <QtGlobal>
 #include <QMetaType>
+#include <QVarLengthArray>
 
 namespace Chess {
 
@@ -128,8 +129,19 @@ inline int Move::promotion() const
 	return (m_data >> 20) & 0x3FF;
 }
 
+/*!
+ * A list of moves, normally stored on the stack.
+ *
+ * The preallocated capacity is enough for the pseudo-legal moves of
+ * any position in the supported variants, including the drop variants,
+ * so move generation doesn't allocate memory. A longer list would
+ * still work but it would be moved to the heap.
+ */
+typedef QVarLengthArray<Move, 1024> MoveList;
+
 } // namespace Chess
 
+Q_DECLARE_TYPEINFO(Chess::Move, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(Chess::Move)
 
 #endif // MOVE_H
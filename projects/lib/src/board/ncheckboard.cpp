@@ -76,6 +76,15 @@ void NCheckBoard::vUndoMove(const Move& move)
 	StandardBoard::vUndoMove(move);
 }
 
+void NCheckBoard::vRestore(const Board& other)
+{
+	StandardBoard::vRestore(other);
+
+	const NCheckBoard& board = static_cast<const NCheckBoard&>(other);
+	m_checksToWin[Side::White] = board.m_checksToWin[Side::White];
+	m_checksToWin[Side::Black] = board.m_checksToWin[Side::Black];
+}
+
 Result NCheckBoard::result()
 {
 	// Side wins if counter is zero
@@ -63,6 +63,7 @@ class LIB_EXPORT NCheckBoard : public StandardBoard
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
+		virtual void vRestore(const Board& other);
 
 		/*! Returns total number of checks necessary to win */
 		int checkLimit() const;
@@ -69,6 +69,16 @@ int PocketKnightBoard::reserveType(int) const
 	return Piece::NoPiece;
 }
 
+bool PocketKnightBoard::variantHasBitboards() const
+{
+	return true;
+}
+
+bool PocketKnightBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 void PocketKnightBoard::vMakeMove(const Move& move, BoardTransition* transition)
 {
 	int source = move.sourceSquare();
@@ -95,10 +105,19 @@ void PocketKnightBoard::vUndoMove(const Move& move)
 		addToReserve(Piece(sideToMove(), prom));
 }
 
-void PocketKnightBoard::generateMovesForPiece(QVarLengthArray< Move >& moves, int pieceType, int square) const
+void PocketKnightBoard::generateMovesForPiece(MoveList& moves, int pieceType, int square) const
 {
 	// Generate drops
-	if (square == 0)
+	if (square == 0 && hasBitboards())
+	{
+		Bitboard targets = dropTargets();
+		while (targets != 0)
+		{
+			int target = Bitboards::squareIndex(Bitboards::popLsb(targets));
+			moves.append(Move(0, target, pieceType));
+		}
+	}
+	else if (square == 0)
 	{
 		const int size = arraySize();
 		for (int i = 0; i < size; i++)
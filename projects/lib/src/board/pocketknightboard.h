@@ -52,10 +52,12 @@ class LIB_EXPORT PocketKnightBoard : public WesternBoard
 	protected:
 		// Inherited from WesternBoard
 		virtual int reserveType(int pieceType) const;
+		virtual bool variantHasBitboards() const;
+		virtual bool variantHasLegalMoveGenerator() const;
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
-		virtual void generateMovesForPiece(QVarLengthArray< Move >& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 };
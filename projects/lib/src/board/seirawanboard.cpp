@@ -84,7 +84,7 @@ QList<Piece> SeirawanBoard::reservePieceTypes() const
 
 void SeirawanBoard::addPromotions(int sourceSquare,
 				  int targetSquare,
-				  QVarLengthArray<Move>& moves) const
+				  MoveList& moves) const
 {
 	WesternBoard::addPromotions(sourceSquare, targetSquare, moves);
 
@@ -94,23 +94,25 @@ void SeirawanBoard::addPromotions(int sourceSquare,
 
 bool SeirawanBoard::vSetFenString(const QStringList& fen)
 {
-	m_squareMap.clear();
+	m_squareMap.resize(arraySize());
+	for (int i = 0; i < m_squareMap.size(); i++)
+		m_squareMap[i] = -1;
 	return WesternBoard::vSetFenString(fen);
 }
 
 void SeirawanBoard::insertIntoSquareMap(int square, int count)
 {
-	m_squareMap.insert(square, count);
+	m_squareMap[square] = count;
 }
 
 void SeirawanBoard::updateSquareMap(const Move& move, int increment)
 {
 	int source = move.sourceSquare();
-	if (m_squareMap.contains(source))
+	if (m_squareMap[source] >= 0)
 		m_squareMap[source] += increment;
 
 	int target = move.targetSquare();
-	if (m_squareMap.contains(target))
+	if (m_squareMap[target] >= 0)
 		m_squareMap[target] += increment;
 }
 
@@ -150,9 +152,9 @@ QString SeirawanBoard::vFenString(Board::FenNotation notation) const
 	// prepend castling field with list of files usable for piece channeling
 	QString s;
 
-	for (int i: m_squareMap.keys())
+	for (int i = 0; i < m_squareMap.size(); i++)
 	{
-		if (m_squareMap[i] > 0)
+		if (m_squareMap[i] != 0)
 			continue;
 
 		Piece piece = pieceAt(i);
@@ -336,8 +338,7 @@ void SeirawanBoard::vMakeMove(const Move& move, BoardTransition* transition)
 
 	WesternBoard::vMakeMove(move, transition);
 
-	if (m_squareMap.contains(source)
-	&&  m_squareMap[source] == 0
+	if (m_squareMap[source] == 0
 	&&  prom != Piece::NoPiece)
 	{
 		if (prom >= rookSquareChanneling(Hawk))
@@ -386,14 +387,22 @@ void SeirawanBoard::vUndoMove(const Move& move)
 	WesternBoard::vUndoMove(move);
 }
 
-void SeirawanBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
+void SeirawanBoard::vRestore(const Board& other)
+{
+	WesternBoard::vRestore(other);
+
+	const SeirawanBoard& board = static_cast<const SeirawanBoard&>(other);
+	m_squareMap = board.m_squareMap;
+}
+
+void SeirawanBoard::generateMovesForPiece(MoveList& moves,
 					  int pieceType,
 					  int square) const
 {
 	if (!isValidSquare(chessSquare(square)))
 		return;
 
-	QVarLengthArray< Move > moves1, moves2;
+	MoveList moves1, moves2;
 	WesternBoard::generateMovesForPiece(moves1, pieceType, square);
 
 	// add normal moves
@@ -401,7 +410,7 @@ void SeirawanBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
 		moves.append(m);
 
 	// return if no channeling is allowed on square
-	if (!m_squareMap.contains(square) ||  m_squareMap[square] > 0)
+	if (m_squareMap[square] != 0)
 		return;
 
 	// generate channeling moves as promotions on base rank
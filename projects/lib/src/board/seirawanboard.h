@@ -19,6 +19,7 @@
 #define SEIRAWANBOARD_H
 
 #include "westernboard.h"
+#include <QVarLengthArray>
 
 namespace Chess {
 
@@ -68,7 +69,7 @@ class LIB_EXPORT SeirawanBoard : public WesternBoard
 		virtual QList< Piece > reservePieceTypes() const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray<Move>& moves) const;
+					   MoveList& moves) const;
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool parseCastlingRights(QChar c);
 		virtual QString vFenString(FenNotation notation) const;
@@ -79,11 +80,17 @@ class LIB_EXPORT SeirawanBoard : public WesternBoard
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
-		virtual void generateMovesForPiece(QVarLengthArray<Move>& moves,
+		virtual void vRestore(const Board& other);
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 	private:
-		QMap<int, int> m_squareMap;
+		/*
+		 * The number of moves made from or to each gating square,
+		 * indexed by square. Pieces can be gated on a square
+		 * while its count is zero. Other squares are set to -1.
+		 */
+		QVarLengthArray<int> m_squareMap;
 		void insertIntoSquareMap(int square, int count = 0);
 		void updateSquareMap(const Move& move, int increment);
 		enum direction { forward, backward };
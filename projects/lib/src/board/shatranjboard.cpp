@@ -73,12 +73,12 @@ void ShatranjBoard::vInitialize()
 
 void ShatranjBoard::addPromotions(int sourceSquare,
 				 int targetSquare,
-				 QVarLengthArray<Move>& moves) const
+				 MoveList& moves) const
 {
 	moves.append(Move(sourceSquare, targetSquare, Ferz));
 }
 
-void ShatranjBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
+void ShatranjBoard::generateMovesForPiece(MoveList& moves,
 					  int pieceType,
 					  int square) const
 {
@@ -174,12 +174,7 @@ Result ShatranjBoard::result()
 
 bool ShatranjBoard::bareKing(Side side, int count) const
 {
-	for (int i = 0; count < 2 && i < arraySize(); i++)
-	{
-		if (side == pieceAt(i).side())
-			++count;
-	}
-	return count < 2;
+	return pieceCount(side) + count < 2;
 }
 
 bool ShatranjBoard::canBareOpponentKing()
@@ -189,7 +184,7 @@ bool ShatranjBoard::canBareOpponentKing()
 	if (!bareKing(side.opposite(), -1))
 		return false;
 
-	QVarLengthArray<Move>moves;
+	MoveList moves;
 	generateMovesForPiece(moves, King, kingSquare(side));
 	for (const auto &m: moves)
 	{
@@ -20,43 +20,6 @@
 
 namespace Chess {
 
-Square::Square()
-	: m_file(-1),
-	  m_rank(-1)
-{
-}
-
-Square::Square(int file, int rank)
-	: m_file(file),
-	  m_rank(rank)
-{
-}
-
-bool Square::operator==(const Square& other) const
-{
-	return (m_file == other.m_file) && (m_rank == other.m_rank);
-}
-
-bool Square::operator!=(const Square& other) const
-{
-	return (m_file != other.m_file) || (m_rank != other.m_rank);
-}
-
-bool Square::isValid() const
-{
-	return (m_file >= 0) && (m_rank >= 0);
-}
-
-int Square::file() const
-{
-	return m_file;
-}
-
-int Square::rank() const
-{
-	return m_rank;
-}
-
 Square::Color Square::color() const
 {
 	if (!isValid())
@@ -66,14 +29,4 @@ Square::Color Square::color() const
 	return Dark;
 }
 
-void Square::setFile(int file)
-{
-	m_file = file;
-}
-
-void Square::setRank(int rank)
-{
-	m_rank = rank;
-}
-
 } // namespace Chess
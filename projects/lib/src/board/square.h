@@ -19,6 +19,7 @@
 #define SQUARE_H
 
 #include <QString>
+#include <QHash>
 
 namespace Chess {
 
@@ -28,6 +29,12 @@ namespace Chess {
 * Square is mainly used as a middle-layer between the Board
 * class (which uses integers for squares) and more generic, high-level
 * classes like GenericMove.
+*
+* A square is a trivially copyable 16-bit value: the file and the rank
+* are signed bytes, so they must be between -128 and 127. The
+* conversions to and from the padded square indexes of Board are
+* constexpr, so they cost nothing when the board size is known at
+* compile time.
 */
 class LIB_EXPORT Square
 {
@@ -41,34 +48,102 @@ class LIB_EXPORT Square
 		};
 
 		/*! Creates a new square with invalid defaults. */
-		Square();
+		constexpr Square()
+			: m_file(-1),
+			  m_rank(-1)
+		{
+		}
 		/*! Creates a new square from \a file and \a rank. */
-		Square(int file, int rank);
+		constexpr Square(int file, int rank)
+			: m_file(qint8(file)),
+			  m_rank(qint8(rank))
+		{
+		}
+
+		/*!
+		 * Returns the square of padded square index \a index on a
+		 * board of \a width files and \a height ranks.
+		 *
+		 * The padded board has a wall of one file on both sides
+		 * and two ranks at both ends, and its first index is the
+		 * top-left wall square.
+		 */
+		static constexpr Square fromIndex(int index, int width, int height)
+		{
+			return Square(index % (width + 2) - 1,
+				      height + 1 - index / (width + 2));
+		}
+		/*!
+		 * Returns the padded square index of this square on a
+		 * board of \a width files and \a height ranks.
+		 *
+		 * The square must be valid on the board.
+		 * \sa fromIndex()
+		 */
+		constexpr int index(int width, int height) const
+		{
+			return (height + 1 - m_rank) * (width + 2) + 1 + m_file;
+		}
+
+		/*! Returns the file and rank packed into 16 bits. */
+		constexpr quint16 data() const
+		{
+			return quint16(quint8(m_file) | (quint8(m_rank) << 8));
+		}
 
 		/*! Returns true if \a other is the same as this square. */
-		bool operator==(const Square& other) const;
+		constexpr bool operator==(const Square& other) const
+		{
+			return data() == other.data();
+		}
 		/*! Returns true if \a other is different from this square. */
-		bool operator!=(const Square& other) const;
+		constexpr bool operator!=(const Square& other) const
+		{
+			return data() != other.data();
+		}
 
 		/*! Returns true if both file and rank have non-negative values. */
-		bool isValid() const;
+		constexpr bool isValid() const
+		{
+			return m_file >= 0 && m_rank >= 0;
+		}
 
 		/*! Zero-based file of the square. 0 is the 'a' file. */
-		int file() const;
+		constexpr int file() const
+		{
+			return m_file;
+		}
 		/*! Zero-based rank of the square. 0 is white's first rank. */
-		int rank() const;
+		constexpr int rank() const
+		{
+			return m_rank;
+		}
 		/*! Returns the color of the square. */
 		Color color() const;
 
 		/*! Sets the file to \a file. */
-		void setFile(int file);
+		void setFile(int file)
+		{
+			m_file = qint8(file);
+		}
 		/*! Sets the rank to \a rank. */
-		void setRank(int rank);
+		void setRank(int rank)
+		{
+			m_rank = qint8(rank);
+		}
 
 	private:
-		int m_file;
-		int m_rank;
+		qint8 m_file;
+		qint8 m_rank;
 };
 
+/*! Returns the hash value of \a square. */
+inline uint qHash(const Square& square, uint seed = 0)
+{
+	return ::qHash(square.data(), seed);
+}
+
 } // namespace Chess
+
+Q_DECLARE_TYPEINFO(Chess::Square, Q_PRIMITIVE_TYPE);
 #endif // SQUARE_H
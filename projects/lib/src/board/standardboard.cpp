@@ -23,7 +23,7 @@ namespace {
 
 // Zobrist keys for Polyglot opening book compatibility
 // Specs: http://alpha.uhasselt.be/Research/Algebra/Toga/book_format.html
-const quint64 s_keys[] = {
+alignas(64) constexpr quint64 s_keys[] = {
 	Q_UINT64_C(0xF8D626AAAF278509), Q_UINT64_C(0x2218DBC13AB50C2A),
 	Q_UINT64_C(0xEB7284FF06058ED8), Q_UINT64_C(0x588B4C4C77A4044D),
 	Q_UINT64_C(0xC2366DF16A5D128C), Q_UINT64_C(0x6AF41C8BC3CD3747),
@@ -1071,18 +1071,63 @@ QString StandardBoard::defaultFenString() const
 	return "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 }
 
+bool StandardBoard::variantHasBitboards() const
+{
+	return true;
+}
+
+bool StandardBoard::variantHasLegalMoveGenerator() const
+{
+	return true;
+}
+
 Result StandardBoard::tablebaseResult(unsigned int* dtz) const
 {
-	SyzygyTablebase::PieceList pieces;
+	// Only collect the pieces if the position can be probed
+	int count = pieceCount();
+	if (count > SyzygyTablebase::maxPieces()
+	||  !SyzygyTablebase::tbAvailable(count))
+		return Result();
 
-	for (int i = 0; i < arraySize(); i++)
+	// The bitboards are in the tablebases' square order
+	SyzygyTablebase::PieceBitboards pieces = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	if (hasBitboards())
+	{
+		pieces.white = sideBitboard(Side::White);
+		pieces.black = sideBitboard(Side::Black);
+		pieces.kings = pieceBitboard(Side::White, King)
+			     | pieceBitboard(Side::Black, King);
+		pieces.queens = pieceBitboard(Side::White, Queen)
+			      | pieceBitboard(Side::Black, Queen);
+		pieces.rooks = pieceBitboard(Side::White, Rook)
+			     | pieceBitboard(Side::Black, Rook);
+		pieces.bishops = pieceBitboard(Side::White, Bishop)
+			       | pieceBitboard(Side::Black, Bishop);
+		pieces.knights = pieceBitboard(Side::White, Knight)
+			       | pieceBitboard(Side::Black, Knight);
+		pieces.pawns = pieceBitboard(Side::White, Pawn)
+			     | pieceBitboard(Side::Black, Pawn);
+	}
+	else
 	{
-		Piece piece(pieceAt(i));
-		if (piece.isValid())
+		quint64* types[] = { nullptr, &pieces.pawns, &pieces.knights,
+				     &pieces.bishops, &pieces.rooks,
+				     &pieces.queens, &pieces.kings };
+		for (int i = 0; i < arraySize(); i++)
 		{
-			if (pieces.size() > 6)
-				return Result();
-			pieces.append(qMakePair(chessSquare(i), piece));
+			const Piece piece(pieceAt(i));
+			if (!piece.isValid())
+				continue;
+
+			const Square square(chessSquare(i));
+			const quint64 bit = Q_UINT64_C(1)
+				<< (square.rank() * 8 + square.file());
+			if (piece.side() == Side::White)
+				pieces.white |= bit;
+			else
+				pieces.black |= bit;
+			if (piece.type() < int(sizeof(types) / sizeof(types[0])))
+				*types[piece.type()] |= bit;
 		}
 	}
 
@@ -1101,6 +1146,7 @@ Result StandardBoard::tablebaseResult(unsigned int* dtz) const
 					castling,
 					reversibleMoveCount(),
 					pieces,
+					key(),
 					dtz);
 }
 
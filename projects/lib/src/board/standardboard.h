@@ -45,6 +45,11 @@ class LIB_EXPORT StandardBoard : public WesternBoard
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
 		virtual Result tablebaseResult(unsigned int* dtm = nullptr) const;
+
+	protected:
+		// Inherited from WesternBoard
+		virtual bool variantHasBitboards() const;
+		virtual bool variantHasLegalMoveGenerator() const;
 };
 
 } // namespace Chess
@@ -48,16 +48,4 @@ Result SuicideBoard::vResultOfStalemate() const
 	return Result(Result::Win, winner, str);
 }
 
-int SuicideBoard::pieceCount(Side side, int ptype) const
-{
-	int count = 0;
-	for (int i = 0; i < arraySize(); i++)
-	{
-		if ((ptype == Piece::NoPiece || ptype == pieceAt(i).type())
-	        &&  (side == Side::NoSide || side == pieceAt(i).side()))
-			++count;
-	}
-	return count;
-}
-
 } // namespace Chess
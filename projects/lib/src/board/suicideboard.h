@@ -58,11 +58,6 @@ class LIB_EXPORT SuicideBoard : public AntiBoard
 	protected:
 		// Inherited from AntiBoard
 		virtual Result vResultOfStalemate() const;
-
-	private:
-		int pieceCount(Side side,
-			       int ptype = Piece::NoPiece) const;
-
 }; // namespace Chess
 
 }
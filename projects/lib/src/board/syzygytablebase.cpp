@@ -17,17 +17,66 @@
 
 #include "syzygytablebase.h"
 #include <QDir>
+#include <QFile>
 #include <QMutex>
+#include <QAtomicInteger>
 #include <QStringList>
 #include <tbprobe.h>
 #include "westernboard.h"
+#include "bitboard.h"
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
 
 namespace {
 
 bool s_initialized = false, s_initOK = false, s_noRule50 = false;
 int s_pieces = INT_MAX;
+QString s_paths;
 QMutex s_mutex;
 
+/*
+ * A probe cache shared by all threads. An entry stores the probed
+ * value and the key XORed with it, so a torn or overwritten entry
+ * simply fails the key check instead of needing a lock.
+ */
+struct CacheEntry
+{
+	QAtomicInteger<quint64> check;
+	QAtomicInteger<quint64> data;
+};
+
+const int CacheSize = 1 << 16;
+CacheEntry s_cache[CacheSize];
+QAtomicInteger<quint64> s_cacheProbes;
+QAtomicInteger<quint64> s_cacheHits;
+
+bool cacheLookup(quint64 key, unsigned* value)
+{
+	if (key == 0)
+		return false;
+
+	s_cacheProbes.ref();
+	const CacheEntry& entry = s_cache[key & (CacheSize - 1)];
+	const quint64 data = entry.data.loadAcquire();
+	if ((entry.check.loadAcquire() ^ data) != key)
+		return false;
+
+	s_cacheHits.ref();
+	*value = unsigned(data);
+	return true;
+}
+
+void cacheStore(quint64 key, unsigned value)
+{
+	if (key == 0)
+		return;
+
+	CacheEntry& entry = s_cache[key & (CacheSize - 1)];
+	entry.data.storeRelease(value);
+	entry.check.storeRelease(key ^ value);
+}
+
 int tbSquare(const Chess::Square& square)
 {
 	if (!square.isValid())
@@ -35,6 +84,54 @@ int tbSquare(const Chess::Square& square)
 	return square.rank() * 8 + square.file();
 }
 
+Chess::Side tbWinner(unsigned wdl, bool wtm)
+{
+	switch (wdl)
+	{
+	case TB_BLESSED_LOSS:
+		if (!s_noRule50)
+			break;
+		// Fallthrough
+	case TB_LOSS:
+		return (wtm? Chess::Side::Black: Chess::Side::White);
+	case TB_CURSED_WIN:
+		if (!s_noRule50)
+			break;
+		// Fallthrough
+	case TB_WIN:
+		return (wtm? Chess::Side::White: Chess::Side::Black);
+	default:
+		break;
+	}
+
+	return Chess::Side::NoSide;
+}
+
+qint64 preloadFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return 0;
+
+	const qint64 size = file.size();
+	uchar* data = file.map(0, size);
+	if (data == nullptr)
+		return 0;
+
+#ifdef Q_OS_UNIX
+	posix_madvise(data, size_t(size), POSIX_MADV_WILLNEED);
+#endif
+
+	// Touch every page so that the file is in the page cache
+	// when Fathom maps it
+	volatile uchar sum = 0;
+	for (qint64 i = 0; i < size; i += 4096)
+		sum ^= data[i];
+
+	file.unmap(data);
+	return size;
+}
+
 } // anonymous namespace
 
 bool SyzygyTablebase::initialize(const QString& path)
@@ -42,6 +139,7 @@ bool SyzygyTablebase::initialize(const QString& path)
 	if (s_initialized)
 		return s_initOK;
 	s_initialized = true;
+	s_paths = path;
 
 	const auto nativePath = QDir::toNativeSeparators(path);
 	s_initOK = tb_init(nativePath.toStdString().c_str());
@@ -60,30 +158,80 @@ void SyzygyTablebase::setPieces(int pieces)
 		s_pieces = pieces;
 }
 
+int SyzygyTablebase::maxPieces()
+{
+	return s_pieces;
+}
+
 void SyzygyTablebase::setNoRule50()
 {
 	s_noRule50 = true;
 }
 
+int SyzygyTablebase::preload(int pieces,
+			      const QStringList& materials,
+			      qint64* bytes)
+{
+	if (bytes != nullptr)
+		*bytes = 0;
+	if (!s_initOK)
+		return 0;
+
+#ifdef Q_OS_WIN
+	const QChar separator(';');
+#else
+	const QChar separator(':');
+#endif
+
+	int count = 0;
+	const QStringList filters = { "*.rtbw", "*.rtbz" };
+	for (const QString& path : s_paths.split(separator, QString::SkipEmptyParts))
+	{
+		QDir dir(path);
+		const QStringList files = dir.entryList(filters, QDir::Files);
+		for (const QString& fileName : files)
+		{
+			// Eg. "KRPvKR.rtbw" has 5 pieces
+			const QString material = fileName.section('.', 0, 0);
+			if (material.size() - 1 > pieces
+			&&  !materials.contains(material))
+				continue;
+
+			const qint64 size = preloadFile(dir.filePath(fileName));
+			if (size <= 0)
+				continue;
+
+			count++;
+			if (bytes != nullptr)
+				*bytes += size;
+		}
+	}
+
+	return count;
+}
+
+quint64 SyzygyTablebase::cacheProbes()
+{
+	return s_cacheProbes.load();
+}
+
+quint64 SyzygyTablebase::cacheHits()
+{
+	return s_cacheHits.load();
+}
+
 Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 					   const Chess::Square& enpassantSq,
 					   Castling castling,
 					   int rule50,
 					   const PieceList& pieces,
+					   quint64 key,
 					   unsigned int* dtz)
 {
-	if (!s_initOK)
-		return Chess::Result();
-	if (castling)
-		return Chess::Result();
-	if (pieces.size() > s_pieces)
+	if (!s_initOK || castling || pieces.size() > s_pieces)
 		return Chess::Result();
 
-	bool wtm = (side == Chess::Side::White);
-	unsigned ep = (tbSquare(enpassantSq) < 0? 0: tbSquare(enpassantSq));
-	uint64_t white = 0, black = 0;
-	uint64_t kings = 0, queens = 0, rooks = 0, bishops = 0, knights = 0,
-		pawns = 0;
+	PieceBitboards bitboards = { 0, 0, 0, 0, 0, 0, 0, 0 };
 	typedef QPair<Chess::Square, Chess::Piece> PcSq;
 	for (const PcSq& item : pieces)
 	{
@@ -92,60 +240,90 @@ Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 		unsigned sq = tbSquare(item.first);
 		uint64_t bit = ((uint64_t)1 << sq);
 		if (item.second.side() == Chess::Side::White)
-			white |= bit;
+			bitboards.white |= bit;
 		else
-			black |= bit;
+			bitboards.black |= bit;
 		switch (item.second.type())
 		{
 		case Chess::WesternBoard::Pawn:
-			pawns |= bit; break;
+			bitboards.pawns |= bit; break;
 		case Chess::WesternBoard::Knight:
-			knights |= bit; break;
+			bitboards.knights |= bit; break;
 		case Chess::WesternBoard::Bishop:
-			bishops |= bit; break;
+			bitboards.bishops |= bit; break;
 		case Chess::WesternBoard::Rook:
-			rooks |= bit; break;
+			bitboards.rooks |= bit; break;
 		case Chess::WesternBoard::Queen:
-			queens |= bit; break;
+			bitboards.queens |= bit; break;
 		case Chess::WesternBoard::King:
-			kings |= bit; break;
+			bitboards.kings |= bit; break;
 		}
 	}
 
-	s_mutex.lock();
-	unsigned result = tb_probe_root(white, black, kings, queens, rooks,
-		bishops, knights, pawns, rule50, 0, ep, wtm, nullptr);
-	s_mutex.unlock();
+	return result(side, enpassantSq, castling, rule50, bitboards, key, dtz);
+}
 
-	Chess::Side winner(Chess::Side::NoSide); 
-	if (result == TB_RESULT_FAILED)
+Chess::Result SyzygyTablebase::result(const Chess::Side& side,
+					   const Chess::Square& enpassantSq,
+					   Castling castling,
+					   int rule50,
+					   const PieceBitboards& pieces,
+					   quint64 key,
+					   unsigned int* dtz)
+{
+	const uint64_t white = pieces.white, black = pieces.black;
+	if (!s_initOK
+	||  castling
+	||  Chess::Bitboards::popCount(white | black) > s_pieces)
 		return Chess::Result();
-	if (result == TB_RESULT_CHECKMATE)
-		winner = (wtm? Chess::Side::Black: Chess::Side::White);
-	else if (result == TB_RESULT_STALEMATE)
-		winner = Chess::Side::NoSide;
-	else
+
+	bool wtm = (side == Chess::Side::White);
+	unsigned ep = (tbSquare(enpassantSq) < 0? 0: tbSquare(enpassantSq));
+	const uint64_t kings = pieces.kings, queens = pieces.queens,
+		rooks = pieces.rooks, bishops = pieces.bishops,
+		knights = pieces.knights, pawns = pieces.pawns;
+
+	// The WDL probe is thread-safe and much cheaper than the DTZ root
+	// probe. WDL values are for a reset halfmove clock, which only
+	// matters for a win or loss that the 50-move rule could still
+	// turn into a draw.
+	if (dtz == nullptr)
 	{
-		switch (TB_GET_WDL(result))
+		unsigned wdl;
+		if (!cacheLookup(key, &wdl))
 		{
-		case TB_BLESSED_LOSS:
-			if (!s_noRule50)
-				break;
-			// Fallthrough
-		case TB_LOSS:
-			winner = (wtm? Chess::Side::Black: Chess::Side::White);
-			break;
-		case TB_DRAW:
-			break;
-		case TB_CURSED_WIN:
-			if (!s_noRule50)
-				break;
-			// Fallthrough
-		case TB_WIN:
-			winner = (wtm? Chess::Side::White: Chess::Side::Black);
-			break;
+			wdl = tb_probe_wdl(white, black, kings, queens, rooks,
+				bishops, knights, pawns, 0, 0, ep, wtm);
+			cacheStore(key, wdl);
 		}
+		if (wdl == TB_RESULT_FAILED)
+			return Chess::Result();
+		if ((wdl != TB_WIN && wdl != TB_LOSS) || rule50 == 0 || s_noRule50)
+			return Chess::Result(Chess::Result::Adjudication,
+					     tbWinner(wdl, wtm), "SyzygyTB");
 	}
+
+	// The root probe isn't reentrant. Its result depends on the
+	// halfmove clock, which is mixed into the cache key.
+	const quint64 rootKey = (key == 0) ? 0
+		: key ^ (quint64(rule50 + 1) * Q_UINT64_C(0x9E3779B97F4A7C15));
+	unsigned result;
+	if (!cacheLookup(rootKey, &result))
+	{
+		s_mutex.lock();
+		result = tb_probe_root(white, black, kings, queens, rooks,
+			bishops, knights, pawns, rule50, 0, ep, wtm, nullptr);
+		s_mutex.unlock();
+		cacheStore(rootKey, result);
+	}
+
+	Chess::Side winner(Chess::Side::NoSide); 
+	if (result == TB_RESULT_FAILED)
+		return Chess::Result();
+	if (result == TB_RESULT_CHECKMATE)
+		winner = (wtm? Chess::Side::Black: Chess::Side::White);
+	else if (result != TB_RESULT_STALEMATE)
+		winner = tbWinner(TB_GET_WDL(result), wtm);
 	if (dtz != nullptr)
 		*dtz = TB_GET_DTZ(result);
 	return Chess::Result(Chess::Result::Adjudication, winner, "SyzygyTB");
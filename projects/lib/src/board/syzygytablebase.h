@@ -21,6 +21,7 @@
 #include <QFlags>
 #include <QList>
 #include <QPair>
+#include <QStringList>
 #include "result.h"
 #include "square.h"
 #include "piece.h"
@@ -53,6 +54,24 @@ class LIB_EXPORT SyzygyTablebase
 		/*! Synonym for QList< QPair<Chess::Square, Chess::Piece> >. */
 		typedef QList< QPair<Chess::Square, Chess::Piece> > PieceList;
 
+		/*!
+		 * \brief The pieces of a position as bitboards.
+		 *
+		 * Bit 0 is the a1 square, bit 7 is h1 and bit 63 is h8,
+		 * which is the layout of Chess::Bitboard and Fathom.
+		 */
+		struct PieceBitboards
+		{
+			quint64 white;		//!< The white pieces
+			quint64 black;		//!< The black pieces
+			quint64 kings;		//!< The kings of both sides
+			quint64 queens;		//!< The queens of both sides
+			quint64 rooks;		//!< The rooks of both sides
+			quint64 bishops;	//!< The bishops of both sides
+			quint64 knights;	//!< The knights of both sides
+			quint64 pawns;		//!< The pawns of both sides
+		};
+
 		/*!
 		 * Initializes the tablebases.
 		 *
@@ -72,18 +91,60 @@ class LIB_EXPORT SyzygyTablebase
 		 * adjudication. Default is no limit.
 		 */
 		static void setPieces(int pieces);
+		/*!
+		 * Returns the maximum number of pieces to be used for tablebase
+		 * adjudication.
+		 *
+		 * \sa setPieces()
+		 */
+		static int maxPieces();
 		/*!
 		 * Disable the 50 move rule from consideration.
 		 */
 		static void setNoRule50();
+		/*!
+		 * Reads the tablebase files for positions with up to
+		 * \a pieces pieces, and the files of the materials in
+		 * \a materials (eg. "KRPvKR"), into the OS page cache.
+		 *
+		 * Fathom maps the files lazily, so the first probe of each
+		 * material would otherwise wait for the disk, usually on
+		 * a game's clock. The tablebases must be initialized first.
+		 *
+		 * Returns the number of files read, and sets \a bytes to
+		 * their total size.
+		 */
+		static int preload(int pieces,
+				   const QStringList& materials = QStringList(),
+				   qint64* bytes = nullptr);
+		/*!
+		 * Returns the number of lookups in the probe cache.
+		 *
+		 * The cache is shared by all games, and it holds the
+		 * results of recent probes by position key.
+		 */
+		static quint64 cacheProbes();
+		/*!
+		 * Returns the number of probes that were answered by the
+		 * probe cache without reading the tablebases.
+		 */
+		static quint64 cacheHits();
 		/*!
 		 * Returns the expected game result for the positions specified
 		 * by \a side, \a enpassantSq, \a castling and \a pieces.
 		 *
+		 * \a key is the position's Zobrist key, which is used for
+		 * the probe cache. A zero key bypasses the cache.
+		 *
 		 * If the position is a win for either player, \a dtz is
 		 * set to the distance to zero, ie. the number of plies it
 		 * takes to force a non-reversible move or mate.
 		 *
+		 * Without \a dtz the position is probed in the thread-safe
+		 * WDL tables, and the DTZ tables are only needed if a win
+		 * could still be spoiled by the 50-move rule. Probing
+		 * the DTZ tables is serialized between threads.
+		 *
 		 * If the position isn't found in the tablebases, a null result
 		 * is returned.
 		 *
@@ -94,6 +155,22 @@ class LIB_EXPORT SyzygyTablebase
 					    Castling castling,
 					    int rule50,
 					    const PieceList& pieces,
+					    quint64 key = 0,
+					    unsigned int* dtz = nullptr);
+		/*!
+		 * Returns the expected game result for the position whose
+		 * pieces are in \a pieces.
+		 *
+		 * This overload takes the bitboards that are probed
+		 * directly, so a board that keeps bitboards doesn't have
+		 * to build a piece list for every probe.
+		 */
+		static Chess::Result result(const Chess::Side& side,
+					    const Chess::Square& enpassantSq,
+					    Castling castling,
+					    int rule50,
+					    const PieceBitboards& pieces,
+					    quint64 key = 0,
 					    unsigned int* dtz = nullptr);
 
 	private:
@@ -88,14 +88,14 @@ bool TwoKingsEachBoard::inCheck(Side side, int square) const
 	return WesternBoard::inCheck(side, square);
 }
 
-void TwoKingsEachBoard::generateMovesForPiece(QVarLengthArray< Move >& moves, int pieceType, int square) const
+void TwoKingsEachBoard::generateMovesForPiece(MoveList& moves, int pieceType, int square) const
 {
 	if (pieceType != King)
 		return WesternBoard::generateMovesForPiece(moves,
 							   pieceType,
 							   square);
 
-	QVarLengthArray< Move > testmoves;
+	MoveList testmoves;
 	WesternBoard::generateMovesForPiece(testmoves, King, square);
 
 	for (const auto& move : testmoves)
@@ -53,7 +53,7 @@ class LIB_EXPORT TwoKingsEachBoard : public WesternBoard
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
 		virtual bool inCheck(Side side, int square = 0) const;
-		virtual void generateMovesForPiece(QVarLengthArray< Move >& moves,
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 		virtual Move moveFromLanString(const QString& str);
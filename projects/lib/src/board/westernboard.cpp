@@ -35,6 +35,9 @@ WesternBoard::WesternBoard(WesternZobrist* zobrist)
 	  m_pawnHasDoubleStep(true),
 	  m_hasEnPassantCaptures(true),
 	  m_pawnAmbiguous(false),
+	  m_diagonalPawnCaptures(true),
+	  m_hasLegalMoveGenerator(false),
+	  m_dropMask(~Bitboard(0)),
 	  m_zobrist(zobrist)
 {
 	setPieceType(Pawn, tr("pawn"), "P");
@@ -89,12 +92,18 @@ bool WesternBoard::variantHasChanneling(Side, int) const
 	return false;
 }
 
+bool WesternBoard::variantHasLegalMoveGenerator() const
+{
+	return false;
+}
+
 void WesternBoard::vInitialize()
 {
 	m_kingCanCapture = kingCanCapture();
 	m_hasCastling = hasCastling();
 	m_pawnHasDoubleStep = pawnHasDoubleStep();
 	m_hasEnPassantCaptures = hasEnPassantCaptures();
+	m_hasLegalMoveGenerator = variantHasLegalMoveGenerator();
 
 	m_arwidth = width() + 2;
 
@@ -134,6 +143,36 @@ void WesternBoard::vInitialize()
 	m_rookOffsets[3] = m_arwidth;
 
 	m_pawnAmbiguous = (pawnAmbiguity(FreeStep) > 1);
+
+	// Pawn attacks can be looked up from the bitboard tables
+	// if pawns capture one square diagonally forward
+	int captureFiles = 0;
+	for (const PawnStep& pStep: m_pawnSteps)
+	{
+		if (pStep.type != CaptureStep)
+			continue;
+		if (pStep.file == -1 || pStep.file == 1)
+			captureFiles |= (pStep.file == -1) ? 1 : 2;
+		else
+			captureFiles |= 4;
+	}
+	m_diagonalPawnCaptures = (captureFiles == 3
+				  && pawnAmbiguity(CaptureStep) == 2);
+
+	m_knightTypes.clear();
+	m_bishopTypes.clear();
+	m_rookTypes.clear();
+	for (int type = Pawn; type < pieceTypeCount(); type++)
+	{
+		if (type == King)
+			continue;
+		if (pieceHasMovement(type, KnightMovement))
+			m_knightTypes.append(type);
+		if (pieceHasMovement(type, BishopMovement))
+			m_bishopTypes.append(type);
+		if (pieceHasMovement(type, RookMovement))
+			m_rookTypes.append(type);
+	}
 }
 
 inline int WesternBoard::pawnPushOffset(const PawnStep& ps, int sign) const
@@ -183,16 +222,22 @@ QString WesternBoard::sanMoveString(const Move& move)
 	Piece capture = pieceAt(target);
 	Square square = chessSquare(source);
 
+	// The move has to be made only for the mate test, which
+	// is needed only if the move gives check
 	char checkOrMate = 0;
-	makeMove(move);
-	if (inCheck(sideToMove()))
+	bool check;
+	if (!givesCheck(move, &check) || check)
 	{
-		if (canMove())
-			checkOrMate = '+';
-		else
-			checkOrMate = '#';
+		makeMove(move);
+		if (inCheck(sideToMove()))
+		{
+			if (canMove())
+				checkOrMate = '+';
+			else
+				checkOrMate = '#';
+		}
+		undoMove();
 	}
-	undoMove();
 
 	// drop move
 	if (source == 0 && move.promotion() != Piece::NoPiece)
@@ -236,25 +281,39 @@ QString WesternBoard::sanMoveString(const Move& move)
 	if (piece.type() != Pawn)	// not pawn
 	{
 		str += pieceSymbol(piece).toUpper();
-		QVarLengthArray<Move> moves;
-		generateMoves(moves, piece.type());
 
-		for (int i = 0; i < moves.size(); i++)
+		// 'source2' is another piece that can move to 'target'
+		auto addRival = [&](int source2)
 		{
-			const Move& move2 = moves[i];
-			if (move2.sourceSquare() == 0
-			||  move2.sourceSquare() == source
-			||  move2.targetSquare() != target)
-				continue;
-
-			if (!vIsLegalMove(move2))
-				continue;
-
-			Square square2(chessSquare(move2.sourceSquare()));
+			Square square2(chessSquare(source2));
 			if (square2.file() != square.file())
 				needFile = true;
 			else if (square2.rank() != square.rank())
 				needRank = true;
+		};
+
+		Bitboard rivals;
+		if (sameTypeAttackers(source, target, &rivals))
+		{
+			while (rivals != 0)
+				addRival(Bitboards::squareIndex(Bitboards::popLsb(rivals)));
+		}
+		else
+		{
+			MoveList moves;
+			generateMoves(moves, piece.type());
+
+			for (int i = 0; i < moves.size(); i++)
+			{
+				const Move& move2 = moves[i];
+				if (move2.sourceSquare() == 0
+				||  move2.sourceSquare() == source
+				||  move2.targetSquare() != target)
+					continue;
+
+				if (vIsLegalMove(move2))
+					addRival(move2.sourceSquare());
+			}
 		}
 	}
 	if (needFile)
@@ -300,31 +359,42 @@ Move WesternBoard::moveFromLanString(const QString& str)
 	return move;
 }
 
-Move WesternBoard::moveFromSanString(const QString& str)
+Square WesternBoard::sanSquare(const QChar* str) const
 {
-	if (str.length() < 2)
-		return Move();
+	if (coordinateSystem() != NormalCoordinates)
+		return chessSquare(QString(str, 2));
+
+	if (str[1] < '0' || str[1] > '9')
+		return Square();
+	return Square(str[0].toLatin1() - 'a', str[1].toLatin1() - '1');
+}
 
-	QString mstr = str;
+Move WesternBoard::moveFromSanString(const QString& str)
+{
+	// The string is read in place, without making copies or
+	// substrings of it
+	const QChar* s = str.constData();
+	int len = str.length();
 	Side side = sideToMove();
 
 	// Ignore check/mate/strong move/blunder notation
-	while (mstr.endsWith('+') || mstr.endsWith('#')
-	||     mstr.endsWith('!') || mstr.endsWith('?'))
+	while (len > 0
+	&&     (s[len - 1] == '+' || s[len - 1] == '#'
+	||      s[len - 1] == '!' || s[len - 1] == '?'))
 	{
-		mstr.chop(1);
+		len--;
 	}
 
-	if (mstr.length() < 2)
+	if (len < 2)
 		return Move();
 
 	// Castling
-	if (mstr.startsWith("O-O"))
+	if (s[0] == 'O' && len >= 3 && s[1] == '-' && s[2] == 'O')
 	{
 		CastlingSide cside;
-		if (mstr == "O-O")
+		if (len == 3)
 			cside = KingSide;
-		else if (mstr == "O-O-O")
+		else if (len == 5 && s[3] == '-' && s[4] == 'O')
 			cside = QueenSide;
 		else
 			return Move();
@@ -333,7 +403,7 @@ Move WesternBoard::moveFromSanString(const QString& str)
 		int target = m_castlingRights.rookSquare[side][cside];
 
 		Move move(source, target);
-		if (isLegalMove(move))
+		if ((isTrustedSanString() && target != 0) || isLegalMove(move))
 			return move;
 		else
 			return Move();
@@ -341,16 +411,16 @@ Move WesternBoard::moveFromSanString(const QString& str)
 
 	Square sourceSq;
 	Square targetSq;
-	QString::const_iterator it = mstr.cbegin();
+	int pos = 0;
 
 	// A SAN move can't start with the capture mark, and
-	if (*it == 'x')
+	if (s[pos] == 'x')
 		return Move();
 	// a pawn move should not specify the piece type
-	if (pieceFromSymbol(*it) == Pawn)
-		it++; // ignore character
+	if (pieceFromSymbol(s[pos]) == Pawn)
+		pos++; // ignore character
 	// Piece type
-	Piece piece = pieceFromSymbol(*it);
+	Piece piece = pieceFromSymbol(s[pos]);
 	if (piece.side() != Side::White)
 		piece = Piece::NoPiece;
 	else
@@ -358,18 +428,19 @@ Move WesternBoard::moveFromSanString(const QString& str)
 	if (piece.isEmpty())
 	{
 		piece = Piece(side, Pawn);
-		targetSq = chessSquare(mstr.mid(0, 2));
+		if (pos + 1 < len)
+			targetSq = sanSquare(s + pos);
 		if (isValidSquare(targetSq))
-			it += 2;
+			pos += 2;
 	}
 	else
 	{
-		++it;
+		++pos;
 
 		// Drop moves
-		if (*it == '@')
+		if (s[pos] == '@')
 		{
-			targetSq = chessSquare(mstr.right(2));
+			targetSq = sanSquare(s + len - 2);
 			if (!isValidSquare(targetSq))
 				return Move();
 
@@ -385,21 +456,21 @@ Move WesternBoard::moveFromSanString(const QString& str)
 	if (!isValidSquare(targetSq))
 	{
 		// Source square's file
-		sourceSq.setFile(it->toLatin1() - 'a');
+		sourceSq.setFile(s[pos].toLatin1() - 'a');
 		if (sourceSq.file() < 0 || sourceSq.file() >= width())
 			sourceSq.setFile(-1);
-		else if (++it == mstr.cend())
+		else if (++pos == len)
 			return Move();
 
 		// Source square's rank
-		if (it->isDigit())
+		if (s[pos].isDigit())
 		{
-			sourceSq.setRank(it->toLatin1() - '1');
+			sourceSq.setRank(s[pos].toLatin1() - '1');
 			if (sourceSq.rank() < 0 || sourceSq.rank() >= height())
 				return Move();
-			++it;
+			++pos;
 		}
-		if (it == mstr.cend())
+		if (pos == len)
 		{
 			// What we thought was the source square, was
 			// actually the target square.
@@ -413,9 +484,9 @@ Move WesternBoard::moveFromSanString(const QString& str)
 				return Move();
 		}
 		// Capture
-		else if (*it == 'x')
+		else if (s[pos] == 'x')
 		{
-			if(++it == mstr.cend())
+			if (++pos == len)
 				return Move();
 			stringIsCapture = true;
 		}
@@ -423,10 +494,10 @@ Move WesternBoard::moveFromSanString(const QString& str)
 		// Target square
 		if (!isValidSquare(targetSq))
 		{
-			if (it + 1 == mstr.cend())
+			if (pos + 1 == len)
 				return Move();
-			targetSq = chessSquare(mstr.mid(it - mstr.cbegin(), 2));
-			it += 2;
+			targetSq = sanSquare(s + pos);
+			pos += 2;
 		}
 	}
 	if (!isValidSquare(targetSq))
@@ -444,39 +515,60 @@ Move WesternBoard::moveFromSanString(const QString& str)
 
 	// Promotion
 	int promotion = Piece::NoPiece;
-	if (it != mstr.cend())
+	if (pos < len)
 	{
-		if ((*it == '=' || *it == '(') && ++it == mstr.cend())
+		if ((s[pos] == '=' || s[pos] == '(') && ++pos == len)
 			return Move();
 
-		promotion = pieceFromSymbol(*it).type();
+		promotion = pieceFromSymbol(s[pos]).type();
 		if (promotion == Piece::NoPiece)
 			return Move();
 	}
 
-	QVarLengthArray<Move> moves;
+	MoveList moves;
 	generateMoves(moves, piece.type());
 	const Move* match = nullptr;
 
-	// Loop through all legal moves to find a move that matches
-	// the data we got from the move string.
-	for (int i = 0; i < moves.size(); i++)
+	auto matches = [&](const Move& move)
 	{
-		const Move& move = moves[i];
 		if (move.sourceSquare() == 0 || move.targetSquare() != target)
-			continue;
+			return false;
 		Square sourceSq2 = chessSquare(move.sourceSquare());
 		if (sourceSq.rank() != -1 && sourceSq2.rank() != sourceSq.rank())
-			continue;
+			return false;
 		if (sourceSq.file() != -1 && sourceSq2.file() != sourceSq.file())
-			continue;
+			return false;
 		// Castling moves were handled earlier
 		if (pieceAt(target) == Piece(side, Rook))
-			continue;
-		if (move.promotion() != promotion)
-			continue;
+			return false;
+		return move.promotion() == promotion;
+	};
+
+	// A trusted move string that matches only one pseudo-legal
+	// move doesn't need the legality test
+	if (isTrustedSanString())
+	{
+		for (int i = 0; i < moves.size(); i++)
+		{
+			if (!matches(moves[i]))
+				continue;
+			if (match != nullptr)
+			{
+				match = nullptr;
+				break;
+			}
+			match = &moves[i];
+		}
+		if (match != nullptr)
+			return *match;
+	}
 
-		if (!vIsLegalMove(move))
+	// Loop through all legal moves to find a move that matches
+	// the data we got from the move string.
+	for (int i = 0; i < moves.size(); i++)
+	{
+		const Move& move = moves[i];
+		if (!matches(move) || !vIsLegalMove(move))
 			continue;
 
 		// Return an empty move if there are multiple moves that
@@ -996,7 +1088,8 @@ void WesternBoard::vUndoMove(const Move& move)
 		m_history.pop_back();
 		return;
 	}
-	else if (target == m_kingSquare[side])
+	else if (target == m_kingSquare[side]
+	     &&  pieceAt(target).type() == King)
 	{
 		m_kingSquare[side] = source;
 	}
@@ -1024,12 +1117,34 @@ void WesternBoard::vUndoMove(const Move& move)
 	m_history.pop_back();
 }
 
-void WesternBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
+void WesternBoard::vRestore(const Board& other)
+{
+	Board::vRestore(other);
+
+	const WesternBoard& board = static_cast<const WesternBoard&>(other);
+	m_sign = board.m_sign;
+	m_kingSquare[Side::White] = board.m_kingSquare[Side::White];
+	m_kingSquare[Side::Black] = board.m_kingSquare[Side::Black];
+	m_enpassantSquare = board.m_enpassantSquare;
+	m_enpassantTarget = board.m_enpassantTarget;
+	m_reversibleMoveCount = board.m_reversibleMoveCount;
+	m_history = board.m_history;
+	m_castlingRights = board.m_castlingRights;
+	for (int side = 0; side < 2; side++)
+	{
+		m_castleTarget[side][QueenSide] = board.m_castleTarget[side][QueenSide];
+		m_castleTarget[side][KingSide] = board.m_castleTarget[side][KingSide];
+	}
+}
+
+void WesternBoard::generateMovesForPiece(MoveList& moves,
 					 int pieceType,
 					 int square) const
 {
 	if (pieceType == Pawn)
 		return generatePawnMoves(square, moves);
+	if (hasBitboards())
+		return generateBitboardMoves(pieceType, square, moves);
 	if (pieceType == King)
 	{
 		generateHoppingMoves(square, m_bishopOffsets, moves);
@@ -1046,18 +1161,48 @@ void WesternBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
 		generateSlidingMoves(square, m_rookOffsets, moves);
 }
 
-bool WesternBoard::inCheck(Side side, int square) const
+void WesternBoard::generateBitboardMoves(int pieceType,
+					 int square,
+					 MoveList& moves) const
 {
-	Side opSide = side.opposite();
-	if (square == 0)
+	int bit = Bitboards::bitIndex(square);
+	Bitboard targets = 0;
+
+	if (pieceType == King)
+		targets = Bitboards::kingAttacks(bit);
+	else
 	{
-		square = m_kingSquare[side];
-		// In the "horde" variant the horde side has no king
-		if (square == 0)
-			return false;
+		if (pieceHasMovement(pieceType, KnightMovement))
+			targets |= Bitboards::knightAttacks(bit);
+		if (pieceHasMovement(pieceType, BishopMovement))
+			targets |= Bitboards::bishopAttacks(bit, occupiedBitboard());
+		if (pieceHasMovement(pieceType, RookMovement))
+			targets |= Bitboards::rookAttacks(bit, occupiedBitboard());
 	}
 
-	// Pawn attacks
+	targets &= ~sideBitboard(sideToMove());
+	while (targets != 0)
+	{
+		int target = Bitboards::squareIndex(Bitboards::popLsb(targets));
+		moves.append(Move(square, target));
+	}
+
+	if (pieceType == King)
+		generateCastlingMoves(moves);
+}
+
+Bitboard WesternBoard::typesBitboard(Side side,
+				     const QVarLengthArray<int, 8>& types) const
+{
+	Bitboard b = 0;
+	for (int type: types)
+		b |= pieceBitboard(side, type);
+	return b;
+}
+
+bool WesternBoard::pawnAttacks(Side side, int square) const
+{
+	Piece opPawn(side.opposite(), Pawn);
 	int sign = (side == Side::White) ? 1 : -1;
 
 	for (const PawnStep& pStep: m_pawnSteps)
@@ -1065,11 +1210,205 @@ bool WesternBoard::inCheck(Side side, int square) const
 		if (pStep.type == CaptureStep)
 		{
 			int fromSquare = square - pawnPushOffset(pStep, -sign);
-			if (pieceAt(fromSquare) == Piece(opSide, Pawn))
+			if (pieceAt(fromSquare) == opPawn)
 				return true;
 		}
 	}
 
+	return false;
+}
+
+WesternBoard::AttackSets WesternBoard::attackSets(Side side) const
+{
+	AttackSets sets;
+	sets.pawns = pieceBitboard(side, Pawn);
+	sets.kings = m_kingCanCapture ? pieceBitboard(side, King) : 0;
+	sets.knights = typesBitboard(side, m_knightTypes);
+	sets.bishops = typesBitboard(side, m_bishopTypes);
+	sets.rooks = typesBitboard(side, m_rookTypes);
+	return sets;
+}
+
+Bitboard WesternBoard::attackers(Side side,
+				 int square,
+				 Bitboard occupied,
+				 const AttackSets& opSets) const
+{
+	int bit = Bitboards::bitIndex(square);
+	Bitboard attackers = 0;
+
+	if (m_diagonalPawnCaptures)
+		attackers |= Bitboards::pawnAttacks(side, bit) & opSets.pawns;
+	else
+	{
+		Piece opPawn(side.opposite(), Pawn);
+		int sign = (side == Side::White) ? 1 : -1;
+		for (const PawnStep& pStep: m_pawnSteps)
+		{
+			if (pStep.type != CaptureStep)
+				continue;
+			int fromSquare = square - pawnPushOffset(pStep, -sign);
+			if (pieceAt(fromSquare) == opPawn)
+				attackers |= Bitboards::bit(Bitboards::bitIndex(fromSquare));
+		}
+	}
+
+	attackers |= Bitboards::kingAttacks(bit) & opSets.kings;
+	attackers |= Bitboards::knightAttacks(bit) & opSets.knights;
+	attackers |= Bitboards::bishopAttacks(bit, occupied) & opSets.bishops;
+	attackers |= Bitboards::rookAttacks(bit, occupied) & opSets.rooks;
+
+	return attackers;
+}
+
+Bitboard WesternBoard::pinnedPieces(Side side,
+				    int kingBit,
+				    const AttackSets& opSets) const
+{
+	Bitboard occupied = occupiedBitboard();
+	Bitboard pinned = 0;
+
+	// Opposing sliders that would attack the king if there
+	// was only one piece in between
+	Bitboard snipers =
+		(Bitboards::bishopAttacks(kingBit, 0) & opSets.bishops)
+		| (Bitboards::rookAttacks(kingBit, 0) & opSets.rooks);
+
+	while (snipers != 0)
+	{
+		int sniper = Bitboards::popLsb(snipers);
+		Bitboard blockers = Bitboards::between(kingBit, sniper) & occupied;
+		if (blockers != 0 && (blockers & (blockers - 1)) == 0)
+			pinned |= blockers & sideBitboard(side);
+	}
+
+	return pinned;
+}
+
+bool WesternBoard::sameTypeAttackers(int source,
+				     int target,
+				     Bitboard* rivals) const
+{
+	Piece piece = pieceAt(source);
+	Side side = piece.side();
+	int kingSq = m_kingSquare[side];
+	if (!m_hasLegalMoveGenerator || !hasBitboards()
+	||  kingSq == 0 || piece.type() == King)
+		return false;
+
+	// Knight, bishop and rook movements are symmetric, so the
+	// pieces that attack the target are the ones that can move there
+	int targetBit = Bitboards::bitIndex(target);
+	Bitboard occupied = occupiedBitboard();
+	Bitboard attacks = 0;
+	if (pieceHasMovement(piece.type(), KnightMovement))
+		attacks |= Bitboards::knightAttacks(targetBit);
+	if (pieceHasMovement(piece.type(), BishopMovement))
+		attacks |= Bitboards::bishopAttacks(targetBit, occupied);
+	if (pieceHasMovement(piece.type(), RookMovement))
+		attacks |= Bitboards::rookAttacks(targetBit, occupied);
+
+	Bitboard candidates = attacks & pieceBitboard(side, piece.type())
+			      & ~Bitboards::bit(Bitboards::bitIndex(source));
+	*rivals = candidates;
+	if (candidates == 0)
+		return true;
+
+	// Another piece that moves to the same square blocks or captures
+	// a checker just like the legal move itself, so only the pins
+	// can make it illegal
+	int kingBit = Bitboards::bitIndex(kingSq);
+	Bitboard pinned = candidates
+			  & pinnedPieces(side, kingBit, attackSets(side.opposite()));
+	while (pinned != 0)
+	{
+		int bit = Bitboards::popLsb(pinned);
+		if ((Bitboards::line(kingBit, bit) & Bitboards::bit(targetBit)) == 0)
+			*rivals &= ~Bitboards::bit(bit);
+	}
+
+	return true;
+}
+
+bool WesternBoard::givesCheck(const Move& move, bool* check) const
+{
+	Side side = sideToMove();
+	Side opSide = side.opposite();
+	int source = move.sourceSquare();
+	int target = move.targetSquare();
+	int opKingSq = m_kingSquare[opSide];
+	if (!m_hasLegalMoveGenerator || !hasBitboards()
+	||  !m_diagonalPawnCaptures || opKingSq == 0)
+		return false;
+
+	int type = move.promotion();
+	if (source != 0)
+	{
+		if (type == Piece::NoPiece)
+			type = pieceAt(source).type();
+		// Castling moves two pieces and en-passant captures
+		// remove a piece from another square
+		if (source == m_kingSquare[side]
+		&&  castlingSide(move) != NoCastlingSide)
+			return false;
+		if (type == Pawn && target == m_enpassantSquare)
+			return false;
+	}
+
+	Bitboard sourceBb = source ? Bitboards::bit(Bitboards::bitIndex(source)) : 0;
+	Bitboard targetBb = Bitboards::bit(Bitboards::bitIndex(target));
+	Bitboard occupied = (occupiedBitboard() & ~sourceBb) | targetBb;
+
+	// The attack sets after the move, with the moved piece on the
+	// target square attacking with its new type
+	AttackSets sets = attackSets(side);
+	sets.pawns &= ~sourceBb;
+	sets.kings &= ~sourceBb;
+	sets.knights &= ~sourceBb;
+	sets.bishops &= ~sourceBb;
+	sets.rooks &= ~sourceBb;
+	if (type == Pawn)
+		sets.pawns |= targetBb;
+	else if (type == King)
+	{
+		if (m_kingCanCapture)
+			sets.kings |= targetBb;
+	}
+	else
+	{
+		if (pieceHasMovement(type, KnightMovement))
+			sets.knights |= targetBb;
+		if (pieceHasMovement(type, BishopMovement))
+			sets.bishops |= targetBb;
+		if (pieceHasMovement(type, RookMovement))
+			sets.rooks |= targetBb;
+	}
+
+	*check = attackers(opSide, opKingSq, occupied, sets) != 0;
+	return true;
+}
+
+bool WesternBoard::inCheck(Side side, int square) const
+{
+	Side opSide = side.opposite();
+	if (square == 0)
+	{
+		square = m_kingSquare[side];
+		// In the "horde" variant the horde side has no king
+		if (square == 0)
+			return false;
+	}
+
+	if (hasBitboards())
+	{
+		return attackers(side, square, occupiedBitboard(),
+				 attackSets(opSide)) != 0;
+	}
+
+	// Pawn attacks
+	if (pawnAttacks(side, square))
+		return true;
+
 	Piece opKing(opSide, King);
 	Piece piece;
 	
@@ -1127,6 +1466,11 @@ bool WesternBoard::inCheck(Side side, int square) const
 	return false;
 }
 
+Bitboard WesternBoard::dropTargets() const
+{
+	return ~occupiedBitboard() & m_dropMask;
+}
+
 bool WesternBoard::isLegalPosition()
 {
 	Side side = sideToMove().opposite();
@@ -1187,9 +1531,215 @@ bool WesternBoard::vIsLegalMove(const Move& move)
 	return Board::vIsLegalMove(move);
 }
 
+bool WesternBoard::generateLegalMoves(MoveList& moves, bool firstOnly)
+{
+	Side side = sideToMove();
+	int kingSq = m_kingSquare[side];
+	if (!m_hasLegalMoveGenerator || kingSq == 0)
+		return false;
+	if (!hasBitboards())
+		return generateMailboxLegalMoves(moves);
+
+	int kingBit = Bitboards::bitIndex(kingSq);
+	Bitboard occupied = occupiedBitboard();
+	// The attacking pieces are collected only once because the king
+	// moves test every target square against them
+	Side opSide = side.opposite();
+	AttackSets opSets = attackSets(opSide);
+	Bitboard checkers = attackers(side, kingSq, occupied, opSets);
+	Bitboard pinned = pinnedPieces(side, kingBit, opSets);
+
+	// The squares where a piece other than the king can move to:
+	// anywhere if not in check, the checker or the squares between
+	// it and the king if in single check, none if in double check.
+	Bitboard evasions = ~Bitboard(0);
+	if (checkers != 0)
+	{
+		if (Bitboards::popCount(checkers) > 1)
+			evasions = 0;
+		else
+			evasions = checkers
+				 | Bitboards::between(kingBit, Bitboards::lsb(checkers));
+	}
+
+	auto isLegal = [&](const Move& move)
+	{
+		int source = move.sourceSquare();
+		int target = move.targetSquare();
+
+		if (source == kingSq)
+		{
+			// Castling needs to check the squares the king passes
+			// through, so let vIsLegalMove() deal with it
+			if (castlingSide(move) != NoCastlingSide)
+				return checkers == 0 && vIsLegalMove(move);
+
+			Bitboard occ = occupied & ~Bitboards::bit(kingBit);
+			return (m_kingCanCapture
+				|| pieceAt(target).side() != opSide)
+			    && attackers(side, target, occ, opSets) == 0;
+		}
+		// An en-passant capture removes two pieces from a line, which
+		// the pins don't account for
+		if (source != 0
+		&&  target == m_enpassantSquare
+		&&  pieceAt(source).type() == Pawn)
+			return vIsLegalMove(move);
+
+		Bitboard targetBb = Bitboards::bit(Bitboards::bitIndex(target));
+		if ((evasions & targetBb) == 0)
+			return false;
+		if (source != 0)
+		{
+			int sourceBit = Bitboards::bitIndex(source);
+			if (pinned & Bitboards::bit(sourceBit))
+				return (Bitboards::line(kingBit, sourceBit)
+					& targetBb) != 0;
+		}
+		return true;
+	};
+	auto addLegalMoves = [&](const MoveList& pseudoMoves)
+	{
+		for (int i = 0; i < pseudoMoves.size(); i++)
+		{
+			if (isLegal(pseudoMoves[i]))
+			{
+				moves.append(pseudoMoves[i]);
+				if (firstOnly)
+					return;
+			}
+		}
+	};
+
+	// Drops that don't block a check aren't generated at all
+	MoveList pseudoMoves;
+	m_dropMask = evasions;
+	if (!firstOnly)
+	{
+		generateMoves(pseudoMoves);
+		addLegalMoves(pseudoMoves);
+	}
+	else
+	{
+		// One piece at a time, starting with the king, which is
+		// the only piece that can move in double check
+		Bitboard pieces = sideBitboard(side) & ~Bitboards::bit(kingBit);
+		int square = kingSq;
+		while (moves.isEmpty())
+		{
+			pseudoMoves.clear();
+			generateMovesForPiece(pseudoMoves, pieceAt(square).type(), square);
+			addLegalMoves(pseudoMoves);
+			if (pieces == 0)
+				break;
+			square = Bitboards::squareIndex(Bitboards::popLsb(pieces));
+		}
+		if (moves.isEmpty())
+		{
+			pseudoMoves.clear();
+			generateDropMoves(pseudoMoves, Piece::NoPiece);
+			addLegalMoves(pseudoMoves);
+		}
+	}
+	m_dropMask = ~Bitboard(0);
+
+	return true;
+}
+
+bool WesternBoard::generateMailboxLegalMoves(MoveList& moves)
+{
+	Side side = sideToMove();
+	// Check evasions are rare enough to be tested by making the moves
+	if (inCheck(side))
+		return false;
+
+	int kingSq = m_kingSquare[side];
+	Side opSide = side.opposite();
+
+	// Find the pinned pieces and the directions of their pins. Only
+	// one piece can be pinned in each direction from the king.
+	int pinSquares[8];
+	int pinOffsets[8];
+	int pinCount = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		const auto& offsets = (i == 0) ? m_bishopOffsets : m_rookOffsets;
+		unsigned movement = (i == 0) ? BishopMovement : RookMovement;
+
+		for (int offset : offsets)
+		{
+			int square = kingSq + offset;
+			while (pieceAt(square).isEmpty())
+				square += offset;
+			if (pieceAt(square).side() != side)
+				continue;
+
+			int pinSquare = square;
+			square += offset;
+			while (pieceAt(square).isEmpty())
+				square += offset;
+
+			Piece piece = pieceAt(square);
+			if (piece.side() == opSide
+			&&  pieceHasMovement(piece.type(), movement))
+			{
+				pinSquares[pinCount] = pinSquare;
+				pinOffsets[pinCount] = offset;
+				pinCount++;
+			}
+		}
+	}
+
+	MoveList pseudoMoves;
+	generateMoves(pseudoMoves);
+
+	for (int i = 0; i < pseudoMoves.size(); i++)
+	{
+		const Move& move = pseudoMoves[i];
+		int source = move.sourceSquare();
+		int target = move.targetSquare();
+		bool isLegal = true;
+
+		// King moves and en-passant captures can't be judged from
+		// the pins, so let vIsLegalMove() deal with them
+		if (source == kingSq
+		||  (source != 0
+		&&   target == m_enpassantSquare
+		&&   pieceAt(source).type() == Pawn))
+			isLegal = vIsLegalMove(move);
+		else
+		{
+			for (int j = 0; j < pinCount; j++)
+			{
+				if (pinSquares[j] != source)
+					continue;
+
+				// A pinned piece can only move along the pin
+				int offset = pinOffsets[j];
+				isLegal = false;
+				for (int sq = kingSq + offset;
+				     !pieceAt(sq).isWall(); sq += offset)
+				{
+					if (sq == target)
+					{
+						isLegal = true;
+						break;
+					}
+				}
+				break;
+			}
+		}
+
+		if (isLegal)
+			moves.append(move);
+	}
+
+	return true;
+}
+
 void WesternBoard::addPromotions(int sourceSquare,
 				 int targetSquare,
-				 QVarLengthArray<Move>& moves) const
+				 MoveList& moves) const
 {
 	moves.append(Move(sourceSquare, targetSquare, Knight));
 	moves.append(Move(sourceSquare, targetSquare, Bishop));
@@ -1198,7 +1748,7 @@ void WesternBoard::addPromotions(int sourceSquare,
 }
 
 void WesternBoard::generatePawnMoves(int sourceSquare,
-				     QVarLengthArray<Move>& moves) const
+				     MoveList& moves) const
 {
 	int targetSquare;
 	Piece capture;
@@ -1293,7 +1843,7 @@ bool WesternBoard::canCastle(CastlingSide castlingSide) const
 	return true;
 }
 
-void WesternBoard::generateCastlingMoves(QVarLengthArray<Move>& moves) const
+void WesternBoard::generateCastlingMoves(MoveList& moves) const
 {
 	Side side = sideToMove();
 	int source = m_kingSquare[side];
@@ -1350,35 +1900,25 @@ Result WesternBoard::result()
 	}
 
 	// Insufficient mating material
-	int material = 0;
-	bool bishops[] = { false, false };
-	for (int i = 0; i < arraySize(); i++)
+	int knights = pieceCount(Side::NoSide, Knight);
+	int bishops = pieceCount(Side::NoSide, Bishop);
+	int others = pieceCount() - pieceCount(Side::NoSide, King)
+		   - knights - bishops;
+	int material = others * 2 + knights + bishops;
+
+	// Bishops on squares of the same color count as one piece
+	if (others == 0 && knights < 2 && bishops > 0 && material > 1)
 	{
-		const Piece& piece = pieceAt(i);
-		if (!piece.isValid())
-			continue;
-
-		switch (piece.type())
-		{
-		case King:
-			break;
-		case Bishop:
+		bool colors[] = { false, false };
+		for (int i = 0; i < arraySize(); i++)
 		{
+			if (pieceAt(i).type() != Bishop)
+				continue;
 			auto color = chessSquare(i).color();
-			if (color != Square::NoColor && !bishops[color])
-			{
-				material++;
-				bishops[color] = true;
-			}
-			break;
-		}
-		case Knight:
-			material++;
-			break;
-		default:
-			material += 2;
-			break;
+			if (color != Square::NoColor)
+				colors[color] = true;
 		}
+		material = knights + colors[0] + colors[1];
 	}
 	if (material <= 1)
 	{
@@ -142,6 +142,20 @@ class LIB_EXPORT WesternBoard : public Board
 		 * \sa SeirawanBoard
 		 */
 		virtual bool variantHasChanneling(Side side, int square) const;
+		/*!
+		 * Returns true if the legal moves can be generated from the
+		 * checking and pinned pieces, without making each move.
+		 *
+		 * This requires the standard check rules: a move is legal
+		 * if it doesn't leave the king in check, and moving a piece
+		 * doesn't change the other pieces on the board, and the
+		 * pieces can only have knight, bishop and rook movements.
+		 * Boards without bitboards find the pins by scanning the
+		 * mailbox from the king. The default value is false.
+		 *
+		 * \sa variantHasBitboards()
+		 */
+		virtual bool variantHasLegalMoveGenerator() const;
 		/*!
 		 * Adds pawn promotions to a move list.
 		 *
@@ -152,7 +166,7 @@ class LIB_EXPORT WesternBoard : public Board
 		 */
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
-					   QVarLengthArray<Move>& moves) const;
+					   MoveList& moves) const;
 		/*! Returns the king square of \a side. */
 		int kingSquare(Side side) const;
 		/*! Returns the current en-passant square. */
@@ -188,6 +202,14 @@ class LIB_EXPORT WesternBoard : public Board
 		 * If \a square is 0, then the king square is used.
 		 */
 		virtual bool inCheck(Side side, int square = 0) const;
+		/*!
+		 * Returns the empty squares where a piece can be dropped.
+		 *
+		 * When the side to move is in check, the legal move generator
+		 * limits these to the squares between the checker and the
+		 * king, and to none in double check. Requires bitboards.
+		 */
+		Bitboard dropTargets() const;
 
 		/*!
 		 * Returns FEN extensions. The default is an empty string.
@@ -209,10 +231,12 @@ class LIB_EXPORT WesternBoard : public Board
 		virtual void vMakeMove(const Move& move,
 				       BoardTransition* transition);
 		virtual void vUndoMove(const Move& move);
-		virtual void generateMovesForPiece(QVarLengthArray<Move>& moves,
+		virtual void vRestore(const Board& other);
+		virtual void generateMovesForPiece(MoveList& moves,
 						   int pieceType,
 						   int square) const;
 		virtual bool vIsLegalMove(const Move& move);
+		virtual bool generateLegalMoves(MoveList& moves, bool firstOnly);
 		virtual bool isLegalPosition();
 		virtual int captureType(const Move& move) const;
 
@@ -235,9 +259,48 @@ class LIB_EXPORT WesternBoard : public Board
 			int reversibleMoveCount;
 		};
 
-		void generateCastlingMoves(QVarLengthArray<Move>& moves) const;
+		// The pieces of one side grouped by the way they attack
+		struct AttackSets
+		{
+			Bitboard pawns;
+			Bitboard kings;
+			Bitboard knights;
+			Bitboard bishops;
+			Bitboard rooks;
+		};
+
+		// Returns the square denoted by the two characters at 'str'
+		// in a SAN string, without making a temporary string
+		Square sanSquare(const QChar* str) const;
+		void generateCastlingMoves(MoveList& moves) const;
+		void generateBitboardMoves(int pieceType,
+					   int square,
+					   MoveList& moves) const;
+		Bitboard typesBitboard(Side side,
+				       const QVarLengthArray<int, 8>& types) const;
+		bool pawnAttacks(Side side, int square) const;
+		AttackSets attackSets(Side side) const;
+		Bitboard attackers(Side side,
+				   int square,
+				   Bitboard occupied,
+				   const AttackSets& opSets) const;
+		Bitboard pinnedPieces(Side side,
+				      int kingBit,
+				      const AttackSets& opSets) const;
+		// Finds the other pieces of the same type as the one on
+		// 'source' that can legally move to 'target' of a legal move,
+		// from the attack tables. Returns false if the board can't
+		// find them without generating the moves.
+		bool sameTypeAttackers(int source,
+				       int target,
+				       Bitboard* rivals) const;
+		// Tells in 'check' whether 'move' would check the opponent,
+		// from the attack tables. Returns false if the board can't
+		// tell without making the move.
+		bool givesCheck(const Move& move, bool* check) const;
+		bool generateMailboxLegalMoves(MoveList& moves);
 		void generatePawnMoves(int sourceSquare,
-				       QVarLengthArray<Move>& moves) const;
+				       MoveList& moves) const;
 
 		bool canCastle(CastlingSide castlingSide) const;
 		QString castlingRightsString(FenNotation notation) const;
@@ -263,6 +326,9 @@ class LIB_EXPORT WesternBoard : public Board
 		bool m_pawnHasDoubleStep;
 		bool m_hasEnPassantCaptures;
 		bool m_pawnAmbiguous;
+		bool m_diagonalPawnCaptures;
+		bool m_hasLegalMoveGenerator;
+		Bitboard m_dropMask;
 		QVector<MoveData> m_history;
 		CastlingRights m_castlingRights;
 		int m_castleTarget[2][2];
@@ -271,6 +337,11 @@ class LIB_EXPORT WesternBoard : public Board
 		QVarLengthArray<int> m_knightOffsets;
 		QVarLengthArray<int> m_bishopOffsets;
 		QVarLengthArray<int> m_rookOffsets;
+
+		// Piece types that have knight, bishop and rook movement
+		QVarLengthArray<int, 8> m_knightTypes;
+		QVarLengthArray<int, 8> m_bishopTypes;
+		QVarLengthArray<int, 8> m_rookTypes;
 };
 
 
@@ -16,46 +16,80 @@
 */
 
 #include "zobrist.h"
-#include <QVarLengthArray>
-#include <QMutex>
-#include <QMutexLocker>
 #include "piece.h"
 
 namespace {
 
-QVarLengthArray<quint64, 0x2000> s_keys;
-QMutex s_mutex;
+/*
+ * The zobrist keys are generated at compile time with the "minimal
+ * standard" random number generator by Park and Miller, starting
+ * from seed 1. The n-th number of the sequence is 16807^n modulo
+ * 2^31 - 1, so the keys are the same in every process and no
+ * locking is needed to use them.
+ */
+const int s_keyCount = 0x2000;
+constexpr quint64 s_a = 16807;
+constexpr quint64 s_m = 2147483647;
 
-} // anonymous namespace
+constexpr quint64 powMod(quint64 base, int exp)
+{
+	return exp == 0 ? 1
+	     : powMod(base * base % s_m, exp / 2) * (exp % 2 ? base : 1) % s_m;
+}
 
-namespace Chess {
+constexpr quint64 nextRandom(quint64 random)
+{
+	return random * s_a % s_m;
+}
 
-int Zobrist::s_randomSeed = 1;
+// Combines three successive 31-bit random numbers into a key
+constexpr quint64 combine(quint64 random)
+{
+	return random
+	     ^ (nextRandom(random) << 31)
+	     ^ (nextRandom(nextRandom(random)) << 62);
+}
 
-/*!
- * The "minimal standard" random number generator
- * by Park and Miller.
- * Returns a pseudo-random integer between 1 and 2147483646.
- */
-int Zobrist::random32()
+constexpr quint64 keyAt(int index)
 {
-	const int a = 16807;
-	const int m = 2147483647;
-	const int q = (m / a);
-	const int r = (m % a);
+	return combine(powMod(s_a, 3 * index + 1));
+}
 
-	int hi = s_randomSeed / q;
-	int lo = s_randomSeed % q;
-	int test = a * lo - r * hi;
+template<int... I> struct Indices {};
 
-	if (test > 0)
-		s_randomSeed = test;
-	else
-		s_randomSeed = test + m;
+template<typename A, typename B> struct ConcatIndices;
+template<int... I, int... J>
+struct ConcatIndices<Indices<I...>, Indices<J...>>
+{
+	typedef Indices<I..., (int(sizeof...(I)) + J)...> Type;
+};
 
-	return s_randomSeed;
+template<int N> struct MakeIndices
+{
+	typedef typename ConcatIndices<
+		typename MakeIndices<N / 2>::Type,
+		typename MakeIndices<N - N / 2>::Type>::Type Type;
+};
+template<> struct MakeIndices<0> { typedef Indices<> Type; };
+template<> struct MakeIndices<1> { typedef Indices<0> Type; };
+
+struct KeyTable
+{
+	quint64 keys[s_keyCount];
+};
+
+template<int... I>
+constexpr KeyTable makeKeyTable(Indices<I...>)
+{
+	return KeyTable{{ keyAt(I)... }};
 }
 
+alignas(64) constexpr KeyTable s_keys =
+	makeKeyTable(MakeIndices<s_keyCount>::Type());
+
+} // anonymous namespace
+
+namespace Chess {
 
 Zobrist::Zobrist(const quint64* keys)
 	: m_initialized(false),
@@ -76,24 +110,13 @@ void Zobrist::initialize(int squareCount,
 	Q_ASSERT(squareCount > 0);
 	Q_ASSERT(pieceTypeCount > 1);
 
-	QMutexLocker locker(&s_mutex);
-
 	if (m_initialized)
 		return;
 
 	m_squareCount = squareCount;
 	m_pieceTypeCount = pieceTypeCount;
-
 	if (m_keys == nullptr)
-	{
-		// Initialize the global zobrist array
-		if (s_keys.isEmpty())
-		{
-			for (int i = 0; i < s_keys.capacity(); i++)
-				s_keys.append(random64());
-		}
-		m_keys = s_keys.constData();
-	}
+		m_keys = s_keys.keys;
 	m_initialized = true;
 }
 
@@ -122,13 +145,4 @@ quint64 Zobrist::reservePiece(const Piece& piece, int slot) const
 	return this->piece(piece, slot);
 }
 
-quint64 Zobrist::random64()
-{
-	quint64 random1 = (quint64)random32();
-	quint64 random2 = (quint64)random32();
-	quint64 random3 = (quint64)random32();
-
-	return random1 ^ (random2 << 31) ^ (random3 << 62);
-}
-
 } // namespace Chess
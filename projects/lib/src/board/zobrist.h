@@ -39,7 +39,7 @@ class LIB_EXPORT Zobrist
 		 * Creates a new uninitialized Zobrist object.
 		 *
 		 * \param keys An array of zobrist keys that can be used
-		 * instead of the random numbers generated by the Zobrist
+		 * instead of the pseudo-random keys built into the Zobrist
 		 * class.
 		 */
 		Zobrist(const quint64* keys = nullptr);
@@ -91,13 +91,7 @@ class LIB_EXPORT Zobrist
 		/*! Returns the array of zobrist keys. */
 		const quint64* keys() const;
 
-		/*! Returns an unsigned 64-bit pseudo-random number. */
-		static quint64 random64();
-
 	private:
-		static int random32();
-		static int s_randomSeed;
-
 		bool m_initialized;
 		int m_squareCount;
 		int m_pieceTypeCount;
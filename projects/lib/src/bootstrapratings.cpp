@@ -0,0 +1,276 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bootstrapratings.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include "ratingsolver.h"
+
+namespace {
+
+// Resamples per task and random number stream
+const int BatchSize = 32;
+
+class BootstrapTask : public QRunnable
+{
+	public:
+		explicit BootstrapTask(const std::function<void()>& function)
+			: m_function(function)
+		{
+		}
+
+		virtual void run()
+		{
+			m_function();
+		}
+
+	private:
+		std::function<void()> m_function;
+};
+
+// A kind of unit: the players, the number of games and the
+// first player's total score
+struct UnitKind
+{
+	int player;
+	int opponent;
+	int games;
+	int points;
+	int count;
+};
+
+} // anonymous namespace
+
+BootstrapRatings::BootstrapRatings(int playerCount)
+	: m_playerCount(0),
+	  m_unitSize(1),
+	  m_gameCount(0),
+	  m_sampleCount(0)
+{
+	reset(playerCount);
+}
+
+int BootstrapRatings::playerCount() const
+{
+	return m_playerCount;
+}
+
+void BootstrapRatings::reset(int playerCount, int unitSize)
+{
+	Q_ASSERT(playerCount >= 0);
+	Q_ASSERT(unitSize >= 1);
+
+	m_playerCount = playerCount;
+	m_unitSize = unitSize;
+	m_gameCount = 0;
+	m_sampleCount = 0;
+	m_counts.clear();
+	m_pending.clear();
+	m_samples.clear();
+	m_validSamples.fill(0, playerCount);
+}
+
+void BootstrapRatings::addUnit(QHash<quint64, int>& counts,
+			       const Unit& unit) const
+{
+	const quint64 pair = quint64(unit.player) * m_playerCount
+			     + unit.opponent;
+	counts[(pair << 24) | (quint64(unit.games) << 12) | unit.points]++;
+}
+
+void BootstrapRatings::addGame(int unit, int player, int opponent,
+			       int points)
+{
+	Q_ASSERT(player >= 0 && player < m_playerCount);
+	Q_ASSERT(opponent >= 0 && opponent < m_playerCount);
+	Q_ASSERT(player != opponent);
+	Q_ASSERT(points >= 0 && points <= 2);
+
+	// Units are stored from the view of the lower player index
+	if (player > opponent)
+	{
+		std::swap(player, opponent);
+		points = 2 - points;
+	}
+	m_gameCount++;
+
+	if (m_unitSize == 1)
+	{
+		addUnit(m_counts, Unit{ player, opponent, 1, points });
+		return;
+	}
+
+	auto it = m_pending.find(unit);
+	if (it != m_pending.end()
+	&&  (it->player != player || it->opponent != opponent))
+	{
+		addUnit(m_counts, it.value());
+		m_pending.erase(it);
+		it = m_pending.end();
+	}
+	if (it == m_pending.end())
+		it = m_pending.insert(unit, Unit{ player, opponent, 0, 0 });
+
+	it->games++;
+	it->points += points;
+	if (it->games >= m_unitSize)
+	{
+		addUnit(m_counts, it.value());
+		m_pending.erase(it);
+	}
+}
+
+int BootstrapRatings::gameCount() const
+{
+	return m_gameCount;
+}
+
+bool BootstrapRatings::run(int sampleCount, quint32 seed)
+{
+	Q_ASSERT(sampleCount > 0);
+
+	QHash<quint64, int> counts(m_counts);
+	for (const Unit& unit : m_pending)
+		addUnit(counts, unit);
+
+	QVector<UnitKind> kinds;
+	int unitCount = 0;
+	for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+	{
+		const quint64 pair = it.key() >> 24;
+		UnitKind kind;
+		kind.player = int(pair / m_playerCount);
+		kind.opponent = int(pair % m_playerCount);
+		kind.games = int((it.key() >> 12) & 0xFFF);
+		kind.points = int(it.key() & 0xFFF);
+		kind.count = it.value();
+		kinds.append(kind);
+		unitCount += kind.count;
+	}
+	m_sampleCount = 0;
+	m_validSamples.fill(0, m_playerCount);
+	if (unitCount == 0)
+		return false;
+
+	const int playerCount = m_playerCount;
+	m_samples.fill(std::numeric_limits<double>::quiet_NaN(),
+		       playerCount * sampleCount);
+	// Every resample writes its own elements, so the tasks don't
+	// need to be synchronized
+	double* samples = m_samples.data();
+
+	auto resample = [=, &kinds](int batch)
+	{
+		std::seed_seq seq{ seed, quint32(batch) };
+		std::mt19937 rng(seq);
+		RatingSolver solver(playerCount);
+
+		const int first = batch * BatchSize;
+		const int last = qMin(first + BatchSize, sampleCount);
+		for (int sample = first; sample < last; sample++)
+		{
+			// A multinomial draw of all units, one kind at a time
+			solver.clearGames();
+			int remaining = unitCount;
+			int remainingWeight = unitCount;
+			for (const UnitKind& kind : kinds)
+			{
+				if (remaining == 0)
+					break;
+
+				int count = remaining;
+				if (kind.count < remainingWeight)
+				{
+					std::binomial_distribution<int> dist(remaining,
+						double(kind.count) / remainingWeight);
+					count = dist(rng);
+				}
+				remaining -= count;
+				remainingWeight -= kind.count;
+				if (count > 0)
+					solver.addGames(kind.player, kind.opponent,
+							count * kind.games,
+							count * kind.points);
+			}
+			solver.solve();
+
+			if (playerCount == 2)
+			{
+				if (solver.games(0) == 0)
+					continue;
+				const double diff = solver.rating(0) - solver.rating(1);
+				samples[sample] = diff;
+				samples[sampleCount + sample] = -diff;
+				continue;
+			}
+			for (int i = 0; i < playerCount; i++)
+			{
+				if (solver.games(i) > 0)
+					samples[i * sampleCount + sample] = solver.rating(i);
+			}
+		}
+	};
+
+	const int batchCount = (sampleCount + BatchSize - 1) / BatchSize;
+	if (batchCount > 1)
+	{
+		QThreadPool pool;
+		pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(),
+					      batchCount));
+		for (int batch = 0; batch < batchCount; batch++)
+			pool.start(new BootstrapTask([=]() { resample(batch); }));
+		pool.waitForDone();
+	}
+	else
+		resample(0);
+
+	for (int i = 0; i < playerCount; i++)
+	{
+		double* begin = samples + i * sampleCount;
+		double* end = std::partition(begin, begin + sampleCount,
+			[](double value) { return !std::isnan(value); });
+		std::sort(begin, end);
+		m_validSamples[i] = int(end - begin);
+	}
+	m_sampleCount = sampleCount;
+
+	return true;
+}
+
+int BootstrapRatings::sampleCount() const
+{
+	return m_sampleCount;
+}
+
+double BootstrapRatings::percentile(int player, double percentile) const
+{
+	Q_ASSERT(player >= 0 && player < m_playerCount);
+
+	const int count = m_validSamples.at(player);
+	if (count == 0)
+		return std::numeric_limits<double>::quiet_NaN();
+
+	// Nearest-rank percentile
+	const int rank = int(std::ceil(percentile / 100.0 * count));
+	return m_samples.at(player * m_sampleCount + qBound(1, rank, count) - 1);
+}
@@ -0,0 +1,112 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOTSTRAPRATINGS_H
+#define BOOTSTRAPRATINGS_H
+
+#include <QHash>
+#include <QVector>
+
+/*!
+ * \brief Bootstrap confidence intervals of tournament ratings
+ *
+ * The error margins of Elo and RatingSolver assume that every game
+ * is independent. The games that repeat an opening with the colors
+ * reversed are correlated, so BootstrapRatings resamples whole units
+ * of such games instead: each resample draws as many units as were
+ * played, with replacement, and fits the ratings to them with a
+ * RatingSolver. The percentiles of the fitted ratings give the
+ * confidence intervals.
+ *
+ * Units with the same players and the same total score are
+ * interchangeable, so a resample only needs one multinomial draw over
+ * the distinct kinds of units, and its cost doesn't grow with the
+ * number of games. The resamples are run in parallel, and each batch
+ * of them has a random number stream of its own that only depends on
+ * the seed, so the result doesn't depend on the number of threads.
+ *
+ * In a tournament of two players the ratings are the Elo differences
+ * to the opponent, like Elo::diff(); otherwise they are the ratings of
+ * RatingSolver, whose average is zero.
+ */
+class LIB_EXPORT BootstrapRatings
+{
+	public:
+		/*! Creates a new estimator for \a playerCount players. */
+		explicit BootstrapRatings(int playerCount = 0);
+
+		/*! Returns the number of players. */
+		int playerCount() const;
+		/*!
+		 * Clears all results and sets the number of players to
+		 * \a playerCount and the number of games in a unit to
+		 * \a unitSize.
+		 */
+		void reset(int playerCount, int unitSize = 1);
+		/*!
+		 * Adds a game of unit \a unit between \a player and
+		 * \a opponent where \a player scored \a points half points
+		 * (0, 1 or 2).
+		 *
+		 * The unit is complete when it has unitSize games. A unit
+		 * that is still incomplete in run() is resampled as it is.
+		 */
+		void addGame(int unit, int player, int opponent, int points);
+		/*! Returns the number of games added since reset(). */
+		int gameCount() const;
+
+		/*!
+		 * Computes \a sampleCount resamples of the ratings with
+		 * random numbers seeded by \a seed.
+		 *
+		 * Returns false if there are no games.
+		 */
+		bool run(int sampleCount, quint32 seed);
+		/*! Returns the number of resamples of the last run(). */
+		int sampleCount() const;
+		/*!
+		 * Returns the rating of \a player at \a percentile percent
+		 * of the resamples of the last run(), or NaN if the player
+		 * has no games.
+		 */
+		double percentile(int player, double percentile) const;
+
+	private:
+		struct Unit
+		{
+			int player;
+			int opponent;
+			int games;
+			int points;
+		};
+
+		void addUnit(QHash<quint64, int>& counts, const Unit& unit) const;
+
+		int m_playerCount;
+		int m_unitSize;
+		int m_gameCount;
+		int m_sampleCount;
+		// Number of complete units of each kind
+		QHash<quint64, int> m_counts;
+		QHash<int, Unit> m_pending;
+		// Sorted ratings of each player's resamples, and the
+		// number of resamples where the player had games
+		QVector<double> m_samples;
+		QVector<int> m_validSamples;
+};
+
+#endif // BOOTSTRAPRATINGS_H
@@ -0,0 +1,170 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cgroup.h"
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#ifdef Q_OS_LINUX
+#include <csignal>
+#include <sys/types.h>
+#endif
+
+namespace {
+
+const char* s_cgroupRoot = "/sys/fs/cgroup";
+
+bool writeFile(const QString& fileName, const QByteArray& data)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+		return false;
+	return file.write(data) == data.size();
+}
+
+QByteArray readFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+	return file.readAll();
+}
+
+} // anonymous namespace
+
+bool Cgroup::isSupported()
+{
+#ifdef Q_OS_LINUX
+	return QFile::exists(QString(s_cgroupRoot) + "/cgroup.controllers");
+#else
+	return false;
+#endif
+}
+
+bool Cgroup::enableControllers(const QString& path)
+{
+	// Each controller is enabled on its own so that a missing one
+	// doesn't keep the others from being used
+	bool ok = true;
+	for (const char* controller : { "+cpu", "+cpuset", "+memory" })
+		ok &= writeFile(path + "/cgroup.subtree_control", controller);
+	return ok;
+}
+
+bool Cgroup::create(const QString& path)
+{
+	return QDir().mkpath(path);
+}
+
+bool Cgroup::remove(const QString& path)
+{
+	QDir dir(path);
+	if (!dir.exists())
+		return true;
+
+	// The control files can't be deleted, only the directories
+	const QStringList children = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	for (const QString& child : children)
+		remove(dir.filePath(child));
+	return QDir().rmdir(path);
+}
+
+bool Cgroup::setCpuQuota(const QString& path, int percent)
+{
+	// The quota is given per 100 ms period
+	const qint64 period = 100000;
+	const qint64 quota = period * percent / 100;
+	return quota > 0
+	    && writeFile(path + "/cpu.max",
+			 QByteArray::number(quota) + ' ' + QByteArray::number(period));
+}
+
+bool Cgroup::setCpus(const QString& path, const CpuAffinity::CpuSet& cpus)
+{
+	return !cpus.isEmpty()
+	    && writeFile(path + "/cpuset.cpus",
+			 CpuAffinity::toString(cpus).toLatin1());
+}
+
+bool Cgroup::setMemoryLimit(const QString& path, qint64 bytes)
+{
+	return bytes > 0
+	    && writeFile(path + "/memory.max", QByteArray::number(bytes));
+}
+
+bool Cgroup::addProcess(const QString& path, qint64 pid)
+{
+	return writeFile(path + "/cgroup.procs", QByteArray::number(pid));
+}
+
+bool Cgroup::kill(const QString& path)
+{
+#ifdef Q_OS_LINUX
+	// cgroup.kill is available since Linux 5.14. Older kernels
+	// need the processes to be killed one by one.
+	if (writeFile(path + "/cgroup.kill", "1"))
+		return true;
+
+	bool ok = QDir(path).exists();
+	const QList<QByteArray> pids = readFile(path + "/cgroup.procs").split('\n');
+	for (const QByteArray& pid : pids)
+	{
+		if (!pid.isEmpty() && ::kill(pid_t(pid.toLongLong()), SIGKILL) != 0)
+			ok = false;
+	}
+	return ok;
+#else
+	Q_UNUSED(path);
+	return false;
+#endif
+}
+
+qint64 Cgroup::throttledTime(const QString& path)
+{
+	const QList<QByteArray> lines = readFile(path + "/cpu.stat").split('\n');
+	for (const QByteArray& line : lines)
+	{
+		if (line.startsWith("throttled_usec "))
+		{
+			bool ok = false;
+			const qint64 usec = line.mid(15).toLongLong(&ok);
+			return ok ? usec : -1;
+		}
+	}
+
+	return -1;
+}
+
+qint64 Cgroup::parseSize(const QString& str)
+{
+	QString digits(str.trimmed().toUpper());
+	qint64 unit = 1;
+	if (digits.endsWith('K'))
+		unit = Q_INT64_C(1) << 10;
+	else if (digits.endsWith('M'))
+		unit = Q_INT64_C(1) << 20;
+	else if (digits.endsWith('G'))
+		unit = Q_INT64_C(1) << 30;
+	if (unit > 1)
+		digits.chop(1);
+
+	bool ok = false;
+	const qint64 size = digits.toLongLong(&ok);
+	if (!ok || size <= 0)
+		return 0;
+	return size * unit;
+}
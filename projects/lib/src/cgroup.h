@@ -0,0 +1,118 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CGROUP_H
+#define CGROUP_H
+
+#include <QString>
+#include "cpuaffinity.h"
+
+/*!
+ * \brief Functions for confining engine processes to Linux cgroups.
+ *
+ * An engine that starts more threads or allocates more memory than
+ * it was told to slows down the other games on the host. With cgroup
+ * v2 the engines of each game slot can be given a CPU quota, a set
+ * of CPUs and a memory limit that the kernel enforces, no matter how
+ * many processes or threads the engines start.
+ *
+ * The groups are created under a directory of the unified cgroup
+ * hierarchy that has been delegated to the user, eg. with
+ * <tt>systemd-run --user --scope -p Delegate=yes</tt>. Each game slot
+ * gets a group of its own, and each engine process a leaf group
+ * inside it, so an engine and the processes it started can be killed
+ * together.
+ *
+ * Cgroups are only supported on Linux.
+ */
+class LIB_EXPORT Cgroup
+{
+	public:
+		/*!
+		 * Returns true if the unified (v2) cgroup hierarchy is
+		 * available on this host.
+		 */
+		static bool isSupported();
+
+		/*!
+		 * Lets the child groups of \a path use the cpu, cpuset
+		 * and memory controllers.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool enableControllers(const QString& path);
+		/*!
+		 * Creates the group \a path.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool create(const QString& path);
+		/*!
+		 * Removes the group \a path and its child groups.
+		 * The groups must not have any processes left.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool remove(const QString& path);
+
+		/*!
+		 * Limits the processes in \a path to \a percent of the
+		 * time of one CPU, eg. 200 for two CPUs.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool setCpuQuota(const QString& path, int percent);
+		/*!
+		 * Lets the processes in \a path run only on \a cpus.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool setCpus(const QString& path,
+				    const CpuAffinity::CpuSet& cpus);
+		/*!
+		 * Limits the memory of the processes in \a path to
+		 * \a bytes. A process that needs more is killed by the
+		 * kernel.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool setMemoryLimit(const QString& path, qint64 bytes);
+
+		/*!
+		 * Moves the process \a pid to the group \a path.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool addProcess(const QString& path, qint64 pid);
+		/*!
+		 * Kills all processes in \a path and its child groups.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool kill(const QString& path);
+
+		/*!
+		 * Returns the time in microseconds that the processes in
+		 * \a path had to wait because they used up their CPU quota,
+		 * or -1 if it's unknown.
+		 */
+		static qint64 throttledTime(const QString& path);
+
+		/*!
+		 * Parses a memory size like "512M" or "2G" into bytes.
+		 * The suffixes K, M and G are powers of 1024. Returns 0
+		 * if \a str is not a valid size.
+		 */
+		static qint64 parseSize(const QString& str);
+
+	private:
+		Cgroup();
+};
+
+#endif // CGROUP_H
@@ -17,11 +17,25 @@
 
 #include "chessengine.h"
 #include <QIODevice>
+#include <QDir>
 #include <QTimer>
+#include <QMetaMethod>
+#include <cstring>
 #include <QStringRef>
 #include <QtAlgorithms>
 #include "engineoption.h"
+#include "enginehandshakecache.h"
+#include "engineprocess.h"
+#include "enginedebuglog.h"
+#include "cgroup.h"
+#include "tracer.h"
 
+namespace {
+
+// How long a thinking engine can stay silent after being told to stop
+const int s_idleTimeout = 10000;
+
+} // anonymous namespace
 
 int ChessEngine::s_count = 0;
 
@@ -75,11 +89,23 @@ ChessEngine::ChessEngine(QObject* parent)
 	  m_pinging(false),
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
+	  m_compactPositions(false),
+	  m_clockRestartPending(false),
+	  m_latency(0),
+	  m_stopTimeout(0),
+	  m_maxStopLatency(0),
+	  m_inputLines(0),
+	  m_acknowledgedLines(0),
+	  m_pingLines(0),
+	  m_gamePings(0),
+	  m_skippedPings(0),
 	  m_pingTimer(new QTimer(this)),
 	  m_quitTimer(new QTimer(this)),
 	  m_idleTimer(new QTimer(this)),
 	  m_protocolStartTimer(new QTimer(this)),
+	  m_thinkingTimer(new QTimer(this)),
 	  m_ioDevice(nullptr),
+	  m_debugLog(nullptr),
 	  m_restartMode(EngineConfiguration::RestartAuto)
 {
 	m_pingTimer->setSingleShot(true);
@@ -91,18 +117,32 @@ ChessEngine::ChessEngine(QObject* parent)
 	connect(m_quitTimer, SIGNAL(timeout()), this, SLOT(onQuitTimeout()));
 
 	m_idleTimer->setSingleShot(true);
-	m_idleTimer->setInterval(10000);
 	connect(m_idleTimer, SIGNAL(timeout()), this, SLOT(onIdleTimeout()));
 
 	m_protocolStartTimer->setSingleShot(true);
 	m_protocolStartTimer->setInterval(35000);
 	connect(m_protocolStartTimer, SIGNAL(timeout()),
 		this, SLOT(onProtocolStartTimeout()));
+
+	m_thinkingTimer->setSingleShot(true);
+	m_thinkingTimer->setInterval(0);
+	connect(m_thinkingTimer, SIGNAL(timeout()),
+		this, SLOT(onThinkingTimeout()));
 }
 
 ChessEngine::~ChessEngine()
 {
 	qDeleteAll(m_options);
+	delete m_debugLog;
+
+	// The kernel may need a moment to clean up the killed
+	// processes, so the group can be left for the game manager
+	// to remove
+	if (!m_cgroup.isEmpty())
+	{
+		Cgroup::kill(m_cgroup);
+		Cgroup::remove(m_cgroup);
+	}
 }
 
 QIODevice* ChessEngine::device() const
@@ -119,6 +159,17 @@ void ChessEngine::setDevice(QIODevice* device)
 
 	connect(m_ioDevice, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
 	connect(m_ioDevice, SIGNAL(readChannelFinished()), this, SLOT(onCrashed()));
+	connect(m_ioDevice, SIGNAL(bytesWritten(qint64)),
+		this, SLOT(onBytesWritten()));
+}
+
+ProcessUsage ChessEngine::resourceUsage() const
+{
+	auto process = qobject_cast<EngineProcess*>(m_ioDevice);
+	if (process == nullptr)
+		return ProcessUsage();
+
+	return ProcessUsage::sample(process->processId());
 }
 
 void ChessEngine::applyConfiguration(const EngineConfiguration& configuration)
@@ -143,13 +194,53 @@ void ChessEngine::applyConfiguration(const EngineConfiguration& configuration)
 
 	m_whiteEvalPov = configuration.whiteEvalPov();
 	m_pondering = configuration.pondering();
+	m_compactPositions = configuration.compactPositions();
 	m_restartMode = configuration.restartMode();
+	m_thinkingTimer->setInterval(configuration.thinkingInterval());
+	m_stopTimeout = configuration.stopTimeout();
+	m_handshakeCacheKey = EngineHandshakeCache::key(configuration);
 	setClaimsValidated(configuration.areClaimsValidated());
 
 	if (configuration.rating())
 		setRating(configuration.rating());
 }
 
+void ChessEngine::applyOptions(const EngineConfiguration& configuration,
+			       const QVariantMap& overrides)
+{
+	QStringList names;
+	const auto options = configuration.options();
+	for (const auto option : options)
+	{
+		if (!option->isEditable())
+			continue;
+		names << option->name();
+		if (getOption(option->name()) == nullptr)
+			continue;
+		setOption(option->name(),
+			  overrides.value(option->name(), option->value()));
+	}
+
+	for (auto it = overrides.constBegin(); it != overrides.constEnd(); ++it)
+	{
+		if (!names.contains(it.key()))
+			setOption(it.key(), it.value());
+	}
+
+	// Restore the options that were only overridden for the
+	// previous game
+	const QStringList overridden = m_overriddenOptions;
+	for (const QString& name : overridden)
+	{
+		EngineOption* option = getOption(name);
+		if (option != nullptr
+		&&  !names.contains(name)
+		&&  !overrides.contains(name))
+			setOption(name, option->defaultValue());
+	}
+	m_overriddenOptions = overrides.keys();
+}
+
 void ChessEngine::addOption(EngineOption* option)
 {
 	Q_ASSERT(option != nullptr);
@@ -191,6 +282,17 @@ void ChessEngine::setOption(const QString& name, const QVariant& value)
 	}
 
 	option->setValue(value);
+
+	// Sending an unchanged value again can make the engine eg.
+	// reallocate its hash table or reload its evaluation network
+	if (option->isEditable())
+	{
+		const auto it = m_sentOptions.constFind(option->name());
+		if (it != m_sentOptions.constEnd()
+		&&  it.value() == option->value())
+			return;
+		m_sentOptions[option->name()] = option->value();
+	}
 	sendOption(option->name(), option->value());
 }
 
@@ -222,12 +324,19 @@ void ChessEngine::start()
 	
 	m_pinging = false;
 	setState(Starting);
+	if (Tracer::isEnabled())
+		Tracer::begin("engine", "handshake", this, name());
 
 	flushWriteBuffer();
 	
 	startProtocol();
-	m_pinging = true;
-	m_protocolStartTimer->start();
+
+	// The protocol may start right away with a cached handshake
+	if (state() == Starting)
+	{
+		m_pinging = true;
+		m_protocolStartTimer->start();
+	}
 }
 
 void ChessEngine::onProtocolStart()
@@ -235,6 +344,7 @@ void ChessEngine::onProtocolStart()
 	m_protocolStartTimer->stop();
 	m_pinging = false;
 	setState(Idle);
+	Tracer::end("engine", "handshake", this);
 	Q_ASSERT(isReady());
 
 	flushWriteBuffer();
@@ -250,9 +360,35 @@ void ChessEngine::onProtocolStart()
 
 void ChessEngine::go()
 {
+	// The ping makes sure that the engine has handled everything
+	// it has been sent before it starts thinking
 	if (state() == Observing && !isPondering())
-		ping();
+	{
+		if (m_acknowledgedLines < m_inputLines
+		||  !m_writeBuffer.isEmpty())
+			ping();
+		else
+			m_skippedPings++;
+	}
 	ChessPlayer::go();
+
+	// The clock was started before the search command was written.
+	// Restart it when the command has actually been sent, so that
+	// the engine doesn't pay for the event loop's delays.
+	if (state() != Thinking || !isReady())
+		return;
+	if (m_ioDevice->bytesToWrite() > 0)
+		m_clockRestartPending = true;
+	else
+	{
+		restartClock();
+		m_turnClock.start();
+	}
+}
+
+int ChessEngine::latency() const
+{
+	return m_latency;
 }
 
 EngineConfiguration::RestartMode ChessEngine::restartMode() const
@@ -280,14 +416,60 @@ bool ChessEngine::pondering() const
 	return m_pondering;
 }
 
+bool ChessEngine::compactPositions() const
+{
+	return m_compactPositions;
+}
+
+QString ChessEngine::handshakeCacheKey() const
+{
+	return m_handshakeCacheKey;
+}
+
+quint64 ChessEngine::inputLineCount() const
+{
+	return m_inputLines;
+}
+
+void ChessEngine::acknowledgeInput(quint64 lineCount)
+{
+	m_acknowledgedLines = qMax(m_acknowledgedLines, lineCount);
+}
+
 void ChessEngine::endGame(const Chess::Result& result)
 {
+	// An engine that was searching has just been told to stop
+	const bool stopping = (state() == Thinking || isPondering());
+
+	m_thinkingTimer->stop();
+	m_pendingThinking.clear();
+	m_clockRestartPending = false;
+	m_turnClock.invalidate();
 	ChessPlayer::endGame(result);
 
+	if (hasDebugOutput())
+		writeDebug(QString("%1(%2): %3 pings sent and %4 "
+				   "skipped during the game")
+			   .arg(name())
+			   .arg(m_id)
+			   .arg(m_gamePings)
+			   .arg(m_skippedPings));
+	m_gamePings = 0;
+	m_skippedPings = 0;
+	if (m_debugLog != nullptr)
+		m_debugLog->flush();
+
 	if (restartsBetweenGames())
+	{
 		quit();
-	else
-		ping();
+		return;
+	}
+
+	if (stopping)
+		m_stopClock.start();
+	ping();
+	if (stopping && m_pinging && m_stopTimeout > 0)
+		m_pingTimer->start(m_stopTimeout);
 }
 
 bool ChessEngine::isHuman() const
@@ -313,7 +495,8 @@ bool ChessEngine::stopThinking()
 	{
 		if (!m_pinging)
 		{
-			m_idleTimer->start();
+			m_idleTimer->start(s_idleTimeout);
+			m_idleClock.start();
 			sendStop();
 			return true;
 		}
@@ -332,6 +515,14 @@ void ChessEngine::onIdleTimeout()
 	if (state() != Thinking || m_pinging)
 		return;
 
+	// The engine has written something since the timer was started
+	const qint64 remaining = s_idleTimeout - m_idleClock.elapsed();
+	if (remaining > 0)
+	{
+		m_idleTimer->start(int(remaining));
+		return;
+	}
+
 	m_writeBuffer.clear();
 	kill();
 
@@ -347,13 +538,24 @@ void ChessEngine::kill()
 	       qPrintable(name()), m_id);
 
 	m_pinging = false;
+	m_clockRestartPending = false;
+	m_turnClock.invalidate();
+	m_stopClock.invalidate();
 	m_pingTimer->stop();
 	m_protocolStartTimer->stop();
+	m_thinkingTimer->stop();
+	m_pendingThinking.clear();
 	m_writeBuffer.clear();
+	if (m_debugLog != nullptr)
+		m_debugLog->flush();
 
 	disconnect(m_ioDevice, SIGNAL(readChannelFinished()),
 		   this, SLOT(onCrashed()));
 	m_ioDevice->close();
+	// Also kill the processes the engine started, eg. helper
+	// processes or the engine behind a wrapper script
+	if (!m_cgroup.isEmpty())
+		Cgroup::kill(m_cgroup);
 
 	ChessPlayer::kill();
 }
@@ -374,6 +576,22 @@ void ChessEngine::ping(bool sendCommand)
 	m_pinging = true;
 	m_pingState = state();
 	m_pingTimer->start();
+
+	// Pings that aren't sent here (eg. waiting for a protocol's
+	// startup to finish) say nothing about the round-trip time
+	if (sendCommand)
+	{
+		m_pingClock.start();
+		m_pingLines = m_inputLines;
+		m_gamePings++;
+		if (Tracer::isEnabled())
+			Tracer::begin("engine", "ping", this, name());
+	}
+	else
+	{
+		m_pingClock.invalidate();
+		m_pingLines = 0;
+	}
 }
 
 void ChessEngine::pong(bool emitReady)
@@ -383,6 +601,26 @@ void ChessEngine::pong(bool emitReady)
 
 	m_pingTimer->stop();
 	m_pinging = false;
+	acknowledgeInput(m_pingLines);
+
+	if (m_stopClock.isValid())
+	{
+		const int msecs = int(m_stopClock.elapsed());
+		m_stopClock.invalidate();
+		m_maxStopLatency = qMax(m_maxStopLatency, msecs);
+		emit stopMeasured(msecs, false);
+	}
+
+	// A busy engine can take a long time to answer a ping, so the
+	// fastest answer is the best estimate of the round-trip time
+	if (m_pingClock.isValid())
+	{
+		const int rtt = int(m_pingClock.nsecsElapsed() / 1000);
+		if (rtt > 0 && (m_latency == 0 || rtt < m_latency))
+			m_latency = rtt;
+		m_pingClock.invalidate();
+		Tracer::end("engine", "ping", this);
+	}
 	flushWriteBuffer();
 
 	if (state() == FinishingGame)
@@ -407,8 +645,18 @@ void ChessEngine::pong(bool emitReady)
 
 void ChessEngine::onPingTimeout()
 {
-	qDebug("Engine %s(%d) failed to respond to ping",
-	       qPrintable(name()), m_id);
+	if (m_stopClock.isValid())
+	{
+		const int msecs = int(m_stopClock.elapsed());
+		m_stopClock.invalidate();
+		m_maxStopLatency = qMax(m_maxStopLatency, msecs);
+		qDebug("Engine %s(%d) failed to stop in %d ms",
+		       qPrintable(name()), m_id, msecs);
+		emit stopMeasured(msecs, true);
+	}
+	else
+		qDebug("Engine %s(%d) failed to respond to ping",
+		       qPrintable(name()), m_id);
 
 	m_pinging = false;
 	m_writeBuffer.clear();
@@ -417,54 +665,248 @@ void ChessEngine::onPingTimeout()
 	forfeit(Chess::Result::StalledConnection);
 }
 
+bool ChessEngine::canWrite(WriteMode mode) const
+{
+	return state() != NotStarted && (!m_pinging || mode == Unbuffered);
+}
+
 void ChessEngine::write(const QString& data, WriteMode mode)
 {
 	if (state() == Disconnected)
 		return;
-	if (state() == NotStarted
-	||  (m_pinging && mode == Buffered))
+	if (!canWrite(mode))
 	{
 		m_writeBuffer.append(data);
 		return;
 	}
 
+	appendLine(data);
+	flushOutput();
+}
+
+void ChessEngine::write(const QStringList& lines, WriteMode mode)
+{
+	if (state() == Disconnected || lines.isEmpty())
+		return;
+	if (!canWrite(mode))
+	{
+		m_writeBuffer.append(lines);
+		return;
+	}
+
+	for (const QString& line : lines)
+		appendLine(line);
+	flushOutput();
+}
+
+void ChessEngine::appendLine(const QString& line)
+{
+	if (hasDebugOutput())
+		writeDebug(QString(">%1(%2): %3")
+			   .arg(name())
+			   .arg(m_id)
+			   .arg(line));
+
+	m_inputLines++;
+
+	// Encode the line as Latin-1 straight into the output buffer,
+	// which keeps its capacity between writes
+	if (m_output.capacity() == 0)
+		m_output.reserve(1024);
+	const int pos = m_output.size();
+	m_output.resize(pos + line.size() + 1);
+
+	char* out = m_output.data() + pos;
+	const QChar* in = line.constData();
+	for (int i = 0; i < line.size(); i++)
+	{
+		const ushort c = in[i].unicode();
+		*out++ = c < 0x100 ? char(c) : '?';
+	}
+	*out = '\n';
+}
+
+void ChessEngine::flushOutput()
+{
 	Q_ASSERT(m_ioDevice->isWritable());
-	emit debugMessage(QString(">%1(%2): %3")
-			  .arg(name())
-			  .arg(m_id)
-			  .arg(data));
 
-	if (m_ioDevice->write(data.toLatin1() + "\n") == -1)
+	if (m_ioDevice->write(m_output) == -1)
 		qDebug("Writing to engine %s(%d) failed",
 		       qPrintable(name()), m_id);
+	m_output.resize(0);
+}
+
+void ChessEngine::reportThinking(const MoveEvaluation& eval)
+{
+	if (!hasThinkingListener())
+		return;
+
+	if (m_thinkingTimer->interval() <= 0)
+	{
+		emit thinking(eval);
+		return;
+	}
+
+	// The first update after a pause is reported immediately
+	if (m_thinkingTimer->isActive())
+	{
+		m_pendingThinking[qMax(eval.pvNumber(), 1)] = eval;
+		return;
+	}
+
+	emit thinking(eval);
+	m_thinkingTimer->start();
+}
+
+void ChessEngine::flushThinking()
+{
+	m_thinkingTimer->stop();
+	if (m_pendingThinking.isEmpty())
+		return;
+
+	const auto pending = m_pendingThinking;
+	m_pendingThinking.clear();
+	for (const MoveEvaluation& eval : pending)
+		emit thinking(eval);
+}
+
+void ChessEngine::onThinkingTimeout()
+{
+	if (m_pendingThinking.isEmpty())
+		return;
+
+	flushThinking();
+	m_thinkingTimer->start();
+}
+
+bool ChessEngine::hasThinkingListener() const
+{
+	static const QMetaMethod signal(
+		QMetaMethod::fromSignal(&ChessPlayer::thinking));
+	return isSignalConnected(signal);
+}
+
+void ChessEngine::setDebugLogDirectory(const QString& dir)
+{
+	delete m_debugLog;
+	m_debugLog = nullptr;
+	if (dir.isEmpty())
+		return;
+
+	// Keep the file name portable
+	QString baseName(name());
+	for (QChar& c : baseName)
+	{
+		if (!c.isLetterOrNumber() && c != '-' && c != '.')
+			c = '_';
+	}
+	m_debugLog = new EngineDebugLog(QDir(dir).filePath(
+		QString("%1-%2.log").arg(baseName).arg(m_id)));
+}
+
+void ChessEngine::setCgroup(const QString& path)
+{
+	m_cgroup = path;
+}
+
+bool ChessEngine::hasDebugOutput() const
+{
+	static const QMetaMethod signal(
+		QMetaMethod::fromSignal(&ChessPlayer::debugMessage));
+	return m_debugLog != nullptr || isSignalConnected(signal);
+}
+
+void ChessEngine::writeDebug(const QString& message)
+{
+	if (m_debugLog != nullptr)
+		m_debugLog->write(message);
+	else
+		emit debugMessage(message);
 }
 
 void ChessEngine::onReadyRead()
 {
-	while (m_ioDevice->isReadable() && m_ioDevice->canReadLine())
+	if (!m_ioDevice->isReadable())
+		return;
+
+	// Append the new data to the buffer, which keeps its capacity
+	// between calls so that reading doesn't allocate memory
+	const qint64 available = m_ioDevice->bytesAvailable();
+	if (available > 0)
+	{
+		const int oldSize = m_readBuffer.size();
+		m_readBuffer.resize(oldSize + int(available));
+		const qint64 n = m_ioDevice->read(m_readBuffer.data() + oldSize,
+						  available);
+		m_readBuffer.resize(oldSize + int(qMax(n, qint64(0))));
+	}
+
+	const bool debug = hasDebugOutput();
+	int pos = 0;
+	bool hasLines = false;
+
+	// The time between the search command and the engine's first
+	// output is overhead that the engine's clock pays for
+	if (m_turnClock.isValid() && available > 0)
+	{
+		if (debug && state() == Thinking)
+			writeDebug(QString("%1(%2): first output %3 ms "
+					   "after the search command")
+				   .arg(name())
+				   .arg(m_id)
+				   .arg(m_turnClock.nsecsElapsed() / 1.0e6,
+					0, 'f', 3));
+		m_turnClock.invalidate();
+	}
+
+	while (m_ioDevice->isReadable())
 	{
-		QString line = QString(m_ioDevice->readLine());
-		if (line.endsWith('\n'))
-			line.chop(1);
-		if (line.endsWith('\r'))
-			line.chop(1);
-		if (line.isEmpty())
+		const char* data = m_readBuffer.constData();
+		const int size = m_readBuffer.size();
+		auto eol = static_cast<const char*>(
+			std::memchr(data + pos, '\n', size_t(size - pos)));
+		if (eol == nullptr)
+			break;
+
+		const int start = pos;
+		int end = int(eol - data);
+		pos = end + 1;
+		if (end > start && data[end - 1] == '\r')
+			end--;
+		if (end == start)
 			continue;
 
-		emit debugMessage(QString("<%1(%2): %3")
-				  .arg(name())
-				  .arg(m_id)
-				  .arg(line));
+		const QString line(QString::fromUtf8(data + start, end - start));
+		if (debug)
+			writeDebug(QString("<%1(%2): %3")
+				   .arg(name())
+				   .arg(m_id)
+				   .arg(line));
 		parseLine(line);
+		hasLines = true;
 
-		if (m_idleTimer->isActive())
-		{
-			if (state() == Thinking && !m_pinging)
-				m_idleTimer->start();
-			else
-				m_idleTimer->stop();
-		}
+		if (m_idleTimer->isActive()
+		&&  (state() != Thinking || m_pinging))
+			m_idleTimer->stop();
 	}
+
+	// Restarting the idle timer for every line would be costly, so
+	// only the time of the output is saved. onIdleTimeout() starts
+	// the timer again if the engine wasn't silent long enough.
+	if (hasLines && m_idleTimer->isActive())
+		m_idleClock.start();
+
+	m_readBuffer.remove(0, pos);
+}
+
+void ChessEngine::onBytesWritten()
+{
+	if (!m_clockRestartPending || m_ioDevice->bytesToWrite() > 0)
+		return;
+
+	m_clockRestartPending = false;
+	restartClock();
+	m_turnClock.start();
 }
 
 void ChessEngine::flushWriteBuffer()
@@ -472,10 +914,9 @@ void ChessEngine::flushWriteBuffer()
 	if (m_pinging || state() == NotStarted)
 		return;
 
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (const QString& line, m_writeBuffer)
-		write(line);
+	const QStringList lines = m_writeBuffer;
 	m_writeBuffer.clear();
+	write(lines);
 }
 
 void ChessEngine::clearWriteBuffer()
@@ -522,3 +963,13 @@ QString ChessEngine::configurationString() const
 {
 	return m_configurationString;
 }
+
+bool ChessEngine::isStopping() const
+{
+	return m_stopClock.isValid();
+}
+
+int ChessEngine::maxStopLatency() const
+{
+	return m_maxStopLatency;
+}
@@ -21,10 +21,13 @@
 #include "chessplayer.h"
 #include <QVariant>
 #include <QStringList>
+#include <QElapsedTimer>
 #include "engineconfiguration.h"
+#include "processusage.h"
 
 class QIODevice;
 class EngineOption;
+class EngineDebugLog;
 
 
 /*!
@@ -61,6 +64,17 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		QIODevice* device() const;
 		/*! Sets the current device to \a device. */
 		void setDevice(QIODevice* device);
+		/*!
+		 * Returns the current resource usage of the engine's
+		 * process, or a null snapshot if the engine doesn't run
+		 * in a local process.
+		 */
+		ProcessUsage resourceUsage() const;
+		/*!
+		 * Returns the engine's round-trip time in microseconds,
+		 * measured from its responses to pings.
+		 */
+		virtual int latency() const;
 
 		// Inherited from ChessPlayer
 		virtual void endGame(const Chess::Result& result);
@@ -76,6 +90,41 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 
 		/*! Applies \a configuration to the engine. */
 		void applyConfiguration(const EngineConfiguration& configuration);
+		/*!
+		 * Writes the engine's debug messages to a log file of its
+		 * own in directory \a dir, instead of emitting them with
+		 * the debugMessage() signal.
+		 *
+		 * The file is named after the engine, and it's written by
+		 * the engine's thread.
+		 *
+		 * \sa EngineDebugLog
+		 */
+		void setDebugLogDirectory(const QString& dir);
+		/*!
+		 * Sets the cgroup that holds the engine's process to
+		 * \a path.
+		 *
+		 * When the engine is killed or destroyed, the processes it
+		 * started are killed with it, and the group is removed.
+		 *
+		 * \sa Cgroup
+		 */
+		void setCgroup(const QString& path);
+		/*!
+		 * Applies the options of \a configuration to the engine
+		 * again, eg. when the engine is reused for a new game.
+		 *
+		 * The values in \a overrides replace the configured values
+		 * of the options with the same names for this game. An
+		 * option that was overridden for the previous game gets its
+		 * configured or default value back.
+		 *
+		 * Only the options whose values differ from the ones the
+		 * engine already has are sent to it.
+		 */
+		void applyOptions(const EngineConfiguration& configuration,
+				  const QVariantMap& overrides = QVariantMap());
 
 		/*!
 		 * Sends a ping message (an echo request) to the engine to
@@ -102,11 +151,20 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		 * the device immediately even if the engine is being pinged.
 		 */
 		void write(const QString& data, WriteMode mode = Buffered);
+		/*!
+		 * Writes \a lines to the chess engine.
+		 *
+		 * The lines are sent with a single write to the device,
+		 * so that a set of commands that belong together (eg. the
+		 * position and the search command) arrives in one piece.
+		 */
+		void write(const QStringList& lines, WriteMode mode = Buffered);
 
 		/*!
 		 * Sets an option with the name \a name to \a value.
 		 *
 		 * \note If the engine doesn't have an option called \a name,
+		 * or if the option already has value \a value in the engine,
 		 * nothing happens.
 		 */
 		void setOption(const QString& name, const QVariant& value);
@@ -120,6 +178,30 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		/*! Returns the options set by the engine's configuration. */
 		QString configurationString() const;
 
+		/*!
+		 * Returns true if the engine was told to stop searching at
+		 * the end of a game and hasn't stopped yet.
+		 */
+		bool isStopping() const;
+		/*!
+		 * Returns the longest time in milliseconds the engine took
+		 * to stop searching at the end of a game.
+		 */
+		int maxStopLatency() const;
+
+	signals:
+		/*!
+		 * This signal is emitted when the engine stops searching
+		 * at the end of a game, \a msecs milliseconds after it was
+		 * told to stop.
+		 *
+		 * If \a timedOut is true the engine didn't stop within the
+		 * stop timeout and it's terminated.
+		 *
+		 * \sa EngineConfiguration::stopTimeout()
+		 */
+		void stopMeasured(int msecs, bool timedOut);
+
 	public slots:
 		// Inherited from ChessPlayer
 		virtual void go();
@@ -228,6 +310,54 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		 * the engine does not support pondering.
 		 */
 		bool pondering() const;
+		/*!
+		 * Returns true if positions should be sent from the last
+		 * irreversible move.
+		 *
+		 * \sa EngineConfiguration::compactPositions()
+		 */
+		bool compactPositions() const;
+		/*!
+		 * Returns the key of the engine in EngineHandshakeCache, or
+		 * an empty string if the handshake can't be cached.
+		 */
+		QString handshakeCacheKey() const;
+
+		/*! Returns the number of lines written to the engine. */
+		quint64 inputLineCount() const;
+		/*!
+		 * Tells that the engine has handled the first \a lineCount
+		 * lines written to it, eg. because it answered a command
+		 * that was the last of them.
+		 *
+		 * The ping before the engine's next move is skipped if
+		 * nothing else has been written to the engine since.
+		 */
+		void acknowledgeInput(quint64 lineCount);
+
+		/*!
+		 * Reports \a eval with the thinking() signal.
+		 *
+		 * If the engine has a thinking interval, updates that arrive
+		 * faster are held back and only the latest update of each PV
+		 * is emitted when the interval expires.
+		 *
+		 * \sa EngineConfiguration::thinkingInterval()
+		 */
+		void reportThinking(const MoveEvaluation& eval);
+		/*!
+		 * Returns true if anything is connected to the thinking()
+		 * signal. Without listeners the engine can skip preparing
+		 * updates that only they would see.
+		 */
+		bool hasThinkingListener() const;
+		/*!
+		 * Emits the thinking updates that are held back.
+		 *
+		 * This must be called before the engine makes a move, so that
+		 * the final update of the search is always delivered.
+		 */
+		void flushThinking();
 
 	protected slots:
 		// Inherited from ChessPlayer
@@ -270,9 +400,17 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 
 	private slots:
 		void onQuitTimeout();
+		void onThinkingTimeout();
 		void onProtocolStartTimeout();
+		void onBytesWritten();
 
 	private:
+		bool hasDebugOutput() const;
+		void writeDebug(const QString& message);
+		bool canWrite(WriteMode mode) const;
+		void appendLine(const QString& line);
+		void flushOutput();
+
 		static int s_count;
 
 		int m_id;
@@ -280,17 +418,41 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		bool m_pinging;
 		bool m_whiteEvalPov;
 		bool m_pondering;
+		bool m_compactPositions;
+		bool m_clockRestartPending;
+		int m_latency;
+		int m_stopTimeout;
+		int m_maxStopLatency;
+		quint64 m_inputLines;
+		quint64 m_acknowledgedLines;
+		quint64 m_pingLines;
+		int m_gamePings;
+		int m_skippedPings;
+		QElapsedTimer m_stopClock;
 		QTimer* m_pingTimer;
+		QElapsedTimer m_pingClock;
+		QElapsedTimer m_turnClock;
 		QTimer* m_quitTimer;
 		QTimer* m_idleTimer;
+		QElapsedTimer m_idleClock;
 		QTimer* m_protocolStartTimer;
+		QTimer* m_thinkingTimer;
+		QMap<int, MoveEvaluation> m_pendingThinking;
 		QIODevice *m_ioDevice;
+		QByteArray m_readBuffer;
 		QStringList m_writeBuffer;
+		// Encoded lines waiting to be written to the device
+		QByteArray m_output;
 		QStringList m_variants;
 		QList<EngineOption*> m_options;
 		QMap<QString, QVariant> m_optionBuffer;
+		QMap<QString, QVariant> m_sentOptions;
+		QStringList m_overriddenOptions;
+		EngineDebugLog* m_debugLog;
+		QString m_cgroup;
 		EngineConfiguration::RestartMode m_restartMode;
 		QString m_configurationString;
+		QString m_handshakeCacheKey;
 };
 
 #endif // CHESSENGINE_H
@@ -18,152 +18,41 @@
 #include "chessgame.h"
 #include <QThread>
 #include <QTimer>
-#include <QtMath>
+#include <QMetaMethod>
 #include "board/board.h"
-#include "board/westernboard.h"
 #include "chessplayer.h"
 #include "openingbook.h"
 #include "chessengine.h"
 #include "engineoption.h"
+#include "tablebaseprober.h"
+#include "gamepool.h"
+#include "tracer.h"
 
-QString ChessGame::evalString(const MoveEvaluation& eval)
+PgnGame::EvalData ChessGame::evalData(const MoveEvaluation& eval) const
 {
-	if (eval.isBookEval())
-		return "book";
+	PgnGame::EvalData data;
 	if (eval.isEmpty())
-		return QString();
+		return data;
 
-#if 1
-	QString str;
-	// score
-	// str += " ev=";
-	QString sScore;
-	if (eval.depth() > 0)
-	{
-		int score = eval.score();
-		int absScore = qAbs(score);
+	data.score = eval.score();
+	data.depth = qMax(0, eval.depth());
+	data.moveTime = eval.time();
+	data.nodes = eval.nodeCount();
+	data.nps = eval.nps();
+	data.tbHits = eval.tbHits();
+	data.pv = eval.pv();
 
-		// Detect mate-in-n scores
-		if (absScore > 9900
-		&&  (absScore = 1000 - (absScore % 1000)) < 100)
-		{
-			if (score < 0)
-				sScore = "-";
-			sScore += "M" + QString::number(absScore);
-		}
-		else
-			sScore = QString::number(double(score) / 100.0, 'f', 2);
-
-		// str += sScore + ",";
-	} else {
-		sScore = "0.00";
-		// str += sScore + ",";
-	}
-
-	str += "d=";
-	if (eval.depth() > 0) {
-		str += QString::number(eval.depth());
-	} else {
-		str += "1";
-	}
-
-	// ponder move 'pd' algebraic move
-	QString sanPv = m_board->sanStringForPv(eval.pv(), Chess::Board::StandardAlgebraic);
-	QStringList sanList = sanPv.split(' ');
-	if (sanList.length() > 1) {
-		str+= ", pd=" + sanList[1];
-	}
-
-	// move time 'mt' "hh:mm:ss"
-	int t = eval.time(); // milliseconds
-	str += ", mt=";
-	if (t == 0)
-		str += "00:00:00";
-	else {
-		int total = qFloor(t / 1000.);
-		int hours = qFloor(total / 3600.) % 24; // should be ok, right?
-		int minutes = (total / 60) % 60;
-		int seconds = total % 60;
-		str +=	QString::number(hours).rightJustified(2, '0') + ":" +
-				QString::number(minutes).rightJustified(2, '0') + ":" +
-				QString::number(seconds).rightJustified(2, '0');
-	}
-
-	// time left 'tl' "hh:mm:ss"
-	ChessPlayer *player = m_player[m_board->sideToMove()];
-	Q_ASSERT(player != 0);
-
-	int tl = player->timeControl()->timeLeft(); // milliseconds
-	str += ", tl=";
-	if (tl == 0)
-		str += "00:00:00";
-	else {
-		int total = qFloor(tl / 1000.);
-		int hours = qFloor(total / 3600.) % 24; // should be ok, right?
-		int minutes = (total / 60) % 60;
-		int seconds = total % 60;
-		str +=	QString::number(hours).rightJustified(2, '0') + ":" +
-				QString::number(minutes).rightJustified(2, '0') + ":" +
-				QString::number(seconds).rightJustified(2, '0');
-	}
-
-	// speed 's' "%d kN/s"
-	int nps = eval.nps();
-	str += ", s=" + QString::number(qFloor(nps / 1000)) + " kN/s";
-
-	// nodes 'n' "%d"
-	str += ", n=" + QString::number(eval.nodeCount());
-
-	// pv 'pv' algebraic string
-	str += ", pv=" + m_board->sanStringForPv(eval.pv(), Chess::Board::StandardAlgebraic);
-
-	// tbhits 'tb'
-	str += ", tb=" + QString::number(eval.tbHits());
-
-	// 50-move clock 'R50'
-	Chess::WesternBoard *wboard = dynamic_cast<Chess::WesternBoard *>(m_board);
-	if (wboard) {
-		str += ", R50=" + QString::number(qFloor(((100 - wboard->reversibleMoveCount()) / 2.) + 0.5));
-	}
-
-	// eval from white's perspective 'wv'
-	Chess::Side side = m_board->sideToMove();
-	str += ", wv=";
-	if (side == Chess::Side::Black && sScore != "0.00") {
-		if (sScore[0] == '-')
-			str += sScore.right(sScore.length() - 1);
-		else
-			str += "-" + sScore;
-	} else {
-		str += sScore;
-	}
-
-	str += ',';
-
-#else
-	QString str = eval.scoreText();
-	if (eval.depth() > 0)
-		str += "/" + QString::number(eval.depth()) + " ";
-
-	int t = eval.time();
-	if (t == 0)
-		return str + "0s";
+	ChessPlayer* player = m_player[m_board->sideToMove()];
+	Q_ASSERT(player != nullptr);
+	data.timeLeft = player->timeControl()->timeLeft();
 
-	int precision = 0;
-	if (t < 100)
-		precision = 3;
-	else if (t < 1000)
-		precision = 2;
-	else if (t < 10000)
-		precision = 1;
-	str += QString::number(double(t / 1000.0), 'f', precision) + 's';
-#endif
-	return str;
+	return data;
 }
 
 ChessGame::ChessGame(Chess::Board* board, PgnGame* pgn, QObject* parent)
 	: QObject(parent),
 	  m_board(board),
+	  m_openingIndex(-1),
 	  m_startDelay(0),
 	  m_finished(false),
 	  m_gameInProgress(false),
@@ -171,27 +60,42 @@ ChessGame::ChessGame(Chess::Board* board, PgnGame* pgn, QObject* parent)
 	  m_pgnInitialized(false),
 	  m_bookOwnership(false),
 	  m_boardShouldBeFlipped(false),
+	  m_liveComments(false),
+	  m_trainingData(false),
+	  m_startDelayPending(false),
+	  m_playersSynced(false),
 	  m_pgn(pgn),
-	  m_elapsed(0)
+	  m_tbAdjudication(false),
+	  m_tbProber(nullptr),
+	  m_elapsed(0),
+	  m_memory(MemoryStats::Games)
 {
 	Q_ASSERT(pgn != nullptr);
+	m_memory.setBytes(sizeof(ChessGame));
 
 	for (int i = 0; i < 2; i++)
 	{
 		m_player[i] = nullptr;
 		m_book[i] = nullptr;
 		m_bookDepth[i] = 0;
+		m_thinkingTime[i] = 0;
+		m_ponderedMoves[i] = 0;
+		m_ponderHits[i] = 0;
 	}
 }
 
 ChessGame::~ChessGame()
 {
-	delete m_board;
+	if (m_gamePool.isNull())
+		delete m_board;
+	else
+		m_gamePool->recycleBoard(m_board);
 	if (m_bookOwnership)
 	{
 		bool same = (m_book[0] == m_book[1]);
-		delete m_book[0];
-		if (!same)
+		if (m_sharedBook[0].isNull())
+			delete m_book[0];
+		if (!same && m_sharedBook[1].isNull())
 			delete m_book[1];
 	}
 }
@@ -242,7 +146,7 @@ const QVector<Chess::Move>& ChessGame::moves() const
 	return m_moves;
 }
 
-const QMap<int,int>& ChessGame::scores() const
+const QVector<ChessGame::MoveScore>& ChessGame::scores() const
 {
 	return m_scores;
 }
@@ -280,6 +184,75 @@ QString ChessGame::gameDuration() const
 	return m_gameDuration;
 }
 
+ProcessUsage ChessGame::resourceUsage(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_usage[side].since(m_startUsage[side]);
+}
+
+int ChessGame::thinkingTime(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_thinkingTime[side];
+}
+
+int ChessGame::ponderedMoves(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_ponderedMoves[side];
+}
+
+int ChessGame::ponderHits(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_ponderHits[side];
+}
+
+const MoveTimeStats& ChessGame::timeStats(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_timeStats[side];
+}
+
+void ChessGame::sampleUsage(Chess::Side side)
+{
+	auto engine = qobject_cast<ChessEngine*>(m_player[side]);
+	if (engine == nullptr)
+		return;
+
+	// Keep the previous snapshot if the engine is already gone
+	ProcessUsage usage = engine->resourceUsage();
+	if (!usage.isNull())
+		m_usage[side] = usage;
+}
+
+void ChessGame::setUsageTags()
+{
+	for (int i = 0; i < 2; i++)
+	{
+		Chess::Side side = Chess::Side::Type(i);
+		ProcessUsage usage = resourceUsage(side);
+		if (usage.isNull())
+			continue;
+
+		const QString prefix = side == Chess::Side::White ? "White" : "Black";
+		m_pgn->setTag(prefix + "CpuTime",
+			      QString::number(usage.cpuTime() / 1000.0, 'f', 1));
+		if (m_thinkingTime[side] > 0)
+			m_pgn->setTag(prefix + "CpuLoad",
+				      QString::number(double(usage.cpuTime())
+						      / m_thinkingTime[side], 'f', 2));
+		if (usage.peakMemory() >= 0)
+			m_pgn->setTag(prefix + "PeakRss",
+				      QString::number(usage.peakMemory()));
+		if (usage.voluntarySwitches() >= 0)
+			m_pgn->setTag(prefix + "ContextSwitches",
+				      QString("%1/%2")
+				      .arg(usage.voluntarySwitches())
+				      .arg(usage.involuntarySwitches()));
+	}
+}
+
 void ChessGame::stop(bool emitMoveChanged)
 {
 	if (m_finished)
@@ -294,6 +267,8 @@ void ChessGame::stop(bool emitMoveChanged)
 	emit humanEnabled(false);
 	if (!m_gameInProgress)
 	{
+		if (!m_playersSynced)
+			Tracer::end("game", "setup", this);
 		m_result = Chess::Result();
 		finish();
 		return;
@@ -320,6 +295,26 @@ void ChessGame::stop(bool emitMoveChanged)
 	m_pgn->setResultDescription(m_result.description());
 	m_pgn->setTag("TerminationDetails", m_result.shortDescription());
 
+	sampleUsage(Chess::Side::White);
+	sampleUsage(Chess::Side::Black);
+	setUsageTags();
+
+	// The players reset their counters in the next game
+	for (int i = 0; i < 2; i++)
+	{
+		m_ponderedMoves[i] = m_player[i]->ponderedMoves();
+		m_ponderHits[i] = m_player[i]->ponderHits();
+		m_timeStats[i] = m_player[i]->timeStats();
+	}
+
+	// The game holds its moves and PGN data until it's deleted
+	m_memory.setBytes(sizeof(ChessGame)
+			  + m_moves.capacity() * sizeof(Chess::Move)
+			  + m_scores.capacity() * sizeof(MoveScore)
+			  + m_trainingPositions.capacity()
+			    * sizeof(TrainingData::Position)
+			  + m_pgn->memoryUsage());
+
 	if (emitMoveChanged && plies > 1)
 	{
 		const PgnGame::MoveData& md(moves.at(plies - 1));
@@ -329,6 +324,22 @@ void ChessGame::stop(bool emitMoveChanged)
 	m_player[Chess::Side::White]->endGame(m_result);
 	m_player[Chess::Side::Black]->endGame(m_result);
 
+	// The players answer their end-of-game pings while the game is
+	// recorded and the next one is set up, which waits for them in
+	// syncPlayers(). An engine that restarts has to quit first.
+	bool restarts = false;
+	for (int i = 0; i < 2; i++)
+	{
+		auto engine = qobject_cast<ChessEngine*>(m_player[i]);
+		if (engine != nullptr && engine->restartsBetweenGames())
+			restarts = true;
+	}
+	if (!restarts)
+	{
+		QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+		return;
+	}
+
 	connect(this, SIGNAL(playersReady()), this, SLOT(finish()), Qt::QueuedConnection);
 	syncPlayers();
 }
@@ -336,6 +347,7 @@ void ChessGame::stop(bool emitMoveChanged)
 void ChessGame::finish()
 {
 	disconnect(this, SIGNAL(playersReady()), this, SLOT(finish()));
+	disconnect(this, SIGNAL(playersReady()), this, SLOT(startGame()));
 	for (int i = 0; i < 2; i++)
 	{
 		if (m_player[i] != nullptr)
@@ -345,6 +357,18 @@ void ChessGame::finish()
 	emit finished(this, m_result);
 }
 
+void ChessGame::finishWithResult(const Chess::Result& result)
+{
+	Q_ASSERT(!m_gameInProgress);
+	if (m_finished)
+		return;
+
+	m_result = result;
+	m_finished = true;
+	m_pgn->setResult(result);
+	emit finished(this, m_result);
+}
+
 void ChessGame::kill()
 {
 	for (int i = 0; i < 2; i++)
@@ -356,25 +380,71 @@ void ChessGame::kill()
 	stop();
 }
 
-void ChessGame::addPgnMove(const Chess::Move& move, const QString& comment)
+void ChessGame::addPgnMove(const Chess::Move& move, const QString& comment,
+			   const PgnGame::EvalData& eval)
 {
 	PgnGame::MoveData md;
 	md.key = m_board->key();
 	md.move = m_board->genericMove(move);
 	md.moveString = m_board->moveString(move, Chess::Board::StandardAlgebraic);
 	md.comment = comment;
+	md.eval = eval;
+
+	// The evaluation is formatted when the game is written, unless
+	// someone needs the comment while the game is running
+	static const QMetaMethod moveMadeSignal =
+		QMetaMethod::fromSignal(&ChessGame::moveMade);
+	static const QMetaMethod moveChangedSignal =
+		QMetaMethod::fromSignal(&ChessGame::moveChanged);
+	if (!eval.isNull()
+	&&  (m_liveComments
+	||   isSignalConnected(moveMadeSignal)
+	||   isSignalConnected(moveChangedSignal)))
+	{
+		md.comment = PgnGame::moveComment(md, m_board);
+		md.eval = PgnGame::EvalData();
+	}
+
+	addPgnMove(md);
+}
 
+void ChessGame::addPgnMove(const PgnGame::MoveData& md)
+{
 	m_pgn->addMove(md);
 
-	emit pgnMove();
+	// Listeners of a game running in another thread get the moves
+	// through a lock-free ring, with one queued signal per batch
+	static const QMetaMethod pgnMoveSignal =
+		QMetaMethod::fromSignal(&ChessGame::pgnMove);
+	if (!isSignalConnected(pgnMoveSignal))
+		return;
+
+	MoveEvent event = { m_pgn->moves().size(), md.moveString, md.comment };
+	if (m_moveEvents.push(event) == EventRing<MoveEvent>::QueuedAndWake)
+		emit pgnMove();
+}
+
+QVector<ChessGame::MoveEvent> ChessGame::takeMoveEvents()
+{
+	QVector<MoveEvent> events;
+	m_moveEvents.drain([&](const MoveEvent& event)
+	{
+		events.append(event);
+	});
+
+	return events;
 }
 
 void ChessGame::emitLastMove()
 {
+	static const QMetaMethod scoreChangedSignal =
+		QMetaMethod::fromSignal(&ChessGame::scoreChanged);
+
 	int ply = m_moves.size() - 1;
-	if (m_scores.contains(ply))
+	if (ply >= 0 && ply < m_scores.size()
+	&&  isSignalConnected(scoreChangedSignal))
 	{
-		int score = m_scores[ply];
+		int score = m_scores.at(ply).score;
 		if (score != MoveEvaluation::NULL_SCORE)
 			emit scoreChanged(ply, score);
 	}
@@ -396,20 +466,68 @@ void ChessGame::onMoveMade(const Chess::Move& move)
 		return;
 	}
 
-	m_scores[m_moves.size()] = sender->evaluation().score();
+	// The previous position's tablebase result comes first
+	Chess::Result tbResult;
+	if (m_tbProber != nullptr
+	&&  m_tbProber->waitForResult(&tbResult)
+	&&  !tbResult.isNone())
+	{
+		m_result = tbResult;
+		stop();
+		return;
+	}
+
+	sampleUsage(sender->side());
+	m_thinkingTime[sender->side()] += sender->timeControl()->lastMoveTime();
+
+	const MoveEvaluation& eval(sender->evaluation());
+	MoveScore score = { MoveEvaluation::NULL_SCORE, 0, 0, 0 };
+	while (m_scores.size() < m_moves.size())
+		m_scores.append(score);
+	score.score = eval.score();
+	score.depth = eval.depth();
+	score.time = eval.time();
+	score.nodes = eval.nodeCount();
+	m_scores.append(score);
+
 	m_moves.append(move);
-	addPgnMove(move, evalString(sender->evaluation()));
+	if (m_trainingData)
+		addTrainingPosition(move, eval);
+	if (eval.isBookEval())
+		addPgnMove(move, "book");
+	else
+		addPgnMove(move, QString(), evalData(eval));
 
 	// Get the result before sending the move to the opponent
 	m_board->makeMove(move);
 	m_result = m_board->result();
 	if (m_result.isNone())
 	{
-		if (m_board->reversibleMoveCount() == 0)
-			m_adjudicator.resetDrawMoveCount();
+		TraceSpan span("game", "adjudication");
+
+		// The probe runs while the opponent thinks, so a slow
+		// probe doesn't delay the move
+		bool tbProbe = m_tbAdjudication
+			    && TablebaseProber::canProbe(m_board);
+		if (tbProbe)
+		{
+			if (m_tbProber == nullptr)
+			{
+				m_tbProber = new TablebaseProber(m_board->variant(), this);
+				connect(m_tbProber, SIGNAL(finished()),
+					this, SLOT(onTablebaseProbed()));
+			}
+			m_tbProber->probe(m_board);
+		}
 
 		m_adjudicator.addEval(m_board, sender->evaluation());
 		m_result = m_adjudicator.result();
+
+		// A tablebase result overrides the other adjudication rules
+		if (tbProbe && !m_result.isNone()
+		&&  m_tbProber->waitForResult(&tbResult)
+		&&  !tbResult.isNone())
+			m_result = tbResult;
 	}
 	m_board->undoMove();
 
@@ -609,12 +727,31 @@ void ChessGame::setOpeningBook(const OpeningBook* book,
 	{
 		m_book[side] = book;
 		m_bookDepth[side] = depth;
+		m_sharedBook[side].clear();
 	}
 }
 
+void ChessGame::setOpeningBook(const QSharedPointer<const OpeningBook>& book,
+			       Chess::Side side,
+			       int depth)
+{
+	setOpeningBook(book.data(), side, depth);
+	// The game keeps a reference to the book until it's destroyed
+	if (side.isNull())
+	{
+		m_sharedBook[Chess::Side::White] = book;
+		m_sharedBook[Chess::Side::Black] = book;
+	}
+	else
+		m_sharedBook[side] = book;
+}
+
 void ChessGame::setAdjudicator(const GameAdjudicator& adjudicator)
 {
+	// Tablebases are probed by the game, off its own thread
 	m_adjudicator = adjudicator;
+	m_tbAdjudication = adjudicator.tablebaseAdjudication();
+	m_adjudicator.setTablebaseAdjudication(false);
 }
 
 void ChessGame::generateOpening()
@@ -624,15 +761,20 @@ void ChessGame::generateOpening()
 	if (!resetBoard())
 		return;
 
-	// First play moves that are already in the opening
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (const Chess::Move& move, m_moves)
+	// First play moves that are already in the opening, or jump
+	// to the end of the opening if another game already did that
+	OpeningCache::Entry opening;
+	if (!cachedOpening(&opening) || !m_board->restore(opening.position))
 	{
-		Q_ASSERT(m_board->isLegalMove(move));
+		// TODO: use qAsConst() from Qt 5.7
+		foreach (const Chess::Move& move, m_moves)
+		{
+			Q_ASSERT(m_board->isLegalMove(move));
 
-		m_board->makeMove(move);
-		if (!m_board->result().isNone())
-			return;
+			m_board->makeMove(move);
+			if (!m_board->result().isNone())
+				return;
+		}
 	}
 
 	// Then play the opening book moves
@@ -666,6 +808,89 @@ void ChessGame::setBookOwnership(bool enabled)
 	m_bookOwnership = enabled;
 }
 
+void ChessGame::setLiveComments(bool enabled)
+{
+	m_liveComments = enabled;
+}
+
+void ChessGame::setGamePool(const QSharedPointer<GamePool>& pool)
+{
+	m_gamePool = pool;
+}
+
+void ChessGame::setOpeningCache(const QSharedPointer<OpeningCache>& cache,
+				 int index)
+{
+	m_openingCache = cache;
+	m_openingIndex = index;
+}
+
+bool ChessGame::cachedOpening(OpeningCache::Entry* entry) const
+{
+	if (m_openingCache.isNull() || m_moves.isEmpty())
+		return false;
+
+	// The index of an opening is only a hint: the game may have
+	// been given different moves, eg. from opening books
+	return m_openingCache->find(m_openingIndex, entry)
+	    && entry->startingFen == m_startingFen
+	    && entry->moves == m_moves;
+}
+
+void ChessGame::setTrainingData(bool enabled)
+{
+	m_trainingData = enabled;
+}
+
+const QVector<TrainingData::Position>& ChessGame::trainingData() const
+{
+	return m_trainingPositions;
+}
+
+void ChessGame::addTrainingPosition(const Chess::Move& move,
+				    const MoveEvaluation& eval)
+{
+	TrainingData::Position pos;
+	if (!TrainingData::packFen(m_board->fenString(), pos))
+	{
+		qWarning("Can't record training data of %s games",
+			 qPrintable(m_board->variant()));
+		m_trainingData = false;
+		m_trainingPositions.clear();
+		return;
+	}
+
+	if (eval.score() != MoveEvaluation::NULL_SCORE)
+		pos.score = eval.score();
+	pos.depth = eval.depth();
+	pos.move = TrainingData::packMove(m_board->genericMove(move));
+	if (eval.isBookEval())
+		pos.flags |= TrainingData::BookMove;
+
+	// The previous move's SAN tells if the side to move is in check
+	const auto& pgnMoves = m_pgn->moves();
+	if (!pgnMoves.isEmpty()
+	&&  (pgnMoves.last().moveString.endsWith('+')
+	||   pgnMoves.last().moveString.endsWith('#')))
+		pos.flags |= TrainingData::InCheck;
+	if (m_tbAdjudication && TablebaseProber::canProbe(m_board))
+		pos.flags |= TrainingData::TablebaseRange;
+
+	m_trainingPositions.append(pos);
+}
+
+void ChessGame::onTablebaseProbed()
+{
+	Chess::Result result;
+	if (!m_tbProber->takeResult(&result)
+	||  result.isNone()
+	||  m_finished)
+		return;
+
+	m_result = result;
+	stop();
+}
+
 void ChessGame::pauseThread()
 {
 	m_pauseSem.release();
@@ -760,11 +985,17 @@ void ChessGame::syncPlayers()
 
 void ChessGame::start()
 {
+	if (Tracer::isEnabled())
+		Tracer::begin("game", "setup", this, QString("%1 vs %2")
+			      .arg(m_player[Chess::Side::White]->name(),
+				   m_player[Chess::Side::Black]->name()));
+
+	// The start delay runs while the players get ready
 	if (m_startDelay > 0)
 	{
-		QTimer::singleShot(m_startDelay, this, SLOT(start()));
+		m_startDelayPending = true;
+		QTimer::singleShot(m_startDelay, this, SLOT(onStartDelayElapsed()));
 		m_startDelay = 0;
-		return;
 	}
 
 	for (int i = 0; i < 2; i++)
@@ -839,12 +1070,24 @@ void ChessGame::initializePgn()
 	m_pgn->setResultDescription(engineOptions);
 }
 
+void ChessGame::onStartDelayElapsed()
+{
+	m_startDelayPending = false;
+	if (m_playersSynced)
+		startGame();
+}
+
 void ChessGame::startGame()
 {
+	disconnect(this, SIGNAL(playersReady()), this, SLOT(startGame()));
+	m_playersSynced = true;
+	if (m_startDelayPending)
+		return;
+	Tracer::end("game", "setup", this);
+
 	m_result = Chess::Result();
 	emit humanEnabled(false);
 
-	disconnect(this, SIGNAL(playersReady()), this, SLOT(startGame()));
 	if (m_finished)
 		return;
 
@@ -874,7 +1117,10 @@ void ChessGame::startGame()
 	m_gameDuration = "";
 
 	emit started(this);
-	emit fenChanged(m_board->startingFenString());
+	static const QMetaMethod fenChangedSignal =
+		QMetaMethod::fromSignal(&ChessGame::fenChanged);
+	if (isSignalConnected(fenChangedSignal))
+		emit fenChanged(m_board->startingFenString());
 	QDateTime gameStartTime = QDateTime::currentDateTime();
 	m_pgn->setGameStartTime(gameStartTime);
 
@@ -885,28 +1131,55 @@ void ChessGame::startGame()
 		Q_ASSERT(m_timeControl[side].isValid());
 		m_player[side]->setTimeControl(m_timeControl[side]);
 		m_player[side]->newGame(side, m_player[side.opposite()], m_board);
+
+		// The engine may have played earlier games, so its usage
+		// is counted from here
+		m_usage[side] = ProcessUsage();
+		m_thinkingTime[side] = 0;
+		sampleUsage(side);
+		m_startUsage[side] = m_usage[side];
 	}
 
 	// Play the forced opening moves first
-	for (int i = 0; i < m_moves.size(); i++)
+	if (!m_moves.isEmpty())
 	{
-		Chess::Move move(m_moves.at(i));
-		Q_ASSERT(m_board->isLegalMove(move));
-		
-		addPgnMove(move, "book");
-
-		playerToMove()->makeBookMove(move);
-		playerToWait()->makeMove(move);
-		m_board->makeMove(move);
-		
-		emitLastMove();
+		TraceSpan span("game", "opening replay");
+		OpeningCache::Entry opening;
+		const bool cached = cachedOpening(&opening);
+		for (int i = 0; i < m_moves.size(); i++)
+		{
+			Chess::Move move(m_moves.at(i));
+			Q_ASSERT(m_board->isLegalMove(move));
+
+			if (cached)
+				addPgnMove(opening.pgnMoves.at(i));
+			else
+				addPgnMove(move, "book");
+
+			playerToMove()->makeBookMove(move);
+			playerToWait()->makeMove(move);
+			m_board->makeMove(move);
+
+			emitLastMove();
+
+			// A cached opening is known not to end the game
+			if (!cached && !m_board->result().isNone())
+			{
+				qDebug("Every move was played from the book");
+				m_result = m_board->result();
+				stop();
+				return;
+			}
+		}
 
-		if (!m_board->result().isNone())
+		if (!cached && !m_openingCache.isNull())
 		{
-			qDebug("Every move was played from the book");
-			m_result = m_board->result();
-			stop();
-			return;
+			const QVector<PgnGame::MoveData>& pgnMoves(m_pgn->moves());
+			opening.startingFen = m_startingFen;
+			opening.moves = m_moves;
+			opening.pgnMoves = pgnMoves.mid(pgnMoves.size() - m_moves.size());
+			opening.position = m_board->snapshot();
+			m_openingCache->insert(m_openingIndex, opening);
 		}
 	}
 	
@@ -21,18 +21,26 @@
 #include <QObject>
 #include <QVector>
 #include <QStringList>
-#include <QMap>
 #include <QSemaphore>
+#include <QSharedPointer>
 #include "pgngame.h"
 #include "board/result.h"
 #include "board/move.h"
 #include "timecontrol.h"
+#include "movetimestats.h"
+#include "trainingdata.h"
 #include "gameadjudicator.h"
+#include "processusage.h"
+#include "eventring.h"
+#include "memorystats.h"
+#include "openingcache.h"
 
 namespace Chess { class Board; }
 class ChessPlayer;
 class OpeningBook;
 class MoveEvaluation;
+class TablebaseProber;
+class GamePool;
 
 
 class LIB_EXPORT ChessGame : public QObject
@@ -40,6 +48,26 @@ class LIB_EXPORT ChessGame : public QObject
 	Q_OBJECT
 
 	public:
+		/*! A move that was added to the game's PGN. */
+		struct MoveEvent
+		{
+			int ply;		//!< The number of plies after the move
+			QString moveString;	//!< The move in SAN notation
+			QString comment;	//!< The move comment
+		};
+		/*!
+		 * The evaluation of a move.
+		 *
+		 * \sa scores()
+		 */
+		struct MoveScore
+		{
+			int score;	//!< The mover's score in centipawns
+			int depth;	//!< The search depth in plies
+			int time;	//!< The move time in milliseconds
+			quint64 nodes;	//!< The number of nodes searched
+		};
+
 		ChessGame(Chess::Board* board, PgnGame* pgn, QObject* parent = nullptr);
 		virtual ~ChessGame();
 		
@@ -55,7 +83,13 @@ class LIB_EXPORT ChessGame : public QObject
 		Chess::Board* board() const;
 		QString startingFen() const;
 		const QVector<Chess::Move>& moves() const;
-		const QMap<int,int>& scores() const;
+		/*!
+		 * Returns the evaluations of the moves, indexed by ply.
+		 *
+		 * Moves that weren't played by the players, eg. the
+		 * opening moves, have a score of MoveEvaluation::NULL_SCORE.
+		 */
+		const QVector<MoveScore>& scores() const;
 		Chess::Result result() const;
 
 		void setError(const QString& message);
@@ -68,9 +102,37 @@ class LIB_EXPORT ChessGame : public QObject
 		void setOpeningBook(const OpeningBook* book,
 				    Chess::Side side = Chess::Side(),
 				    int depth = 1000);
+		void setOpeningBook(const QSharedPointer<const OpeningBook>& book,
+				    Chess::Side side = Chess::Side(),
+				    int depth = 1000);
 		void setAdjudicator(const GameAdjudicator& adjudicator);
 		void setStartDelay(int time);
 		void setBookOwnership(bool enabled);
+		void setLiveComments(bool enabled);
+		/*!
+		 * Returns the board to \a pool instead of deleting it when
+		 * the game is destroyed.
+		 */
+		void setGamePool(const QSharedPointer<GamePool>& pool);
+		/*!
+		 * Uses \a cache to replay the opening moves, which are
+		 * the opening at \a index of the tournament.
+		 *
+		 * The first game of an opening stores its replay in the
+		 * cache; the following games with the same starting
+		 * position and moves reuse it.
+		 * \sa OpeningCache
+		 */
+		void setOpeningCache(const QSharedPointer<OpeningCache>& cache,
+				     int index);
+		/*!
+		 * If \a enabled is true, the position before every move
+		 * the players make is recorded for training data.
+		 *
+		 * The default is false.
+		 * \sa trainingData()
+		 */
+		void setTrainingData(bool enabled);
 
 		void generateOpening();
 
@@ -78,6 +140,49 @@ class LIB_EXPORT ChessGame : public QObject
 		void unlockThread();
 
 		QString gameDuration() const;
+		/*!
+		 * Returns the resource usage of the engine playing \a side
+		 * during the game, or a null snapshot if the player is
+		 * not an engine.
+		 */
+		ProcessUsage resourceUsage(Chess::Side side) const;
+		/*!
+		 * Returns the time in milliseconds that \a side spent
+		 * thinking on its moves.
+		 */
+		int thinkingTime(Chess::Side side) const;
+		/*!
+		 * Returns the number of moves \a side pondered on.
+		 *
+		 * \sa ChessPlayer::ponderedMoves()
+		 */
+		int ponderedMoves(Chess::Side side) const;
+		/*!
+		 * Returns the number of ponder hits \a side had.
+		 *
+		 * \sa ChessPlayer::ponderHits()
+		 */
+		int ponderHits(Chess::Side side) const;
+		/*! Returns the time usage statistics of \a side's moves. */
+		const MoveTimeStats& timeStats(Chess::Side side) const;
+		/*!
+		 * Returns the recorded training positions of the game.
+		 *
+		 * The positions don't have a result until the game is
+		 * finished, and it's up to the caller to set it.
+		 * \sa setTrainingData()
+		 */
+		const QVector<TrainingData::Position>& trainingData() const;
+		/*!
+		 * Returns the moves added to the PGN since the last call.
+		 *
+		 * The moves are queued only while the pgnMove() signal is
+		 * connected, and pgnMove() is emitted once for each batch
+		 * of moves, not once per move. This function must be
+		 * called from a single thread, typically the one the
+		 * pgnMove() slot runs in, and never blocks the game.
+		 */
+		QVector<MoveEvent> takeMoveEvents();
 
 	public slots:
 		void start();
@@ -86,6 +191,14 @@ class LIB_EXPORT ChessGame : public QObject
 		void stop(bool emitMoveChanged = true);
 		void kill();
 		void emitStartFailed();
+		/*!
+		 * Ends the game with \a result without starting it.
+		 *
+		 * This is for games whose result is already known, eg. from
+		 * a result cache. The players are never used, so they don't
+		 * have to be set. Emits finished().
+		 */
+		void finishWithResult(const Chess::Result& result);
 		void onMoveMade(const Chess::Move& move);
 		void onAdjudication(const Chess::Result& result);
 		void onResignation(const Chess::Result& result);
@@ -110,29 +223,42 @@ class LIB_EXPORT ChessGame : public QObject
 
 	private slots:
 		void startGame();
+		void onStartDelayElapsed();
 		void startTurn();
 		void finish();
 		void onResultClaim(const Chess::Result& result);
 		void onPlayerReady();
 		void syncPlayers();
 		void pauseThread();
+		void onTablebaseProbed();
 
 	private:
 		Chess::Move bookMove(Chess::Side side);
 		bool resetBoard();
 		void initializePgn();
-		void addPgnMove(const Chess::Move& move, const QString& comment);
+		void addPgnMove(const Chess::Move& move, const QString& comment,
+				const PgnGame::EvalData& eval = PgnGame::EvalData());
+		void addPgnMove(const PgnGame::MoveData& md);
+		bool cachedOpening(OpeningCache::Entry* entry) const;
 		void emitLastMove();
+		void addTrainingPosition(const Chess::Move& move,
+					 const MoveEvaluation& eval);
+		void sampleUsage(Chess::Side side);
+		void setUsageTags();
 
 		void startGameTimer();
 		int stopGameTimer();
 		
-		QString evalString(const MoveEvaluation& eval);
+		PgnGame::EvalData evalData(const MoveEvaluation& eval) const;
 
 		Chess::Board* m_board;
 		ChessPlayer* m_player[2];
 		TimeControl m_timeControl[2];
 		const OpeningBook* m_book[2];
+		QSharedPointer<const OpeningBook> m_sharedBook[2];
+		QSharedPointer<GamePool> m_gamePool;
+		QSharedPointer<OpeningCache> m_openingCache;
+		int m_openingIndex;
 		int m_bookDepth[2];
 		int m_startDelay;
 		bool m_finished;
@@ -141,18 +267,33 @@ class LIB_EXPORT ChessGame : public QObject
 		bool m_pgnInitialized;
 		bool m_bookOwnership;
 		bool m_boardShouldBeFlipped;
+		bool m_liveComments;
+		bool m_trainingData;
+		bool m_startDelayPending;
+		bool m_playersSynced;
 		QString m_error;
 		QString m_startingFen;
 		Chess::Result m_result;
 		QVector<Chess::Move> m_moves;
-		QMap<int,int> m_scores;
+		QVector<MoveScore> m_scores;
 		PgnGame* m_pgn;
 		QSemaphore m_pauseSem;
 		QSemaphore m_resumeSem;
 		GameAdjudicator m_adjudicator;
+		bool m_tbAdjudication;
+		TablebaseProber* m_tbProber;
 		int m_elapsed;
 		QElapsedTimer m_gameTimer;
 		QString m_gameDuration;
+		ProcessUsage m_startUsage[2];
+		ProcessUsage m_usage[2];
+		int m_thinkingTime[2];
+		int m_ponderedMoves[2];
+		int m_ponderHits[2];
+		MoveTimeStats m_timeStats[2];
+		QVector<TrainingData::Position> m_trainingPositions;
+		EventRing<MoveEvent> m_moveEvents;
+		MemoryAccount m_memory;
 };
 
 #endif // CHESSGAME_H
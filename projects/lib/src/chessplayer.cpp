@@ -16,26 +16,26 @@
 */
 
 #include "chessplayer.h"
-#include <QTimer>
 #include "board/board.h"
+#include "clockservice.h"
+#include "tracer.h"
 
 
 ChessPlayer::ChessPlayer(QObject* parent)
 	: QObject(parent),
 	  m_state(NotStarted),
-	  m_timer(new QTimer(this)),
+	  m_clockId(0),
 	  m_claimedResult(false),
 	  m_validateClaims(true),
 	  m_board(nullptr),
 	  m_opponent(nullptr),
 	  m_rating(0)
 {
-	m_timer->setSingleShot(true);
-	connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
 }
 
 ChessPlayer::~ChessPlayer()
 {
+	stopClock();
 }
 
 bool ChessPlayer::isReady() const
@@ -61,6 +61,7 @@ void ChessPlayer::newGame(Chess::Side side, ChessPlayer* opponent, Chess::Board*
 
 	m_claimedResult = false;
 	m_eval.clear();
+	m_timeStats = MoveTimeStats();
 	m_opponent = opponent;
 	m_board = board;
 	m_side = side;
@@ -77,9 +78,11 @@ void ChessPlayer::endGame(const Chess::Result& result)
 		return;
 
 	Q_ASSERT(m_state != Disconnected);
+	if (m_state == Thinking)
+		Tracer::end("player", "think", this);
 	setState(FinishingGame);
 	m_board = nullptr;
-	m_timer->stop();
+	stopClock();
 	disconnect(this, SIGNAL(ready()), this, SLOT(go()));
 }
 
@@ -98,6 +101,8 @@ void ChessPlayer::go()
 
 	Q_ASSERT(m_board != nullptr);
 	m_side = m_board->sideToMove();
+	if (Tracer::isEnabled())
+		Tracer::begin("player", "think", this, name());
 	
 	startClock();
 	startThinking();
@@ -126,13 +131,31 @@ void ChessPlayer::startClock()
 
 	m_timeControl.startTimer();
 
+	stopClock();
 	if (!m_timeControl.isInfinite())
 	{
+		// Give the player's last-moment move time to arrive
 		int t = m_timeControl.timeLeft() + m_timeControl.expiryMargin();
-		m_timer->start(qMax(t, 0) + 200);
+		t = qMax(t, 0) + latency() / 1000 + 1;
+		m_clockId = ClockService::instance()->startClock(
+			this, "onClockExpired", t);
 	}
 }
 
+void ChessPlayer::stopClock()
+{
+	if (m_clockId == 0)
+		return;
+	ClockService::instance()->cancelClock(m_clockId);
+	m_clockId = 0;
+}
+
+void ChessPlayer::restartClock()
+{
+	if (m_state == Thinking)
+		m_timeControl.startTimer();
+}
+
 void ChessPlayer::makeBookMove(const Chess::Move& move)
 {
 	m_timeControl.startTimer();
@@ -143,6 +166,11 @@ void ChessPlayer::makeBookMove(const Chess::Move& move)
 	emit moveMade(move);
 }
 
+const MoveTimeStats& ChessPlayer::timeStats() const
+{
+	return m_timeStats;
+}
+
 const TimeControl* ChessPlayer::timeControl() const
 {
 	return &m_timeControl;
@@ -153,6 +181,11 @@ void ChessPlayer::setTimeControl(const TimeControl& timeControl)
 	m_timeControl = timeControl;
 }
 
+int ChessPlayer::latency() const
+{
+	return 0;
+}
+
 Chess::Side ChessPlayer::side() const
 {
 	return m_side;
@@ -218,6 +251,16 @@ void ChessPlayer::clearPonderState()
 {
 }
 
+int ChessPlayer::ponderedMoves() const
+{
+	return 0;
+}
+
+int ChessPlayer::ponderHits() const
+{
+	return 0;
+}
+
 bool ChessPlayer::areClaimsValidated() const
 {
 	return m_validateClaims;
@@ -233,7 +276,7 @@ void ChessPlayer::claimResult(const Chess::Result& result)
 	if (m_claimedResult)
 		return;
 
-	m_timer->stop();
+	stopClock();
 	m_timeControl.update();
 	if (m_state == Thinking)
 		setState(Observing);
@@ -257,11 +300,18 @@ void ChessPlayer::emitMove(const Chess::Move& move)
 {
 	if (m_state == Thinking)
 		setState(Observing);
+	Tracer::end("player", "think", this);
 
-	m_timeControl.update();
+	// The engine's own search time is replaced by the measured time
+	const int clockTime = m_timeControl.timeLeft();
+	const int reportedTime = m_eval.time();
+	m_timeControl.update(true, latency());
 	m_eval.setTime(m_timeControl.lastMoveTime());
+	if (!m_timeControl.isInfinite())
+		m_timeStats.addMove(clockTime, m_timeControl.lastMoveTime(),
+				    reportedTime);
 
-	m_timer->stop();
+	stopClock();
 	if (m_timeControl.expired() && !canPlayAfterTimeout())
 	{
 		forfeit(Chess::Result::Timeout);
@@ -283,6 +333,16 @@ void ChessPlayer::onCrashed()
 	forfeit(Chess::Result::Disconnection);
 }
 
+void ChessPlayer::onClockExpired(int id)
+{
+	// The clock may have been restarted after it ran out
+	if (id != m_clockId)
+		return;
+
+	m_clockId = 0;
+	onTimeout();
+}
+
 void ChessPlayer::onTimeout()
 {
 	if (!canPlayAfterTimeout())
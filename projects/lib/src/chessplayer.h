@@ -25,7 +25,7 @@
 #include "board/move.h"
 #include "timecontrol.h"
 #include "moveevaluation.h"
-class QTimer;
+#include "movetimestats.h"
 namespace Chess { class Board; }
 
 
@@ -92,6 +92,11 @@ class LIB_EXPORT ChessPlayer : public QObject
 		
 		/*! Returns the player's evaluation of the current position. */
 		const MoveEvaluation& evaluation() const;
+		/*!
+		 * Returns the time usage statistics of the player's moves
+		 * in the current game. Book moves aren't counted.
+		 */
+		const MoveTimeStats& timeStats() const;
 
 		/*! Returns the player's time control. */
 		const TimeControl* timeControl() const;
@@ -99,6 +104,14 @@ class LIB_EXPORT ChessPlayer : public QObject
 		/*! Sets the time control for the player. */
 		void setTimeControl(const TimeControl& timeControl);
 
+		/*!
+		 * Returns the estimated round-trip time of the player's
+		 * connection in microseconds.
+		 *
+		 * The default implementation returns 0.
+		 */
+		virtual int latency() const;
+
 		/*! Returns the side of the player. */
 		Chess::Side side() const;
 
@@ -135,6 +148,20 @@ class LIB_EXPORT ChessPlayer : public QObject
 
 		/*! Clears the player's pondering state. */
 		virtual void clearPonderState();
+		/*!
+		 * Returns the number of the opponent's moves in the current
+		 * game that the player predicted a ponder move for.
+		 *
+		 * The default implementation returns 0.
+		 */
+		virtual int ponderedMoves() const;
+		/*!
+		 * Returns the number of pondered moves in the current game
+		 * where the opponent played the predicted move.
+		 *
+		 * The default implementation returns 0.
+		 */
+		virtual int ponderHits() const;
 
 		/*! Returns true if the player is human. */
 		virtual bool isHuman() const = 0;
@@ -233,6 +260,9 @@ class LIB_EXPORT ChessPlayer : public QObject
 		 */
 		virtual void onTimeout();
 
+	private slots:
+		void onClockExpired(int id);
+
 	protected:
 		/*! Returns the chessboard on which the player is playing. */
 		Chess::Board* board();
@@ -272,6 +302,14 @@ class LIB_EXPORT ChessPlayer : public QObject
 		 */
 		void emitMove(const Chess::Move& move);
 		
+		/*!
+		 * Restarts the chess clock if the player is thinking.
+		 *
+		 * Players that can't start thinking immediately when go()
+		 * is called can use this to avoid losing time.
+		 */
+		void restartClock();
+
 		/*! Returns the opposing player. */
 		const ChessPlayer* opponent() const;
 
@@ -289,17 +327,19 @@ class LIB_EXPORT ChessPlayer : public QObject
 
 	private:
 		void startClock();
+		void stopClock();
 
 		QString m_name;
 		State m_state;
 		TimeControl m_timeControl;
-		QTimer* m_timer;
+		int m_clockId;
 		bool m_claimedResult;
 		bool m_validateClaims;
 		Chess::Side m_side;
 		Chess::Board* m_board;
 		ChessPlayer* m_opponent;
 		int m_rating;
+		MoveTimeStats m_timeStats;
 };
 
 #endif // CHESSPLAYER_H
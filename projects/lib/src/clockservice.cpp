@@ -0,0 +1,145 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clockservice.h"
+#include <QMutexLocker>
+
+
+ClockService::ClockService()
+	: m_tick(0),
+	  m_lastId(0)
+{
+	m_time.start();
+}
+
+ClockService* ClockService::instance()
+{
+	static ClockService* service = []()
+	{
+		auto service = new ClockService;
+		service->start(QThread::TimeCriticalPriority);
+		return service;
+	}();
+
+	return service;
+}
+
+int ClockService::startClock(QObject* receiver, const char* method, int msecs)
+{
+	Q_ASSERT(receiver != nullptr);
+	Q_ASSERT(method != nullptr);
+
+	QMutexLocker locker(&m_mutex);
+
+	// An idle wheel isn't turned, so catch up with the clock first
+	if (m_slots.isEmpty())
+		m_tick = m_time.elapsed();
+
+	// Clock ids are positive and never 0
+	if (++m_lastId <= 0)
+		m_lastId = 1;
+
+	// The wheel turns one slot per millisecond; clocks further away
+	// than one revolution wait for a number of rounds
+	const qint64 expiry = qMax(m_time.elapsed() + qMax(msecs, 0),
+				   m_tick + 1);
+	const int slot = int(expiry % WheelSize);
+	const Clock clock = {
+		m_lastId,
+		int((expiry - m_tick - 1) / WheelSize),
+		receiver,
+		method
+	};
+	m_wheel[slot].append(clock);
+
+	const bool wasIdle = m_slots.isEmpty();
+	m_slots.insert(m_lastId, slot);
+	if (wasIdle)
+		m_wakeUp.wakeOne();
+
+	return m_lastId;
+}
+
+void ClockService::cancelClock(int id)
+{
+	QMutexLocker locker(&m_mutex);
+
+	auto it = m_slots.find(id);
+	if (it == m_slots.end())
+		return;
+	const int slot = it.value();
+	m_slots.erase(it);
+
+	QVector<Clock>& clocks = m_wheel[slot];
+	for (int i = 0; i < clocks.size(); i++)
+	{
+		if (clocks.at(i).id != id)
+			continue;
+		clocks[i] = clocks.last();
+		clocks.removeLast();
+		break;
+	}
+}
+
+void ClockService::advance(qint64 tick)
+{
+	while (m_tick < tick)
+	{
+		m_tick++;
+		QVector<Clock>& clocks = m_wheel[m_tick % WheelSize];
+
+		for (int i = 0; i < clocks.size(); )
+		{
+			Clock& clock = clocks[i];
+			if (clock.rounds > 0)
+			{
+				clock.rounds--;
+				i++;
+				continue;
+			}
+
+			// The mutex is held, so a cancelled clock's
+			// receiver can't be destroyed during the call
+			QMetaObject::invokeMethod(clock.receiver,
+						  clock.method,
+						  Qt::QueuedConnection,
+						  Q_ARG(int, clock.id));
+			m_slots.remove(clock.id);
+			clocks[i] = clocks.last();
+			clocks.removeLast();
+		}
+	}
+}
+
+void ClockService::run()
+{
+	QMutexLocker locker(&m_mutex);
+
+	forever
+	{
+		if (m_slots.isEmpty())
+		{
+			m_wakeUp.wait(&m_mutex);
+			continue;
+		}
+
+		advance(m_time.elapsed());
+
+		// Sleep until the next slot is due
+		m_wakeUp.wait(&m_mutex, 1);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLOCKSERVICE_H
+#define CLOCKSERVICE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QHash>
+
+
+/*!
+ * \brief A high-resolution timer thread for the players' clocks
+ *
+ * QTimer events are delivered by the game thread's event loop, so
+ * under load they can fire tens of milliseconds late, which is a lot
+ * in bullet games with tiny increments. ClockService keeps all the
+ * running clocks in a timing wheel with millisecond slots that's
+ * turned by a dedicated high-priority thread.
+ *
+ * When a clock runs out, the service invokes a slot of the clock's
+ * receiver with a queued connection. The slot takes the clock's id
+ * as its only argument, so a clock that was cancelled just as it ran
+ * out can be recognized and ignored.
+ *
+ * \sa ChessPlayer
+ */
+class LIB_EXPORT ClockService : public QThread
+{
+	Q_OBJECT
+
+	public:
+		/*! Returns the shared clock service, starting it if needed. */
+		static ClockService* instance();
+
+		/*!
+		 * Starts a clock that runs out after \a msecs milliseconds
+		 * and then invokes \a receiver's slot \a method, which has
+		 * the signature "method(int)".
+		 *
+		 * Returns the id of the clock, which is never 0.
+		 */
+		int startClock(QObject* receiver, const char* method, int msecs);
+		/*!
+		 * Cancels clock \a id. After this function returns the
+		 * clock's slot won't be invoked, unless the invocation was
+		 * already queued.
+		 */
+		void cancelClock(int id);
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		enum { WheelSize = 512 };
+
+		struct Clock
+		{
+			int id;
+			int rounds;
+			QObject* receiver;
+			const char* method;
+		};
+
+		ClockService();
+		void advance(qint64 tick);
+
+		QMutex m_mutex;
+		QWaitCondition m_wakeUp;
+		QElapsedTimer m_time;
+		qint64 m_tick;
+		int m_lastId;
+		QVector<Clock> m_wheel[WheelSize];
+		QHash<int, int> m_slots;
+};
+
+#endif // CLOCKSERVICE_H
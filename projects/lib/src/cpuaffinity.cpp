@@ -0,0 +1,251 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cpuaffinity.h"
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <sched.h>
+#endif
+
+namespace {
+
+CpuAffinity::CpuSet availableCpus()
+{
+	CpuAffinity::CpuSet cpus;
+
+#ifdef Q_OS_WIN
+	DWORD_PTR processMask = 0;
+	DWORD_PTR systemMask = 0;
+	if (GetProcessAffinityMask(GetCurrentProcess(),
+				   &processMask, &systemMask))
+	{
+		for (int i = 0; i < int(sizeof(DWORD_PTR) * 8); i++)
+		{
+			if (processMask & (DWORD_PTR(1) << i))
+				cpus << i;
+		}
+	}
+#elif defined(Q_OS_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+	{
+		for (int i = 0; i < CPU_SETSIZE; i++)
+		{
+			if (CPU_ISSET(i, &set))
+				cpus << i;
+		}
+	}
+#endif
+
+	if (cpus.isEmpty())
+	{
+		for (int i = 0; i < QThread::idealThreadCount(); i++)
+			cpus << i;
+	}
+
+	return cpus;
+}
+
+} // anonymous namespace
+
+bool CpuAffinity::isSupported()
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
+	return true;
+#else
+	return false;
+#endif
+}
+
+QList<CpuAffinity::CpuSet> CpuAffinity::nodes()
+{
+	const CpuSet available(availableCpus());
+	QList<CpuSet> nodes;
+
+#ifdef Q_OS_LINUX
+	const QDir dir("/sys/devices/system/node");
+	const QStringList names(dir.entryList(QStringList() << "node*",
+					      QDir::Dirs, QDir::Name));
+	for (const QString& name : names)
+	{
+		QFile file(dir.filePath(name + "/cpulist"));
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+			continue;
+
+		CpuSet node;
+		const CpuSet cpus(parse(QString::fromLatin1(file.readAll())
+					.trimmed()));
+		for (int cpu : cpus)
+		{
+			if (available.contains(cpu))
+				node << cpu;
+		}
+		if (!node.isEmpty())
+			nodes << node;
+	}
+
+	// The directory is sorted by name, so "node10" comes before "node2"
+	std::sort(nodes.begin(), nodes.end(),
+		  [](const CpuSet& a, const CpuSet& b)
+		  { return a.first() < b.first(); });
+#endif
+
+	if (nodes.isEmpty())
+		nodes << available;
+	return nodes;
+}
+
+QList<CpuAffinity::CpuSet> CpuAffinity::split(const QList<CpuSet>& nodes,
+					      int count)
+{
+	QList<CpuSet> sets;
+	if (count <= 0)
+		return sets;
+
+	int total = 0;
+	for (const CpuSet& node : nodes)
+		total += node.size();
+
+	// Use the largest set size that gives every slot its own CPUs
+	// without crossing node boundaries
+	for (int size = qMax(1, total / count); size >= 1; size--)
+	{
+		sets.clear();
+		for (const CpuSet& node : nodes)
+		{
+			for (int i = 0; i + size <= node.size(); i += size)
+				sets << node.mid(i, size);
+		}
+		if (sets.size() >= count)
+			break;
+	}
+
+	while (sets.size() > count)
+		sets.removeLast();
+	return sets;
+}
+
+CpuAffinity::CpuSet CpuAffinity::parse(const QString& str)
+{
+	CpuSet cpus;
+	const QStringList ranges(str.split(',', QString::SkipEmptyParts));
+
+	for (const QString& range : ranges)
+	{
+		const QStringList bounds(range.split('-'));
+		if (bounds.size() > 2)
+			return CpuSet();
+
+		bool ok1 = false;
+		bool ok2 = true;
+		const int first = bounds.at(0).toInt(&ok1);
+		const int last = bounds.size() == 2
+			? bounds.at(1).toInt(&ok2) : first;
+		if (!ok1 || !ok2 || first < 0 || last < first)
+			return CpuSet();
+
+		for (int cpu = first; cpu <= last; cpu++)
+		{
+			if (!cpus.contains(cpu))
+				cpus << cpu;
+		}
+	}
+
+	std::sort(cpus.begin(), cpus.end());
+	return cpus;
+}
+
+QString CpuAffinity::toString(const CpuSet& cpus)
+{
+	QStringList ranges;
+
+	int i = 0;
+	while (i < cpus.size())
+	{
+		int j = i;
+		while (j + 1 < cpus.size() && cpus.at(j + 1) == cpus.at(j) + 1)
+			j++;
+
+		if (j == i)
+			ranges << QString::number(cpus.at(i));
+		else
+			ranges << QString("%1-%2").arg(cpus.at(i)).arg(cpus.at(j));
+		i = j + 1;
+	}
+
+	return ranges.join(',');
+}
+
+bool CpuAffinity::setProcessAffinity(qint64 pid, const CpuSet& cpus)
+{
+	if (pid <= 0 || cpus.isEmpty())
+		return false;
+
+#ifdef Q_OS_WIN
+	DWORD_PTR mask = 0;
+	for (int cpu : cpus)
+	{
+		if (cpu < int(sizeof(DWORD_PTR) * 8))
+			mask |= DWORD_PTR(1) << cpu;
+	}
+	if (mask == 0)
+		return false;
+
+	HANDLE process = OpenProcess(PROCESS_SET_INFORMATION, FALSE,
+				     DWORD(pid));
+	if (process == NULL)
+		return false;
+	const bool ok = SetProcessAffinityMask(process, mask);
+	CloseHandle(process);
+
+	return ok;
+#elif defined(Q_OS_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus)
+	{
+		if (cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	}
+
+	// The affinity is per thread on Linux. New threads inherit it,
+	// but the engine may have started some threads already.
+	bool ok = sched_setaffinity(pid_t(pid), sizeof(set), &set) == 0;
+	const QDir taskDir(QString("/proc/%1/task").arg(pid));
+	const QStringList tasks(taskDir.entryList(QDir::Dirs
+						  | QDir::NoDotAndDotDot));
+	for (const QString& task : tasks)
+	{
+		const pid_t tid = pid_t(task.toLongLong());
+		if (tid > 0 && tid != pid_t(pid))
+			sched_setaffinity(tid, sizeof(set), &set);
+	}
+
+	return ok;
+#else
+	Q_UNUSED(pid);
+	Q_UNUSED(cpus);
+	return false;
+#endif
+}
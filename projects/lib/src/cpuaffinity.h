@@ -0,0 +1,87 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CPUAFFINITY_H
+#define CPUAFFINITY_H
+
+#include <QList>
+#include <QString>
+
+/*!
+ * \brief Functions for binding engine processes to CPUs.
+ *
+ * When many games are played concurrently, the scheduler of the
+ * operating system tends to move engine processes between cores and
+ * NUMA nodes. This makes the engines' speed uneven. CpuAffinity
+ * splits the available CPUs into disjoint sets, one for each game
+ * slot, and binds processes to them.
+ *
+ * CPUs are identified by their logical index, as in the output of
+ * \c taskset or the Windows task manager. Process affinity is
+ * supported on Linux and Windows. On Windows only the first 64 CPUs
+ * can be used.
+ */
+class LIB_EXPORT CpuAffinity
+{
+	public:
+		/*! A set of CPUs, in ascending order. */
+		typedef QList<int> CpuSet;
+
+		/*!
+		 * Returns true if process affinity can be set on this
+		 * platform.
+		 */
+		static bool isSupported();
+
+		/*!
+		 * Returns the CPUs this process may run on, grouped by
+		 * NUMA node.
+		 *
+		 * If the NUMA topology is unknown, all CPUs are returned
+		 * in a single group.
+		 */
+		static QList<CpuSet> nodes();
+
+		/*!
+		 * Splits the CPUs in \a nodes into \a count disjoint sets
+		 * of equal size.
+		 *
+		 * The sets don't cross node boundaries if that can be
+		 * avoided. If there are fewer CPUs than \a count, the
+		 * returned list is shorter and the sets have to be shared.
+		 */
+		static QList<CpuSet> split(const QList<CpuSet>& nodes, int count);
+
+		/*!
+		 * Parses a CPU list like "0-3,8,10-11" into a set.
+		 * Returns an empty set if \a str is not a valid list.
+		 */
+		static CpuSet parse(const QString& str);
+		/*! Returns \a cpus as a CPU list like "0-3,8,10-11". */
+		static QString toString(const CpuSet& cpus);
+
+		/*!
+		 * Binds all threads of the process \a pid to \a cpus.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool setProcessAffinity(qint64 pid, const CpuSet& cpus);
+
+	private:
+		CpuAffinity();
+};
+
+#endif // CPUAFFINITY_H
@@ -19,24 +19,42 @@
 #include <QStringList>
 #include <QFile>
 #include <QDataStream>
-#include <QMutex>
+#include <QMap>
+#include <QAtomicPointer>
+#include <algorithm>
 #include "pgngame.h"
 #include "pgnstream.h"
+#include "memorystats.h"
 
-namespace {
+/*
+ * The nodes of an ECO tree in one array. The root node is at index 0 and
+ * the children of every node are in a contiguous block, sorted by move.
+ */
+struct EcoNode::Table
+{
+	QStringList openings;
+	QVector<EcoNode> nodes;
 
-QStringList s_openings;
-EcoNode* s_root = nullptr;
+	void sortChildren(int first, int count);
+	qint64 memoryUsage() const;
 
-class EcoDeleter
-{
-	public:
-		~EcoDeleter()
+	// The table in use, published once and never modified
+	static QAtomicPointer<Table> instance;
+
+	struct Deleter
+	{
+		~Deleter()
 		{
-			delete s_root;
+			delete instance.loadAcquire();
 		}
+	};
+	static Deleter deleter;
 };
-EcoDeleter s_ecoDeleter;
+
+QAtomicPointer<EcoNode::Table> EcoNode::Table::instance;
+EcoNode::Table::Deleter EcoNode::Table::deleter;
+
+namespace {
 
 int ecoFromString(const QString& ecoString)
 {
@@ -54,57 +72,148 @@ int ecoFromString(const QString& ecoString)
 
 } // anonymous namespace
 
-QDataStream& operator<<(QDataStream& out, const EcoNode* node)
+void EcoNode::Table::sortChildren(int first, int count)
 {
-	if (!node)
-		return out;
-	out << node->m_ecoCode
-	    << node->m_opening
-	    << node->m_variation
-	    << node->m_children;
+	QVector<int> order(count);
+	for (int i = 0; i < count; i++)
+		order[i] = first + i;
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+	{
+		return nodes.at(a).m_move < nodes.at(b).m_move;
+	});
+
+	// Child offsets are relative to the node, so moving a node
+	// within the block must adjust its offset
+	QVector<EcoNode> sorted;
+	sorted.reserve(count);
+	for (int i = 0; i < count; i++)
+	{
+		sorted.append(nodes.at(order.at(i)));
+		sorted.last().m_childOffset += order.at(i) - (first + i);
+	}
+	std::copy(sorted.constBegin(), sorted.constEnd(),
+		  nodes.begin() + first);
+}
+
+const EcoNode::Table* EcoNode::table()
+{
+	return Table::instance.loadAcquire();
+}
 
-	return out;
+qint64 EcoNode::Table::memoryUsage() const
+{
+	// The opening names are shared by the nodes
+	qint64 bytes = nodes.capacity() * sizeof(EcoNode);
+	for (const EcoNode& node : nodes)
+	{
+		bytes += (node.m_move.capacity()
+			  + node.m_variation.capacity()) * sizeof(QChar);
+	}
+	for (const QString& opening : openings)
+		bytes += opening.capacity() * sizeof(QChar);
+	return bytes;
 }
 
-QDataStream& operator>>(QDataStream& in, EcoNode*& node)
+bool EcoNode::setTable(Table* table)
 {
-	node = new EcoNode;
+	if (!Table::instance.testAndSetOrdered(nullptr, table))
+	{
+		delete table;
+		return false;
+	}
+
+	// The table is kept until the process exits
+	MemoryStats::add(MemoryStats::EcoTree, table->memoryUsage());
+	return true;
+}
 
-	in >> node->m_ecoCode
-	   >> node->m_opening
-	   >> node->m_variation
-	   >> node->m_children;
+bool EcoNode::readNode(QDataStream& in, Table& table, int index)
+{
+	qint16 ecoCode;
+	qint32 opening;
+	QString variation;
+	quint32 count;
+
+	in >> ecoCode >> opening >> variation >> count;
+	if (in.status() != QDataStream::Ok
+	||  opening >= table.openings.size()
+	||  count > quint32(INT_MAX - table.nodes.size()))
+		return false;
+
+	const int first = table.nodes.size();
+	table.nodes.resize(first + int(count));
+
+	EcoNode& node = table.nodes[index];
+	node.m_ecoCode = ecoCode;
+	if (opening >= 0)
+		node.m_opening = table.openings.at(opening);
+	node.m_variation = variation;
+	node.m_childOffset = first - index;
+	node.m_childCount = int(count);
+
+	for (int i = first; i < first + int(count); i++)
+	{
+		in >> table.nodes[i].m_move;
+		if (!readNode(in, table, i))
+			return false;
+	}
+	table.sortChildren(first, int(count));
 
-	return in;
+	return true;
+}
+
+void EcoNode::writeNode(QDataStream& out,
+			const QHash<QString, int>& openings,
+			const EcoNode* node)
+{
+	out << node->m_ecoCode
+	    << qint32(openings.value(node->m_opening, -1))
+	    << node->m_variation
+	    << quint32(node->m_childCount);
+
+	// Same order as a serialized QMap
+	const EcoNode* children = node + node->m_childOffset;
+	for (int i = node->m_childCount - 1; i >= 0; i--)
+	{
+		out << children[i].m_move;
+		writeNode(out, openings, &children[i]);
+	}
 }
 
 void EcoNode::initialize()
 {
-	static QMutex mutex;
-	if (s_root)
+	if (table())
 		return;
 
-	mutex.lock();
-	if (!s_root)
-	{
-		Q_INIT_RESOURCE(eco);
+	Q_INIT_RESOURCE(eco);
+
+	Table* table = new Table;
+	table->nodes.resize(1);
 
-		QFile file(":/eco.bin");
-		if (!file.open(QIODevice::ReadOnly))
-			qWarning("Could not open ECO file");
-		else
+	QFile file(":/eco.bin");
+	if (!file.open(QIODevice::ReadOnly))
+		qWarning("Could not open ECO file");
+	else
+	{
+		QDataStream in(&file);
+		in.setVersion(QDataStream::Qt_4_6);
+		in >> table->openings;
+		if (!readNode(in, *table, 0))
 		{
-			QDataStream in(&file);
-			in.setVersion(QDataStream::Qt_4_6);
-			in >> s_openings >> s_root;
+			qWarning("Invalid ECO file");
+			table->nodes.resize(1);
+			table->nodes[0] = EcoNode();
 		}
 	}
-	mutex.unlock();
+
+	table->nodes.squeeze();
+	table->openings.clear();
+	setTable(table);
 }
 
 void EcoNode::initialize(PgnStream& in)
 {
-	if (s_root)
+	if (table())
 		return;
 
 	if (!in.isOpen())
@@ -113,65 +222,88 @@ void EcoNode::initialize(PgnStream& in)
 		return;
 	}
 
-	s_root = new EcoNode;
-	EcoNode* current = s_root;
-	QMap<QString, int> tmpOpenings;
+	// Build a temporary tree of node indexes, then lay it out so that
+	// each node's children are next to each other
+	struct TmpNode
+	{
+		EcoNode node;
+		QMap<QString, int> children;
+	};
+	QVector<TmpNode> tmp(1);
 
 	PgnGame game;
 	while (game.read(in, INT_MAX - 1, false))
 	{
-		current = s_root;
+		int current = 0;
 		for (const PgnGame::MoveData& move : game.moves())
 		{
-			QString san = move.moveString;
-			EcoNode* node = current->child(san);
-			if (node == nullptr)
+			int child = tmp.at(current).children.value(
+				move.moveString, -1);
+			if (child == -1)
 			{
-				node = new EcoNode;
-				current->addChild(san, node);
+				child = tmp.size();
+				tmp.append(TmpNode());
+				tmp[child].node.m_move = move.moveString;
+				tmp[current].children[move.moveString] = child;
 			}
-			current = node;
+			current = child;
 		}
-		if (current == s_root)
+		if (current == 0)
 			continue;
 
-		current->m_ecoCode = ecoFromString(game.tagValue("ECO"));
+		EcoNode& node = tmp[current].node;
+		node.m_ecoCode = ecoFromString(game.tagValue("ECO"));
+		node.m_opening = game.tagValue("Opening");
+		node.m_variation = game.tagValue("Variation");
+	}
+
+	Table* table = new Table;
+	table->nodes.reserve(tmp.size());
+	table->nodes.append(tmp.at(0).node);
+	QVector<int> sources(1, 0);
+
+	// Breadth-first, so each block of siblings is appended at once
+	for (int i = 0; i < sources.size(); i++)
+	{
+		const QMap<QString, int>& children =
+			tmp.at(sources.at(i)).children;
+		EcoNode& node = table->nodes[i];
+		node.m_childOffset = table->nodes.size() - i;
+		node.m_childCount = children.size();
 
-		QString val = game.tagValue("Opening");
-		if (!val.isEmpty())
+		for (auto it = children.constBegin(); it != children.constEnd(); ++it)
 		{
-			int index = tmpOpenings.value(val, -1);
-			if (index == -1)
-			{
-				index = tmpOpenings.count();
-				tmpOpenings[val] = index;
-				s_openings.append(val);
-			}
-			current->m_opening = index;
+			table->nodes.append(tmp.at(it.value()).node);
+			sources.append(it.value());
 		}
-
-		current->m_variation = game.tagValue("Variation");
 	}
+
+	setTable(table);
 }
 
 const EcoNode* EcoNode::root()
 {
-	if (!s_root)
+	const Table* t = table();
+	if (!t)
+	{
 		initialize();
-	return s_root;
+		t = table();
+	}
+	return t->nodes.constData();
 }
 
 const EcoNode* EcoNode::find(const QVector<PgnGame::MoveData>& moves)
 {
-	if (!s_root)
+	const Table* t = table();
+	if (!t)
 		return nullptr;
 
-	EcoNode* current = s_root;
-	EcoNode* valid = nullptr;
+	const EcoNode* current = t->nodes.constData();
+	const EcoNode* valid = nullptr;
 
 	for (const PgnGame::MoveData& move : moves)
 	{
-		EcoNode* node = current->child(move.moveString);
+		const EcoNode* node = current->child(move.moveString);
 		if (node == nullptr)
 			return valid;
 		if (!node->opening().isEmpty())
@@ -184,7 +316,8 @@ const EcoNode* EcoNode::find(const QVector<PgnGame::MoveData>& moves)
 
 void EcoNode::write(const QString& fileName)
 {
-	if (!s_root)
+	const Table* t = table();
+	if (!t)
 		return;
 
 	QFile file(fileName);
@@ -194,22 +327,30 @@ void EcoNode::write(const QString& fileName)
 		return;
 	}
 
+	QStringList openingList;
+	QHash<QString, int> openings;
+	for (const EcoNode& node : t->nodes)
+	{
+		if (!node.m_opening.isEmpty() && !openings.contains(node.m_opening))
+		{
+			openings[node.m_opening] = openingList.size();
+			openingList.append(node.m_opening);
+		}
+	}
+
 	QDataStream out(&file);
 	out.setVersion(QDataStream::Qt_4_6);
-	out << s_openings << s_root;
+	out << openingList;
+	writeNode(out, openings, t->nodes.constData());
 }
 
 EcoNode::EcoNode()
 	: m_ecoCode(-1),
-	  m_opening(-1)
+	  m_childOffset(0),
+	  m_childCount(0)
 {
 }
 
-EcoNode::~EcoNode()
-{
-	qDeleteAll(m_children.values());
-}
-
 bool EcoNode::isLeaf() const
 {
 	return m_ecoCode != -1;
@@ -226,7 +367,7 @@ QString EcoNode::ecoCode() const
 
 QString EcoNode::opening() const
 {
-	return m_opening >= 0 ? s_openings[m_opening] : QString();
+	return m_opening;
 }
 
 QString EcoNode::variation() const
@@ -234,12 +375,17 @@ QString EcoNode::variation() const
 	return m_variation;
 }
 
-EcoNode* EcoNode::child(const QString& sanMove) const
+const EcoNode* EcoNode::child(const QString& sanMove) const
 {
-	return m_children.value(sanMove);
-}
+	const EcoNode* first = this + m_childOffset;
+	const EcoNode* last = first + m_childCount;
+	const EcoNode* it = std::lower_bound(first, last, sanMove,
+		[](const EcoNode& node, const QString& move)
+	{
+		return node.m_move < move;
+	});
 
-void EcoNode::addChild(const QString& sanMove, EcoNode* child)
-{
-	m_children[sanMove] = child;
+	if (it != last && it->m_move == sanMove)
+		return it;
+	return nullptr;
 }
@@ -19,7 +19,8 @@
 #define ECONODE_H
 
 #include <QString>
-#include <QMap>
+#include <QVector>
+#include <QHash>
 #include "pgngame.h"
 class QDataStream;
 class PgnStream;
@@ -36,14 +37,19 @@ class PgnStream;
  * to a PgnGame can be found by traversing the ECO tree as new moves are added
  * to the game, or by passing all the moves at once to the find() function.
  *
+ * The tree is stored as one flat array where the children of each node are
+ * sorted by move and kept next to each other, so finding a child is a binary
+ * search over a small contiguous block. Once initialized the tree is never
+ * modified, and it can be queried from any thread without locking.
+ *
  * \note The Encyclopaedia of Chess Openings only applies to games of standard
  * chess that start from the default starting position.
  */
 class LIB_EXPORT EcoNode
 {
 	public:
-		/*! Destroys the node and its subtree. */
-		~EcoNode();
+		/*! Creates a new inner node with no children. */
+		EcoNode();
 
 		/*!
 		 * Returns true if the node is a leaf node; otherwise returns false.
@@ -55,7 +61,7 @@ class LIB_EXPORT EcoNode
 		 * Returns the node's child node corresponding to \a sanMove, or 0
 		 * if no match is found.
 		 */
-		EcoNode* child(const QString& sanMove) const;
+		const EcoNode* child(const QString& sanMove) const;
 		/*!
 		 * Returns the node's ECO code, or an empty string if the node is
 		 * an inner node.
@@ -74,7 +80,10 @@ class LIB_EXPORT EcoNode
 
 		/*! Initializes the ECO tree from the internal opening database. */
 		static void initialize();
-		/*! Initializes the ECO tree by parsing the PGN games in \a in. */
+		/*!
+		 * Initializes the ECO tree by parsing the PGN games in \a in.
+		 * Does nothing if the tree is already initialized.
+		 */
 		static void initialize(PgnStream& in);
 		/*!
 		 * Returns the root node of the ECO tree.
@@ -90,25 +99,23 @@ class LIB_EXPORT EcoNode
 		static void write(const QString& fileName);
 
 	private:
-		friend LIB_EXPORT QDataStream& operator<<(QDataStream& out, const EcoNode* node);
-		friend LIB_EXPORT QDataStream& operator>>(QDataStream& in, EcoNode*& node);
+		struct Table;
 
-		EcoNode();
-		void addChild(const QString& sanMove, EcoNode* child);
+		static const Table* table();
+		static bool setTable(Table* table);
+		static bool readNode(QDataStream& in, Table& table, int index);
+		static void writeNode(QDataStream& out,
+				      const QHash<QString, int>& openings,
+				      const EcoNode* node);
 
-		qint16 m_ecoCode;
-		qint32 m_opening;
+		QString m_move;
+		QString m_opening;
 		QString m_variation;
-
-		QMap<QString, EcoNode*> m_children;
+		qint16 m_ecoCode;
+		int m_childOffset;
+		int m_childCount;
 };
 
-/*! Writes the node \a node to stream \a out. */
-extern LIB_EXPORT QDataStream& operator<<(QDataStream& out, const EcoNode* node);
-/*!
- * Reads a node from stream \a in into \a node.
- * \a node should be a null or uninitialized pointer.
- */
-extern LIB_EXPORT QDataStream& operator>>(QDataStream& in, EcoNode*& node);
+Q_DECLARE_TYPEINFO(EcoNode, Q_MOVABLE_TYPE);
 
 #endif // ECONODE_H
@@ -17,9 +17,62 @@
 
 #include "enginebuilder.h"
 #include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QTcpSocket>
+#include <QMutex>
+#include <QHash>
+#include <algorithm>
 #include "engineprocess.h"
 #include "enginefactory.h"
 
+namespace {
+
+// The number of engines connected to each remote node, shared by all
+// builders because several engines may use the same nodes
+QMutex s_remoteLoadMutex;
+QHash<QString, int> s_remoteLoad;
+
+void addRemoteLoad(const QString& address, int amount)
+{
+	QMutexLocker locker(&s_remoteLoadMutex);
+	s_remoteLoad[address] += amount;
+}
+
+QStringList remoteNodesByLoad(const QString& addresses)
+{
+	QStringList nodes;
+	for (const QString& node : addresses.split(',', QString::SkipEmptyParts))
+		nodes << node.trimmed();
+
+	// The least loaded node first, in their given order otherwise
+	QMutexLocker locker(&s_remoteLoadMutex);
+	std::stable_sort(nodes.begin(), nodes.end(),
+		[](const QString& a, const QString& b)
+	{
+		return s_remoteLoad.value(a) < s_remoteLoad.value(b);
+	});
+
+	return nodes;
+}
+
+// Several engines may share the same stderr file
+QMutex s_stderrFileMutex;
+
+void rotateStderrFile(const QString& fileName, qint64 maxSize)
+{
+	QMutexLocker locker(&s_stderrFileMutex);
+	if (maxSize <= 0 || QFileInfo(fileName).size() < maxSize)
+		return;
+
+	const QString oldFileName(fileName + ".1");
+	QFile::remove(oldFileName);
+	if (!QFile::rename(fileName, oldFileName))
+		qWarning("Cannot rotate stderr file %s", qPrintable(fileName));
+}
+
+} // anonymous namespace
+
 
 EngineBuilder::EngineBuilder(const EngineConfiguration& config)
 	: PlayerBuilder(config.name()),
@@ -34,6 +87,16 @@ void EngineBuilder::setConfiguration(const EngineConfiguration& config)
 	setRating(config.rating());
 }
 
+EngineConfiguration EngineBuilder::configuration() const
+{
+	return m_config;
+}
+
+void EngineBuilder::setDebugLogDirectory(const QString& dir)
+{
+	m_debugLogDir = dir;
+}
+
 bool EngineBuilder::isHuman() const
 {
 	return false;
@@ -43,6 +106,36 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 				   const char* method,
 				   QObject* parent,
 				   QString* error) const
+{
+	if (!EngineFactory::protocols().contains(m_config.protocol()))
+	{
+		setError(error, tr("Unknown chess protocol: %1")
+			 .arg(m_config.protocol()));
+		return nullptr;
+	}
+
+	QIODevice* device = m_config.remoteAddress().isEmpty()
+		? startProcess(error) : connectToRemote(error);
+	if (device == nullptr)
+		return nullptr;
+
+	ChessEngine* engine = EngineFactory::create(m_config.protocol());
+	Q_ASSERT(engine != nullptr);
+
+	engine->setParent(parent);
+	if (receiver != nullptr && method != nullptr)
+		QObject::connect(engine, SIGNAL(debugMessage(QString)),
+				 receiver, method);
+	engine->setDevice(device);
+	engine->applyConfiguration(m_config);
+	if (!m_debugLogDir.isEmpty())
+		engine->setDebugLogDirectory(m_debugLogDir);
+
+	engine->start();
+	return engine;
+}
+
+QIODevice* EngineBuilder::startProcess(QString* error) const
 {
 	QString workDir = m_config.workingDirectory();
 	QString cmd = m_config.command().trimmed();
@@ -54,13 +147,6 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 		return nullptr;
 	}
 
-	if (!EngineFactory::protocols().contains(m_config.protocol()))
-	{
-		setError(error, tr("Unknown chess protocol: %1")
-			 .arg(m_config.protocol()));
-		return nullptr;
-	}
-
 	EngineProcess* process = new EngineProcess();
 
 	if (workDir.isEmpty())
@@ -74,8 +160,18 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 	else
 		process->setWorkingDirectory(workDir);
 
+	// The engine writes its stderr straight to the file. Nothing
+	// reads the stderr pipe, so without a file the output is
+	// discarded instead of filling the pipe and blocking the engine.
 	if (!stderrFile.isEmpty())
+	{
+		rotateStderrFile(stderrFile, m_config.stderrMaxSize());
 		process->setStandardErrorFile(stderrFile, QIODevice::Append);
+	}
+#ifndef Q_OS_WIN32
+	else
+		process->setStandardErrorFile(QProcess::nullDevice());
+#endif
 
 	if (!m_config.arguments().isEmpty())
 		process->start(cmd, m_config.arguments());
@@ -91,18 +187,76 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 		return nullptr;
 	}
 
-	ChessEngine* engine = EngineFactory::create(m_config.protocol());
-	Q_ASSERT(engine != nullptr);
+	return process;
+}
 
-	engine->setParent(parent);
-	if (receiver != nullptr && method != nullptr)
-		QObject::connect(engine, SIGNAL(debugMessage(QString)),
-				 receiver, method);
-	engine->setDevice(process);
-	engine->applyConfiguration(m_config);
+QIODevice* EngineBuilder::connectToRemote(QString* error) const
+{
+	// Try the nodes until one of them accepts the connection, so
+	// that a node that's down only costs a failed connection
+	QString errors;
+	const QStringList nodes = remoteNodesByLoad(m_config.remoteAddress());
+	for (const QString& node : nodes)
+	{
+		QString nodeError;
+		QTcpSocket* socket = connectToNode(node, &nodeError);
+		if (socket != nullptr)
+		{
+			addRemoteLoad(node, 1);
+			QObject::connect(socket, &QObject::destroyed, [node]()
+			{
+				addRemoteLoad(node, -1);
+			});
+			return socket;
+		}
 
-	engine->start();
-	return engine;
+		if (!errors.isEmpty())
+			errors += '\n';
+		errors += nodeError;
+	}
+
+	if (nodes.isEmpty())
+		errors = tr("Invalid remote address: %1")
+			 .arg(m_config.remoteAddress());
+	setError(error, errors);
+	return nullptr;
+}
+
+QTcpSocket* EngineBuilder::connectToNode(const QString& address,
+					 QString* error) const
+{
+	const int sep = address.lastIndexOf(':');
+	bool ok = false;
+	const quint16 port = address.mid(sep + 1).toUShort(&ok);
+
+	// IPv6 addresses are written in brackets, eg. "[::1]:5000"
+	QString host = address.left(sep);
+	if (host.startsWith('[') && host.endsWith(']'))
+		host = host.mid(1, host.size() - 2);
+
+	if (sep <= 0 || !ok || port == 0 || host.isEmpty())
+	{
+		*error = tr("Invalid remote address: %1").arg(address);
+		return nullptr;
+	}
+
+	QTcpSocket* socket = new QTcpSocket();
+	socket->connectToHost(host, port);
+
+	if (!socket->waitForConnected(10000))
+	{
+		*error = tr("Cannot connect to %1: %2")
+			 .arg(address).arg(socket->errorString());
+		delete socket;
+		return nullptr;
+	}
+
+	// Engine commands are short lines that must not wait for more
+	// data to fill a packet
+	socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+
+	return socket;
 }
 
 void EngineBuilder::setError(QString* error, const QString& message) const
@@ -21,9 +21,18 @@
 #include "playerbuilder.h"
 #include <QCoreApplication>
 #include "engineconfiguration.h"
+class QIODevice;
+class QTcpSocket;
 
-
-/*! \brief A class for constructing local chess engines. */
+/*!
+ * \brief A class for constructing chess engines.
+ *
+ * The engine is started as a local process, or reached over TCP if
+ * its configuration has a remote address. When several remote nodes
+ * are given, each new engine connects to the node that serves the
+ * fewest engines at the moment, so that the games of a tournament are
+ * spread over all of them.
+ */
 class LIB_EXPORT EngineBuilder : public PlayerBuilder
 {
 	Q_DECLARE_TR_FUNCTIONS(EngineBuilder)
@@ -34,6 +43,15 @@ class LIB_EXPORT EngineBuilder : public PlayerBuilder
 
 		/* ! Sets a new engine configuration. */
 		void setConfiguration(const EngineConfiguration& config);
+		/*! Returns the engine configuration. */
+		EngineConfiguration configuration() const;
+		/*!
+		 * Makes the engines write their debug messages to log files
+		 * in directory \a dir.
+		 *
+		 * \sa ChessEngine::setDebugLogDirectory()
+		 */
+		void setDebugLogDirectory(const QString& dir);
 
 		// Inherited from PlayerBuilder
 		virtual bool isHuman() const;
@@ -43,9 +61,14 @@ class LIB_EXPORT EngineBuilder : public PlayerBuilder
 					    QString* error) const;
 
 	private:
+		QIODevice* startProcess(QString* error) const;
+		QIODevice* connectToRemote(QString* error) const;
+		QTcpSocket* connectToNode(const QString& address,
+					  QString* error) const;
 		void setError(QString* error, const QString& message) const;
 
 		EngineConfiguration m_config;
+		QString m_debugLogDir;
 };
 
 #endif // ENGINEBUILDER_H
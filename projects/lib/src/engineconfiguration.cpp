@@ -16,18 +16,25 @@
 */
 
 #include "engineconfiguration.h"
+#include <QDir>
+#include <QFileInfo>
 #include <QSet>
+#include <QStandardPaths>
 #include "engineoption.h"
 #include "enginetextoption.h"
 #include "engineoptionfactory.h"
 
 EngineConfiguration::EngineConfiguration()
-	: m_variants(QStringList() << "standard"),
+	: m_stderrMaxSize(0),
+	  m_variants(QStringList() << "standard"),
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
+	  m_compactPositions(false),
 	  m_validateClaims(true),
 	  m_restartMode(RestartAuto),
-	  m_rating(0)
+	  m_rating(0),
+	  m_thinkingInterval(0),
+	  m_stopTimeout(0)
 {
 }
 
@@ -36,23 +43,31 @@ EngineConfiguration::EngineConfiguration(const QString& name,
 					 const QString& protocol)
 	: m_name(name),
 	  m_command(command),
+	  m_stderrMaxSize(0),
 	  m_protocol(protocol),
 	  m_variants(QStringList() << "standard"),
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
+	  m_compactPositions(false),
 	  m_validateClaims(true),
 	  m_restartMode(RestartAuto),
-	  m_rating(0)
+	  m_rating(0),
+	  m_thinkingInterval(0),
+	  m_stopTimeout(0)
 {
 }
 
 EngineConfiguration::EngineConfiguration(const QVariant& variant)
-	: m_variants(QStringList() << "standard"),
+	: m_stderrMaxSize(0),
+	  m_variants(QStringList() << "standard"),
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
+	  m_compactPositions(false),
 	  m_validateClaims(true),
 	  m_restartMode(RestartAuto),
-	  m_rating(0)
+	  m_rating(0),
+	  m_thinkingInterval(0),
+	  m_stopTimeout(0)
 {
 	const QVariantMap map = variant.toMap();
 
@@ -60,6 +75,8 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 	setCommand(map["command"].toString());
 	setWorkingDirectory(map["workingDirectory"].toString());
 	setStderrFile(map["stderrFile"].toString());
+	setStderrMaxSize(map["stderrMaxSize"].toLongLong());
+	setRemoteAddress(map["remote"].toString());
 	setProtocol(map["protocol"].toString());
 
 	if (map.contains("initStrings"))
@@ -68,6 +85,8 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 		setWhiteEvalPov(map["whitepov"].toBool());
 	if (map.contains("ponder"))
 		setPondering(map["ponder"].toBool());
+	if (map.contains("compactPositions"))
+		setCompactPositions(map["compactPositions"].toBool());
 
 	if (map.contains("restart"))
 	{
@@ -100,6 +119,12 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 
 	if (map.contains("rating"))
 		setRating(map["rating"].toInt());
+
+	if (map.contains("thinkingInterval"))
+		setThinkingInterval(map["thinkingInterval"].toInt());
+
+	if (map.contains("stopTimeout"))
+		setStopTimeout(map["stopTimeout"].toInt());
 }
 
 EngineConfiguration::EngineConfiguration(const EngineConfiguration& other)
@@ -107,15 +132,20 @@ EngineConfiguration::EngineConfiguration(const EngineConfiguration& other)
 	  m_command(other.m_command),
 	  m_workingDirectory(other.m_workingDirectory),
 	  m_stderrFile(other.m_stderrFile),
+	  m_stderrMaxSize(other.m_stderrMaxSize),
+	  m_remoteAddress(other.m_remoteAddress),
 	  m_protocol(other.m_protocol),
 	  m_arguments(other.m_arguments),
 	  m_initStrings(other.m_initStrings),
 	  m_variants(other.m_variants),
 	  m_whiteEvalPov(other.m_whiteEvalPov),
 	  m_pondering(other.m_pondering),
+	  m_compactPositions(other.m_compactPositions),
 	  m_validateClaims(other.m_validateClaims),
 	  m_restartMode(other.m_restartMode),
-	  m_rating(other.m_rating)
+	  m_rating(other.m_rating),
+	  m_thinkingInterval(other.m_thinkingInterval),
+	  m_stopTimeout(other.m_stopTimeout)
 {
 	const auto options = other.options();
 	for (const EngineOption* option : options)
@@ -133,16 +163,21 @@ EngineConfiguration& EngineConfiguration::operator=(EngineConfiguration&& other)
 	m_command = other.m_command;
 	m_workingDirectory = other.m_workingDirectory;
 	m_stderrFile = other.m_stderrFile;
+	m_stderrMaxSize = other.m_stderrMaxSize;
+	m_remoteAddress = other.m_remoteAddress;
 	m_protocol = other.m_protocol;
 	m_arguments = other.m_arguments;
 	m_initStrings = other.m_initStrings;
 	m_variants = other.m_variants;
 	m_whiteEvalPov = other.m_whiteEvalPov;
 	m_pondering = other.m_pondering;
+	m_compactPositions = other.m_compactPositions;
 	m_validateClaims = other.m_validateClaims;
 	m_restartMode = other.m_restartMode;
 	m_options = other.m_options;
 	m_rating = other.m_rating;
+	m_thinkingInterval = other.m_thinkingInterval;
+	m_stopTimeout = other.m_stopTimeout;
 
 	// other's destructor will cause a mess if its m_options isn't cleared
 	other.m_options.clear();
@@ -162,6 +197,10 @@ QVariant EngineConfiguration::toVariant() const
 	map.insert("command", m_command);
 	map.insert("workingDirectory", m_workingDirectory);
 	map.insert("stderrFile", m_stderrFile);
+	if (m_stderrMaxSize)
+		map.insert("stderrMaxSize", m_stderrMaxSize);
+	if (!m_remoteAddress.isEmpty())
+		map.insert("remote", m_remoteAddress);
 	map.insert("protocol", m_protocol);
 
 	if (!m_initStrings.isEmpty())
@@ -170,6 +209,8 @@ QVariant EngineConfiguration::toVariant() const
 		map.insert("whitepov", true);
 	if (m_pondering)
 		map.insert("ponder", true);
+	if (m_compactPositions)
+		map.insert("compactPositions", true);
 
 	if (m_restartMode == RestartOn)
 		map.insert("restart", "on");
@@ -195,6 +236,11 @@ QVariant EngineConfiguration::toVariant() const
 	if (m_rating)
 		map.insert("rating", m_rating);
 
+	if (m_thinkingInterval)
+		map.insert("thinkingInterval", m_thinkingInterval);
+	if (m_stopTimeout)
+		map.insert("stopTimeout", m_stopTimeout);
+
 	return map;
 }
 
@@ -223,6 +269,11 @@ void EngineConfiguration::setStderrFile(const QString& fileName)
 	m_stderrFile = fileName;
 }
 
+void EngineConfiguration::setStderrMaxSize(qint64 bytes)
+{
+	m_stderrMaxSize = qMax(Q_INT64_C(0), bytes);
+}
+
 void EngineConfiguration::setRating(const int rating)
 {
 	m_rating = rating > 0 ? rating : 0;
@@ -238,6 +289,28 @@ QString EngineConfiguration::command() const
 	return m_command;
 }
 
+QString EngineConfiguration::executablePath() const
+{
+	const QString cmd(m_command.trimmed());
+	const QDir dir(m_workingDirectory.isEmpty()
+		       ? QDir::currentPath() : m_workingDirectory);
+
+	QFileInfo info(dir, cmd);
+	if (info.isFile())
+		return info.absoluteFilePath();
+	if (!m_arguments.isEmpty())
+		return QString();
+
+	QString program(cmd.section(' ', 0, 0));
+	if (cmd.startsWith('"'))
+		program = cmd.section('"', 1, 1);
+	info = QFileInfo(dir, program);
+	if (info.isFile())
+		return info.absoluteFilePath();
+
+	return QStandardPaths::findExecutable(program);
+}
+
 QString EngineConfiguration::workingDirectory() const
 {
 	return m_workingDirectory;
@@ -248,6 +321,11 @@ QString EngineConfiguration::stderrFile() const
 	return m_stderrFile;
 }
 
+qint64 EngineConfiguration::stderrMaxSize() const
+{
+	return m_stderrMaxSize;
+}
+
 QString EngineConfiguration::protocol() const
 {
 	return m_protocol;
@@ -364,6 +442,16 @@ void EngineConfiguration::setPondering(bool enabled)
 	m_pondering = enabled;
 }
 
+bool EngineConfiguration::compactPositions() const
+{
+	return m_compactPositions;
+}
+
+void EngineConfiguration::setCompactPositions(bool enabled)
+{
+	m_compactPositions = enabled;
+}
+
 EngineConfiguration::RestartMode EngineConfiguration::restartMode() const
 {
 	return m_restartMode;
@@ -384,6 +472,36 @@ void EngineConfiguration::setClaimsValidated(bool validate)
 	m_validateClaims = validate;
 }
 
+int EngineConfiguration::thinkingInterval() const
+{
+	return m_thinkingInterval;
+}
+
+void EngineConfiguration::setThinkingInterval(int msecs)
+{
+	m_thinkingInterval = qMax(0, msecs);
+}
+
+int EngineConfiguration::stopTimeout() const
+{
+	return m_stopTimeout;
+}
+
+void EngineConfiguration::setStopTimeout(int msecs)
+{
+	m_stopTimeout = qMax(0, msecs);
+}
+
+QString EngineConfiguration::remoteAddress() const
+{
+	return m_remoteAddress;
+}
+
+void EngineConfiguration::setRemoteAddress(const QString& address)
+{
+	m_remoteAddress = address;
+}
+
 EngineConfiguration& EngineConfiguration::operator=(const EngineConfiguration& other)
 {
 	if (this != &other)
@@ -392,15 +510,20 @@ EngineConfiguration& EngineConfiguration::operator=(const EngineConfiguration& o
 		m_command = other.m_command;
 		m_workingDirectory = other.m_workingDirectory;
 		m_stderrFile = other.m_stderrFile;
+		m_stderrMaxSize = other.m_stderrMaxSize;
+		m_remoteAddress = other.m_remoteAddress;
 		m_protocol = other.m_protocol;
 		m_arguments = other.m_arguments;
 		m_initStrings = other.m_initStrings;
 		m_variants = other.m_variants;
 		m_whiteEvalPov = other.m_whiteEvalPov;
 		m_pondering = other.m_pondering;
+		m_compactPositions = other.m_compactPositions;
 		m_validateClaims = other.m_validateClaims;
 		m_restartMode = other.m_restartMode;
 		m_rating = other.m_rating;
+		m_thinkingInterval = other.m_thinkingInterval;
+		m_stopTimeout = other.m_stopTimeout;
 
 		qDeleteAll(m_options);
 		m_options.clear();
@@ -432,13 +555,18 @@ bool EngineConfiguration::operator==(const EngineConfiguration& other) const
 {
 	if (m_whiteEvalPov != other.m_whiteEvalPov
 		|| m_pondering != other.m_pondering
+		|| m_compactPositions != other.m_compactPositions
 		|| m_validateClaims != other.m_validateClaims
 		|| m_restartMode != other.m_restartMode
 		|| m_rating != other.m_rating
+		|| m_thinkingInterval != other.m_thinkingInterval
+		|| m_stopTimeout != other.m_stopTimeout
 		|| m_name != other.m_name
 		|| m_command != other.m_command
 		|| m_workingDirectory != other.m_workingDirectory
 		|| m_stderrFile != other.m_stderrFile
+		|| m_stderrMaxSize != other.m_stderrMaxSize
+		|| m_remoteAddress != other.m_remoteAddress
 		|| m_protocol != other.m_protocol
 		|| m_arguments != other.m_arguments
 		|| m_initStrings != other.m_initStrings
@@ -95,6 +95,13 @@ class LIB_EXPORT EngineConfiguration
 		 * \sa stderrFile()
 		 */
 		void setStderrFile(const QString& fileName);
+		/*!
+		 * Sets the maximum size of the standard error output file
+		 * to \a bytes.
+		 *
+		 * \sa stderrMaxSize()
+		 */
+		void setStderrMaxSize(qint64 bytes);
 		/*!
 		 * Sets the communication protocol the engine uses.
 		 *
@@ -120,6 +127,14 @@ class LIB_EXPORT EngineConfiguration
 		 * \sa setCommand()
 		 */
 		QString command() const;
+		/*!
+		 * Returns the absolute path of the engine's executable, or an
+		 * empty string if it can't be found.
+		 *
+		 * The executable is resolved the same way the engine process
+		 * resolves it. The command may include the arguments.
+		 */
+		QString executablePath() const;
 		/*!
 		 * Returns the working directory the engine uses.
 		 *
@@ -133,6 +148,19 @@ class LIB_EXPORT EngineConfiguration
 		 * \sa setStderrFile()
 		 */
 		QString stderrFile() const;
+		/*!
+		 * Returns the maximum size of the standard error output
+		 * file in bytes.
+		 *
+		 * The engine writes to the file directly, so the size is
+		 * checked when the engine is started: if the file has
+		 * reached the maximum size, it is renamed with a ".1"
+		 * suffix (replacing an earlier one) and a new file is
+		 * started. The default value is 0, which means no limit.
+		 *
+		 * \sa setStderrMaxSize()
+		 */
+		qint64 stderrMaxSize() const;
 		/*!
 		 * Returns the communication protocol the engine uses.
 		 *
@@ -198,6 +226,21 @@ class LIB_EXPORT EngineConfiguration
 		/*! Sets pondering mode to \a enabled. */
 		void setPondering(bool enabled);
 
+		/*!
+		 * Returns true if positions are sent to the engine from the
+		 * last irreversible move instead of the start of the game.
+		 *
+		 * This keeps the position commands of UCI engines short in
+		 * long games. Positions before an irreversible move can't
+		 * occur again, so the engine doesn't need them to detect
+		 * repetitions, but an engine that uses the game history for
+		 * anything else (eg. an opening book) may play differently.
+		 * The default is false.
+		 */
+		bool compactPositions() const;
+		/*! Sets compact position mode to \a enabled. */
+		void setCompactPositions(bool enabled);
+
 		/*!
 		 * Returns the restart mode.
 		 * The default value is \a RestartAuto.
@@ -217,6 +260,44 @@ class LIB_EXPORT EngineConfiguration
 		/*! Sets result claim validation mode to \a validate. */
 		void setClaimsValidated(bool validate);
 
+		/*!
+		 * Returns the minimum interval between thinking updates
+		 * in milliseconds.
+		 *
+		 * Updates that arrive faster are coalesced: only the latest
+		 * one is reported when the interval expires, and the last
+		 * update before a move is always reported. The default value
+		 * is 0, which reports every update.
+		 */
+		int thinkingInterval() const;
+		/*! Sets the thinking update interval to \a msecs. */
+		void setThinkingInterval(int msecs);
+
+		/*!
+		 * Returns the time in milliseconds the engine has to stop
+		 * thinking at the end of a game before it's terminated.
+		 *
+		 * An engine that's terminated is restarted for its next
+		 * game. The default value is 0, which uses the normal
+		 * ping timeout.
+		 */
+		int stopTimeout() const;
+		/*! Sets the stop timeout to \a msecs. */
+		void setStopTimeout(int msecs);
+
+		/*!
+		 * Returns the address of a remote engine as "host:port",
+		 * or an empty string if the engine runs locally.
+		 *
+		 * A remote engine is reached over TCP instead of being
+		 * started as a local process; the command is then ignored.
+		 * The address may also be a comma-separated list of nodes
+		 * that serve the same engine.
+		 */
+		QString remoteAddress() const;
+		/*! Sets the address of a remote engine to \a address. */
+		void setRemoteAddress(const QString& address);
+
 		/*!
 		 * Assigns \a other to this engine configuration and returns
 		 * a reference to this object.
@@ -231,6 +312,8 @@ class LIB_EXPORT EngineConfiguration
 		QString m_command;
 		QString m_workingDirectory;
 		QString m_stderrFile;
+		qint64 m_stderrMaxSize;
+		QString m_remoteAddress;
 		QString m_protocol;
 		QStringList m_arguments;
 		QStringList m_initStrings;
@@ -238,9 +321,12 @@ class LIB_EXPORT EngineConfiguration
 		QList<EngineOption*> m_options;
 		bool m_whiteEvalPov;
 		bool m_pondering;
+		bool m_compactPositions;
 		bool m_validateClaims;
 		RestartMode m_restartMode;
 		int m_rating;
+		int m_thinkingInterval;
+		int m_stopTimeout;
 };
 
 #endif // ENGINE_CONFIGURATION_H
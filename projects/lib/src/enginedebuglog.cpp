@@ -0,0 +1,157 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginedebuglog.h"
+#include <chrono>
+
+namespace {
+
+// Buffered messages are written when they need this much memory
+const int s_bufferSize = 64 * 1024;
+
+void appendNumber(QByteArray& out, qint64 value, int width)
+{
+	char digits[24];
+	int i = 0;
+	do
+	{
+		digits[i++] = char('0' + value % 10);
+		value /= 10;
+	} while (value > 0 || i < width);
+
+	while (i > 0)
+		out += digits[--i];
+}
+
+} // anonymous namespace
+
+EngineDebugLog::EngineDebugLog(const QString& fileName,
+			       qint64 maxSize,
+			       int maxFiles)
+	: m_file(fileName),
+	  m_maxSize(maxSize),
+	  m_maxFiles(qMax(maxFiles, 0)),
+	  m_size(-1),
+	  m_failed(false),
+	  m_memory(MemoryStats::DebugBuffers)
+{
+	m_buffer.reserve(s_bufferSize + 1024);
+	m_memory.setBytes(m_buffer.capacity());
+}
+
+EngineDebugLog::~EngineDebugLog()
+{
+	flush();
+}
+
+QString EngineDebugLog::fileName() const
+{
+	return m_file.fileName();
+}
+
+void EngineDebugLog::write(const QString& message)
+{
+	using namespace std::chrono;
+	const qint64 usecs = duration_cast<microseconds>(
+		system_clock::now().time_since_epoch()).count();
+
+	appendNumber(m_buffer, usecs / 1000000, 1);
+	m_buffer += '.';
+	appendNumber(m_buffer, usecs % 1000000, 6);
+	m_buffer += ' ';
+	m_buffer += message.toUtf8();
+	m_buffer += '\n';
+
+	if (m_buffer.size() >= s_bufferSize)
+		flush();
+	m_memory.setBytes(m_buffer.capacity());
+}
+
+bool EngineDebugLog::flush()
+{
+	if (m_buffer.isEmpty())
+		return true;
+	if (m_failed)
+	{
+		m_buffer.clear();
+		return false;
+	}
+
+	if (!m_file.isOpen())
+	{
+		if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+		{
+			qWarning("cannot open engine log file: %s",
+				 qPrintable(m_file.fileName()));
+			m_failed = true;
+			m_buffer.clear();
+			return false;
+		}
+		m_size = m_file.size();
+	}
+
+	if (m_maxSize > 0
+	&&  m_size > 0
+	&&  m_size + m_buffer.size() > m_maxSize
+	&&  !rotate())
+	{
+		m_buffer.clear();
+		return false;
+	}
+
+	const qint64 n = m_file.write(m_buffer);
+	const bool ok = (n == m_buffer.size() && m_file.flush());
+	m_size += qMax(n, qint64(0));
+	m_buffer.clear();
+	if (!ok)
+		qWarning("cannot write engine log file: %s",
+			 qPrintable(m_file.fileName()));
+
+	return ok;
+}
+
+bool EngineDebugLog::rotate()
+{
+	const QString fileName(m_file.fileName());
+	m_file.close();
+
+	if (m_maxFiles == 0)
+		QFile::remove(fileName);
+	else
+	{
+		QFile::remove(fileName + '.' + QString::number(m_maxFiles));
+		for (int i = m_maxFiles - 1; i >= 1; i--)
+		{
+			const QString name(fileName + '.' + QString::number(i));
+			if (QFile::exists(name))
+				QFile::rename(name, fileName + '.'
+						    + QString::number(i + 1));
+		}
+		QFile::rename(fileName, fileName + ".1");
+	}
+
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("cannot open engine log file: %s",
+			 qPrintable(fileName));
+		m_failed = true;
+		return false;
+	}
+	m_size = 0;
+
+	return true;
+}
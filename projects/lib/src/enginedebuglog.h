@@ -0,0 +1,80 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEDEBUGLOG_H
+#define ENGINEDEBUGLOG_H
+
+#include <QFile>
+#include <QByteArray>
+#include "memorystats.h"
+
+/*!
+ * \brief A buffered debug log file of a single chess engine.
+ *
+ * EngineDebugLog collects an engine's debug messages (the lines
+ * written to and read from the engine) in memory and appends them to
+ * the log file in large blocks. Every message is prefixed with the
+ * time since the Epoch in seconds, with microsecond precision.
+ *
+ * When the file grows bigger than the maximum size it is rotated:
+ * the file is renamed to "FILE.1", the previous "FILE.1" to "FILE.2",
+ * and so on, and the oldest file is removed.
+ *
+ * The log isn't thread-safe. It's meant to be used only by the
+ * thread of the engine that owns it, so that logging doesn't need
+ * any locks or signals.
+ */
+class LIB_EXPORT EngineDebugLog
+{
+	public:
+		/*!
+		 * Creates a new log that writes to file \a fileName.
+		 *
+		 * The file is rotated when it's bigger than \a maxSize
+		 * bytes, and at most \a maxFiles old files are kept.
+		 */
+		explicit EngineDebugLog(const QString& fileName,
+					qint64 maxSize = 64 * 1024 * 1024,
+					int maxFiles = 4);
+		/*! Flushes the log and closes the file. */
+		~EngineDebugLog();
+
+		/*! Returns the name of the log file. */
+		QString fileName() const;
+
+		/*! Appends \a message to the log. */
+		void write(const QString& message);
+		/*!
+		 * Writes the buffered messages to the file.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool flush();
+
+	private:
+		bool rotate();
+
+		QFile m_file;
+		qint64 m_maxSize;
+		int m_maxFiles;
+		qint64 m_size;
+		bool m_failed;
+		QByteArray m_buffer;
+		MemoryAccount m_memory;
+};
+
+#endif // ENGINEDEBUGLOG_H
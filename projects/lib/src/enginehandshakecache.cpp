@@ -0,0 +1,156 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginehandshakecache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <jsonparser.h>
+#include <jsonserializer.h>
+#include "engineconfiguration.h"
+
+namespace {
+
+QMutex s_mutex;
+QString s_fileName;
+QVariantMap s_entries;
+bool s_loaded = false;
+
+void load()
+{
+	if (s_loaded)
+		return;
+	s_loaded = true;
+
+	QFile input(s_fileName);
+	if (!input.exists())
+		return;
+	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning("Cannot open engine cache file %s",
+			 qPrintable(s_fileName));
+		return;
+	}
+
+	QTextStream stream(&input);
+	JsonParser parser(stream);
+	const QVariantMap entries(parser.parse().toMap());
+	if (parser.hasError())
+	{
+		qWarning("Bad engine cache file %s, line %lld: %s",
+			 qPrintable(s_fileName), parser.errorLineNumber(),
+			 qPrintable(parser.errorString()));
+		return;
+	}
+
+	s_entries = entries;
+}
+
+} // anonymous namespace
+
+void EngineHandshakeCache::setFileName(const QString& fileName)
+{
+	QMutexLocker locker(&s_mutex);
+
+	s_fileName = fileName;
+	s_entries.clear();
+	s_loaded = false;
+}
+
+bool EngineHandshakeCache::isEnabled()
+{
+	QMutexLocker locker(&s_mutex);
+	return !s_fileName.isEmpty();
+}
+
+QString EngineHandshakeCache::key(const EngineConfiguration& config)
+{
+	// The executable of a remote engine can't be checked
+	if (!isEnabled() || !config.remoteAddress().isEmpty())
+		return QString();
+
+	const QString path(config.executablePath());
+	if (path.isEmpty())
+		return QString();
+	const QFileInfo info(path);
+	if (!info.isFile())
+		return QString();
+
+	QStringList fields;
+	fields << config.protocol()
+	       << info.canonicalFilePath()
+	       << QString::number(info.lastModified().toMSecsSinceEpoch())
+	       << QString::number(info.size())
+	       << config.workingDirectory()
+	       << config.command()
+	       << config.arguments().join('\n')
+	       << config.initStrings().join('\n');
+
+	return QCryptographicHash::hash(fields.join('\0').toUtf8(),
+					QCryptographicHash::Sha1).toHex();
+}
+
+QVariantMap EngineHandshakeCache::entry(const QString& key)
+{
+	if (key.isEmpty())
+		return QVariantMap();
+
+	QMutexLocker locker(&s_mutex);
+	if (s_fileName.isEmpty())
+		return QVariantMap();
+
+	load();
+	return s_entries.value(key).toMap();
+}
+
+void EngineHandshakeCache::setEntry(const QString& key,
+				    const QVariantMap& entry)
+{
+	if (key.isEmpty())
+		return;
+
+	QMutexLocker locker(&s_mutex);
+	if (s_fileName.isEmpty())
+		return;
+
+	load();
+	s_entries[key] = entry;
+
+	// The whole file is replaced atomically so that a concurrent
+	// reader never sees a partial cache
+	QSaveFile output(s_fileName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("Cannot open engine cache file %s",
+			 qPrintable(s_fileName));
+		return;
+	}
+
+	QTextStream out(&output);
+	JsonSerializer serializer(s_entries);
+	serializer.serialize(out);
+	out.flush();
+	if (!output.commit())
+		qWarning("Cannot write engine cache file %s",
+			 qPrintable(s_fileName));
+}
@@ -0,0 +1,75 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_HANDSHAKE_CACHE_H
+#define ENGINE_HANDSHAKE_CACHE_H
+
+#include <QString>
+#include <QVariantMap>
+class EngineConfiguration;
+
+/*!
+ * \brief A cache of the information engines report when they start.
+ *
+ * Starting the chess protocol means waiting for the engine to list
+ * all its options and features, and parsing them. For engines with
+ * hundreds of options that takes a noticeable time, and with frequent
+ * restarts it adds up. EngineHandshakeCache stores the result of the
+ * protocol handshake in a file so that it can be reused the next time
+ * the same engine is started.
+ *
+ * An engine is identified by its protocol, the path, modification
+ * time and size of its executable, and its working directory,
+ * arguments and initialization strings. Rebuilding the engine or
+ * changing its configuration makes the old entry invalid.
+ *
+ * The cache is disabled until a file name is set. All functions of
+ * this class are thread-safe.
+ */
+class LIB_EXPORT EngineHandshakeCache
+{
+	public:
+		/*!
+		 * Sets the cache file to \a fileName.
+		 *
+		 * The file is read when the first entry is needed. An empty
+		 * \a fileName disables the cache.
+		 */
+		static void setFileName(const QString& fileName);
+		/*! Returns true if a cache file has been set. */
+		static bool isEnabled();
+
+		/*!
+		 * Returns the cache key of the engine in \a config.
+		 *
+		 * Returns an empty string if the cache is disabled or the
+		 * engine's executable can't be found.
+		 */
+		static QString key(const EngineConfiguration& config);
+		/*!
+		 * Returns the cached handshake for \a key, or an empty map
+		 * if there is none.
+		 */
+		static QVariantMap entry(const QString& key);
+		/*! Stores \a entry for \a key and writes the cache file. */
+		static void setEntry(const QString& key, const QVariantMap& entry);
+
+	private:
+		EngineHandshakeCache();
+};
+
+#endif // ENGINE_HANDSHAKE_CACHE_H
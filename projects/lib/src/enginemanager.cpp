@@ -18,9 +18,87 @@
 #include "enginemanager.h"
 #include <QFile>
 #include <QTextStream>
-#include <jsonparser.h>
-#include <jsonserializer.h>
+#include <jsonreader.h>
+#include <jsonwriter.h>
 
+EngineManager::Entry::Entry()
+	: offset(0),
+	  length(0)
+{
+}
+
+EngineManager::Entry::Entry(const EngineConfiguration& config)
+	: name(config.name()),
+	  offset(0),
+	  length(0),
+	  config(config)
+{
+}
+
+/*
+ * Indexes the engine configurations in \a fileName into \a entries.
+ * Only the names of the engines are read; the rest of each object
+ * is validated and skipped.
+ */
+bool EngineManager::readEngines(const QString& fileName, QList<Entry>& entries)
+{
+	if (!QFile::exists(fileName))
+		return false;
+
+	QFile input(fileName);
+	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning("cannot open engine configuration file: %s", qPrintable(fileName));
+		return false;
+	}
+
+	QSharedPointer<QString> source(new QString(QTextStream(&input).readAll()));
+	QTextStream stream(source.data(), QIODevice::ReadOnly);
+	JsonReader reader(stream);
+	if (reader.readNext() == JsonReader::StartArray)
+	{
+		while (reader.readNext() != JsonReader::EndArray)
+		{
+			if (reader.hasError())
+				break;
+
+			Entry entry;
+			entry.source = source;
+			entry.offset = int(reader.tokenOffset());
+			if (reader.tokenType() == JsonReader::StartObject)
+			{
+				while (reader.readNext() == JsonReader::Name)
+				{
+					const bool isName = (reader.text() == "name");
+					if (reader.readNext() == JsonReader::String
+					&&  isName)
+						entry.name = reader.text();
+					if (!reader.skipValue())
+						break;
+				}
+			}
+			else
+				reader.skipValue();
+			if (reader.hasError())
+				break;
+
+			entry.length = int(reader.characterOffset()) - entry.offset;
+			entries << entry;
+		}
+	}
+	else
+		reader.skipValue();
+
+	if (reader.hasError())
+	{
+		qWarning("%s", qPrintable(QString("bad engine configuration file line %1 in %2: %3")
+			.arg(reader.errorLineNumber()).arg(fileName).arg(reader.errorString()))); // clazy:exclude=qstring-arg
+		entries.clear();
+		return false;
+	}
+
+	return true;
+}
 
 EngineManager::EngineManager(QObject* parent)
 	: QObject(parent)
@@ -31,6 +109,52 @@ EngineManager::~EngineManager()
 {
 }
 
+EngineConfiguration EngineManager::parseEntry(const Entry& entry)
+{
+	if (entry.source.isNull())
+		return entry.config;
+
+	QString text(entry.source->mid(entry.offset, entry.length));
+	QTextStream stream(&text, QIODevice::ReadOnly);
+	JsonReader reader(stream);
+	reader.readNext();
+	return EngineConfiguration(reader.readValue());
+}
+
+const EngineConfiguration& EngineManager::configAt(int index) const
+{
+	Entry& entry = m_engines[index];
+	if (!entry.source.isNull())
+	{
+		entry.config = parseEntry(entry);
+		entry.source.clear();
+	}
+
+	return entry.config;
+}
+
+bool EngineManager::isSameEngine(int index, const Entry& entry) const
+{
+	// Unchanged JSON objects don't have to be parsed
+	const Entry& old = m_engines.at(index);
+	if (!old.source.isNull() && !entry.source.isNull()
+	&&  old.source->midRef(old.offset, old.length)
+	    == entry.source->midRef(entry.offset, entry.length))
+		return true;
+
+	return configAt(index) == parseEntry(entry);
+}
+
+void EngineManager::rebuildIndex()
+{
+	m_index.clear();
+	for (int i = 0; i < m_engines.size(); i++)
+	{
+		if (!m_index.contains(m_engines.at(i).name))
+			m_index.insert(m_engines.at(i).name, i);
+	}
+}
+
 int EngineManager::engineCount() const
 {
 	return m_engines.count();
@@ -38,31 +162,32 @@ int EngineManager::engineCount() const
 
 EngineConfiguration EngineManager::engineAt(int index) const
 {
-	return m_engines.at(index);
+	return configAt(index);
+}
+
+QString EngineManager::engineNameAt(int index) const
+{
+	return m_engines.at(index).name;
 }
 
 int EngineManager::engineIndex(const QString& name) const
 {
-	int index = 0;
-	for (const EngineConfiguration& engine : m_engines)
-	{
-		if (name == engine.name())
-			return index;
-		++index;
-	}
-	return -1;
+	return m_index.value(name, -1);
 }
 
 void EngineManager::addEngine(const EngineConfiguration& engine)
 {
-	m_engines << engine;
+	m_engines << Entry(engine);
+	if (!m_index.contains(engine.name()))
+		m_index.insert(engine.name(), m_engines.size() - 1);
 
 	emit engineAdded(m_engines.size() - 1);
 }
 
 void EngineManager::updateEngineAt(int index, const EngineConfiguration& engine)
 {
-	m_engines[index] = engine;
+	m_engines[index] = Entry(engine);
+	rebuildIndex();
 
 	emit engineUpdated(index);
 }
@@ -72,16 +197,24 @@ void EngineManager::removeEngineAt(int index)
 	emit engineAboutToBeRemoved(index);
 
 	m_engines.removeAt(index);
+	rebuildIndex();
 }
 
 QList<EngineConfiguration> EngineManager::engines() const
 {
-	return m_engines;
+	QList<EngineConfiguration> engines;
+	for (int i = 0; i < m_engines.size(); i++)
+		engines << configAt(i);
+
+	return engines;
 }
 
 void EngineManager::setEngines(const QList<EngineConfiguration>& engines)
 {
-	m_engines = engines;
+	m_engines.clear();
+	for (const EngineConfiguration& engine : engines)
+		m_engines << Entry(engine);
+	rebuildIndex();
 
 	emit enginesReset();
 }
@@ -91,10 +224,9 @@ bool EngineManager::supportsVariant(const QString& variant) const
 	if (m_engines.isEmpty())
 		return false;
 
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (const auto& config, m_engines)
+	for (int i = 0; i < m_engines.size(); i++)
 	{
-		if (!config.supportsVariant(variant))
+		if (!configAt(i).supportsVariant(variant))
 			return false;
 	}
 
@@ -103,70 +235,46 @@ bool EngineManager::supportsVariant(const QString& variant) const
 
 void EngineManager::loadEngines(const QString& fileName)
 {
-	if (!QFile::exists(fileName))
+	QList<Entry> entries;
+	if (!readEngines(fileName, entries))
 		return;
 
-	QFile input(fileName);
-	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+	for (const Entry& entry : entries)
 	{
-		qWarning("cannot open engine configuration file: %s", qPrintable(fileName));
-		return;
-	}
-
-	QTextStream stream(&input);
-	JsonParser parser(stream);
-	const QVariantList engines(parser.parse().toList());
+		m_engines << entry;
+		if (!m_index.contains(entry.name))
+			m_index.insert(entry.name, m_engines.size() - 1);
 
-	if (parser.hasError())
-	{
-		qWarning("%s", qPrintable(QString("bad engine configuration file line %1 in %2: %3")
-			.arg(parser.errorLineNumber()).arg(fileName).arg(parser.errorString()))); // clazy:exclude=qstring-arg
-		return;
+		emit engineAdded(m_engines.size() - 1);
 	}
-
-	for (const QVariant& engine : engines)
-		addEngine(EngineConfiguration(engine));
 }
 
 void EngineManager::reloadEngines(const QString& fileName)
 {
-	if (!QFile::exists(fileName))
-		return;
-
-	QFile input(fileName);
-	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning("cannot open engine configuration file: %s", qPrintable(fileName));
-		return;
-	}
-
-	QTextStream stream(&input);
-	JsonParser parser(stream);
-	const QVariantList engines(parser.parse().toList());
-
-	if (parser.hasError())
-	{
-		qWarning("%s", qPrintable(QString("bad engine configuration file line %1 in %2: %3")
-			.arg(parser.errorLineNumber()).arg(fileName).arg(parser.errorString()))); // clazy:exclude=qstring-arg
+	QList<Entry> newEntries;
+	if (!readEngines(fileName, newEntries))
 		return;
-	}
 
 	QSet<QString> names = engineNames();
-	QList<EngineConfiguration> newEngines;
-	for (const QVariant& engine : engines)
-		newEngines << engine;
 
-	for (const EngineConfiguration& engine : newEngines)
+	for (const Entry& entry : newEntries)
 	{
-		const int index = engineIndex(engine.name());
+		const int index = engineIndex(entry.name);
 		if (index >= 0)
 		{
-			names.remove(engine.name());
-			if (engineAt(index) != engine)
-				updateEngineAt(index, engine);
+			names.remove(entry.name);
+			if (!isSameEngine(index, entry))
+			{
+				m_engines[index] = entry;
+				emit engineUpdated(index);
+			}
 		}
 		else
-			addEngine(engine);
+		{
+			m_engines << entry;
+			m_index.insert(entry.name, m_engines.size() - 1);
+			emit engineAdded(m_engines.size() - 1);
+		}
 	}
 
 	for (const QString& name : names)
@@ -179,11 +287,6 @@ void EngineManager::reloadEngines(const QString& fileName)
 
 void EngineManager::saveEngines(const QString& fileName)
 {
-	QVariantList engines;
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (const EngineConfiguration& config, m_engines)
-		engines << config.toVariant();
-
 	QFile output(fileName);
 	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
 	{
@@ -192,16 +295,19 @@ void EngineManager::saveEngines(const QString& fileName)
 	}
 
 	QTextStream out(&output);
-	JsonSerializer serializer(engines);
-	serializer.serialize(out);
+	JsonWriter writer(out);
+	writer.writeStartArray();
+	for (int i = 0; i < m_engines.size(); i++)
+		writer.writeValue(configAt(i).toVariant());
+	writer.writeEndArray();
 }
 
 QSet<QString> EngineManager::engineNames() const
 {
 	QSet<QString> names;
 	// TODO: use qAsConst() from Qt 5.7
-	foreach (const EngineConfiguration& engine, m_engines)
-		names.insert(engine.name());
+	foreach (const Entry& engine, m_engines)
+		names.insert(engine.name);
 
 	return names;
 }
@@ -19,11 +19,17 @@
 #define ENGINE_MANAGER_H
 
 #include <QSet>
+#include <QHash>
+#include <QSharedPointer>
 #include "engineconfiguration.h"
 
 /*!
  * \brief Manages chess engines and their configurations.
  *
+ * The engines read from a configuration file are only indexed by
+ * name when the file is loaded. An engine's configuration is parsed
+ * when it's first referenced, so loading a large file is cheap.
+ *
  * \sa EngineConfiguration
  */
 class LIB_EXPORT EngineManager : public QObject
@@ -39,6 +45,11 @@ class LIB_EXPORT EngineManager : public QObject
 		int engineCount() const;
 		/*! Returns the engine at \a index. */
 		EngineConfiguration engineAt(int index) const;
+		/*!
+		 * Returns the name of the engine at \a index without
+		 * parsing its configuration.
+		 */
+		QString engineNameAt(int index) const;
 		/*! Returns the index of the engine with \a name or -1 if not found. */
 		int engineIndex(const QString& name) const;
 
@@ -85,7 +96,32 @@ class LIB_EXPORT EngineManager : public QObject
 		void engineUpdated(int index);
 
 	private:
-		QList<EngineConfiguration> m_engines;
+		/*!
+		 * An engine in the list. An engine read from a file keeps
+		 * the position of its JSON object in the file's contents
+		 * until its configuration is needed.
+		 */
+		struct Entry
+		{
+			Entry();
+			explicit Entry(const EngineConfiguration& config);
+
+			QString name;
+			QSharedPointer<const QString> source;
+			int offset;
+			int length;
+			EngineConfiguration config;
+		};
+
+		static bool readEngines(const QString& fileName,
+					QList<Entry>& entries);
+		static EngineConfiguration parseEntry(const Entry& entry);
+		const EngineConfiguration& configAt(int index) const;
+		bool isSameEngine(int index, const Entry& entry) const;
+		void rebuildIndex();
+
+		mutable QList<Entry> m_engines;
+		QHash<QString, int> m_index;
 
 };
 
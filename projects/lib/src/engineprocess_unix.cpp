@@ -0,0 +1,590 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engineprocess_unix.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace {
+
+// Everything the child process needs, prepared before vfork()
+struct ChildSetup
+{
+	const char* program;
+	char* const* argv;
+	const char* workDir;
+	int stdinFd;
+	int stdoutFd;
+	int stderrFd;
+	int errorFd;
+	const sigset_t* signalMask;
+};
+
+bool ignoreSigPipe()
+{
+	// Writing to an engine that has exited must not kill us
+	struct sigaction action;
+	if (sigaction(SIGPIPE, nullptr, &action) == 0
+	&&  action.sa_handler == SIG_DFL)
+	{
+		action.sa_handler = SIG_IGN;
+		sigaction(SIGPIPE, &action, nullptr);
+	}
+	return true;
+}
+
+// Creates a pipe whose ends are closed when a child executes a program,
+// so that the engines started by other threads don't inherit them
+bool createPipe(int fds[2])
+{
+#ifdef Q_OS_LINUX
+	return pipe2(fds, O_CLOEXEC) == 0;
+#else
+	if (pipe(fds) != 0)
+		return false;
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return true;
+#endif
+}
+
+void closeFd(int& fd)
+{
+	if (fd != -1)
+	{
+		::close(fd);
+		fd = -1;
+	}
+}
+
+pid_t waitForPid(pid_t pid, int* status, int options)
+{
+	pid_t ret;
+	do
+		ret = waitpid(pid, status, options);
+	while (ret == -1 && errno == EINTR);
+	return ret;
+}
+
+bool redirect(int fd, int target)
+{
+	// dup2() doesn't clear the close-on-exec flag of a descriptor
+	// that is already in place
+	if (fd == target)
+		return fcntl(fd, F_SETFD, 0) == 0;
+	return dup2(fd, target) == target;
+}
+
+[[noreturn]] void execChild(const ChildSetup& setup)
+{
+	// The child shares the memory of the parent until it executes
+	// the program, so only async-signal-safe functions are called
+	// and nothing but the stack is written to.
+	for (int sig = 1; sig < NSIG; sig++)
+	{
+		struct sigaction action;
+		if (sigaction(sig, nullptr, &action) != 0
+		||  action.sa_handler == SIG_DFL
+		||  (action.sa_handler == SIG_IGN && sig != SIGPIPE))
+			continue;
+
+		struct sigaction defaultAction;
+		memset(&defaultAction, 0, sizeof(defaultAction));
+		sigemptyset(&defaultAction.sa_mask);
+		defaultAction.sa_handler = SIG_DFL;
+		sigaction(sig, &defaultAction, nullptr);
+	}
+	sigprocmask(SIG_SETMASK, setup.signalMask, nullptr);
+
+	if (redirect(setup.stdinFd, STDIN_FILENO)
+	&&  redirect(setup.stdoutFd, STDOUT_FILENO)
+	&&  (setup.stderrFd == -1 || redirect(setup.stderrFd, STDERR_FILENO))
+	&&  (setup.workDir == nullptr || chdir(setup.workDir) == 0))
+		execv(setup.program, setup.argv);
+
+	// Tell the parent why the program couldn't be executed
+	const int error = errno;
+	ssize_t ret = write(setup.errorFd, &error, sizeof(error));
+	Q_UNUSED(ret);
+	_exit(127);
+}
+
+pid_t spawn(const ChildSetup& setup)
+{
+	const pid_t pid = vfork();
+	if (pid == 0)
+		execChild(setup);
+	return pid;
+}
+
+} // anonymous namespace
+
+EngineProcess::EngineProcess(QObject* parent)
+	: QIODevice(parent),
+	  m_started(false),
+	  m_finished(false),
+	  m_exitCode(0),
+	  m_exitStatus(EngineProcess::NormalExit),
+	  m_stdErrFileMode(Truncate),
+	  m_pid(0),
+	  m_inWrite(-1),
+	  m_outRead(-1),
+	  m_notifier(nullptr),
+	  m_exitTimer(new QTimer(this))
+{
+	// An engine can close its output a moment before it exits
+	m_exitTimer->setInterval(50);
+	connect(m_exitTimer, SIGNAL(timeout()), this, SLOT(onExitTimeout()));
+}
+
+EngineProcess::~EngineProcess()
+{
+	if (m_started)
+	{
+		qWarning("EngineProcess: Destroyed while process is still running.");
+		kill();
+		waitForFinished(-1);
+	}
+	cleanup();
+}
+
+int EngineProcess::exitCode() const
+{
+	return m_exitCode;
+}
+
+qint64 EngineProcess::processId() const
+{
+	if (!m_started)
+		return 0;
+	return m_pid;
+}
+
+EngineProcess::ExitStatus EngineProcess::exitStatus() const
+{
+	return m_exitStatus;
+}
+
+qint64 EngineProcess::bytesAvailable() const
+{
+	return m_buffer.size() + QIODevice::bytesAvailable();
+}
+
+bool EngineProcess::canReadLine() const
+{
+	return m_buffer.contains('\n') || QIODevice::canReadLine();
+}
+
+void EngineProcess::closeOutput()
+{
+	if (m_notifier != nullptr)
+	{
+		// The notifier may be the sender of the current signal
+		m_notifier->setEnabled(false);
+		m_notifier->deleteLater();
+		m_notifier = nullptr;
+	}
+	closeFd(m_outRead);
+}
+
+void EngineProcess::cleanup()
+{
+	m_exitTimer->stop();
+	closeOutput();
+	closeFd(m_inWrite);
+
+	m_started = false;
+}
+
+void EngineProcess::close()
+{
+	if (!isOpen())
+		return;
+
+	emit aboutToClose();
+	if (m_started)
+	{
+		kill();
+		waitForFinished(-1);
+	}
+	cleanup();
+	m_buffer.clear();
+	QIODevice::close();
+}
+
+bool EngineProcess::isSequential() const
+{
+	return true;
+}
+
+void EngineProcess::setWorkingDirectory(const QString& dir)
+{
+	m_workDir = dir;
+}
+
+void EngineProcess::setStandardErrorFile(const QString& fileName, OpenMode mode)
+{
+	m_stdErrFile = fileName;
+	m_stdErrFileMode = mode;
+}
+
+QStringList EngineProcess::splitCommand(const QString& command)
+{
+	QStringList args;
+	QString arg;
+	int quoteCount = 0;
+	bool inQuote = false;
+
+	for (const QChar& c : command)
+	{
+		if (c == '\"')
+		{
+			// Three consecutive quotes are a literal quote
+			if (++quoteCount == 3)
+			{
+				quoteCount = 0;
+				arg += c;
+			}
+			continue;
+		}
+		if (quoteCount == 1)
+			inQuote = !inQuote;
+		quoteCount = 0;
+
+		if (!inQuote && c.isSpace())
+		{
+			if (!arg.isEmpty())
+				args << arg;
+			arg.clear();
+		}
+		else
+			arg += c;
+	}
+	if (!arg.isEmpty())
+		args << arg;
+
+	return args;
+}
+
+void EngineProcess::start(const QString& program,
+			  const QStringList& arguments,
+			  OpenMode mode)
+{
+	static const bool sigPipeIgnored = ignoreSigPipe();
+	Q_UNUSED(sigPipeIgnored);
+
+	if (isOpen())
+		close();
+
+	m_finished = false;
+	m_exitCode = 0;
+	m_exitStatus = NormalExit;
+
+	// Find the program like QProcess does
+	QString path(program);
+	if (!path.contains('/'))
+	{
+		const QString exe = QStandardPaths::findExecutable(path);
+		if (!exe.isEmpty())
+			path = exe;
+	}
+
+	const QByteArray programName = QFile::encodeName(path);
+	const QByteArray workDir = QFile::encodeName(m_workDir);
+	QList<QByteArray> args;
+	args << programName;
+	for (const QString& arg : arguments)
+		args << arg.toLocal8Bit();
+	QVector<char*> argv;
+	for (QByteArray& arg : args)
+		argv << arg.data();
+	argv << nullptr;
+
+	int errFd = -1;
+	if (!m_stdErrFile.isEmpty())
+	{
+		int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+		flags |= (m_stdErrFileMode & Append) ? O_APPEND : O_TRUNC;
+		errFd = ::open(QFile::encodeName(m_stdErrFile).constData(),
+			       flags, 0666);
+		if (errFd == -1)
+		{
+			setErrorString(tr("Cannot open %1: %2")
+				       .arg(m_stdErrFile)
+				       .arg(QString::fromLocal8Bit(strerror(errno))));
+			return;
+		}
+	}
+
+	int inPipe[2] = { -1, -1 };
+	int outPipe[2] = { -1, -1 };
+	int errorPipe[2] = { -1, -1 };
+	if (!createPipe(inPipe) || !createPipe(outPipe) || !createPipe(errorPipe))
+	{
+		setErrorString(QString::fromLocal8Bit(strerror(errno)));
+		for (int* fd : { &inPipe[0], &inPipe[1], &outPipe[0], &outPipe[1],
+				 &errorPipe[0], &errorPipe[1], &errFd })
+			closeFd(*fd);
+		return;
+	}
+
+	// No signal handler may run in the child while it shares our
+	// memory. The child restores the mask before it executes the
+	// program.
+	sigset_t allSignals;
+	sigset_t oldMask;
+	sigfillset(&allSignals);
+	pthread_sigmask(SIG_SETMASK, &allSignals, &oldMask);
+
+	const ChildSetup setup = {
+		programName.constData(),
+		argv.constData(),
+		m_workDir.isEmpty() ? nullptr : workDir.constData(),
+		inPipe[0],
+		outPipe[1],
+		errFd,
+		errorPipe[1],
+		&oldMask
+	};
+	const pid_t pid = spawn(setup);
+	const int forkError = errno;
+
+	pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+	closeFd(inPipe[0]);
+	closeFd(outPipe[1]);
+	closeFd(errorPipe[1]);
+	closeFd(errFd);
+
+	// The error pipe is closed without data when the program is
+	// executed successfully
+	int error = forkError;
+	bool ok = (pid > 0);
+	if (ok)
+	{
+		ssize_t n;
+		do
+			n = read(errorPipe[0], &error, sizeof(error));
+		while (n == -1 && errno == EINTR);
+
+		if (n > 0)
+		{
+			ok = false;
+			waitForPid(pid, nullptr, 0);
+		}
+	}
+	closeFd(errorPipe[0]);
+
+	if (!ok)
+	{
+		setErrorString(QString::fromLocal8Bit(strerror(error)));
+		closeFd(inPipe[1]);
+		closeFd(outPipe[0]);
+		return;
+	}
+
+	m_pid = pid;
+	m_inWrite = inPipe[1];
+	m_outRead = outPipe[0];
+	m_started = true;
+	m_buffer.clear();
+
+	fcntl(m_outRead, F_SETFL, fcntl(m_outRead, F_GETFL) | O_NONBLOCK);
+	m_notifier = new QSocketNotifier(m_outRead, QSocketNotifier::Read, this);
+	connect(m_notifier, SIGNAL(activated(int)), this, SLOT(onReadyRead()));
+
+	// Make QIODevice aware that the device is now open
+	QIODevice::open(mode);
+}
+
+void EngineProcess::start(const QString& program,
+			  OpenMode mode)
+{
+	QStringList args = splitCommand(program);
+	if (args.isEmpty())
+		return;
+
+	QString prog = args.first();
+	args.removeFirst();
+	start(prog, args, mode);
+}
+
+void EngineProcess::kill()
+{
+	if (m_started && m_pid > 0)
+		::kill(pid_t(m_pid), SIGKILL);
+}
+
+bool EngineProcess::readOutput()
+{
+	char data[4096];
+	for (;;)
+	{
+		const ssize_t n = ::read(m_outRead, data, sizeof(data));
+		if (n > 0)
+			m_buffer.append(data, int(n));
+		else if (n == 0)
+			return true;
+		else if (errno != EINTR)
+			return errno != EAGAIN && errno != EWOULDBLOCK;
+	}
+}
+
+void EngineProcess::onReadyRead()
+{
+	if (m_outRead == -1)
+		return;
+
+	const int oldSize = m_buffer.size();
+	const bool atEnd = readOutput();
+	if (m_buffer.size() > oldSize)
+	{
+		emit readyRead();
+
+		// A receiver may have closed the device
+		if (m_outRead == -1)
+			return;
+	}
+	if (!atEnd)
+		return;
+
+	closeOutput();
+	emit readChannelFinished();
+
+	onFinished();
+	if (m_started)
+		m_exitTimer->start();
+}
+
+void EngineProcess::onExitTimeout()
+{
+	onFinished();
+	if (!m_started)
+		m_exitTimer->stop();
+}
+
+bool EngineProcess::reap(bool block)
+{
+	if (m_pid <= 0)
+		return true;
+
+	int status = 0;
+	const pid_t ret = waitForPid(pid_t(m_pid), &status, block ? 0 : WNOHANG);
+	if (ret == 0)
+		return false;
+
+	// The exit status is lost if someone else reaped the process
+	m_pid = 0;
+	if (ret != -1 && WIFEXITED(status))
+	{
+		m_exitCode = WEXITSTATUS(status);
+		m_exitStatus = NormalExit;
+	}
+	else
+	{
+		m_exitCode = -1;
+		m_exitStatus = CrashExit;
+	}
+	return true;
+}
+
+void EngineProcess::onFinished()
+{
+	if (!m_started || m_finished || !reap(false))
+		return;
+
+	// Keep the output that wasn't read yet
+	if (m_outRead != -1)
+		readOutput();
+
+	m_finished = true;
+	cleanup();
+	emit finished(m_exitCode, m_exitStatus);
+}
+
+bool EngineProcess::waitForFinished(int msecs)
+{
+	if (!m_started)
+		return true;
+
+	QElapsedTimer timer;
+	timer.start();
+	while (!reap(msecs == -1))
+	{
+		if (msecs != -1 && timer.elapsed() >= msecs)
+			return false;
+		QThread::msleep(1);
+	}
+	onFinished();
+
+	return true;
+}
+
+bool EngineProcess::waitForStarted(int msecs)
+{
+	// Don't wait here because start() already did the waiting
+	Q_UNUSED(msecs);
+	return m_started;
+}
+
+QString EngineProcess::workingDirectory() const
+{
+	return m_workDir;
+}
+
+qint64 EngineProcess::readData(char* data, qint64 maxSize)
+{
+	const qint64 n = qMin(maxSize, qint64(m_buffer.size()));
+	if (n == 0 && !m_started)
+		return -1;
+
+	memcpy(data, m_buffer.constData(), size_t(n));
+	m_buffer.remove(0, int(n));
+	return n;
+}
+
+qint64 EngineProcess::writeData(const char* data, qint64 maxSize)
+{
+	if (m_inWrite == -1)
+		return -1;
+
+	qint64 written = 0;
+	while (written < maxSize)
+	{
+		const ssize_t n = ::write(m_inWrite, data + written,
+					  size_t(maxSize - written));
+		if (n == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return written > 0 ? written : -1;
+		}
+		written += n;
+	}
+	return written;
+}
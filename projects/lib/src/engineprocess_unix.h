@@ -0,0 +1,190 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEPROCESS_UNIX_H
+#define ENGINEPROCESS_UNIX_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+class QSocketNotifier;
+class QTimer;
+
+
+/*!
+ * \brief A replacement for QProcess on Unix
+ *
+ * QProcess starts a process with fork(), which copies the page tables
+ * of the parent. In a process with a large resident size, eg. one with
+ * opening books, position indexes and tablebases mapped, every engine
+ * start then takes longer and briefly needs more memory. EngineProcess
+ * starts the engine with vfork() and exec(), so the cost of starting
+ * an engine doesn't depend on the size of the parent.
+ *
+ * The interface is the same as that of the Windows implementation.
+ * The engine's output is read when a socket notifier reports it, and
+ * writes go straight to the engine's input pipe.
+ *
+ * \sa QProcess
+ */
+class LIB_EXPORT EngineProcess : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! The process' exit status. */
+		enum ExitStatus
+		{
+			NormalExit,	//!< The process exited normally
+			CrashExit	//!< The process crashed
+		};
+
+		/*! Creates a new EngineProcess. */
+		explicit EngineProcess(QObject* parent = nullptr);
+		/*!
+		 * Destructs the EngineProcess and frees all resources.
+		 * If the process is still running, it is killed.
+		 */
+		virtual ~EngineProcess();
+
+		// Inherited from QIODevice
+		virtual qint64 bytesAvailable() const;
+		virtual bool canReadLine() const;
+		virtual void close();
+		virtual bool isSequential() const;
+
+		/*! Returns the exit code of the last process that finished. */
+		int exitCode() const;
+		/*!
+		 * Returns the native process identifier of the running
+		 * process, or 0 if no process is running.
+		 */
+		qint64 processId() const;
+		/*! Returns the exit status of the last process that finished. */
+		ExitStatus exitStatus() const;
+
+		/*!
+		 * Returns the process' working directory.
+		 * Returns an empty string if the working directory wasn't
+		 * set with setWorkingDirectory().
+		 */
+		QString workingDirectory() const;
+		/*!
+		 * Sets the working directory to dir.
+		 * EngineProcess will start the process in this directory.
+		 */
+		void setWorkingDirectory(const QString& dir);
+		/*!
+		 * Redirects the process' standard error to the file fileName.
+		 * The file will be appended to if mode is Append; otherwise
+		 * it will be truncated. Without a file the process inherits
+		 * the standard error of this process.
+		 */
+		void setStandardErrorFile(const QString& fileName,
+					  OpenMode mode = Truncate);
+
+		/*!
+		 * Starts the program \a program in a new process, passing the
+		 * command line arguments in \a arguments. The OpenMode is set
+		 * to \a mode.
+		 *
+		 * \note Unlike the same function in QProcess, this one will
+		 * block until the program has been executed or has failed
+		 * to execute.
+		 *
+		 * \note To check if the process started successfully, call
+		 * the waitForStarted() method.
+		 */
+		void start(const QString& program,
+			   const QStringList& arguments,
+			   OpenMode mode = ReadWrite);
+		/*!
+		 * Starts the program \a program with OpenMode \a mode.
+		 *
+		 * The program and its arguments are split from \a program
+		 * like QProcess does it: arguments that contain spaces are
+		 * surrounded by double quotes, and three consecutive double
+		 * quotes stand for a literal double quote.
+		 */
+		void start(const QString& program,
+			   OpenMode mode = ReadWrite);
+
+		/*!
+		 * Blocks until the process has finished and the finished()
+		 * signal has been emitted.
+		 *
+		 * Times out after \a msecs milliseconds. If \a msecs is -1
+		 * the function will not time out.
+		 *
+		 * \return true if the process finished.
+		 */
+		bool waitForFinished(int msecs = 30000);
+
+		/*!
+		 * Returns true if the process started successfully.
+		 * Doesn't really wait for anything since the start() method
+		 * already did the waiting.
+		 */
+		bool waitForStarted(int msecs = 30000);
+
+	public slots:
+		/*! Kills the process, causing it to exit immediately. */
+		void kill();
+
+	signals:
+		/*!
+		 * Emitted when the process finishes.
+		 * \param exitCode exit code of the process
+		 * \param exitStatus exit status of the process
+		 */
+		void finished(int exitCode, ExitStatus exitStatus);
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private slots:
+		void onReadyRead();
+		void onExitTimeout();
+
+	private:
+		static QStringList splitCommand(const QString& command);
+
+		bool readOutput();
+		void closeOutput();
+		bool reap(bool block);
+		void onFinished();
+		void cleanup();
+
+		bool m_started;
+		bool m_finished;
+		int m_exitCode;
+		ExitStatus m_exitStatus;
+		QString m_workDir;
+		QString m_stdErrFile;
+		OpenMode m_stdErrFileMode;
+		qint64 m_pid;
+		int m_inWrite;
+		int m_outRead;
+		QByteArray m_buffer;
+		QSocketNotifier* m_notifier;
+		QTimer* m_exitTimer;
+};
+
+#endif // ENGINEPROCESS_UNIX_H
@@ -56,6 +56,13 @@ int EngineProcess::exitCode() const
 	return (int)m_exitCode;
 }
 
+qint64 EngineProcess::processId() const
+{
+	if (!m_started)
+		return 0;
+	return qint64(m_processInfo.dwProcessId);
+}
+
 EngineProcess::ExitStatus EngineProcess::exitStatus() const
 {
 	return m_exitStatus;
@@ -90,11 +97,7 @@ void EngineProcess::cleanup()
 {
 	if (m_reader != 0)
 	{
-		if (m_reader->isRunning())
-		{
-			qWarning("EngineProcess: pipe reader was terminated");
-			m_reader->terminate();
-		}
+		// Deleting the reader cancels its pending read
 		delete m_reader;
 		m_reader = 0;
 	}
@@ -264,7 +267,8 @@ void EngineProcess::start(const QString& program,
 	saAttr.bInheritHandle = TRUE;
 	saAttr.lpSecurityDescriptor = NULL;
 
-	CreatePipe(&m_outRead, &outWrite, &saAttr, 0);
+	// The engine's output is read with overlapped I/O
+	PipeReader::createPipe(&m_outRead, &outWrite, &saAttr);
 	CreatePipe(&inRead, &m_inWrite, &saAttr, 0);
 
 	STARTUPINFO startupInfo;
@@ -275,15 +279,9 @@ void EngineProcess::start(const QString& program,
 	startupInfo.hStdInput = inRead;
 	startupInfo.dwFlags |= STARTF_USESTDHANDLES;
 
-	// Call DuplicateHandle with a NULL target to get non-inheritable
-	// handles for the parent process' ends of the pipes
-	DuplicateHandle(GetCurrentProcess(),
-			m_outRead,		// child's stdout read end
-			GetCurrentProcess(),
-			NULL,			// no target
-			0,			// flags
-			FALSE,			// not inheritable
-			DUPLICATE_SAME_ACCESS);	// same handle access
+	// Call DuplicateHandle with a NULL target to get a non-inheritable
+	// handle for the parent process' end of the input pipe. The read
+	// end of the output pipe is created non-inheritable.
 	DuplicateHandle(GetCurrentProcess(),
 			m_inWrite,		// child's stdin write end
 			GetCurrentProcess(),
@@ -408,10 +406,9 @@ bool EngineProcess::waitForFinished(int msecs)
 	DWORD ret = WaitForSingleObject(m_processInfo.hProcess, dwWait);
 	if (ret == WAIT_OBJECT_0)
 	{
-		// The blocking ReadFile call in the pipe reader should
-		// return now that the pipes are closed. But if it doesn't
-		// happen, the pipe reader will be terminated violently
-		// after the timeout.
+		// The pending read of the pipe reader should complete
+		// now that the pipes are closed. If it doesn't happen,
+		// the read is cancelled after the timeout.
 		m_reader->wait(10000);
 		onFinished();
 
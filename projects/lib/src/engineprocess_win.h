@@ -33,7 +33,7 @@ class PipeReader;
  * new data immediately (no polling) when it's available. The interface is
  * the same as QProcess' with some unneeded features left out.
  *
- * On non-Windows platforms EngineProcess is just a typedef to QProcess.
+ * On Unix platforms EngineProcess is implemented with vfork() instead.
  *
  * \sa QProcess
  * \sa PipeReader
@@ -66,6 +66,11 @@ class LIB_EXPORT EngineProcess : public QIODevice
 
 		/*! Returns the exit code of the last process that finished. */
 		int exitCode() const;
+		/*!
+		 * Returns the native process identifier of the running
+		 * process, or 0 if no process is running.
+		 */
+		qint64 processId() const;
 		/*! Returns the exit status of the last process that finished. */
 		ExitStatus exitStatus() const;
 
@@ -17,6 +17,79 @@
 
 #include "epdrecord.h"
 #include <QTextStream>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) \
+ || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EPDRECORD_SSE2
+#include <emmintrin.h>
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+inline bool s_isBlank(QChar c)
+{
+	return c == ' ' || c == '\t';
+}
+
+inline bool s_isSpecial(ushort c)
+{
+	return c == ' ' || c == '\t' || c == '\"' || c == ';';
+}
+
+#ifdef EPDRECORD_SSE2
+inline int s_lowestBit(unsigned mask)
+{
+#ifdef Q_CC_MSVC
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return int(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Returns the index of the first space, tab, quote or semicolon in
+// 'str' at or after 'from', or 'size' if there isn't one. The SSE2
+// version tests 8 characters at a time.
+int s_nextSpecial(const QChar* str, int from, int size)
+{
+	const ushort* s = reinterpret_cast<const ushort*>(str);
+	int i = from;
+
+#ifdef EPDRECORD_SSE2
+	const __m128i space = _mm_set1_epi16(' ');
+	const __m128i tab = _mm_set1_epi16('\t');
+	const __m128i quote = _mm_set1_epi16('\"');
+	const __m128i semicolon = _mm_set1_epi16(';');
+
+	for (; i + 8 <= size; i += 8)
+	{
+		const __m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(s + i));
+		const __m128i hits = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi16(chunk, space),
+				     _mm_cmpeq_epi16(chunk, tab)),
+			_mm_or_si128(_mm_cmpeq_epi16(chunk, quote),
+				     _mm_cmpeq_epi16(chunk, semicolon)));
+		const unsigned mask = unsigned(_mm_movemask_epi8(hits));
+		if (mask != 0)
+			return i + s_lowestBit(mask) / 2;
+	}
+#endif
+
+	for (; i < size; i++)
+	{
+		if (s_isSpecial(s[i]))
+			return i;
+	}
+	return size;
+}
+
+} // anonymous namespace
 
 EpdRecord::EpdRecord()
 {
@@ -34,67 +107,96 @@ bool EpdRecord::parse(QTextStream& stream)
 	m_fen.clear();
 	m_operations.clear();
 
+	// Skip the blank lines
+	const QChar* s = nullptr;
+	int size = 0;
+	int pos = 0;
+	forever
+	{
+		if (stream.atEnd())
+		{
+			m_line.clear();
+			return false;
+		}
+
+		m_line = stream.readLine();
+		s = m_line.constData();
+		size = m_line.size();
+		pos = 0;
+		while (pos < size && s_isBlank(s[pos]))
+			pos++;
+		if (pos < size)
+			break;
+	}
+
 	// Parse FEN
 	for (int i = 0; i < 4; i++)
 	{
-		QString tmp;
-		stream >> tmp;
-		if (stream.status() != QTextStream::Ok)
+		while (pos < size && s_isBlank(s[pos]))
+			pos++;
+		if (pos == size)
+		{
+			m_fen.clear();
 			return false;
+		}
+
+		int end = s_nextSpecial(s, pos, size);
+		while (end < size && !s_isBlank(s[end]))
+			end = s_nextSpecial(s, end + 1, size);
 
-		m_fen.append(tmp);
-		if (i < 3)
-			m_fen.append(" ");
+		if (i > 0)
+			m_fen.append(' ');
+		m_fen.append(s + pos, end - pos);
+		pos = end;
 	}
 
-	// Parse the operations
-	QString opcode;
-	QString operand;
+	// Find the operations. Only the special characters are looked
+	// at one by one, the runs between them are skipped as a whole.
+	Operation op = { -1, 0, -1, -1 };
 	TokenType type = SeparatorToken;
 	bool inQuotes = false;
+	bool operandEmpty = true;
 	bool ok = true;
-	while (stream.status() == QTextStream::Ok)
+	int lastBreak = -1;
+	while (ok && pos < size)
 	{
-		QChar c;
-		stream >> c;
-
-		switch (c.toLatin1())
+		const int next = s_nextSpecial(s, pos, size);
+		if (next > pos)
 		{
-		case '\n':
-			return true;
-		case ' ':
-		case '\t':
-			if (inQuotes && type == OperandToken)
-				operand.append(c);
-			else if (type != SeparatorToken)
+			if (type == SeparatorToken)
 			{
-				if (type == OpcodeToken)
-					type = OperandToken;
-				else
-				{
-					m_operations[opcode].append(operand);
-					operand.clear();
-				}
+				type = OpcodeToken;
+				op.opcodeStart = pos;
 			}
-			break;
-		case '\"':
 			if (type == OpcodeToken)
-			{
-				ok = false;
+				op.opcodeLength = next - op.opcodeStart;
+			else
+				operandEmpty = false;
+			if (next == size)
 				break;
-			}
-			else if (type == SeparatorToken)
+		}
+		pos = next + 1;
+
+		switch (s[next].unicode())
+		{
+		case ' ':
+		case '\t':
+			if (inQuotes)
+				operandEmpty = false;
+			else if (type == OpcodeToken)
 			{
-				if (opcode.isEmpty())
-				{
-					ok = false;
-					break;
-				}
 				type = OperandToken;
+				op.operandStart = pos;
 			}
-			else if (type == OperandToken
-			     &&  !inQuotes
-			     &&  !operand.isEmpty())
+			else if (type == OperandToken)
+			{
+				operandEmpty = true;
+				lastBreak = next;
+			}
+			break;
+		case '\"':
+			if (type != OperandToken
+			||  (!inQuotes && !operandEmpty))
 			{
 				ok = false;
 				break;
@@ -102,43 +204,54 @@ bool EpdRecord::parse(QTextStream& stream)
 			inQuotes = !inQuotes;
 			break;
 		case ';':
-			if (!inQuotes)
+			if (inQuotes)
 			{
-				if (opcode.isEmpty())
-				{
-					ok = false;
-					break;
-				}
-				m_operations[opcode].append(operand);
-				opcode.clear();
-				operand.clear();
-				type = SeparatorToken;
+				operandEmpty = false;
+				break;
 			}
-			break;
-		default:
 			if (type == SeparatorToken)
-				type = OpcodeToken;
-			if (type == OpcodeToken)
-				opcode.append(c);
-			else
-				operand.append(c);
+			{
+				ok = false;
+				break;
+			}
+			op.end = next;
+			m_operations.append(op);
+			op.operandStart = -1;
+			type = SeparatorToken;
+			operandEmpty = true;
+			lastBreak = -1;
 			break;
 		}
+	}
 
-		if (!ok)
-		{
-			while (!stream.atEnd() && c != '\n')
-				stream >> c;
-			return false;
-		}
+	// An unterminated operation keeps the operands that were
+	// already separated by whitespace
+	if (type == OperandToken && lastBreak != -1)
+	{
+		op.end = lastBreak;
+		m_operations.append(op);
 	}
 
-	return true;
+	return ok;
+}
+
+bool EpdRecord::isOpcode(const Operation& op, const QString& opcode) const
+{
+	if (op.opcodeLength != opcode.size())
+		return false;
+
+	const QChar* s = m_line.constData() + op.opcodeStart;
+	return std::equal(s, s + op.opcodeLength, opcode.constData());
 }
 
 bool EpdRecord::hasOpcode(const QString& opcode) const
 {
-	return m_operations.contains(opcode);
+	for (const Operation& op : m_operations)
+	{
+		if (isOpcode(op, opcode))
+			return true;
+	}
+	return false;
 }
 
 QString EpdRecord::fen() const
@@ -148,5 +261,45 @@ QString EpdRecord::fen() const
 
 QStringList EpdRecord::operands(const QString& opcode) const
 {
-	return m_operations.value(opcode);
+	QStringList operands;
+	const QChar* s = m_line.constData();
+
+	for (const Operation& op : m_operations)
+	{
+		if (!isOpcode(op, opcode))
+			continue;
+		if (op.operandStart == -1)
+		{
+			operands.append(QString());
+			continue;
+		}
+
+		// The operation was validated by parse(), so the quotes
+		// are balanced and only need to be dropped
+		QString operand;
+		bool inQuotes = false;
+		int pos = op.operandStart;
+		forever
+		{
+			const int next = s_nextSpecial(s, pos, op.end);
+			operand.append(s + pos, next - pos);
+			if (next == op.end)
+				break;
+			pos = next + 1;
+
+			const QChar c = s[next];
+			if (c == '\"')
+				inQuotes = !inQuotes;
+			else if (inQuotes || c == ';')
+				operand.append(c);
+			else
+			{
+				operands.append(operand);
+				operand.clear();
+			}
+		}
+		operands.append(operand);
+	}
+
+	return operands;
 }
@@ -19,7 +19,7 @@
 #define EPDRECORD_H
 
 #include <QStringList>
-#include <QMap>
+#include <QVector>
 class QTextStream;
 
 /*!
@@ -38,6 +38,11 @@ class QTextStream;
  * records from EPD files, but in the future it may also be used to
  * build new EPD test suites etc.
  *
+ * Parsing only locates the FEN fields and the boundaries of the
+ * operations in the record's line. The operands are split and
+ * unquoted when they are requested with operands(), so reading a
+ * record that is only needed for its position is cheap.
+ *
  * \sa OpeningSuite
  */
 class LIB_EXPORT EpdRecord
@@ -66,8 +71,20 @@ class LIB_EXPORT EpdRecord
 		QStringList operands(const QString& opcode) const;
 
 	private:
+		struct Operation
+		{
+			int opcodeStart;
+			int opcodeLength;
+			int operandStart;
+			int end;
+		};
+
+		bool isOpcode(const Operation& op,
+			      const QString& opcode) const;
+
+		QString m_line;
 		QString m_fen;
-		QMap<QString, QStringList> m_operations;
+		QVector<Operation> m_operations;
 };
 
 #endif // EPDRECORD_H
@@ -0,0 +1,145 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTRING_H
+#define EVENTRING_H
+
+#include <QAtomicInteger>
+#include <vector>
+
+
+/*!
+ * \brief A lock-free single-producer, single-consumer event queue
+ *
+ * EventRing passes events of type \a T from one thread to another
+ * through a fixed-size ring buffer. Exactly one thread may call
+ * push() and exactly one (other) thread may call drain(); neither
+ * of them ever blocks or takes a lock.
+ *
+ * The producer uses push()'s return value to decide when to wake up
+ * the consumer: only the first event after a drain() needs a wakeup,
+ * so the consumer gets one notification, eg. a queued signal, per
+ * batch of events instead of one per event.
+ *
+ * \note The capacity is rounded up to a power of two. If the ring is
+ * full the new event is dropped and counted in droppedCount().
+ */
+template<typename T>
+class EventRing
+{
+	public:
+		/*! The result of push(). */
+		enum PushResult
+		{
+			Queued,		//!< Queued, the consumer is already notified
+			QueuedAndWake,	//!< Queued, the consumer must be notified
+			Dropped		//!< The ring was full
+		};
+
+		/*! Creates a new ring that holds up to \a capacity events. */
+		explicit EventRing(int capacity = 256);
+
+		/*!
+		 * Queues \a event.
+		 *
+		 * Must only be called from the producer thread.
+		 */
+		PushResult push(const T& event);
+		/*!
+		 * Passes every queued event to \a func in FIFO order and
+		 * returns the number of events taken.
+		 *
+		 * Must only be called from the consumer thread.
+		 */
+		template<typename Func>
+		int drain(Func func);
+		/*! Returns the number of events dropped because of a full ring. */
+		int droppedCount() const;
+
+	private:
+		Q_DISABLE_COPY(EventRing)
+
+		std::vector<T> m_events;
+		quint32 m_mask;
+		QAtomicInteger<quint32> m_head;
+		QAtomicInteger<quint32> m_tail;
+		QAtomicInt m_wakePending;
+		QAtomicInt m_dropped;
+};
+
+
+template<typename T>
+EventRing<T>::EventRing(int capacity)
+	: m_mask(1),
+	  m_head(0),
+	  m_tail(0),
+	  m_wakePending(0),
+	  m_dropped(0)
+{
+	while (m_mask + 1 < quint32(qMax(capacity, 2)))
+		m_mask = (m_mask << 1) | 1;
+	m_events.resize(m_mask + 1);
+}
+
+template<typename T>
+typename EventRing<T>::PushResult EventRing<T>::push(const T& event)
+{
+	// The indexes run freely and wrap around; only their difference
+	// and the masked slot matter
+	const quint32 tail = m_tail.load();
+	if (tail - m_head.loadAcquire() > m_mask)
+	{
+		m_dropped.ref();
+		return Dropped;
+	}
+
+	m_events[tail & m_mask] = event;
+	m_tail.storeRelease(tail + 1);
+
+	return m_wakePending.fetchAndStoreOrdered(1) ? Queued : QueuedAndWake;
+}
+
+template<typename T>
+template<typename Func>
+int EventRing<T>::drain(Func func)
+{
+	// Clearing the flag first means that an event pushed while
+	// draining either is taken below or triggers a new wakeup
+	m_wakePending.fetchAndStoreOrdered(0);
+
+	quint32 head = m_head.load();
+	const quint32 tail = m_tail.loadAcquire();
+	const int count = int(tail - head);
+
+	for (; head != tail; head++)
+	{
+		T& slot = m_events[head & m_mask];
+		func(slot);
+		slot = T();
+		m_head.storeRelease(head + 1);
+	}
+
+	return count;
+}
+
+template<typename T>
+int EventRing<T>::droppedCount() const
+{
+	return m_dropped.load();
+}
+
+#endif // EVENTRING_H
@@ -19,6 +19,30 @@
 #include "board/board.h"
 #include "moveevaluation.h"
 
+namespace {
+
+// Returns the number of plies to mate in 'score', which is negative
+// if the player is getting mated, or 0 if 'score' isn't a mate score.
+// The mate scores are detected like in MoveEvaluation::scoreText().
+int matePlies(int score)
+{
+	const int absScore = qAbs(score);
+	if (absScore <= 98800)
+		return 0;
+
+	const int plies = 1000 - (absScore % 1000);
+	if (plies >= 200)
+		return 0;
+	return (score > 0) ? plies : -plies;
+}
+
+QString mateText(int plies)
+{
+	return QString(plies > 0 ? "+M%1" : "-M%1").arg(qAbs(plies));
+}
+
+} // anonymous namespace
+
 GameAdjudicator::GameAdjudicator()
 	: m_drawMoveNum(0),
 	  m_drawMoveCount(0),
@@ -26,10 +50,16 @@ GameAdjudicator::GameAdjudicator()
 	  m_drawScoreCount(0),
 	  m_resignMoveCount(0),
 	  m_resignScore(0),
+	  m_mateMoveCount(0),
+	  m_mateDistance(0),
+	  m_mateScoreCount(0),
+	  m_maxPlyCount(0),
 	  m_tbEnabled(false)
 {
 	m_resignScoreCount[0] = 0;
 	m_resignScoreCount[1] = 0;
+	m_matePlies[0] = 0;
+	m_matePlies[1] = 0;
 }
 
 void GameAdjudicator::setDrawThreshold(int moveNumber, int moveCount, int score)
@@ -53,14 +83,59 @@ void GameAdjudicator::setResignThreshold(int moveCount, int score)
 	m_resignScoreCount[1] = 0;
 }
 
+void GameAdjudicator::setMateThreshold(int moveCount, int distance)
+{
+	Q_ASSERT(moveCount >= 0);
+	Q_ASSERT(distance >= 0);
+
+	m_mateMoveCount = moveCount;
+	m_mateDistance = distance;
+	m_mateScoreCount = 0;
+}
+
 void GameAdjudicator::setTablebaseAdjudication(bool enable)
 {
 	m_tbEnabled = enable;
 }
 
+bool GameAdjudicator::tablebaseAdjudication() const
+{
+	return m_tbEnabled;
+}
+
+QString GameAdjudicator::settingsString() const
+{
+	QString str = QString("draw %1 %2 %3, resign %4 %5, maxplies %6, tb %7")
+		.arg(m_drawMoveNum).arg(m_drawMoveCount).arg(m_drawScore)
+		.arg(m_resignMoveCount).arg(m_resignScore)
+		.arg(m_maxPlyCount).arg(m_tbEnabled);
+	// Left out when disabled so that the older settings stay the same
+	if (m_mateMoveCount > 0)
+		str += QString(", mate %1 %2").arg(m_mateMoveCount)
+					      .arg(m_mateDistance);
+	return str;
+}
+
+void GameAdjudicator::setMaximumGameLength(int moveCount)
+{
+	Q_ASSERT(moveCount >= 0);
+	m_maxPlyCount = moveCount * 2;
+}
+
+void GameAdjudicator::setMaximumPlyCount(int plyCount)
+{
+	Q_ASSERT(plyCount >= 0);
+	m_maxPlyCount = plyCount;
+}
+
 void GameAdjudicator::addEval(const Chess::Board* board, const MoveEvaluation& eval)
 {
-	Chess::Side side = board->sideToMove().opposite();
+	PlyState state;
+	state.side = board->sideToMove().opposite();
+	state.plyCount = board->plyCount();
+	state.reversibleMoves = board->reversibleMoveCount();
+	state.score = eval.score();
+	state.depth = eval.depth();
 
 	// Tablebase adjudication
 	if (m_tbEnabled)
@@ -70,43 +145,101 @@ void GameAdjudicator::addEval(const Chess::Board* board, const MoveEvaluation& e
 			return;
 	}
 
+	if (state.reversibleMoves == 0)
+		m_drawScoreCount = 0;
+
+	if (adjudicateGameLength(state))
+		return;
+
 	// Moves forced by the user (eg. from opening book or played by user)
-	if (eval.depth() <= 0)
+	if (state.depth <= 0)
 	{
 		m_drawScoreCount = 0;
-		m_resignScoreCount[side] = 0;
+		m_resignScoreCount[state.side] = 0;
+		m_mateScoreCount = 0;
 		return;
 	}
 
-	// Draw adjudication
-	if (m_drawMoveNum > 0)
-	{
-		if (qAbs(eval.score()) <= m_drawScore)
-			m_drawScoreCount++;
-		else
-			m_drawScoreCount = 0;
-		if (board->plyCount() / 2 >= m_drawMoveNum
-		&&  m_drawScoreCount >= m_drawMoveCount * 2)
-		{
-			m_result = Chess::Result(Chess::Result::Adjudication,
-						Chess::Side::NoSide, "TCEC draw rule");
-			return;
-		}
-	}
+	if (adjudicateDraw(state))
+		return;
+	if (adjudicateMate(state))
+		return;
+	adjudicateResign(state);
+}
+
+bool GameAdjudicator::adjudicateGameLength(const PlyState& state)
+{
+	if (m_maxPlyCount <= 0 || state.plyCount < m_maxPlyCount)
+		return false;
+
+	m_result = Chess::Result(Chess::Result::Adjudication,
+				 Chess::Side::NoSide, "max moves rule");
+	return true;
+}
+
+bool GameAdjudicator::adjudicateDraw(const PlyState& state)
+{
+	if (m_drawMoveNum <= 0)
+		return false;
+
+	if (qAbs(state.score) <= m_drawScore)
+		m_drawScoreCount++;
+	else
+		m_drawScoreCount = 0;
+	if (state.plyCount / 2 < m_drawMoveNum
+	||  m_drawScoreCount < m_drawMoveCount * 2)
+		return false;
+
+	m_result = Chess::Result(Chess::Result::Adjudication,
+				 Chess::Side::NoSide, "TCEC draw rule");
+	return true;
+}
 
-	// Resign adjudication
-	if (m_resignMoveCount > 0)
+bool GameAdjudicator::adjudicateResign(const PlyState& state)
+{
+	if (m_resignMoveCount <= 0)
+		return false;
+
+	int& count = m_resignScoreCount[state.side];
+	if (state.score <= m_resignScore)
+		count++;
+	else
+		count = 0;
+	if (count < m_resignMoveCount)
+		return false;
+
+	m_result = Chess::Result(Chess::Result::Adjudication,
+				 state.side.opposite(), "TCEC win rule");
+	return true;
+}
+
+bool GameAdjudicator::adjudicateMate(const PlyState& state)
+{
+	if (m_mateMoveCount <= 0)
+		return false;
+
+	const int plies = matePlies(state.score);
+	if (plies == 0 || (qAbs(plies) + 1) / 2 > m_mateDistance)
 	{
-		int& count = m_resignScoreCount[side];
-		if (eval.score() <= m_resignScore)
-			count++;
-		else
-			count = 0;
-
-		if (count >= m_resignMoveCount)
-			m_result = Chess::Result(Chess::Result::Adjudication,
-						 side.opposite(), "TCEC win rule");
+		m_mateScoreCount = 0;
+		return false;
 	}
+
+	// Both players have to agree on the winner
+	const Chess::Side winner = (plies > 0) ? state.side
+					       : state.side.opposite();
+	if (m_mateScoreCount > 0 && winner != m_mateWinner)
+		m_mateScoreCount = 0;
+	m_mateWinner = winner;
+	m_matePlies[state.side] = plies;
+	if (++m_mateScoreCount < m_mateMoveCount * 2)
+		return false;
+
+	m_result = Chess::Result(Chess::Result::Adjudication, winner,
+				 QString("mate score rule, %1 %2")
+				 .arg(mateText(m_matePlies[winner]))
+				 .arg(mateText(m_matePlies[winner.opposite()])));
+	return true;
 }
 
 void GameAdjudicator::resetDrawMoveCount()
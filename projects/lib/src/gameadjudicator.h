@@ -19,6 +19,7 @@
 #define GAMEADJUDICATOR_H
 
 #include "board/result.h"
+#include "board/side.h"
 namespace Chess { class Board; }
 class MoveEvaluation;
 
@@ -27,6 +28,12 @@ class MoveEvaluation;
  *
  * The GameAdjudicator class can be used to adjudicate chess games when
  * the probability of a specific result is high enough.
+ *
+ * The adjudicator keeps only running counters. Each move is reduced
+ * to a small per-ply state that the board provides in constant time
+ * (eg. the ply count and the number of reversible moves), and every
+ * rule updates its own counters from that state. Adding a rule
+ * never makes adjudication slower as the game gets longer.
  */
 class LIB_EXPORT GameAdjudicator
 {
@@ -56,6 +63,31 @@ class LIB_EXPORT GameAdjudicator
 		 * consecutive moves.
 		 */
 		void setResignThreshold(int moveCount, int score);
+		/*!
+		 * Sets the mate score adjudication threshold for each game.
+		 *
+		 * A game will be adjudicated as a win for the player that
+		 * both players agree is mating if both report a forced
+		 * mate in at most \a distance full moves for at least
+		 * \a moveCount consecutive moves. The result's description
+		 * has the last mate scores of both players.
+		 */
+		void setMateThreshold(int moveCount, int distance);
+		/*!
+		 * Sets the maximum game length to \a moveCount full moves.
+		 *
+		 * A game that is still going on after \a moveCount moves is
+		 * adjudicated as a draw. The default is 0, which means no
+		 * limit.
+		 */
+		void setMaximumGameLength(int moveCount);
+		/*!
+		 * Sets the maximum game length to \a plyCount plies.
+		 *
+		 * This is like setMaximumGameLength() but counts half
+		 * moves, eg. for stopping after the first move.
+		 */
+		void setMaximumPlyCount(int plyCount);
 		/*!
 		 * Sets tablebase adjudication to \a enable.
 		 *
@@ -63,6 +95,18 @@ class LIB_EXPORT GameAdjudicator
 		 * latest position is found in the tablebases.
 		 */
 		void setTablebaseAdjudication(bool enable);
+		/*!
+		 * Returns true if tablebase adjudication is enabled;
+		 * otherwise returns false.
+		 */
+		bool tablebaseAdjudication() const;
+		/*!
+		 * Returns the adjudication settings as a string.
+		 *
+		 * Adjudicators with the same settings return the same string,
+		 * regardless of the games they have seen.
+		 */
+		QString settingsString() const;
 
 		/*!
 		 * Adds a new move evaluation to the adjudicator.
@@ -74,7 +118,11 @@ class LIB_EXPORT GameAdjudicator
 		 * the game should be adjudicated.
 		 */
 		void addEval(const Chess::Board* board, const MoveEvaluation& eval);
-		/*! Sets draw move count to 0. */
+		/*!
+		 * Sets draw move count to 0.
+		 *
+		 * addEval() does this itself after an irreversible move.
+		 */
 		void resetDrawMoveCount();
 		/*!
 		 * Returns the adjudication result.
@@ -85,6 +133,21 @@ class LIB_EXPORT GameAdjudicator
 		Chess::Result result() const;
 
 	private:
+		/*! The state of the game after a move. */
+		struct PlyState
+		{
+			Chess::Side side;	//!< The side that made the move
+			int plyCount;		//!< Plies played, including the move
+			int reversibleMoves;	//!< Plies since the last irreversible move
+			int score;		//!< The mover's score
+			int depth;		//!< The mover's search depth
+		};
+
+		bool adjudicateGameLength(const PlyState& state);
+		bool adjudicateDraw(const PlyState& state);
+		bool adjudicateResign(const PlyState& state);
+		bool adjudicateMate(const PlyState& state);
+
 		int m_drawMoveNum;
 		int m_drawMoveCount;
 		int m_drawScore;
@@ -92,6 +155,12 @@ class LIB_EXPORT GameAdjudicator
 		int m_resignMoveCount;
 		int m_resignScore;
 		int m_resignScoreCount[2];
+		int m_mateMoveCount;
+		int m_mateDistance;
+		int m_mateScoreCount;
+		Chess::Side m_mateWinner;
+		int m_matePlies[2];
+		int m_maxPlyCount;
 		bool m_tbEnabled;
 		Chess::Result m_result;
 };
@@ -0,0 +1,827 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gamearchive.h"
+#include <algorithm>
+#include <QScopedPointer>
+#include <QtEndian>
+#include "board/board.h"
+#include "gamewriter.h"
+#include "pgngame.h"
+
+namespace {
+
+// File header: magic and format version
+const char s_magic[4] = { 'C', 'C', 'G', 'A' };
+const char s_version = 1;
+const qint64 s_headerSize = 8;
+
+// File trailer: footer position and magic
+const char s_footerMagic[8] = { 'C', 'C', 'G', 'A', 'I', 'N', 'D', 'X' };
+const qint64 s_trailerSize = 16;
+
+enum ChunkType
+{
+	StringChunk = 'S',
+	GameChunk = 'G',
+	FooterChunk = 'I'
+};
+
+enum CommentType
+{
+	NoComment,
+	BookComment,
+	TextComment,
+	EvalComment
+};
+
+enum EvalFlag
+{
+	HasR50 = 1,
+	MateScore = 2
+};
+
+/*
+ * The fields of an evaluation comment written by ChessGame:
+ * "d=DEPTH[, pd=MOVE], mt=TIME, tl=TIME, s=SPEED kN/s, n=NODES,
+ * pv=PV, tb=HITS[, R50=COUNT], wv=SCORE,"
+ * followed by optional free text (eg. the result description).
+ */
+struct EvalData
+{
+	quint8 flags;
+	quint16 depth;
+	quint32 moveTime;
+	quint32 timeLeft;
+	qint32 speed;
+	quint64 nodes;
+	quint64 tbHits;
+	qint16 r50;
+	qint32 score;
+	QVector<int> pv;
+	QString suffix;
+};
+
+void writeVarint(QByteArray& out, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		out.append(char((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.append(char(value));
+}
+
+template <typename T>
+void writeFixed(QByteArray& out, T value)
+{
+	uchar buf[sizeof(T)];
+	qToLittleEndian(value, buf);
+	out.append(reinterpret_cast<const char*>(buf), int(sizeof(T)));
+}
+
+void writeText(QByteArray& out, const QString& str)
+{
+	const QByteArray utf8(str.toUtf8());
+	writeVarint(out, quint64(utf8.size()));
+	out.append(utf8);
+}
+
+class Reader
+{
+	public:
+		explicit Reader(const QByteArray& data)
+			: m_pos(data.constData()),
+			  m_end(data.constData() + data.size()),
+			  m_ok(true)
+		{
+		}
+
+		bool isOk() const
+		{
+			return m_ok;
+		}
+
+		quint64 varint()
+		{
+			quint64 value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				if (m_pos >= m_end)
+					break;
+				const uchar c = uchar(*m_pos++);
+				value |= quint64(c & 0x7f) << shift;
+				if (!(c & 0x80))
+					return value;
+			}
+			m_ok = false;
+			return 0;
+		}
+
+		template <typename T>
+		T fixed()
+		{
+			if (m_end - m_pos < qint64(sizeof(T)))
+			{
+				m_ok = false;
+				return T(0);
+			}
+			const T value = qFromLittleEndian<T>(
+				reinterpret_cast<const uchar*>(m_pos));
+			m_pos += sizeof(T);
+			return value;
+		}
+
+		QString text()
+		{
+			const quint64 size = varint();
+			if (size > quint64(m_end - m_pos))
+			{
+				m_ok = false;
+				return QString();
+			}
+			const QString str(QString::fromUtf8(m_pos, int(size)));
+			m_pos += size;
+			return str;
+		}
+
+	private:
+		const char* m_pos;
+		const char* m_end;
+		bool m_ok;
+};
+
+quint32 sortKey(const Chess::GenericMove& move)
+{
+	const auto square = [](const Chess::Square& sq)
+	{
+		return quint32((sq.file() + 1) & 0x3f)
+		     | quint32(((sq.rank() + 1) & 0x3f) << 6);
+	};
+	return square(move.sourceSquare())
+	     | (square(move.targetSquare()) << 12)
+	     | (quint32(move.promotion() & 0xff) << 24);
+}
+
+/*
+ * Returns the legal moves of \a board sorted by their generic
+ * notation, which doesn't depend on the move generator.
+ */
+QVector<Chess::Move> sortedMoves(Chess::Board* board)
+{
+	Chess::MoveList moves;
+	board->legalMoves(moves);
+
+	QVector< QPair<quint32, Chess::Move> > keys;
+	keys.reserve(moves.size());
+	for (const auto& move : moves)
+		keys.append(qMakePair(sortKey(board->genericMove(move)), move));
+	std::sort(keys.begin(), keys.end(),
+		  [](const QPair<quint32, Chess::Move>& a,
+		     const QPair<quint32, Chess::Move>& b)
+	{
+		return a.first < b.first;
+	});
+
+	QVector<Chess::Move> sorted;
+	sorted.reserve(keys.size());
+	for (const auto& key : keys)
+		sorted.append(key.second);
+	return sorted;
+}
+
+int moveIndex(Chess::Board* board, const Chess::Move& move)
+{
+	return sortedMoves(board).indexOf(move);
+}
+
+QString clockString(quint32 seconds)
+{
+	const QChar zero('0');
+	return QString("%1:%2:%3")
+		.arg(seconds / 3600, 2, 10, zero)
+		.arg((seconds / 60) % 60, 2, 10, zero)
+		.arg(seconds % 60, 2, 10, zero);
+}
+
+bool parseClock(const QString& str, quint32& seconds)
+{
+	const QStringList parts(str.split(':'));
+	if (parts.size() != 3)
+		return false;
+
+	seconds = 0;
+	for (const QString& part : parts)
+	{
+		bool ok = false;
+		const uint value = part.toUInt(&ok);
+		if (!ok || part.size() != 2)
+			return false;
+		seconds = seconds * 60 + value;
+	}
+	return true;
+}
+
+bool formatEval(const EvalData& eval, Chess::Board* board, QString& str)
+{
+	QStringList pv;
+	for (int index : eval.pv)
+	{
+		const auto moves = sortedMoves(board);
+		if (index < 0 || index >= moves.size())
+			break;
+		pv.append(board->moveString(moves.at(index),
+					    Chess::Board::StandardAlgebraic));
+		board->makeMove(moves.at(index));
+	}
+	for (int i = 0; i < pv.size(); i++)
+		board->undoMove();
+	if (pv.size() != eval.pv.size())
+		return false;
+
+	str = "d=" + QString::number(eval.depth);
+	if (pv.size() > 1)
+		str += ", pd=" + pv.at(1);
+	str += ", mt=" + clockString(eval.moveTime);
+	str += ", tl=" + clockString(eval.timeLeft);
+	str += ", s=" + QString::number(eval.speed) + " kN/s";
+	str += ", n=" + QString::number(eval.nodes);
+	str += ", pv=" + pv.join(' ');
+	str += ", tb=" + QString::number(eval.tbHits);
+	if (eval.flags & HasR50)
+		str += ", R50=" + QString::number(eval.r50);
+
+	str += ", wv=";
+	if (eval.flags & MateScore)
+	{
+		if (eval.score < 0)
+			str += '-';
+		str += 'M' + QString::number(qAbs(eval.score));
+	}
+	else
+		str += QString::number(double(eval.score) / 100.0, 'f', 2);
+
+	str += ',' + eval.suffix;
+	return true;
+}
+
+bool parseEval(const QString& comment, Chess::Board* board, EvalData& eval)
+{
+	int pos = 0;
+	auto field = [&](const char* name, const char* end, QString& value)
+	{
+		const QString prefix(QString::fromLatin1(name) + '=');
+		if (!comment.midRef(pos).startsWith(prefix))
+			return false;
+		const int start = pos + prefix.size();
+		const int stop = comment.indexOf(QLatin1String(end), start);
+		if (stop == -1)
+			return false;
+		value = comment.mid(start, stop - start);
+		pos = stop + int(qstrlen(end));
+		return true;
+	};
+
+	QString depth, moveTime, timeLeft, speed, nodes, pv, tbHits, r50, score;
+	QString ponderMove;
+	if (!field("d", ", ", depth))
+		return false;
+	field("pd", ", ", ponderMove);
+	if (!field("mt", ", ", moveTime)
+	||  !field("tl", ", ", timeLeft)
+	||  !field("s", " kN/s, ", speed)
+	||  !field("n", ", ", nodes)
+	||  !field("pv", ", ", pv)
+	||  !field("tb", ", ", tbHits))
+		return false;
+	eval.flags = 0;
+	if (field("R50", ", ", r50))
+		eval.flags |= HasR50;
+	if (!field("wv", ",", score))
+		return false;
+	eval.suffix = comment.mid(pos);
+
+	bool ok = true;
+	auto check = [&ok](bool fieldOk)
+	{
+		ok = ok && fieldOk;
+	};
+	bool fieldOk;
+	eval.depth = depth.toUShort(&fieldOk);
+	check(fieldOk);
+	check(parseClock(moveTime, eval.moveTime));
+	check(parseClock(timeLeft, eval.timeLeft));
+	eval.speed = speed.toInt(&fieldOk);
+	check(fieldOk);
+	eval.nodes = nodes.toULongLong(&fieldOk);
+	check(fieldOk);
+	eval.tbHits = tbHits.toULongLong(&fieldOk);
+	check(fieldOk);
+	eval.r50 = (eval.flags & HasR50) ? r50.toShort(&fieldOk) : 0;
+	check(fieldOk || !(eval.flags & HasR50));
+
+	const int mate = score.indexOf('M');
+	if (mate != -1)
+	{
+		eval.flags |= MateScore;
+		eval.score = score.mid(mate + 1).toInt(&fieldOk);
+		check(fieldOk && mate == int(score.startsWith('-')));
+		if (mate == 1)
+			eval.score = -eval.score;
+	}
+	else
+	{
+		eval.score = qRound(score.toDouble(&fieldOk) * 100.0);
+		check(fieldOk);
+	}
+	if (!ok)
+		return false;
+
+	eval.pv.clear();
+	const QStringList moves(pv.split(' ', QString::SkipEmptyParts));
+	for (const QString& str : moves)
+	{
+		const Chess::Move move(board->moveFromString(str));
+		if (move.isNull())
+			break;
+		eval.pv.append(moveIndex(board, move));
+		board->makeMove(move);
+	}
+	for (int i = 0; i < eval.pv.size(); i++)
+		board->undoMove();
+	if (eval.pv.size() != moves.size())
+		return false;
+
+	// Only use the compact form if it reproduces the comment exactly
+	QString str;
+	return formatEval(eval, board, str) && str == comment;
+}
+
+void writeEval(QByteArray& out, const EvalData& eval)
+{
+	writeFixed<quint8>(out, eval.flags);
+	writeFixed<quint16>(out, eval.depth);
+	writeFixed<quint32>(out, eval.moveTime);
+	writeFixed<quint32>(out, eval.timeLeft);
+	writeFixed<qint32>(out, eval.speed);
+	writeFixed<quint64>(out, eval.nodes);
+	writeFixed<quint64>(out, eval.tbHits);
+	writeFixed<qint16>(out, eval.r50);
+	writeFixed<qint32>(out, eval.score);
+	writeVarint(out, quint64(eval.pv.size()));
+	for (int index : eval.pv)
+		writeVarint(out, quint64(index));
+	writeText(out, eval.suffix);
+}
+
+void readEval(Reader& in, EvalData& eval)
+{
+	eval.flags = in.fixed<quint8>();
+	eval.depth = in.fixed<quint16>();
+	eval.moveTime = in.fixed<quint32>();
+	eval.timeLeft = in.fixed<quint32>();
+	eval.speed = in.fixed<qint32>();
+	eval.nodes = in.fixed<quint64>();
+	eval.tbHits = in.fixed<quint64>();
+	eval.r50 = in.fixed<qint16>();
+	eval.score = in.fixed<qint32>();
+
+	const quint64 count = in.varint();
+	eval.pv.clear();
+	for (quint64 i = 0; i < count && in.isOk(); i++)
+		eval.pv.append(int(in.varint()));
+	eval.suffix = in.text();
+}
+
+} // anonymous namespace
+
+GameArchive::GameArchive()
+	: m_end(0),
+	  m_modified(false)
+{
+}
+
+GameArchive::~GameArchive()
+{
+	close();
+}
+
+bool GameArchive::isArchive(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const QByteArray magic(file.read(sizeof(s_magic)));
+	return magic == QByteArray(s_magic, sizeof(s_magic));
+}
+
+bool GameArchive::open(const QString& fileName, QIODevice::OpenMode mode)
+{
+	close();
+	m_file.setFileName(fileName);
+
+	QIODevice::OpenMode fileMode = QIODevice::ReadOnly;
+	if (mode & QIODevice::Append)
+		fileMode = QIODevice::ReadWrite;
+	else if (mode & QIODevice::WriteOnly)
+		fileMode = QIODevice::ReadWrite | QIODevice::Truncate;
+	if (!m_file.open(fileMode))
+		return false;
+
+	if (m_file.size() == 0 && fileMode != QIODevice::ReadOnly)
+	{
+		QByteArray header(s_magic, sizeof(s_magic));
+		header.append(s_version);
+		header.append(QByteArray(int(s_headerSize) - header.size(), 0));
+		if (m_file.write(header) != header.size())
+		{
+			m_file.close();
+			return false;
+		}
+		m_end = s_headerSize;
+		m_modified = true;
+		return true;
+	}
+
+	const QByteArray header(m_file.read(s_headerSize));
+	if (header.size() != s_headerSize
+	||  !header.startsWith(QByteArray(s_magic, sizeof(s_magic)))
+	||  header.at(sizeof(s_magic)) != s_version)
+	{
+		qWarning("%s is not a valid game archive", qPrintable(fileName));
+		m_file.close();
+		return false;
+	}
+
+	if (!readFooter())
+		scan();
+
+	// The footer is rewritten when the archive is closed
+	if (fileMode != QIODevice::ReadOnly
+	&&  (m_end != m_file.size() && !m_file.resize(m_end)))
+	{
+		m_file.close();
+		return false;
+	}
+
+	return true;
+}
+
+void GameArchive::close(bool sync)
+{
+	if (!m_file.isOpen())
+		return;
+
+	if (m_modified && !writeFooter())
+		qWarning("Could not write the index of game archive %s",
+			 qPrintable(m_file.fileName()));
+	if (sync && m_file.isWritable())
+		GameWriter::syncFile(m_file);
+	m_file.close();
+
+	m_strings.clear();
+	m_stringIds.clear();
+	m_offsets.clear();
+	m_end = 0;
+	m_modified = false;
+}
+
+bool GameArchive::isOpen() const
+{
+	return m_file.isOpen();
+}
+
+QString GameArchive::fileName() const
+{
+	return m_file.fileName();
+}
+
+int GameArchive::gameCount() const
+{
+	return m_offsets.size();
+}
+
+bool GameArchive::flush(bool sync)
+{
+	if (!m_file.isOpen())
+		return false;
+	return sync ? GameWriter::syncFile(m_file) : m_file.flush();
+}
+
+bool GameArchive::readGame(int index, PgnGame& game)
+{
+	if (index < 0 || index >= m_offsets.size())
+		return false;
+
+	char type;
+	QByteArray payload;
+	return readChunk(m_offsets.at(index), type, payload)
+	    && type == GameChunk
+	    && decodeGame(payload, game);
+}
+
+bool GameArchive::writeGame(const PgnGame& game)
+{
+	if (!m_file.isOpen() || !m_file.isWritable())
+		return false;
+
+	QByteArray record;
+	QStringList newStrings;
+	if (!encodeGame(game, record, newStrings))
+		return false;
+
+	QByteArray data;
+	for (const QString& str : newStrings)
+	{
+		const QByteArray utf8(str.toUtf8());
+		data.append(char(StringChunk));
+		writeVarint(data, quint64(utf8.size()));
+		data.append(utf8);
+	}
+	const qint64 offset = m_end + data.size();
+	data.append(char(GameChunk));
+	writeVarint(data, quint64(record.size()));
+	data.append(record);
+
+	if (!m_file.seek(m_end) || m_file.write(data) != data.size())
+		return false;
+
+	for (const QString& str : newStrings)
+	{
+		m_stringIds[str] = m_strings.size();
+		m_strings.append(str);
+	}
+	m_offsets.append(offset);
+	m_end += data.size();
+	m_modified = true;
+
+	return true;
+}
+
+bool GameArchive::readChunk(qint64 pos, char& type, QByteArray& payload)
+{
+	if (!m_file.seek(pos) || !m_file.getChar(&type))
+		return false;
+
+	quint64 size = 0;
+	char c;
+	int shift = 0;
+	do
+	{
+		if (shift > 63 || !m_file.getChar(&c))
+			return false;
+		size |= quint64(uchar(c) & 0x7f) << shift;
+		shift += 7;
+	}
+	while (uchar(c) & 0x80);
+
+	if (size > quint64(m_file.size() - m_file.pos()))
+		return false;
+	payload = m_file.read(qint64(size));
+	return quint64(payload.size()) == size;
+}
+
+bool GameArchive::readFooter()
+{
+	const qint64 size = m_file.size();
+	if (size < s_headerSize + s_trailerSize || !m_file.seek(size - s_trailerSize))
+		return false;
+
+	const QByteArray trailer(m_file.read(s_trailerSize));
+	if (trailer.size() != s_trailerSize
+	||  !trailer.endsWith(QByteArray(s_footerMagic, sizeof(s_footerMagic))))
+		return false;
+
+	const qint64 footerPos = qFromLittleEndian<qint64>(
+		reinterpret_cast<const uchar*>(trailer.constData()));
+	char type;
+	QByteArray payload;
+	if (footerPos < s_headerSize
+	||  !readChunk(footerPos, type, payload)
+	||  type != FooterChunk
+	||  m_file.pos() != size - s_trailerSize)
+		return false;
+
+	Reader in(payload);
+	QStringList strings;
+	const quint64 stringCount = in.varint();
+	for (quint64 i = 0; i < stringCount && in.isOk(); i++)
+		strings.append(in.text());
+
+	QVector<qint64> offsets;
+	const quint64 gameCount = in.varint();
+	for (quint64 i = 0; i < gameCount && in.isOk(); i++)
+		offsets.append(in.fixed<qint64>());
+	if (!in.isOk())
+		return false;
+
+	m_strings = strings;
+	m_stringIds.clear();
+	for (int i = 0; i < m_strings.size(); i++)
+		m_stringIds[m_strings.at(i)] = i;
+	m_offsets = offsets;
+	m_end = footerPos;
+
+	return true;
+}
+
+void GameArchive::scan()
+{
+	m_strings.clear();
+	m_stringIds.clear();
+	m_offsets.clear();
+
+	qint64 pos = s_headerSize;
+	char type;
+	QByteArray payload;
+	while (readChunk(pos, type, payload))
+	{
+		if (type == StringChunk)
+		{
+			const QString str(QString::fromUtf8(payload));
+			m_stringIds[str] = m_strings.size();
+			m_strings.append(str);
+		}
+		else if (type == GameChunk)
+			m_offsets.append(pos);
+		else
+			break;
+
+		pos = m_file.pos();
+	}
+
+	m_end = pos;
+	m_modified = m_file.isWritable();
+}
+
+bool GameArchive::writeFooter()
+{
+	const QStringList& strings = m_strings;
+	const QVector<qint64>& offsets = m_offsets;
+
+	QByteArray payload;
+	writeVarint(payload, quint64(strings.size()));
+	for (const QString& str : strings)
+		writeText(payload, str);
+	writeVarint(payload, quint64(offsets.size()));
+	for (qint64 offset : offsets)
+		writeFixed<qint64>(payload, offset);
+
+	QByteArray data;
+	data.append(char(FooterChunk));
+	writeVarint(data, quint64(payload.size()));
+	data.append(payload);
+	writeFixed<qint64>(data, m_end);
+	data.append(s_footerMagic, sizeof(s_footerMagic));
+
+	return m_file.seek(m_end)
+	    && m_file.write(data) == data.size()
+	    && m_file.resize(m_end + data.size())
+	    && m_file.flush();
+}
+
+bool GameArchive::encodeGame(const PgnGame& game,
+			     QByteArray& out,
+			     QStringList& newStrings)
+{
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return false;
+
+	QHash<QString, int> newIds;
+	auto stringId = [&](const QString& str)
+	{
+		int id = m_stringIds.value(str, -1);
+		if (id == -1)
+			id = newIds.value(str, -1);
+		if (id != -1)
+			return id;
+
+		id = m_strings.size() + newStrings.size();
+		newIds[str] = id;
+		newStrings.append(str);
+		return id;
+	};
+
+	const auto tags = game.tags();
+	writeVarint(out, quint64(tags.size()));
+	for (const auto& tag : tags)
+	{
+		writeVarint(out, quint64(stringId(tag.first)));
+		writeVarint(out, quint64(stringId(tag.second)));
+	}
+	writeText(out, game.initialComment());
+
+	const auto& moves = game.moves();
+	writeVarint(out, quint64(moves.size()));
+	for (const auto& md : moves)
+	{
+		const Chess::Move move(board->moveFromGenericMove(md.move));
+		const int index = move.isNull() ? -1 : moveIndex(board.data(), move);
+		if (index == -1)
+			return false;
+		writeVarint(out, quint64(index));
+
+		const QString comment(PgnGame::moveComment(md, board.data()));
+		EvalData eval;
+		if (comment.isEmpty())
+			out.append(char(NoComment));
+		else if (comment == "book")
+			out.append(char(BookComment));
+		else if (parseEval(comment, board.data(), eval))
+		{
+			out.append(char(EvalComment));
+			writeEval(out, eval);
+		}
+		else
+		{
+			out.append(char(TextComment));
+			writeText(out, comment);
+		}
+
+		board->makeMove(move);
+	}
+
+	return true;
+}
+
+bool GameArchive::decodeGame(const QByteArray& data, PgnGame& game) const
+{
+	game.clear();
+
+	Reader in(data);
+	const quint64 tagCount = in.varint();
+	for (quint64 i = 0; i < tagCount && in.isOk(); i++)
+	{
+		const quint64 name = in.varint();
+		const quint64 value = in.varint();
+		if (name >= quint64(m_strings.size())
+		||  value >= quint64(m_strings.size()))
+			return false;
+		game.setTag(m_strings.at(int(name)), m_strings.at(int(value)));
+	}
+	game.setInitialComment(in.text());
+	if (!in.isOk())
+		return false;
+
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return false;
+	game.setStartingSide(board->startingSide());
+
+	const quint64 moveCount = in.varint();
+	for (quint64 i = 0; i < moveCount && in.isOk(); i++)
+	{
+		const quint64 index = in.varint();
+		const auto moves = sortedMoves(board.data());
+		if (index >= quint64(moves.size()))
+			return false;
+		const Chess::Move& move = moves.at(int(index));
+
+		PgnGame::MoveData md;
+		md.key = board->key();
+		md.move = board->genericMove(move);
+		md.moveString = board->moveString(move,
+						  Chess::Board::StandardAlgebraic);
+
+		EvalData eval;
+		switch (in.fixed<quint8>())
+		{
+		case NoComment:
+			break;
+		case BookComment:
+			md.comment = "book";
+			break;
+		case TextComment:
+			md.comment = in.text();
+			break;
+		case EvalComment:
+			readEval(in, eval);
+			if (!in.isOk() || !formatEval(eval, board.data(), md.comment))
+				return false;
+			break;
+		default:
+			return false;
+		}
+
+		game.addMove(md, false);
+		board->makeMove(move);
+	}
+
+	return in.isOk();
+}
@@ -0,0 +1,130 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMEARCHIVE_H
+#define GAMEARCHIVE_H
+
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+class PgnGame;
+
+
+/*!
+ * \brief A compact binary archive of chess games.
+ *
+ * GameArchive stores PgnGame objects in a binary format that is
+ * smaller and faster to parse than PGN:
+ * - Tag names and values are kept in a string table, so each distinct
+ *   string is stored only once per archive.
+ * - Moves are stored as indexes into the position's legal moves,
+ *   sorted by their generic notation.
+ * - The evaluation comments written by ChessGame are stored as
+ *   fixed-width fields. Other comments are stored as text.
+ *
+ * Games are always appended to the end of the archive. When the
+ * archive is closed, a footer holding the string table and the offset
+ * of every game is written for random access. If the footer is
+ * missing, eg. because the writer was interrupted, the archive is
+ * recovered by scanning it from the beginning.
+ *
+ * \note The move strings are regenerated when the games are read,
+ * so non-standard SAN in the source games is normalized.
+ *
+ * \sa PgnGame
+ */
+class LIB_EXPORT GameArchive
+{
+	public:
+		/*! Creates a new, closed GameArchive object. */
+		GameArchive();
+		/*! Closes the archive and destroys the object. */
+		~GameArchive();
+
+		/*!
+		 * Returns true if \a fileName is a game archive;
+		 * otherwise returns false.
+		 */
+		static bool isArchive(const QString& fileName);
+
+		/*!
+		 * Opens the archive \a fileName.
+		 *
+		 * \a mode can be one of:
+		 * - QIODevice::ReadOnly: open an existing archive for reading
+		 * - QIODevice::WriteOnly: create a new, empty archive
+		 * - QIODevice::Append: append to an existing archive, or
+		 *   create a new one if \a fileName doesn't exist
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName,
+			  QIODevice::OpenMode mode = QIODevice::ReadOnly);
+		/*!
+		 * Writes the footer if needed and closes the archive.
+		 *
+		 * If \a sync is true the archive is flushed to stable
+		 * storage before it's closed.
+		 */
+		void close(bool sync = false);
+		/*! Returns true if the archive is open. */
+		bool isOpen() const;
+		/*! Returns the file name of the archive. */
+		QString fileName() const;
+
+		/*! Returns the number of games in the archive. */
+		int gameCount() const;
+		/*!
+		 * Reads the game at \a index to \a game.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool readGame(int index, PgnGame& game);
+		/*!
+		 * Appends \a game to the archive.
+		 *
+		 * The game may stay in the file buffer until the archive
+		 * is flushed or closed.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool writeGame(const PgnGame& game);
+		/*!
+		 * Flushes buffered games to the file, or to stable storage
+		 * if \a sync is true.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool flush(bool sync = false);
+
+	private:
+		bool readChunk(qint64 pos, char& type, QByteArray& payload);
+		bool readFooter();
+		void scan();
+		bool writeFooter();
+		bool encodeGame(const PgnGame& game,
+				QByteArray& out,
+				QStringList& newStrings);
+		bool decodeGame(const QByteArray& data, PgnGame& game) const;
+
+		QFile m_file;
+		QStringList m_strings;
+		QHash<QString, int> m_stringIds;
+		QVector<qint64> m_offsets;
+		qint64 m_end;
+		bool m_modified;
+};
+
+#endif // GAMEARCHIVE_H
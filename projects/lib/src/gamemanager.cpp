@@ -17,10 +17,25 @@
 
 #include "gamemanager.h"
 #include <QThread>
+#include <QMetaMethod>
+#include <QTimer>
 #include <algorithm>
 #include "playerbuilder.h"
 #include "chessgame.h"
 #include "chessplayer.h"
+#include "chessengine.h"
+#include "enginebuilder.h"
+#include "engineprocess.h"
+#include "cgroup.h"
+#include "tracer.h"
+
+namespace {
+
+// An engine that once took this long (in milliseconds) to stop at the
+// end of a game is replaced instead of waited for when it's slow again
+const int s_slowStopLatency = 1000;
+
+} // anonymous namespace
 
 class GameInitializer : public QObject
 {
@@ -35,6 +50,9 @@ class GameInitializer : public QObject
 		const PlayerBuilder* blackBuilder() const;
 		void swapPlayers();
 		void setGame(ChessGame* game);
+		void setPrestartEngines(bool enabled);
+		void setCpus(const CpuAffinity::CpuSet& cpus);
+		void setCgroup(const QString& path);
 
 	public slots:
 		void initializeGame();
@@ -48,12 +66,20 @@ class GameInitializer : public QObject
 		void onPlayerQuit();
 
 	private:
+		ChessPlayer* createPlayer(int index, QString* error);
 		void deletePlayer(int index);
+		void drainPlayer(int index);
+		void prestartPlayers();
 
 		int m_playerCount;
 		bool m_finishing;
+		bool m_prestartEngines;
+		CpuAffinity::CpuSet m_cpus;
+		QString m_cgroup;
 		const PlayerBuilder* m_builder[2];
 		ChessPlayer* m_player[2];
+		// Engines started in advance for the next game
+		ChessPlayer* m_spare[2];
 		ChessGame* m_game;
 };
 
@@ -61,6 +87,7 @@ GameInitializer::GameInitializer(const PlayerBuilder* white,
 				 const PlayerBuilder* black)
 	: m_playerCount(0),
 	  m_finishing(false),
+	  m_prestartEngines(false),
 	  m_game(nullptr)
 {
 	Q_ASSERT(white != nullptr);
@@ -70,17 +97,21 @@ GameInitializer::GameInitializer(const PlayerBuilder* white,
 	m_builder[Chess::Side::Black] = black;
 	m_player[0] = nullptr;
 	m_player[1] = nullptr;
+	m_spare[0] = nullptr;
+	m_spare[1] = nullptr;
 }
 
 GameInitializer::~GameInitializer()
 {
-	for (int i = 0; i < 2; i++)
+	ChessPlayer* players[] = { m_player[0], m_player[1],
+				   m_spare[0], m_spare[1] };
+	for (ChessPlayer* player : players)
 	{
-		if (m_player[i] == nullptr)
+		if (player == nullptr)
 			continue;
 
-		m_player[i]->disconnect();
-		m_player[i]->kill();
+		player->disconnect();
+		player->kill();
 	}
 }
 
@@ -98,6 +129,7 @@ void GameInitializer::swapPlayers()
 {
 	std::swap(m_builder[0], m_builder[1]);
 	std::swap(m_player[0], m_player[1]);
+	std::swap(m_spare[0], m_spare[1]);
 }
 
 void GameInitializer::setGame(ChessGame* game)
@@ -105,6 +137,64 @@ void GameInitializer::setGame(ChessGame* game)
 	m_game = game;
 }
 
+void GameInitializer::setPrestartEngines(bool enabled)
+{
+	m_prestartEngines = enabled;
+}
+
+void GameInitializer::setCpus(const CpuAffinity::CpuSet& cpus)
+{
+	m_cpus = cpus;
+}
+
+void GameInitializer::setCgroup(const QString& path)
+{
+	m_cgroup = path;
+}
+
+ChessPlayer* GameInitializer::createPlayer(int index, QString* error)
+{
+	auto manager = qobject_cast<GameManager*>(thread()->parent());
+	const bool debug = manager == nullptr
+			|| manager->hasDebugOutput();
+	TraceSpan span("engine", "spawn");
+
+	ChessPlayer* player = m_builder[index]->create(thread()->parent(),
+						       debug ? SIGNAL(debugMessage(QString))
+							     : nullptr,
+						       this, error);
+	if (span.isRecorded() && player != nullptr)
+		span.setDetail(player->name());
+
+	// Remote engines don't run on this host
+	auto engine = qobject_cast<ChessEngine*>(player);
+	auto process = engine != nullptr
+		? qobject_cast<EngineProcess*>(engine->device()) : nullptr;
+	if (process != nullptr && !m_cpus.isEmpty()
+	&&  !CpuAffinity::setProcessAffinity(process->processId(), m_cpus))
+		qWarning("Cannot bind engine %s to CPUs %s",
+			 qPrintable(engine->name()),
+			 qPrintable(CpuAffinity::toString(m_cpus)));
+
+	// Every engine process gets a leaf group in the slot's group,
+	// so that it can be killed with the processes it starts
+	if (process != nullptr && !m_cgroup.isEmpty())
+	{
+		const qint64 pid = process->processId();
+		const QString path = QString("%1/engine-%2").arg(m_cgroup).arg(pid);
+		if (Cgroup::create(path) && Cgroup::addProcess(path, pid))
+			engine->setCgroup(path);
+		else
+		{
+			qWarning("Cannot move engine %s to cgroup %s",
+				 qPrintable(engine->name()), qPrintable(path));
+			Cgroup::remove(path);
+		}
+	}
+
+	return player;
+}
+
 void GameInitializer::deletePlayer(int index)
 {
 	ChessPlayer* player = m_player[index];
@@ -122,10 +212,35 @@ void GameInitializer::deletePlayer(int index)
 	}
 }
 
+void GameInitializer::drainPlayer(int index)
+{
+	ChessPlayer* player = m_player[index];
+	Q_ASSERT(player != nullptr);
+
+	// The engine quits on its own once it has stopped, or it's
+	// terminated when its stop timeout expires
+	m_player[index] = nullptr;
+	qDebug("Starting a new instance of %s while the old one stops",
+	       qPrintable(player->name()));
+	connect(player, SIGNAL(ready()),
+		player, SLOT(quit()), Qt::QueuedConnection);
+	connect(player, SIGNAL(disconnected()),
+		player, SLOT(deleteLater()));
+}
+
 void GameInitializer::initializeGame()
 {
+	TraceSpan span("manager", "initialize");
 	for (int i = 0; i < 2; i++)
 	{
+		// Don't let the next game wait for an engine that's
+		// known to be slow to stop
+		auto engine = qobject_cast<ChessEngine*>(m_player[i]);
+		if (engine != nullptr
+		&&  engine->isStopping()
+		&&  engine->maxStopLatency() >= s_slowStopLatency)
+			drainPlayer(i);
+
 		// Delete a disconnected player (crashed engine) so that
 		// it will be restarted.
 		if (m_player[i] != nullptr
@@ -134,12 +249,29 @@ void GameInitializer::initializeGame()
 			deletePlayer(i);
 		}
 
+		// An engine that is reused gets the current options, eg.
+		// after its configuration was reloaded. Only the changed
+		// options are sent.
+		auto builder = dynamic_cast<const EngineBuilder*>(m_builder[i]);
+		engine = qobject_cast<ChessEngine*>(m_player[i]);
+		if (engine != nullptr && builder != nullptr)
+			engine->applyOptions(builder->configuration());
+
+		// Use an engine that was started in advance if it's
+		// still alive
+		if (m_player[i] == nullptr && m_spare[i] != nullptr)
+		{
+			if (m_spare[i]->state() != ChessPlayer::Disconnected)
+				m_player[i] = m_spare[i];
+			else
+				m_spare[i]->deleteLater();
+			m_spare[i] = nullptr;
+		}
+
 		if (m_player[i] == nullptr)
 		{
 			QString error;
-			m_player[i] = m_builder[i]->create(thread()->parent(),
-							   SIGNAL(debugMessage(QString)),
-							   this, &error);
+			m_player[i] = createPlayer(i, &error);
 			m_game->setError(error);
 
 			if (m_player[i] == nullptr)
@@ -155,31 +287,55 @@ void GameInitializer::initializeGame()
 	}
 	m_playerCount = 2;
 
+	prestartPlayers();
 	emit gameInitialized(true);
 }
 
-void GameInitializer::finish()
+void GameInitializer::prestartPlayers()
 {
-	if (m_finishing)
+	if (!m_prestartEngines)
 		return;
-	m_finishing = true;
 
-	if (m_playerCount <= 0)
+	// An engine that restarts between games can't be reused, so its
+	// replacement is started now. It initializes while this game is
+	// played and is ready when the next game begins.
+	for (int i = 0; i < 2; i++)
 	{
-		emit finished();
-		return;
+		auto engine = qobject_cast<ChessEngine*>(m_player[i]);
+		if (m_spare[i] != nullptr
+		||  engine == nullptr
+		||  !engine->restartsBetweenGames())
+			continue;
+
+		// A failure is only a warning here: the engine is started
+		// again when the next game needs it
+		m_spare[i] = createPlayer(i, nullptr);
 	}
+}
 
-	for (int i = 0; i < 2; i++)
+void GameInitializer::finish()
+{
+	if (m_finishing)
+		return;
+	m_finishing = true;
+
+	m_playerCount = 0;
+	ChessPlayer* players[] = { m_player[0], m_player[1],
+				   m_spare[0], m_spare[1] };
+	for (ChessPlayer* player : players)
 	{
-		if (m_player[i] == nullptr)
+		if (player == nullptr)
 			continue;
 
-		connect(m_player[i], SIGNAL(disconnected()),
+		m_playerCount++;
+		connect(player, SIGNAL(disconnected()),
 			this, SLOT(onPlayerQuit()),
 			Qt::QueuedConnection);
-		m_player[i]->quit();
+		player->quit();
 	}
+
+	if (m_playerCount == 0)
+		emit finished();
 }
 
 void GameInitializer::onPlayerQuit()
@@ -196,16 +352,21 @@ class GameThread : public QThread
 	public:
 		GameThread(const PlayerBuilder* white,
 			   const PlayerBuilder* black,
+			   QThread* host,
 			   QObject* parent);
 		virtual ~GameThread();
 
 		bool isReady() const;
+		bool isActive() const;
+		QThread* host() const;
 		void newGame(ChessGame* game);
 		void finish();
 		void finishAndDelete();
 
 		GameInitializer* initializer() const;
 		ChessGame* game() const;
+		int slot() const;
+		void setSlot(int slot);
 		GameManager::StartMode startMode() const;
 		GameManager::CleanupMode cleanupMode() const;
 
@@ -215,12 +376,17 @@ class GameThread : public QThread
 	signals:
 		void gameInitialized(bool success);
 		void ready();
+		void stopped();
 
 	private slots:
 		void onGameDestroyed();
+		void onInitializerDestroyed();
 
 	private:
 		bool m_ready;
+		bool m_active;
+		int m_slot;
+		QThread* m_host;
 		GameManager::StartMode m_startMode;
 		GameManager::CleanupMode m_cleanupMode;
 		ChessGame* m_game;
@@ -229,9 +395,13 @@ class GameThread : public QThread
 
 GameThread::GameThread(const PlayerBuilder* white,
 		       const PlayerBuilder* black,
+		       QThread* host,
 		       QObject* parent)
 	: QThread(parent),
 	  m_ready(true),
+	  m_active(true),
+	  m_slot(0),
+	  m_host(host != nullptr ? host : this),
 	  m_startMode(GameManager::StartImmediately),
 	  m_cleanupMode(GameManager::DeletePlayers),
 	  m_game(nullptr),
@@ -243,9 +413,10 @@ GameThread::GameThread(const PlayerBuilder* white,
 		m_initializer, SLOT(deleteLater()),
 		Qt::QueuedConnection);
 	connect(m_initializer, SIGNAL(destroyed()),
-		this, SLOT(quit()),
+		this, SLOT(onInitializerDestroyed()),
 		Qt::QueuedConnection);
-	m_initializer->moveToThread(this);
+	connect(this, SIGNAL(finished()), this, SIGNAL(stopped()));
+	m_initializer->moveToThread(m_host);
 }
 
 GameThread::~GameThread()
@@ -257,6 +428,18 @@ bool GameThread::isReady() const
 	return m_ready;
 }
 
+bool GameThread::isActive() const
+{
+	if (m_host == this)
+		return isRunning();
+	return m_active;
+}
+
+QThread* GameThread::host() const
+{
+	return m_host;
+}
+
 void GameThread::newGame(ChessGame* game)
 {
 	m_ready = false;
@@ -288,7 +471,7 @@ void GameThread::finish()
 
 void GameThread::finishAndDelete()
 {
-	connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+	connect(this, SIGNAL(stopped()), this, SLOT(deleteLater()));
 	finish();
 }
 
@@ -302,6 +485,16 @@ ChessGame* GameThread::game() const
 	return m_game;
 }
 
+int GameThread::slot() const
+{
+	return m_slot;
+}
+
+void GameThread::setSlot(int slot)
+{
+	m_slot = slot;
+}
+
 GameManager::StartMode GameThread::startMode() const
 {
 	return m_startMode;
@@ -328,13 +521,51 @@ void GameThread::onGameDestroyed()
 	emit ready();
 }
 
+void GameThread::onInitializerDestroyed()
+{
+	// A thread of our own can quit now. A shared worker keeps
+	// running the other games it hosts.
+	if (m_host == this)
+	{
+		quit();
+		return;
+	}
+
+	m_active = false;
+	emit stopped();
+}
+
 
 GameManager::GameManager(QObject* parent)
 	: QObject(parent),
 	  m_finishing(false),
+	  m_prestartEngines(false),
+	  m_cgroupCpuQuota(0),
+	  m_cgroupMemoryLimit(0),
 	  m_concurrency(1),
-	  m_activeQueuedGameCount(0)
+	  m_minConcurrency(0),
+	  m_maxConcurrency(0),
+	  m_loadTimer(new QTimer(this)),
+	  m_workerCount(0),
+	  m_lookahead(0),
+	  m_activeQueuedGameCount(0),
+	  m_lastEntryId(0),
+	  m_slotCount(0)
 {
+	// New games need a while to load the host, so the
+	// concurrency limit is changed in small steps
+	m_loadTimer->setInterval(5000);
+	connect(m_loadTimer, SIGNAL(timeout()),
+		this, SLOT(adaptConcurrency()));
+}
+
+GameManager::~GameManager()
+{
+	for (QThread* worker : m_workers)
+	{
+		worker->quit();
+		worker->wait();
+	}
 }
 
 QList<ChessGame*> GameManager::activeGames() const
@@ -350,23 +581,245 @@ int GameManager::concurrency() const
 void GameManager::setConcurrency(int concurrency)
 {
 	m_concurrency = concurrency;
+	m_minConcurrency = 0;
+	m_maxConcurrency = 0;
+	m_loadTimer->stop();
 }
 
-void GameManager::cleanupIdleThreads()
+void GameManager::setAdaptiveConcurrency(int minimum, int maximum)
 {
-	QList<GameThread*>::iterator it = m_activeThreads.begin();
-	while (it != m_activeThreads.end())
+	Q_ASSERT(minimum > 0);
+	Q_ASSERT(maximum >= minimum);
+
+	m_concurrency = minimum;
+	m_minConcurrency = minimum;
+	m_maxConcurrency = maximum;
+	m_hostLoad = HostLoad::sample();
+	m_loadTimer->start();
+}
+
+int GameManager::maxConcurrency() const
+{
+	return m_maxConcurrency > 0 ? m_maxConcurrency : m_concurrency;
+}
+
+void GameManager::limitConcurrency(int limit)
+{
+	Q_ASSERT(limit > 0);
+
+	if (m_maxConcurrency > 0)
+		setAdaptiveConcurrency(qMin(m_minConcurrency, limit),
+				       qMin(m_maxConcurrency, limit));
+	else
+		setConcurrency(qMin(m_concurrency, limit));
+}
+
+void GameManager::adaptConcurrency()
+{
+	const HostLoad load = HostLoad::sample();
+	const double busy = load.busyRatio(m_hostLoad);
+	const double steal = load.stealRatio(m_hostLoad);
+	const int runnable = load.runnableThreads();
+	m_hostLoad = load;
+	if (busy < 0.0)
+		return;
+
+	// The sampling thread itself is always runnable
+	const int cores = QThread::idealThreadCount();
+	bool saturated = busy > 0.95 || steal > 0.05 || runnable > cores + 1;
+	bool headroom = busy < 0.85
+		     && steal < 0.02
+		     && (runnable < 0 || runnable < cores);
+
+	if (saturated && m_concurrency > m_minConcurrency)
+		m_concurrency--;
+	else if (headroom
+	     &&  m_concurrency < m_maxConcurrency
+	     &&  m_activeQueuedGameCount >= m_concurrency
+	     &&  !m_gameEntries.isEmpty())
 	{
-		GameThread* thread = *it;
-		Q_ASSERT(thread != nullptr);
+		m_concurrency++;
+		startQueuedGame();
+	}
+}
 
-		if (thread->isReady())
-		{
-			it = m_activeThreads.erase(it);
-			thread->finishAndDelete();
-		}
-		else
-			++it;
+bool GameManager::hasDebugOutput() const
+{
+	static const QMetaMethod signal(
+		QMetaMethod::fromSignal(&GameManager::debugMessage));
+	return isSignalConnected(signal);
+}
+
+bool GameManager::prestartsEngines() const
+{
+	return m_prestartEngines;
+}
+
+void GameManager::setPrestartEngines(bool enabled)
+{
+	m_prestartEngines = enabled;
+}
+
+QList<CpuAffinity::CpuSet> GameManager::cpuAffinity() const
+{
+	return m_cpuSets;
+}
+
+void GameManager::setCpuAffinity(const QList<CpuAffinity::CpuSet>& sets)
+{
+	m_cpuSets = sets;
+}
+
+bool GameManager::setCgroups(const QString& path,
+			     int cpuQuota,
+			     qint64 memoryLimit)
+{
+	m_cgroupPath = path;
+	m_cgroupCpuQuota = cpuQuota;
+	m_cgroupMemoryLimit = memoryLimit;
+	m_slotThrottledTime.clear();
+
+	return path.isEmpty()
+	    || (Cgroup::isSupported() && Cgroup::enableControllers(path));
+}
+
+QString GameManager::slotCgroup(int slot)
+{
+	// The groups are named like the slots in the log, from 1 up
+	const QString path = QString("%1/slot%2").arg(m_cgroupPath).arg(slot + 1);
+	if (m_slotThrottledTime.contains(slot))
+		return path;
+
+	bool ok = Cgroup::create(path);
+	if (ok && m_cgroupCpuQuota > 0)
+		ok = Cgroup::setCpuQuota(path, m_cgroupCpuQuota);
+	if (ok && m_cgroupMemoryLimit > 0)
+		ok = Cgroup::setMemoryLimit(path, m_cgroupMemoryLimit);
+	if (ok && !m_cpuSets.isEmpty())
+		ok = Cgroup::setCpus(path, m_cpuSets.at(slot % m_cpuSets.size()));
+	if (!ok)
+		qWarning("Cannot set up cgroup %s", qPrintable(path));
+
+	m_slotThrottledTime[slot] = 0;
+	return path;
+}
+
+void GameManager::reportThrottling(int slot)
+{
+	const qint64 usec = Cgroup::throttledTime(slotCgroup(slot));
+	if (usec < 0)
+		return;
+
+	// A throttled engine thinks slower than its clock assumes
+	const qint64 delta = usec - m_slotThrottledTime.value(slot);
+	if (delta >= 1000)
+		qWarning("Engines in game slot %d were throttled for %lld ms",
+			 slot + 1, delta / 1000);
+	m_slotThrottledTime[slot] = usec;
+}
+
+void GameManager::removeCgroups()
+{
+	const QList<int> slotNumbers = m_slotThrottledTime.keys();
+	for (int slot : slotNumbers)
+	{
+		const QString path = slotCgroup(slot);
+		const qint64 usec = Cgroup::throttledTime(path);
+		if (usec >= 1000)
+			qDebug("Game slot %d was throttled for %lld ms in total",
+			       slot + 1, usec / 1000);
+
+		Cgroup::kill(path);
+		if (!Cgroup::remove(path))
+			qWarning("Cannot remove cgroup %s", qPrintable(path));
+	}
+	m_slotThrottledTime.clear();
+}
+
+int GameManager::workerThreads() const
+{
+	return m_workerCount;
+}
+
+void GameManager::setWorkerThreads(int count)
+{
+	m_workerCount = qMax(0, count);
+}
+
+int GameManager::defaultWorkerThreads()
+{
+	return qMax(1, QThread::idealThreadCount() / 8);
+}
+
+int GameManager::lookahead() const
+{
+	return m_lookahead;
+}
+
+int GameManager::activeGameCount() const
+{
+	return m_activeGames.size();
+}
+
+int GameManager::queuedGameCount() const
+{
+	return m_queuedGames.size();
+}
+
+void GameManager::setLookahead(int games)
+{
+	m_lookahead = qMax(0, games);
+}
+
+int GameManager::playerConcurrency(const PlayerBuilder* builder) const
+{
+	return m_playerConcurrency.value(builder);
+}
+
+void GameManager::setPlayerConcurrency(const PlayerBuilder* builder, int count)
+{
+	Q_ASSERT(builder != nullptr);
+
+	if (count > 0)
+		m_playerConcurrency[builder] = count;
+	else
+		m_playerConcurrency.remove(builder);
+}
+
+GameManager::BuilderPair GameManager::builderPair(const PlayerBuilder* white,
+						  const PlayerBuilder* black)
+{
+	if (std::less<const PlayerBuilder*>()(black, white))
+		std::swap(white, black);
+	return qMakePair(white, black);
+}
+
+GameManager::BuilderPair GameManager::builderPair(const GameThread* thread)
+{
+	const GameInitializer* initializer = thread->initializer();
+	return builderPair(initializer->whiteBuilder(),
+			   initializer->blackBuilder());
+}
+
+void GameManager::releaseThread(GameThread* thread)
+{
+	if (!m_activeThreads.remove(thread))
+		return;
+
+	m_idleThreads.remove(builderPair(thread), thread);
+	m_freeSlots.push(thread->slot());
+	if (thread->host() != thread)
+		m_workerLoad[thread->host()]--;
+}
+
+void GameManager::cleanupIdleThreads()
+{
+	const QList<GameThread*> threads = m_idleThreads.values();
+	for (GameThread* thread : threads)
+	{
+		Q_ASSERT(thread->isReady());
+		releaseThread(thread);
+		thread->finishAndDelete();
 	}
 }
 
@@ -374,11 +827,11 @@ void GameManager::cleanup()
 {
 	m_finishing = false;
 
-	// Remove terminated threads from the list
-	QList< QPointer<GameThread> >::iterator it = m_threads.begin();
+	// Remove terminated threads from the set
+	QSet<GameThread*>::iterator it = m_threads.begin();
 	while (it != m_threads.end())
 	{
-		if (*it == nullptr || !(*it)->isRunning())
+		if (!(*it)->isActive())
 			it = m_threads.erase(it);
 		else
 			++it;
@@ -386,15 +839,20 @@ void GameManager::cleanup()
 
 	if (m_threads.isEmpty())
 	{
+		removeCgroups();
 		emit finished();
 		return;
 	}
 
-	// Terminate running threads
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (GameThread* thread, m_threads)
+	// Terminate running threads. Idle players aren't reused after this.
+	const QList<GameThread*> activeThreads = m_activeThreads.values();
+	for (GameThread* thread : activeThreads)
+		releaseThread(thread);
+
+	const QList<GameThread*> threads = m_threads.values();
+	for (GameThread* thread : threads)
 	{
-		connect(thread, SIGNAL(finished()), this, SLOT(onThreadQuit()),
+		connect(thread, SIGNAL(stopped()), this, SLOT(onThreadQuit()),
 			Qt::QueuedConnection);
 		thread->finish();
 	}
@@ -403,6 +861,7 @@ void GameManager::cleanup()
 void GameManager::finish()
 {
 	m_gameEntries.clear();
+	m_queuedGames.clear();
 	if (m_activeGames.isEmpty())
 		cleanup();
 	else
@@ -413,14 +872,16 @@ void GameManager::newGame(ChessGame* game,
 			  const PlayerBuilder* white,
 			  const PlayerBuilder* black,
 			  StartMode startMode,
-			  CleanupMode cleanupMode)
+			  CleanupMode cleanupMode,
+			  const QObject* owner)
 {
 	Q_ASSERT(game != nullptr);
 	Q_ASSERT(white != nullptr);
 	Q_ASSERT(black != nullptr);
 	Q_ASSERT(game->parent() == nullptr);
 
-	GameEntry entry = { game, white, black, startMode, cleanupMode };
+	GameEntry entry = { game, white, black, startMode, cleanupMode,
+			    owner, 0, ++m_lastEntryId };
 	if (!white->isHuman() && black->isHuman())
 		game->setBoardShouldBeFlipped(true);
 
@@ -430,14 +891,32 @@ void GameManager::newGame(ChessGame* game,
 		return;
 	}
 
+	// A queued game may be stopped and deleted before it starts
+	connect(game, SIGNAL(destroyed(QObject*)),
+		this, SLOT(onQueuedGameDestroyed(QObject*)));
 	m_gameEntries << entry;
+	m_queuedGames[game] = entry.id;
+	Tracer::begin("manager", "queued", game);
 	startQueuedGame();
 }
 
+void GameManager::onQueuedGameDestroyed(QObject* game)
+{
+	// The entry stays in the queue until it's skipped
+	m_queuedGames.remove(game);
+	Tracer::end("manager", "queued", game);
+}
+
+void GameManager::onThreadDestroyed(QObject* thread)
+{
+	// Only the address is used, the thread is already destroyed
+	m_threads.remove(static_cast<GameThread*>(thread));
+}
+
 void GameManager::onThreadQuit()
 {
 	GameThread* thread = qobject_cast<GameThread*>(QObject::sender());
-	m_threads.removeOne(thread);
+	m_threads.remove(thread);
 
 	if (thread != nullptr)
 		thread->deleteLater();
@@ -445,6 +924,7 @@ void GameManager::onThreadQuit()
 	if (m_threads.isEmpty())
 	{
 		m_finishing = false;
+		removeCgroups();
 		emit finished();
 	}
 }
@@ -456,17 +936,20 @@ void GameManager::onThreadReady()
 	ChessGame* game = thread->game();
 
 	m_activeGames.removeOne(game);
-	m_threads.removeAll(nullptr);
+	if (!m_cgroupPath.isEmpty())
+		reportThrottling(thread->slot());
 
 	if (thread->cleanupMode() == DeletePlayers)
 	{
-		m_activeThreads.removeOne(thread);
+		releaseThread(thread);
 		thread->finishAndDelete();
 	}
+	else
+		m_idleThreads.insert(builderPair(thread), thread);
 
 	if (thread->startMode() == Enqueue)
 	{
-		m_activeQueuedGameCount--;
+		releaseQueuedSlot(game);
 		startQueuedGame();
 	}
 
@@ -484,10 +967,10 @@ void GameManager::onGameInitialized(bool success)
 	if (!success)
 	{
 		if (gameThread->startMode() == Enqueue)
-			m_activeQueuedGameCount--;
+			releaseQueuedSlot(game);
 
-		m_threads.removeOne(gameThread);
-		m_activeThreads.removeOne(gameThread);
+		m_threads.remove(gameThread);
+		releaseThread(gameThread);
 
 		connect(gameThread, SIGNAL(destroyed()),
 			game, SLOT(emitStartFailed()));
@@ -500,7 +983,7 @@ void GameManager::onGameInitialized(bool success)
 	if (gameThread->startMode() == Enqueue)
 		cleanupIdleThreads();
 
-	game->moveToThread(gameThread);
+	game->moveToThread(gameThread->host());
 	connect(game, SIGNAL(started(ChessGame*)),
 		this, SIGNAL(gameStarted(ChessGame*)),
 		Qt::QueuedConnection);
@@ -515,55 +998,276 @@ GameThread* GameManager::getThread(const PlayerBuilder* white,
 	Q_ASSERT(white != nullptr);
 	Q_ASSERT(black != nullptr);
 
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (GameThread* thread, m_activeThreads)
+	auto it = m_idleThreads.find(builderPair(white, black));
+	if (it != m_idleThreads.end())
 	{
-		if (!thread->isReady())
-			continue;
+		GameThread* thread = it.value();
+		m_idleThreads.erase(it);
+		Q_ASSERT(thread->isReady());
 
 		GameInitializer* tmp = thread->initializer();
-		if (tmp->whiteBuilder() == black
-		&&  tmp->blackBuilder() == white)
+		if (tmp->whiteBuilder() != white)
 			tmp->swapPlayers();
-		if (tmp->whiteBuilder() == white && tmp->blackBuilder() == black)
-			return thread;
+		return thread;
 	}
 
-	GameThread* gameThread = new GameThread(white, black, this);
+	// Use the lowest slot number that's not taken
+	int slot = m_slotCount;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.top();
+		m_freeSlots.pop();
+	}
+	else
+		m_slotCount++;
+
+	GameThread* gameThread = new GameThread(white, black,
+						getWorker(), this);
+	gameThread->setSlot(slot);
 	m_threads << gameThread;
 	m_activeThreads << gameThread;
+	if (gameThread->host() != gameThread)
+		m_workerLoad[gameThread->host()]++;
+	connect(gameThread, SIGNAL(destroyed(QObject*)),
+		this, SLOT(onThreadDestroyed(QObject*)));
 	connect(gameThread, SIGNAL(ready()),
 		this, SLOT(onThreadReady()));
 	connect(gameThread, SIGNAL(gameInitialized(bool)),
 		this, SLOT(onGameInitialized(bool)),
 		Qt::QueuedConnection);
 
-	gameThread->start();
+	if (gameThread->host() == gameThread)
+		gameThread->start();
 	return gameThread;
 }
 
+QThread* GameManager::getWorker()
+{
+	if (m_workerCount <= 0)
+		return nullptr;
+
+	// Pick the worker hosting the fewest game slots, and start
+	// a new worker while the pool isn't full and all are busy
+	QThread* worker = nullptr;
+	int minLoad = 0;
+	for (QThread* thread : m_workers)
+	{
+		const int load = m_workerLoad.value(thread);
+		if (worker == nullptr || load < minLoad)
+		{
+			worker = thread;
+			minLoad = load;
+		}
+	}
+
+	if (worker == nullptr
+	||  (minLoad > 0 && m_workers.size() < m_workerCount))
+	{
+		worker = new QThread(this);
+		m_workers << worker;
+		worker->start();
+	}
+
+	return worker;
+}
+
+bool GameManager::hasIdleThread(const PlayerBuilder* white,
+				const PlayerBuilder* black) const
+{
+	return m_idleThreads.contains(builderPair(white, black));
+}
+
+bool GameManager::isQueued(const GameEntry& entry) const
+{
+	return m_queuedGames.value(entry.game) == entry.id;
+}
+
+int GameManager::instanceCount(const PlayerBuilder* builder) const
+{
+	// Idle threads keep their players alive
+	int count = 0;
+	for (const GameThread* thread : m_activeThreads)
+	{
+		const BuilderPair pair(builderPair(thread));
+		count += (pair.first == builder) + (pair.second == builder);
+	}
+
+	return count;
+}
+
+bool GameManager::canStart(const GameEntry& entry) const
+{
+	// A game that reuses idle players doesn't start new instances
+	if (m_playerConcurrency.isEmpty()
+	||  hasIdleThread(entry.white, entry.black))
+		return true;
+
+	const int needed = (entry.white == entry.black) ? 2 : 1;
+	for (const PlayerBuilder* builder : { entry.white, entry.black })
+	{
+		const int limit = m_playerConcurrency.value(builder);
+		if (limit > 0 && instanceCount(builder) + needed > limit)
+			return false;
+	}
+
+	return true;
+}
+
+bool GameManager::releaseLimitedIdleThreads()
+{
+	bool released = false;
+	const QList<GameThread*> threads = m_idleThreads.values();
+	for (GameThread* thread : threads)
+	{
+		const BuilderPair pair(builderPair(thread));
+		if (!m_playerConcurrency.contains(pair.first)
+		&&  !m_playerConcurrency.contains(pair.second))
+			continue;
+
+		releaseThread(thread);
+		thread->finishAndDelete();
+		released = true;
+	}
+
+	return released;
+}
+
+int GameManager::nextEntryIndex()
+{
+	Q_ASSERT(!m_queuedGames.isEmpty());
+
+	while (!isQueued(m_gameEntries.first()))
+		m_gameEntries.removeFirst();
+
+	// Games whose players are at their concurrency limit wait.
+	// Owners sharing the slots take turns: the oldest game of the
+	// owner with the fewest running games goes first.
+	int first = -1;
+	int firstLoad = 0;
+	for (int i = 0; i < m_gameEntries.size(); i++)
+	{
+		const GameEntry& entry = m_gameEntries.at(i);
+		const int load = m_ownerGameCount.value(entry.owner);
+		if ((first != -1 && load >= firstLoad)
+		||  !isQueued(entry) || !canStart(entry))
+			continue;
+
+		first = i;
+		firstLoad = load;
+		if (load == 0)
+			break;
+	}
+	if (first == -1)
+		return -1;
+	const QObject* owner = m_gameEntries.at(first).owner;
+
+	// Prefer a game whose players are idle in a free slot, unless
+	// the oldest game has already waited long enough
+	int index = first;
+	if (m_gameEntries.at(first).skipCount < m_lookahead
+	&&  !m_idleThreads.isEmpty())
+	{
+		int count = 0;
+		for (int i = first; i < m_gameEntries.size() && count < m_lookahead; i++)
+		{
+			const GameEntry& entry = m_gameEntries.at(i);
+			if (entry.owner != owner
+			||  !isQueued(entry) || !canStart(entry))
+				continue;
+			if (hasIdleThread(entry.white, entry.black))
+			{
+				index = i;
+				break;
+			}
+			count++;
+		}
+	}
+
+	for (int i = first; i < index; i++)
+	{
+		if (m_gameEntries.at(i).owner == owner)
+			m_gameEntries[i].skipCount++;
+	}
+	return index;
+}
+
+GameManager::GameEntry GameManager::takeEntry(int index)
+{
+	m_queuedGames.remove(m_gameEntries.at(index).game);
+	return m_gameEntries.takeAt(index);
+}
+
 void GameManager::startGame(const GameEntry& entry)
 {
+	disconnect(entry.game, SIGNAL(destroyed(QObject*)),
+		   this, SLOT(onQueuedGameDestroyed(QObject*)));
+	if (entry.startMode == Enqueue)
+		Tracer::end("manager", "queued", entry.game);
+
 	GameThread* gameThread = getThread(entry.white, entry.black);
 	Q_ASSERT(gameThread != nullptr);
 
 	gameThread->setStartMode(entry.startMode);
 	gameThread->setCleanupMode(entry.cleanupMode);
+	// Deleted players are never replaced, so there's no point in
+	// starting engines in advance for them
+	gameThread->initializer()->setPrestartEngines(
+		m_prestartEngines && entry.cleanupMode == ReusePlayers);
+	if (!m_cpuSets.isEmpty())
+		gameThread->initializer()->setCpus(
+			m_cpuSets.at(gameThread->slot() % m_cpuSets.size()));
+	if (!m_cgroupPath.isEmpty())
+	{
+		const QString path = slotCgroup(gameThread->slot());
+		gameThread->initializer()->setCgroup(path);
+		m_slotThrottledTime[gameThread->slot()] =
+			qMax(Q_INT64_C(0), Cgroup::throttledTime(path));
+	}
 	gameThread->newGame(entry.game);
 }
 
 void GameManager::startQueuedGame()
 {
 	if (m_activeQueuedGameCount >= m_concurrency)
+	{
+		// Give the scheduler games to choose from
+		if (m_queuedGames.size() < m_lookahead)
+			emit ready();
 		return;
-	if (m_gameEntries.isEmpty())
+	}
+	if (m_queuedGames.isEmpty())
 	{
+		m_gameEntries.clear();
 		emit ready();
 		return;
 	}
 
+	int index = nextEntryIndex();
+	if (index == -1 && releaseLimitedIdleThreads())
+		index = nextEntryIndex();
+	if (index == -1)
+	{
+		// Every queued game waits for a player at its limit,
+		// so the free slots need other games
+		if (m_queuedGames.size() < 4 * qMax(m_lookahead, m_concurrency))
+			emit ready();
+		return;
+	}
+
+	const GameEntry entry(takeEntry(index));
 	m_activeQueuedGameCount++;
-	startGame(m_gameEntries.takeFirst());
+	m_ownerGameCount[entry.owner]++;
+	m_gameOwners[entry.game] = entry.owner;
+	startGame(entry);
+}
+
+void GameManager::releaseQueuedSlot(ChessGame* game)
+{
+	m_activeQueuedGameCount--;
+
+	const QObject* owner = m_gameOwners.take(game);
+	if (--m_ownerGameCount[owner] <= 0)
+		m_ownerGameCount.remove(owner);
 }
 
 #include "gamemanager.moc"
@@ -20,11 +20,20 @@
 
 #include <QObject>
 #include <QList>
-#include <QPointer>
+#include <QSet>
+#include <QHash>
+#include <QPair>
+#include <queue>
+#include <vector>
+#include <functional>
+#include "cpuaffinity.h"
+#include "hostload.h"
 class ChessGame;
 class ChessPlayer;
 class PlayerBuilder;
 class GameThread;
+class QThread;
+class QTimer;
 
 
 /*!
@@ -32,7 +41,8 @@ class GameThread;
  *
  * GameManager can start games in a new thread, run
  * multiple games concurrently, and queue games to be
- * run when a game slot/thread is free.
+ * run when a game slot/thread is free. Optionally many
+ * games share a small pool of worker threads.
  *
  * \sa ChessGame, PlayerBuilder
  */
@@ -70,6 +80,8 @@ class LIB_EXPORT GameManager : public QObject
 
 		/*! Creates a new game manager. */
 		GameManager(QObject* parent = nullptr);
+		/*! Destroys the game manager. */
+		virtual ~GameManager();
 
 		/*!
 		 * Returns the list of active games.
@@ -93,9 +105,191 @@ class LIB_EXPORT GameManager : public QObject
 		/*!
 		 * Sets the concurrency limit to \a concurrency.
 		 *
+		 * This turns off adaptive concurrency.
+		 *
 		 * \sa concurrency()
 		 */
 		void setConcurrency(int concurrency);
+		/*!
+		 * Adapts the concurrency limit to the load of the host.
+		 *
+		 * The limit starts at \a minimum. Every few seconds the
+		 * host load is sampled: while there are queued games and
+		 * the host has CPU power to spare the limit is raised by
+		 * one, up to \a maximum, and when the CPUs are saturated
+		 * or much of their time is stolen by a hypervisor it's
+		 * lowered by one, down to \a minimum. Lowering the limit
+		 * never stops a running game; it only delays the next ones.
+		 *
+		 * \sa HostLoad, maxConcurrency()
+		 */
+		void setAdaptiveConcurrency(int minimum, int maximum);
+		/*!
+		 * Returns the highest allowed concurrency limit.
+		 *
+		 * This is the maximum of adaptive concurrency, or
+		 * concurrency() if it's not adaptive.
+		 */
+		int maxConcurrency() const;
+		/*!
+		 * Lowers the concurrency limit to at most \a limit.
+		 *
+		 * Both the fixed and the adaptive limits are capped, and
+		 * adaptive concurrency stays on if it's in use.
+		 */
+		void limitConcurrency(int limit);
+
+		/*!
+		 * Returns true if the debugMessage() signal is connected.
+		 *
+		 * Players are only connected to the signal when it has
+		 * a receiver, so that they don't have to format debug
+		 * messages nobody reads.
+		 */
+		bool hasDebugOutput() const;
+
+		/*!
+		 * Returns true if engines are started in advance.
+		 *
+		 * \sa setPrestartEngines()
+		 */
+		bool prestartsEngines() const;
+		/*!
+		 * Sets engine prestarting to \a enabled.
+		 *
+		 * Engines that restart between games can't be reused in
+		 * ReusePlayers mode. With prestarting enabled, a replacement
+		 * for such an engine is started and initialized while its
+		 * current game is played, so the next game can start without
+		 * waiting for the engine. Prestarted engines run alongside
+		 * the current game's engines, which costs memory and some CPU
+		 * time. The default is false.
+		 */
+		void setPrestartEngines(bool enabled);
+
+		/*!
+		 * Returns the CPU sets of the game slots.
+		 *
+		 * \sa setCpuAffinity()
+		 */
+		QList<CpuAffinity::CpuSet> cpuAffinity() const;
+		/*!
+		 * Binds the engines of each game slot to a set of CPUs.
+		 *
+		 * Every game thread is given the lowest free slot number
+		 * when it's created, and the engines it starts are bound to
+		 * the CPUs in \a sets at that slot. If there are more slots
+		 * than sets, the sets are reused from the beginning. An empty
+		 * list (the default) doesn't bind engines to any CPUs.
+		 *
+		 * \sa CpuAffinity
+		 */
+		void setCpuAffinity(const QList<CpuAffinity::CpuSet>& sets);
+
+		/*!
+		 * Runs the engines of each game slot in a cgroup of its own.
+		 *
+		 * The groups are created under \a path, which must be a
+		 * delegated directory of the cgroup v2 hierarchy. Each slot
+		 * may use \a cpuQuota percent of one CPU and \a memoryLimit
+		 * bytes of memory; a zero value means no limit. The CPU sets
+		 * of setCpuAffinity() are also enforced by the groups, so
+		 * the threads and child processes of an engine can't leave
+		 * them.
+		 *
+		 * A warning is printed after each game in which the slot's
+		 * engines were throttled for using up their CPU quota.
+		 * An empty \a path (the default) doesn't use cgroups.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 *
+		 * \sa Cgroup
+		 */
+		bool setCgroups(const QString& path, int cpuQuota, qint64 memoryLimit);
+
+		/*!
+		 * Returns the maximum number of worker threads.
+		 *
+		 * \sa setWorkerThreads()
+		 */
+		int workerThreads() const;
+		/*!
+		 * Runs the games in a pool of at most \a count threads.
+		 *
+		 * By default (\a count is 0) every game slot gets a thread
+		 * of its own. Because games and players are driven by
+		 * events, a thread can also host many games at once: its
+		 * event loop then handles the engine I/O and clocks of all
+		 * of them. Each new game slot is given to the worker that
+		 * hosts the fewest slots, and a new worker is started while
+		 * there are less than \a count workers and all of them are
+		 * busy. Changing the value only affects new game slots.
+		 *
+		 * \sa defaultWorkerThreads()
+		 */
+		void setWorkerThreads(int count);
+		/*!
+		 * Returns a suitable worker thread count for this host:
+		 * one thread per eight hardware threads, but at least one.
+		 */
+		static int defaultWorkerThreads();
+
+		/*!
+		 * Returns the number of queued games the scheduler
+		 * chooses from.
+		 *
+		 * \sa setLookahead()
+		 */
+		int lookahead() const;
+		/*!
+		 * Lets the scheduler choose from \a games queued games.
+		 *
+		 * Players are only reused if a new game has the same
+		 * builder objects as a game that just ended. With a
+		 * lookahead the manager asks for games to be queued (by
+		 * emitting ready()) even when all game slots are busy, and
+		 * a freed slot is given to the first of the next \a games
+		 * queued games whose players are idle in that slot. This
+		 * saves engine restarts in tournaments with many players.
+		 *
+		 * No game is passed over more than \a games times, so the
+		 * games still start roughly in order. The default is 0,
+		 * which starts the queued games in order without waiting
+		 * for more of them.
+		 */
+		void setLookahead(int games);
+
+		/*!
+		 * Returns the maximum number of instances of \a builder's
+		 * player that may run at the same time, or 0 if there's
+		 * no limit.
+		 *
+		 * \sa setPlayerConcurrency()
+		 */
+		int playerConcurrency(const PlayerBuilder* builder) const;
+		/*!
+		 * Lets at most \a count instances of \a builder's player
+		 * run at the same time, eg. for an engine that needs a
+		 * license or a GPU of its own. A \a count of 0 removes
+		 * the limit.
+		 *
+		 * A queued game whose player is at its limit is passed
+		 * over, and the free game slots go to the other queued
+		 * games. If none of the queued games can start, the
+		 * manager asks for more of them (by emitting ready()) until
+		 * there are four times as many as game slots or the
+		 * lookahead, whichever is more.
+		 * Players that are kept alive in idle game threads count
+		 * as running instances until the threads are cleaned up.
+		 *
+		 * Games started with StartImmediately ignore the limit.
+		 */
+		void setPlayerConcurrency(const PlayerBuilder* builder, int count);
+
+		/*! Returns the number of games that are being played. */
+		int activeGameCount() const;
+		/*! Returns the number of games waiting for a game slot. */
+		int queuedGameCount() const;
 
 		/*!
 		 * Cleans up and deletes all idle game threads
@@ -133,6 +327,10 @@ class LIB_EXPORT GameManager : public QObject
 		 * \a cleanupMode determines whether the players and their builder
 		 * objects are destroyed or reused after the game.
 		 *
+		 * Queued games with different \a owner objects share the game
+		 * slots fairly: a free slot goes to the owner with the fewest
+		 * running games, so concurrent tournaments each get their turn.
+		 *
 		 * If the game cannot be started because one or both of the players
 		 * can't be initialized, \a game will emit the startFailed() signal.
 		 *
@@ -143,7 +341,8 @@ class LIB_EXPORT GameManager : public QObject
 			     const PlayerBuilder* white,
 			     const PlayerBuilder* black,
 			     StartMode startMode = StartImmediately,
-			     CleanupMode cleanupMode = DeletePlayers);
+			     CleanupMode cleanupMode = DeletePlayers,
+			     const QObject* owner = nullptr);
 
 	public slots:
 		/*!
@@ -171,6 +370,12 @@ class LIB_EXPORT GameManager : public QObject
 		 * \note The signal is NOT emitted if a newly freed
 		 * game slot can be used by a game that was waiting in
 		 * the queue.
+		 *
+		 * With a lookahead the signal is also emitted while there
+		 * are no free game slots but fewer queued games than the
+		 * lookahead.
+		 *
+		 * \sa setLookahead()
 		 */
 		void ready();
 		/*!
@@ -186,6 +391,9 @@ class LIB_EXPORT GameManager : public QObject
 		void onThreadReady();
 		void onThreadQuit();
 		void onGameInitialized(bool success);
+		void adaptConcurrency();
+		void onQueuedGameDestroyed(QObject* game);
+		void onThreadDestroyed(QObject* thread);
 
 	private:
 		struct GameEntry
@@ -195,21 +403,76 @@ class LIB_EXPORT GameManager : public QObject
 			const PlayerBuilder* black;
 			StartMode startMode;
 			CleanupMode cleanupMode;
+			const QObject* owner;
+			// How many later games were started before this one
+			int skipCount;
+			// Tells the entry apart from a deleted game's entry
+			// if a new game gets the same address
+			quint64 id;
 		};
+		typedef QPair<const PlayerBuilder*, const PlayerBuilder*> BuilderPair;
+
+		static BuilderPair builderPair(const PlayerBuilder* white,
+					       const PlayerBuilder* black);
+		static BuilderPair builderPair(const GameThread* thread);
 
 		GameThread* getThread(const PlayerBuilder* white,
 				      const PlayerBuilder* black);
 		void startGame(const GameEntry& entry);
 		void startQueuedGame();
 		void cleanup();
+		QThread* getWorker();
+		bool hasIdleThread(const PlayerBuilder* white,
+				   const PlayerBuilder* black) const;
+		int instanceCount(const PlayerBuilder* builder) const;
+		bool canStart(const GameEntry& entry) const;
+		bool releaseLimitedIdleThreads();
+		int nextEntryIndex();
+		GameEntry takeEntry(int index);
+		bool isQueued(const GameEntry& entry) const;
+		void releaseThread(GameThread* thread);
+		void releaseQueuedSlot(ChessGame* game);
+		QString slotCgroup(int slot);
+		void reportThrottling(int slot);
+		void removeCgroups();
 
 		bool m_finishing;
+		bool m_prestartEngines;
+		QList<CpuAffinity::CpuSet> m_cpuSets;
+		QString m_cgroupPath;
+		int m_cgroupCpuQuota;
+		qint64 m_cgroupMemoryLimit;
+		// Throttled time of the slots' groups when their current
+		// games started, by slot number
+		QHash<int, qint64> m_slotThrottledTime;
 		int m_concurrency;
+		int m_minConcurrency;
+		int m_maxConcurrency;
+		QTimer* m_loadTimer;
+		HostLoad m_hostLoad;
+		int m_workerCount;
+		int m_lookahead;
 		int m_activeQueuedGameCount;
-		QList< QPointer<GameThread> > m_threads;
-		QList<GameThread*> m_activeThreads;
+		quint64 m_lastEntryId;
+		QSet<GameThread*> m_threads;
+		QSet<GameThread*> m_activeThreads;
+		// Ready threads whose players can be reused, by their builders
+		// in either order
+		QMultiHash<BuilderPair, GameThread*> m_idleThreads;
+		// Slot numbers given up by threads, lowest first
+		std::priority_queue<int, std::vector<int>, std::greater<int> > m_freeSlots;
+		int m_slotCount;
+		QList<QThread*> m_workers;
+		QHash<QThread*, int> m_workerLoad;
+		// The queue may hold entries of deleted games, which are
+		// skipped. The queued games map to the ids of their entries.
 		QList<GameEntry> m_gameEntries;
+		QHash<QObject*, quint64> m_queuedGames;
 		QList<ChessGame*> m_activeGames;
+		QHash<const PlayerBuilder*, int> m_playerConcurrency;
+		// Running queued games by their owners
+		QHash<const QObject*, int> m_ownerGameCount;
+		QHash<ChessGame*, const QObject*> m_gameOwners;
 };
 
 #endif // GAMEMANAGER_H
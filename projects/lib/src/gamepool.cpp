@@ -0,0 +1,119 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gamepool.h"
+#include <QMutexLocker>
+#include "board/board.h"
+#include "board/boardfactory.h"
+#include "pgngame.h"
+
+GamePool::GamePool(int capacity)
+	: m_capacity(capacity),
+	  m_boardCount(0),
+	  m_reuseCount(0)
+{
+}
+
+GamePool::~GamePool()
+{
+	for (const auto& boards : m_boards)
+		qDeleteAll(boards);
+	qDeleteAll(m_pgns);
+}
+
+int GamePool::capacity() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_capacity;
+}
+
+void GamePool::setCapacity(int capacity)
+{
+	QMutexLocker locker(&m_mutex);
+	m_capacity = capacity;
+}
+
+Chess::Board* GamePool::takeBoard(const QString& variant)
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		auto it = m_boards.find(variant);
+		if (it != m_boards.end() && !it->isEmpty())
+		{
+			Chess::Board* board = it->takeLast();
+			m_boardCount--;
+			m_reuseCount++;
+			return board;
+		}
+	}
+
+	return Chess::BoardFactory::create(variant);
+}
+
+void GamePool::recycleBoard(Chess::Board* board)
+{
+	if (board == nullptr)
+		return;
+
+	QMutexLocker locker(&m_mutex);
+	if (m_boardCount >= m_capacity)
+	{
+		locker.unlock();
+		delete board;
+		return;
+	}
+
+	m_boards[board->variant()].append(board);
+	m_boardCount++;
+}
+
+PgnGame* GamePool::takePgn()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_pgns.isEmpty())
+		return new PgnGame();
+
+	m_reuseCount++;
+	return m_pgns.takeLast();
+}
+
+void GamePool::recyclePgn(PgnGame* pgn)
+{
+	if (pgn == nullptr)
+		return;
+
+	// Clearing keeps the capacity of the move list for the next game
+	pgn->clear();
+	pgn->setInitialComment(QString());
+	pgn->setTagReceiver(nullptr);
+
+	QMutexLocker locker(&m_mutex);
+	if (m_pgns.size() >= m_capacity)
+	{
+		locker.unlock();
+		delete pgn;
+		return;
+	}
+
+	m_pgns.append(pgn);
+}
+
+int GamePool::reuseCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_reuseCount;
+}
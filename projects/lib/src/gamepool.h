@@ -0,0 +1,98 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMEPOOL_H
+#define GAMEPOOL_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+namespace Chess { class Board; }
+class PgnGame;
+
+
+/*!
+ * \brief A pool of recycled boards and PGN games.
+ *
+ * A tournament of many short games would otherwise create and destroy
+ * a Chess::Board and a PgnGame for every game. GamePool keeps the
+ * objects of finished games and hands them out again: a recycled
+ * board is reset by ChessGame when the game starts, and a recycled
+ * PgnGame is cleared but keeps the capacity of its move list, so the
+ * next game's moves are added without reallocating it.
+ *
+ * At most capacity() objects of each kind are kept; extra objects are
+ * deleted. The pool is thread-safe, so games can return their boards
+ * from the threads they run in.
+ *
+ * \sa ChessGame::setGamePool()
+ */
+class LIB_EXPORT GamePool
+{
+	public:
+		/*! Creates a new pool that keeps up to \a capacity objects. */
+		explicit GamePool(int capacity = 64);
+		/*! Deletes the pooled objects. */
+		~GamePool();
+
+		/*! Returns the maximum number of pooled objects of a kind. */
+		int capacity() const;
+		/*! Sets the maximum number of pooled objects to \a capacity. */
+		void setCapacity(int capacity);
+
+		/*!
+		 * Returns a board of \a variant, either a recycled one or
+		 * a new one from Chess::BoardFactory.
+		 *
+		 * Returns 0 if \a variant doesn't exist. The caller takes
+		 * ownership of the board and must set its position before
+		 * using it.
+		 */
+		Chess::Board* takeBoard(const QString& variant);
+		/*!
+		 * Returns \a board to the pool, or deletes it if the pool
+		 * is full.
+		 */
+		void recycleBoard(Chess::Board* board);
+
+		/*!
+		 * Returns an empty PgnGame, either a recycled one or a new
+		 * one. The caller takes ownership of the game.
+		 */
+		PgnGame* takePgn();
+		/*!
+		 * Clears \a pgn and returns it to the pool, or deletes it
+		 * if the pool is full.
+		 */
+		void recyclePgn(PgnGame* pgn);
+
+		/*! Returns the number of objects that were reused. */
+		int reuseCount() const;
+
+	private:
+		Q_DISABLE_COPY(GamePool)
+
+		mutable QMutex m_mutex;
+		int m_capacity;
+		int m_boardCount;
+		int m_reuseCount;
+		QHash< QString, QVector<Chess::Board*> > m_boards;
+		QVector<PgnGame*> m_pgns;
+};
+
+#endif // GAMEPOOL_H
@@ -0,0 +1,206 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gameresultcache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QVariantMap>
+#include "engineconfiguration.h"
+
+namespace {
+
+// Returns the part of the result's description that the result type
+// doesn't imply, ie. the description that recreates the result
+QString extraDescription(const Chess::Result& result)
+{
+	const QString preset(Chess::Result(result.type(),
+					   result.winner()).description());
+	const QString str(result.description());
+	if (str == preset)
+		return QString();
+	if (str.startsWith(preset + ": "))
+		return str.mid(preset.size() + 2);
+	return str;
+}
+
+Chess::Side winner(const QString& result)
+{
+	if (result == "1-0")
+		return Chess::Side::White;
+	if (result == "0-1")
+		return Chess::Side::Black;
+	return Chess::Side::NoSide;
+}
+
+QString sha1(const QByteArray& data)
+{
+	return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+}
+
+} // anonymous namespace
+
+GameResultCache::GameResultCache(const QString& fileName)
+	: m_fileName(fileName),
+	  m_file(fileName),
+	  m_loaded(false)
+{
+}
+
+QString GameResultCache::fileName() const
+{
+	return m_fileName;
+}
+
+QString GameResultCache::engineKey(const EngineConfiguration& config)
+{
+	// The executable of a remote engine can't be checked
+	if (!config.remoteAddress().isEmpty())
+		return QString();
+
+	const QString path(config.executablePath());
+	const QFileInfo info(path);
+	if (path.isEmpty() || !info.isFile())
+		return QString();
+
+	Executable& exe = m_executables[info.canonicalFilePath()];
+	const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+	if (exe.hash.isEmpty() || exe.size != info.size()
+	||  exe.modified != modified)
+	{
+		QFile file(path);
+		QCryptographicHash hash(QCryptographicHash::Sha1);
+		if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file))
+		{
+			qWarning("Cannot read engine executable %s",
+				 qPrintable(path));
+			m_executables.remove(info.canonicalFilePath());
+			return QString();
+		}
+		exe.size = info.size();
+		exe.modified = modified;
+		exe.hash = hash.result().toHex();
+	}
+
+	// Where the engine writes its error output doesn't affect
+	// its games
+	QVariantMap map(config.toVariant().toMap());
+	map.remove("stderrFile");
+	map.remove("stderrMaxSize");
+	map.insert("arguments", config.arguments());
+	map.insert("executable", exe.hash);
+
+	return sha1(QJsonDocument::fromVariant(map)
+		    .toJson(QJsonDocument::Compact));
+}
+
+QString GameResultCache::gameKey(const QString& whiteKey,
+				 const QString& blackKey,
+				 const QStringList& fields)
+{
+	if (whiteKey.isEmpty() || blackKey.isEmpty())
+		return QString();
+
+	QStringList key;
+	key << whiteKey << blackKey << fields;
+	return sha1(key.join('\0').toUtf8());
+}
+
+GameResultCache::Entry GameResultCache::entry(const QString& key)
+{
+	load();
+	return m_entries.value(key);
+}
+
+bool GameResultCache::setEntry(const QString& key, const Entry& entry)
+{
+	Q_ASSERT(!key.isEmpty());
+	Q_ASSERT(!entry.result.isNone());
+
+	load();
+	m_entries[key] = entry;
+
+	if (!m_file.isOpen()
+	&&  !m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		qWarning("Cannot open result cache file %s",
+			 qPrintable(m_fileName));
+		return false;
+	}
+
+	QVariantMap map;
+	map.insert("key", key);
+	map.insert("result", entry.result.toShortString());
+	map.insert("type", int(entry.result.type()));
+	map.insert("description", extraDescription(entry.result));
+	map.insert("pgn", entry.pgn);
+
+	QByteArray line = QJsonDocument::fromVariant(map)
+			  .toJson(QJsonDocument::Compact);
+	line += '\n';
+	if (m_file.write(line) != line.size() || !m_file.flush())
+	{
+		qWarning("Cannot write result cache file %s",
+			 qPrintable(m_fileName));
+		return false;
+	}
+
+	return true;
+}
+
+void GameResultCache::load()
+{
+	if (m_loaded)
+		return;
+	m_loaded = true;
+
+	QFile input(m_fileName);
+	if (!input.exists())
+		return;
+	if (!input.open(QIODevice::ReadOnly))
+	{
+		qWarning("Cannot open result cache file %s",
+			 qPrintable(m_fileName));
+		return;
+	}
+
+	while (!input.atEnd())
+	{
+		// A run that was killed can leave an incomplete last
+		// record, which is skipped
+		const QByteArray line = input.readLine();
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+		if (error.error != QJsonParseError::NoError || !doc.isObject())
+			continue;
+
+		const QVariantMap map = doc.toVariant().toMap();
+		const QString key = map.value("key").toString();
+		const int type = map.value("type").toInt();
+		if (key.isEmpty() || type < Chess::Result::Win
+		||  type >= Chess::Result::NoResult)
+			continue;
+
+		Entry entry;
+		entry.result = Chess::Result(Chess::Result::Type(type),
+			winner(map.value("result").toString()),
+			map.value("description").toString());
+		entry.pgn = map.value("pgn").toString();
+		m_entries[key] = entry;
+	}
+}
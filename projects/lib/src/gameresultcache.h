@@ -0,0 +1,114 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAME_RESULT_CACHE_H
+#define GAME_RESULT_CACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QFile>
+#include "board/result.h"
+class EngineConfiguration;
+
+/*!
+ * \brief A cache of finished games that is kept between runs.
+ *
+ * A tournament that plays the same engines with the same openings,
+ * time controls and random seeds as an earlier run would play the
+ * same games again if the engines are deterministic, eg. when they
+ * search a fixed number of nodes. GameResultCache stores the
+ * finished games in a file so that the games can be taken from the
+ * cache instead of playing them again.
+ *
+ * An engine is identified by a hash of its executable's contents and
+ * its configuration, including its options. A game is identified by
+ * the keys of both engines in the order of their colors and by the
+ * fields the tournament adds, eg. the opening and the time controls.
+ *
+ * The cache is only correct for deterministic engines, so it must be
+ * enabled explicitly. The file is read when the first entry is
+ * needed, and finished games are appended to it.
+ */
+class LIB_EXPORT GameResultCache
+{
+	public:
+		/*! A cached game. */
+		struct Entry
+		{
+			/*! The result, or NoResult if the game isn't cached. */
+			Chess::Result result;
+			/*! The game in PGN format. */
+			QString pgn;
+		};
+
+		/*! Creates a new cache that uses file \a fileName. */
+		explicit GameResultCache(const QString& fileName);
+
+		/*! Returns the name of the cache file. */
+		QString fileName() const;
+
+		/*!
+		 * Returns the cache key of the engine in \a config.
+		 *
+		 * Returns an empty string if the engine's executable can't
+		 * be found, or if the engine is a remote engine. The hash of
+		 * an executable is computed again only if its size or
+		 * modification time changes.
+		 */
+		QString engineKey(const EngineConfiguration& config);
+		/*!
+		 * Returns the cache key of a game between engines \a whiteKey
+		 * and \a blackKey that are identified by engineKey().
+		 *
+		 * \a fields contains everything else that affects the game.
+		 * Returns an empty string if either engine key is empty.
+		 */
+		static QString gameKey(const QString& whiteKey,
+				       const QString& blackKey,
+				       const QStringList& fields);
+
+		/*!
+		 * Returns the cached game for \a key. If there is none, the
+		 * result of the returned entry is NoResult.
+		 */
+		Entry entry(const QString& key);
+		/*!
+		 * Stores \a entry for \a key and appends it to the cache file.
+		 *
+		 * Returns false if the file can't be written.
+		 */
+		bool setEntry(const QString& key, const Entry& entry);
+
+	private:
+		struct Executable
+		{
+			qint64 size;
+			qint64 modified;
+			QString hash;
+		};
+
+		void load();
+
+		QString m_fileName;
+		QFile m_file;
+		bool m_loaded;
+		QHash<QString, Entry> m_entries;
+		QHash<QString, Executable> m_executables;
+};
+
+#endif // GAME_RESULT_CACHE_H
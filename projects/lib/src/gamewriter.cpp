@@ -0,0 +1,607 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "gamewriter.h"
+#include <algorithm>
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <jsonserializer.h>
+#include "board/board.h"
+#include "gamearchive.h"
+#include "gzipdevice.h"
+#include "keyset.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+/*
+ * A text output file, gzip-compressed if its name ends with ".gz".
+ */
+class OutputFile
+{
+	public:
+		OutputFile(const QString& fileName, const char* type);
+		~OutputFile();
+
+		bool open();
+		QTextStream& stream();
+		bool flush(bool sync);
+		void close(bool sync);
+
+	private:
+		QFile m_file;
+		GzipDevice m_gzip;
+		QTextStream m_out;
+		const char* m_type;
+};
+
+OutputFile::OutputFile(const QString& fileName, const char* type)
+	: m_file(fileName),
+	  m_gzip(&m_file),
+	  m_type(type)
+{
+}
+
+OutputFile::~OutputFile()
+{
+	close(false);
+}
+
+bool OutputFile::open()
+{
+	bool isOpen = m_file.isOpen();
+	if (isOpen && m_file.exists())
+		return true;
+
+	if (isOpen)
+	{
+		qWarning("%s file %s does not exist. Reopening...",
+			 m_type, qPrintable(m_file.fileName()));
+		close(false);
+	}
+
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		qWarning("Could not open %s file %s",
+			 m_type, qPrintable(m_file.fileName()));
+		return false;
+	}
+
+	if (GzipDevice::isGzipFileName(m_file.fileName())
+	&&  m_gzip.open(QIODevice::WriteOnly))
+		m_out.setDevice(&m_gzip);
+	else
+		m_out.setDevice(&m_file);
+
+	return true;
+}
+
+QTextStream& OutputFile::stream()
+{
+	return m_out;
+}
+
+bool OutputFile::flush(bool sync)
+{
+	m_out.flush();
+	if (m_gzip.isOpen() && !m_gzip.flush())
+		return false;
+	if (!m_file.flush())
+		return false;
+
+	return !sync || GameWriter::syncFile(m_file);
+}
+
+void OutputFile::close(bool sync)
+{
+	if (!m_file.isOpen())
+		return;
+
+	m_out.flush();
+	m_gzip.close();
+	if (sync)
+		GameWriter::syncFile(m_file);
+	m_file.close();
+}
+
+/*
+ * Replays \a game and appends the key and FEN string of the positions
+ * at \a plies (sorted) to \a positions. Returns false if the game
+ * can't be replayed.
+ */
+bool epdPositions(const PgnGame& game,
+		  const QList<int>& plies,
+		  QVector< QPair<quint64, QString> >& positions)
+{
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return false;
+
+	const auto& moves = game.moves();
+	const int count = moves.size();
+
+	int next = 0;
+	while (next < plies.size() && plies.at(next) < 0)
+		next++;
+	const bool saveEnd = (plies.isEmpty() || next > 0);
+	const int lastPly = saveEnd ? count : qMin(count, plies.last());
+
+	for (int ply = 0; ply <= lastPly; ply++)
+	{
+		if (ply > 0)
+		{
+			const Chess::Move move(board->moveFromGenericMove(
+				moves.at(ply - 1).move));
+			if (move.isNull())
+				return false;
+			board->makeMove(move);
+		}
+
+		bool save = (saveEnd && ply == count);
+		if (next < plies.size() && plies.at(next) == ply)
+		{
+			save = true;
+			next++;
+		}
+		if (save)
+			positions.append(qMakePair(board->key(),
+						   board->fenString()));
+	}
+
+	return true;
+}
+
+} // anonymous namespace
+
+GameWriter::GameWriter(QObject* parent)
+	: QThread(parent),
+	  m_pgnOutMode(PgnGame::Verbose),
+	  m_epdUnique(false),
+	  m_livePgnOutMode(PgnGame::Verbose),
+	  m_livePgnInterval(0),
+	  m_syncPolicy(NoSync),
+	  m_maxQueueSize(64),
+	  m_hasLiveGame(false),
+	  m_finishing(false)
+{
+}
+
+GameWriter::~GameWriter()
+{
+	finish();
+}
+
+void GameWriter::setPgnOutput(const QString& fileName, PgnGame::PgnMode mode)
+{
+	Q_ASSERT(!isRunning());
+
+	m_pgnOutput = fileName;
+	m_pgnOutMode = mode;
+}
+
+void GameWriter::setBinaryOutput(const QString& fileName)
+{
+	Q_ASSERT(!isRunning());
+	m_binaryOutput = fileName;
+}
+
+void GameWriter::setEpdOutput(const QString& fileName,
+			      const QList<int>& plies,
+			      bool unique)
+{
+	Q_ASSERT(!isRunning());
+
+	m_epdOutput = fileName;
+	m_epdPlies = plies;
+	std::sort(m_epdPlies.begin(), m_epdPlies.end());
+	m_epdPlies.erase(std::unique(m_epdPlies.begin(), m_epdPlies.end()),
+			 m_epdPlies.end());
+	m_epdUnique = unique;
+}
+
+void GameWriter::setDataOutput(const QString& fileName)
+{
+	Q_ASSERT(!isRunning());
+	m_dataOutput = fileName;
+}
+
+void GameWriter::setLivePgnOutput(const QString& fileName,
+				  PgnGame::PgnMode mode)
+{
+	Q_ASSERT(!isRunning());
+
+	m_livePgnOutput = fileName;
+	m_livePgnOutMode = mode;
+}
+
+void GameWriter::setLivePgnInterval(int msecs)
+{
+	Q_ASSERT(!isRunning());
+	m_livePgnInterval = msecs;
+}
+
+void GameWriter::setLiveEventOutput(const QString& fileName)
+{
+	Q_ASSERT(!isRunning());
+	m_liveEventOutput = fileName;
+}
+
+void GameWriter::setEventLogOutput(const QString& fileName)
+{
+	Q_ASSERT(!isRunning());
+	m_eventLogOutput = fileName;
+}
+
+void GameWriter::setSyncPolicy(SyncPolicy policy)
+{
+	Q_ASSERT(!isRunning());
+	m_syncPolicy = policy;
+}
+
+void GameWriter::setMaxQueueSize(int size)
+{
+	Q_ASSERT(size > 0);
+
+	QMutexLocker locker(&m_mutex);
+	m_maxQueueSize = size;
+}
+
+bool GameWriter::hasOutput() const
+{
+	return !m_pgnOutput.isEmpty()
+	    || !m_binaryOutput.isEmpty()
+	    || !m_epdOutput.isEmpty()
+	    || !m_dataOutput.isEmpty()
+	    || !m_livePgnOutput.isEmpty()
+	    || !m_liveEventOutput.isEmpty()
+	    || !m_eventLogOutput.isEmpty();
+}
+
+void GameWriter::writeGame(const PgnGame& game)
+{
+	if (m_pgnOutput.isEmpty() && m_binaryOutput.isEmpty())
+		return;
+	Q_ASSERT(isRunning());
+
+	QMutexLocker locker(&m_mutex);
+	while (queueSize() >= m_maxQueueSize)
+		m_queueChanged.wait(&m_mutex);
+	m_games.enqueue(game);
+	m_queueChanged.wakeAll();
+}
+
+void GameWriter::writeEpd(const PgnGame& game)
+{
+	if (m_epdOutput.isEmpty())
+		return;
+	Q_ASSERT(isRunning());
+
+	QMutexLocker locker(&m_mutex);
+	while (queueSize() >= m_maxQueueSize)
+		m_queueChanged.wait(&m_mutex);
+	m_epdGames.enqueue(game);
+	m_queueChanged.wakeAll();
+}
+
+void GameWriter::writeTrainingData(const QVector<TrainingData::Position>& positions)
+{
+	if (m_dataOutput.isEmpty() || positions.isEmpty())
+		return;
+	Q_ASSERT(isRunning());
+
+	QMutexLocker locker(&m_mutex);
+	while (queueSize() >= m_maxQueueSize)
+		m_queueChanged.wait(&m_mutex);
+	m_trainingData.enqueue(positions);
+	m_queueChanged.wakeAll();
+}
+
+void GameWriter::writeLiveGame(const PgnGame& game)
+{
+	if (m_livePgnOutput.isEmpty())
+		return;
+	Q_ASSERT(isRunning());
+
+	QMutexLocker locker(&m_mutex);
+	m_liveGame = game;
+	m_hasLiveGame = true;
+	m_queueChanged.wakeAll();
+}
+
+void GameWriter::writeLiveEvent(int gameNumber, const QStringList& fields)
+{
+	if (m_liveEventOutput.isEmpty())
+		return;
+	Q_ASSERT(isRunning());
+
+	QString line(QString::number(gameNumber));
+	for (const QString& field : fields)
+	{
+		QString str(field);
+		str.replace('\t', ' ').replace('\n', ' ').replace('\r', ' ');
+		line += '\t' + str;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	while (queueSize() >= m_maxQueueSize)
+		m_queueChanged.wait(&m_mutex);
+	m_events.append(line);
+	m_queueChanged.wakeAll();
+}
+
+void GameWriter::writeEventLog(const QString& type, const QVariantMap& data)
+{
+	if (m_eventLogOutput.isEmpty())
+		return;
+	Q_ASSERT(isRunning());
+
+	QVariantMap event(data);
+	event["event"] = type;
+	event["time"] = QDateTime::currentDateTimeUtc()
+		.toString("yyyy-MM-ddThh:mm:ss.zzzZ");
+
+	QString line;
+	QTextStream stream(&line);
+	JsonSerializer serializer(event, JsonSerializer::Compact);
+	if (!serializer.serialize(stream))
+	{
+		qWarning("Could not serialize %s event: %s",
+			 qPrintable(type),
+			 qPrintable(serializer.errorString()));
+		return;
+	}
+	stream.flush();
+
+	QMutexLocker locker(&m_mutex);
+	while (queueSize() >= m_maxQueueSize)
+		m_queueChanged.wait(&m_mutex);
+	m_logEvents.append(line);
+	m_queueChanged.wakeAll();
+}
+
+bool GameWriter::hasDataOutput() const
+{
+	return !m_dataOutput.isEmpty();
+}
+
+bool GameWriter::hasLiveEventOutput() const
+{
+	return !m_liveEventOutput.isEmpty();
+}
+
+bool GameWriter::hasEventLogOutput() const
+{
+	return !m_eventLogOutput.isEmpty();
+}
+
+bool GameWriter::hasLiveOutput() const
+{
+	return !m_livePgnOutput.isEmpty() || hasLiveEventOutput();
+}
+
+int GameWriter::queueSize() const
+{
+	return m_games.size() + m_epdGames.size() + m_trainingData.size()
+	     + m_events.size() + m_logEvents.size();
+}
+
+bool GameWriter::isLiveGameDue(const QElapsedTimer& timer) const
+{
+	return m_hasLiveGame
+	    && (m_finishing
+	    ||  !timer.isValid()
+	    ||  timer.elapsed() >= m_livePgnInterval);
+}
+
+void GameWriter::finish()
+{
+	if (!isRunning())
+		return;
+
+	m_mutex.lock();
+	m_finishing = true;
+	m_queueChanged.wakeAll();
+	m_mutex.unlock();
+
+	wait();
+	m_finishing = false;
+}
+
+bool GameWriter::syncFile(QFile& file)
+{
+	if (!file.flush())
+		return false;
+#ifdef Q_OS_WIN
+	return _commit(file.handle()) == 0;
+#else
+	return fsync(file.handle()) == 0;
+#endif
+}
+
+void GameWriter::run()
+{
+	OutputFile pgnFile(m_pgnOutput, "PGN");
+	GameArchive archive;
+	OutputFile epdFile(m_epdOutput, "EPD");
+	KeySet epdKeys;
+	TrainingData dataFile;
+	OutputFile eventFile(m_liveEventOutput, "Live event");
+	OutputFile logFile(m_eventLogOutput, "Event log");
+	QElapsedTimer liveTimer;
+	bool finishing = false;
+
+	while (!finishing)
+	{
+		QQueue<PgnGame> games;
+		QQueue<PgnGame> epdGames;
+		QQueue< QVector<TrainingData::Position> > trainingData;
+		QStringList events;
+		QStringList logEvents;
+		PgnGame liveGame;
+		bool hasLiveGame;
+
+		m_mutex.lock();
+		while (queueSize() == 0 && !m_finishing
+		&&     !isLiveGameDue(liveTimer))
+		{
+			// A rate-limited live game wakes the thread
+			// when its interval expires
+			if (m_hasLiveGame)
+				m_queueChanged.wait(&m_mutex, ulong(qMax(qint64(1),
+					m_livePgnInterval - liveTimer.elapsed())));
+			else
+				m_queueChanged.wait(&m_mutex);
+		}
+
+		games.swap(m_games);
+		epdGames.swap(m_epdGames);
+		trainingData.swap(m_trainingData);
+		events.swap(m_events);
+		logEvents.swap(m_logEvents);
+		hasLiveGame = isLiveGameDue(liveTimer);
+		if (hasLiveGame)
+		{
+			liveGame = m_liveGame;
+			m_liveGame = PgnGame();
+			m_hasLiveGame = false;
+		}
+		finishing = m_finishing;
+		m_queueChanged.wakeAll();
+		m_mutex.unlock();
+
+		if (!epdGames.isEmpty() && epdFile.open())
+		{
+			QVector< QPair<quint64, QString> > positions;
+			for (const PgnGame& game : epdGames)
+			{
+				positions.clear();
+				if (!epdPositions(game, m_epdPlies, positions))
+				{
+					qWarning("Could not replay game for EPD output");
+					continue;
+				}
+
+				for (const auto& pos : positions)
+				{
+					if (!m_epdUnique || epdKeys.insert(pos.first))
+						epdFile.stream() << pos.second << "\n";
+				}
+			}
+			if (!epdFile.flush(m_syncPolicy == SyncEachBatch))
+				qWarning("Could not write EPD position");
+		}
+
+		if (!trainingData.isEmpty())
+		{
+			if (!dataFile.isOpen()
+			&&  !dataFile.open(m_dataOutput, QIODevice::Append))
+			{
+				qWarning("Could not open training data file %s",
+					 qPrintable(m_dataOutput));
+			}
+			else
+			{
+				// Partial blocks are kept until the file is
+				// closed unless every batch is synced, so the
+				// blocks stay large enough to compress well
+				bool ok = true;
+				for (const auto& game : trainingData)
+				{
+					for (const TrainingData::Position& pos : game)
+						ok = dataFile.write(pos) && ok;
+				}
+				if (m_syncPolicy == SyncEachBatch)
+					ok = dataFile.flush(true) && ok;
+				if (!ok)
+					qWarning("Could not write training data file %s",
+						 qPrintable(m_dataOutput));
+			}
+		}
+
+		if (!games.isEmpty() && !m_pgnOutput.isEmpty() && pgnFile.open())
+		{
+			for (const PgnGame& game : games)
+			{
+				if (!game.write(pgnFile.stream(), m_pgnOutMode))
+					qWarning("Could not write PGN game");
+			}
+			if (!pgnFile.flush(m_syncPolicy == SyncEachBatch))
+				qWarning("Could not write PGN file %s",
+					 qPrintable(m_pgnOutput));
+		}
+
+		if (!games.isEmpty() && !m_binaryOutput.isEmpty())
+		{
+			if (!archive.isOpen()
+			&&  !archive.open(m_binaryOutput, QIODevice::Append))
+			{
+				qWarning("Could not open game archive %s",
+					 qPrintable(m_binaryOutput));
+			}
+			else
+			{
+				for (const PgnGame& game : games)
+				{
+					if (!archive.writeGame(game))
+						qWarning("Could not archive game");
+				}
+				if (!archive.flush(m_syncPolicy == SyncEachBatch))
+					qWarning("Could not write game archive %s",
+						 qPrintable(m_binaryOutput));
+			}
+		}
+
+		if (!events.isEmpty() && eventFile.open())
+		{
+			for (const QString& event : events)
+				eventFile.stream() << event << "\n";
+			if (!eventFile.flush(false))
+				qWarning("Could not write live events");
+		}
+
+		// The serializer ends each event with a newline
+		if (!logEvents.isEmpty() && logFile.open())
+		{
+			for (const QString& event : logEvents)
+				logFile.stream() << event;
+			if (!logFile.flush(m_syncPolicy == SyncEachBatch))
+				qWarning("Could not write the event log");
+		}
+
+		if (hasLiveGame)
+		{
+			QFile::resize(m_livePgnOutput, 0);
+			liveGame.write(m_livePgnOutput, m_livePgnOutMode);
+			liveTimer.start();
+		}
+	}
+
+	const bool sync = (m_syncPolicy != NoSync);
+	pgnFile.close(sync);
+	epdFile.close(sync);
+	eventFile.close(false);
+	logFile.close(sync);
+	archive.close(sync);
+	dataFile.close(sync);
+}
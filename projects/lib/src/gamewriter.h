@@ -0,0 +1,240 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMEWRITER_H
+#define GAMEWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QStringList>
+#include <QVariantMap>
+#include <QList>
+#include "pgngame.h"
+#include "trainingdata.h"
+class QFile;
+class QElapsedTimer;
+
+
+/*!
+ * \brief A thread for writing finished games to disk
+ *
+ * GameWriter moves the file output of a tournament (PGN, binary
+ * archive, EPD, training data, live PGN, live events and the event log)
+ * off the thread that schedules the games.
+ * Games are queued by writeGame() and written in the same order by
+ * the writer thread, so a slow file system doesn't stall the event
+ * loop.
+ *
+ * The writer thread takes everything that is queued when it wakes up
+ * and writes it as one batch, flushing the files once per batch.
+ * The queue is bounded: if it's full, writeGame() and writeEpd()
+ * block until the writer catches up.
+ *
+ * The EPD positions are extracted from the games on the writer
+ * thread. Duplicate positions can be skipped by their Zobrist keys,
+ * which are kept in a KeySet for the lifetime of the thread.
+ *
+ * The output files must be set before the thread is started.
+ *
+ * \sa Tournament
+ */
+class LIB_EXPORT GameWriter : public QThread
+{
+	Q_OBJECT
+
+	public:
+		/*! When written data is synced to stable storage. */
+		enum SyncPolicy
+		{
+			NoSync,		//!< Leave syncing to the OS (default)
+			SyncOnClose,	//!< Sync when the files are closed
+			SyncEachBatch	//!< Sync after every batch of writes
+		};
+
+		/*! Creates a new, idle GameWriter. */
+		GameWriter(QObject* parent = nullptr);
+		/*! Writes any queued data and destroys the writer. */
+		virtual ~GameWriter();
+
+		/*!
+		 * Sets the PGN output file to \a fileName, with games
+		 * saved in mode \a mode.
+		 */
+		void setPgnOutput(const QString& fileName,
+				  PgnGame::PgnMode mode = PgnGame::Verbose);
+		/*! Sets the binary archive output file to \a fileName. */
+		void setBinaryOutput(const QString& fileName);
+		/*!
+		 * Sets the EPD output file to \a fileName.
+		 *
+		 * The positions at \a plies of each game are saved, where
+		 * ply 0 is the starting position and a negative ply is the
+		 * final position. Plies beyond the end of a game are
+		 * skipped. If \a plies is empty only the final position
+		 * is saved.
+		 *
+		 * If \a unique is true then positions that were already
+		 * saved by this writer are skipped, including
+		 * transpositions.
+		 */
+		void setEpdOutput(const QString& fileName,
+				  const QList<int>& plies = QList<int>(),
+				  bool unique = false);
+		/*! Sets the training data output file to \a fileName. */
+		void setDataOutput(const QString& fileName);
+		/*!
+		 * Sets the live PGN output file to \a fileName, with games
+		 * saved in mode \a mode.
+		 */
+		void setLivePgnOutput(const QString& fileName,
+				      PgnGame::PgnMode mode = PgnGame::Verbose);
+		/*!
+		 * Sets the minimum interval between two live PGN
+		 * rewrites to \a msecs milliseconds.
+		 *
+		 * The default interval is 0, which rewrites the live PGN
+		 * after every move.
+		 */
+		void setLivePgnInterval(int msecs);
+		/*!
+		 * Sets the live event output file to \a fileName.
+		 *
+		 * Live events are appended to the file one line at a
+		 * time, so it can be followed with eg. "tail -f".
+		 */
+		void setLiveEventOutput(const QString& fileName);
+		/*!
+		 * Sets the event log output file to \a fileName.
+		 *
+		 * The event log is a JSON lines file: every event is
+		 * written as a JSON object on its own line.
+		 */
+		void setEventLogOutput(const QString& fileName);
+		/*! Sets the sync policy to \a policy. */
+		void setSyncPolicy(SyncPolicy policy);
+		/*!
+		 * Sets the maximum number of games and positions that
+		 * can be queued to \a size. The default is 64.
+		 */
+		void setMaxQueueSize(int size);
+
+		/*!
+		 * Returns true if any output file is set; otherwise
+		 * returns false.
+		 */
+		bool hasOutput() const;
+		/*!
+		 * Returns true if a training data output file is set;
+		 * otherwise returns false.
+		 */
+		bool hasDataOutput() const;
+		/*!
+		 * Returns true if a live event output file is set; otherwise
+		 * returns false.
+		 */
+		bool hasLiveEventOutput() const;
+		/*!
+		 * Returns true if an event log output file is set;
+		 * otherwise returns false.
+		 */
+		bool hasEventLogOutput() const;
+		/*!
+		 * Returns true if a live PGN or live event output file is
+		 * set; otherwise returns false.
+		 */
+		bool hasLiveOutput() const;
+
+		/*! Queues \a game for the PGN and binary outputs. */
+		void writeGame(const PgnGame& game);
+		/*! Queues the positions of \a game for the EPD output. */
+		void writeEpd(const PgnGame& game);
+		/*! Queues the positions of a game for the training data output. */
+		void writeTrainingData(const QVector<TrainingData::Position>& positions);
+		/*!
+		 * Queues \a game for the live PGN output.
+		 *
+		 * Only the latest live game is kept, so a game that hasn't
+		 * been written yet is replaced by \a game.
+		 */
+		void writeLiveGame(const PgnGame& game);
+		/*!
+		 * Queues a live event of game \a gameNumber for the live
+		 * event output.
+		 *
+		 * The event is written as one line with the game number
+		 * followed by \a fields, all separated by tabs.
+		 */
+		void writeLiveEvent(int gameNumber, const QStringList& fields);
+		/*!
+		 * Queues an event of type \a type for the event log.
+		 *
+		 * The event is written as a JSON object with the members
+		 * of \a data, the event type ("event") and the current
+		 * UTC time ("time").
+		 */
+		void writeEventLog(const QString& type, const QVariantMap& data);
+
+		/*!
+		 * Writes everything in the queue, closes the files and
+		 * stops the thread. Blocks until the thread has finished.
+		 */
+		void finish();
+
+		/*!
+		 * Flushes \a file to stable storage.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool syncFile(QFile& file);
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		int queueSize() const;
+		bool isLiveGameDue(const QElapsedTimer& timer) const;
+
+		QString m_pgnOutput;
+		PgnGame::PgnMode m_pgnOutMode;
+		QString m_binaryOutput;
+		QString m_epdOutput;
+		QList<int> m_epdPlies;
+		bool m_epdUnique;
+		QString m_dataOutput;
+		QString m_livePgnOutput;
+		PgnGame::PgnMode m_livePgnOutMode;
+		int m_livePgnInterval;
+		QString m_liveEventOutput;
+		QString m_eventLogOutput;
+		SyncPolicy m_syncPolicy;
+		int m_maxQueueSize;
+
+		QMutex m_mutex;
+		QWaitCondition m_queueChanged;
+		QQueue<PgnGame> m_games;
+		QQueue<PgnGame> m_epdGames;
+		QQueue< QVector<TrainingData::Position> > m_trainingData;
+		QStringList m_events;
+		QStringList m_logEvents;
+		PgnGame m_liveGame;
+		bool m_hasLiveGame;
+		bool m_finishing;
+};
+
+#endif // GAMEWRITER_H
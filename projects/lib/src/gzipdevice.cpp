@@ -0,0 +1,1020 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "gzipdevice.h"
+#include <cstring>
+#include <functional>
+#include <QFileDevice>
+
+namespace {
+
+const uchar s_magic[3] = { 0x1f, 0x8b, 0x08 };
+
+// The uncompressed size of a BGZF block; a block of incompressible
+// data is stored as is and still fits in 64 kB.
+const int s_blockSize = 0xff00;
+const int s_bufferSize = 0x10000;
+const int s_windowSize = 0x8000;
+
+// An empty BGZF block that marks the end of the data
+const char s_eofBlock[28] =
+{
+	'\x1f', '\x8b', '\x08', '\x04', 0, 0, 0, 0, 0, '\xff', 6, 0,
+	'B', 'C', 2, 0, 0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+const int s_lengthBase[29] =
+{
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const int s_lengthExtra[29] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const int s_distBase[30] =
+{
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+const int s_distExtra[30] =
+{
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+quint32 readLe(const uchar* data, int size)
+{
+	quint32 value = 0;
+	for (int i = size - 1; i >= 0; i--)
+		value = (value << 8) | data[i];
+	return value;
+}
+
+void appendLe(QByteArray& data, quint32 value, int size)
+{
+	for (int i = 0; i < size; i++)
+		data.append(char((value >> (8 * i)) & 0xff));
+}
+
+struct CrcTable
+{
+	CrcTable()
+	{
+		for (quint32 i = 0; i < 256; i++)
+		{
+			quint32 c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+			values[i] = c;
+		}
+	}
+
+	quint32 values[256];
+};
+
+quint32 updateCrc(quint32 crc, const char* data, qint64 size)
+{
+	static const CrcTable s_table;
+
+	crc = ~crc;
+	while (size-- > 0)
+		crc = s_table.values[(crc ^ uchar(*data++)) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+/*
+ * A canonical Huffman code. Codes of up to FastBits bits are decoded
+ * with a single table lookup, longer codes one bit at a time.
+ */
+struct Huffman
+{
+	enum { FastBits = 10 };
+
+	bool build(const uchar* lengths, int n);
+
+	short count[16];
+	short symbol[288];
+	// Code length in the top 4 bits, symbol in the low 12 bits
+	quint16 fast[1 << FastBits];
+};
+
+bool Huffman::build(const uchar* lengths, int n)
+{
+	std::memset(count, 0, sizeof(count));
+	std::memset(fast, 0, sizeof(fast));
+	for (int i = 0; i < n; i++)
+		count[lengths[i]]++;
+	if (count[0] == n)
+		return true;
+
+	// Reject over-subscribed codes
+	int left = 1;
+	for (int len = 1; len < 16; len++)
+	{
+		left = (left << 1) - count[len];
+		if (left < 0)
+			return false;
+	}
+
+	short offsets[16];
+	offsets[1] = 0;
+	for (int len = 1; len < 15; len++)
+		offsets[len + 1] = offsets[len] + count[len];
+	for (int i = 0; i < n; i++)
+	{
+		if (lengths[i] != 0)
+			symbol[offsets[lengths[i]]++] = short(i);
+	}
+
+	// The bits of a code are stored in reverse order
+	int code = 0;
+	int index = 0;
+	for (int len = 1; len <= FastBits; len++)
+	{
+		for (int i = 0; i < count[len]; i++, code++)
+		{
+			int reversed = 0;
+			for (int bit = 0; bit < len; bit++)
+				reversed |= ((code >> bit) & 1) << (len - 1 - bit);
+			const quint16 entry = quint16((len << 12) | symbol[index++]);
+			for (int j = reversed; j < (1 << FastBits); j += 1 << len)
+				fast[j] = entry;
+		}
+		code <<= 1;
+	}
+
+	return true;
+}
+
+struct FixedCodes
+{
+	FixedCodes()
+	{
+		uchar lengths[288];
+		int i = 0;
+		for (; i < 144; i++)
+			lengths[i] = 8;
+		for (; i < 256; i++)
+			lengths[i] = 9;
+		for (; i < 280; i++)
+			lengths[i] = 7;
+		for (; i < 288; i++)
+			lengths[i] = 8;
+		literals.build(lengths, 288);
+
+		for (i = 0; i < 30; i++)
+			lengths[i] = 5;
+		distances.build(lengths, 30);
+	}
+
+	Huffman literals;
+	Huffman distances;
+};
+
+} // anonymous namespace
+
+/*
+ * A streaming gzip decoder (RFC 1952 and RFC 1951) that reads the
+ * compressed data from a shared device, starting at a given offset.
+ */
+class GzipReader
+{
+	public:
+		typedef std::function<void (qint64, qint64)> MemberFunction;
+
+		GzipReader(QIODevice* device, const MemberFunction& onMember);
+
+		void start(qint64 compressedPos, qint64 pos);
+		qint64 read(char* data, qint64 maxSize);
+
+	private:
+		enum State
+		{
+			HeaderState,
+			BlockState,
+			StoredState,
+			HuffmanState,
+			TrailerState,
+			EndState,
+			ErrorState
+		};
+
+		bool fillBits(int count);
+		bool getBits(int count, int& value);
+		bool getByte(uchar& c);
+		bool getInputByte(uchar& c);
+		void alignToByte();
+		int decode(const Huffman& code);
+		bool skipBytes(int count);
+		bool skipString();
+		State readHeader();
+		bool readBlockHeader();
+		bool readDynamicCodes();
+		bool readTrailer();
+
+		QIODevice* m_device;
+		MemberFunction m_onMember;
+		QByteArray m_input;
+		int m_inputPos;
+		qint64 m_inputStart;
+		quint64 m_bitBuffer;
+		int m_bitCount;
+		State m_state;
+		bool m_finalBlock;
+		int m_storedSize;
+		int m_copyLength;
+		int m_copyDistance;
+		const Huffman* m_literals;
+		const Huffman* m_distances;
+		Huffman m_dynamicLiterals;
+		Huffman m_dynamicDistances;
+		QByteArray m_window;
+		quint32 m_crc;
+		quint32 m_memberSize;
+		qint64 m_pos;
+};
+
+GzipReader::GzipReader(QIODevice* device, const MemberFunction& onMember)
+	: m_device(device),
+	  m_onMember(onMember),
+	  m_window(s_windowSize, 0)
+{
+	start(0, 0);
+}
+
+void GzipReader::start(qint64 compressedPos, qint64 pos)
+{
+	m_input.clear();
+	m_inputPos = 0;
+	m_inputStart = compressedPos;
+	m_bitBuffer = 0;
+	m_bitCount = 0;
+	m_state = HeaderState;
+	m_finalBlock = false;
+	m_storedSize = 0;
+	m_copyLength = 0;
+	m_copyDistance = 0;
+	m_literals = nullptr;
+	m_distances = nullptr;
+	m_crc = 0;
+	m_memberSize = 0;
+	m_pos = pos;
+}
+
+bool GzipReader::getByte(uchar& c)
+{
+	if (m_bitCount >= 8)
+	{
+		c = uchar(m_bitBuffer & 0xff);
+		m_bitBuffer >>= 8;
+		m_bitCount -= 8;
+		return true;
+	}
+
+	return getInputByte(c);
+}
+
+bool GzipReader::getInputByte(uchar& c)
+{
+	if (m_inputPos >= m_input.size())
+	{
+		// The device may be shared by other readers
+		m_inputStart += m_input.size();
+		m_inputPos = 0;
+		m_input.clear();
+		if (!m_device->seek(m_inputStart))
+			return false;
+		m_input = m_device->read(s_bufferSize);
+		if (m_input.isEmpty())
+			return false;
+	}
+	c = uchar(m_input.constData()[m_inputPos++]);
+	return true;
+}
+
+bool GzipReader::fillBits(int count)
+{
+	while (m_bitCount < count)
+	{
+		// Fill the bit buffer in one go if the input allows it
+		const int available = qMin(m_input.size() - m_inputPos,
+					   (63 - m_bitCount) / 8);
+		if (available > 0)
+		{
+			const uchar* p = reinterpret_cast<const uchar*>(
+				m_input.constData()) + m_inputPos;
+			for (int i = 0; i < available; i++)
+			{
+				m_bitBuffer |= quint64(p[i]) << m_bitCount;
+				m_bitCount += 8;
+			}
+			m_inputPos += available;
+			continue;
+		}
+
+		uchar c;
+		if (!getInputByte(c))
+			return false;
+		m_bitBuffer |= quint64(c) << m_bitCount;
+		m_bitCount += 8;
+	}
+
+	return true;
+}
+
+bool GzipReader::getBits(int count, int& value)
+{
+	if (!fillBits(count))
+		return false;
+
+	value = int(m_bitBuffer & ((1u << count) - 1));
+	m_bitBuffer >>= count;
+	m_bitCount -= count;
+	return true;
+}
+
+void GzipReader::alignToByte()
+{
+	const int extra = m_bitCount % 8;
+	m_bitBuffer >>= extra;
+	m_bitCount -= extra;
+}
+
+int GzipReader::decode(const Huffman& code)
+{
+	fillBits(Huffman::FastBits);
+	if (m_bitCount >= Huffman::FastBits)
+	{
+		const quint16 entry = code.fast[m_bitBuffer
+			& ((1u << Huffman::FastBits) - 1)];
+		if (entry != 0)
+		{
+			const int len = entry >> 12;
+			m_bitBuffer >>= len;
+			m_bitCount -= len;
+			return entry & 0xfff;
+		}
+	}
+
+	int value = 0;
+	int first = 0;
+	int index = 0;
+	for (int len = 1; len < 16; len++)
+	{
+		int bit;
+		if (!getBits(1, bit))
+			return -1;
+		value |= bit;
+
+		const int count = code.count[len];
+		if (value - count < first)
+			return code.symbol[index + (value - first)];
+		index += count;
+		first = (first + count) << 1;
+		value <<= 1;
+	}
+
+	return -1;
+}
+
+bool GzipReader::skipBytes(int count)
+{
+	uchar c;
+	while (count-- > 0)
+	{
+		if (!getByte(c))
+			return false;
+	}
+	return true;
+}
+
+bool GzipReader::skipString()
+{
+	uchar c;
+	do
+	{
+		if (!getByte(c))
+			return false;
+	} while (c != 0);
+
+	return true;
+}
+
+GzipReader::State GzipReader::readHeader()
+{
+	const qint64 memberPos = m_inputStart + m_inputPos - m_bitCount / 8;
+
+	uchar header[10];
+	for (int i = 0; i < 10; i++)
+	{
+		if (!getByte(header[i]))
+			return (i == 0) ? EndState : ErrorState;
+	}
+
+	// Anything after the last member that isn't gzip data is ignored
+	if (std::memcmp(header, s_magic, sizeof(s_magic)) != 0)
+		return (memberPos == 0) ? ErrorState : EndState;
+
+	const uchar flags = header[3];
+	if (flags & 0xe0)
+		return ErrorState;
+
+	if (m_onMember)
+		m_onMember(memberPos, m_pos);
+
+	uchar c[2];
+	if ((flags & 0x04)
+	&&  (!getByte(c[0]) || !getByte(c[1]) || !skipBytes(int(readLe(c, 2)))))
+		return ErrorState;
+	if ((flags & 0x08) && !skipString())
+		return ErrorState;
+	if ((flags & 0x10) && !skipString())
+		return ErrorState;
+	if ((flags & 0x02) && !skipBytes(2))
+		return ErrorState;
+
+	m_crc = 0;
+	m_memberSize = 0;
+	m_finalBlock = false;
+	return BlockState;
+}
+
+bool GzipReader::readBlockHeader()
+{
+	int type;
+	int final;
+	if (!getBits(1, final) || !getBits(2, type))
+		return false;
+	m_finalBlock = (final != 0);
+
+	if (type == 0)
+	{
+		alignToByte();
+		uchar header[4];
+		for (int i = 0; i < 4; i++)
+		{
+			if (!getByte(header[i]))
+				return false;
+		}
+		const quint32 size = readLe(header, 2);
+		if (size != (~readLe(header + 2, 2) & 0xffff))
+			return false;
+
+		m_storedSize = int(size);
+		m_state = StoredState;
+		return true;
+	}
+	if (type == 1)
+	{
+		static const FixedCodes s_fixed;
+		m_literals = &s_fixed.literals;
+		m_distances = &s_fixed.distances;
+		m_state = HuffmanState;
+		return true;
+	}
+	if (type == 2 && readDynamicCodes())
+	{
+		m_literals = &m_dynamicLiterals;
+		m_distances = &m_dynamicDistances;
+		m_state = HuffmanState;
+		return true;
+	}
+
+	return false;
+}
+
+bool GzipReader::readDynamicCodes()
+{
+	static const uchar s_order[19] =
+	{
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	int literalCount;
+	int distanceCount;
+	int codeCount;
+	if (!getBits(5, literalCount)
+	||  !getBits(5, distanceCount)
+	||  !getBits(4, codeCount))
+		return false;
+	literalCount += 257;
+	distanceCount += 1;
+	codeCount += 4;
+	if (literalCount > 286 || distanceCount > 30)
+		return false;
+
+	uchar lengths[286 + 30];
+	for (int i = 0; i < 19; i++)
+	{
+		int len = 0;
+		if (i < codeCount && !getBits(3, len))
+			return false;
+		lengths[s_order[i]] = uchar(len);
+	}
+
+	Huffman lengthCode;
+	if (!lengthCode.build(lengths, 19))
+		return false;
+
+	const int total = literalCount + distanceCount;
+	for (int i = 0; i < total; )
+	{
+		const int symbol = decode(lengthCode);
+		if (symbol < 0)
+			return false;
+		if (symbol < 16)
+		{
+			lengths[i++] = uchar(symbol);
+			continue;
+		}
+
+		int len = 0;
+		int repeat;
+		if (symbol == 16)
+		{
+			if (i == 0 || !getBits(2, repeat))
+				return false;
+			len = lengths[i - 1];
+			repeat += 3;
+		}
+		else if (symbol == 17)
+		{
+			if (!getBits(3, repeat))
+				return false;
+			repeat += 3;
+		}
+		else
+		{
+			if (!getBits(7, repeat))
+				return false;
+			repeat += 11;
+		}
+
+		if (i + repeat > total)
+			return false;
+		while (repeat-- > 0)
+			lengths[i++] = uchar(len);
+	}
+
+	// A block without an end-of-block code can't be decoded
+	return lengths[256] != 0
+	    && m_dynamicLiterals.build(lengths, literalCount)
+	    && m_dynamicDistances.build(lengths + literalCount, distanceCount);
+}
+
+bool GzipReader::readTrailer()
+{
+	alignToByte();
+
+	uchar trailer[8];
+	for (int i = 0; i < 8; i++)
+	{
+		if (!getByte(trailer[i]))
+			return false;
+	}
+	return readLe(trailer, 4) == m_crc
+	    && readLe(trailer + 4, 4) == m_memberSize;
+}
+
+qint64 GzipReader::read(char* data, qint64 maxSize)
+{
+	char* out = data;
+	char* const end = data + maxSize;
+	const char* crcStart = out;
+	const int mask = s_windowSize - 1;
+	char* window = m_window.data();
+
+	while (out < end && m_state != EndState && m_state != ErrorState)
+	{
+		switch (m_state)
+		{
+		case HeaderState:
+			m_state = readHeader();
+			break;
+		case BlockState:
+			if (!readBlockHeader())
+				m_state = ErrorState;
+			break;
+		case StoredState:
+			while (m_storedSize > 0 && out < end)
+			{
+				uchar c;
+				if (!getByte(c))
+				{
+					m_state = ErrorState;
+					break;
+				}
+				*out++ = char(c);
+				window[m_memberSize++ & mask] = char(c);
+				m_storedSize--;
+			}
+			if (m_storedSize == 0 && m_state == StoredState)
+				m_state = m_finalBlock ? TrailerState : BlockState;
+			break;
+		case HuffmanState:
+			while (out < end)
+			{
+				if (m_copyLength > 0)
+				{
+					int n = int(qMin(qint64(m_copyLength), qint64(end - out)));
+					m_copyLength -= n;
+					quint32 from = m_memberSize - quint32(m_copyDistance);
+					while (n-- > 0)
+					{
+						const char c = window[from++ & mask];
+						*out++ = c;
+						window[m_memberSize++ & mask] = c;
+					}
+					continue;
+				}
+
+				int symbol = decode(*m_literals);
+				if (symbol < 256)
+				{
+					if (symbol < 0)
+					{
+						m_state = ErrorState;
+						break;
+					}
+					*out++ = char(symbol);
+					window[m_memberSize++ & mask] = char(symbol);
+					continue;
+				}
+				if (symbol == 256)
+				{
+					m_state = m_finalBlock ? TrailerState : BlockState;
+					break;
+				}
+
+				symbol -= 257;
+				int extra = 0;
+				if (symbol >= 29
+				||  !getBits(s_lengthExtra[symbol], extra))
+				{
+					m_state = ErrorState;
+					break;
+				}
+				m_copyLength = s_lengthBase[symbol] + extra;
+
+				symbol = decode(*m_distances);
+				if (symbol < 0 || symbol >= 30
+				||  !getBits(s_distExtra[symbol], extra))
+				{
+					m_state = ErrorState;
+					break;
+				}
+				m_copyDistance = s_distBase[symbol] + extra;
+				if (quint32(m_copyDistance) > m_memberSize)
+				{
+					m_state = ErrorState;
+					break;
+				}
+			}
+			break;
+		case TrailerState:
+			m_crc = updateCrc(m_crc, crcStart, out - crcStart);
+			crcStart = out;
+			m_state = readTrailer() ? HeaderState : ErrorState;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (m_state == ErrorState)
+	{
+		qWarning("Invalid gzip data at offset %lld",
+			 m_inputStart + m_inputPos);
+		return -1;
+	}
+
+	m_crc = updateCrc(m_crc, crcStart, out - crcStart);
+	m_pos += out - data;
+	return out - data;
+}
+
+GzipDevice::GzipDevice(QIODevice* device, QObject* parent)
+	: QIODevice(parent),
+	  m_device(device),
+	  m_reader(nullptr),
+	  m_indexed(false),
+	  m_size(-1),
+	  m_readerPos(0)
+{
+	Q_ASSERT(device != nullptr);
+}
+
+GzipDevice::~GzipDevice()
+{
+	close();
+	delete m_reader;
+}
+
+bool GzipDevice::isGzip(QIODevice* device)
+{
+	Q_ASSERT(device != nullptr);
+
+	const QByteArray data(device->peek(sizeof(s_magic)));
+	return isGzip(data.constData(), data.size());
+}
+
+bool GzipDevice::isGzip(const char* data, qint64 size)
+{
+	return size >= qint64(sizeof(s_magic))
+	    && std::memcmp(data, s_magic, sizeof(s_magic)) == 0;
+}
+
+bool GzipDevice::isGzipFileName(const QString& fileName)
+{
+	return fileName.endsWith(".gz", Qt::CaseInsensitive);
+}
+
+QIODevice* GzipDevice::device() const
+{
+	return m_device;
+}
+
+bool GzipDevice::open(OpenMode mode)
+{
+	if (isOpen() || !m_device->isOpen()
+	||  (mode & ReadWrite) == ReadWrite
+	||  (mode & ReadWrite) == 0)
+		return false;
+
+	if (mode & ReadOnly)
+	{
+		if (!m_device->isReadable())
+			return false;
+		m_device->setTextModeEnabled(false);
+
+		m_members.clear();
+		m_indexed = false;
+		m_size = -1;
+		indexBlocks();
+
+		if (m_reader == nullptr)
+			m_reader = new GzipReader(m_device,
+				[this](qint64 compressedPos, qint64 pos)
+				{
+					addMember(compressedPos, pos);
+				});
+		m_reader->start(0, 0);
+		m_readerPos = 0;
+	}
+	else
+	{
+		if (!m_device->isWritable())
+			return false;
+		m_pending.clear();
+	}
+
+	return QIODevice::open(mode);
+}
+
+void GzipDevice::close()
+{
+	if (!isOpen())
+		return;
+
+	if (isWritable())
+	{
+		flush();
+		if (m_device->write(s_eofBlock, sizeof(s_eofBlock))
+		    != qint64(sizeof(s_eofBlock)))
+			qWarning("Could not write gzip data");
+		flush();
+	}
+	QIODevice::close();
+}
+
+bool GzipDevice::flush()
+{
+	if (!isWritable())
+		return false;
+
+	if (!m_pending.isEmpty())
+	{
+		if (!writeBlock(m_pending.constData(), m_pending.size()))
+			return false;
+		m_pending.clear();
+	}
+
+	QFileDevice* file = qobject_cast<QFileDevice*>(m_device);
+	return file == nullptr || file->flush();
+}
+
+bool GzipDevice::isSequential() const
+{
+	return false;
+}
+
+qint64 GzipDevice::size() const
+{
+	if (!isReadable())
+		return pos();
+
+	if (!m_indexed)
+		const_cast<GzipDevice*>(this)->indexMembers();
+	return m_size;
+}
+
+bool GzipDevice::seek(qint64 pos)
+{
+	if (!isReadable() || !QIODevice::seek(pos))
+		return false;
+	if (pos == m_readerPos)
+		return true;
+
+	// Find the last member that starts at or before pos
+	int first = 0;
+	int last = m_members.size();
+	while (first < last)
+	{
+		const int mid = (first + last) / 2;
+		if (m_members.at(mid).pos <= pos)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	if (first == 0)
+		return false;
+
+	const Member& member = m_members.at(first - 1);
+	if (pos < m_readerPos || member.pos > m_readerPos)
+		restart(member);
+	return skip(pos - m_readerPos);
+}
+
+qint64 GzipDevice::readData(char* data, qint64 maxSize)
+{
+	if (m_reader == nullptr)
+		return -1;
+
+	const qint64 n = m_reader->read(data, maxSize);
+	if (n > 0)
+		m_readerPos += n;
+	return n;
+}
+
+qint64 GzipDevice::writeData(const char* data, qint64 size)
+{
+	m_pending.append(data, int(size));
+	while (m_pending.size() >= s_blockSize)
+	{
+		if (!writeBlock(m_pending.constData(), s_blockSize))
+			return -1;
+		m_pending.remove(0, s_blockSize);
+	}
+
+	return size;
+}
+
+void GzipDevice::addMember(qint64 compressedPos, qint64 pos)
+{
+	if (m_members.isEmpty()
+	||  compressedPos > m_members.last().compressedPos)
+	{
+		Member member = { compressedPos, pos };
+		m_members.append(member);
+	}
+}
+
+void GzipDevice::indexBlocks()
+{
+	// The extra field of a BGZF header holds the size of the block,
+	// and the last four bytes of the block its uncompressed size
+	qint64 compressedPos = 0;
+	qint64 pos = 0;
+	forever
+	{
+		if (!m_device->seek(compressedPos))
+			break;
+		const QByteArray header(m_device->read(18));
+		if (header.isEmpty())
+		{
+			m_indexed = true;
+			m_size = pos;
+			break;
+		}
+
+		const uchar* h = reinterpret_cast<const uchar*>(header.constData());
+		if (header.size() < 18
+		||  !isGzip(header.constData(), header.size())
+		||  !(h[3] & 0x04)
+		||  readLe(h + 10, 2) != 6
+		||  h[12] != 'B' || h[13] != 'C'
+		||  readLe(h + 14, 2) != 2)
+		{
+			// Other members are indexed when they're decompressed
+			addMember(compressedPos, pos);
+			break;
+		}
+
+		const qint64 blockSize = qint64(readLe(h + 16, 2)) + 1;
+		if (!m_device->seek(compressedPos + blockSize - 4))
+			break;
+		const QByteArray trailer(m_device->read(4));
+		if (trailer.size() != 4)
+			break;
+
+		addMember(compressedPos, pos);
+		compressedPos += blockSize;
+		pos += readLe(reinterpret_cast<const uchar*>(trailer.constData()), 4);
+	}
+}
+
+void GzipDevice::indexMembers()
+{
+	m_indexed = true;
+	if (m_members.isEmpty())
+		return;
+
+	// Decompress the rest of the data to find its size
+	const Member member = m_members.last();
+	GzipReader reader(m_device,
+		[this](qint64 compressedPos, qint64 pos)
+		{
+			addMember(compressedPos, pos);
+		});
+	reader.start(member.compressedPos, member.pos);
+
+	QByteArray buffer(s_bufferSize, 0);
+	qint64 size = member.pos;
+	qint64 n;
+	while ((n = reader.read(buffer.data(), buffer.size())) > 0)
+		size += n;
+	m_size = size;
+}
+
+bool GzipDevice::restart(const Member& member)
+{
+	m_reader->start(member.compressedPos, member.pos);
+	m_readerPos = member.pos;
+	return true;
+}
+
+bool GzipDevice::skip(qint64 count)
+{
+	char buffer[4096];
+	while (count > 0)
+	{
+		const qint64 n = m_reader->read(buffer,
+			qMin(count, qint64(sizeof(buffer))));
+		if (n <= 0)
+			return false;
+		m_readerPos += n;
+		count -= n;
+	}
+
+	return true;
+}
+
+bool GzipDevice::writeBlock(const char* data, int size)
+{
+	Q_ASSERT(size > 0 && size <= s_blockSize);
+
+	// qCompress() adds a 32-bit size prefix, a two-byte zlib header
+	// and an Adler-32 checksum to the raw deflate data
+	const QByteArray compressed(qCompress(
+		reinterpret_cast<const uchar*>(data), size));
+	const int deflateSize = compressed.size() - 10;
+
+	QByteArray block;
+	block.reserve(s_bufferSize);
+	block.append(s_eofBlock, 16);
+	appendLe(block, 0, 2);
+	if (deflateSize > 0 && deflateSize < size + 5)
+		block.append(compressed.constData() + 6, deflateSize);
+	else
+	{
+		// A single stored block
+		block.append(char(0x01));
+		appendLe(block, quint32(size), 2);
+		appendLe(block, ~quint32(size), 2);
+		block.append(data, size);
+	}
+	appendLe(block, updateCrc(0, data, size), 4);
+	appendLe(block, quint32(size), 4);
+
+	const quint32 blockSize = quint32(block.size() - 1);
+	block[16] = char(blockSize & 0xff);
+	block[17] = char(blockSize >> 8);
+
+	return m_device->write(block) == block.size();
+}
@@ -0,0 +1,120 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GZIPDEVICE_H
+#define GZIPDEVICE_H
+
+#include <QIODevice>
+#include <QVector>
+class GzipReader;
+
+
+/*!
+ * \brief A device for reading and writing gzip-compressed data
+ *
+ * GzipDevice decompresses data from, or compresses data to, another
+ * QIODevice. The positions and sizes of a GzipDevice are uncompressed
+ * offsets, so the device can replace an uncompressed file.
+ *
+ * Data is written as a series of independently compressed gzip
+ * members of at most 64 kB each, using the BGZF layout of the
+ * "bgzip" tool. The output is a valid gzip file.
+ *
+ * Any gzip file can be read. BGZF files can be read in random order
+ * efficiently, because a seek only needs to decompress one block.
+ * In other gzip files a seek backwards has to decompress the file
+ * from the beginning of the gzip member.
+ */
+class LIB_EXPORT GzipDevice : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*!
+		 * Creates a new GzipDevice that operates on \a device.
+		 *
+		 * \a device must be opened before the GzipDevice, and it
+		 * must stay open until the GzipDevice is closed.
+		 */
+		GzipDevice(QIODevice* device, QObject* parent = nullptr);
+		/*! Closes the device and destroys the object. */
+		virtual ~GzipDevice();
+
+		/*!
+		 * Returns true if the data at the current position of
+		 * \a device starts a gzip member; otherwise returns false.
+		 *
+		 * The position of \a device isn't changed.
+		 */
+		static bool isGzip(QIODevice* device);
+		/*!
+		 * Returns true if the \a size bytes of \a data start a
+		 * gzip member; otherwise returns false.
+		 */
+		static bool isGzip(const char* data, qint64 size);
+		/*!
+		 * Returns true if \a fileName has a ".gz" suffix, which
+		 * means that output to it should be compressed.
+		 */
+		static bool isGzipFileName(const QString& fileName);
+
+		/*! Returns the compressed device. */
+		QIODevice* device() const;
+		/*!
+		 * Compresses the buffered data and flushes it to the
+		 * compressed device.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool flush();
+
+		// Inherited from QIODevice
+		virtual bool open(OpenMode mode);
+		virtual void close();
+		virtual bool isSequential() const;
+		virtual qint64 size() const;
+		virtual bool seek(qint64 pos);
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 size);
+
+	private:
+		struct Member
+		{
+			qint64 compressedPos;
+			qint64 pos;
+		};
+
+		void addMember(qint64 compressedPos, qint64 pos);
+		void indexBlocks();
+		void indexMembers();
+		bool restart(const Member& member);
+		bool skip(qint64 count);
+		bool writeBlock(const char* data, int size);
+
+		QIODevice* m_device;
+		GzipReader* m_reader;
+		QVector<Member> m_members;
+		bool m_indexed;
+		qint64 m_size;
+		qint64 m_readerPos;
+		QByteArray m_pending;
+};
+
+#endif // GZIPDEVICE_H
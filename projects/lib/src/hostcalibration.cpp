@@ -0,0 +1,132 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hostcalibration.h"
+#include <cctype>
+#include <QElapsedTimer>
+#include <QList>
+#include <QProcess>
+#include <QScopedPointer>
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+namespace {
+
+// The perft depth of one round of the workload, which takes a few
+// milliseconds so that the timer is checked often enough
+const int s_perftDepth = 3;
+
+quint64 perft(Chess::Board* board, int depth)
+{
+	Chess::MoveList moves;
+	board->legalMoves(moves);
+	if (depth <= 1 || moves.isEmpty())
+		return moves.size();
+
+	quint64 nodeCount = 0;
+	for (const auto& move : moves)
+	{
+		board->makeMove(move);
+		nodeCount += perft(board, depth - 1);
+		board->undoMove();
+	}
+
+	return nodeCount;
+}
+
+// Returns the first number in 'line' after position 'pos'
+qint64 numberAfter(const QByteArray& line, int pos)
+{
+	while (pos < line.size() && !isdigit(uchar(line.at(pos))))
+	{
+		// Only separators can come between the label and the value
+		const char c = line.at(pos);
+		if (c != ' ' && c != '\t' && c != ':' && c != '=')
+			return 0;
+		pos++;
+	}
+
+	qint64 value = 0;
+	while (pos < line.size() && isdigit(uchar(line.at(pos))))
+		value = value * 10 + (line.at(pos++) - '0');
+	return value;
+}
+
+} // anonymous namespace
+
+qint64 HostCalibration::perftSpeed(int msecs)
+{
+	QScopedPointer<Chess::Board> board(Chess::BoardFactory::create("standard"));
+	board->reset();
+
+	QElapsedTimer timer;
+	timer.start();
+	quint64 nodes = 0;
+	do
+		nodes += perft(board.data(), s_perftDepth);
+	while (timer.elapsed() < msecs);
+
+	return qint64(nodes * 1000 / quint64(qMax(timer.elapsed(), qint64(1))));
+}
+
+qint64 HostCalibration::benchSpeed(const QString& command, int timeout)
+{
+	QProcess process;
+	// Stockfish writes its bench report to standard error
+	process.setProcessChannelMode(QProcess::MergedChannels);
+	process.start(command, QIODevice::ReadOnly);
+	if (!process.waitForStarted(timeout)
+	||  !process.waitForFinished(timeout))
+	{
+		qWarning("benchmark failed: %s", qPrintable(command));
+		process.kill();
+		process.waitForFinished(1000);
+		return 0;
+	}
+
+	const qint64 speed = parseBenchOutput(process.readAll());
+	if (speed == 0)
+		qWarning("no nodes per second in the output of %s",
+			 qPrintable(command));
+	return speed;
+}
+
+qint64 HostCalibration::parseBenchOutput(const QByteArray& output)
+{
+	const QList<QByteArray> lines = output.split('\n');
+	for (int i = lines.size() - 1; i >= 0; i--)
+	{
+		const QByteArray line = lines.at(i).toLower();
+		for (const char* label : { "nodes/second", "nps" })
+		{
+			const int pos = line.indexOf(label);
+			if (pos == -1)
+				continue;
+			const qint64 value = numberAfter(line, pos + int(qstrlen(label)));
+			if (value > 0)
+				return value;
+		}
+	}
+
+	return 0;
+}
+
+double HostCalibration::scaleFactor(qint64 speed, qint64 referenceSpeed)
+{
+	Q_ASSERT(speed > 0 && referenceSpeed > 0);
+	return double(referenceSpeed) / double(speed);
+}
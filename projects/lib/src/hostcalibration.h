@@ -0,0 +1,73 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOSTCALIBRATION_H
+#define HOSTCALIBRATION_H
+
+#include <QByteArray>
+#include <QString>
+
+/*!
+ * \brief Functions for measuring the speed of the host.
+ *
+ * The same time control means a different search effort on a slow
+ * and a fast machine. HostCalibration measures the speed of the host
+ * in nodes per second with a short benchmark, and gives the factor
+ * that scales the time control to the effort it has on a reference
+ * host.
+ *
+ * The benchmark is either the built-in perft workload, which
+ * generates the legal moves of the standard chess start position a
+ * few plies deep, or the \c bench command of a chess engine. The
+ * reference speed has to be measured with the same benchmark and the
+ * same program version.
+ *
+ * \sa TimeControl::scale()
+ */
+class LIB_EXPORT HostCalibration
+{
+	public:
+		/*!
+		 * Runs the built-in perft workload for at least \a msecs
+		 * milliseconds and returns the nodes per second.
+		 */
+		static qint64 perftSpeed(int msecs);
+		/*!
+		 * Runs the benchmark \a command, for example
+		 * "stockfish bench", and returns the nodes per second it
+		 * reports. Returns 0 if the command fails or if it
+		 * doesn't finish in \a timeout milliseconds.
+		 */
+		static qint64 benchSpeed(const QString& command, int timeout);
+		/*!
+		 * Returns the nodes per second reported in the output
+		 * \a output of a \c bench command, or 0 if there is no
+		 * such report.
+		 *
+		 * The value is read from the last line that has a
+		 * "Nodes/second" or "nps" label followed by a number.
+		 */
+		static qint64 parseBenchOutput(const QByteArray& output);
+		/*!
+		 * Returns the factor that scales the time control to
+		 * the effort it has on a host with the speed
+		 * \a referenceSpeed, when this host's speed is \a speed.
+		 */
+		static double scaleFactor(qint64 speed, qint64 referenceSpeed);
+};
+
+#endif // HOSTCALIBRATION_H
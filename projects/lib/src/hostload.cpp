@@ -0,0 +1,119 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hostload.h"
+#ifdef Q_OS_WIN
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <QFile>
+#include <QList>
+#endif
+
+HostLoad::HostLoad()
+	: m_total(-1),
+	  m_idle(-1),
+	  m_steal(-1),
+	  m_runnable(-1)
+{
+}
+
+HostLoad HostLoad::sample()
+{
+	HostLoad load;
+
+#ifdef Q_OS_WIN
+	FILETIME idleTime, kernelTime, userTime;
+	if (!GetSystemTimes(&idleTime, &kernelTime, &userTime))
+		return load;
+
+	ULARGE_INTEGER idle, kernel, user;
+	idle.LowPart = idleTime.dwLowDateTime;
+	idle.HighPart = idleTime.dwHighDateTime;
+	kernel.LowPart = kernelTime.dwLowDateTime;
+	kernel.HighPart = kernelTime.dwHighDateTime;
+	user.LowPart = userTime.dwLowDateTime;
+	user.HighPart = userTime.dwHighDateTime;
+
+	// The kernel time includes the idle time
+	load.m_total = qint64(kernel.QuadPart + user.QuadPart);
+	load.m_idle = qint64(idle.QuadPart);
+#elif defined(Q_OS_LINUX)
+	// Files in /proc have no size, so they're read line by line
+	// instead of checking for the end of the file
+	QFile file("/proc/stat");
+	if (!file.open(QIODevice::ReadOnly))
+		return load;
+
+	QByteArray line;
+	while (!(line = file.readLine()).isEmpty())
+	{
+		const QList<QByteArray> fields = line.simplified().split(' ');
+		if (fields.first() == "cpu" && fields.size() >= 5)
+		{
+			// user nice system idle iowait irq softirq steal;
+			// guest time is already included in user time
+			load.m_total = 0;
+			for (int i = 1; i < qMin(fields.size(), 9); i++)
+				load.m_total += fields.at(i).toLongLong();
+			load.m_idle = fields.at(4).toLongLong();
+			if (fields.size() >= 6)
+				load.m_idle += fields.at(5).toLongLong();
+			load.m_steal = fields.size() >= 9
+				       ? fields.at(8).toLongLong() : -1;
+		}
+		else if (fields.first() == "procs_running" && fields.size() >= 2)
+			load.m_runnable = fields.at(1).toInt();
+	}
+#endif
+
+	return load;
+}
+
+bool HostLoad::isNull() const
+{
+	return m_total < 0;
+}
+
+int HostLoad::runnableThreads() const
+{
+	return m_runnable;
+}
+
+double HostLoad::busyRatio(const HostLoad& start) const
+{
+	if (isNull() || start.isNull())
+		return -1.0;
+
+	const qint64 total = m_total - start.m_total;
+	if (total <= 0)
+		return -1.0;
+
+	const qint64 idle = m_idle - start.m_idle;
+	return qBound(0.0, double(total - idle) / total, 1.0);
+}
+
+double HostLoad::stealRatio(const HostLoad& start) const
+{
+	if (isNull() || start.isNull() || m_steal < 0 || start.m_steal < 0)
+		return -1.0;
+
+	const qint64 total = m_total - start.m_total;
+	if (total <= 0)
+		return -1.0;
+
+	return qBound(0.0, double(m_steal - start.m_steal) / total, 1.0);
+}
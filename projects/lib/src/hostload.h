@@ -0,0 +1,75 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOSTLOAD_H
+#define HOSTLOAD_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief A snapshot of the CPU load of the host.
+ *
+ * HostLoad counts the busy, idle and stolen CPU time of the whole host
+ * and the number of runnable threads. Comparing two snapshots tells
+ * whether the host has CPU power to spare for more games, or whether
+ * the engines already compete for the CPUs or lose time to other
+ * virtual machines.
+ *
+ * Snapshots can be taken on Linux and Windows. Only Linux reports
+ * stolen time and runnable threads.
+ */
+class LIB_EXPORT HostLoad
+{
+	public:
+		/*! Creates a null snapshot. */
+		HostLoad();
+
+		/*!
+		 * Returns a snapshot of the current host load, or a null
+		 * snapshot if it can't be read.
+		 */
+		static HostLoad sample();
+
+		/*! Returns true if this is a null snapshot. */
+		bool isNull() const;
+
+		/*!
+		 * Returns the number of threads that were running or
+		 * waiting for a CPU, or -1 if it's unknown.
+		 */
+		int runnableThreads() const;
+		/*!
+		 * Returns the share of CPU time between \a start and this
+		 * snapshot that was used, from 0 to 1, or -1 if it's unknown.
+		 * Stolen time counts as used.
+		 */
+		double busyRatio(const HostLoad& start) const;
+		/*!
+		 * Returns the share of CPU time between \a start and this
+		 * snapshot that was stolen by the hypervisor, from 0 to 1,
+		 * or -1 if it's unknown.
+		 */
+		double stealRatio(const HostLoad& start) const;
+
+	private:
+		qint64 m_total;
+		qint64 m_idle;
+		qint64 m_steal;
+		int m_runnable;
+};
+
+#endif // HOSTLOAD_H
@@ -0,0 +1,93 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "indexpermutation.h"
+
+namespace {
+
+quint64 mix(quint64 x)
+{
+	// The SplitMix64 finalizer
+	x ^= x >> 30;
+	x *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+	x ^= x >> 27;
+	x *= Q_UINT64_C(0x94d049bb133111eb);
+	x ^= x >> 31;
+	return x;
+}
+
+} // anonymous namespace
+
+IndexPermutation::IndexPermutation()
+	: m_size(0),
+	  m_halfBits(0),
+	  m_halfMask(0)
+{
+	for (int i = 0; i < RoundCount; i++)
+		m_keys[i] = 0;
+}
+
+IndexPermutation::IndexPermutation(quint64 size, quint32 seed)
+	: m_size(size),
+	  m_halfBits(1),
+	  m_halfMask(0)
+{
+	// The network works on an even number of bits, which covers at
+	// most four times the range, so an index takes no more than four
+	// passes through the network on average
+	while (m_halfBits < 32 && (size - 1) >> (m_halfBits * 2) != 0)
+		m_halfBits++;
+	m_halfMask = (Q_UINT64_C(1) << m_halfBits) - 1;
+
+	quint64 key = seed;
+	for (int i = 0; i < RoundCount; i++)
+	{
+		key += Q_UINT64_C(0x9e3779b97f4a7c15);
+		m_keys[i] = mix(key);
+	}
+}
+
+quint64 IndexPermutation::size() const
+{
+	return m_size;
+}
+
+quint64 IndexPermutation::map(quint64 index) const
+{
+	Q_ASSERT(index < m_size);
+
+	do
+		index = encrypt(index);
+	while (index >= m_size);
+
+	return index;
+}
+
+quint64 IndexPermutation::encrypt(quint64 value) const
+{
+	quint64 left = (value >> m_halfBits) & m_halfMask;
+	quint64 right = value & m_halfMask;
+
+	for (int i = 0; i < RoundCount; i++)
+	{
+		const quint64 next = left ^ (mix(right ^ m_keys[i]) & m_halfMask);
+		left = right;
+		right = next;
+	}
+
+	return (left << m_halfBits) | right;
+}
@@ -0,0 +1,62 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INDEXPERMUTATION_H
+#define INDEXPERMUTATION_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief A pseudorandom permutation of an index range.
+ *
+ * IndexPermutation maps each index in the range [0, size) to a unique
+ * index in the same range without storing the permutation. The mapping
+ * is a Feistel network keyed by a seed, and indices that fall outside
+ * the range are walked through the network again until they land in
+ * it. Because of this the permutation takes constant memory, any
+ * position of it can be looked up directly, and two objects with the
+ * same size and seed always produce the same order.
+ */
+class LIB_EXPORT IndexPermutation
+{
+	public:
+		/*! Creates an empty permutation. */
+		IndexPermutation();
+		/*! Creates a permutation of \a size indices keyed by \a seed. */
+		IndexPermutation(quint64 size, quint32 seed);
+
+		/*! Returns the number of indices in the permutation. */
+		quint64 size() const;
+		/*!
+		 * Returns the index at position \a index of the permutation.
+		 *
+		 * \a index must be less than size().
+		 */
+		quint64 map(quint64 index) const;
+
+	private:
+		static const int RoundCount = 4;
+
+		quint64 encrypt(quint64 value) const;
+
+		quint64 m_size;
+		int m_halfBits;
+		quint64 m_halfMask;
+		quint64 m_keys[RoundCount];
+};
+
+#endif // INDEXPERMUTATION_H
@@ -0,0 +1,123 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "keyset.h"
+
+namespace {
+
+// The table is grown when it's more than 3/4 full
+bool isOverloaded(qint64 size, size_t capacity)
+{
+	return quint64(size) * 4 > quint64(capacity) * 3;
+}
+
+} // anonymous namespace
+
+KeySet::KeySet()
+	: m_size(0),
+	  m_hasZero(false)
+{
+}
+
+qint64 KeySet::size() const
+{
+	return m_size;
+}
+
+size_t KeySet::slot(quint64 key) const
+{
+	// Fold the high bits in, in case the low bits are less random
+	return size_t(key ^ (key >> 32)) & (m_table.size() - 1);
+}
+
+bool KeySet::contains(quint64 key) const
+{
+	if (key == 0)
+		return m_hasZero;
+	if (m_table.empty())
+		return false;
+
+	const size_t mask = m_table.size() - 1;
+	for (size_t i = slot(key); m_table[i] != 0; i = (i + 1) & mask)
+	{
+		if (m_table[i] == key)
+			return true;
+	}
+	return false;
+}
+
+bool KeySet::insert(quint64 key)
+{
+	if (key == 0)
+	{
+		if (m_hasZero)
+			return false;
+		m_hasZero = true;
+		m_size++;
+		return true;
+	}
+
+	if (m_table.empty() || isOverloaded(m_size + 1, m_table.size()))
+		rehash(qMax(size_t(1024), m_table.size() * 2));
+
+	const size_t mask = m_table.size() - 1;
+	size_t i = slot(key);
+	for (; m_table[i] != 0; i = (i + 1) & mask)
+	{
+		if (m_table[i] == key)
+			return false;
+	}
+
+	m_table[i] = key;
+	m_size++;
+	return true;
+}
+
+void KeySet::reserve(qint64 size)
+{
+	size_t capacity = qMax(size_t(1024), m_table.size());
+	while (isOverloaded(size, capacity))
+		capacity *= 2;
+	if (capacity > m_table.size())
+		rehash(capacity);
+}
+
+void KeySet::clear()
+{
+	std::vector<quint64>().swap(m_table);
+	m_size = 0;
+	m_hasZero = false;
+}
+
+void KeySet::rehash(size_t capacity)
+{
+	Q_ASSERT((capacity & (capacity - 1)) == 0);
+
+	std::vector<quint64> old(capacity, 0);
+	old.swap(m_table);
+
+	const size_t mask = capacity - 1;
+	for (quint64 key : old)
+	{
+		if (key == 0)
+			continue;
+		size_t i = slot(key);
+		while (m_table[i] != 0)
+			i = (i + 1) & mask;
+		m_table[i] = key;
+	}
+}
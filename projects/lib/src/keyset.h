@@ -0,0 +1,69 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KEYSET_H
+#define KEYSET_H
+
+#include <QtGlobal>
+#include <vector>
+
+/*!
+ * \brief A compact set of 64-bit position keys.
+ *
+ * KeySet stores Zobrist keys in a single open-addressing table with
+ * linear probing, so each key takes only a little more than 8 bytes.
+ * This makes it suitable for deduplicating hundreds of millions of
+ * positions, where a QSet would need several times more memory.
+ *
+ * The keys are expected to be well distributed, so they are used for
+ * indexing the table almost as is.
+ *
+ * \note KeySet is not thread-safe.
+ */
+class LIB_EXPORT KeySet
+{
+	public:
+		/*! Creates a new empty set. */
+		KeySet();
+
+		/*! Returns the number of keys in the set. */
+		qint64 size() const;
+		/*! Returns true if the set contains \a key. */
+		bool contains(quint64 key) const;
+		/*!
+		 * Inserts \a key into the set.
+		 *
+		 * Returns true if the key was added; returns false if it
+		 * was already in the set.
+		 */
+		bool insert(quint64 key);
+		/*! Makes room for at least \a size keys. */
+		void reserve(qint64 size);
+		/*! Removes all keys and frees the memory. */
+		void clear();
+
+	private:
+		size_t slot(quint64 key) const;
+		void rehash(size_t capacity);
+
+		// A zero key marks an empty slot, so it's stored separately
+		std::vector<quint64> m_table;
+		qint64 m_size;
+		bool m_hasZero;
+};
+
+#endif // KEYSET_H
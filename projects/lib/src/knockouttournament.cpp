@@ -114,6 +114,13 @@ void KnockoutTournament::initializePairing()
 
 	m_rounds.clear();
 	m_rounds << pairs;
+	for (int size = pairs.size() / 2; size >= 1; size /= 2)
+		m_rounds << QList<TournamentPair*>();
+	for (int i = 1; i < m_rounds.size(); i++)
+	{
+		for (int j = 0; j < m_rounds.at(i - 1).size() / 2; j++)
+			m_rounds[i] << nullptr;
+	}
 }
 
 int KnockoutTournament::gamesPerCycle() const
@@ -132,41 +139,42 @@ int KnockoutTournament::gamesPerCycle() const
 
 void KnockoutTournament::addScore(int player, int score)
 {
-	for (TournamentPair* pair : m_rounds.last())
+	// A player's games are always in their latest encounter because
+	// the next one isn't created before the previous one is over.
+	for (int round = m_rounds.size() - 1; round >= 0; round--)
 	{
-		if (pair->firstPlayer() == player)
-		{
-			pair->addFirstScore(score);
-			break;
-		}
-		if (pair->secondPlayer() == player)
+		for (TournamentPair* pair : m_rounds.at(round))
 		{
-			pair->addSecondScore(score);
-			break;
+			if (pair == nullptr)
+				continue;
+			if (pair->firstPlayer() == player)
+			{
+				pair->addFirstScore(score);
+				Tournament::addScore(player, score);
+				return;
+			}
+			if (pair->secondPlayer() == player)
+			{
+				pair->addSecondScore(score);
+				Tournament::addScore(player, score);
+				return;
+			}
 		}
 	}
 
 	Tournament::addScore(player, score);
 }
 
-QList<int> KnockoutTournament::lastRoundWinners() const
+bool KnockoutTournament::areAllGamesFinished() const
 {
-	QList<int> winners;
-	const auto last = m_rounds.last();
-	for (const TournamentPair* pair : last)
-		winners << pair->leader();
-
-	return winners;
+	return isDecided(m_rounds.last().first());
 }
 
-bool KnockoutTournament::areAllGamesFinished() const
+bool KnockoutTournament::isDecided(const TournamentPair* pair) const
 {
-	const QList<TournamentPair*>& lastRound(m_rounds.last());
-	if (lastRound.size() > 1)
-		return false;
-
-	const TournamentPair* pair(lastRound.first());
-	return !pair->gamesInProgress() && !needMoreGames(pair);
+	return pair != nullptr
+	    && !pair->gamesInProgress()
+	    && !needMoreGames(pair);
 }
 
 bool KnockoutTournament::needMoreGames(const TournamentPair* pair) const
@@ -205,33 +213,36 @@ TournamentPair* KnockoutTournament::nextPair(int gameNumber)
 {
 	Q_UNUSED(gameNumber);
 
-	const auto last = m_rounds.last();
-	for (TournamentPair* pair : last)
-	{
-		if (needMoreGames(pair))
-			return pair;
-	}
-
-	QList<int> winners(lastRoundWinners());
-	if (winners.size() <= 1 || gamesInProgress())
-		return nullptr;
-
-	QList<TournamentPair*> nextRound;
-	for (int i = 0; i < winners.size(); i += 2)
+	// An encounter of the next round can start as soon as the two
+	// encounters leading to it are decided, so the game slots don't
+	// sit idle while the rest of the round is still being played.
+	// Earlier rounds go first to keep the bracket moving.
+	for (int round = 0; round < m_rounds.size(); round++)
 	{
-		nextRound << pair(winners.at(i), winners.at(i + 1));
-	}
-	m_rounds << nextRound;
-	setCurrentRound(currentRound() + 1);
+		QList<TournamentPair*>& pairs = m_rounds[round];
+		for (int i = 0; i < pairs.size(); i++)
+		{
+			TournamentPair* pair = pairs.at(i);
+			if (pair == nullptr)
+			{
+				const QList<TournamentPair*>& prev(m_rounds.at(round - 1));
+				const TournamentPair* pair1 = prev.at(i * 2);
+				const TournamentPair* pair2 = prev.at(i * 2 + 1);
+				if (!isDecided(pair1) || !isDecided(pair2))
+					continue;
+
+				pair = this->pair(pair1->leader(), pair2->leader());
+				pairs[i] = pair;
+			}
 
-	// TODO: use qAsConst() from Qt 5.7
-	foreach (TournamentPair* pair, nextRound)
-	{
-		if (pair->isValid())
-			return pair;
+			if (needMoreGames(pair))
+			{
+				setCurrentRound(round + 1);
+				return pair;
+			}
+		}
 	}
 
-	Q_UNREACHABLE();
 	return nullptr;
 }
 
@@ -256,12 +267,18 @@ QString KnockoutTournament::results() const
 	}
 	lines.removeLast();
 
-	for (int round = 0; round < currentRound(); round++)
+	for (int round = 0; round < m_rounds.size(); round++)
 	{
 		int x = 0;
 		const auto nthRound = m_rounds.at(round);
 		for (const TournamentPair* pair : nthRound)
 		{
+			if (pair == nullptr)
+			{
+				x++;
+				continue;
+			}
+
 			QString winner;
 			if (needMoreGames(pair) || pair->gamesInProgress())
 				winner = "...";
@@ -56,9 +56,11 @@ class LIB_EXPORT KnockoutTournament : public Tournament
 		static int playerSeed(int rank, int bracketSize);
 
 		QList<int> firstRoundPlayers() const;
-		QList<int> lastRoundWinners() const;
 		bool needMoreGames(const TournamentPair* pair) const;
+		bool isDecided(const TournamentPair* pair) const;
 
+		// All rounds of the bracket. The encounters of later rounds
+		// are null until both of their players are known.
 		QList< QList<TournamentPair*> > m_rounds;
 };
 
@@ -0,0 +1,159 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memorystats.h"
+#include <QAtomicInteger>
+#include <QCoreApplication>
+#include <QStringList>
+#include "processusage.h"
+
+namespace {
+
+QAtomicInteger<qint64> s_current[MemoryStats::SubsystemCount];
+QAtomicInteger<qint64> s_peak[MemoryStats::SubsystemCount];
+
+QString formatBytes(qint64 bytes)
+{
+	if (bytes < 1024)
+		return QString("%1 B").arg(bytes);
+	if (bytes < 1024 * 1024)
+		return QString("%1 kB").arg(bytes / 1024.0, 0, 'f', 1);
+	return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+} // anonymous namespace
+
+QString MemoryStats::name(Subsystem subsystem)
+{
+	switch (subsystem)
+	{
+	case Boards:
+		return "boards";
+	case Games:
+		return "games";
+	case PgnBuffer:
+		return "pgn_buffer";
+	case Books:
+		return "books";
+	case OpeningIndex:
+		return "opening_index";
+	case EcoTree:
+		return "eco_tree";
+	case DebugBuffers:
+		return "debug_buffers";
+	default:
+		return QString();
+	}
+}
+
+qint64 MemoryStats::current(Subsystem subsystem)
+{
+	Q_ASSERT(subsystem >= 0 && subsystem < SubsystemCount);
+	return s_current[subsystem].load();
+}
+
+qint64 MemoryStats::peak(Subsystem subsystem)
+{
+	Q_ASSERT(subsystem >= 0 && subsystem < SubsystemCount);
+	return s_peak[subsystem].load();
+}
+
+qint64 MemoryStats::total()
+{
+	qint64 bytes = 0;
+	for (int i = 0; i < SubsystemCount; i++)
+		bytes += s_current[i].load();
+	return bytes;
+}
+
+void MemoryStats::add(Subsystem subsystem, qint64 bytes)
+{
+	Q_ASSERT(subsystem >= 0 && subsystem < SubsystemCount);
+	if (bytes == 0)
+		return;
+
+	const qint64 value = s_current[subsystem].fetchAndAddRelaxed(bytes) + bytes;
+	Q_ASSERT(value >= 0);
+
+	qint64 peak = s_peak[subsystem].load();
+	while (value > peak
+	&&     !s_peak[subsystem].testAndSetRelaxed(peak, value, peak))
+		;
+}
+
+qint64 MemoryStats::processPeakMemory()
+{
+	return ProcessUsage::sample(QCoreApplication::applicationPid())
+		.peakMemory();
+}
+
+QString MemoryStats::report()
+{
+	QStringList items;
+	const qint64 rss = processPeakMemory();
+	if (rss >= 0)
+		items << QString("peak RSS %1").arg(formatBytes(rss * 1024));
+
+	for (int i = 0; i < SubsystemCount; i++)
+	{
+		const Subsystem subsystem = Subsystem(i);
+		if (peak(subsystem) == 0)
+			continue;
+		items << QString("%1 %2 (peak %3)")
+			 .arg(name(subsystem))
+			 .arg(formatBytes(current(subsystem)))
+			 .arg(formatBytes(peak(subsystem)));
+	}
+
+	return items.join(", ");
+}
+
+MemoryAccount::MemoryAccount(MemoryStats::Subsystem subsystem)
+	: m_subsystem(subsystem),
+	  m_bytes(0)
+{
+}
+
+MemoryAccount::MemoryAccount(const MemoryAccount& other)
+	: m_subsystem(other.m_subsystem),
+	  m_bytes(0)
+{
+	setBytes(other.m_bytes);
+}
+
+MemoryAccount::~MemoryAccount()
+{
+	MemoryStats::add(m_subsystem, -m_bytes);
+}
+
+MemoryAccount& MemoryAccount::operator=(const MemoryAccount& other)
+{
+	setBytes(other.m_bytes);
+	return *this;
+}
+
+qint64 MemoryAccount::bytes() const
+{
+	return m_bytes;
+}
+
+void MemoryAccount::setBytes(qint64 bytes)
+{
+	Q_ASSERT(bytes >= 0);
+	MemoryStats::add(m_subsystem, bytes - m_bytes);
+	m_bytes = bytes;
+}
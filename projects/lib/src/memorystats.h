@@ -0,0 +1,113 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <QString>
+
+/*!
+ * \brief Accounts the memory held by the major owners of data.
+ *
+ * The owners of the largest data structures (boards, PGN games,
+ * opening books, the opening suite index, the ECO tree and the
+ * engine debug buffers) report an estimate of the memory they hold
+ * with a MemoryAccount. MemoryStats keeps the current total and the
+ * high-water mark of each subsystem, so that a growing process can
+ * be traced back to the owner of the memory.
+ *
+ * The estimates only count the containers' payload, not the
+ * allocator's overhead, so they are a lower bound of the real usage.
+ * The counters are atomic and can be updated from any thread.
+ */
+class LIB_EXPORT MemoryStats
+{
+	public:
+		/*! A subsystem whose memory is accounted. */
+		enum Subsystem
+		{
+			Boards,		//!< Chess boards and their move history
+			Games,		//!< Games and their PGN data
+			PgnBuffer,	//!< PGN games waiting to be written in order
+			Books,		//!< Opening books loaded to RAM
+			OpeningIndex,	//!< Opening suite file positions
+			EcoTree,	//!< ECO classification tree
+			DebugBuffers,	//!< Buffered engine debug output
+			SubsystemCount	//!< The number of subsystems
+		};
+
+		/*! Returns the name of \a subsystem, eg. "boards". */
+		static QString name(Subsystem subsystem);
+
+		/*! Returns the bytes currently held by \a subsystem. */
+		static qint64 current(Subsystem subsystem);
+		/*! Returns the most bytes \a subsystem has held at once. */
+		static qint64 peak(Subsystem subsystem);
+		/*! Returns the bytes currently held by every subsystem. */
+		static qint64 total();
+
+		/*! Adds \a bytes (which may be negative) to \a subsystem. */
+		static void add(Subsystem subsystem, qint64 bytes);
+
+		/*!
+		 * Returns the peak resident set size of this process in
+		 * kilobytes, or -1 if it's unknown.
+		 */
+		static qint64 processPeakMemory();
+
+		/*!
+		 * Returns a one-line report of the current and peak
+		 * usage of each subsystem that has held memory.
+		 */
+		static QString report();
+
+	private:
+		MemoryStats();
+};
+
+/*!
+ * \brief The memory an owner holds in a MemoryStats subsystem.
+ *
+ * An owner keeps a MemoryAccount as a member and calls setBytes()
+ * whenever its estimated size changes. The bytes are released when
+ * the account is destroyed. A copy of the account holds the same
+ * bytes, which suits owners that are copied with their data.
+ */
+class LIB_EXPORT MemoryAccount
+{
+	public:
+		/*! Creates an empty account in \a subsystem. */
+		explicit MemoryAccount(MemoryStats::Subsystem subsystem);
+		/*! Creates a copy of \a other, holding the same bytes. */
+		MemoryAccount(const MemoryAccount& other);
+		/*! Releases the bytes held by the account. */
+		~MemoryAccount();
+
+		/*! Makes this account hold as many bytes as \a other. */
+		MemoryAccount& operator=(const MemoryAccount& other);
+
+		/*! Returns the bytes held by the account. */
+		qint64 bytes() const;
+		/*! Sets the bytes held by the account to \a bytes. */
+		void setBytes(qint64 bytes);
+
+	private:
+		MemoryStats::Subsystem m_subsystem;
+		qint64 m_bytes;
+};
+
+#endif // MEMORYSTATS_H
@@ -17,50 +17,126 @@
 
 #include "mersenne.h"
 #include <QMutex>
+#include <QAtomicInt>
+#include <QThreadStorage>
 
 namespace {
 
-int s_index = 0;
-quint32 s_mt[624];
+struct State
+{
+	int generation;
+	int index;
+	quint32 mt[624];
+};
+
+QMutex s_mutex;
+quint32 s_seed = 0;
+int s_nextStream = 0;
+QAtomicInt s_generation(1);
+QThreadStorage<State*> s_state;
+
+void seedState(State* state, quint32 seed)
+{
+	quint32* mt = state->mt;
+	mt[0] = seed;
 
-void generateNumbers()
+	for (int i = 1; i < 624; i++)
+		mt[i] = (0x6C078965 * (mt[i - 1] ^ (mt[i - 1] >> 30)) + i) & 0xFFFFFFFF;
+	state->index = 0;
+}
+
+void generateNumbers(quint32* mt)
 {
 	for (int i = 0; i < 624; i++)
 	{
-		quint32 y = (s_mt[i] & 0x1) + (s_mt[(i + 1) % 624] & 0x7FFFFFFF);
-		s_mt[i] = s_mt[(i + 397) % 624] ^ (y >> 1);
+		quint32 y = (mt[i] & 0x1) + (mt[(i + 1) % 624] & 0x7FFFFFFF);
+		mt[i] = mt[(i + 397) % 624] ^ (y >> 1);
 
 		if (y % 2)
-			s_mt[i] ^= 0x9908B0DF;
+			mt[i] ^= 0x9908B0DF;
 	}
 }
 
+State* threadState()
+{
+	State* state = s_state.localData();
+	if (state == nullptr)
+	{
+		state = new State;
+		state->generation = 0;
+		s_state.setLocalData(state);
+	}
+
+	return state;
+}
+
+State* localState()
+{
+	State* state = threadState();
+
+	// Seed this thread's stream on its first use after initialize()
+	if (state->generation != s_generation.loadAcquire())
+	{
+		QMutexLocker locker(&s_mutex);
+		state->generation = s_generation.load();
+		seedState(state, Mersenne::streamSeed(s_seed, s_nextStream++));
+	}
+
+	return state;
+}
+
 } // anonymous namespace
 
 void Mersenne::initialize(quint32 seed)
 {
-	s_mt[0] = seed;
+	State* state = threadState();
+
+	// The calling thread gets the first stream, which is the
+	// sequence of a single generator seeded with the seed
+	QMutexLocker locker(&s_mutex);
+	s_seed = seed;
+	s_generation.ref();
+	state->generation = s_generation.load();
+	seedState(state, seed);
+	s_nextStream = 1;
+}
+
+void Mersenne::seedThread(quint32 seed)
+{
+	State* state = threadState();
+	state->generation = s_generation.loadAcquire();
+	seedState(state, seed);
+}
 
-	for (int i = 1; i < 624; i++)
-		s_mt[i] = (0x6C078965 * (s_mt[i - 1] ^ (s_mt[i - 1] >> 30)) + i) & 0xFFFFFFFF;
+quint32 Mersenne::streamSeed(quint32 seed, int stream)
+{
+	if (stream == 0)
+		return seed;
+
+	// A splitmix-style finalizer spreads consecutive streams
+	// over unrelated seeds
+	quint32 x = seed + 0x9E3779B9U * quint32(stream);
+	x ^= x >> 16;
+	x *= 0x85EBCA6BU;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35U;
+	x ^= x >> 16;
+	return x;
 }
 
 quint32 Mersenne::random()
 {
-	static QMutex mutex;
-	mutex.lock();
-
-	if (s_index == 0)
-		generateNumbers();
+	State* state = localState();
+	if (state->index == 0)
+		generateNumbers(state->mt);
 
-	quint32 y = s_mt[s_index];
+	quint32 y = state->mt[state->index];
 	y ^= y >> 11;
 	y ^= (y << 7) & 0x9D2C5680;
 	y ^= (y << 15) & 0xEFC60000;
 	y ^= y >> 18;
 
-	s_index = (s_index + 1) % 624;
-	mutex.unlock();
+	state->index = (state->index + 1) % 624;
 
 	return y;
 }
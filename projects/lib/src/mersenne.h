@@ -24,21 +24,48 @@
  * \brief A "Mersenne Twister" pseudorandom number generator
  *
  * The Mersenne PRNG produces pseudorandom numbers between
- * 0 and 0xFFFFFFFF - 1 at uniform distribution. Unlike Qt's
- * own random numbers, the sequences generated by this class
- * are not deterministic per thread.
+ * 0 and 0xFFFFFFFF - 1 at uniform distribution.
+ *
+ * Every thread has a generator of its own, so random() never
+ * takes a lock. The generators are derived from the seed given to
+ * initialize(): the thread that calls initialize() gets the plain
+ * sequence of that seed, and every other thread gets its own stream,
+ * seeded from the seed and the order in which the threads first
+ * ask for a number.
  */
 class LIB_EXPORT Mersenne
 {
 	public:
-		/*! Initializes the PRNG with \a seed. */
+		/*!
+		 * Initializes the PRNG with \a seed.
+		 *
+		 * Every thread's generator is reseeded: the calling
+		 * thread's immediately, the others' on their next call
+		 * to random().
+		 */
 		static void initialize(quint32 seed);
 		/*!
 		 * Returns a pseudorandom number between 0 and 0xFFFFFFFF -1.
 		 *
-		 * This function is thread-safe.
+		 * This function is thread-safe and lock-free, except for
+		 * the first call in a thread after initialize().
 		 */
 		static quint32 random();
+		/*!
+		 * Reseeds the calling thread's generator with \a seed.
+		 *
+		 * The generators of the other threads are not affected,
+		 * so eg. each game can get a stream of its own.
+		 */
+		static void seedThread(quint32 seed);
+		/*!
+		 * Returns the seed of stream number \a stream derived
+		 * from \a seed. Stream 0 is \a seed itself.
+		 *
+		 * These are the seeds the threads' streams get after
+		 * initialize().
+		 */
+		static quint32 streamSeed(quint32 seed, int stream);
 
 	private:
 		Mersenne();
@@ -0,0 +1,161 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "movetimestats.h"
+
+namespace {
+
+// Upper limits of the histogram buckets; the last bucket has none
+const int s_timeLimits[MoveTimeStats::BucketCount] =
+	{ 1, 2, 5, 10, 20, 35, 50, 0 };
+const int s_overheadLimits[MoveTimeStats::BucketCount] =
+	{ 1, 2, 5, 10, 25, 50, 100, 0 };
+
+int bucketIndex(const int* limits, double value)
+{
+	for (int i = 0; i < MoveTimeStats::BucketCount - 1; i++)
+	{
+		if (value < limits[i])
+			return i;
+	}
+	return MoveTimeStats::BucketCount - 1;
+}
+
+} // anonymous namespace
+
+MoveTimeStats::MoveTimeStats()
+	: m_moveCount(0),
+	  m_timeFractionSum(0.0),
+	  m_nearForfeits(0),
+	  m_minTimeLeft(-1),
+	  m_overheadCount(0),
+	  m_overheadSum(0),
+	  m_maxOverhead(0)
+{
+	for (int i = 0; i < BucketCount; i++)
+	{
+		m_timeBuckets[i] = 0;
+		m_overheadBuckets[i] = 0;
+	}
+}
+
+int MoveTimeStats::timeBucketLimit(int bucket)
+{
+	Q_ASSERT(bucket >= 0 && bucket < BucketCount);
+	return s_timeLimits[bucket];
+}
+
+int MoveTimeStats::overheadBucketLimit(int bucket)
+{
+	Q_ASSERT(bucket >= 0 && bucket < BucketCount);
+	return s_overheadLimits[bucket];
+}
+
+void MoveTimeStats::addMove(int clockTime, int moveTime, int reportedTime)
+{
+	if (clockTime <= 0)
+		return;
+
+	moveTime = qMax(moveTime, 0);
+	const double fraction = double(moveTime) / clockTime;
+	m_moveCount++;
+	m_timeBuckets[bucketIndex(s_timeLimits, fraction * 100.0)]++;
+	m_timeFractionSum += fraction;
+
+	const int timeLeft = qMax(clockTime - moveTime, 0);
+	if (timeLeft < NearForfeitTime)
+		m_nearForfeits++;
+	if (m_minTimeLeft == -1 || timeLeft < m_minTimeLeft)
+		m_minTimeLeft = timeLeft;
+
+	if (reportedTime > 0)
+	{
+		// An engine that reports a little more than the measured
+		// time has no overhead worth counting
+		const int overhead = qMax(moveTime - reportedTime, 0);
+		m_overheadCount++;
+		m_overheadBuckets[bucketIndex(s_overheadLimits, overhead)]++;
+		m_overheadSum += overhead;
+		m_maxOverhead = qMax(m_maxOverhead, overhead);
+	}
+}
+
+void MoveTimeStats::add(const MoveTimeStats& other)
+{
+	m_moveCount += other.m_moveCount;
+	m_timeFractionSum += other.m_timeFractionSum;
+	m_nearForfeits += other.m_nearForfeits;
+	if (other.m_minTimeLeft != -1
+	&&  (m_minTimeLeft == -1 || other.m_minTimeLeft < m_minTimeLeft))
+		m_minTimeLeft = other.m_minTimeLeft;
+	m_overheadCount += other.m_overheadCount;
+	m_overheadSum += other.m_overheadSum;
+	m_maxOverhead = qMax(m_maxOverhead, other.m_maxOverhead);
+
+	for (int i = 0; i < BucketCount; i++)
+	{
+		m_timeBuckets[i] += other.m_timeBuckets[i];
+		m_overheadBuckets[i] += other.m_overheadBuckets[i];
+	}
+}
+
+int MoveTimeStats::moveCount() const
+{
+	return m_moveCount;
+}
+
+int MoveTimeStats::timeBucket(int bucket) const
+{
+	Q_ASSERT(bucket >= 0 && bucket < BucketCount);
+	return m_timeBuckets[bucket];
+}
+
+double MoveTimeStats::timeFractionSum() const
+{
+	return m_timeFractionSum;
+}
+
+int MoveTimeStats::nearForfeits() const
+{
+	return m_nearForfeits;
+}
+
+int MoveTimeStats::minTimeLeft() const
+{
+	return m_minTimeLeft;
+}
+
+int MoveTimeStats::overheadCount() const
+{
+	return m_overheadCount;
+}
+
+int MoveTimeStats::overheadBucket(int bucket) const
+{
+	Q_ASSERT(bucket >= 0 && bucket < BucketCount);
+	return m_overheadBuckets[bucket];
+}
+
+qint64 MoveTimeStats::overheadSum() const
+{
+	return m_overheadSum;
+}
+
+int MoveTimeStats::maxOverhead() const
+{
+	return m_maxOverhead;
+}
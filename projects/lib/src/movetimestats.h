@@ -0,0 +1,112 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOVETIMESTATS_H
+#define MOVETIMESTATS_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief Time usage statistics of a player's moves.
+ *
+ * MoveTimeStats counts the moves of a player in two histograms: one of
+ * the move time relative to the time that was left on the clock, and
+ * one of the overhead, the difference between the move time measured
+ * by the GUI and the search time the engine reported itself. A large
+ * overhead means that the engine's time management doesn't account for
+ * the time its moves spend in transit or the time it takes to stop.
+ *
+ * Moves that leave the player very little time are counted as near
+ * forfeits. The statistics of several games can be combined with add().
+ */
+class LIB_EXPORT MoveTimeStats
+{
+	public:
+		/*! The number of buckets in each histogram. */
+		static const int BucketCount = 8;
+		/*!
+		 * A move that leaves less than this many milliseconds on
+		 * the clock is a near forfeit.
+		 */
+		static const int NearForfeitTime = 100;
+
+		/*! Creates empty statistics. */
+		MoveTimeStats();
+
+		/*!
+		 * Returns the upper limit of \a bucket in the move time
+		 * histogram as a percentage of the clock, or 0 for the last
+		 * bucket, which has no limit.
+		 */
+		static int timeBucketLimit(int bucket);
+		/*!
+		 * Returns the upper limit of \a bucket in the overhead
+		 * histogram in milliseconds, or 0 for the last bucket.
+		 */
+		static int overheadBucketLimit(int bucket);
+
+		/*!
+		 * Adds a move that took \a moveTime milliseconds when the
+		 * player had \a clockTime milliseconds left.
+		 *
+		 * If \a reportedTime is positive it's the search time the
+		 * player reported for the move, and the move's overhead is
+		 * counted too.
+		 */
+		void addMove(int clockTime, int moveTime, int reportedTime);
+		/*! Adds the moves of \a other to these statistics. */
+		void add(const MoveTimeStats& other);
+
+		/*! Returns the number of moves. */
+		int moveCount() const;
+		/*! Returns the number of moves in \a bucket of the time histogram. */
+		int timeBucket(int bucket) const;
+		/*!
+		 * Returns the sum of the move times relative to the clock,
+		 * where 1.0 is the whole clock.
+		 */
+		double timeFractionSum() const;
+		/*! Returns the number of near forfeits. */
+		int nearForfeits() const;
+		/*!
+		 * Returns the least time in milliseconds that a move left
+		 * on the clock, or -1 if there are no moves.
+		 */
+		int minTimeLeft() const;
+
+		/*! Returns the number of moves with a known overhead. */
+		int overheadCount() const;
+		/*! Returns the number of moves in \a bucket of the overhead histogram. */
+		int overheadBucket(int bucket) const;
+		/*! Returns the total overhead in milliseconds. */
+		qint64 overheadSum() const;
+		/*! Returns the largest overhead in milliseconds. */
+		int maxOverhead() const;
+
+	private:
+		int m_moveCount;
+		int m_timeBuckets[BucketCount];
+		double m_timeFractionSum;
+		int m_nearForfeits;
+		int m_minTimeLeft;
+		int m_overheadCount;
+		int m_overheadBuckets[BucketCount];
+		qint64 m_overheadSum;
+		int m_maxOverhead;
+};
+
+#endif // MOVETIMESTATS_H
@@ -19,11 +19,66 @@
 #include <QString>
 #include <QFile>
 #include <QDataStream>
+#include <QCache>
+#include <QMutex>
 #include <QtDebug>
+#include <algorithm>
 #include "pgngame.h"
 #include "pgnstream.h"
 #include "mersenne.h"
 
+namespace {
+
+// The number of positions in the cache of disk mode books
+const int s_diskCacheSize = 4096;
+
+struct WeightedMoves
+{
+	QVector<Chess::GenericMove> moves;
+	QVector<quint32> weights;
+};
+
+typedef QPair<QString, quint64> DiskCacheKey;
+
+// Probed positions of all disk mode books of the process
+QCache<DiskCacheKey, WeightedMoves> s_diskCache(s_diskCacheSize);
+QMutex s_diskCacheMutex;
+
+/*
+ * Picks a move randomly from \a count moves whose weights are summed
+ * up to each move in \a weights, with the highest-weighted move
+ * having the highest probability of getting picked.
+ */
+Chess::GenericMove pickMove(const Chess::GenericMove* moves,
+			    const quint32* weights,
+			    int count)
+{
+	if (count <= 0 || weights[count - 1] == 0)
+		return Chess::GenericMove();
+
+	const quint32 pick = Mersenne::random() % weights[count - 1];
+	return moves[std::upper_bound(weights, weights + count, pick) - weights];
+}
+
+WeightedMoves weightedMoves(const QList<OpeningBook::Entry>& entries)
+{
+	WeightedMoves moves;
+	moves.moves.reserve(entries.size());
+	moves.weights.reserve(entries.size());
+
+	quint32 weight = 0;
+	for (const OpeningBook::Entry& entry : entries)
+	{
+		weight += entry.weight;
+		moves.moves.append(entry.move);
+		moves.weights.append(weight);
+	}
+
+	return moves;
+}
+
+} // anonymous namespace
+
 
 QDataStream& operator>>(QDataStream& in, OpeningBook* book)
 {
@@ -47,7 +102,10 @@ QDataStream& operator<<(QDataStream& out, const OpeningBook* book)
 }
 
 OpeningBook::OpeningBook(AccessMode mode)
-	: m_mode(mode)
+	: m_mode(mode),
+	  m_mappedData(nullptr),
+	  m_mappedCount(0),
+	  m_memory(MemoryStats::Books)
 {
 }
 
@@ -58,11 +116,15 @@ OpeningBook::~OpeningBook()
 bool OpeningBook::read(const QString& filename)
 {
 	m_filename = filename;
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly))
+	m_mappedFile.clear();
+	m_mappedData = nullptr;
+	m_mappedCount = 0;
+
+	QSharedPointer<QFile> file(new QFile(filename));
+	if (!file->open(QIODevice::ReadOnly))
 		return false;
 
-	if ((file.size() % entrySize()) != 0)
+	if ((file->size() % entrySize()) != 0)
 	{
 		qDebug("Invalid size for opening book %s",
 		       qPrintable(filename));
@@ -70,11 +132,41 @@ bool OpeningBook::read(const QString& filename)
 	}
 
 	if (m_mode == Disk)
+	{
+		// The file may have changed since it was last probed
+		QMutexLocker locker(&s_diskCacheMutex);
+		for (const DiskCacheKey& key : s_diskCache.keys())
+		{
+			if (key.first == filename)
+				s_diskCache.remove(key);
+		}
 		return true;
+	}
 
 	m_map.clear();
-	QDataStream in(&file);
+	clearMoveTable();
+	updateMemoryUsage();
+	if (m_mode == Mapped)
+	{
+		if (file->size() == 0)
+			return false;
+
+		const uchar* data = file->map(0, file->size());
+		if (data != nullptr)
+		{
+			m_mappedFile = file;
+			m_mappedData = data;
+			m_mappedCount = file->size() / entrySize();
+			return true;
+		}
+		qWarning("Could not map opening book %s, loading it to RAM",
+			 qPrintable(filename));
+	}
+
+	QDataStream in(file.data());
 	in >> this;
+	buildMoveTable();
+	updateMemoryUsage();
 
 	return !m_map.isEmpty();
 }
@@ -93,6 +185,8 @@ bool OpeningBook::write(const QString& filename) const
 
 void OpeningBook::addEntry(const Entry& entry, quint64 key)
 {
+	clearMoveTable();
+
 	Map::iterator it = m_map.find(key);
 	while (it != m_map.end() && it.key() == key)
 	{
@@ -108,6 +202,47 @@ void OpeningBook::addEntry(const Entry& entry, quint64 key)
 	m_map.insert(key, entry);
 }
 
+void OpeningBook::updateMemoryUsage()
+{
+	// Every entry is a node of the map's red-black tree
+	m_memory.setBytes(m_map.size() * (sizeof(quint64) + sizeof(Entry)
+					  + 3 * sizeof(void*))
+			  + m_table.keys.size() * (sizeof(quint64) + sizeof(int))
+			  + m_table.moves.size() * (sizeof(Chess::GenericMove)
+						    + sizeof(quint32)));
+}
+
+void OpeningBook::buildMoveTable()
+{
+	clearMoveTable();
+	m_table.moves.reserve(m_map.size());
+	m_table.weights.reserve(m_map.size());
+
+	// The runs keep the order of Map::values()
+	quint32 weight = 0;
+	for (auto it = m_map.constBegin(); it != m_map.constEnd(); ++it)
+	{
+		if (m_table.keys.isEmpty() || m_table.keys.last() != it.key())
+		{
+			m_table.keys.append(it.key());
+			m_table.runs.append(m_table.moves.size());
+			weight = 0;
+		}
+		weight += it.value().weight;
+		m_table.moves.append(it.value().move);
+		m_table.weights.append(weight);
+	}
+	m_table.runs.append(m_table.moves.size());
+}
+
+void OpeningBook::clearMoveTable()
+{
+	if (m_table.runs.isEmpty())
+		return;
+
+	m_table = MoveTable();
+}
+
 int OpeningBook::import(const PgnGame& pgn, int maxMoves)
 {
 	Q_ASSERT(maxMoves > 0);
@@ -131,10 +266,11 @@ int OpeningBook::import(const PgnGame& pgn, int maxMoves)
 		// Skip the loser's moves
 		if ((i % 2) != loserMod)
 		{
-			Entry entry = { moves.at(i).move, weight };
+			Entry entry = { moves.at(i).move, weight, 0 };
 			addEntry(entry, moves.at(i).key);
 		}
 	}
+	updateMemoryUsage();
 
 	return ret;
 }
@@ -156,6 +292,8 @@ int OpeningBook::import(PgnStream& in, int maxMoves)
 
 		moveCount += import(game, maxMoves);
 	}
+	buildMoveTable();
+	updateMemoryUsage();
 
 	return moveCount;
 }
@@ -216,40 +354,146 @@ QList<OpeningBook::Entry> OpeningBook::entriesFromDisk(quint64 key) const
 	return entries;
 }
 
+OpeningBook::Entry OpeningBook::entryFromData(const uchar* data,
+					      quint64* key) const
+{
+	const QByteArray bytes(QByteArray::fromRawData(
+		reinterpret_cast<const char*>(data), entrySize()));
+	QDataStream in(bytes);
+	return readEntry(in, key);
+}
+
+qint64 OpeningBook::mappedLowerBound(quint64 key) const
+{
+	const qint64 step = entrySize();
+	quint64 entryKey = 0;
+
+	// Binary search for the first entry with a matching key
+	qint64 first = 0;
+	qint64 count = m_mappedCount;
+	while (count > 0)
+	{
+		const qint64 half = count / 2;
+		entryFromData(m_mappedData + (first + half) * step, &entryKey);
+		if (entryKey < key)
+		{
+			first += half + 1;
+			count -= half + 1;
+		}
+		else
+			count = half;
+	}
+
+	return first;
+}
+
+QList<OpeningBook::Entry> OpeningBook::entriesFromMapping(quint64 key) const
+{
+	QList<Entry> entries;
+	const qint64 step = entrySize();
+	quint64 entryKey = 0;
+
+	for (qint64 i = mappedLowerBound(key); i < m_mappedCount; i++)
+	{
+		const Entry entry = entryFromData(m_mappedData + i * step,
+						  &entryKey);
+		if (entryKey != key)
+			break;
+		entries << entry;
+	}
+
+	return entries;
+}
+
 QList<OpeningBook::Entry> OpeningBook::entries(quint64 key) const
 {
-	if (m_mode == Ram)
-		return m_map.values(key);
-	return entriesFromDisk(key);
+	if (m_mappedData != nullptr)
+		return entriesFromMapping(key);
+	if (m_mode == Disk)
+		return entriesFromDisk(key);
+	return m_map.values(key);
 }
 
-Chess::GenericMove OpeningBook::move(quint64 key) const
+Chess::GenericMove OpeningBook::moveFromMapping(quint64 key) const
 {
-	Chess::GenericMove move;
-	
-	// There can be multiple entries/moves with the same key.
-	// We need to find them all to choose the best one
-	const auto entries = this->entries(key);
-	if (entries.isEmpty())
-		return move;
-	
-	// Calculate the total weight of all available moves
-	int totalWeight = 0;
-	for (const Entry& entry : entries)
+	const qint64 step = entrySize();
+	const qint64 first = mappedLowerBound(key);
+	quint64 entryKey = 0;
+
+	// The run of entries is read twice instead of being copied
+	quint32 totalWeight = 0;
+	qint64 end = first;
+	for (; end < m_mappedCount; end++)
+	{
+		const Entry entry = entryFromData(m_mappedData + end * step,
+						  &entryKey);
+		if (entryKey != key)
+			break;
 		totalWeight += entry.weight;
-	if (totalWeight <= 0)
-		return move;
+	}
+	if (totalWeight == 0)
+		return Chess::GenericMove();
 
-	// Pick a move randomly, with the highest-weighted move having
-	// the highest probability of getting picked.
-	int pick = Mersenne::random() % totalWeight;
-	int currentWeight = 0;
-	for (const Entry& entry : entries)
+	const quint32 pick = Mersenne::random() % totalWeight;
+	quint32 currentWeight = 0;
+	for (qint64 i = first; i < end; i++)
 	{
+		const Entry entry = entryFromData(m_mappedData + i * step,
+						  &entryKey);
 		currentWeight += entry.weight;
 		if (currentWeight > pick)
 			return entry.move;
 	}
-	
+
+	return Chess::GenericMove();
+}
+
+Chess::GenericMove OpeningBook::moveFromDisk(quint64 key) const
+{
+	const DiskCacheKey cacheKey(m_filename, key);
+	{
+		QMutexLocker locker(&s_diskCacheMutex);
+		const WeightedMoves* cached = s_diskCache.object(cacheKey);
+		if (cached != nullptr)
+			return pickMove(cached->moves.constData(),
+					cached->weights.constData(),
+					cached->moves.size());
+	}
+
+	WeightedMoves* moves = new WeightedMoves(weightedMoves(entriesFromDisk(key)));
+	const Chess::GenericMove move = pickMove(moves->moves.constData(),
+						 moves->weights.constData(),
+						 moves->moves.size());
+
+	QMutexLocker locker(&s_diskCacheMutex);
+	s_diskCache.insert(cacheKey, moves);
 	return move;
 }
+
+Chess::GenericMove OpeningBook::move(quint64 key) const
+{
+	if (m_mappedData != nullptr)
+		return moveFromMapping(key);
+	if (m_mode == Disk)
+		return moveFromDisk(key);
+
+	// A book that is still being imported has no move table
+	if (m_table.runs.isEmpty())
+	{
+		const WeightedMoves moves(weightedMoves(m_map.values(key)));
+		return pickMove(moves.moves.constData(),
+				moves.weights.constData(),
+				moves.moves.size());
+	}
+
+	const auto it = std::lower_bound(m_table.keys.constBegin(),
+					 m_table.keys.constEnd(), key);
+	if (it == m_table.keys.constEnd() || *it != key)
+		return Chess::GenericMove();
+
+	const int index = int(it - m_table.keys.constBegin());
+	const int first = m_table.runs.at(index);
+	return pickMove(m_table.moves.constData() + first,
+			m_table.weights.constData() + first,
+			m_table.runs.at(index + 1) - first);
+}
@@ -20,9 +20,13 @@
 
 #include <QtGlobal>
 #include <QMultiMap>
+#include <QSharedPointer>
+#include <QVector>
 #include "board/genericmove.h"
+#include "memorystats.h"
 
 class QString;
+class QFile;
 class QDataStream;
 class PgnGame;
 class PgnStream;
@@ -38,6 +42,10 @@ class PgnStream;
  * The opening book can be stored externally in a binary file. When it's needed,
  * it is loaded in memory, and positions can be found quickly by searching
  * the book for Zobrist keys that match the current board position.
+ *
+ * A book file whose entries are sorted by key can also be mapped into
+ * memory and searched in place, which needs no extra memory and no
+ * loading time. Copies of the book share the same mapping.
  */
 class LIB_EXPORT OpeningBook
 {
@@ -46,7 +54,8 @@ class LIB_EXPORT OpeningBook
 		enum AccessMode
 		{
 			Ram,	//!< Load the entire book to RAM
-			Disk	//!< Read moves directly from disk
+			Disk,	//!< Read moves directly from disk
+			Mapped	//!< Map the book file into memory
 		};
 
 		/*!
@@ -66,6 +75,12 @@ class LIB_EXPORT OpeningBook
 			 * likely the move will be played.
 			 */
 			quint16 weight;
+			/*!
+			 * Learning data. The meaning of the value
+			 * depends on the book format and the program that
+			 * created the book; 0 means no data.
+			 */
+			quint32 learn;
 		};
 
 		/*! Creates a new OpeningBook with access mode \a mode. */
@@ -112,6 +127,11 @@ class LIB_EXPORT OpeningBook
 
 		/*!
 		 * Reads a book from \a filename.
+		 *
+		 * In Mapped mode the file stays open and mapped until the
+		 * book and all its copies are destroyed. If the file can't
+		 * be mapped, it is loaded to RAM instead.
+		 *
 		 * Returns true if successful; otherwise returns false.
 		 */
 		bool read(const QString& filename);
@@ -135,6 +155,8 @@ class LIB_EXPORT OpeningBook
 
 		/*! Adds a new entry to the book. */
 		void addEntry(const Entry& entry, quint64 key);
+		/*! Accounts the memory used by the book's entries in RAM. */
+		void updateMemoryUsage();
 		
 		/*!
 		 * Reads a new book entry from \a in and returns it.
@@ -143,17 +165,52 @@ class LIB_EXPORT OpeningBook
 		 * belongs to the entry.
 		 */
 		virtual Entry readEntry(QDataStream& in, quint64* key) const = 0;
+		/*!
+		 * Decodes the book entry at \a data, which holds entrySize()
+		 * bytes of a book file, and returns it.
+		 *
+		 * The implementation must set \a key to the hash that
+		 * belongs to the entry. The default implementation calls
+		 * readEntry() on a stream; subclasses can reimplement this
+		 * function to decode the entry directly.
+		 */
+		virtual Entry entryFromData(const uchar* data, quint64* key) const;
 		
 		/*! Writes the key and entry pointed to by \a it, to \a out. */
 		virtual void writeEntry(const Map::const_iterator& it,
 					QDataStream& out) const = 0;
 
 	private:
+		/*
+		 * The book moves of each position in one contiguous run,
+		 * with weights summed up to each move so that a weighted
+		 * pick is a binary search over the run.
+		 */
+		struct MoveTable
+		{
+			QVector<quint64> keys;
+			// Start of the run of each key, and the end of the last run
+			QVector<int> runs;
+			QVector<Chess::GenericMove> moves;
+			QVector<quint32> weights;
+		};
+
 		QList<Entry> entriesFromDisk(quint64 key) const;
+		QList<Entry> entriesFromMapping(quint64 key) const;
+		qint64 mappedLowerBound(quint64 key) const;
+		Chess::GenericMove moveFromMapping(quint64 key) const;
+		Chess::GenericMove moveFromDisk(quint64 key) const;
+		void buildMoveTable();
+		void clearMoveTable();
 
 		AccessMode m_mode;
 		QString m_filename;
 		Map m_map;
+		MoveTable m_table;
+		QSharedPointer<QFile> m_mappedFile;
+		const uchar* m_mappedData;
+		qint64 m_mappedCount;
+		MemoryAccount m_memory;
 };
 
 /*!
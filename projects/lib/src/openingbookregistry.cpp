@@ -0,0 +1,87 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "openingbookregistry.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWeakPointer>
+#include "polyglotbook.h"
+
+namespace {
+
+QMutex s_mutex;
+QHash<QString, QWeakPointer<const OpeningBook> > s_books;
+
+QString bookKey(const QString& fileName, OpeningBook::AccessMode mode)
+{
+	QString path(QFileInfo(fileName).canonicalFilePath());
+	if (path.isEmpty())
+		path = fileName;
+
+	return QString::number(mode) + ':' + path;
+}
+
+} // anonymous namespace
+
+QSharedPointer<const OpeningBook> OpeningBookRegistry::polyglotBook(
+	const QString& fileName,
+	OpeningBook::AccessMode mode)
+{
+	const QString key(bookKey(fileName, mode));
+
+	// The book is loaded while the mutex is locked so that concurrent
+	// requests for the same file don't load it more than once
+	QMutexLocker locker(&s_mutex);
+	QSharedPointer<const OpeningBook> book(s_books.value(key).toStrongRef());
+	if (!book.isNull())
+		return book;
+
+	PolyglotBook* newBook = new PolyglotBook(mode);
+	if (!newBook->read(fileName))
+	{
+		delete newBook;
+		s_books.remove(key);
+		return QSharedPointer<const OpeningBook>();
+	}
+
+	book = QSharedPointer<const OpeningBook>(newBook);
+	s_books[key] = book;
+
+	return book;
+}
+
+int OpeningBookRegistry::bookCount()
+{
+	QMutexLocker locker(&s_mutex);
+
+	int count = 0;
+	auto it = s_books.begin();
+	while (it != s_books.end())
+	{
+		if (it.value().isNull())
+			it = s_books.erase(it);
+		else
+		{
+			++count;
+			++it;
+		}
+	}
+
+	return count;
+}
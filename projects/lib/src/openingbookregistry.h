@@ -0,0 +1,60 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENING_BOOK_REGISTRY_H
+#define OPENING_BOOK_REGISTRY_H
+
+#include <QSharedPointer>
+#include "openingbook.h"
+
+/*!
+ * \brief A process-wide registry of loaded opening books.
+ *
+ * OpeningBookRegistry makes sure that each book file is loaded only
+ * once, no matter how many games, players or tournaments use it. The
+ * books are keyed by their canonical file path and access mode, and
+ * handed out as shared pointers to const objects. A book is destroyed
+ * when the last pointer to it is released, and a later request loads
+ * it again.
+ *
+ * Looking up moves in a const OpeningBook is thread-safe, so the same
+ * instance can be used by any number of concurrent games.
+ *
+ * All functions of this class are thread-safe.
+ */
+class LIB_EXPORT OpeningBookRegistry
+{
+	public:
+		/*!
+		 * Returns the Polyglot book in \a fileName, accessed in
+		 * \a mode.
+		 *
+		 * If the book is already in use, the existing instance is
+		 * returned. Otherwise the book is read from disk. Returns
+		 * a null pointer if the book can't be read.
+		 */
+		static QSharedPointer<const OpeningBook> polyglotBook(
+			const QString& fileName,
+			OpeningBook::AccessMode mode = OpeningBook::Ram);
+		/*! Returns the number of books that are currently loaded. */
+		static int bookCount();
+
+	private:
+		OpeningBookRegistry();
+};
+
+#endif // OPENING_BOOK_REGISTRY_H
@@ -0,0 +1,78 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "openingcache.h"
+#include <QMutexLocker>
+
+OpeningCache::OpeningCache(int capacity)
+	: m_entries(capacity),
+	  m_hitCount(0)
+{
+}
+
+int OpeningCache::capacity() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_entries.maxCost();
+}
+
+void OpeningCache::setCapacity(int capacity)
+{
+	QMutexLocker locker(&m_mutex);
+	m_entries.setMaxCost(capacity);
+}
+
+int OpeningCache::size() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_entries.size();
+}
+
+int OpeningCache::hitCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_hitCount;
+}
+
+bool OpeningCache::find(int index, Entry* entry)
+{
+	Q_ASSERT(entry != nullptr);
+
+	// The members of the entry are implicitly shared, so copying
+	// it under the lock is cheap
+	QMutexLocker locker(&m_mutex);
+	const Entry* cached = m_entries.object(index);
+	if (cached == nullptr)
+		return false;
+
+	*entry = *cached;
+	m_hitCount++;
+	return true;
+}
+
+void OpeningCache::insert(int index, const Entry& entry)
+{
+	QMutexLocker locker(&m_mutex);
+	m_entries.insert(index, new Entry(entry));
+}
+
+void OpeningCache::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	m_entries.clear();
+	m_hitCount = 0;
+}
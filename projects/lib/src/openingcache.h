@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENINGCACHE_H
+#define OPENINGCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include "board/move.h"
+#include "board/boardsnapshot.h"
+#include "pgngame.h"
+
+
+/*!
+ * \brief A cache of replayed openings shared by the games of a tournament
+ *
+ * The games that repeat an opening, eg. with the colors reversed,
+ * play the same moves from the same position. OpeningCache keeps the
+ * result of the first replay of each opening: its moves, their PGN
+ * data with the SAN strings and position keys, and a snapshot of the
+ * final position. A later game of the opening adds the cached PGN
+ * data instead of formatting every move again, and can jump straight
+ * to the final position when it needs it for opening book moves.
+ *
+ * The openings are identified by their index in the tournament. At
+ * most capacity() openings are kept; the least recently used ones
+ * are dropped first. The cache is thread-safe, so the games can use
+ * it from the threads they run in.
+ *
+ * \sa ChessGame::setOpeningCache()
+ */
+class LIB_EXPORT OpeningCache
+{
+	public:
+		/*! A replayed opening. */
+		struct Entry
+		{
+			/*!
+			 * The starting FEN string, or an empty string for
+			 * the default position of the variant.
+			 */
+			QString startingFen;
+			/*! The moves of the opening. */
+			QVector<Chess::Move> moves;
+			/*! The PGN data of the moves. */
+			QVector<PgnGame::MoveData> pgnMoves;
+			/*! The position after the moves. */
+			Chess::BoardSnapshot position;
+		};
+
+		/*! Creates a new cache that keeps up to \a capacity openings. */
+		explicit OpeningCache(int capacity = 256);
+
+		/*! Returns the maximum number of cached openings. */
+		int capacity() const;
+		/*! Sets the maximum number of cached openings to \a capacity. */
+		void setCapacity(int capacity);
+		/*! Returns the number of cached openings. */
+		int size() const;
+		/*! Returns the number of successful lookups. */
+		int hitCount() const;
+
+		/*!
+		 * Finds the opening at \a index and copies it to \a entry.
+		 * Returns true if the opening is in the cache; otherwise
+		 * returns false.
+		 */
+		bool find(int index, Entry* entry);
+		/*!
+		 * Stores \a entry as the opening at \a index, replacing any
+		 * earlier entry of the index.
+		 */
+		void insert(int index, const Entry& entry);
+		/*! Removes all openings from the cache. */
+		void clear();
+
+	private:
+		Q_DISABLE_COPY(OpeningCache)
+
+		mutable QMutex m_mutex;
+		QCache<int, Entry> m_entries;
+		int m_hitCount;
+};
+
+#endif // OPENINGCACHE_H
@@ -0,0 +1,155 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "openingprefetcher.h"
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include "board/board.h"
+#include "board/boardfactory.h"
+#include "openingsuite.h"
+
+namespace {
+
+// After this many invalid openings in a row the suite is assumed to be
+// incompatible with the variant, and the openings are passed on anyway
+const int s_maxInvalidOpenings = 100;
+
+} // anonymous namespace
+
+OpeningPrefetcher::OpeningPrefetcher(OpeningSuite* suite,
+				     const QString& variant,
+				     int maxPlies,
+				     QObject* parent)
+	: QThread(parent),
+	  m_suite(suite),
+	  m_variant(variant),
+	  m_maxPlies(maxPlies),
+	  m_queueSize(16),
+	  m_stopping(false)
+{
+	Q_ASSERT(suite != nullptr);
+}
+
+OpeningPrefetcher::~OpeningPrefetcher()
+{
+	stop();
+}
+
+int OpeningPrefetcher::queueSize() const
+{
+	return m_queueSize;
+}
+
+void OpeningPrefetcher::setQueueSize(int size)
+{
+	Q_ASSERT(!isRunning());
+	Q_ASSERT(size > 0);
+
+	m_queueSize = size;
+}
+
+PgnGame OpeningPrefetcher::takeOpening()
+{
+	QMutexLocker locker(&m_mutex);
+	if (!isRunning())
+	{
+		m_stopping = false;
+		start();
+	}
+
+	while (m_queue.isEmpty())
+		m_queueChanged.wait(&m_mutex);
+
+	PgnGame opening(m_queue.dequeue());
+	m_queueChanged.wakeAll();
+
+	return opening;
+}
+
+void OpeningPrefetcher::stop()
+{
+	m_mutex.lock();
+	m_stopping = true;
+	m_queueChanged.wakeAll();
+	m_mutex.unlock();
+
+	wait();
+
+	QMutexLocker locker(&m_mutex);
+	m_queue.clear();
+}
+
+bool OpeningPrefetcher::isValid(const PgnGame& opening,
+				Chess::Board* board) const
+{
+	QString fen(opening.startingFenString());
+	if (fen.isEmpty())
+		fen = board->defaultFenString();
+	if (!board->setFenString(fen))
+		return false;
+
+	for (const PgnGame::MoveData& md : opening.moves())
+	{
+		const Chess::Move move(board->moveFromGenericMove(md.move));
+		if (!board->isLegalMove(move))
+			return false;
+
+		board->makeMove(move);
+		if (!board->result().isNone())
+			break;
+	}
+
+	return true;
+}
+
+void OpeningPrefetcher::run()
+{
+	QScopedPointer<Chess::Board> board(
+		Chess::BoardFactory::create(m_variant));
+	Q_ASSERT(!board.isNull());
+	int invalidCount = 0;
+	int index = 0;
+
+	forever
+	{
+		m_mutex.lock();
+		while (m_queue.size() >= m_queueSize && !m_stopping)
+			m_queueChanged.wait(&m_mutex);
+		const bool stopping = m_stopping;
+		m_mutex.unlock();
+
+		if (stopping)
+			break;
+
+		// The suite is read without holding the lock
+		PgnGame opening(m_suite->nextGame(m_maxPlies));
+		index++;
+		if (isValid(opening, board.data()))
+			invalidCount = 0;
+		else if (++invalidCount < s_maxInvalidOpenings)
+		{
+			qWarning("Skipping opening %d of the opening suite: "
+				 "it's invalid in variant %s",
+				 index, qPrintable(m_variant));
+			continue;
+		}
+
+		m_mutex.lock();
+		m_queue.enqueue(opening);
+		m_queueChanged.wakeAll();
+		m_mutex.unlock();
+	}
+}
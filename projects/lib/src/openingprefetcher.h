@@ -0,0 +1,95 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OPENINGPREFETCHER_H
+#define OPENINGPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include "pgngame.h"
+class OpeningSuite;
+namespace Chess { class Board; }
+
+
+/*!
+ * \brief A thread for reading openings ahead of time
+ *
+ * OpeningPrefetcher reads openings from an OpeningSuite on a
+ * background thread and keeps up to queueSize() of them ready, so
+ * starting a game doesn't have to wait for the opening file. Each
+ * opening is validated by playing it on a board of the tournament's
+ * variant. Invalid openings are reported and skipped as soon as they
+ * are read.
+ *
+ * Once the thread is started it owns the opening suite: the suite
+ * must not be used by anyone else until the thread has finished.
+ *
+ * \sa Tournament
+ */
+class LIB_EXPORT OpeningPrefetcher : public QThread
+{
+	Q_OBJECT
+
+	public:
+		/*!
+		 * Creates a new prefetcher that reads openings of at most
+		 * \a maxPlies plies from \a suite, and validates them in
+		 * \a variant.
+		 */
+		OpeningPrefetcher(OpeningSuite* suite,
+				  const QString& variant,
+				  int maxPlies,
+				  QObject* parent = nullptr);
+		/*! Stops the thread and destroys the prefetcher. */
+		virtual ~OpeningPrefetcher();
+
+		/*! Returns the maximum number of openings kept ready. */
+		int queueSize() const;
+		/*!
+		 * Sets the maximum number of openings kept ready to \a size.
+		 * \note This function must be called before the thread is
+		 * started.
+		 */
+		void setQueueSize(int size);
+
+		/*!
+		 * Returns the next opening, waiting for it if necessary.
+		 * The thread is started if it isn't running.
+		 */
+		PgnGame takeOpening();
+		/*! Stops the thread and discards the queued openings. */
+		void stop();
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		bool isValid(const PgnGame& opening, Chess::Board* board) const;
+
+		OpeningSuite* m_suite;
+		QString m_variant;
+		int m_maxPlies;
+		int m_queueSize;
+		bool m_stopping;
+		QMutex m_mutex;
+		QWaitCondition m_queueChanged;
+		QQueue<PgnGame> m_queue;
+};
+
+#endif // OPENINGPREFETCHER_H
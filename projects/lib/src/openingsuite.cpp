@@ -16,22 +16,55 @@
 */
 
 #include "openingsuite.h"
+#include <climits>
+#include <cstring>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QTextStream>
+#include <QtEndian>
 #include "pgnstream.h"
+#include "pgnindexer.h"
+#include "gzipdevice.h"
 #include "epdrecord.h"
 #include "mersenne.h"
 
+namespace {
+
+/*
+ * The index file starts with a header, followed by a pair of
+ * little-endian (position, line number) integers for each opening.
+ */
+const char s_indexMagic[8] = { 'C', 'C', 'O', 'I', 'D', 'X', '0', '1' };
+
+struct IndexHeader
+{
+	char magic[8];
+	qint64 fileSize;
+	qint64 lastModified;
+	qint64 format;
+	qint64 count;
+};
+
+} // anonymous namespace
+
 OpeningSuite::OpeningSuite(const QString& fen)
 	: m_format(EpdFormat),
 	  m_order(SequentialOrder),
 	  m_gamesRead(0),
 	  m_gameIndex(0),
 	  m_startIndex(0),
+	  m_sliceIndex(0),
+	  m_sliceCount(1),
+	  m_openingCount(0),
 	  m_fen(fen),
 	  m_file(nullptr),
+	  m_device(nullptr),
 	  m_epdStream(nullptr),
-	  m_pgnStream(nullptr)
+	  m_pgnStream(nullptr),
+	  m_indexFile(nullptr),
+	  m_indexData(nullptr),
+	  m_memory(MemoryStats::OpeningIndex)
 {
 }
 
@@ -44,10 +77,17 @@ OpeningSuite::OpeningSuite(const QString& fileName,
 	  m_gamesRead(0),
 	  m_gameIndex(0),
 	  m_startIndex(startIndex),
+	  m_sliceIndex(0),
+	  m_sliceCount(1),
+	  m_openingCount(0),
 	  m_fileName(fileName),
 	  m_file(nullptr),
+	  m_device(nullptr),
 	  m_epdStream(nullptr),
-	  m_pgnStream(nullptr)
+	  m_pgnStream(nullptr),
+	  m_indexFile(nullptr),
+	  m_indexData(nullptr),
+	  m_memory(MemoryStats::OpeningIndex)
 {
 }
 
@@ -63,6 +103,7 @@ OpeningSuite::~OpeningSuite()
 		delete m_pgnStream->device();
 		delete m_pgnStream;
 	}
+	delete m_indexFile;
 }
 
 OpeningSuite::Format OpeningSuite::format() const
@@ -80,6 +121,25 @@ bool OpeningSuite::isNull() const
 	return m_epdStream == nullptr && m_pgnStream == nullptr;
 }
 
+QString OpeningSuite::indexFileName() const
+{
+	return m_indexFileName;
+}
+
+void OpeningSuite::setIndexFileName(const QString& fileName)
+{
+	m_indexFileName = fileName;
+}
+
+void OpeningSuite::setSlice(int index, int count)
+{
+	Q_ASSERT(count > 0);
+	Q_ASSERT(index >= 0 && index < count);
+
+	m_sliceIndex = index;
+	m_sliceCount = count;
+}
+
 bool OpeningSuite::initialize()
 {
 	if (!m_fen.isEmpty())
@@ -87,7 +147,13 @@ bool OpeningSuite::initialize()
 
 	m_gamesRead = 0;
 	m_gameIndex = 0;
+	m_openingCount = 0;
 	m_filePositions.clear();
+	m_memory.setBytes(0);
+	m_permutation = IndexPermutation();
+	m_indexData = nullptr;
+	delete m_indexFile;
+	m_indexFile = nullptr;
 
 	if (m_epdStream != nullptr)
 	{
@@ -111,32 +177,61 @@ bool OpeningSuite::initialize()
 		return false;
 	}
 
+	// A compressed PGN file is decompressed by PgnStream
+	m_device = m_file;
+	if (m_format == EpdFormat && GzipDevice::isGzip(m_file))
+	{
+		GzipDevice* gzip = new GzipDevice(m_file);
+		m_file->setParent(gzip);
+		if (!gzip->open(QIODevice::ReadOnly))
+		{
+			qWarning("Can't open opening suite %s",
+				 qPrintable(m_fileName));
+			delete gzip;
+			return false;
+		}
+		m_device = gzip;
+	}
+
 	if (m_format == PgnFormat)
-		m_pgnStream = new PgnStream(m_file);
+	{
+		m_pgnStream = new PgnStream();
+		if (!m_pgnStream->setMappedFile(m_file))
+			m_pgnStream->setDevice(m_file);
+	}
 
 	if (m_order == RandomOrder)
 	{
-		// Create a shuffled vector of file positions
-		forever
+		if (!mapIndex())
 		{
-			FilePosition pos;
+			QVector<FilePosition> positions;
 			if (m_format == EpdFormat)
-				pos = getEpdPos();
+			{
+				forever
+				{
+					FilePosition pos = getEpdPos();
+					if (pos.pos == -1)
+						break;
+					positions.append(pos);
+				}
+			}
 			else if (m_format == PgnFormat)
-				pos = getPgnPos();
+				positions = getPgnPositions();
 
-			if (pos.pos == -1)
-				break;
-
-			int i = Mersenne::random() % (m_filePositions.size() + 1);
-			if (i == m_filePositions.size())
-				m_filePositions.append(pos);
-			else
+			// Read the positions from the new index if possible
+			if (!writeIndex(positions) || !mapIndex())
 			{
-				m_filePositions.append(m_filePositions.at(i));
-				m_filePositions[i] = pos;
+				m_filePositions = positions;
+				m_openingCount = positions.size();
 			}
+			m_memory.setBytes(m_filePositions.capacity()
+					  * sizeof(FilePosition));
 		}
+
+		m_permutation = IndexPermutation(m_openingCount,
+						 Mersenne::random());
+		if (m_openingCount > 0)
+			m_gameIndex = m_sliceIndex % m_openingCount;
 	}
 	else if (m_order == SequentialOrder)
 	{
@@ -146,7 +241,7 @@ bool OpeningSuite::initialize()
 			if (m_format == EpdFormat)
 				pos = getEpdPos();
 			else if (m_format == PgnFormat)
-				pos = getPgnPos();
+				pos = getPgnPos(*m_pgnStream);
 
 			if (pos.pos == -1)
 				break;
@@ -155,8 +250,8 @@ bool OpeningSuite::initialize()
 
 	if (m_format == EpdFormat)
 	{
-		m_file->reset();
-		m_epdStream = new QTextStream(m_file);
+		m_device->reset();
+		m_epdStream = new QTextStream(m_device);
 	}
 
 	return true;
@@ -175,11 +270,12 @@ PgnGame OpeningSuite::nextGame(int maxPlies)
 		return game;
 
 	FilePosition pos = { -1, -1 };
-	if (m_order == RandomOrder)
+	if (m_order == RandomOrder && m_openingCount > 0)
 	{
-		pos = m_filePositions.at(m_gameIndex++);
-		if (m_gameIndex >= m_filePositions.size())
-			m_gameIndex = 0;
+		pos = filePosition(int(m_permutation.map(m_gameIndex)));
+		m_gameIndex += m_sliceCount;
+		if (m_gameIndex >= m_openingCount)
+			m_gameIndex = m_sliceIndex % m_openingCount;
 	}
 
 	bool ok = false;
@@ -227,20 +323,20 @@ PgnGame OpeningSuite::nextGame(int maxPlies)
 	return game;
 }
 
-OpeningSuite::FilePosition OpeningSuite::getPgnPos()
+OpeningSuite::FilePosition OpeningSuite::getPgnPos(PgnStream& stream)
 {
 	FilePosition pos = { -1, -1 };
-	if (!m_pgnStream->nextGame())
+	if (!stream.nextGame())
 		return pos;
 
-	pos.pos = m_pgnStream->pos();
-	pos.lineNumber = m_pgnStream->lineNumber();
+	pos.pos = stream.pos();
+	pos.lineNumber = stream.lineNumber();
 
 	char c;
 	bool inTag = false;
 	bool inQuotes = false;
 
-	while ((c = m_pgnStream->readChar()) != 0)
+	while ((c = stream.readChar()) != 0)
 	{
 		if (!inTag)
 		{
@@ -248,7 +344,7 @@ OpeningSuite::FilePosition OpeningSuite::getPgnPos()
 				inTag = true;
 			else if (!isspace(c))
 			{
-				m_pgnStream->rewindChar();
+				stream.rewindChar();
 				break;
 			}
 
@@ -267,20 +363,145 @@ OpeningSuite::FilePosition OpeningSuite::getPgnPos()
 	return pos;
 }
 
+QVector<OpeningSuite::FilePosition> OpeningSuite::getPgnPositions()
+{
+	QVector<FilePosition> positions;
+
+	PgnIndexer indexer(m_file);
+	if (!indexer.isValid())
+	{
+		forever
+		{
+			FilePosition pos = getPgnPos(*m_pgnStream);
+			if (pos.pos == -1)
+				break;
+			positions.append(pos);
+		}
+		return positions;
+	}
+
+	const auto chunks = indexer.chunks();
+	QVector<QVector<FilePosition>> chunkPositions(chunks.size());
+	indexer.scan(chunks, [&](PgnStream& stream,
+				 const PgnIndexer::Chunk& chunk,
+				 int index)
+	{
+		forever
+		{
+			FilePosition pos = getPgnPos(stream);
+			if (pos.pos == -1 || pos.pos >= chunk.end)
+				break;
+			chunkPositions[index].append(pos);
+		}
+	});
+
+	for (const auto& list : chunkPositions)
+		positions += list;
+	return positions;
+}
+
 OpeningSuite::FilePosition OpeningSuite::getEpdPos()
 {
-	FilePosition pos = { m_file->pos(), -1 };
+	FilePosition pos = { m_device->pos(), -1 };
 
-	while (m_file->readLine().isEmpty())
+	while (m_device->readLine().isEmpty())
 	{
-		if (m_file->atEnd())
+		if (m_device->atEnd())
 		{
 			pos.pos = -1;
 			break;
 		}
 		else
-			pos.pos = m_file->pos();
+			pos.pos = m_device->pos();
 	}
 
 	return pos;
 }
+
+OpeningSuite::FilePosition OpeningSuite::filePosition(int index) const
+{
+	if (m_indexData == nullptr)
+		return m_filePositions.at(index);
+
+	const uchar* entry = m_indexData + qint64(index) * 16;
+	FilePosition pos;
+	pos.pos = qFromLittleEndian<qint64>(entry);
+	pos.lineNumber = qFromLittleEndian<qint64>(entry + 8);
+	return pos;
+}
+
+bool OpeningSuite::mapIndex()
+{
+	if (m_indexFileName.isEmpty())
+		return false;
+
+	QFile* file = new QFile(m_indexFileName);
+	const uchar* data = nullptr;
+	if (file->open(QIODevice::ReadOnly)
+	&&  file->size() >= qint64(sizeof(IndexHeader)))
+		data = file->map(0, file->size());
+	if (data == nullptr)
+	{
+		delete file;
+		return false;
+	}
+
+	IndexHeader header;
+	memcpy(&header, data, sizeof(header));
+	const QFileInfo info(m_fileName);
+	const qint64 count = qFromLittleEndian(header.count);
+	if (memcmp(header.magic, s_indexMagic, sizeof(s_indexMagic)) != 0
+	||  qFromLittleEndian(header.fileSize) != info.size()
+	||  qFromLittleEndian(header.lastModified)
+	    != info.lastModified().toMSecsSinceEpoch()
+	||  qFromLittleEndian(header.format) != m_format
+	||  count < 0 || count > INT_MAX
+	||  file->size() != qint64(sizeof(header)) + count * 16)
+	{
+		delete file;
+		return false;
+	}
+
+	// The entries are read from the mapping as they're needed
+	m_indexFile = file;
+	m_indexData = data + sizeof(header);
+	m_openingCount = int(count);
+	return true;
+}
+
+bool OpeningSuite::writeIndex(const QVector<FilePosition>& positions) const
+{
+	if (m_indexFileName.isEmpty())
+		return false;
+
+	const QFileInfo info(m_fileName);
+	IndexHeader header;
+	memcpy(header.magic, s_indexMagic, sizeof(s_indexMagic));
+	header.fileSize = qToLittleEndian(info.size());
+	header.lastModified = qToLittleEndian(
+		info.lastModified().toMSecsSinceEpoch());
+	header.format = qToLittleEndian(qint64(m_format));
+	header.count = qToLittleEndian(qint64(positions.size()));
+
+	QByteArray data(int(sizeof(header)) + positions.size() * 16, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	uchar* entry = reinterpret_cast<uchar*>(data.data()) + sizeof(header);
+	for (const FilePosition& pos : positions)
+	{
+		qToLittleEndian(pos.pos, entry);
+		qToLittleEndian(pos.lineNumber, entry + 8);
+		entry += 16;
+	}
+
+	QSaveFile file(m_indexFileName);
+	if (!file.open(QIODevice::WriteOnly)
+	||  file.write(data) != data.size()
+	||  !file.commit())
+	{
+		qWarning("Can't write opening suite index %s",
+			 qPrintable(m_indexFileName));
+		return false;
+	}
+
+	return true;
+}
@@ -20,8 +20,11 @@
 
 #include <QVector>
 #include "pgngame.h"
+#include "indexpermutation.h"
+#include "memorystats.h"
 class QString;
 class QFile;
+class QIODevice;
 class QTextStream;
 class PgnStream;
 
@@ -87,6 +90,41 @@ class LIB_EXPORT OpeningSuite
 		 */
 		bool isNull() const;
 
+		/*! Returns the name of the index file. */
+		QString indexFileName() const;
+		/*!
+		 * Sets the index file to \a fileName.
+		 *
+		 * In random order the file positions of the openings are
+		 * stored in the index file, and later calls to initialize()
+		 * map it into memory instead of parsing the opening file
+		 * again, so the positions don't have to be kept in memory.
+		 * The index is rebuilt automatically if the size or
+		 * modification time of the opening file has changed.
+		 *
+		 * By default no index file is used.
+		 * \note This function must be called before initialize().
+		 */
+		void setIndexFileName(const QString& fileName);
+		/*!
+		 * Picks only slice \a index of \a count slices of the
+		 * openings in random order.
+		 *
+		 * The random order is a permutation of the openings
+		 * keyed by a number from the Mersenne generator, so suites
+		 * that are initialized after the same Mersenne::initialize()
+		 * call pick the openings in the same order. Giving each of
+		 * \a count such suites a different \a index splits the
+		 * openings between them: a suite picks the openings at
+		 * positions \a index, \a index + \a count, and so on of the
+		 * order. This lets the workers of a distributed match play
+		 * disjoint, reproducible sets of openings.
+		 *
+		 * By default the suite picks all openings (one slice).
+		 * \note This function must be called before initialize().
+		 */
+		void setSlice(int index, int count);
+
 		/*!
 		 * Initializes the opening suite.
 		 *
@@ -94,7 +132,11 @@ class LIB_EXPORT OpeningSuite
 		 * the opening suite file and gets ready to read data. If
 		 * \a order is RandomOrder, the file positions of all the
 		 * openings are parsed from the file, which could take some
-		 * time if the file is large.
+		 * time if the file is large. PGN files are parsed on
+		 * multiple threads with PgnIndexer, and the positions are
+		 * cached in the index file if one is set. The openings are
+		 * then picked through an IndexPermutation, so the positions
+		 * are never shuffled or copied.
 		 *
 		 * Returns true if successful; otherwise returns false.
 		 */
@@ -112,20 +154,33 @@ class LIB_EXPORT OpeningSuite
 			qint64 lineNumber;
 		};
 
-		FilePosition getPgnPos();
+		static FilePosition getPgnPos(PgnStream& stream);
+		QVector<FilePosition> getPgnPositions();
+		bool mapIndex();
+		bool writeIndex(const QVector<FilePosition>& positions) const;
 		FilePosition getEpdPos();
+		FilePosition filePosition(int index) const;
 
 		Format m_format;
 		Order m_order;
 		int m_gamesRead;
 		int m_gameIndex;
 		int m_startIndex;
+		int m_sliceIndex;
+		int m_sliceCount;
+		int m_openingCount;
 		QString m_fileName;
+		QString m_indexFileName;
 		QString m_fen;
 		QFile* m_file;
+		QIODevice* m_device;
 		QTextStream* m_epdStream;
 		PgnStream* m_pgnStream;
+		QFile* m_indexFile;
+		const uchar* m_indexData;
 		QVector<FilePosition> m_filePositions;
+		IndexPermutation m_permutation;
+		MemoryAccount m_memory;
 };
 
 #endif // OPENINGSUITE_H
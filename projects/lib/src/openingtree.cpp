@@ -0,0 +1,457 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "openingtree.h"
+#include <algorithm>
+#include <queue>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include "pgngame.h"
+
+namespace {
+
+/*
+ * The tree file starts with a header, followed by a sorted array of
+ * little-endian (key, childKey, games, whiteWins, draws, eloGames,
+ * eloSum) records.
+ */
+const char s_treeMagic[8] = { 'C', 'C', 'O', 'P', 'T', 'R', '0', '1' };
+const int s_recordSize = 36;
+
+struct TreeHeader
+{
+	char magic[8];
+	qint64 fileSize;
+	qint64 lastModified;
+	qint64 count;
+};
+
+TreeHeader treeHeader(const QString& sourceFileName, qint64 count)
+{
+	const QFileInfo info(sourceFileName);
+	TreeHeader header;
+	memcpy(header.magic, s_treeMagic, sizeof(s_treeMagic));
+	header.fileSize = qToLittleEndian(info.size());
+	header.lastModified = qToLittleEndian(
+		info.lastModified().toMSecsSinceEpoch());
+	header.count = qToLittleEndian(count);
+	return header;
+}
+
+} // anonymous namespace
+
+quint32 OpeningTree::Continuation::blackWins() const
+{
+	return games - whiteWins - draws;
+}
+
+int OpeningTree::Continuation::averageElo() const
+{
+	if (eloGames == 0)
+		return 0;
+	return int((eloSum + eloGames / 2) / eloGames);
+}
+
+void OpeningTree::Continuation::add(const Continuation& other)
+{
+	games += other.games;
+	whiteWins += other.whiteWins;
+	draws += other.draws;
+	eloGames += other.eloGames;
+	eloSum += other.eloSum;
+}
+
+OpeningTree::OpeningTree()
+	: m_records(nullptr),
+	  m_count(0)
+{
+}
+
+OpeningTree::~OpeningTree()
+{
+	close();
+}
+
+bool OpeningTree::open(const QString& fileName,
+		       const QString& sourceFileName)
+{
+	close();
+
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly)
+	||  m_file.size() < qint64(sizeof(TreeHeader)))
+	{
+		close();
+		return false;
+	}
+
+	const uchar* data = m_file.map(0, m_file.size());
+	if (data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	TreeHeader header;
+	memcpy(&header, data, sizeof(header));
+	const QFileInfo info(sourceFileName);
+	const qint64 count = qFromLittleEndian(header.count);
+	if (memcmp(header.magic, s_treeMagic, sizeof(s_treeMagic)) != 0
+	||  qFromLittleEndian(header.fileSize) != info.size()
+	||  qFromLittleEndian(header.lastModified)
+	    != info.lastModified().toMSecsSinceEpoch()
+	||  count < 0
+	||  m_file.size() != qint64(sizeof(header)) + count * s_recordSize)
+	{
+		close();
+		return false;
+	}
+
+	m_records = data + sizeof(header);
+	m_count = count;
+
+	return true;
+}
+
+void OpeningTree::close()
+{
+	// QFile::close() also unmaps the file
+	m_file.close();
+	m_records = nullptr;
+	m_count = 0;
+}
+
+bool OpeningTree::isOpen() const
+{
+	return m_records != nullptr;
+}
+
+qint64 OpeningTree::size() const
+{
+	return m_count;
+}
+
+quint64 OpeningTree::keyAt(qint64 index) const
+{
+	return qFromLittleEndian<quint64>(m_records + index * s_recordSize);
+}
+
+QVector<OpeningTree::Continuation> OpeningTree::find(quint64 key) const
+{
+	QVector<Continuation> moves;
+
+	// Find the first record with the key
+	qint64 first = 0;
+	qint64 last = m_count;
+	while (first < last)
+	{
+		const qint64 mid = first + (last - first) / 2;
+		if (keyAt(mid) < key)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	for (qint64 i = first; i < m_count && keyAt(i) == key; i++)
+	{
+		const uchar* record = m_records + i * s_recordSize;
+		Continuation move;
+		move.childKey = qFromLittleEndian<quint32>(record + 8);
+		move.games = qFromLittleEndian<quint32>(record + 12);
+		move.whiteWins = qFromLittleEndian<quint32>(record + 16);
+		move.draws = qFromLittleEndian<quint32>(record + 20);
+		move.eloGames = qFromLittleEndian<quint32>(record + 24);
+		move.eloSum = qFromLittleEndian<quint64>(record + 28);
+		moves.append(move);
+	}
+
+	return moves;
+}
+
+
+bool OpeningTreeWriter::Record::operator<(const Record& other) const
+{
+	if (key != other.key)
+		return key < other.key;
+	return childKey < other.childKey;
+}
+
+bool OpeningTreeWriter::Record::isSameMove(const Record& other) const
+{
+	return key == other.key && childKey == other.childKey;
+}
+
+void OpeningTreeWriter::Record::add(const Record& other)
+{
+	games += other.games;
+	whiteWins += other.whiteWins;
+	draws += other.draws;
+	eloGames += other.eloGames;
+	eloSum += other.eloSum;
+}
+
+OpeningTreeWriter::OpeningTreeWriter(int maxPly, int bufferSize)
+	: m_maxPly(maxPly),
+	  m_bufferSize(bufferSize),
+	  m_error(false)
+{
+	Q_ASSERT(maxPly > 0);
+	Q_ASSERT(bufferSize > 0);
+}
+
+OpeningTreeWriter::~OpeningTreeWriter()
+{
+	qDeleteAll(m_runs);
+}
+
+void OpeningTreeWriter::addGame(const PgnGame& pgn, quint64 finalKey)
+{
+	// Unfinished games have no score
+	const Chess::Result result(pgn.result());
+	if (result.isNone())
+		return;
+
+	const quint32 whiteWin = (result.winner() == Chess::Side::White);
+	const quint32 draw = result.isDraw();
+	const int elo[2] = { pgn.tagValue("WhiteElo").toInt(),
+			     pgn.tagValue("BlackElo").toInt() };
+
+	const auto& moves = pgn.moves();
+	const int count = qMin(moves.size(), m_maxPly);
+	Chess::Side side(pgn.startingSide());
+	QVector<Record> records;
+	records.reserve(count);
+	for (int i = 0; i < count; i++)
+	{
+		const quint64 childKey = (i + 1 < moves.size())
+			? moves.at(i + 1).key : finalKey;
+		const int moverElo = elo[side];
+		Record record = { moves.at(i).key, quint32(childKey), 1,
+				  whiteWin, draw, moverElo > 0,
+				  quint64(qMax(0, moverElo)) };
+		records.append(record);
+		side = side.opposite();
+	}
+
+	// Count repeated moves only once
+	std::sort(records.begin(), records.end());
+	auto end = std::unique(records.begin(), records.end(),
+		[](const Record& a, const Record& b)
+	{
+		return a.isSameMove(b);
+	});
+	records.erase(end, records.end());
+
+	QMutexLocker locker(&m_mutex);
+	if (m_error)
+		return;
+
+	m_records += records;
+	if (m_records.size() < m_bufferSize)
+		return;
+
+	// Common opening moves shrink a lot when they're merged, so
+	// a run is written only if that doesn't free enough memory
+	compact();
+	if (m_records.size() > m_bufferSize / 2 && !writeRun())
+	{
+		m_error = true;
+		m_records.clear();
+	}
+}
+
+void OpeningTreeWriter::compact()
+{
+	std::sort(m_records.begin(), m_records.end());
+
+	int n = 0;
+	for (int i = 0; i < m_records.size(); i++)
+	{
+		if (n > 0 && m_records.at(n - 1).isSameMove(m_records.at(i)))
+			m_records[n - 1].add(m_records.at(i));
+		else
+			m_records[n++] = m_records.at(i);
+	}
+	m_records.resize(n);
+}
+
+bool OpeningTreeWriter::writeRun()
+{
+	QTemporaryFile* file = new QTemporaryFile;
+	m_runs.append(file);
+
+	const qint64 size = qint64(m_records.size()) * sizeof(Record);
+	if (!file->open()
+	||  file->write(reinterpret_cast<const char*>(m_records.constData()),
+			size) != size)
+	{
+		qWarning("Can't write temporary opening tree file");
+		return false;
+	}
+
+	m_records.clear();
+	return true;
+}
+
+bool OpeningTreeWriter::merge(QIODevice* out, qint64* count)
+{
+	static const int bufferSize = 4096;
+
+	// The runs are read in small blocks, and the next record of
+	// each run is kept in a heap ordered by the smallest record
+	struct Run
+	{
+		QIODevice* device;
+		QVector<Record> buffer;
+		int pos;
+
+		bool next()
+		{
+			if (++pos < buffer.size())
+				return true;
+
+			buffer.resize(bufferSize);
+			const qint64 n = device->read(
+				reinterpret_cast<char*>(buffer.data()),
+				bufferSize * sizeof(Record));
+			buffer.resize(n > 0 ? int(n / sizeof(Record)) : 0);
+			pos = 0;
+			return !buffer.isEmpty();
+		}
+		const Record& record() const
+		{
+			return buffer.at(pos);
+		}
+	};
+
+	QVector<Run> runs(m_runs.size());
+	auto greater = [&runs](int a, int b)
+	{
+		return runs.at(b).record() < runs.at(a).record();
+	};
+	std::priority_queue<int, std::vector<int>, decltype(greater)> heap(greater);
+
+	for (int i = 0; i < m_runs.size(); i++)
+	{
+		Run& run = runs[i];
+		run.device = m_runs.at(i);
+		run.pos = -1;
+		if (!run.device->seek(0))
+			return false;
+		if (run.next())
+			heap.push(i);
+	}
+
+	// Equal moves from different runs are merged into one record
+	QByteArray data;
+	data.reserve(bufferSize * s_recordSize);
+	Record pending = Record();
+	bool hasPending = false;
+	*count = 0;
+	while (!heap.empty() || hasPending)
+	{
+		Record record = Record();
+		bool hasRecord = false;
+		if (!heap.empty())
+		{
+			const int i = heap.top();
+			heap.pop();
+			record = runs.at(i).record();
+			hasRecord = true;
+			if (runs[i].next())
+				heap.push(i);
+		}
+
+		if (hasRecord && hasPending && pending.isSameMove(record))
+		{
+			pending.add(record);
+			continue;
+		}
+
+		if (hasPending)
+		{
+			uchar buf[s_recordSize];
+			qToLittleEndian(pending.key, buf);
+			qToLittleEndian(pending.childKey, buf + 8);
+			qToLittleEndian(pending.games, buf + 12);
+			qToLittleEndian(pending.whiteWins, buf + 16);
+			qToLittleEndian(pending.draws, buf + 20);
+			qToLittleEndian(pending.eloGames, buf + 24);
+			qToLittleEndian(pending.eloSum, buf + 28);
+			data.append(reinterpret_cast<const char*>(buf),
+				    s_recordSize);
+			++*count;
+		}
+		pending = record;
+		hasPending = hasRecord;
+
+		if (data.size() >= bufferSize * s_recordSize
+		||  (!hasPending && !data.isEmpty()))
+		{
+			if (out->write(data) != data.size())
+				return false;
+			data.clear();
+		}
+	}
+
+	return true;
+}
+
+bool OpeningTreeWriter::write(const QString& fileName,
+			      const QString& sourceFileName)
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (m_error)
+		return false;
+
+	// Small trees are written straight from memory as one run
+	if (!m_records.isEmpty())
+	{
+		compact();
+		if (!writeRun())
+			return false;
+	}
+
+	// The header is rewritten when the number of records is known
+	TreeHeader header = treeHeader(sourceFileName, 0);
+	qint64 count = 0;
+
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)
+	||  file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+	    != qint64(sizeof(header))
+	||  !merge(&file, &count))
+	{
+		qWarning("Can't write opening tree %s", qPrintable(fileName));
+		return false;
+	}
+
+	header = treeHeader(sourceFileName, count);
+	if (!file.seek(0)
+	||  file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+	    != qint64(sizeof(header))
+	||  !file.commit())
+	{
+		qWarning("Can't write opening tree %s", qPrintable(fileName));
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,188 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENINGTREE_H
+#define OPENINGTREE_H
+
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+class PgnGame;
+class QIODevice;
+class QTemporaryFile;
+
+
+/*!
+ * \brief Move statistics of the positions in a game database.
+ *
+ * An opening tree maps the Zobrist key of a position to the moves
+ * played in it, with the number of games, the results and the
+ * average Elo of the players who made the move. The statistics are
+ * aggregated over the whole database when the tree is written, so
+ * looking up a position is a binary search in a memory-mapped file.
+ *
+ * A move is identified by the low 32 bits of the key of the position
+ * it leads to. That is enough to tell the legal moves of a position
+ * apart, and it works for every variant.
+ *
+ * Use OpeningTreeWriter to create the file.
+ *
+ * \sa OpeningTreeWriter, PositionIndex
+ */
+class LIB_EXPORT OpeningTree
+{
+	public:
+		/*! The statistics of a move in a position. */
+		struct Continuation
+		{
+			/*! The low 32 bits of the key after the move. */
+			quint32 childKey;
+			/*! The number of games where the move was played. */
+			quint32 games;
+			/*! The number of those games won by white. */
+			quint32 whiteWins;
+			/*! The number of those games that were drawn. */
+			quint32 draws;
+			/*! The number of games where the mover's Elo is known. */
+			quint32 eloGames;
+			/*! The sum of the mover's Elo in those games. */
+			quint64 eloSum;
+
+			/*! Returns the number of games won by black. */
+			quint32 blackWins() const;
+			/*!
+			 * Returns the average Elo of the players who made the
+			 * move, or 0 if it's not known.
+			 */
+			int averageElo() const;
+			/*!
+			 * Adds the statistics of \a other, eg. from another
+			 * database, to this move.
+			 */
+			void add(const Continuation& other);
+		};
+
+		/*! Creates a new closed tree. */
+		OpeningTree();
+		/*! Destroys the tree and closes the file. */
+		~OpeningTree();
+
+		/*!
+		 * Opens the tree file \a fileName that was created for the
+		 * PGN file \a sourceFileName.
+		 *
+		 * Returns false if the file can't be mapped, or if
+		 * \a sourceFileName was modified after the tree was written.
+		 */
+		bool open(const QString& fileName, const QString& sourceFileName);
+		/*! Closes the tree file. */
+		void close();
+		/*! Returns true if the tree is open. */
+		bool isOpen() const;
+
+		/*! Returns the number of (position, move) pairs in the tree. */
+		qint64 size() const;
+		/*!
+		 * Returns the moves played in the position with Zobrist
+		 * key \a key, sorted by their child keys.
+		 */
+		QVector<Continuation> find(quint64 key) const;
+
+	private:
+		Q_DISABLE_COPY(OpeningTree)
+
+		quint64 keyAt(qint64 index) const;
+
+		QFile m_file;
+		const uchar* m_records;
+		qint64 m_count;
+};
+
+/*!
+ * \brief Creates OpeningTree files.
+ *
+ * The moves of the games are collected in memory and merged into one
+ * record per position and move whenever the buffer is full. Buffers
+ * that are still too large are written to temporary files as sorted
+ * runs, which are merged when the tree is written.
+ *
+ * addGame() can be called from several threads at once.
+ *
+ * \sa OpeningTree
+ */
+class LIB_EXPORT OpeningTreeWriter
+{
+	public:
+		/*!
+		 * Creates a new writer that keeps at most \a bufferSize
+		 * moves in memory and adds the first \a maxPly plies of
+		 * each game.
+		 */
+		explicit OpeningTreeWriter(int maxPly = 40,
+					   int bufferSize = 4 * 1024 * 1024);
+		/*! Destroys the writer and its temporary files. */
+		~OpeningTreeWriter();
+
+		/*!
+		 * Adds the moves of \a pgn to the tree.
+		 *
+		 * The position before each move comes from its MoveData
+		 * key. \a finalKey is the key of the position after the
+		 * last move. A move that's played more than once in the
+		 * same position of the game is counted once.
+		 */
+		void addGame(const PgnGame& pgn, quint64 finalKey);
+
+		/*!
+		 * Writes the tree to \a fileName for the PGN file
+		 * \a sourceFileName.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool write(const QString& fileName, const QString& sourceFileName);
+
+	private:
+		Q_DISABLE_COPY(OpeningTreeWriter)
+
+		struct Record
+		{
+			quint64 key;
+			quint32 childKey;
+			quint32 games;
+			quint32 whiteWins;
+			quint32 draws;
+			quint32 eloGames;
+			quint64 eloSum;
+
+			bool operator<(const Record& other) const;
+			bool isSameMove(const Record& other) const;
+			void add(const Record& other);
+		};
+
+		void compact();
+		bool writeRun();
+		bool merge(QIODevice* out, qint64* count);
+
+		QMutex m_mutex;
+		QVector<Record> m_records;
+		QVector<QTemporaryFile*> m_runs;
+		int m_maxPly;
+		int m_bufferSize;
+		bool m_error;
+};
+
+#endif // OPENINGTREE_H
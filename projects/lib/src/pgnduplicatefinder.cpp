@@ -0,0 +1,232 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnduplicatefinder.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include "pgngame.h"
+#include "pgnstream.h"
+
+namespace {
+
+// Candidate groups per task
+const int GroupBatchSize = 256;
+
+class DuplicateTask : public QRunnable
+{
+	public:
+		explicit DuplicateTask(const std::function<void()>& function)
+			: m_function(function)
+		{
+		}
+
+		virtual void run()
+		{
+			m_function();
+		}
+
+	private:
+		std::function<void()> m_function;
+};
+
+// Reads games and keeps the last file open for the next game
+class GameReader
+{
+	public:
+		explicit GameReader(const QStringList& fileNames)
+			: m_fileNames(fileNames),
+			  m_fileIndex(-1)
+		{
+		}
+
+		bool read(int fileIndex, qint64 pos, qint64 lineNumber,
+			  PgnGame& game)
+		{
+			if (fileIndex != m_fileIndex)
+			{
+				m_fileIndex = fileIndex;
+				m_stream.setDevice(nullptr);
+				m_file.close();
+				m_file.setFileName(m_fileNames.at(fileIndex));
+				if (m_file.open(QIODevice::ReadOnly | QIODevice::Text))
+					m_stream.setDevice(&m_file);
+			}
+			if (!m_file.isOpen())
+				return false;
+
+			return m_stream.seek(pos, lineNumber)
+			    && game.read(m_stream, INT_MAX - 1, false);
+		}
+
+	private:
+		QStringList m_fileNames;
+		int m_fileIndex;
+		QFile m_file;
+		PgnStream m_stream;
+};
+
+bool isSameGame(const PgnGame& a, const PgnGame& b)
+{
+	if (a.moves().size() != b.moves().size()
+	||  a.playerName(Chess::Side::White) != b.playerName(Chess::Side::White)
+	||  a.playerName(Chess::Side::Black) != b.playerName(Chess::Side::Black)
+	||  a.variant() != b.variant()
+	||  a.startingFenString() != b.startingFenString())
+		return false;
+
+	for (int i = 0; i < a.moves().size(); i++)
+	{
+		if (!(a.moves().at(i).move == b.moves().at(i).move))
+			return false;
+	}
+	return true;
+}
+
+} // anonymous namespace
+
+PgnDuplicateFinder::PgnDuplicateFinder()
+{
+}
+
+int PgnDuplicateFinder::addGame(const QString& fileName,
+				qint64 pos,
+				qint64 lineNumber,
+				quint64 moveHash)
+{
+	// The games of a file are usually added together
+	int file = m_fileNames.size() - 1;
+	if (file < 0 || m_fileNames.at(file) != fileName)
+	{
+		file = m_fileNames.indexOf(fileName);
+		if (file == -1)
+		{
+			file = m_fileNames.size();
+			m_fileNames.append(fileName);
+		}
+	}
+
+	Game game = { file, pos, lineNumber, moveHash };
+	m_games.append(game);
+	return m_games.size() - 1;
+}
+
+int PgnDuplicateFinder::gameCount() const
+{
+	return m_games.size();
+}
+
+int PgnDuplicateFinder::run()
+{
+	m_originals.fill(-1, m_games.size());
+
+	// Group the games by hash, in the order they were added
+	QVector<int> order;
+	order.reserve(m_games.size());
+	for (int i = 0; i < m_games.size(); i++)
+	{
+		if (m_games.at(i).moveHash != 0)
+			order.append(i);
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+	{
+		const quint64 hashA = m_games.at(a).moveHash;
+		const quint64 hashB = m_games.at(b).moveHash;
+		return hashA != hashB ? hashA < hashB : a < b;
+	});
+
+	QVector<QVector<int>> groups;
+	for (int begin = 0; begin < order.size(); )
+	{
+		const quint64 hash = m_games.at(order.at(begin)).moveHash;
+		int end = begin + 1;
+		while (end < order.size() && m_games.at(order.at(end)).moveHash == hash)
+			end++;
+		if (end - begin > 1)
+			groups.append(order.mid(begin, end - begin));
+		begin = end;
+	}
+
+	// Each group only writes the originals of its own games
+	int* originals = m_originals.data();
+	auto confirm = [&](int firstGroup, int lastGroup)
+	{
+		GameReader reader(m_fileNames);
+		for (int i = firstGroup; i < lastGroup; i++)
+		{
+			const QVector<int>& group(groups.at(i));
+			QVector<PgnGame> games(group.size());
+			QVector<bool> ok(group.size());
+			for (int j = 0; j < group.size(); j++)
+			{
+				const Game& game(m_games.at(group.at(j)));
+				ok[j] = reader.read(game.file, game.pos,
+						    game.lineNumber, games[j]);
+			}
+
+			for (int j = 1; j < group.size(); j++)
+			{
+				for (int k = 0; ok.at(j) && k < j; k++)
+				{
+					if (ok.at(k) && originals[group.at(k)] == -1
+					&&  isSameGame(games.at(j), games.at(k)))
+					{
+						originals[group.at(j)] = group.at(k);
+						break;
+					}
+				}
+			}
+		}
+	};
+
+	const int batchCount = (groups.size() + GroupBatchSize - 1) / GroupBatchSize;
+	if (batchCount > 1)
+	{
+		QThreadPool pool;
+		pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(),
+					      batchCount));
+		for (int batch = 0; batch < batchCount; batch++)
+		{
+			const int first = batch * GroupBatchSize;
+			const int last = qMin(first + GroupBatchSize, groups.size());
+			pool.start(new DuplicateTask([=, &confirm]()
+			{
+				confirm(first, last);
+			}));
+		}
+		pool.waitForDone();
+	}
+	else
+		confirm(0, groups.size());
+
+	return int(std::count_if(m_originals.constBegin(), m_originals.constEnd(),
+				 [](int original) { return original != -1; }));
+}
+
+int PgnDuplicateFinder::originalOf(int index) const
+{
+	return m_originals.value(index, -1);
+}
+
+bool PgnDuplicateFinder::isDuplicate(int index) const
+{
+	return originalOf(index) != -1;
+}
@@ -0,0 +1,85 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNDUPLICATEFINDER_H
+#define PGNDUPLICATEFINDER_H
+
+#include <QStringList>
+#include <QVector>
+
+/*!
+ * \brief Finds duplicate games in PGN files
+ *
+ * The games are added with their position in a PGN file and their
+ * PgnGameEntry::moveHash(). The games with the same hash are
+ * candidates, which run() confirms by reading them and comparing
+ * their players, starting positions and moves. The candidate groups
+ * are read in parallel, each by a thread with files of its own.
+ *
+ * The first game of a set of equal games is the original and the
+ * rest are its duplicates.
+ */
+class LIB_EXPORT PgnDuplicateFinder
+{
+	public:
+		/*! Creates a new finder without games. */
+		PgnDuplicateFinder();
+
+		/*!
+		 * Adds the game at stream position \a pos and line
+		 * \a lineNumber of PGN file \a fileName, with move hash
+		 * \a moveHash. Returns the index of the game.
+		 *
+		 * Games without moves (\a moveHash is 0) are never
+		 * duplicates.
+		 */
+		int addGame(const QString& fileName,
+			    qint64 pos,
+			    qint64 lineNumber,
+			    quint64 moveHash);
+		/*! Returns the number of games. */
+		int gameCount() const;
+
+		/*!
+		 * Finds the duplicate games and returns their number.
+		 *
+		 * A game that can't be read is not a duplicate.
+		 */
+		int run();
+		/*!
+		 * Returns the index of the original of game \a index, or
+		 * -1 if the game is not a duplicate.
+		 */
+		int originalOf(int index) const;
+		/*! Returns true if game \a index is a duplicate. */
+		bool isDuplicate(int index) const;
+
+	private:
+		struct Game
+		{
+			int file;
+			qint64 pos;
+			qint64 lineNumber;
+			quint64 moveHash;
+		};
+
+		QStringList m_fileNames;
+		QVector<Game> m_games;
+		QVector<int> m_originals;
+};
+
+#endif // PGNDUPLICATEFINDER_H
@@ -0,0 +1,386 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnentryindex.h"
+#include <algorithm>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QVector>
+#include <QtEndian>
+#include "pgntagpool.h"
+
+namespace {
+
+/*
+ * The index file starts with a header, followed by the game records,
+ * the sort orders of each tag, and a string table of the tag values.
+ * All numbers are little-endian.
+ *
+ * A game record has the stream position, line number and move hash
+ * as 64-bit integers, followed by the 32-bit string IDs of the tags.
+ *
+ * A sort order is an array of 32-bit row numbers. The string table
+ * has the 64-bit offsets of the values, followed by the UTF-8 data.
+ */
+const char s_indexMagic[8] = { 'C', 'C', 'E', 'N', 'T', 'I', '0', '2' };
+const int s_tagCount = PgnGameEntry::VariantTag + 1;
+const int s_recordSize = 24 + s_tagCount * 4;
+
+struct IndexHeader
+{
+	char magic[8];
+	qint64 fileSize;
+	qint64 lastModified;
+	qint64 count;
+	qint64 valueCount;
+};
+
+class BufferedWriter
+{
+	public:
+		explicit BufferedWriter(QIODevice* device)
+			: m_device(device),
+			  m_ok(true)
+		{
+			m_buffer.reserve(BufferSize + 8);
+		}
+
+		void put32(quint32 value)
+		{
+			uchar data[4];
+			qToLittleEndian(value, data);
+			append(reinterpret_cast<const char*>(data), 4);
+		}
+
+		void put64(qint64 value)
+		{
+			uchar data[8];
+			qToLittleEndian(value, data);
+			append(reinterpret_cast<const char*>(data), 8);
+		}
+
+		void append(const char* data, int size)
+		{
+			m_buffer.append(data, size);
+			if (m_buffer.size() >= BufferSize)
+				flush();
+		}
+
+		bool flush()
+		{
+			if (m_ok && !m_buffer.isEmpty())
+				m_ok = m_device->write(m_buffer) == m_buffer.size();
+			m_buffer.clear();
+			return m_ok;
+		}
+
+	private:
+		enum { BufferSize = 1024 * 1024 };
+
+		QIODevice* m_device;
+		QByteArray m_buffer;
+		bool m_ok;
+};
+
+} // anonymous namespace
+
+PgnEntryIndex::PgnEntryIndex()
+	: m_records(nullptr),
+	  m_sortOrders(nullptr),
+	  m_valueOffsets(nullptr),
+	  m_values(nullptr),
+	  m_count(0),
+	  m_valueCount(0)
+{
+}
+
+PgnEntryIndex::~PgnEntryIndex()
+{
+	close();
+}
+
+bool PgnEntryIndex::write(const QString& fileName,
+			  const QList<const PgnGameEntry*>& entries,
+			  const QString& sourceFileName)
+{
+	const PgnTagPool* pool = entries.isEmpty() ?
+		nullptr : entries.first()->tagPool();
+	const int count = entries.size();
+
+	QVector<QByteArray> values(pool != nullptr ? pool->size() : 1);
+	for (int i = 1; i < values.size(); i++)
+		values[i] = pool->value(quint32(i));
+	const quint32 valueCount = quint32(values.size());
+
+	// Rank the distinct values so that each sort order can be
+	// built with a counting sort instead of comparing strings
+	QVector<quint32> valueOrder(values.size());
+	for (int i = 0; i < valueOrder.size(); i++)
+		valueOrder[i] = quint32(i);
+	std::sort(valueOrder.begin(), valueOrder.end(),
+		  [&](quint32 a, quint32 b)
+	{
+		int cmp = qstricmp(values.at(a).constData(),
+				   values.at(b).constData());
+		if (cmp == 0)
+			cmp = qstrcmp(values.at(a), values.at(b));
+		return cmp != 0 ? cmp < 0 : a < b;
+	});
+	QVector<quint32> rank(values.size());
+	for (int i = 0; i < valueOrder.size(); i++)
+		rank[valueOrder.at(i)] = quint32(i);
+
+	const QFileInfo info(sourceFileName);
+	IndexHeader header;
+	memcpy(header.magic, s_indexMagic, sizeof(s_indexMagic));
+	header.fileSize = qToLittleEndian(info.size());
+	header.lastModified = qToLittleEndian(
+		info.lastModified().toMSecsSinceEpoch());
+	header.count = qToLittleEndian(qint64(count));
+	header.valueCount = qToLittleEndian(qint64(valueCount));
+
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't write PGN entry index %s", qPrintable(fileName));
+		return false;
+	}
+
+	BufferedWriter out(&file);
+	out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const PgnGameEntry* entry : entries)
+	{
+		Q_ASSERT(entry->tagPool() == pool);
+		out.put64(entry->pos());
+		out.put64(entry->lineNumber());
+		out.put64(qint64(entry->moveHash()));
+		for (int i = 0; i < s_tagCount; i++)
+			out.put32(entry->tagId(PgnGameEntry::TagType(i)));
+	}
+
+	QVector<quint32> start(values.size() + 1);
+	QVector<quint32> order(count);
+	for (int i = 0; i < s_tagCount; i++)
+	{
+		const auto type = PgnGameEntry::TagType(i);
+
+		start.fill(0);
+		for (const PgnGameEntry* entry : entries)
+			start[rank.at(entry->tagId(type)) + 1]++;
+		for (int j = 1; j < start.size(); j++)
+			start[j] += start.at(j - 1);
+
+		for (int row = 0; row < count; row++)
+		{
+			const quint32 id = entries.at(row)->tagId(type);
+			order[start[rank.at(id)]++] = quint32(row);
+		}
+		for (quint32 row : order)
+			out.put32(row);
+	}
+
+	qint64 offset = 0;
+	for (const QByteArray& value : values)
+	{
+		out.put64(offset);
+		offset += value.size();
+	}
+	out.put64(offset);
+	for (const QByteArray& value : values)
+		out.append(value.constData(), value.size());
+
+	if (!out.flush() || !file.commit())
+	{
+		qWarning("Can't write PGN entry index %s", qPrintable(fileName));
+		return false;
+	}
+
+	return true;
+}
+
+bool PgnEntryIndex::open(const QString& fileName,
+			 const QString& sourceFileName)
+{
+	close();
+
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly)
+	||  m_file.size() < qint64(sizeof(IndexHeader)))
+	{
+		close();
+		return false;
+	}
+
+	const uchar* data = m_file.map(0, m_file.size());
+	if (data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	IndexHeader header;
+	memcpy(&header, data, sizeof(header));
+	const QFileInfo info(sourceFileName);
+	const qint64 count = qFromLittleEndian(header.count);
+	const qint64 valueCount = qFromLittleEndian(header.valueCount);
+	if (memcmp(header.magic, s_indexMagic, sizeof(s_indexMagic)) != 0
+	||  qFromLittleEndian(header.fileSize) != info.size()
+	||  qFromLittleEndian(header.lastModified)
+	    != info.lastModified().toMSecsSinceEpoch()
+	||  count < 0 || count > INT_MAX
+	||  valueCount < 1 || valueCount > UINT_MAX - 1)
+	{
+		close();
+		return false;
+	}
+
+	const qint64 tableOffset = qint64(sizeof(header))
+				 + count * s_recordSize
+				 + count * s_tagCount * 4;
+	const qint64 valuesOffset = tableOffset + (valueCount + 1) * 8;
+	if (valuesOffset > m_file.size()
+	||  valuesOffset + qFromLittleEndian<qint64>(
+		data + valuesOffset - 8) != m_file.size())
+	{
+		close();
+		return false;
+	}
+
+	m_records = data + sizeof(header);
+	m_sortOrders = m_records + count * s_recordSize;
+	m_valueOffsets = data + tableOffset;
+	m_values = data + valuesOffset;
+	m_count = int(count);
+	m_valueCount = quint32(valueCount);
+
+	return true;
+}
+
+void PgnEntryIndex::close()
+{
+	// QFile::close() also unmaps the file
+	m_file.close();
+	m_records = nullptr;
+	m_sortOrders = nullptr;
+	m_valueOffsets = nullptr;
+	m_values = nullptr;
+	m_count = 0;
+	m_valueCount = 0;
+}
+
+bool PgnEntryIndex::isOpen() const
+{
+	return m_records != nullptr;
+}
+
+QString PgnEntryIndex::fileName() const
+{
+	return m_file.fileName();
+}
+
+int PgnEntryIndex::count() const
+{
+	return m_count;
+}
+
+qint64 PgnEntryIndex::pos(int row) const
+{
+	Q_ASSERT(row >= 0 && row < m_count);
+	return qFromLittleEndian<qint64>(m_records + qint64(row) * s_recordSize);
+}
+
+qint64 PgnEntryIndex::lineNumber(int row) const
+{
+	Q_ASSERT(row >= 0 && row < m_count);
+	return qFromLittleEndian<qint64>(m_records + qint64(row) * s_recordSize
+					 + 8);
+}
+
+quint64 PgnEntryIndex::moveHash(int row) const
+{
+	Q_ASSERT(row >= 0 && row < m_count);
+	return qFromLittleEndian<quint64>(m_records + qint64(row) * s_recordSize
+					  + 16);
+}
+
+quint32 PgnEntryIndex::tagId(int row, int type) const
+{
+	const uchar* record = m_records + qint64(row) * s_recordSize;
+	return qFromLittleEndian<quint32>(record + 24 + type * 4);
+}
+
+QByteArray PgnEntryIndex::value(quint32 id) const
+{
+	if (id >= m_valueCount)
+		return QByteArray();
+
+	const uchar* offset = m_valueOffsets + qint64(id) * 8;
+	const qint64 begin = qFromLittleEndian<qint64>(offset);
+	const qint64 end = qFromLittleEndian<qint64>(offset + 8);
+	if (end <= begin)
+		return QByteArray();
+
+	return QByteArray(reinterpret_cast<const char*>(m_values + begin),
+			  int(end - begin));
+}
+
+QString PgnEntryIndex::tagValue(int row, PgnGameEntry::TagType type) const
+{
+	Q_ASSERT(row >= 0 && row < m_count);
+
+	const QByteArray value(this->value(tagId(row, type)));
+	if (value.isEmpty())
+		return QString();
+	return QString::fromUtf8(value);
+}
+
+int PgnEntryIndex::sortedRow(PgnGameEntry::TagType type, int rank) const
+{
+	Q_ASSERT(rank >= 0 && rank < m_count);
+
+	const qint64 index = qint64(type) * m_count + rank;
+	return int(qFromLittleEndian<quint32>(m_sortOrders + index * 4));
+}
+
+QList<const PgnGameEntry*> PgnEntryIndex::entries(PgnTagPool* tagPool) const
+{
+	Q_ASSERT(tagPool != nullptr);
+
+	// Each distinct value is interned only once
+	QVector<quint32> ids(static_cast<int>(m_valueCount));
+	for (quint32 i = 0; i < m_valueCount; i++)
+		ids[int(i)] = tagPool->intern(value(i));
+
+	QList<const PgnGameEntry*> entries;
+	entries.reserve(m_count);
+	for (int row = 0; row < m_count; row++)
+	{
+		PgnGameEntry* entry = new PgnGameEntry(tagPool);
+		entry->m_pos = pos(row);
+		entry->m_lineNumber = lineNumber(row);
+		entry->m_moveHash = moveHash(row);
+		for (int i = 0; i < s_tagCount; i++)
+		{
+			const quint32 id = tagId(row, i);
+			entry->m_tags[i] = id < m_valueCount ? ids.at(int(id)) : 0;
+		}
+		entries.append(entry);
+	}
+
+	return entries;
+}
@@ -0,0 +1,121 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNENTRYINDEX_H
+#define PGNENTRYINDEX_H
+
+#include <QFile>
+#include <QList>
+#include "pgngameentry.h"
+class PgnTagPool;
+
+
+/*!
+ * \brief A memory-mapped index of the games in a PGN file.
+ *
+ * A PgnEntryIndex stores the same data as a list of PgnGameEntry
+ * objects: the position, line number and tags of every game. The
+ * data is kept in a file that is mapped to memory, so opening an
+ * index of millions of games is fast and only the pages that are
+ * actually read take up memory.
+ *
+ * The index also contains the order of the games when they are
+ * sorted by each tag, so a view can be sorted without reading all
+ * the tag values.
+ *
+ * \sa PgnGameEntry, PositionIndex
+ */
+class LIB_EXPORT PgnEntryIndex
+{
+	public:
+		/*! Creates a new closed index. */
+		PgnEntryIndex();
+		/*! Destroys the index and closes the file. */
+		~PgnEntryIndex();
+
+		/*!
+		 * Writes an index of \a entries to \a fileName for the PGN
+		 * file \a sourceFileName. The entries must share the same
+		 * tag pool.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool write(const QString& fileName,
+				  const QList<const PgnGameEntry*>& entries,
+				  const QString& sourceFileName);
+
+		/*!
+		 * Opens the index file \a fileName that was created for
+		 * the PGN file \a sourceFileName.
+		 *
+		 * Returns false if the file can't be mapped, or if
+		 * \a sourceFileName was modified after the index was written.
+		 */
+		bool open(const QString& fileName, const QString& sourceFileName);
+		/*! Closes the index file. */
+		void close();
+		/*! Returns true if the index is open. */
+		bool isOpen() const;
+		/*! Returns the name of the index file. */
+		QString fileName() const;
+
+		/*! Returns the number of games in the index. */
+		int count() const;
+		/*! Returns the stream position where game \a row begins. */
+		qint64 pos(int row) const;
+		/*! Returns the line number where game \a row begins. */
+		qint64 lineNumber(int row) const;
+		/*!
+		 * Returns the move hash of game \a row.
+		 *
+		 * \sa PgnGameEntry::moveHash()
+		 */
+		quint64 moveHash(int row) const;
+		/*! Returns the tag value of game \a row for \a type. */
+		QString tagValue(int row, PgnGameEntry::TagType type) const;
+
+		/*!
+		 * Returns the game at position \a rank when the games are
+		 * sorted by the tag \a type in ascending order. Games with
+		 * equal tags keep their order in the PGN file.
+		 */
+		int sortedRow(PgnGameEntry::TagType type, int rank) const;
+
+		/*!
+		 * Creates a PgnGameEntry object for each game in the index,
+		 * with the tag values stored in \a tagPool.
+		 *
+		 * The caller takes ownership of the entries.
+		 */
+		QList<const PgnGameEntry*> entries(PgnTagPool* tagPool) const;
+
+	private:
+		Q_DISABLE_COPY(PgnEntryIndex)
+
+		QByteArray value(quint32 id) const;
+		quint32 tagId(int row, int type) const;
+
+		QFile m_file;
+		const uchar* m_records;
+		const uchar* m_sortOrders;
+		const uchar* m_valueOffsets;
+		const uchar* m_values;
+		int m_count;
+		quint32 m_valueCount;
+};
+
+#endif // PGNENTRYINDEX_H
@@ -20,7 +20,10 @@
 #include <QFile>
 #include <QMetaObject>
 #include <QDateTime>
+#include <QScopedPointer>
+#include <QtMath>
 #include "board/boardfactory.h"
+#include "board/westernboard.h"
 #include "econode.h"
 #include "pgnstream.h"
 
@@ -34,6 +37,81 @@ void writeTag(QTextStream& out, const QString& tag, const QString& value)
 		out << "[" << tag << " \"?\"]\n";
 }
 
+// Formats \a msecs as "hh:mm:ss"
+QString clockString(int msecs)
+{
+	if (msecs == 0)
+		return "00:00:00";
+
+	int total = qFloor(msecs / 1000.);
+	int hours = qFloor(total / 3600.) % 24;
+	int minutes = (total / 60) % 60;
+	int seconds = total % 60;
+	return QString::number(hours).rightJustified(2, '0') + ":" +
+	       QString::number(minutes).rightJustified(2, '0') + ":" +
+	       QString::number(seconds).rightJustified(2, '0');
+}
+
+QString evalText(const PgnGame::EvalData& eval, Chess::Board* board)
+{
+	QString sScore;
+	if (eval.depth > 0)
+	{
+		int score = eval.score;
+		int absScore = qAbs(score);
+
+		// Detect mate-in-n scores
+		if (absScore > 9900
+		&&  (absScore = 1000 - (absScore % 1000)) < 100)
+		{
+			if (score < 0)
+				sScore = "-";
+			sScore += "M" + QString::number(absScore);
+		}
+		else
+			sScore = QString::number(double(score) / 100.0, 'f', 2);
+	}
+	else
+		sScore = "0.00";
+
+	QString str = "d=";
+	str += QString::number(eval.depth > 0 ? eval.depth : 1);
+
+	// The SAN PV is also used for the ponder move
+	QString sanPv = board->sanStringForPv(eval.pv,
+		Chess::Board::StandardAlgebraic);
+	QStringList sanList = sanPv.split(' ');
+	if (sanList.length() > 1)
+		str += ", pd=" + sanList[1];
+
+	str += ", mt=" + clockString(eval.moveTime);
+	str += ", tl=" + clockString(eval.timeLeft);
+	str += ", s=" + QString::number(eval.nps / 1000) + " kN/s";
+	str += ", n=" + QString::number(eval.nodes);
+	str += ", pv=" + sanPv;
+	str += ", tb=" + QString::number(eval.tbHits);
+
+	auto wboard = dynamic_cast<Chess::WesternBoard*>(board);
+	if (wboard)
+		str += ", R50=" + QString::number(qFloor(
+			((100 - wboard->reversibleMoveCount()) / 2.) + 0.5));
+
+	// Eval from white's perspective
+	str += ", wv=";
+	if (board->sideToMove() == Chess::Side::Black && sScore != "0.00")
+	{
+		if (sScore[0] == '-')
+			str += sScore.right(sScore.length() - 1);
+		else
+			str += "-" + sScore;
+	}
+	else
+		str += sScore;
+
+	str += ',';
+	return str;
+}
+
 } // anonymous namespace
 
 PgnStream& operator>>(PgnStream& in, PgnGame& game)
@@ -49,9 +127,25 @@ QTextStream& operator<<(QTextStream& out, const PgnGame& game)
 }
 
 
+PgnGame::EvalData::EvalData()
+	: score(0),
+	  depth(-1),
+	  moveTime(0),
+	  timeLeft(0),
+	  nodes(0),
+	  nps(0),
+	  tbHits(0)
+{
+}
+
+bool PgnGame::EvalData::isNull() const
+{
+	return depth < 0;
+}
+
 PgnGame::PgnGame()
 	: m_startingSide(Chess::Side::White),
-	  m_eco(EcoNode::root()),
+	  m_eco(nullptr),
 	  m_tagReceiver(nullptr)
 {
 }
@@ -64,7 +158,7 @@ bool PgnGame::isNull() const
 void PgnGame::clear()
 {
 	m_startingSide = Chess::Side();
-	m_eco = EcoNode::root();
+	m_eco = nullptr;
 	m_tags.clear();
 	m_moves.clear();
 }
@@ -73,25 +167,7 @@ QList< QPair<QString, QString> > PgnGame::tags() const
 {
 	QList< QPair<QString, QString> > list;
 
-	// The seven tag roster
-	const QStringList roster = (QStringList() << "Event" << "Site" << "Date"
-		<< "Round" << "White" << "Black" << "Result");
-	for (const QString& tag : roster)
-	{
-		QString value = m_tags.value(tag);
-		if (value.isEmpty())
-			value = "?";
-		list.append(qMakePair(tag, value));
-	}
-
-	QMap<QString, QString>::const_iterator it;
-	for (it = m_tags.constBegin(); it != m_tags.constEnd(); ++it)
-	{
-		if (!roster.contains(it.key()) && !it.value().isEmpty())
-			list.append(qMakePair(it.key(), it.value()));
-	}
-
-	return list;
+	return m_tags.toList();
 }
 
 const QVector<PgnGame::MoveData>& PgnGame::moves() const
@@ -101,11 +177,13 @@ const QVector<PgnGame::MoveData>& PgnGame::moves() const
 
 void PgnGame::addMove(const MoveData& data, bool addEco)
 {
+	// The ECO tree isn't loaded until a game actually has moves
+	const EcoNode* parent = m_moves.isEmpty() ? EcoNode::root() : m_eco;
 	m_moves.append(data);
 
 	if (addEco) {
-		m_eco = (m_eco && isStandard()) ? m_eco->child(data.moveString)
-						: nullptr;
+		m_eco = (parent && isStandard()) ? parent->child(data.moveString)
+						 : nullptr;
 		if (m_eco && m_eco->isLeaf())
 		{
 			setTag("ECO", m_eco->ecoCode());
@@ -192,7 +270,11 @@ bool PgnGame::parseMove(PgnStream& in, bool addEco)
 	}
 
 	const QString str(in.tokenString());
-	Chess::Move move(board->moveFromString(str));
+	Chess::Move move;
+	if (in.trustedMoves())
+		move = board->moveFromTrustedSanString(str);
+	if (move.isNull())
+		move = board->moveFromString(str);
 	if (move.isNull())
 	{
 		qDebug("Illegal move: %s", qPrintable(str));
@@ -232,7 +314,7 @@ bool PgnGame::read(PgnStream& in, int maxMoves, bool addEco)
 		case PgnStream::PgnResult:
 			{
 				const QString str(in.tokenString());
-				QString result = m_tags.value("Result");
+				QString result = m_tags.value(PgnTagList::Result);
 
 				if (!result.isEmpty() && str != result)
 					qDebug("%s",qPrintable(QString("Line %1: The termination "
@@ -279,20 +361,22 @@ bool PgnGame::write(QTextStream& out, PgnMode mode) const
 	
 	if (mode == Minimal && m_tags.contains("FEN"))
 	{
-		writeTag(out, "FEN", m_tags["FEN"]);
-		writeTag(out, "SetUp", m_tags["SetUp"]);
+		writeTag(out, "FEN", m_tags.value("FEN"));
+		writeTag(out, "SetUp", m_tags.value("SetUp"));
 	}
 
 	if (mode == Minimal && m_tags.contains("Variant")
 	&&  variant() != "standard")
 	{
-		writeTag(out, "Variant", m_tags["Variant"]);
+		writeTag(out, "Variant", m_tags.value("Variant"));
 	}
 
 	QString str;
 	int lineLength = 0;
 	int movenum = 0;
 	int side = m_startingSide;
+	const QStringList comments = (mode == Verbose) ?
+		this->comments() : QStringList();
 
 	if (!m_initialComment.isEmpty())
 		out << "\n" << "{" << m_initialComment << "}";
@@ -308,8 +392,8 @@ bool PgnGame::write(QTextStream& out, PgnMode mode) const
 			str = QString::number(++movenum) + ". ";
 
 		str += data.moveString;
-		if (mode == Verbose && !data.comment.isEmpty())
-			str += QString(" {%1}").arg(data.comment);
+		if (mode == Verbose && !comments.at(i).isEmpty())
+			str += QString(" {%1}").arg(comments.at(i));
 
 		// Limit the lines to 80 characters
 		if (lineLength == 0 || lineLength + str.size() >= 80)
@@ -326,7 +410,7 @@ bool PgnGame::write(QTextStream& out, PgnMode mode) const
 		side = !side;
 	}
 
-	str = m_tags.value("Result");
+	str = m_tags.value(PgnTagList::Result);
 
 	if (lineLength + str.size() >= 80)
 		out << "\n" << str << "\n\n";
@@ -348,6 +432,65 @@ bool PgnGame::write(const QString& filename, PgnMode mode) const
 	return write(out, mode);
 }
 
+QStringList PgnGame::comments() const
+{
+	QStringList list;
+	list.reserve(m_moves.size());
+	bool hasEval = false;
+	for (const MoveData& md : m_moves)
+	{
+		list.append(md.comment);
+		hasEval = hasEval || !md.eval.isNull();
+	}
+	if (!hasEval)
+		return list;
+
+	// Formatting the evaluations needs the position before each move
+	QScopedPointer<Chess::Board> board(createBoard());
+	if (board.isNull())
+		return list;
+
+	for (int i = 0; i < m_moves.size(); i++)
+	{
+		const MoveData& md = m_moves.at(i);
+		const Chess::Move move(board->moveFromGenericMove(md.move));
+		if (move.isNull())
+			break;
+
+		if (!md.eval.isNull())
+			list[i] = moveComment(md, board.data());
+		board->makeMove(move);
+	}
+
+	return list;
+}
+
+qint64 PgnGame::memoryUsage() const
+{
+	qint64 bytes = sizeof(PgnGame)
+		     + m_tags.memoryUsage()
+		     + m_moves.capacity() * sizeof(MoveData)
+		     + m_initialComment.capacity() * sizeof(QChar);
+	for (const MoveData& move : m_moves)
+	{
+		bytes += (move.moveString.capacity()
+			  + move.comment.capacity()
+			  + move.eval.pv.capacity()) * sizeof(QChar);
+	}
+	return bytes;
+}
+
+QString PgnGame::moveComment(const MoveData& move, Chess::Board* board)
+{
+	if (move.eval.isNull())
+		return move.comment;
+
+	QString str(evalText(move.eval, board));
+	if (!move.comment.isEmpty())
+		str += ' ' + move.comment;
+	return str;
+}
+
 bool PgnGame::isStandard() const
 {
 	return variant() == "standard" && !m_tags.contains("FEN");
@@ -360,37 +503,37 @@ QString PgnGame::tagValue(const QString& tag) const
 
 QString PgnGame::event() const
 {
-	return m_tags.value("Event");
+	return m_tags.value(PgnTagList::Event);
 }
 
 QString PgnGame::site() const
 {
-	return m_tags.value("Site");
+	return m_tags.value(PgnTagList::Site);
 }
 
 QDate PgnGame::date() const
 {
-	return QDate::fromString(m_tags.value("Date"), "yyyy.MM.dd");
+	return QDate::fromString(m_tags.value(PgnTagList::Date), "yyyy.MM.dd");
 }
 
 int PgnGame::round() const
 {
-	return m_tags.value("Round").toInt();
+	return m_tags.value(PgnTagList::Round).toInt();
 }
 
 QString PgnGame::playerName(Chess::Side side) const
 {
 	if (side == Chess::Side::White)
-		return m_tags.value("White");
+		return m_tags.value(PgnTagList::White);
 	else if (side == Chess::Side::Black)
-		return m_tags.value("Black");
+		return m_tags.value(PgnTagList::Black);
 
 	return QString();
 }
 
 Chess::Result PgnGame::result() const
 {
-	return Chess::Result(m_tags.value("Result"));
+	return Chess::Result(m_tags.value(PgnTagList::Result));
 }
 
 QString PgnGame::variant() const
@@ -416,10 +559,7 @@ QString PgnGame::startingFenString() const
 
 void PgnGame::setTag(const QString& tag, const QString& value)
 {
-	if (value.isEmpty())
-		m_tags.remove(tag);
-	else
-		m_tags[tag] = value;
+	m_tags.setValue(tag, value);
 
 	if (m_tagReceiver)
 		QMetaObject::invokeMethod(m_tagReceiver, "setTag",
@@ -525,6 +665,16 @@ void PgnGame::setStartingFenString(Chess::Side side, const QString& fen)
 	}
 }
 
+QString PgnGame::initialComment() const
+{
+	return m_initialComment;
+}
+
+void PgnGame::setInitialComment(const QString& comment)
+{
+	m_initialComment = comment;
+}
+
 void PgnGame::setResultDescription(const QString& description)
 {
 	if (description.isEmpty())
@@ -535,6 +685,8 @@ void PgnGame::setResultDescription(const QString& description)
 		return;
 	}
 
+	// An evaluation is joined with the rest of the comment when it's
+	// formatted, so the description can just follow it
 	QString& comment = m_moves.last().comment;
 	if (!comment.isEmpty())
 	{
@@ -20,6 +20,7 @@
 
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QList>
 #include <QPair>
@@ -27,6 +28,7 @@
 #include <climits>
 #include "board/genericmove.h"
 #include "board/result.h"
+#include "pgntaglist.h"
 class QTextStream;
 class PgnStream;
 class EcoNode;
@@ -60,6 +62,38 @@ class LIB_EXPORT PgnGame
 			Verbose
 		};
 
+		/*!
+		 * \brief An engine's search data for a move.
+		 *
+		 * The data is stored as is while the game is played and
+		 * formatted into a comment by moveComment() only when it's
+		 * needed, eg. when the game is written.
+		 */
+		struct EvalData
+		{
+			/*! Creates a null EvalData object. */
+			EvalData();
+			/*! Returns true if the object holds no data. */
+			bool isNull() const;
+
+			/*! Score from the moving side's point of view. */
+			qint32 score;
+			/*! Search depth, or -1 for a null object. */
+			qint16 depth;
+			/*! Time used for the move in milliseconds. */
+			qint32 moveTime;
+			/*! The moving side's time left in milliseconds. */
+			qint32 timeLeft;
+			/*! Number of nodes searched. */
+			quint64 nodes;
+			/*! Search speed in nodes per second. */
+			quint64 nps;
+			/*! Number of tablebase hits. */
+			quint64 tbHits;
+			/*! Principal variation in the engine's move notation. */
+			QString pv;
+		};
+
 		/*! \brief A struct for storing the game's move history. */
 		struct MoveData
 		{
@@ -69,8 +103,14 @@ class LIB_EXPORT PgnGame
 			Chess::GenericMove move;
 			/*! The move in Standard Algebraic Notation. */
 			QString moveString;
-			/*! A comment/annotation describing the move. */
+			/*!
+			 * A comment/annotation describing the move.
+			 * If \a eval is not null this is the text that follows
+			 * the formatted evaluation.
+			 */
 			QString comment;
+			/*! The engine's search data for the move. */
+			EvalData eval;
 		};
 
 		/*! Creates a new PgnGame object. */
@@ -128,6 +168,25 @@ class LIB_EXPORT PgnGame
 		 */
 		bool write(const QString& filename, PgnMode mode = Verbose) const;
 		
+		/*!
+		 * Returns the full comments of the game's moves, including
+		 * formatted evaluations.
+		 */
+		QStringList comments() const;
+		/*!
+		 * Returns an estimate of the memory used by the game's
+		 * tags and moves in bytes.
+		 */
+		qint64 memoryUsage() const;
+		/*!
+		 * Returns the full comment of \a move, including its formatted
+		 * evaluation.
+		 *
+		 * \a board must be in the position before the move. The
+		 * evaluation's PV is converted to Standard Algebraic Notation.
+		 */
+		static QString moveComment(const MoveData& move, Chess::Board* board);
+
 		/*!
 		 * Returns true if the game's variant is "standard" and it's
 		 * played from the default starting position; otherwise
@@ -183,6 +242,10 @@ class LIB_EXPORT PgnGame
 		void setStartingSide(Chess::Side side);
 		/*! Sets the starting position's FEN string. */
 		void setStartingFenString(Chess::Side side, const QString& fen);
+		/*! Returns the comment that precedes the first move. */
+		QString initialComment() const;
+		/*! Sets the comment that precedes the first move to \a comment. */
+		void setInitialComment(const QString& comment);
 		/*!
 		 * Sets a description for the result.
 		 *
@@ -207,7 +270,7 @@ class LIB_EXPORT PgnGame
 		
 		Chess::Side m_startingSide;
 		const EcoNode* m_eco;
-		QMap<QString, QString> m_tags;
+		PgnTagList m_tags;
 		QVector<MoveData> m_moves;
 		QObject* m_tagReceiver;
 		QString m_initialComment;
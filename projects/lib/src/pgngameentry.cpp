@@ -16,63 +16,129 @@
 */
 
 #include "pgngameentry.h"
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <QDataStream>
 #include <QMap>
 #include "pgnstream.h"
 #include "pgngamefilter.h"
+#include "pgntagpool.h"
 
 namespace {
 
-int s_stringContains(const char* s1, const char* s2, int size)
+int s_stringToInt(const char *s, int size)
 {
-	Q_ASSERT(s1 != nullptr);
-	Q_ASSERT(s2 != nullptr);
-	Q_ASSERT(size >= 0);
+	int num = 0;
+	for (int i = 0; i < size; i++)
+	{
+		if (!isdigit(s[i]))
+			return 0;
+		num = num * 10 + (s[i] - '0');
+	}
 
-	if (!*s2)
-		return 0;
-	if (size == 0)
-		return -1;
+	return num;
+}
 
-	const char* s1_end = s1 + size;
+const quint64 s_fnvOffset = Q_UINT64_C(14695981039346656037);
+const quint64 s_fnvPrime = Q_UINT64_C(1099511628211);
 
-	while (s1 < s1_end)
+void skipMoveTextSection(PgnStream& in, char start)
+{
+	char end = '\n';
+	if (start == '(')
+		end = ')';
+	else if (start == '{')
+		end = '}';
+	else
+		start = 0;
+
+	int level = 1;
+	char c;
+	while ((c = in.readChar()) != 0)
 	{
-		if (toupper(*s1) == toupper(*s2))
-		{
-			const char* a = s1 + 1;
-			const char* b = s2 + 1;
-
-			while (*b && a < s1_end)
-			{
-				if (toupper(*a) != toupper(*b))
-					break;
-				a++;
-				b++;
-			}
-			if (!*b)
-				return b - s2;
-			if (a == s1_end)
-				return -1;
-		}
-		s1++;
+		if (c == end && --level == 0)
+			break;
+		if (c == start)
+			level++;
 	}
+}
 
-	return -1;
+bool isMoveToken(const QByteArray& token)
+{
+	if (token.isEmpty() || token.at(0) == '$' || token == "*"
+	||  token == "1-0" || token == "0-1" || token == "1/2-1/2")
+		return false;
+
+	// Move numbers
+	for (char c : token)
+	{
+		if (!isdigit(c))
+			return true;
+	}
+	return false;
 }
 
-int s_stringToInt(const char *s, int size)
+/*
+ * Reads the movetext of a game and returns a hash of its moves, or
+ * 0 if the game has no moves. Move numbers, results, comments,
+ * variations and annotation glyphs don't change the hash.
+ */
+quint64 hashMoveText(PgnStream& in)
 {
-	int num = 0;
-	for (int i = 0; i < size; i++)
+	quint64 hash = s_fnvOffset;
+	bool haveMoves = false;
+	QByteArray token;
+
+	auto addToken = [&]()
 	{
-		if (!isdigit(s[i]))
-			return 0;
-		num = num * 10 + (s[i] - '0');
+		int size = token.size();
+		while (size > 0 && strchr("!?+#", token.at(size - 1)) != nullptr)
+			size--;
+		token.resize(size);
+
+		if (isMoveToken(token))
+		{
+			for (char c : token)
+				hash = (hash ^ uchar(c)) * s_fnvPrime;
+			hash = (hash ^ uchar(' ')) * s_fnvPrime;
+			haveMoves = true;
+		}
+		token.resize(0);
+	};
+
+	char c;
+	while ((c = in.readChar()) != 0)
+	{
+		switch (c)
+		{
+		case '[':
+			// The tags of the next game
+			in.rewindChar();
+			addToken();
+			return haveMoves ? qMax(hash, quint64(1)) : 0;
+		case '(':
+		case '{':
+		case ';':
+		case '%':
+			addToken();
+			skipMoveTextSection(in, c);
+			break;
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+		case '.':
+			addToken();
+			break;
+		default:
+			token += c;
+			break;
+		}
 	}
 
-	return num;
+	addToken();
+	return haveMoves ? qMax(hash, quint64(1)) : 0;
 }
 
 } // anonymous namespace
@@ -95,41 +161,57 @@ QDataStream& operator<<(QDataStream& out, const PgnGameEntry& entry)
 	return out;
 }
 
-PgnGameEntry::PgnGameEntry()
-	: m_pos(0),
-	  m_lineNumber(1)
+PgnGameEntry::PgnGameEntry(PgnTagPool* tagPool)
+	: m_tagPool(tagPool),
+	  m_pos(0),
+	  m_lineNumber(1),
+	  m_moveHash(0)
 {
+	Q_ASSERT(tagPool != nullptr);
+	std::fill(m_tags, m_tags + TagCount, 0);
 }
 
 bool PgnGameEntry::match(const PgnGameFilter& filter) const
 {
-	const char* data = m_data.constData();
+	return match(PgnTagMatcher(filter, *m_tagPool));
+}
+
+bool PgnGameEntry::match(const PgnTagMatcher& matcher) const
+{
+	const PgnGameFilter& filter = matcher.filter();
 
 	if (filter.type() == PgnGameFilter::FixedString)
-		return s_stringContains(data, filter.pattern(), m_data.size()) != -1;
+	{
+		for (int type = 0; type < TagCount; type++)
+		{
+			if (matcher.matchesPattern(m_tags[type]))
+				return true;
+		}
+		return false;
+	}
 
 	int whitePlayer = 0;
 
-	int i = 0;
-	for (int type = 0; type < 8; type++)
+	for (int type = 0; type < TagCount; type++)
 	{
-		int size = data[i++];
-		const char* str = data + i;
+		const quint32 id = m_tags[type];
 
 		switch (type)
 		{
 		case EventTag:
-			if (s_stringContains(str, filter.event(), size) == -1)
+			if (!matcher.matchesEvent(id))
 				return false;
 			break;
 		case SiteTag:
-			if (s_stringContains(str, filter.site(), size) == -1)
+			if (!matcher.matchesSite(id))
 				return false;
 			break;
 		case DateTag:
 			if (!filter.minDate().isNull() || !filter.maxDate().isNull())
 			{
-				if (size < 10)
+				const QByteArray value(m_tagPool->value(id));
+				const char* str = value.constData();
+				if (value.size() < 10)
 					return false;
 
 				int year = s_stringToInt(str, 4);
@@ -152,7 +234,9 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 		case RoundTag:
 			if (filter.minRound() != 0 || filter.maxRound() != 0)
 			{
-				int round = s_stringToInt(str, size);
+				const QByteArray value(m_tagPool->value(id));
+				int round = s_stringToInt(value.constData(),
+							  value.size());
 
 				if (round == 0
 				||  (filter.minRound() != 0 && round < filter.minRound())
@@ -166,9 +250,9 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 				int len2 = -1;
 
 				if (filter.playerSide() != Chess::Side::Black)
-					len1 = s_stringContains(str, filter.player(), size);
+					len1 = matcher.matchPlayer(id);
 				if (filter.playerSide() != Chess::Side::White)
-					len2 = s_stringContains(str, filter.opponent(), size);
+					len2 = matcher.matchOpponent(id);
 
 				if (len1 == -1 && len2 == -1)
 					return false;
@@ -181,9 +265,9 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 				int len2 = -1;
 
 				if (filter.playerSide() != Chess::Side::White && whitePlayer != 1)
-					len1 = s_stringContains(str, filter.player(), size);
+					len1 = matcher.matchPlayer(id);
 				if (filter.playerSide() != Chess::Side::Black && whitePlayer != 2)
-					len2 = s_stringContains(str, filter.opponent(), size);
+					len2 = matcher.matchOpponent(id);
 
 				if (len1 == -1 && len2 == -1)
 					return false;
@@ -194,7 +278,7 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 			if (filter.result() == PgnGameFilter::AnyResult)
 				break;
 
-			Chess::Result result(QString::fromLatin1(str, size));
+			Chess::Result result(QString::fromLatin1(m_tagPool->value(id)));
 			int winner = 0;
 
 			if (!result.winner().isNull())
@@ -246,25 +330,24 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 		default:
 			break;
 		}
-		i += size;
 	}
 
 	return true;
 }
 
-void PgnGameEntry::addTag(const QByteArray& tagValue)
+void PgnGameEntry::setTag(TagType type, const QByteArray& tagValue)
 {
-	int size = qMin(127, tagValue.size());
-
-	m_data.append(char(size));
-	m_data.append(tagValue.constData(), size);
+	// Values are limited to 127 characters to keep the packed
+	// format of write() intact
+	m_tags[type] = m_tagPool->intern(tagValue.left(127));
 }
 
 void PgnGameEntry::clear()
 {
 	m_pos = 0;
 	m_lineNumber = 1;
-	m_data.clear();
+	m_moveHash = 0;
+	std::fill(m_tags, m_tags + TagCount, 0);
 }
 
 bool PgnGameEntry::read(PgnStream& in)
@@ -274,7 +357,6 @@ bool PgnGameEntry::read(PgnStream& in)
 
 	m_pos = in.pos();
 	m_lineNumber = in.lineNumber();
-	m_data.clear();
 
 	char c;
 	QByteArray tagName;
@@ -323,14 +405,16 @@ bool PgnGameEntry::read(PgnStream& in)
 			tagValue += c;
 	}
 
-	addTag(tags["Event"]);
-	addTag(tags["Site"]);
-	addTag(tags["Date"]);
-	addTag(tags["Round"]);
-	addTag(tags["White"]);
-	addTag(tags["Black"]);
-	addTag(tags["Result"]);
-	addTag(tags["Variant"]);
+	setTag(EventTag, tags["Event"]);
+	setTag(SiteTag, tags["Site"]);
+	setTag(DateTag, tags["Date"]);
+	setTag(RoundTag, tags["Round"]);
+	setTag(WhiteTag, tags["White"]);
+	setTag(BlackTag, tags["Black"]);
+	setTag(ResultTag, tags["Result"]);
+	setTag(VariantTag, tags["Variant"]);
+
+	m_moveHash = hashMoveText(in);
 
 	return true;
 }
@@ -340,11 +424,30 @@ bool PgnGameEntry::read(QDataStream& in)
 	// modifying this function can cause backward compatibility issues
 	// in other programs.
 
+	QByteArray data;
 	in >> m_pos;
 	in >> m_lineNumber;
-	in >> m_data;
+	in >> data;
+	m_moveHash = 0;
 
-	return in.status() == QDataStream::Ok;
+	if (in.status() != QDataStream::Ok)
+		return false;
+
+	// The tags are packed as a size byte followed by the value
+	int i = 0;
+	for (int type = 0; type < TagCount; type++)
+	{
+		if (i >= data.size())
+			return false;
+		const int size = data.at(i++);
+		if (size < 0 || i + size > data.size())
+			return false;
+
+		setTag(TagType(type), data.mid(i, size));
+		i += size;
+	}
+
+	return true;
 }
 
 void PgnGameEntry::write(QDataStream& out) const
@@ -352,9 +455,17 @@ void PgnGameEntry::write(QDataStream& out) const
 	// modifying this function can cause backward compatibility issues
 	// in other programs.
 
+	QByteArray data;
+	for (int type = 0; type < TagCount; type++)
+	{
+		const QByteArray value(m_tagPool->value(m_tags[type]));
+		data.append(char(value.size()));
+		data.append(value);
+	}
+
 	out << m_pos;
 	out << m_lineNumber;
-	out << m_data;
+	out << data;
 }
 
 qint64 PgnGameEntry::pos() const
@@ -367,14 +478,25 @@ qint64 PgnGameEntry::lineNumber() const
 	return m_lineNumber;
 }
 
-QString PgnGameEntry::tagValue(TagType type) const
+quint64 PgnGameEntry::moveHash() const
 {
-	int i = 0;
-	for (int j = 0; j < type; j++)
-		i += m_data[i] + 1;
+	return m_moveHash;
+}
 
-	int size = m_data[i];
-	if (size == 0)
+QString PgnGameEntry::tagValue(TagType type) const
+{
+	const QByteArray value(m_tagPool->value(m_tags[type]));
+	if (value.isEmpty())
 		return QString();
-	return m_data.mid(i + 1, size);
+	return value;
+}
+
+quint32 PgnGameEntry::tagId(TagType type) const
+{
+	return m_tags[type];
+}
+
+const PgnTagPool* PgnGameEntry::tagPool() const
+{
+	return m_tagPool;
 }
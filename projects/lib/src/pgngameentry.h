@@ -22,6 +22,8 @@
 #include "board/result.h"
 class PgnStream;
 class PgnGameFilter;
+class PgnTagPool;
+class PgnTagMatcher;
 class QDataStream;
 
 
@@ -32,9 +34,10 @@ class QDataStream;
  * the position and line number in a PGN stream.
  * This class was designed for high-performance and low memory
  * consumption, which is useful for quickly loading large game
- * collections.
+ * collections. The tag values are stored in a PgnTagPool that
+ * is shared by all entries of a collection.
  *
- * \sa PgnGame, PgnStream
+ * \sa PgnGame, PgnStream, PgnTagPool
  */
 class LIB_EXPORT PgnGameEntry
 {
@@ -52,8 +55,13 @@ class LIB_EXPORT PgnGameEntry
 			VariantTag	//!< The chess variant of the game
 		};
 
-		/*! Creates a new empty PgnGameEntry object. */
-		PgnGameEntry();
+		/*!
+		 * Creates a new empty PgnGameEntry object whose tag
+		 * values are stored in \a tagPool.
+		 *
+		 * \note \a tagPool must outlive the entry.
+		 */
+		explicit PgnGameEntry(PgnTagPool* tagPool);
 
 		/*! Resets the entry to an empty default. */
 		void clear();
@@ -77,24 +85,55 @@ class LIB_EXPORT PgnGameEntry
 		/*!
 		 * Returns true if the PGN tags match \a filter.
 		 * The matching is case insensitive.
+		 *
+		 * \note This function looks up the filter in the tag pool
+		 * on every call. Use a PgnTagMatcher to match many entries.
 		 */
 		bool match(const PgnGameFilter& filter) const;
+		/*!
+		 * Returns true if the PGN tags match \a matcher, which must
+		 * have been created for the tag pool of this entry.
+		 */
+		bool match(const PgnTagMatcher& matcher) const;
 
 		/*! Returns the stream position where the game begins. */
 		qint64 pos() const;
 		/*! Returns the line number where the game begins. */
 		qint64 lineNumber() const;
+		/*!
+		 * Returns a 64-bit hash of the game's moves, or 0 if the
+		 * game has no moves or the entry wasn't read from a PGN
+		 * stream.
+		 *
+		 * The hash ignores move numbers, comments, variations and
+		 * annotations, so games with the same moves usually have
+		 * the same hash. Equal hashes don't guarantee equal moves.
+		 */
+		quint64 moveHash() const;
 
 		/*! Returns the tag value corresponding to \a type. */
 		QString tagValue(TagType type) const;
+		/*!
+		 * Returns the ID of the tag value corresponding to \a type
+		 * in tagPool().
+		 */
+		quint32 tagId(TagType type) const;
+		/*! Returns the pool where the tag values are stored. */
+		const PgnTagPool* tagPool() const;
 
 	private:
-		void addTag(const QByteArray& tagValue);
+		friend class PgnEntryIndex;
+
+		enum { TagCount = VariantTag + 1 };
+
+		void setTag(TagType type, const QByteArray& tagValue);
 
-		QByteArray m_data;
+		PgnTagPool* m_tagPool;
+		quint32 m_tags[TagCount];
 
 		qint64 m_pos;
 		qint64 m_lineNumber;
+		quint64 m_moveHash;
 };
 
 /*! Reads a PGN game entry from a PGN stream. */
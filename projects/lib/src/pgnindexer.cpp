@@ -0,0 +1,171 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnindexer.h"
+#include <algorithm>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include "pgnstream.h"
+#include "gzipdevice.h"
+
+namespace {
+
+// Files smaller than this are scanned on a single thread
+const qint64 s_minChunkSize = 4 * 1024 * 1024;
+
+class ChunkTask : public QRunnable
+{
+	public:
+		ChunkTask(const std::function<void (int)>& function, int index)
+			: m_function(function),
+			  m_index(index)
+		{
+		}
+
+		void run() override
+		{
+			m_function(m_index);
+		}
+
+	private:
+		const std::function<void (int)>& m_function;
+		int m_index;
+};
+
+} // anonymous namespace
+
+PgnIndexer::PgnIndexer(QFile* file)
+	: m_file(file),
+	  m_map(nullptr),
+	  m_data(nullptr),
+	  m_size(0)
+{
+	Q_ASSERT(file != nullptr);
+
+	const qint64 size = file->size();
+	if (file->isOpen() && size > 0)
+		m_map = file->map(0, size);
+
+	// Compressed files have to be read sequentially
+	if (m_map != nullptr
+	&&  GzipDevice::isGzip(reinterpret_cast<const char*>(m_map), size))
+	{
+		file->unmap(m_map);
+		m_map = nullptr;
+	}
+	if (m_map != nullptr)
+	{
+		m_data = reinterpret_cast<const char*>(m_map);
+		m_size = size;
+	}
+}
+
+PgnIndexer::~PgnIndexer()
+{
+	if (m_map != nullptr)
+		m_file->unmap(m_map);
+}
+
+bool PgnIndexer::isValid() const
+{
+	return m_map != nullptr;
+}
+
+QVector<PgnIndexer::Chunk> PgnIndexer::chunks(int maxCount) const
+{
+	static const char s_eventTag[] = "\n[Event ";
+
+	QVector<Chunk> chunks;
+	if (m_size == 0)
+		return chunks;
+
+	if (maxCount <= 0)
+		maxCount = QThread::idealThreadCount();
+	const int count = int(qBound(qint64(1),
+				     m_size / s_minChunkSize,
+				     qint64(qMax(1, maxCount))));
+
+	// Move each nominal split point forward to the next game
+	const char* end = m_data + m_size;
+	Chunk chunk = { 0, m_size, 1 };
+	for (int i = 1; i < count; i++)
+	{
+		const qint64 from = m_size * i / count;
+		if (from <= chunk.begin)
+			continue;
+
+		const char* next = std::search(m_data + from, end,
+			s_eventTag, s_eventTag + sizeof(s_eventTag) - 1);
+		if (next == end)
+			break;
+
+		chunk.end = next - m_data + 1;
+		chunks.append(chunk);
+		chunk.begin = chunk.end;
+		chunk.end = m_size;
+	}
+	chunks.append(chunk);
+
+	// Count the lines of each chunk in parallel
+	QVector<qint64> lineCounts(chunks.size());
+	runParallel(chunks.size(), [&](int i)
+	{
+		const Chunk& c = chunks.at(i);
+		lineCounts[i] = std::count(m_data + c.begin,
+					   m_data + c.end, '\n');
+	});
+	for (int i = 1; i < chunks.size(); i++)
+	{
+		chunks[i].lineNumber = chunks.at(i - 1).lineNumber
+				     + lineCounts.at(i - 1);
+	}
+
+	return chunks;
+}
+
+void PgnIndexer::scan(const QVector<Chunk>& chunks,
+		      const ScanFunction& function) const
+{
+	runParallel(chunks.size(), [&](int i)
+	{
+		const Chunk& chunk = chunks.at(i);
+		PgnStream stream;
+		stream.setData(m_data, m_size);
+		if (stream.seek(chunk.begin, chunk.lineNumber))
+			function(stream, chunk, i);
+	});
+}
+
+void PgnIndexer::runParallel(int count,
+			     const std::function<void (int)>& function) const
+{
+	if (count == 1)
+	{
+		function(0);
+		return;
+	}
+
+	// A private pool, because the caller may itself be running
+	// in the global thread pool
+	QThreadPool pool;
+	pool.setMaxThreadCount(qMin(count, QThread::idealThreadCount()));
+	for (int i = 0; i < count; i++)
+		pool.start(new ChunkTask(function, i));
+	pool.waitForDone();
+}
@@ -0,0 +1,104 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNINDEXER_H
+#define PGNINDEXER_H
+
+#include <functional>
+#include <QVector>
+class QFile;
+class PgnStream;
+
+
+/*!
+ * \brief Scans a PGN file on multiple threads.
+ *
+ * PgnIndexer maps a PGN file into memory and splits it into chunks
+ * that begin at "[Event" tags. Each chunk is scanned on a thread pool
+ * with its own PgnStream, which is positioned at the start of the
+ * chunk with the correct line number. This means that the positions
+ * and line numbers reported by the streams are valid for the whole
+ * file, and the results can be merged in chunk order without any
+ * adjustment.
+ *
+ * \sa PgnStream
+ */
+class LIB_EXPORT PgnIndexer
+{
+	public:
+		/*! A contiguous part of the input data. */
+		struct Chunk
+		{
+			qint64 begin;      //!< Offset of the first byte
+			qint64 end;        //!< Offset past the last byte
+			qint64 lineNumber; //!< Line number at \a begin
+		};
+
+		/*!
+		 * A function that scans \a chunk with \a stream.
+		 *
+		 * \a index is the index of the chunk in file order. The
+		 * function should stop when it finds a game that begins at
+		 * or after the end of the chunk, because that game belongs
+		 * to the next chunk.
+		 */
+		typedef std::function<void (PgnStream& stream,
+					    const Chunk& chunk,
+					    int index)> ScanFunction;
+
+		/*!
+		 * Creates a new indexer for \a file.
+		 *
+		 * \a file must be open and it must stay open for the
+		 * lifetime of the indexer.
+		 */
+		explicit PgnIndexer(QFile* file);
+		/*! Destroys the indexer and unmaps the file. */
+		~PgnIndexer();
+
+		/*!
+		 * Returns true if the file was mapped successfully;
+		 * otherwise returns false. Compressed files are not
+		 * mapped.
+		 */
+		bool isValid() const;
+
+		/*!
+		 * Splits the file into at most \a maxCount chunks.
+		 *
+		 * If \a maxCount is 0 or less, the ideal thread count of
+		 * the system is used. Small files are never split.
+		 */
+		QVector<Chunk> chunks(int maxCount = 0) const;
+		/*!
+		 * Calls \a function for every chunk in \a chunks on a
+		 * thread pool and returns when all of them are done.
+		 */
+		void scan(const QVector<Chunk>& chunks,
+			  const ScanFunction& function) const;
+
+	private:
+		void runParallel(int count,
+				 const std::function<void (int)>& function) const;
+
+		QFile* m_file;
+		uchar* m_map;
+		const char* m_data;
+		qint64 m_size;
+};
+
+#endif // PGNINDEXER_H
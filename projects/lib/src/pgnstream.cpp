@@ -16,13 +16,47 @@
 */
 
 #include "pgnstream.h"
+#include <algorithm>
 #include <cctype>
 #include <cstring>
-#include <QIODevice>
+#include <QFile>
 #include "board/boardfactory.h"
+#include "gzipdevice.h"
 
 namespace {
 
+// Size of the blocks read from a device
+const int s_blockSize = 64 * 1024;
+
+// Returns the first character in [p, end) that is in chars or a null
+// character, or end if there isn't one
+const char* findAny(const char* p, const char* end, const char* chars)
+{
+	// strchr() also finds the terminating null character
+	while (p != end && strchr(chars, *p) == nullptr)
+		++p;
+	return p;
+}
+
+// Returns the first bracket opening or closing a comment, or a null
+// character, in [p, end), or end if there isn't one
+const char* findBracket(const char* p, const char* end,
+			char opBracket, char clBracket)
+{
+	// The closing bracket is usually near, which limits the range
+	// searched for the rarer characters
+	auto stop = static_cast<const char*>(memchr(p, clBracket, end - p));
+	if (stop == nullptr)
+		stop = end;
+	for (char c : { opBracket, '\0' })
+	{
+		auto q = static_cast<const char*>(memchr(p, c, stop - p));
+		if (q != nullptr)
+			stop = q;
+	}
+	return stop;
+}
+
 void skipSection(PgnStream* in, char start)
 {
 	char end;
@@ -59,26 +93,35 @@ void skipSection(PgnStream* in, char start)
 PgnStream::PgnStream(const QString& variant)
 	: m_board(nullptr),
 	  m_pos(0),
+	  m_bufferPos(0),
 	  m_lineNumber(1),
-	  m_lastChar(0),
 	  m_tokenType(NoToken),
 	  m_device(nullptr),
 	  m_string(nullptr),
+	  m_file(nullptr),
+	  m_gzip(nullptr),
+	  m_data(nullptr),
+	  m_size(0),
 	  m_status(Ok),
-	  m_phase(OutOfGame)
+	  m_phase(OutOfGame),
+	  m_trustedMoves(false)
 {
 	setVariant(variant);
 }
 
 PgnStream::PgnStream(QIODevice* device, const QString& variant)
-	: m_board(nullptr)
+	: m_board(nullptr),
+	  m_gzip(nullptr),
+	  m_trustedMoves(false)
 {
 	setVariant(variant);
 	setDevice(device);
 }
 
 PgnStream::PgnStream(const QByteArray* string, const QString& variant)
-	: m_board(nullptr)
+	: m_board(nullptr),
+	  m_gzip(nullptr),
+	  m_trustedMoves(false)
 {
 	setVariant(variant);
 	setString(string);
@@ -86,20 +129,27 @@ PgnStream::PgnStream(const QByteArray* string, const QString& variant)
 
 PgnStream::~PgnStream()
 {
+	delete m_gzip;
 	delete m_board;
 }
 
 void PgnStream::reset()
 {
 	m_pos = 0;
+	m_bufferPos = 0;
 	m_lineNumber = 1;
-	m_lastChar = 0;
 	m_tokenString.clear();
 	m_tagName.clear();
 	m_tagValue.clear();
 	m_tokenType = NoToken;
 	m_device = nullptr;
 	m_string = nullptr;
+	m_file = nullptr;
+	delete m_gzip;
+	m_gzip = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+	m_buffer.clear();
 	m_status = Ok;
 	m_phase = OutOfGame;
 }
@@ -111,6 +161,10 @@ Chess::Board* PgnStream::board()
 
 QIODevice* PgnStream::device() const
 {
+	if (m_file)
+		return m_file;
+	if (m_gzip)
+		return m_gzip->device();
 	return m_device;
 }
 
@@ -119,6 +173,17 @@ void PgnStream::setDevice(QIODevice* device)
 	Q_ASSERT(device != nullptr);
 
 	reset();
+	if (device->isOpen() && GzipDevice::isGzip(device))
+	{
+		m_gzip = new GzipDevice(device);
+		if (m_gzip->open(QIODevice::ReadOnly))
+		{
+			m_device = m_gzip;
+			return;
+		}
+		delete m_gzip;
+		m_gzip = nullptr;
+	}
 	m_device = device;
 }
 
@@ -130,10 +195,43 @@ const QByteArray* PgnStream::string() const
 void PgnStream::setString(const QByteArray* string)
 {
 	Q_ASSERT(string != nullptr);
-	reset();
+	setData(string->constData(), string->size());
 	m_string = string;
 }
 
+void PgnStream::setData(const char* data, qint64 size)
+{
+	Q_ASSERT(data != nullptr || size == 0);
+	reset();
+	m_data = data;
+	m_size = size;
+}
+
+bool PgnStream::setMappedFile(QFile* file)
+{
+	Q_ASSERT(file != nullptr);
+
+	reset();
+	const qint64 size = file->size();
+	if (!file->isOpen() || size <= 0)
+		return false;
+
+	uchar* data = file->map(0, size);
+	if (data == nullptr)
+		return false;
+	if (GzipDevice::isGzip(reinterpret_cast<const char*>(data), size))
+	{
+		file->unmap(data);
+		return false;
+	}
+
+	m_file = file;
+	m_data = reinterpret_cast<const char*>(data);
+	m_size = size;
+
+	return true;
+}
+
 QString PgnStream::variant() const
 {
 	Q_ASSERT(m_board != nullptr);
@@ -154,16 +252,26 @@ bool PgnStream::setVariant(const QString& variant)
 	return true;
 }
 
+bool PgnStream::trustedMoves() const
+{
+	return m_trustedMoves;
+}
+
+void PgnStream::setTrustedMoves(bool enabled)
+{
+	m_trustedMoves = enabled;
+}
+
 bool PgnStream::isOpen() const
 {
-	return (m_device && m_device->isOpen()) || m_string;
+	if (m_device)
+		return m_device->isOpen();
+	return m_data != nullptr;
 }
 
 qint64 PgnStream::pos() const
 {
-	if (m_device)
-		return m_device->pos();
-	return m_pos;
+	return m_bufferPos + m_pos;
 }
 
 qint64 PgnStream::lineNumber() const
@@ -171,32 +279,26 @@ qint64 PgnStream::lineNumber() const
 	return m_lineNumber;
 }
 
-char PgnStream::readChar()
+bool PgnStream::fillBuffer()
 {
-	char c;
-	if (m_device)
-	{
-		if (!m_device->getChar(&m_lastChar))
-		{
-			m_status = ReadPastEnd;
-			return 0;
-		}
-		c = m_lastChar;
-	}
-	else if (m_string && m_pos < m_string->size())
-	{
-		c = m_string->at(m_pos++);
-	}
-	else
-	{
-		m_status = ReadPastEnd;
-		return 0;
-	}
-
-	if (c == '\n')
-		m_lineNumber++;
+	if (m_device == nullptr)
+		return false;
 
-	return c;
+	// The last character of the previous block is kept so that it
+	// can be rewound
+	const int keep = (m_size > 0) ? 1 : 0;
+	if (keep > 0)
+		m_buffer[0] = m_data[m_size - 1];
+	m_bufferPos += m_size - keep;
+
+	m_buffer.resize(keep + s_blockSize);
+	const qint64 n = m_device->read(m_buffer.data() + keep, s_blockSize);
+	m_buffer.resize(keep + int(qMax(n, qint64(0))));
+	m_data = m_buffer.constData();
+	m_size = m_buffer.size();
+	m_pos = keep;
+
+	return n > 0;
 }
 
 void PgnStream::rewind()
@@ -206,21 +308,11 @@ void PgnStream::rewind()
 
 void PgnStream::rewindChar()
 {
-	Q_ASSERT(pos() > 0);
-
-	char c;
-	if (m_device)
-	{
-		c = m_lastChar;
-		m_device->ungetChar(m_lastChar);
-		m_lastChar = 0;
-	}
-	else if (m_string)
-		c = m_string->at(m_pos--);
-	else
+	Q_ASSERT(m_pos > 0);
+	if (m_pos <= 0)
 		return;
 
-	if (c == '\n')
+	if (m_data[--m_pos] == '\n')
 		m_lineNumber--;
 }
 
@@ -232,12 +324,24 @@ bool PgnStream::seek(qint64 pos, qint64 lineNumber)
 	bool ok = false;
 	if (m_device)
 	{
-		ok = m_device->seek(pos);
-		m_pos = 0;
+		// A position in the buffered block needs no device seek
+		if (pos >= m_bufferPos && pos < m_bufferPos + m_size)
+		{
+			m_pos = pos - m_bufferPos;
+			ok = true;
+		}
+		else if (m_device->seek(pos))
+		{
+			m_data = nullptr;
+			m_size = 0;
+			m_pos = 0;
+			m_bufferPos = pos;
+			ok = true;
+		}
 	}
-	else if (m_string)
+	else if (m_data)
 	{
-		ok = pos < m_string->size();
+		ok = pos < m_size;
 		m_pos = pos;
 	}
 	if (!ok)
@@ -245,7 +349,6 @@ bool PgnStream::seek(qint64 pos, qint64 lineNumber)
 
 	m_status = Ok;
 	m_lineNumber = lineNumber;
-	m_lastChar = 0;
 	m_phase = OutOfGame;
 
 	return true;
@@ -260,12 +363,28 @@ void PgnStream::parseUntil(const char* chars)
 {
 	Q_ASSERT(chars != nullptr);
 
-	char c;
-	while ((c = readChar()) != 0)
+	for (;;)
 	{
-		if (strchr(chars, c))
-			break;
-		m_tokenString.append(c);
+		if (m_pos >= m_size && !fillBuffer())
+		{
+			m_status = ReadPastEnd;
+			return;
+		}
+
+		// The token is copied in pieces, one per buffered block
+		const char* start = m_data + m_pos;
+		const char* end = m_data + m_size;
+		const char* p = findAny(start, end, chars);
+		m_tokenString.append(start, int(p - start));
+		m_lineNumber += std::count(start, p, '\n');
+		m_pos += p - start;
+
+		// Consume the delimiter
+		if (p != end)
+		{
+			readChar();
+			return;
+		}
 	}
 }
 
@@ -334,18 +453,46 @@ void PgnStream::parseTag()
 void PgnStream::parseComment(char opBracket)
 {
 	int level = 1;
-	char clBracket = (opBracket == '(') ? ')' : '}';
+	const char clBracket = (opBracket == '(') ? ')' : '}';
 
-	char c;
-	while ((c = readChar()) != 0)
+	for (;;)
 	{
+		if (m_pos >= m_size && !fillBuffer())
+		{
+			m_status = ReadPastEnd;
+			return;
+		}
+
+		const char* start = m_data + m_pos;
+		const char* end = m_data + m_size;
+
+		// Leading newlines aren't part of the comment
+		if (m_tokenString.isEmpty())
+		{
+			while (start != end && *start == '\n')
+			{
+				++start;
+				m_lineNumber++;
+			}
+			m_pos = start - m_data;
+			if (start == end)
+				continue;
+		}
+
+		// Everything up to the next bracket is copied in one piece
+		const char* p = findBracket(start, end, opBracket, clBracket);
+		m_tokenString.append(start, int(p - start));
+		m_lineNumber += std::count(start, p, '\n');
+		m_pos = p - m_data;
+		if (p == end)
+			continue;
+
+		const char c = m_data[m_pos++];
+		if (c == 0 || (c == clBracket && --level <= 0))
+			return;
 		if (c == opBracket)
 			level++;
-		else if (c == clBracket && --level <= 0)
-			break;
-
-		if (c != '\n' || !m_tokenString.isEmpty())
-			m_tokenString.append(c);
+		m_tokenString.append(c);
 	}
 }
 
@@ -21,13 +21,19 @@
 #include <QtGlobal>
 #include <QString>
 class QIODevice;
+class QFile;
+class GzipDevice;
 namespace Chess { class Board; }
 
 
 /*!
  * \brief A class for reading games in PGN format from a text stream.
  *
- * PgnStream is used for reading PGN games from a QIODevice or a string.
+ * PgnStream is used for reading PGN games from a QIODevice, a string
+ * or a memory-mapped file. Gzip-compressed devices are decompressed
+ * on the fly. A device is read in large blocks into a buffer of the
+ * stream's own, so the stream must be the only reader of the device
+ * while it's in use.
  * It has its own input methods, and keeps track of the current line
  * number which can be used to report errors in the games. PgnStream
  * also has its own Chess::Board object, so that the same board can be
@@ -101,15 +107,53 @@ class LIB_EXPORT PgnStream
 		 */
 		Chess::Board* board();
 
-		/*! Returns the assigned device, or 0 if no device is in use. */
+		/*!
+		 * Returns the assigned device, or 0 if no device is in use.
+		 *
+		 * If the stream operates on a mapped file, the mapped
+		 * file is returned.
+		 */
 		QIODevice* device() const;
-		/*! Sets the current device to \a device. */
+		/*!
+		 * Sets the current device to \a device.
+		 *
+		 * If \a device is open and holds gzip-compressed data, the
+		 * stream reads it through a GzipDevice. The positions of the
+		 * stream are then uncompressed offsets.
+		 */
 		void setDevice(QIODevice* device);
 
 		/*! Returns the assigned string, or 0 if no string is in use. */
 		const QByteArray* string() const;
-		/*! Sets the current string to \a string. */
+		/*!
+		 * Sets the current string to \a string.
+		 *
+		 * \a string must not be modified while the stream is in use.
+		 */
 		void setString(const QByteArray* string);
+		/*!
+		 * Sets the current input to \a size bytes of \a data.
+		 *
+		 * The data is not copied, so it must stay valid and
+		 * unmodified while the stream is in use.
+		 */
+		void setData(const char* data, qint64 size);
+
+		/*!
+		 * Maps the whole of \a file into memory and reads the stream
+		 * directly from the mapping.
+		 *
+		 * This avoids the per-character overhead of QIODevice and
+		 * makes seek() a constant-time operation, which is useful for
+		 * large PGN databases. \a file must be open, and it must stay
+		 * open for as long as the stream is in use. The mapping is
+		 * released when \a file is closed or destroyed.
+		 *
+		 * Returns true if successful; otherwise returns false and
+		 * leaves the stream closed, in which case the caller can fall
+		 * back to setDevice(). Compressed files are never mapped.
+		 */
+		bool setMappedFile(QFile* file);
 
 		/*! Returns the chess variant. */
 		QString variant() const;
@@ -119,6 +163,26 @@ class LIB_EXPORT PgnStream
 		 */
 		bool setVariant(const QString& variant);
 
+		/*!
+		 * Returns true if the moves in the stream are known to be
+		 * legal; otherwise returns false.
+		 *
+		 * \sa setTrustedMoves()
+		 */
+		bool trustedMoves() const;
+		/*!
+		 * If \a enabled is true, the moves in the stream are known
+		 * to be legal SAN moves, eg. because Cute Chess wrote them.
+		 * They are then read with
+		 * Chess::Board::moveFromTrustedSanString(), which skips most
+		 * legality tests.
+		 *
+		 * The default is false. An illegal move in a trusted stream
+		 * may not be detected, so this mode should only be used for
+		 * files that haven't been edited by hand.
+		 */
+		void setTrustedMoves(bool enabled);
+
 		/*! Returns true if the stream is open. */
 		bool isOpen() const;
 
@@ -135,12 +199,12 @@ class LIB_EXPORT PgnStream
 		char readChar();
 		/*!
 		 * Rewinds the stream position by one character, which means that
-		 * the next time readChar() is called, nothing is read and the
-		 * buffer character is returned.
+		 * the next time readChar() is called, the same character is
+		 * read again.
 		 *
-		 * \note Only one character is kept in the buffer, so calling
-		 * this method multiple times in a row has the same effect as
-		 * calling it just once.
+		 * \note Only the last character read is guaranteed to be
+		 * available, so this method shouldn't be called multiple
+		 * times in a row.
 		 */
 		void rewindChar();
 		/*!
@@ -199,22 +263,46 @@ class LIB_EXPORT PgnStream
 			InGame
 		};
 
+		bool fillBuffer();
 		void parseUntil(const char* chars);
 		void parseTag();
 		void parseComment(char opBracket);
 
 		Chess::Board* m_board;
+		// Position in m_data, and the position of m_data in
+		// the stream
 		qint64 m_pos;
+		qint64 m_bufferPos;
 		qint64 m_lineNumber;
-		char m_lastChar;
 		QByteArray m_tokenString;
 		QByteArray m_tagName;
 		QByteArray m_tagValue;
 		TokenType m_tokenType;
 		QIODevice* m_device;
 		const QByteArray* m_string;
+		QFile* m_file;
+		GzipDevice* m_gzip;
+		// The input data, or the buffered block of a device
+		const char* m_data;
+		qint64 m_size;
+		QByteArray m_buffer;
 		Status m_status;
 		Phase m_phase;
+		bool m_trustedMoves;
 };
 
+inline char PgnStream::readChar()
+{
+	if (m_pos >= m_size && !fillBuffer())
+	{
+		m_status = ReadPastEnd;
+		return 0;
+	}
+
+	const char c = m_data[m_pos++];
+	if (c == '\n')
+		m_lineNumber++;
+	return c;
+}
+
 #endif // PGNSTREAM_H
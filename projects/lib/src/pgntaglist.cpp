@@ -0,0 +1,251 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgntaglist.h"
+#include <QHash>
+#include <QReadWriteLock>
+
+namespace {
+
+const char* const s_rosterNames[PgnTagList::RosterSize] =
+{
+	"Event", "Site", "Date", "Round", "White", "Black", "Result"
+};
+
+/*
+ * The process-wide table of tag names. The roster tags keep
+ * their enum values as IDs.
+ */
+class TagNames
+{
+	public:
+		TagNames()
+		{
+			for (const char* name : s_rosterNames)
+				add(QString::fromLatin1(name));
+		}
+
+		int find(const QString& name) const
+		{
+			QReadLocker locker(&m_lock);
+			return m_ids.value(name, -1);
+		}
+
+		int intern(const QString& name)
+		{
+			int id = find(name);
+			if (id != -1)
+				return id;
+
+			QWriteLocker locker(&m_lock);
+			id = m_ids.value(name, -1);
+			if (id == -1)
+				id = add(name);
+			return id;
+		}
+
+		QString name(int id) const
+		{
+			QReadLocker locker(&m_lock);
+			return m_names.value(id);
+		}
+
+	private:
+		int add(const QString& name)
+		{
+			Q_ASSERT(m_names.size() < 0xffff);
+
+			const int id = m_names.size();
+			m_names.append(name);
+			m_ids.insert(name, id);
+			return id;
+		}
+
+		mutable QReadWriteLock m_lock;
+		QVector<QString> m_names;
+		QHash<QString, int> m_ids;
+};
+
+TagNames& tagNames()
+{
+	static TagNames names;
+	return names;
+}
+
+} // anonymous namespace
+
+PgnTagList::PgnTagList()
+{
+}
+
+int PgnTagList::tagId(const QString& name)
+{
+	const int id = findTagId(name);
+	return (id != -1) ? id : tagNames().intern(name);
+}
+
+QString PgnTagList::tagName(int id)
+{
+	if (id >= 0 && id < RosterSize)
+		return QString::fromLatin1(s_rosterNames[id]);
+	return tagNames().name(id);
+}
+
+int PgnTagList::findTagId(const QString& name)
+{
+	// The roster tags are found without taking the lock
+	for (int i = 0; i < RosterSize; i++)
+	{
+		if (name == QLatin1String(s_rosterNames[i]))
+			return i;
+	}
+	return tagNames().find(name);
+}
+
+bool PgnTagList::isEmpty() const
+{
+	for (const Entry& entry : m_entries)
+	{
+		if (!entry.value.isEmpty())
+			return false;
+	}
+	return true;
+}
+
+void PgnTagList::clear()
+{
+	m_entries.clear();
+}
+
+bool PgnTagList::contains(const QString& name) const
+{
+	return !value(name).isEmpty();
+}
+
+QString PgnTagList::value(int id) const
+{
+	if (id < 0)
+		return QString();
+	if (id < RosterSize)
+		return (m_entries.size() > id) ? m_entries.at(id).value : QString();
+
+	const int index = extraIndex(id);
+	return (index != -1) ? m_entries.at(index).value : QString();
+}
+
+QString PgnTagList::value(const QString& name) const
+{
+	return value(findTagId(name));
+}
+
+void PgnTagList::setValue(int id, const QString& value)
+{
+	Q_ASSERT(id >= 0);
+
+	if (m_entries.isEmpty())
+	{
+		if (value.isEmpty())
+			return;
+
+		// The roster slots are created with the first tag
+		m_entries.reserve(RosterSize + 4);
+		for (int i = 0; i < RosterSize; i++)
+		{
+			const Entry entry = { quint16(i), QString() };
+			m_entries.append(entry);
+		}
+	}
+
+	if (id < RosterSize)
+	{
+		m_entries[id].value = value;
+		return;
+	}
+
+	const int index = extraIndex(id);
+	if (index != -1)
+	{
+		if (value.isEmpty())
+			m_entries.remove(index);
+		else
+			m_entries[index].value = value;
+		return;
+	}
+	if (value.isEmpty())
+		return;
+
+	// The extra tags are kept in alphabetical order
+	const QString name(tagName(id));
+	int pos = RosterSize;
+	while (pos < m_entries.size()
+	&&     tagName(m_entries.at(pos).id) < name)
+		pos++;
+
+	const Entry entry = { quint16(id), value };
+	m_entries.insert(pos, entry);
+}
+
+void PgnTagList::setValue(const QString& name, const QString& value)
+{
+	if (value.isEmpty())
+	{
+		// Removing an unknown tag doesn't intern its name
+		const int id = findTagId(name);
+		if (id != -1)
+			setValue(id, value);
+		return;
+	}
+	setValue(tagId(name), value);
+}
+
+QList< QPair<QString, QString> > PgnTagList::toList() const
+{
+	QList< QPair<QString, QString> > list;
+	for (int i = 0; i < RosterSize; i++)
+	{
+		QString val(value(i));
+		if (val.isEmpty())
+			val = "?";
+		list.append(qMakePair(tagName(i), val));
+	}
+
+	for (int i = RosterSize; i < m_entries.size(); i++)
+	{
+		const Entry& entry = m_entries.at(i);
+		list.append(qMakePair(tagName(entry.id), entry.value));
+	}
+
+	return list;
+}
+
+qint64 PgnTagList::memoryUsage() const
+{
+	qint64 bytes = m_entries.capacity() * sizeof(Entry);
+	for (const Entry& entry : m_entries)
+		bytes += entry.value.capacity() * sizeof(QChar);
+	return bytes;
+}
+
+int PgnTagList::extraIndex(int id) const
+{
+	for (int i = RosterSize; i < m_entries.size(); i++)
+	{
+		if (m_entries.at(i).id == id)
+			return i;
+	}
+	return -1;
+}
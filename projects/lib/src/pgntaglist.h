@@ -0,0 +1,116 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNTAGLIST_H
+#define PGNTAGLIST_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+
+/*!
+ * \brief A compact list of PGN tags.
+ *
+ * PgnTagList stores the tags of a PgnGame in one flat vector instead
+ * of a map. Tag names are interned process-wide and stored as 16-bit
+ * IDs. The tags of the Seven Tag Roster have fixed IDs and fixed slots
+ * at the start of the vector, so getting or setting them is an index
+ * operation. The other tags follow in the alphabetical order of their
+ * names.
+ *
+ * The vector is implicitly shared, so copying a tag list copies no
+ * data, and modifying a copy takes a single allocation.
+ *
+ * \sa PgnGame
+ */
+class LIB_EXPORT PgnTagList
+{
+	public:
+		/*! The tags of the Seven Tag Roster in their PGN order. */
+		enum RosterTag
+		{
+			Event,		//!< The name of the event
+			Site,		//!< The location of the event
+			Date,		//!< The starting date of the game
+			Round,		//!< The round of the game
+			White,		//!< The white player
+			Black,		//!< The black player
+			Result,		//!< The result of the game
+			RosterSize	//!< The number of roster tags
+		};
+
+		/*! Creates an empty tag list. */
+		PgnTagList();
+
+		/*!
+		 * Returns the ID of tag name \a name, interning the name
+		 * if it's new.
+		 */
+		static int tagId(const QString& name);
+		/*! Returns the name of the tag whose ID is \a id. */
+		static QString tagName(int id);
+
+		/*! Returns true if the list has no tags. */
+		bool isEmpty() const;
+		/*! Removes all tags. */
+		void clear();
+
+		/*! Returns true if the list has a tag named \a name. */
+		bool contains(const QString& name) const;
+		/*!
+		 * Returns the value of the tag whose ID is \a id, or an
+		 * empty string if there's no such tag.
+		 */
+		QString value(int id) const;
+		/*! \overload */
+		QString value(const QString& name) const;
+		/*!
+		 * Sets the value of the tag whose ID is \a id to \a value.
+		 * An empty \a value removes the tag.
+		 */
+		void setValue(int id, const QString& value);
+		/*! \overload */
+		void setValue(const QString& name, const QString& value);
+
+		/*!
+		 * Returns the (name, value) pairs of the tags, the Seven
+		 * Tag Roster first. Missing roster tags have the value "?".
+		 */
+		QList< QPair<QString, QString> > toList() const;
+
+		/*!
+		 * Returns an estimate of the memory used by the tags in
+		 * bytes, not counting the shared tag names.
+		 */
+		qint64 memoryUsage() const;
+
+	private:
+		struct Entry
+		{
+			quint16 id;
+			QString value;
+		};
+
+		static int findTagId(const QString& name);
+		int extraIndex(int id) const;
+
+		QVector<Entry> m_entries;
+};
+
+#endif // PGNTAGLIST_H
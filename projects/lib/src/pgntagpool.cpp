@@ -0,0 +1,215 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgntagpool.h"
+#if defined(__SSE2__) || defined(_M_X64) \
+ || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PGNTAGPOOL_SSE2
+#include <emmintrin.h>
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+// Folds the ASCII letters to upper case and leaves the other bytes,
+// including the bytes of multi-byte UTF-8 characters, alone
+inline char s_foldCase(char c)
+{
+	return (c >= 'a' && c <= 'z') ? char(c - ('a' - 'A')) : c;
+}
+
+QByteArray s_foldedPattern(const QByteArray& pattern)
+{
+	QByteArray folded(pattern);
+	for (int i = 0; i < folded.size(); i++)
+		folded[i] = s_foldCase(folded.at(i));
+	return folded;
+}
+
+inline bool s_equalsFolded(const char* str, const char* folded, int size)
+{
+	for (int i = 0; i < size; i++)
+	{
+		if (s_foldCase(str[i]) != folded[i])
+			return false;
+	}
+	return true;
+}
+
+#ifdef PGNTAGPOOL_SSE2
+inline int s_lowestBit(unsigned mask)
+{
+#ifdef Q_CC_MSVC
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return int(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Returns true if 'str' contains 'folded', a pattern whose letters
+// are already in upper case. The candidate positions are the bytes
+// that match the first character of the pattern in either case,
+// which the SSE2 version finds 16 bytes at a time.
+bool s_stringContains(const QByteArray& str, const QByteArray& folded)
+{
+	const int size = str.size();
+	const int patternSize = folded.size();
+	if (patternSize == 0)
+		return true;
+	const int last = size - patternSize;
+	if (last < 0)
+		return false;
+
+	const char* s = str.constData();
+	const char* p = folded.constData();
+	const char first = p[0];
+	int i = 0;
+
+#ifdef PGNTAGPOOL_SSE2
+	const char firstLower = (first >= 'A' && first <= 'Z')
+				? char(first + ('a' - 'A')) : first;
+	const __m128i upper = _mm_set1_epi8(first);
+	const __m128i lower = _mm_set1_epi8(firstLower);
+
+	for (; i <= last && i + 16 <= size; i += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(s + i));
+		unsigned mask = unsigned(_mm_movemask_epi8(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, upper),
+				     _mm_cmpeq_epi8(chunk, lower))));
+
+		while (mask != 0)
+		{
+			const int pos = i + s_lowestBit(mask);
+			if (pos > last)
+				return false;
+			if (s_equalsFolded(s + pos + 1, p + 1, patternSize - 1))
+				return true;
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; i <= last; i++)
+	{
+		if (s_foldCase(s[i]) == first
+		&&  s_equalsFolded(s + i + 1, p + 1, patternSize - 1))
+			return true;
+	}
+
+	return false;
+}
+
+} // anonymous namespace
+
+PgnTagPool::PgnTagPool()
+{
+	m_values.append(QByteArray());
+	m_ids.insert(QByteArray(), 0);
+}
+
+quint32 PgnTagPool::intern(const QByteArray& value)
+{
+	if (value.isEmpty())
+		return 0;
+
+	// Most values are already in the pool, and looking them
+	// up doesn't block the other threads
+	{
+		QReadLocker locker(&m_lock);
+		auto it = m_ids.constFind(value);
+		if (it != m_ids.constEnd())
+			return it.value();
+	}
+
+	QWriteLocker locker(&m_lock);
+	auto it = m_ids.constFind(value);
+	if (it != m_ids.constEnd())
+		return it.value();
+
+	const quint32 id = quint32(m_values.size());
+	m_values.append(value);
+	m_ids.insert(value, id);
+
+	return id;
+}
+
+QByteArray PgnTagPool::value(quint32 id) const
+{
+	QReadLocker locker(&m_lock);
+	return m_values.value(int(id));
+}
+
+int PgnTagPool::size() const
+{
+	QReadLocker locker(&m_lock);
+	return m_values.size();
+}
+
+QBitArray PgnTagPool::find(const QByteArray& pattern) const
+{
+	QReadLocker locker(&m_lock);
+	QBitArray bits(m_values.size(), pattern.isEmpty());
+
+	if (!pattern.isEmpty())
+	{
+		const QByteArray folded(s_foldedPattern(pattern));
+		for (int i = 0; i < m_values.size(); i++)
+		{
+			if (s_stringContains(m_values.at(i), folded))
+				bits.setBit(i);
+		}
+	}
+
+	return bits;
+}
+
+PgnTagMatcher::PgnTagMatcher()
+{
+}
+
+PgnTagMatcher::PgnTagMatcher(const PgnGameFilter& filter,
+			     const PgnTagPool& pool)
+	: m_filter(filter)
+{
+	if (filter.type() == PgnGameFilter::FixedString)
+	{
+		m_pattern = pool.find(filter.pattern());
+		return;
+	}
+
+	m_event = pool.find(filter.event());
+	m_site = pool.find(filter.site());
+	m_player = pool.find(filter.player());
+	m_opponent = pool.find(filter.opponent());
+}
+
+int PgnTagMatcher::matchPlayer(quint32 id) const
+{
+	return test(m_player, id) ? int(qstrlen(m_filter.player())) : -1;
+}
+
+int PgnTagMatcher::matchOpponent(quint32 id) const
+{
+	return test(m_opponent, id) ? int(qstrlen(m_filter.opponent())) : -1;
+}
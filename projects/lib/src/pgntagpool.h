@@ -0,0 +1,146 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNTAGPOOL_H
+#define PGNTAGPOOL_H
+
+#include <QByteArray>
+#include <QBitArray>
+#include <QHash>
+#include <QVector>
+#include <QReadWriteLock>
+#include "pgngamefilter.h"
+
+
+/*!
+ * \brief A pool of interned PGN tag values.
+ *
+ * Large PGN databases repeat the same event names, sites and player
+ * names in thousands of games. A PgnTagPool stores each distinct
+ * value once, and PgnGameEntry objects refer to the values by 32-bit
+ * IDs. ID 0 is always the empty string.
+ *
+ * The pool is thread-safe, so several threads can add values to
+ * it at the same time.
+ *
+ * \sa PgnGameEntry, PgnTagMatcher
+ */
+class LIB_EXPORT PgnTagPool
+{
+	public:
+		/*! Creates a new pool that contains only the empty string. */
+		PgnTagPool();
+
+		/*!
+		 * Adds \a value to the pool if it's not there yet.
+		 * Returns the ID of \a value.
+		 */
+		quint32 intern(const QByteArray& value);
+		/*! Returns the value whose ID is \a id. */
+		QByteArray value(quint32 id) const;
+		/*! Returns the number of values in the pool. */
+		int size() const;
+
+		/*!
+		 * Returns a bit array where the bit of each value that
+		 * contains \a pattern is set. The matching is case
+		 * insensitive. An empty \a pattern matches all values.
+		 */
+		QBitArray find(const QByteArray& pattern) const;
+
+	private:
+		Q_DISABLE_COPY(PgnTagPool)
+
+		mutable QReadWriteLock m_lock;
+		QVector<QByteArray> m_values;
+		QHash<QByteArray, quint32> m_ids;
+};
+
+/*!
+ * \brief A PgnGameFilter prepared for the values of a PgnTagPool.
+ *
+ * The string terms of the filter are looked up in the pool once,
+ * which turns the event, site and player matches of each
+ * PgnGameEntry into bit tests on the tag IDs.
+ *
+ * \sa PgnGameEntry::match()
+ */
+class LIB_EXPORT PgnTagMatcher
+{
+	public:
+		/*! Creates a matcher with an empty filter and no values. */
+		PgnTagMatcher();
+		/*! Creates a matcher for \a filter and \a pool. */
+		PgnTagMatcher(const PgnGameFilter& filter, const PgnTagPool& pool);
+
+		/*! Returns the filter. */
+		const PgnGameFilter& filter() const;
+
+		/*! Returns true if value \a id matches the fixed string pattern. */
+		bool matchesPattern(quint32 id) const;
+		/*! Returns true if value \a id matches the event filter. */
+		bool matchesEvent(quint32 id) const;
+		/*! Returns true if value \a id matches the site filter. */
+		bool matchesSite(quint32 id) const;
+		/*!
+		 * Returns the length of the first player's filter if value
+		 * \a id matches it; otherwise returns -1.
+		 */
+		int matchPlayer(quint32 id) const;
+		/*!
+		 * Returns the length of the opponent's filter if value
+		 * \a id matches it; otherwise returns -1.
+		 */
+		int matchOpponent(quint32 id) const;
+
+	private:
+		static bool test(const QBitArray& bits, quint32 id);
+
+		PgnGameFilter m_filter;
+		QBitArray m_pattern;
+		QBitArray m_event;
+		QBitArray m_site;
+		QBitArray m_player;
+		QBitArray m_opponent;
+};
+
+inline const PgnGameFilter& PgnTagMatcher::filter() const
+{
+	return m_filter;
+}
+
+inline bool PgnTagMatcher::test(const QBitArray& bits, quint32 id)
+{
+	return id < quint32(bits.size()) && bits.testBit(int(id));
+}
+
+inline bool PgnTagMatcher::matchesPattern(quint32 id) const
+{
+	return test(m_pattern, id);
+}
+
+inline bool PgnTagMatcher::matchesEvent(quint32 id) const
+{
+	return test(m_event, id);
+}
+
+inline bool PgnTagMatcher::matchesSite(quint32 id) const
+{
+	return test(m_site, id);
+}
+
+#endif // PGNTAGPOOL_H
@@ -16,109 +16,305 @@
 */
 
 #include "pipereader_win.h"
+#include <QAtomicInt>
 #include <QMutexLocker>
+#include <QString>
+#include <QThread>
+
+
+/*
+ * The thread that completes the reads of all pipe readers.
+ *
+ * Each pipe is associated with one I/O completion port, with the
+ * PipeReader object as the completion key.
+ */
+class PipeCompletionThread : public QThread
+{
+	public:
+		PipeCompletionThread();
+		virtual ~PipeCompletionThread();
+
+		bool add(PipeReader* reader);
+		void post(PipeReader* reader);
+
+	protected:
+		virtual void run();
+
+	private:
+		HANDLE m_port;
+};
+
+PipeCompletionThread::PipeCompletionThread()
+	: m_port(CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1))
+{
+	if (m_port == NULL)
+		qWarning("CreateIoCompletionPort failed with 0x%x",
+			 int(GetLastError()));
+	else
+		start();
+}
+
+PipeCompletionThread::~PipeCompletionThread()
+{
+	if (m_port == NULL)
+		return;
+
+	// A null completion key tells the thread to quit
+	PostQueuedCompletionStatus(m_port, 0, 0, NULL);
+	wait();
+	CloseHandle(m_port);
+}
+
+bool PipeCompletionThread::add(PipeReader* reader)
+{
+	if (m_port == NULL)
+		return false;
+
+	return CreateIoCompletionPort(reader->m_pipe, m_port,
+				      ULONG_PTR(reader), 0) != NULL;
+}
+
+void PipeCompletionThread::post(PipeReader* reader)
+{
+	PostQueuedCompletionStatus(m_port, 0, ULONG_PTR(reader),
+				   &reader->m_overlapped);
+}
+
+void PipeCompletionThread::run()
+{
+	forever
+	{
+		DWORD bytes = 0;
+		ULONG_PTR key = 0;
+		LPOVERLAPPED overlapped = NULL;
+
+		BOOL ok = GetQueuedCompletionStatus(m_port, &bytes, &key,
+						    &overlapped, INFINITE);
+		if (key == 0)
+			return;
+		if (overlapped == NULL)
+			continue;
+
+		reinterpret_cast<PipeReader*>(key)->onReadCompleted(bytes, ok);
+	}
+}
+
+Q_GLOBAL_STATIC(PipeCompletionThread, s_completionThread)
 
 
 PipeReader::PipeReader(HANDLE pipe, QObject* parent)
-	: QThread(parent),
+	: QObject(parent),
 	  m_pipe(pipe),
-	  m_bufEnd(m_buf + BufSize),
-	  m_start(m_buf),
-	  m_end(m_buf),
-	  m_freeBytes(BufSize),
-	  m_usedBytes(0),
-	  m_lastNewLine(1)
+	  m_lastNewLine(-1),
+	  m_started(false),
+	  m_readPending(false),
+	  m_finished(false),
+	  m_closing(false)
 {
 	Q_ASSERT(m_pipe != INVALID_HANDLE_VALUE);
+	ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+	m_buffer.reserve(BufSize);
+}
+
+PipeReader::~PipeReader()
+{
+	QMutexLocker locker(&m_mutex);
+	m_closing = true;
+
+	// The completion thread may not touch this object after the
+	// pending read has been completed or cancelled
+	if (m_readPending)
+	{
+		CancelIoEx(m_pipe, &m_overlapped);
+		while (m_readPending)
+			m_stateChanged.wait(&m_mutex);
+	}
+}
+
+bool PipeReader::createPipe(HANDLE* readPipe,
+			    HANDLE* writePipe,
+			    SECURITY_ATTRIBUTES* attributes)
+{
+	// Anonymous pipes don't support overlapped I/O, so a uniquely
+	// named pipe is used instead
+	static QAtomicInt counter;
+	const QString name(QString("\\\\.\\pipe\\cutechess-%1-%2")
+			   .arg(GetCurrentProcessId())
+			   .arg(counter.fetchAndAddRelaxed(1)));
+	auto wname = reinterpret_cast<const wchar_t*>(name.utf16());
+
+	*readPipe = CreateNamedPipeW(wname,
+				     PIPE_ACCESS_INBOUND
+				     | FILE_FLAG_OVERLAPPED
+				     | FILE_FLAG_FIRST_PIPE_INSTANCE,
+				     PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+				     1,		// max. instances
+				     0,		// output buffer size
+				     BufSize,	// input buffer size
+				     0,		// default timeout
+				     NULL);	// not inheritable
+	if (*readPipe == INVALID_HANDLE_VALUE)
+		return false;
+
+	*writePipe = CreateFileW(wname,
+				 GENERIC_WRITE,
+				 0,		// no sharing
+				 attributes,
+				 OPEN_EXISTING,
+				 FILE_ATTRIBUTE_NORMAL,
+				 NULL);
+	if (*writePipe == INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(*readPipe);
+		*readPipe = INVALID_HANDLE_VALUE;
+		return false;
+	}
+
+	return true;
+}
+
+void PipeReader::start()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_started)
+		return;
+	m_started = true;
+
+	if (!s_completionThread()->add(this))
+	{
+		qWarning("Cannot associate pipe with the completion port: 0x%x",
+			 int(GetLastError()));
+		m_finished = true;
+		return;
+	}
+
+	issueRead();
+}
+
+bool PipeReader::isRunning() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_started && !m_finished;
+}
+
+bool PipeReader::isFinished() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_finished;
+}
+
+bool PipeReader::wait(unsigned long msecs)
+{
+	QMutexLocker locker(&m_mutex);
+	while (m_started && !m_finished)
+	{
+		if (!m_stateChanged.wait(&m_mutex, msecs))
+			return false;
+	}
+
+	return true;
 }
 
 qint64 PipeReader::bytesAvailable() const
 {
-	return qint64(m_usedBytes.available());
+	QMutexLocker locker(&m_mutex);
+	return qint64(m_buffer.size());
 }
 
 bool PipeReader::canReadLine() const
 {
 	QMutexLocker locker(&m_mutex);
-	return m_lastNewLine <= m_usedBytes.available();
+	return m_lastNewLine >= 0;
 }
 
 qint64 PipeReader::readData(char* data, qint64 maxSize)
 {
-	int n = qMin(int(maxSize), m_usedBytes.available());
+	QMutexLocker locker(&m_mutex);
+
+	int n = qMin(int(maxSize), m_buffer.size());
 	if (n <= 0)
 		return -1;
-	m_usedBytes.acquire(n);
 
-	// Copy the first (possibly the only) block of data
-	int size1 = qMin(int(m_bufEnd - m_start), n);
-	memcpy(data, m_start, size_t(size1));
-	m_start += size1;
+	memcpy(data, m_buffer.constData(), size_t(n));
+	m_buffer.remove(0, n);
+	m_lastNewLine -= n;
+	if (m_lastNewLine < 0)
+		m_lastNewLine = -1;
 
-	Q_ASSERT(m_start <= m_bufEnd);
-	if (m_start == m_bufEnd)
-		m_start = m_buf;
+	// Resume reading if the buffer was full
+	if (!m_readPending && !m_finished && m_started)
+		issueRead();
 
-	// Copy the second block of data from the beginning
-	int size2 = n - size1;
-	if (size2 > 0)
-	{
-		memcpy(data + size1, m_start, size_t(size2));
-		m_start += size2;
+	return n;
+}
 
-		Q_ASSERT(m_start <= m_bufEnd);
-		if (m_start == m_bufEnd)
-			m_start = m_buf;
-	}
-	Q_ASSERT(n == size1 + size2);
+void PipeReader::issueRead()
+{
+	// Called with the mutex locked
+	if (m_closing || m_buffer.size() + ChunkSize > BufSize)
+		return;
 
-	m_freeBytes.release(n);
-	return n;
+	ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+	m_readPending = true;
+
+	// A read that completes right away is still reported through
+	// the completion port
+	if (!ReadFile(m_pipe, m_chunk, ChunkSize, NULL, &m_overlapped)
+	&&  GetLastError() != ERROR_IO_PENDING)
+	{
+		// Let the completion thread handle the error so that
+		// the finished() signal is always emitted by it
+		s_completionThread()->post(this);
+	}
 }
 
-void PipeReader::run()
+void PipeReader::onReadCompleted(DWORD bytes, bool ok)
 {
-	DWORD dwRead = 0;
+	QMutexLocker locker(&m_mutex);
+	m_readPending = false;
 
-	forever
+	if (m_closing)
 	{
-		int maxSize = qMin(BufSize / 10, int(m_bufEnd - m_end));
-		m_freeBytes.acquire(maxSize);
+		m_stateChanged.wakeAll();
+		return;
+	}
 
-		BOOL ok = ReadFile(m_pipe, m_end, maxSize, &dwRead, 0);
-		if (!ok || dwRead == 0)
-		{
-			DWORD err = GetLastError();
-			if (err != ERROR_INVALID_HANDLE
-			&&  err != ERROR_BROKEN_PIPE)
-				qWarning("ReadFile failed with 0x%x", int(err));
-			return;
-		}
+	if (!ok || bytes == 0)
+	{
+		DWORD err = ok ? ERROR_BROKEN_PIPE : GetLastError();
+		if (err != ERROR_INVALID_HANDLE
+		&&  err != ERROR_BROKEN_PIPE
+		&&  err != ERROR_OPERATION_ABORTED)
+			qWarning("ReadFile failed with 0x%x", int(err));
 
-		m_end += dwRead;
-		Q_ASSERT(m_end <= m_bufEnd);
+		m_finished = true;
+		m_stateChanged.wakeAll();
 
-		QMutexLocker locker(&m_mutex);
+		// The signals are emitted with the mutex locked so that this
+		// object can't be destroyed before the emit returns. They're
+		// queued to the receivers, which live in other threads.
+		emit finished();
+		return;
+	}
 
-		m_lastNewLine += dwRead;
-		for (int i = 1; i <= int(dwRead); i++)
+	const int oldSize = m_buffer.size();
+	m_buffer.append(m_chunk, int(bytes));
+
+	bool newLine = false;
+	for (int i = int(bytes) - 1; i >= 0; i--)
+	{
+		if (m_chunk[i] == '\n')
 		{
-			if (*(m_end - i) == '\n')
-			{
-				m_lastNewLine = i;
-				break;
-			}
+			m_lastNewLine = oldSize + i;
+			newLine = true;
+			break;
 		}
+	}
 
-		if (m_end == m_bufEnd)
-			m_end = m_buf;
-
-		m_freeBytes.release(maxSize - dwRead);
-		m_usedBytes.release(dwRead);
+	issueRead();
 
-		// To avoid signal spam, send the 'readyRead' signal only
-		// if we have a whole line of new data
-		if (m_lastNewLine <= int(dwRead))
-			emit readyRead();
-	}
+	// To avoid signal spam, send the 'readyRead' signal only
+	// if we have a whole line of new data
+	if (newLine)
+		emit readyRead();
 }
@@ -19,31 +19,63 @@
 #define PIPEREADER_WIN_H
 
 #include <windows.h>
-#include <QThread>
+#include <QObject>
+#include <QByteArray>
 #include <QMutex>
-#include <QSemaphore>
+#include <QWaitCondition>
 
 
 /*!
- * \brief A thread class for reading input from a child process
+ * \brief A class for reading input from a child process
  *
  * PipeReader is intended for reading input from chess engines in Windows.
- * It uses blocking read calls to read from a WinAPI pipe, and
- * sends the readyRead() signal when a new line of text data is available.
+ * It uses overlapped reads on a WinAPI pipe, and sends the readyRead()
+ * signal when a new line of text data is available.
  *
- * No event loops are used. The child process has to terminate or be
- * terminated before the pipe reader can exit cleanly.
+ * The reads of all PipeReader objects are completed by a single thread
+ * that waits on an I/O completion port, so the number of threads doesn't
+ * grow with the number of engines. The pipe must be opened for
+ * overlapped I/O, eg. with createPipe().
  *
  * \note This class is for Windows only
  * \sa EngineProcess
  */
-class LIB_EXPORT PipeReader : public QThread
+class LIB_EXPORT PipeReader : public QObject
 {
 	Q_OBJECT
 
 	public:
-		/*! Creates a new PipeReader and starts the read loop. */
+		/*! Creates a new PipeReader for \a pipe. */
 		PipeReader(HANDLE pipe, QObject* parent = nullptr);
+		/*!
+		 * Destroys the reader. A pending read is cancelled, but the
+		 * pipe is not closed.
+		 */
+		virtual ~PipeReader();
+
+		/*!
+		 * Creates an anonymous pipe whose read end can be used
+		 * with PipeReader.
+		 *
+		 * The read end is not inheritable. The write end uses
+		 * \a attributes, so it can be passed to a child process.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		static bool createPipe(HANDLE* readPipe,
+				       HANDLE* writePipe,
+				       SECURITY_ATTRIBUTES* attributes);
+
+		/*! Starts reading from the pipe. */
+		void start();
+		/*! Returns true if the reader is started and not finished. */
+		bool isRunning() const;
+		/*! Returns true if the pipe was closed or a read failed. */
+		bool isFinished() const;
+		/*!
+		 * Waits for the reader to finish, for at most \a msecs
+		 * milliseconds. Returns true if the reader finished.
+		 */
+		bool wait(unsigned long msecs = ULONG_MAX);
 
 		/*!
 		 * Read up to \a maxSize bytes into \a data.
@@ -60,22 +92,29 @@ class LIB_EXPORT PipeReader : public QThread
 	signals:
 		/*! There's a new line of data available. */
 		void readyRead();
-		
-	protected:
-		virtual void run();
+		/*! The pipe was closed, or reading from it failed. */
+		void finished();
 
 	private:
+		friend class PipeCompletionThread;
+
 		static const int BufSize = 0x8000;
+		static const int ChunkSize = BufSize / 10;
+
+		void issueRead();
+		void onReadCompleted(DWORD bytes, bool ok);
 
 		HANDLE m_pipe;
-		char m_buf[BufSize];
-		const char* const m_bufEnd;
-		char* m_start;
-		char* m_end;
-		mutable QMutex m_mutex;
-		QSemaphore m_freeBytes;
-		QSemaphore m_usedBytes;
+		OVERLAPPED m_overlapped;
+		char m_chunk[ChunkSize];
+		QByteArray m_buffer;
 		int m_lastNewLine;
+		bool m_started;
+		bool m_readPending;
+		bool m_finished;
+		bool m_closing;
+		mutable QMutex m_mutex;
+		QWaitCondition m_stateChanged;
 };
 
 #endif // PIPEREADER_WIN_H
@@ -17,6 +17,7 @@
 
 #include "polyglotbook.h"
 #include <QDataStream>
+#include <QtEndian>
 
 namespace {
 
@@ -73,16 +74,28 @@ OpeningBook::Entry PolyglotBook::readEntry(QDataStream& in, quint64* key) const
 	// because QDataStream uses big-endian by default.
 	in >> *key >> pgMove >> weight >> learn;
 	
-	return { moveFromBits(pgMove), weight };
+	return { moveFromBits(pgMove), weight, learn };
+}
+
+OpeningBook::Entry PolyglotBook::entryFromData(const uchar* data,
+					       quint64* key) const
+{
+	// The entries are big-endian, like in readEntry()
+	*key = qFromBigEndian<quint64>(data);
+	quint16 pgMove = qFromBigEndian<quint16>(data + 8);
+	quint16 weight = qFromBigEndian<quint16>(data + 10);
+	quint32 learn = qFromBigEndian<quint32>(data + 12);
+
+	return { moveFromBits(pgMove), weight, learn };
 }
 
 void PolyglotBook::writeEntry(const Map::const_iterator& it,
 			      QDataStream& out) const
 {
-	quint32 learn = 0;
 	quint64 key = it.key();
 	quint16 pgMove = moveToBits(it.value().move);
 	quint16 weight = it.value().weight;
+	quint32 learn = it.value().learn;
 	
 	// Store the data. Again, big-endian is used by default.
 	out << key << pgMove << weight << learn;
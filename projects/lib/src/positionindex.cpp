@@ -0,0 +1,347 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionindex.h"
+#include <algorithm>
+#include <queue>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include "pgngame.h"
+
+namespace {
+
+/*
+ * The index file starts with a header, followed by a sorted array
+ * of little-endian (key, game, ply) records.
+ */
+const char s_indexMagic[8] = { 'C', 'C', 'P', 'O', 'S', 'I', '0', '1' };
+const int s_recordSize = 16;
+
+struct IndexHeader
+{
+	char magic[8];
+	qint64 fileSize;
+	qint64 lastModified;
+	qint64 count;
+};
+
+} // anonymous namespace
+
+PositionIndex::PositionIndex()
+	: m_records(nullptr),
+	  m_count(0)
+{
+}
+
+PositionIndex::~PositionIndex()
+{
+	close();
+}
+
+bool PositionIndex::open(const QString& fileName,
+			 const QString& sourceFileName)
+{
+	close();
+
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly)
+	||  m_file.size() < qint64(sizeof(IndexHeader)))
+	{
+		close();
+		return false;
+	}
+
+	const uchar* data = m_file.map(0, m_file.size());
+	if (data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	IndexHeader header;
+	memcpy(&header, data, sizeof(header));
+	const QFileInfo info(sourceFileName);
+	const qint64 count = qFromLittleEndian(header.count);
+	if (memcmp(header.magic, s_indexMagic, sizeof(s_indexMagic)) != 0
+	||  qFromLittleEndian(header.fileSize) != info.size()
+	||  qFromLittleEndian(header.lastModified)
+	    != info.lastModified().toMSecsSinceEpoch()
+	||  count < 0
+	||  m_file.size() != qint64(sizeof(header)) + count * s_recordSize)
+	{
+		close();
+		return false;
+	}
+
+	m_records = data + sizeof(header);
+	m_count = count;
+
+	return true;
+}
+
+void PositionIndex::close()
+{
+	// QFile::close() also unmaps the file
+	m_file.close();
+	m_records = nullptr;
+	m_count = 0;
+}
+
+bool PositionIndex::isOpen() const
+{
+	return m_records != nullptr;
+}
+
+qint64 PositionIndex::positionCount() const
+{
+	return m_count;
+}
+
+quint64 PositionIndex::keyAt(qint64 index) const
+{
+	return qFromLittleEndian<quint64>(m_records + index * s_recordSize);
+}
+
+QVector<PositionIndex::Hit> PositionIndex::find(quint64 key) const
+{
+	QVector<Hit> hits;
+
+	// Find the first record with the key
+	qint64 first = 0;
+	qint64 last = m_count;
+	while (first < last)
+	{
+		const qint64 mid = first + (last - first) / 2;
+		if (keyAt(mid) < key)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	for (qint64 i = first; i < m_count && keyAt(i) == key; i++)
+	{
+		const uchar* record = m_records + i * s_recordSize;
+		Hit hit = { qFromLittleEndian<quint32>(record + 8),
+			    qFromLittleEndian<quint32>(record + 12) };
+		hits.append(hit);
+	}
+
+	return hits;
+}
+
+
+bool PositionIndexWriter::Record::operator<(const Record& other) const
+{
+	if (key != other.key)
+		return key < other.key;
+	if (game != other.game)
+		return game < other.game;
+	return ply < other.ply;
+}
+
+PositionIndexWriter::PositionIndexWriter(int runSize)
+	: m_runSize(runSize),
+	  m_count(0),
+	  m_error(false)
+{
+	Q_ASSERT(runSize > 0);
+}
+
+PositionIndexWriter::~PositionIndexWriter()
+{
+	qDeleteAll(m_runs);
+}
+
+void PositionIndexWriter::addGame(quint32 game,
+				  const PgnGame& pgn,
+				  quint64 finalKey)
+{
+	const auto& moves = pgn.moves();
+	QVector<Record> records;
+	records.reserve(moves.size() + 1);
+	for (int i = 0; i < moves.size(); i++)
+	{
+		Record record = { moves.at(i).key, game, quint32(i) };
+		records.append(record);
+	}
+	Record last = { finalKey, game, quint32(moves.size()) };
+	records.append(last);
+
+	// Keep only the first ply of repeated positions
+	std::sort(records.begin(), records.end());
+	auto end = std::unique(records.begin(), records.end(),
+		[](const Record& a, const Record& b)
+	{
+		return a.key == b.key;
+	});
+	records.erase(end, records.end());
+
+	QMutexLocker locker(&m_mutex);
+	if (m_error)
+		return;
+
+	for (const Record& record : records)
+	{
+		if (m_records.size() >= m_runSize && !writeRun())
+		{
+			m_error = true;
+			m_records.clear();
+			return;
+		}
+		m_records.append(record);
+	}
+	m_count += records.size();
+}
+
+qint64 PositionIndexWriter::positionCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_count;
+}
+
+bool PositionIndexWriter::writeRun()
+{
+	std::sort(m_records.begin(), m_records.end());
+
+	QTemporaryFile* file = new QTemporaryFile;
+	m_runs.append(file);
+
+	const qint64 size = qint64(m_records.size()) * sizeof(Record);
+	if (!file->open()
+	||  file->write(reinterpret_cast<const char*>(m_records.constData()),
+			size) != size)
+	{
+		qWarning("Can't write temporary position index file");
+		return false;
+	}
+
+	m_records.clear();
+	return true;
+}
+
+bool PositionIndexWriter::merge(QIODevice* out)
+{
+	static const int bufferSize = 4096;
+
+	// The runs are read in small blocks, and the next record of
+	// each run is kept in a heap ordered by the smallest record
+	struct Run
+	{
+		QIODevice* device;
+		QVector<Record> buffer;
+		int pos;
+
+		bool next()
+		{
+			if (++pos < buffer.size())
+				return true;
+
+			buffer.resize(bufferSize);
+			const qint64 n = device->read(
+				reinterpret_cast<char*>(buffer.data()),
+				bufferSize * sizeof(Record));
+			buffer.resize(n > 0 ? int(n / sizeof(Record)) : 0);
+			pos = 0;
+			return !buffer.isEmpty();
+		}
+		const Record& record() const
+		{
+			return buffer.at(pos);
+		}
+	};
+
+	QVector<Run> runs(m_runs.size());
+	auto greater = [&runs](int a, int b)
+	{
+		return runs.at(b).record() < runs.at(a).record();
+	};
+	std::priority_queue<int, std::vector<int>, decltype(greater)> heap(greater);
+
+	for (int i = 0; i < m_runs.size(); i++)
+	{
+		Run& run = runs[i];
+		run.device = m_runs.at(i);
+		run.pos = -1;
+		if (!run.device->seek(0))
+			return false;
+		if (run.next())
+			heap.push(i);
+	}
+
+	QByteArray data;
+	data.reserve(bufferSize * s_recordSize);
+	while (!heap.empty())
+	{
+		const int i = heap.top();
+		heap.pop();
+
+		const Record& record = runs.at(i).record();
+		uchar buf[s_recordSize];
+		qToLittleEndian(record.key, buf);
+		qToLittleEndian(record.game, buf + 8);
+		qToLittleEndian(record.ply, buf + 12);
+		data.append(reinterpret_cast<const char*>(buf), s_recordSize);
+
+		if (runs[i].next())
+			heap.push(i);
+
+		if (data.size() >= bufferSize * s_recordSize || heap.empty())
+		{
+			if (out->write(data) != data.size())
+				return false;
+			data.clear();
+		}
+	}
+
+	return true;
+}
+
+bool PositionIndexWriter::write(const QString& fileName,
+				const QString& sourceFileName)
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (m_error)
+		return false;
+
+	// Small indexes are written straight from memory as one run
+	if (!m_records.isEmpty() && !writeRun())
+		return false;
+
+	const QFileInfo info(sourceFileName);
+	IndexHeader header;
+	memcpy(header.magic, s_indexMagic, sizeof(s_indexMagic));
+	header.fileSize = qToLittleEndian(info.size());
+	header.lastModified = qToLittleEndian(
+		info.lastModified().toMSecsSinceEpoch());
+	header.count = qToLittleEndian(m_count);
+
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)
+	||  file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+	    != qint64(sizeof(header))
+	||  !merge(&file)
+	||  !file.commit())
+	{
+		qWarning("Can't write position index %s", qPrintable(fileName));
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,155 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+class PgnGame;
+class QTemporaryFile;
+
+
+/*!
+ * \brief A search index from chess positions to games.
+ *
+ * A position index maps the Zobrist keys of the positions in a PGN
+ * file to the games and plies where they occur. The keys are the
+ * ones returned by Chess::Board::key(), so in standard chess they
+ * are Polyglot keys and match the keys of a PolyglotBook.
+ *
+ * The index file is a sorted array of fixed-size records, which is
+ * memory-mapped and searched with a binary search. Use
+ * PositionIndexWriter to create the file.
+ *
+ * \sa PositionIndexWriter, PgnGame::MoveData
+ */
+class LIB_EXPORT PositionIndex
+{
+	public:
+		/*! A game that reaches a position. */
+		struct Hit
+		{
+			quint32 game;	//!< The index of the game in the PGN file
+			quint32 ply;	//!< The first ply where the position occurs
+		};
+
+		/*! Creates a new closed index. */
+		PositionIndex();
+		/*! Destroys the index and closes the file. */
+		~PositionIndex();
+
+		/*!
+		 * Opens the index file \a fileName that was created for
+		 * the PGN file \a sourceFileName.
+		 *
+		 * Returns false if the file can't be mapped, or if
+		 * \a sourceFileName was modified after the index was written.
+		 */
+		bool open(const QString& fileName, const QString& sourceFileName);
+		/*! Closes the index file. */
+		void close();
+		/*! Returns true if the index is open. */
+		bool isOpen() const;
+
+		/*! Returns the number of positions in the index. */
+		qint64 positionCount() const;
+		/*!
+		 * Returns the games that reach the position with Zobrist
+		 * key \a key, sorted by game index.
+		 */
+		QVector<Hit> find(quint64 key) const;
+
+	private:
+		Q_DISABLE_COPY(PositionIndex)
+
+		quint64 keyAt(qint64 index) const;
+
+		QFile m_file;
+		const uchar* m_records;
+		qint64 m_count;
+};
+
+/*!
+ * \brief Creates PositionIndex files.
+ *
+ * The positions are sorted in memory in runs of a fixed size. Full
+ * runs are written to temporary files and merged when the index is
+ * written, so indexing a large database doesn't need more memory
+ * than one run.
+ *
+ * addGame() can be called from several threads at once.
+ *
+ * \sa PositionIndex
+ */
+class LIB_EXPORT PositionIndexWriter
+{
+	public:
+		/*!
+		 * Creates a new writer that keeps at most \a runSize
+		 * positions in memory.
+		 */
+		explicit PositionIndexWriter(int runSize = 4 * 1024 * 1024);
+		/*! Destroys the writer and its temporary files. */
+		~PositionIndexWriter();
+
+		/*!
+		 * Adds the positions of \a pgn, which is game number
+		 * \a game in the PGN file.
+		 *
+		 * The position before each move comes from its MoveData
+		 * key. \a finalKey is the key of the position after the
+		 * last move. A position that occurs more than once in the
+		 * game is added only at its first ply.
+		 */
+		void addGame(quint32 game, const PgnGame& pgn, quint64 finalKey);
+		/*! Returns the number of positions added so far. */
+		qint64 positionCount() const;
+
+		/*!
+		 * Writes the index to \a fileName for the PGN file
+		 * \a sourceFileName.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool write(const QString& fileName, const QString& sourceFileName);
+
+	private:
+		Q_DISABLE_COPY(PositionIndexWriter)
+
+		struct Record
+		{
+			quint64 key;
+			quint32 game;
+			quint32 ply;
+
+			bool operator<(const Record& other) const;
+		};
+
+		bool writeRun();
+		bool merge(QIODevice* out);
+
+		mutable QMutex m_mutex;
+		QVector<Record> m_records;
+		QVector<QTemporaryFile*> m_runs;
+		int m_runSize;
+		qint64 m_count;
+		bool m_error;
+};
+
+#endif // POSITIONINDEX_H
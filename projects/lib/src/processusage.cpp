@@ -0,0 +1,191 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "processusage.h"
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+namespace {
+
+QByteArray readProcFile(const QString& path)
+{
+	// Files in /proc have no size, so they can't be read with readAll()
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	QByteArray data;
+	char buf[1024];
+	qint64 n;
+	while ((n = file.read(buf, sizeof(buf))) > 0)
+		data.append(buf, int(n));
+
+	return data;
+}
+
+qint64 statusValue(const QByteArray& status, const char* key)
+{
+	const QByteArray pattern = QByteArray("\n") + key + ':';
+	int pos = status.indexOf(pattern);
+	if (pos == -1)
+		return -1;
+
+	pos += pattern.size();
+	int end = status.indexOf('\n', pos);
+	const QByteArray value = status.mid(pos, end - pos).trimmed();
+
+	// Remove the unit (" kB")
+	int space = value.indexOf(' ');
+	bool ok = false;
+	qint64 ret = value.left(space).toLongLong(&ok);
+
+	return ok ? ret : -1;
+}
+
+} // anonymous namespace
+#endif
+
+ProcessUsage::ProcessUsage()
+	: m_cpuTime(-1),
+	  m_peakMemory(-1),
+	  m_voluntarySwitches(-1),
+	  m_involuntarySwitches(-1)
+{
+}
+
+ProcessUsage ProcessUsage::sample(qint64 pid)
+{
+	ProcessUsage usage;
+	if (pid <= 0)
+		return usage;
+
+#ifdef Q_OS_WIN
+	HANDLE process = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
+				     FALSE, DWORD(pid));
+	if (process == nullptr)
+		return usage;
+
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (GetProcessTimes(process, &creationTime, &exitTime,
+			    &kernelTime, &userTime))
+	{
+		ULARGE_INTEGER kernel, user;
+		kernel.LowPart = kernelTime.dwLowDateTime;
+		kernel.HighPart = kernelTime.dwHighDateTime;
+		user.LowPart = userTime.dwLowDateTime;
+		user.HighPart = userTime.dwHighDateTime;
+
+		// FILETIME is in units of 100 nanoseconds
+		usage.m_cpuTime = qint64((kernel.QuadPart + user.QuadPart) / 10000);
+	}
+
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(process, &counters, sizeof(counters)))
+		usage.m_peakMemory = qint64(counters.PeakWorkingSetSize / 1024);
+
+	CloseHandle(process);
+#elif defined(Q_OS_LINUX)
+	const QString procDir = QString("/proc/%1/").arg(pid);
+
+	// The command name in parentheses may contain spaces, so the
+	// fields are counted from the closing parenthesis. The first
+	// field after it is the 3rd one, utime and stime are the 14th
+	// and 15th.
+	const QByteArray stat = readProcFile(procDir + "stat");
+	int pos = stat.lastIndexOf(')');
+	if (pos == -1)
+		return usage;
+	const QList<QByteArray> fields = stat.mid(pos + 2).split(' ');
+	if (fields.size() < 13)
+		return usage;
+
+	static const qint64 ticks = sysconf(_SC_CLK_TCK);
+	const qint64 time = fields.at(11).toLongLong()
+			  + fields.at(12).toLongLong();
+	usage.m_cpuTime = time * 1000 / (ticks > 0 ? ticks : 100);
+
+	const QByteArray status = readProcFile(procDir + "status");
+	usage.m_peakMemory = statusValue(status, "VmHWM");
+
+	// The process' own status only counts the switches of the main
+	// thread, so add up the switches of every thread
+	const QDir taskDir(procDir + "task");
+	const QStringList tasks = taskDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	usage.m_voluntarySwitches = 0;
+	usage.m_involuntarySwitches = 0;
+	for (const QString& task : tasks)
+	{
+		const QByteArray taskStatus = readProcFile(
+			taskDir.filePath(task + "/status"));
+		usage.m_voluntarySwitches += qMax(Q_INT64_C(0),
+			statusValue(taskStatus, "voluntary_ctxt_switches"));
+		usage.m_involuntarySwitches += qMax(Q_INT64_C(0),
+			statusValue(taskStatus, "nonvoluntary_ctxt_switches"));
+	}
+#endif
+
+	return usage;
+}
+
+bool ProcessUsage::isNull() const
+{
+	return m_cpuTime < 0;
+}
+
+ProcessUsage ProcessUsage::since(const ProcessUsage& start) const
+{
+	if (isNull() || start.isNull())
+		return *this;
+
+	ProcessUsage usage(*this);
+	usage.m_cpuTime -= start.m_cpuTime;
+	if (m_voluntarySwitches >= 0 && start.m_voluntarySwitches >= 0)
+		usage.m_voluntarySwitches -= start.m_voluntarySwitches;
+	if (m_involuntarySwitches >= 0 && start.m_involuntarySwitches >= 0)
+		usage.m_involuntarySwitches -= start.m_involuntarySwitches;
+
+	return usage;
+}
+
+qint64 ProcessUsage::cpuTime() const
+{
+	return m_cpuTime;
+}
+
+qint64 ProcessUsage::peakMemory() const
+{
+	return m_peakMemory;
+}
+
+qint64 ProcessUsage::voluntarySwitches() const
+{
+	return m_voluntarySwitches;
+}
+
+qint64 ProcessUsage::involuntarySwitches() const
+{
+	return m_involuntarySwitches;
+}
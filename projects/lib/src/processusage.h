@@ -0,0 +1,83 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROCESSUSAGE_H
+#define PROCESSUSAGE_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief Resource usage of an engine process.
+ *
+ * ProcessUsage is a snapshot of the CPU time, peak memory and context
+ * switches of a running process. Comparing an engine's CPU time to
+ * the time it spent thinking shows whether it really got the CPU
+ * power it was given; a busy or oversubscribed host shows up as a
+ * low CPU load and many involuntary context switches.
+ *
+ * Snapshots can be taken on Linux and Windows. Windows doesn't
+ * count context switches per process, so they are unknown there.
+ */
+class LIB_EXPORT ProcessUsage
+{
+	public:
+		/*! Creates a null snapshot. */
+		ProcessUsage();
+
+		/*!
+		 * Returns a snapshot of the resource usage of the process
+		 * \a pid, or a null snapshot if it can't be read.
+		 */
+		static ProcessUsage sample(qint64 pid);
+
+		/*! Returns true if this is a null snapshot. */
+		bool isNull() const;
+
+		/*!
+		 * Returns the usage since \a start.
+		 *
+		 * CPU time and context switches are counted from \a start,
+		 * the peak memory is that of the whole process lifetime.
+		 */
+		ProcessUsage since(const ProcessUsage& start) const;
+
+		/*! Returns the user and system CPU time in milliseconds. */
+		qint64 cpuTime() const;
+		/*!
+		 * Returns the peak resident set size in kilobytes, or -1
+		 * if it's unknown.
+		 */
+		qint64 peakMemory() const;
+		/*!
+		 * Returns the number of voluntary context switches, or -1
+		 * if it's unknown.
+		 */
+		qint64 voluntarySwitches() const;
+		/*!
+		 * Returns the number of involuntary context switches, or
+		 * -1 if it's unknown.
+		 */
+		qint64 involuntarySwitches() const;
+
+	private:
+		qint64 m_cpuTime;
+		qint64 m_peakMemory;
+		qint64 m_voluntarySwitches;
+		qint64 m_involuntarySwitches;
+};
+
+#endif // PROCESSUSAGE_H
@@ -0,0 +1,282 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ratingsdatabase.h"
+#include <algorithm>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include "ratingsolver.h"
+
+namespace {
+
+const quint32 s_magic = 0x43435244; // "CCRD"
+const quint32 s_version = 1;
+
+} // anonymous namespace
+
+RatingsDatabase::RatingsDatabase()
+	: m_gameCount(0)
+{
+}
+
+quint64 RatingsDatabase::pairKey(int player1, int player2)
+{
+	Q_ASSERT(player1 < player2);
+	return (quint64(player1) << 32) | quint32(player2);
+}
+
+int RatingsDatabase::addPlayer(const QString& name)
+{
+	auto it = m_playerIndexes.constFind(name);
+	if (it != m_playerIndexes.constEnd())
+		return it.value();
+
+	Player player = { name, 0.0, 0, 0, 0 };
+	m_players.append(player);
+	m_playerIndexes.insert(name, m_players.size() - 1);
+	return m_players.size() - 1;
+}
+
+void RatingsDatabase::addResults(int player1, int player2, const Pair& pair)
+{
+	Pair& total = m_pairs[pairKey(player1, player2)];
+	total.wins += pair.wins;
+	total.draws += pair.draws;
+	total.losses += pair.losses;
+
+	const int games = int(pair.wins + pair.draws + pair.losses);
+	Player& p1 = m_players[player1];
+	p1.games += games;
+	p1.points += int(pair.wins * 2 + pair.draws);
+	p1.draws += int(pair.draws);
+	Player& p2 = m_players[player2];
+	p2.games += games;
+	p2.points += int(pair.losses * 2 + pair.draws);
+	p2.draws += int(pair.draws);
+	m_gameCount += games;
+}
+
+bool RatingsDatabase::load(const QString& fileName)
+{
+	m_players.clear();
+	m_playerIndexes.clear();
+	m_pairs.clear();
+	m_sources.clear();
+	m_gameCount = 0;
+
+	QFile file(fileName);
+	if (!file.exists())
+		return true;
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("cannot open ratings database: %s",
+			 qPrintable(fileName));
+		return false;
+	}
+
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_0);
+
+	quint32 magic;
+	quint32 version;
+	in >> magic >> version;
+	if (magic != s_magic || version != s_version)
+	{
+		qWarning("invalid ratings database: %s", qPrintable(fileName));
+		return false;
+	}
+
+	qint32 playerCount;
+	in >> playerCount;
+	for (int i = 0; i < playerCount && in.status() == QDataStream::Ok; i++)
+	{
+		QString name;
+		double rating;
+		in >> name >> rating;
+		m_players[addPlayer(name)].rating = rating;
+	}
+
+	// The players' results are derived from the pairs
+	qint32 pairCount;
+	in >> pairCount;
+	for (int i = 0; i < pairCount && in.status() == QDataStream::Ok; i++)
+	{
+		qint32 player1;
+		qint32 player2;
+		Pair pair;
+		in >> player1 >> player2 >> pair.wins >> pair.draws >> pair.losses;
+		if (player1 < 0 || player1 >= player2 || player2 >= m_players.size())
+		{
+			in.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+		addResults(player1, player2, pair);
+	}
+
+	qint32 sourceCount;
+	in >> sourceCount;
+	for (int i = 0; i < sourceCount && in.status() == QDataStream::Ok; i++)
+	{
+		QString source;
+		QBitArray games;
+		in >> source >> games;
+		m_sources.insert(source, games);
+	}
+
+	if (in.status() != QDataStream::Ok
+	||  m_players.size() != playerCount)
+	{
+		qWarning("invalid ratings database: %s", qPrintable(fileName));
+		return false;
+	}
+
+	return true;
+}
+
+bool RatingsDatabase::save(const QString& fileName) const
+{
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning("cannot open ratings database: %s",
+			 qPrintable(fileName));
+		return false;
+	}
+
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_0);
+	out << s_magic << s_version;
+
+	out << qint32(m_players.size());
+	for (const Player& player : m_players)
+		out << player.name << player.rating;
+
+	out << qint32(m_pairs.size());
+	for (auto it = m_pairs.constBegin(); it != m_pairs.constEnd(); ++it)
+	{
+		const Pair& pair = it.value();
+		out << qint32(it.key() >> 32) << qint32(it.key() & 0xffffffff)
+		    << pair.wins << pair.draws << pair.losses;
+	}
+
+	out << qint32(m_sources.size());
+	for (auto it = m_sources.constBegin(); it != m_sources.constEnd(); ++it)
+		out << it.key() << it.value();
+
+	if (out.status() != QDataStream::Ok || !file.commit())
+	{
+		qWarning("cannot write ratings database: %s",
+			 qPrintable(fileName));
+		return false;
+	}
+
+	return true;
+}
+
+bool RatingsDatabase::addGame(const QString& source,
+			      int index,
+			      const QString& white,
+			      const QString& black,
+			      const Chess::Result& result)
+{
+	Q_ASSERT(index > 0);
+
+	if (result.isNone() || white == black)
+		return false;
+
+	QBitArray& games = m_sources[source];
+	if (games.size() < index)
+		games.resize(index);
+	if (games.testBit(index - 1))
+		return false;
+	games.setBit(index - 1);
+
+	int player1 = addPlayer(white);
+	int player2 = addPlayer(black);
+	Chess::Side winner = result.winner();
+	if (player1 > player2)
+	{
+		qSwap(player1, player2);
+		if (!winner.isNull())
+			winner = winner.opposite();
+	}
+
+	Pair pair = { 0, 0, 0 };
+	if (winner == Chess::Side::White)
+		pair.wins = 1;
+	else if (winner == Chess::Side::Black)
+		pair.losses = 1;
+	else
+		pair.draws = 1;
+	addResults(player1, player2, pair);
+
+	return true;
+}
+
+int RatingsDatabase::gameCount() const
+{
+	return m_gameCount;
+}
+
+bool RatingsDatabase::solve()
+{
+	RatingSolver solver(m_players.size());
+	for (int i = 0; i < m_players.size(); i++)
+		solver.setRating(i, m_players.at(i).rating);
+	for (auto it = m_pairs.constBegin(); it != m_pairs.constEnd(); ++it)
+	{
+		const Pair& pair = it.value();
+		solver.addGames(int(it.key() >> 32), int(it.key() & 0xffffffff),
+				int(pair.wins + pair.draws + pair.losses),
+				int(pair.wins * 2 + pair.draws));
+	}
+
+	const bool converged = solver.solve();
+	for (int i = 0; i < m_players.size(); i++)
+		m_players[i].rating = solver.rating(i);
+
+	return converged;
+}
+
+int RatingsDatabase::playerCount() const
+{
+	return m_players.size();
+}
+
+const RatingsDatabase::Player& RatingsDatabase::player(int index) const
+{
+	return m_players.at(index);
+}
+
+int RatingsDatabase::playerIndex(const QString& name) const
+{
+	return m_playerIndexes.value(name, -1);
+}
+
+QVector<int> RatingsDatabase::ranking() const
+{
+	QVector<int> indexes(m_players.size());
+	for (int i = 0; i < indexes.size(); i++)
+		indexes[i] = i;
+
+	std::stable_sort(indexes.begin(), indexes.end(), [this](int a, int b)
+	{
+		return m_players.at(a).rating > m_players.at(b).rating;
+	});
+	return indexes;
+}
@@ -0,0 +1,136 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RATINGSDATABASE_H
+#define RATINGSDATABASE_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "board/result.h"
+
+/*!
+ * \brief A persistent store of ratings across tournament runs
+ *
+ * A RatingsDatabase keeps the wins, draws and losses between each
+ * pair of players of every game added to it, and the ratings fitted
+ * to them with RatingSolver. The store is a compact binary file, so
+ * listing the ratings doesn't need the games themselves.
+ *
+ * Games are added by their source, eg. the progress journal of a
+ * tournament run, and their index in it. A game that was already
+ * added is skipped, so a source can be added again when it has new
+ * games. A solve() starts from the stored ratings, which makes
+ * refitting after a new run fast.
+ *
+ * \sa RatingSolver
+ */
+class LIB_EXPORT RatingsDatabase
+{
+	public:
+		/*! A player's rating and results. */
+		struct Player
+		{
+			/*! The player's name. */
+			QString name;
+			/*! The rating on the logistic Elo scale. */
+			double rating;
+			/*! The number of games played. */
+			int games;
+			/*! The score in half points. */
+			int points;
+			/*! The number of draws. */
+			int draws;
+		};
+
+		/*! Creates an empty database. */
+		RatingsDatabase();
+
+		/*!
+		 * Reads the database from \a fileName, replacing the
+		 * current contents. A missing file is an empty database.
+		 *
+		 * Returns false if the file can't be read.
+		 */
+		bool load(const QString& fileName);
+		/*!
+		 * Writes the database to \a fileName. The file is
+		 * replaced atomically.
+		 *
+		 * Returns false if the file can't be written.
+		 */
+		bool save(const QString& fileName) const;
+
+		/*!
+		 * Adds a game between \a white and \a black with
+		 * \a result to the database. The game is game number
+		 * \a index of the source \a source.
+		 *
+		 * Returns false if the game was already added or if it
+		 * doesn't have a result.
+		 */
+		bool addGame(const QString& source,
+			     int index,
+			     const QString& white,
+			     const QString& black,
+			     const Chess::Result& result);
+		/*! Returns the number of games in the database. */
+		int gameCount() const;
+
+		/*!
+		 * Fits the ratings to the results, starting from the
+		 * current ratings.
+		 *
+		 * Returns false if the fit didn't converge.
+		 */
+		bool solve();
+
+		/*! Returns the number of players. */
+		int playerCount() const;
+		/*! Returns player number \a index. */
+		const Player& player(int index) const;
+		/*!
+		 * Returns the index of the player called \a name, or -1
+		 * if there's no such player.
+		 */
+		int playerIndex(const QString& name) const;
+		/*! Returns the indexes of the players by rating, best first. */
+		QVector<int> ranking() const;
+
+	private:
+		// Results of the player with the smaller index
+		struct Pair
+		{
+			quint32 wins;
+			quint32 draws;
+			quint32 losses;
+		};
+
+		static quint64 pairKey(int player1, int player2);
+		int addPlayer(const QString& name);
+		void addResults(int player1, int player2, const Pair& pair);
+
+		QVector<Player> m_players;
+		QHash<QString, int> m_playerIndexes;
+		QHash<quint64, Pair> m_pairs;
+		QHash<QString, QBitArray> m_sources;
+		int m_gameCount;
+};
+
+#endif // RATINGSDATABASE_H
@@ -0,0 +1,345 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ratingsolver.h"
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+namespace {
+
+// Elo points per natural logarithm unit of the gamma values
+const double EloScale = 400.0 / std::log(10.0);
+// The fit has converged when no rating changes more than this
+const double Tolerance = 1.0e-4;
+const int MaxIterations = 10000;
+// Smaller tournaments are solved in the calling thread
+const int ParallelThreshold = 16;
+const double PriorDraws = 1.0;
+
+class SolverTask : public QRunnable
+{
+	public:
+		explicit SolverTask(const std::function<void()>& function)
+			: m_function(function)
+		{
+		}
+
+		virtual void run()
+		{
+			m_function();
+		}
+
+	private:
+		std::function<void()> m_function;
+};
+
+} // anonymous namespace
+
+RatingSolver::RatingSolver(int playerCount)
+	: m_playerCount(0),
+	  m_solved(false),
+	  m_converged(false),
+	  m_covarianceValid(false)
+{
+	reset(playerCount);
+}
+
+int RatingSolver::playerCount() const
+{
+	return m_playerCount;
+}
+
+void RatingSolver::reset(int playerCount)
+{
+	Q_ASSERT(playerCount >= 0);
+
+	m_playerCount = playerCount;
+	m_games.fill(0, playerCount * playerCount);
+	m_playerGames.fill(0, playerCount);
+	m_points.fill(0, playerCount);
+	m_gamma.fill(1.0, playerCount);
+	m_nextGamma.fill(1.0, playerCount);
+	// Allocated when needed, which many users of the ratings never do
+	m_covariance.clear();
+	m_solved = false;
+	m_covarianceValid = false;
+}
+
+void RatingSolver::addGame(int player, int opponent, int points)
+{
+	Q_ASSERT(points >= 0 && points <= 2);
+
+	addGames(player, opponent, 1, points);
+}
+
+void RatingSolver::addGames(int player, int opponent, int games, int points)
+{
+	Q_ASSERT(player >= 0 && player < m_playerCount);
+	Q_ASSERT(opponent >= 0 && opponent < m_playerCount);
+	Q_ASSERT(player != opponent);
+	Q_ASSERT(games >= 0 && points >= 0 && points <= games * 2);
+
+	m_games[player * m_playerCount + opponent] += games;
+	m_games[opponent * m_playerCount + player] += games;
+	m_playerGames[player] += games;
+	m_playerGames[opponent] += games;
+	m_points[player] += points;
+	m_points[opponent] += games * 2 - points;
+	m_solved = false;
+}
+
+void RatingSolver::clearGames()
+{
+	m_games.fill(0);
+	m_playerGames.fill(0);
+	m_points.fill(0);
+	m_solved = false;
+	m_covarianceValid = false;
+}
+
+void RatingSolver::setRating(int player, double rating)
+{
+	Q_ASSERT(player >= 0 && player < m_playerCount);
+
+	m_gamma[player] = std::exp(rating / EloScale);
+	m_solved = false;
+	m_covarianceValid = false;
+}
+
+void RatingSolver::iterate(int first, int last)
+{
+	// Minorization-maximization update of the Bradley-Terry model,
+	// which only reads the gamma values of the previous iteration
+	for (int i = first; i < last; i++)
+	{
+		if (m_playerGames[i] == 0)
+		{
+			m_nextGamma[i] = m_gamma[i];
+			continue;
+		}
+
+		const int* games = m_games.constData() + i * m_playerCount;
+		double wins = m_points[i] / 2.0;
+		double sum = 0.0;
+		for (int j = 0; j < m_playerCount; j++)
+		{
+			if (games[j] == 0)
+				continue;
+
+			const double n = games[j] + PriorDraws;
+			wins += PriorDraws / 2.0;
+			sum += n / (m_gamma[i] + m_gamma[j]);
+		}
+		m_nextGamma[i] = wins / sum;
+	}
+}
+
+bool RatingSolver::solve()
+{
+	if (m_solved)
+		return m_converged;
+
+	int activePlayers = 0;
+	for (int i = 0; i < m_playerCount; i++)
+	{
+		if (m_playerGames[i] > 0)
+			activePlayers++;
+	}
+	if (activePlayers == 0)
+		return true;
+
+	int taskCount = 1;
+	if (m_playerCount >= ParallelThreshold)
+		taskCount = qBound(1, QThread::idealThreadCount(),
+				   m_playerCount / (ParallelThreshold / 2));
+	QThreadPool pool;
+	pool.setMaxThreadCount(taskCount);
+
+	bool converged = false;
+	for (int iter = 0; iter < MaxIterations && !converged; iter++)
+	{
+		if (taskCount > 1)
+		{
+			for (int task = 0; task < taskCount; task++)
+			{
+				const int first = task * m_playerCount / taskCount;
+				const int last = (task + 1) * m_playerCount / taskCount;
+				pool.start(new SolverTask([this, first, last]()
+				{
+					iterate(first, last);
+				}));
+			}
+			pool.waitForDone();
+		}
+		else
+			iterate(0, m_playerCount);
+
+		// Keep the average rating at zero
+		double logSum = 0.0;
+		for (int i = 0; i < m_playerCount; i++)
+		{
+			if (m_playerGames[i] > 0)
+				logSum += std::log(m_nextGamma[i]);
+		}
+		const double scale = std::exp(-logSum / activePlayers);
+
+		double maxChange = 0.0;
+		for (int i = 0; i < m_playerCount; i++)
+		{
+			if (m_playerGames[i] == 0)
+				continue;
+
+			m_nextGamma[i] *= scale;
+			const double change = std::fabs(std::log(m_nextGamma[i]
+								 / m_gamma[i]));
+			maxChange = qMax(maxChange, change * EloScale);
+		}
+		m_gamma.swap(m_nextGamma);
+		converged = (maxChange < Tolerance);
+	}
+
+	m_solved = true;
+	m_converged = converged;
+	m_covarianceValid = false;
+	return converged;
+}
+
+void RatingSolver::updateCovariance() const
+{
+	if (m_covarianceValid)
+		return;
+	m_covarianceValid = true;
+
+	QVector<int> active;
+	for (int i = 0; i < m_playerCount; i++)
+	{
+		if (m_playerGames[i] > 0)
+			active.append(i);
+	}
+	const int n = active.size();
+	m_covariance.fill(0.0, m_playerCount * m_playerCount);
+
+	// The information matrix of the ratings is singular because
+	// only rating differences are known. Adding 1/n to every element
+	// fixes the average rating, and subtracting it from the inverse
+	// gives the covariances relative to that average.
+	QVector<double> a(n * n, 1.0 / n);
+	QVector<double> inv(n * n, 0.0);
+	for (int x = 0; x < n; x++)
+	{
+		const int i = active.at(x);
+		inv[x * n + x] = 1.0;
+		for (int y = 0; y < n; y++)
+		{
+			const int j = active.at(y);
+			const int games = m_games.at(i * m_playerCount + j);
+			if (games == 0)
+				continue;
+
+			const double p = m_gamma[i] / (m_gamma[i] + m_gamma[j]);
+			const double info = (games + PriorDraws) * p * (1.0 - p);
+			a[x * n + x] += info;
+			a[x * n + y] -= info;
+		}
+	}
+
+	// Gauss-Jordan elimination with partial pivoting
+	for (int col = 0; col < n; col++)
+	{
+		int pivot = col;
+		for (int row = col + 1; row < n; row++)
+		{
+			if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col]))
+				pivot = row;
+		}
+		// Players in separate groups can't be compared
+		if (std::fabs(a[pivot * n + col]) < 1.0e-12)
+		{
+			m_covariance.fill(std::numeric_limits<double>::infinity());
+			return;
+		}
+		for (int k = 0; k < n; k++)
+		{
+			qSwap(a[col * n + k], a[pivot * n + k]);
+			qSwap(inv[col * n + k], inv[pivot * n + k]);
+		}
+
+		const double d = a[col * n + col];
+		for (int k = 0; k < n; k++)
+		{
+			a[col * n + k] /= d;
+			inv[col * n + k] /= d;
+		}
+		for (int row = 0; row < n; row++)
+		{
+			const double f = a[row * n + col];
+			if (row == col || f == 0.0)
+				continue;
+			for (int k = 0; k < n; k++)
+			{
+				a[row * n + k] -= f * a[col * n + k];
+				inv[row * n + k] -= f * inv[col * n + k];
+			}
+		}
+	}
+
+	for (int x = 0; x < n; x++)
+	{
+		for (int y = 0; y < n; y++)
+		{
+			const int index = active.at(x) * m_playerCount + active.at(y);
+			m_covariance[index] = inv[x * n + y] - 1.0 / n;
+		}
+	}
+}
+
+int RatingSolver::games(int player) const
+{
+	return m_playerGames.at(player);
+}
+
+double RatingSolver::rating(int player) const
+{
+	return EloScale * std::log(m_gamma.at(player));
+}
+
+double RatingSolver::errorMargin(int player) const
+{
+	updateCovariance();
+	const double variance = m_covariance.at(player * m_playerCount + player);
+	return 1.959964 * EloScale * std::sqrt(qMax(variance, 0.0));
+}
+
+double RatingSolver::superiority(int player, int opponent) const
+{
+	if (player == opponent)
+		return 0.5;
+	updateCovariance();
+
+	const double variance = m_covariance.at(player * m_playerCount + player)
+			      + m_covariance.at(opponent * m_playerCount + opponent)
+			      - 2.0 * m_covariance.at(player * m_playerCount + opponent);
+	if (!(variance > 0.0) || std::isinf(variance))
+		return 0.5;
+
+	const double diff = (rating(player) - rating(opponent)) / EloScale;
+	return 0.5 * std::erfc(-diff / std::sqrt(2.0 * variance));
+}
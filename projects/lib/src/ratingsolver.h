@@ -0,0 +1,120 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RATINGSOLVER_H
+#define RATINGSOLVER_H
+
+#include <QVector>
+
+/*!
+ * \brief Maximum likelihood ratings for all players of a tournament
+ *
+ * Unlike Elo, which rates each player as if all of its games were
+ * played against a single opponent, RatingSolver fits the ratings of
+ * all players at once to the results between every pair of players
+ * (the Bradley-Terry model, with a draw counted as half a win). The
+ * ratings are on the logistic Elo scale and their average is zero.
+ *
+ * The fit only depends on the results between each pair of players,
+ * so its cost doesn't grow with the number of games. Each solve()
+ * starts from the previous solution, and the per-player updates are
+ * run in parallel in large tournaments.
+ *
+ * Each pair of players who have met gets one virtual draw, which keeps
+ * the ratings of players without wins or losses finite.
+ *
+ * A solve() without new games since the last one returns at once, and
+ * the covariances behind errorMargin() and superiority() are only
+ * computed when one of them is called after a solve().
+ */
+class LIB_EXPORT RatingSolver
+{
+	public:
+		/*! Creates a new solver for \a playerCount players. */
+		explicit RatingSolver(int playerCount = 0);
+
+		/*! Returns the number of players. */
+		int playerCount() const;
+		/*!
+		 * Clears all results and sets the number of players
+		 * to \a playerCount.
+		 */
+		void reset(int playerCount);
+		/*!
+		 * Adds a game between \a player and \a opponent where
+		 * \a player scored \a points half points (0, 1 or 2).
+		 */
+		void addGame(int player, int opponent, int points);
+		/*!
+		 * Adds \a games games between \a player and \a opponent
+		 * where \a player scored a total of \a points half points.
+		 */
+		void addGames(int player, int opponent, int games, int points);
+		/*!
+		 * Clears all results but keeps the ratings, so that the
+		 * next solve() starts from them.
+		 */
+		void clearGames();
+		/*!
+		 * Sets the rating of \a player to \a rating, which the
+		 * next solve() starts from. Ratings from an earlier fit
+		 * of mostly the same games converge in few iterations.
+		 */
+		void setRating(int player, double rating);
+
+		/*!
+		 * Fits the ratings to the current results.
+		 *
+		 * Returns false if the fit didn't converge, in which case
+		 * the ratings are the best approximation found.
+		 */
+		bool solve();
+
+		/*! Returns the number of games played by \a player. */
+		int games(int player) const;
+		/*! Returns the rating of \a player. */
+		double rating(int player) const;
+		/*! Returns the 95% error margin of \a player's rating. */
+		double errorMargin(int player) const;
+		/*!
+		 * Returns the likelihood of superiority of \a player over
+		 * \a opponent, ie. the probability that \a player is
+		 * stronger.
+		 */
+		double superiority(int player, int opponent) const;
+
+	private:
+		void iterate(int first, int last);
+		void updateCovariance() const;
+
+		int m_playerCount;
+		bool m_solved;
+		bool m_converged;
+		// Games between each pair of players
+		QVector<int> m_games;
+		// Games and half points of each player
+		QVector<int> m_playerGames;
+		QVector<int> m_points;
+		// Gamma values (10^(rating/400)) of the current and the
+		// next iteration
+		QVector<double> m_gamma;
+		QVector<double> m_nextGamma;
+		mutable QVector<double> m_covariance;
+		mutable bool m_covarianceValid;
+};
+
+#endif // RATINGSOLVER_H
@@ -0,0 +1,224 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "selectiontournament.h"
+#include <cmath>
+#include <QStringList>
+#include "chessgame.h"
+#include "playerbuilder.h"
+
+namespace {
+
+// Width of the confidence intervals in standard deviations (99%)
+const double Confidence = 2.576;
+// Candidates aren't compared before they have played this many games
+const int MinGames = 16;
+
+} // anonymous namespace
+
+SelectionTournament::SelectionTournament(GameManager* gameManager,
+					 EngineManager* engineManager,
+					 QObject *parent)
+	: Tournament(gameManager, engineManager, parent),
+	  m_candidate(-1),
+	  m_encounterGames(0)
+{
+}
+
+QString SelectionTournament::type() const
+{
+	return "selection";
+}
+
+QString SelectionTournament::results() const
+{
+	QString ret(Tournament::results());
+	if (m_droppedOrder.isEmpty())
+		return ret;
+
+	QStringList dropped;
+	for (int candidate : m_droppedOrder)
+	{
+		const TournamentPlayer& player(playerAt(candidate));
+		dropped << QString("%1 (%2 games)")
+			   .arg(player.name())
+			   .arg(player.gamesFinished());
+	}
+
+	return ret + "\nDropped: " + dropped.join(", ");
+}
+
+int SelectionTournament::gamesPerRound() const
+{
+	return (playerCount() - 1) * gamesPerEncounter();
+}
+
+QList< QPair<QString, QString> > SelectionTournament::getPairings()
+{
+	// The pairings depend on the results
+	QList< QPair<QString, QString> > pList;
+	return pList;
+}
+
+void SelectionTournament::onGameAboutToStart(ChessGame* game,
+					     const PlayerBuilder* white,
+					     const PlayerBuilder* black)
+{
+	Q_UNUSED(black);
+	const int blackIndex = playerIndex(game, Chess::Side::Black);
+	if (!white->isHuman() && blackIndex == 0)
+		game->setBoardShouldBeFlipped(true);
+}
+
+void SelectionTournament::initializePairing()
+{
+	m_candidate = 1;
+	m_encounterGames = 0;
+	m_gamesStarted.fill(0, playerCount());
+	m_dropped.fill(false, playerCount());
+	m_droppedOrder.clear();
+}
+
+int SelectionTournament::gamesPerCycle() const
+{
+	return playerCount() - 1;
+}
+
+bool SelectionTournament::canPlay(int candidate) const
+{
+	if (m_dropped.at(candidate))
+		return false;
+
+	// Same number of games as in a full Gauntlet tournament
+	return m_gamesStarted.at(candidate)
+		< gamesPerEncounter() * roundMultiplier();
+}
+
+bool SelectionTournament::needMoreGames() const
+{
+	// The games of an encounter share an opening
+	if (m_encounterGames > 0 && m_encounterGames < gamesPerEncounter())
+		return true;
+
+	int candidates = 0;
+	bool canContinue = false;
+	for (int i = 1; i < playerCount(); i++)
+	{
+		if (m_dropped.at(i))
+			continue;
+		candidates++;
+		if (canPlay(i))
+			canContinue = true;
+	}
+
+	// The selection is over when one candidate is left
+	if (candidates <= 1 && !m_droppedOrder.isEmpty())
+		return false;
+	return canContinue;
+}
+
+TournamentPair* SelectionTournament::nextPair(int gameNumber)
+{
+	Q_UNUSED(gameNumber);
+
+	if (!needMoreGames())
+		return nullptr;
+	if (m_encounterGames > 0 && m_encounterGames < gamesPerEncounter())
+	{
+		// m_candidate was already moved past the current candidate
+		m_encounterGames++;
+		m_gamesStarted[m_candidate - 1]++;
+		return currentPair();
+	}
+
+	for (int i = 0; i < playerCount(); i++)
+	{
+		if (m_candidate >= playerCount())
+		{
+			m_candidate = 1;
+			setCurrentRound(currentRound() + 1);
+		}
+
+		const int candidate = m_candidate++;
+		if (canPlay(candidate))
+		{
+			m_encounterGames = 1;
+			m_gamesStarted[candidate]++;
+			return pair(0, candidate);
+		}
+	}
+
+	return nullptr;
+}
+
+void SelectionTournament::addScore(int player, int score)
+{
+	Tournament::addScore(player, score);
+	if (player != 0)
+		dropCandidates();
+}
+
+SelectionTournament::ScoreBounds SelectionTournament::scoreBounds(int candidate) const
+{
+	const TournamentPlayer& player(playerAt(candidate));
+	const double n = player.gamesFinished();
+	const double w = player.wins() / n;
+	const double d = player.draws() / n;
+	const double l = player.losses() / n;
+	const double mu = w + d / 2.0;
+
+	const double variance = w * std::pow(1.0 - mu, 2.0)
+			      + d * std::pow(0.5 - mu, 2.0)
+			      + l * std::pow(0.0 - mu, 2.0);
+	const double margin = Confidence * std::sqrt(variance / n);
+
+	ScoreBounds bounds = { mu - margin, mu + margin };
+	return bounds;
+}
+
+void SelectionTournament::dropCandidates()
+{
+	// The leader is the candidate with the highest lower bound
+	double leaderBound = -1.0;
+	for (int i = 1; i < playerCount(); i++)
+	{
+		if (m_dropped.at(i) || playerAt(i).gamesFinished() < MinGames)
+			continue;
+		leaderBound = qMax(leaderBound, scoreBounds(i).lower);
+	}
+
+	for (int i = 1; i < playerCount(); i++)
+	{
+		if (m_dropped.at(i) || playerAt(i).gamesFinished() < MinGames)
+			continue;
+		if (scoreBounds(i).upper < leaderBound)
+		{
+			m_dropped[i] = true;
+			m_droppedOrder.append(i);
+		}
+	}
+}
+
+bool SelectionTournament::areAllGamesFinished() const
+{
+	return gamesInProgress() == 0 && !needMoreGames();
+}
+
+bool SelectionTournament::hasGauntletRatingsOrder() const
+{
+	return true;
+}
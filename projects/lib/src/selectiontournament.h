@@ -0,0 +1,80 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELECTIONTOURNAMENT_H
+#define SELECTIONTOURNAMENT_H
+
+#include "tournament.h"
+
+/*!
+ * \brief Selection (racing) type chess tournament.
+ *
+ * Like in a Gauntlet tournament the first participant, the reference,
+ * plays against all the others, the candidates. The candidates play
+ * their encounters in turns, and a candidate is dropped as soon as the
+ * upper confidence bound of its score falls below the lower bound of
+ * the leading candidate's score. The remaining candidates play until
+ * they reach the number of games of a full Gauntlet tournament, or
+ * until only one of them is left.
+ */
+class LIB_EXPORT SelectionTournament : public Tournament
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new Selection tournament. */
+		explicit SelectionTournament(GameManager* gameManager,
+					     EngineManager* engineManager,
+					     QObject *parent = nullptr);
+		// Inherited from Tournament
+		virtual QString type() const;
+		virtual QString results() const;
+		virtual int gamesPerRound() const;
+		virtual QList< QPair<QString, QString> > getPairings();
+
+	protected:
+		// Inherited from Tournament
+		virtual void onGameAboutToStart(ChessGame* game,
+						const PlayerBuilder* white,
+						const PlayerBuilder* black);
+		virtual void initializePairing();
+		virtual int gamesPerCycle() const;
+		virtual TournamentPair* nextPair(int gameNumber);
+		virtual void addScore(int player, int score);
+		virtual bool areAllGamesFinished() const;
+		virtual bool hasGauntletRatingsOrder() const;
+
+	private:
+		struct ScoreBounds
+		{
+			double lower;
+			double upper;
+		};
+
+		ScoreBounds scoreBounds(int candidate) const;
+		void dropCandidates();
+		bool needMoreGames() const;
+		bool canPlay(int candidate) const;
+
+		int m_candidate;
+		int m_encounterGames;
+		QVector<int> m_gamesStarted;
+		QVector<bool> m_dropped;
+		QList<int> m_droppedOrder;
+};
+
+#endif // SELECTIONTOURNAMENT_H
@@ -19,6 +19,65 @@
 #include <cmath>
 #include <QtGlobal>
 
+namespace {
+
+/*
+ * Returns the Lagrange multiplier of the maximum likelihood estimate of
+ * the pair score distribution with its mean fixed at \a mean, from the
+ * observed frequencies \a p of the scores \a s.
+ *
+ * Returns false if the mean is outside the observed scores.
+ */
+bool pairScoreLambda(const double* p, const double* s, double mean,
+		     double* lambda)
+{
+	double minDiff = 0.0;
+	double maxDiff = 0.0;
+	for (int i = 0; i < 5; i++)
+	{
+		if (p[i] <= 0.0)
+			continue;
+		minDiff = qMin(minDiff, s[i] - mean);
+		maxDiff = qMax(maxDiff, s[i] - mean);
+	}
+	if (minDiff >= 0.0 || maxDiff <= 0.0)
+		return false;
+
+	// The estimate's probabilities stay positive in (lo, hi), where
+	// the constraint function decreases monotonically
+	double lo = -1.0 / maxDiff;
+	double hi = -1.0 / minDiff;
+	const double margin = (hi - lo) * 1.0e-9;
+	lo += margin;
+	hi -= margin;
+
+	for (int iter = 0; iter < 100; iter++)
+	{
+		const double mid = (lo + hi) / 2.0;
+		double f = 0.0;
+		for (int i = 0; i < 5; i++)
+		{
+			if (p[i] > 0.0)
+				f += p[i] * (s[i] - mean)
+				     / (1.0 + mid * (s[i] - mean));
+		}
+		if (f > 0.0)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	*lambda = (lo + hi) / 2.0;
+	return true;
+}
+
+double logisticScore(double elo)
+{
+	return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+} // anonymous namespace
+
 class BayesElo;
 class SprtProbability;
 
@@ -130,7 +189,8 @@ double SprtProbability::pDraw() const
 
 
 Sprt::Sprt()
-	: m_elo0(0),
+	: m_model(Trinomial),
+	  m_elo0(0),
 	  m_elo1(0),
 	  m_alpha(0),
 	  m_beta(0),
@@ -138,6 +198,8 @@ Sprt::Sprt()
 	  m_losses(0),
 	  m_draws(0)
 {
+	for (int i = 0; i < 5; i++)
+		m_pairs[i] = 0;
 }
 
 bool Sprt::isNull() const
@@ -154,6 +216,16 @@ void Sprt::initialize(double elo0, double elo1,
 	m_beta = beta;
 }
 
+Sprt::Model Sprt::model() const
+{
+	return m_model;
+}
+
+void Sprt::setModel(Model model)
+{
+	m_model = model;
+}
+
 Sprt::Status Sprt::status() const
 {
 	Status status = {
@@ -163,6 +235,8 @@ Sprt::Status Sprt::status() const
 		0.0
 	};
 
+	if (m_model == Pentanomial)
+		return pentanomialStatus();
 	if (m_wins <= 0 || m_losses <= 0 || m_draws <= 0)
 		return status;
 
@@ -202,3 +276,69 @@ void Sprt::addGameResult(GameResult result)
 	else if (result == Loss)
 		m_losses++;
 }
+
+void Sprt::addGamePair(GameResult first, GameResult second)
+{
+	if (first == NoResult || second == NoResult)
+		return;
+
+	auto points = [](GameResult result)
+	{
+		return result == Win ? 2 : (result == Draw ? 1 : 0);
+	};
+	m_pairs[points(first) + points(second)]++;
+}
+
+Sprt::Status Sprt::pentanomialStatus() const
+{
+	Status status = {
+		Continue,
+		0.0,
+		0.0,
+		0.0
+	};
+
+	int count = 0;
+	for (int i = 0; i < 5; i++)
+		count += m_pairs[i];
+	if (count <= 0)
+		return status;
+
+	// Observed pair score frequencies, scores scaled to [0, 1]
+	double p[5];
+	double s[5];
+	for (int i = 0; i < 5; i++)
+	{
+		p[i] = double(m_pairs[i]) / count;
+		s[i] = i / 4.0;
+	}
+
+	// Generalized SPRT: the likelihood ratio of the maximum
+	// likelihood distributions with the expected scores of H1 and H0
+	const double mean0 = logisticScore(m_elo0);
+	const double mean1 = logisticScore(m_elo1);
+	double lambda0 = 0.0;
+	double lambda1 = 0.0;
+	if (!pairScoreLambda(p, s, mean0, &lambda0)
+	||  !pairScoreLambda(p, s, mean1, &lambda1))
+		return status;
+
+	double llr = 0.0;
+	for (int i = 0; i < 5; i++)
+	{
+		if (p[i] > 0.0)
+			llr += p[i] * (std::log(1.0 + lambda0 * (s[i] - mean0))
+				       - std::log(1.0 + lambda1 * (s[i] - mean1)));
+	}
+	status.llr = count * llr;
+
+	status.lBound = std::log(m_beta / (1.0 - m_alpha));
+	status.uBound = std::log((1.0 - m_beta) / m_alpha);
+
+	if (status.llr > status.uBound)
+		status.result = AcceptH1;
+	else if (status.llr < status.lBound)
+		status.result = AcceptH0;
+
+	return status;
+}
@@ -26,6 +26,11 @@
  * players when the Elo difference is known to be outside of the specified
  * interval.
  *
+ * By default the test counts wins, draws and losses of single games.
+ * When each opening is played twice with the colors reversed the two
+ * games are correlated, and the pentanomial model, which counts the
+ * total scores of game pairs, reaches a decision with fewer games.
+ *
  * \sa http://en.wikipedia.org/wiki/Sequential_probability_ratio_test
  */
 class LIB_EXPORT Sprt
@@ -48,6 +53,30 @@ class LIB_EXPORT Sprt
 			Draw		//!< Game was drawn
 		};
 
+		/*! The statistical model of the test. */
+		enum Model
+		{
+			/*!
+			 * Single game results, with the Elo difference
+			 * measured in BayesElo.
+			 */
+			Trinomial,
+			/*!
+			 * Game pair scores (0, 0.5, 1, 1.5 or 2 points), with
+			 * the Elo difference measured on the logistic scale.
+			 */
+			Pentanomial
+		};
+
+		/*! When a decision of the test stops the tournament. */
+		enum StopPolicy
+		{
+			StopOnDecision,	//!< Stop when H0 or H1 is accepted
+			StopOnH0,	//!< Stop only when H0 is accepted
+			StopOnH1,	//!< Stop only when H1 is accepted
+			NeverStop	//!< Only monitor the test
+		};
+
 		/*! The status of the test. */
 		struct Status
 		{
@@ -77,6 +106,13 @@ class LIB_EXPORT Sprt
 		 */
 		void initialize(double elo0, double elo1,
 				double alpha, double beta);
+		/*! Returns the statistical model. */
+		Model model() const;
+		/*!
+		 * Sets the statistical model to \a model.
+		 * The default model is Trinomial.
+		 */
+		void setModel(Model model);
 		/*! Returns the current status of the test. */
 		Status status() const;
 		/*!
@@ -86,8 +122,18 @@ class LIB_EXPORT Sprt
 		 * check if H0 or H1 can be accepted.
 		 */
 		void addGameResult(GameResult result);
+		/*!
+		 * Updates the test with the results \a first and \a second
+		 * of a game pair in the Pentanomial model.
+		 *
+		 * The pair is ignored if either game has no result.
+		 */
+		void addGamePair(GameResult first, GameResult second);
 
 	private:
+		Status pentanomialStatus() const;
+
+		Model m_model;
 		double m_elo0;
 		double m_elo1;
 		double m_alpha;
@@ -95,6 +141,7 @@ class LIB_EXPORT Sprt
 		int m_wins;
 		int m_losses;
 		int m_draws;
+		int m_pairs[5];
 };
 
 #endif // SPRT_H
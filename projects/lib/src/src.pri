@@ -6,13 +6,23 @@ HEADERS += $$PWD/chessengine.h \
     $$PWD/chessplayer.h \
     $$PWD/engineconfiguration.h \
     $$PWD/openingbook.h \
+    $$PWD/openingbookregistry.h \
     $$PWD/pgnstream.h \
+    $$PWD/pgnindexer.h \
     $$PWD/pgngame.h \
+    $$PWD/pgntaglist.h \
+    $$PWD/gamearchive.h \
+    $$PWD/gamepool.h \
+    $$PWD/trainingdata.h \
+    $$PWD/gamewriter.h \
+    $$PWD/gzipdevice.h \
     $$PWD/polyglotbook.h \
     $$PWD/timecontrol.h \
     $$PWD/uciengine.h \
     $$PWD/xboardengine.h \
     $$PWD/moveevaluation.h \
+    $$PWD/enginehandshakecache.h \
+    $$PWD/gameresultcache.h \
     $$PWD/enginemanager.h \
     $$PWD/humanplayer.h \
     $$PWD/engineoption.h \
@@ -25,22 +35,49 @@ HEADERS += $$PWD/chessengine.h \
     $$PWD/gamemanager.h \
     $$PWD/playerbuilder.h \
     $$PWD/enginebuilder.h \
+    $$PWD/enginedebuglog.h \
     $$PWD/classregistry.h \
+    $$PWD/cpuaffinity.h \
+    $$PWD/cgroup.h \
+    $$PWD/processusage.h \
+    $$PWD/movetimestats.h \
+    $$PWD/throughputstats.h \
+    $$PWD/memorystats.h \
+    $$PWD/tracer.h \
+    $$PWD/bootstrapratings.h \
+    $$PWD/pgnduplicatefinder.h \
+    $$PWD/openingtree.h \
+    $$PWD/hostload.h \
+    $$PWD/hostcalibration.h \
+    $$PWD/indexpermutation.h \
+    $$PWD/eventring.h \
+    $$PWD/tablebaseprober.h \
+    $$PWD/clockservice.h \
     $$PWD/enginefactory.h \
     $$PWD/humanbuilder.h \
     $$PWD/engineoptionfactory.h \
     $$PWD/pgngamefilter.h \
+    $$PWD/pgntagpool.h \
+    $$PWD/positionindex.h \
+    $$PWD/pgnentryindex.h \
+    $$PWD/keyset.h \
     $$PWD/tournament.h \
     $$PWD/roundrobintournament.h \
     $$PWD/tournamentfactory.h \
     $$PWD/gauntlettournament.h \
+    $$PWD/selectiontournament.h \
+    $$PWD/swisstournament.h \
     $$PWD/epdrecord.h \
     $$PWD/openingsuite.h \
+    $$PWD/openingprefetcher.h \
+    $$PWD/openingcache.h \
     $$PWD/econode.h \
     $$PWD/mersenne.h \
     $$PWD/sprt.h \
     $$PWD/gameadjudicator.h \
     $$PWD/elo.h \
+    $$PWD/ratingsolver.h \
+    $$PWD/ratingsdatabase.h \
     $$PWD/knockouttournament.h \
     $$PWD/tournamentplayer.h \
     $$PWD/tournamentpair.h \
@@ -50,13 +87,23 @@ SOURCES += $$PWD/chessengine.cpp \
     $$PWD/chessplayer.cpp \
     $$PWD/engineconfiguration.cpp \
     $$PWD/openingbook.cpp \
+    $$PWD/openingbookregistry.cpp \
     $$PWD/pgnstream.cpp \
+    $$PWD/pgnindexer.cpp \
     $$PWD/pgngame.cpp \
+    $$PWD/pgntaglist.cpp \
+    $$PWD/gamearchive.cpp \
+    $$PWD/gamepool.cpp \
+    $$PWD/trainingdata.cpp \
+    $$PWD/gamewriter.cpp \
+    $$PWD/gzipdevice.cpp \
     $$PWD/polyglotbook.cpp \
     $$PWD/timecontrol.cpp \
     $$PWD/uciengine.cpp \
     $$PWD/xboardengine.cpp \
     $$PWD/moveevaluation.cpp \
+    $$PWD/enginehandshakecache.cpp \
+    $$PWD/gameresultcache.cpp \
     $$PWD/enginemanager.cpp \
     $$PWD/humanplayer.cpp \
     $$PWD/engineoption.cpp \
@@ -69,21 +116,47 @@ SOURCES += $$PWD/chessengine.cpp \
     $$PWD/gamemanager.cpp \
     $$PWD/playerbuilder.cpp \
     $$PWD/enginebuilder.cpp \
+    $$PWD/enginedebuglog.cpp \
+    $$PWD/cpuaffinity.cpp \
+    $$PWD/cgroup.cpp \
+    $$PWD/processusage.cpp \
+    $$PWD/movetimestats.cpp \
+    $$PWD/throughputstats.cpp \
+    $$PWD/memorystats.cpp \
+    $$PWD/tracer.cpp \
+    $$PWD/bootstrapratings.cpp \
+    $$PWD/pgnduplicatefinder.cpp \
+    $$PWD/openingtree.cpp \
+    $$PWD/hostload.cpp \
+    $$PWD/hostcalibration.cpp \
+    $$PWD/indexpermutation.cpp \
+    $$PWD/tablebaseprober.cpp \
+    $$PWD/clockservice.cpp \
     $$PWD/enginefactory.cpp \
     $$PWD/humanbuilder.cpp \
     $$PWD/engineoptionfactory.cpp \
     $$PWD/pgngamefilter.cpp \
+    $$PWD/pgntagpool.cpp \
+    $$PWD/positionindex.cpp \
+    $$PWD/pgnentryindex.cpp \
+    $$PWD/keyset.cpp \
     $$PWD/tournament.cpp \
     $$PWD/roundrobintournament.cpp \
     $$PWD/tournamentfactory.cpp \
     $$PWD/gauntlettournament.cpp \
+    $$PWD/selectiontournament.cpp \
+    $$PWD/swisstournament.cpp \
     $$PWD/epdrecord.cpp \
     $$PWD/openingsuite.cpp \
+    $$PWD/openingprefetcher.cpp \
+    $$PWD/openingcache.cpp \
     $$PWD/econode.cpp \
     $$PWD/mersenne.cpp \
     $$PWD/sprt.cpp \
     $$PWD/gameadjudicator.cpp \
     $$PWD/elo.cpp \
+    $$PWD/ratingsolver.cpp \
+    $$PWD/ratingsdatabase.cpp \
     $$PWD/knockouttournament.cpp \
     $$PWD/tournamentplayer.cpp \
     $$PWD/tournamentpair.cpp \
@@ -94,3 +167,7 @@ win32 {
     SOURCES += $$PWD/engineprocess_win.cpp \
 	$$PWD/pipereader_win.cpp
 }
+unix {
+    HEADERS += $$PWD/engineprocess_unix.h
+    SOURCES += $$PWD/engineprocess_unix.cpp
+}
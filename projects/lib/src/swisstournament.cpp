@@ -0,0 +1,324 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "swisstournament.h"
+#include <algorithm>
+#include <QStringList>
+#include "chessgame.h"
+#include "playerbuilder.h"
+
+namespace {
+
+// Upper limit for the pairing search of one score group
+const int MaxSearchNodes = 100000;
+
+} // anonymous namespace
+
+SwissTournament::SwissTournament(GameManager* gameManager,
+				 EngineManager* engineManager,
+				 QObject *parent)
+	: Tournament(gameManager, engineManager, parent),
+	  m_pairingRound(0),
+	  m_encounterGames(0)
+{
+	connect(this, SIGNAL(gameFinished(ChessGame*, int, int, int)),
+		this, SLOT(onSwissGameFinished(ChessGame*, int, int, int)));
+}
+
+QString SwissTournament::type() const
+{
+	return "swiss";
+}
+
+QString SwissTournament::results() const
+{
+	QString ret(Tournament::results());
+	if (m_byes.isEmpty())
+		return ret;
+
+	QStringList byes;
+	for (int player : m_byes)
+		byes << playerAt(player).name();
+
+	return ret + "\nByes: " + byes.join(", ");
+}
+
+int SwissTournament::gamesPerRound() const
+{
+	return gamesPerCycle() * gamesPerEncounter();
+}
+
+QList< QPair<QString, QString> > SwissTournament::getPairings()
+{
+	// The pairings depend on the results
+	QList< QPair<QString, QString> > pList;
+	return pList;
+}
+
+void SwissTournament::onGameAboutToStart(ChessGame* game,
+					 const PlayerBuilder* white,
+					 const PlayerBuilder* black)
+{
+	Q_UNUSED(white);
+	Q_UNUSED(black);
+
+	m_colorBalance[playerIndex(game, Chess::Side::White)]++;
+	m_colorBalance[playerIndex(game, Chess::Side::Black)]--;
+}
+
+void SwissTournament::initializePairing()
+{
+	m_pairingRound = 1;
+	m_encounterGames = 0;
+	m_encounters.clear();
+	m_pairedRound.fill(0, playerCount());
+	m_gamesLeft.fill(0, playerCount());
+	m_colorBalance.fill(0, playerCount());
+	m_byeScore.fill(0, playerCount());
+	m_byes.clear();
+}
+
+int SwissTournament::gamesPerCycle() const
+{
+	return playerCount() / 2;
+}
+
+TournamentPair* SwissTournament::nextPair(int gameNumber)
+{
+	Q_UNUSED(gameNumber);
+
+	if (m_encounterGames > 0 && m_encounterGames < gamesPerEncounter())
+	{
+		m_encounterGames++;
+		return currentPair();
+	}
+
+	if (m_encounters.isEmpty())
+		pairPlayers();
+	if (m_encounters.isEmpty())
+		return nullptr;
+
+	const Encounter encounter = m_encounters.takeFirst();
+	setCurrentRound(encounter.round);
+	m_encounterGames = 1;
+
+	return encounter.pair;
+}
+
+void SwissTournament::onSwissGameFinished(ChessGame* game,
+					  int number,
+					  int whiteIndex,
+					  int blackIndex)
+{
+	Q_UNUSED(game);
+	Q_UNUSED(number);
+
+	m_gamesLeft[whiteIndex] = qMax(0, m_gamesLeft.at(whiteIndex) - 1);
+	m_gamesLeft[blackIndex] = qMax(0, m_gamesLeft.at(blackIndex) - 1);
+}
+
+int SwissTournament::swissScore(int player) const
+{
+	return playerAt(player).score() + m_byeScore.at(player);
+}
+
+void SwissTournament::pairPlayers()
+{
+	if (m_pairingRound > roundMultiplier())
+		return;
+
+	QList<int> pool;
+	for (int i = 0; i < playerCount(); i++)
+	{
+		if (m_pairedRound.at(i) < m_pairingRound)
+			pool << i;
+	}
+	// Order by score, then by seed
+	std::stable_sort(pool.begin(), pool.end(), [this](int a, int b)
+	{
+		return swissScore(a) > swissScore(b);
+	});
+
+	// Players who are still playing the previous round may still
+	// reach any score group up to their maximum score
+	bool blocked = false;
+	int blockScore = 0;
+	for (int player : pool)
+	{
+		if (m_gamesLeft.at(player) == 0)
+			continue;
+
+		const int maxScore = swissScore(player)
+				     + m_gamesLeft.at(player) * 2;
+		blockScore = blocked ? qMax(blockScore, maxScore) : maxScore;
+		blocked = true;
+	}
+
+	QList<int> floaters;
+	int i = 0;
+	while (i < pool.size())
+	{
+		const int score = swissScore(pool.at(i));
+		if (blocked && score <= blockScore)
+			break;
+
+		QList<int> bracket(floaters);
+		while (i < pool.size() && swissScore(pool.at(i)) == score)
+			bracket << pool.at(i++);
+
+		const bool lastBracket = (i >= pool.size() && !blocked);
+		QList< QPair<int, int> > pairs;
+		floaters.clear();
+		pairBracket(bracket, lastBracket, &pairs, &floaters);
+
+		for (const auto& match : pairs)
+			addEncounter(match.first, match.second);
+	}
+	if (i < pool.size() || blocked)
+		return;
+
+	// The round is fully paired
+	for (int player : floaters)
+	{
+		m_byes << player;
+		m_byeScore[player] += gamesPerEncounter() * 2;
+		m_pairedRound[player] = m_pairingRound;
+	}
+	m_pairingRound++;
+}
+
+bool SwissTournament::pairBracket(const QList<int>& players,
+				  bool lastBracket,
+				  QList< QPair<int, int> >* pairs,
+				  QList<int>* floaters)
+{
+	const int minFloaters = players.size() % 2;
+
+	// Rematches are only allowed in the last score group, and only
+	// if there's no other way to pair it
+	for (int pass = 0; pass < (lastBracket ? 2 : 1); pass++)
+	{
+		for (int count = minFloaters; count <= players.size(); count += 2)
+		{
+			if (lastBracket && count > minFloaters)
+				break;
+
+			BracketSearch search;
+			search.players = players;
+			search.used.fill(false, players.size());
+			search.allowRematches = (pass > 0);
+			search.lastBracket = lastBracket;
+			search.nodes = 0;
+
+			if (searchBracket(&search, count))
+			{
+				*pairs = search.pairs;
+				*floaters = search.floaters;
+				return true;
+			}
+		}
+	}
+
+	// Pair the remaining players in order
+	pairs->clear();
+	floaters->clear();
+	for (int i = 0; i + 1 < players.size(); i += 2)
+		pairs->append(qMakePair(players.at(i), players.at(i + 1)));
+	if (minFloaters)
+		floaters->append(players.last());
+	return false;
+}
+
+bool SwissTournament::searchBracket(BracketSearch* search, int floaters)
+{
+	if (++search->nodes > MaxSearchNodes)
+		return false;
+
+	const int n = search->players.size();
+	int i = 0;
+	while (i < n && search->used.at(i))
+		i++;
+	if (i >= n)
+		return true;
+
+	const int player = search->players.at(i);
+	search->used[i] = true;
+
+	// The preferred opponent is at the same position in the lower
+	// half of the group, and the fallbacks are the next players in
+	// the lower half and then the ones closer to the player
+	QVector<int> order;
+	const int half = n / 2;
+	for (int j = i + half; j < n; j++)
+		order << j;
+	for (int j = qMin(i + half, n) - 1; j > i; j--)
+		order << j;
+
+	for (int j : order)
+	{
+		if (search->used.at(j))
+			continue;
+
+		const int opponent = search->players.at(j);
+		if (!search->allowRematches
+		&&  pair(player, opponent)->gamesStarted() > 0)
+			continue;
+
+		search->used[j] = true;
+		search->pairs.append(qMakePair(player, opponent));
+		if (searchBracket(search, floaters))
+			return true;
+		search->pairs.removeLast();
+		search->used[j] = false;
+	}
+
+	// In the last group a floater gets a bye, and players who
+	// already had one are skipped if possible
+	if (floaters > 0
+	&&  (!search->lastBracket || search->allowRematches
+	     || !m_byes.contains(player)))
+	{
+		search->floaters.append(player);
+		if (searchBracket(search, floaters - 1))
+			return true;
+		search->floaters.removeLast();
+	}
+
+	search->used[i] = false;
+	return false;
+}
+
+void SwissTournament::addEncounter(int player1, int player2)
+{
+	// The player with fewer games as white gets white, and the
+	// higher-ranked player wins ties
+	int white = player1;
+	if (m_colorBalance.at(player2) < m_colorBalance.at(player1))
+		white = player2;
+
+	TournamentPair* encounter = pair(player1, player2);
+	if (encounter->firstPlayer() != white)
+		encounter->swapPlayers();
+
+	m_pairedRound[player1] = m_pairingRound;
+	m_pairedRound[player2] = m_pairingRound;
+	m_gamesLeft[player1] = gamesPerEncounter();
+	m_gamesLeft[player2] = gamesPerEncounter();
+
+	const Encounter entry = { encounter, m_pairingRound };
+	m_encounters.append(entry);
+}
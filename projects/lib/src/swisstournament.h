@@ -0,0 +1,108 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SWISSTOURNAMENT_H
+#define SWISSTOURNAMENT_H
+
+#include "tournament.h"
+#include <QPair>
+
+/*!
+ * \brief Swiss-system chess tournament.
+ *
+ * In each round the players are paired with opponents who have the
+ * same score, or a close one, and who they haven't met before. The
+ * number of rounds is set with setRoundMultiplier().
+ *
+ * The pairing follows the Dutch system: the players of each score
+ * group are split into an upper and a lower half, the upper half is
+ * paired with the lower half in rating (seed) order, and players who
+ * can't be paired float down to the next group. A player without an
+ * opponent gets a bye, which counts as a won encounter.
+ *
+ * The score groups are paired from the top down as soon as the scores
+ * of their players are final, so the next round starts while the last
+ * games of the previous round are still in progress.
+ */
+class LIB_EXPORT SwissTournament : public Tournament
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new Swiss tournament. */
+		explicit SwissTournament(GameManager* gameManager,
+					 EngineManager* engineManager,
+					 QObject *parent = nullptr);
+
+		// Inherited from Tournament
+		virtual QString type() const;
+		virtual QString results() const;
+		virtual int gamesPerRound() const;
+		virtual QList< QPair<QString, QString> > getPairings();
+
+	protected:
+		// Inherited from Tournament
+		virtual void onGameAboutToStart(ChessGame* game,
+						const PlayerBuilder* white,
+						const PlayerBuilder* black);
+		virtual void initializePairing();
+		virtual int gamesPerCycle() const;
+		virtual TournamentPair* nextPair(int gameNumber);
+
+	private slots:
+		void onSwissGameFinished(ChessGame* game,
+					 int number,
+					 int whiteIndex,
+					 int blackIndex);
+
+	private:
+		struct Encounter
+		{
+			TournamentPair* pair;
+			int round;
+		};
+		struct BracketSearch
+		{
+			QList<int> players;
+			QVector<bool> used;
+			QList< QPair<int, int> > pairs;
+			QList<int> floaters;
+			bool allowRematches;
+			bool lastBracket;
+			int nodes;
+		};
+
+		int swissScore(int player) const;
+		void pairPlayers();
+		bool pairBracket(const QList<int>& players,
+				 bool lastBracket,
+				 QList< QPair<int, int> >* pairs,
+				 QList<int>* floaters);
+		bool searchBracket(BracketSearch* search, int floaters);
+		void addEncounter(int player1, int player2);
+
+		int m_pairingRound;
+		int m_encounterGames;
+		QList<Encounter> m_encounters;
+		QVector<int> m_pairedRound;
+		QVector<int> m_gamesLeft;
+		QVector<int> m_colorBalance;
+		QVector<int> m_byeScore;
+		QList<int> m_byes;
+};
+
+#endif // SWISSTOURNAMENT_H
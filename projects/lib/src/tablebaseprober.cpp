@@ -0,0 +1,127 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tablebaseprober.h"
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include "board/board.h"
+#include "board/boardfactory.h"
+#include "board/syzygytablebase.h"
+
+
+class TablebaseProber::Task : public QRunnable
+{
+	public:
+		Task(TablebaseProber* prober)
+			: m_prober(prober)
+		{
+		}
+
+		virtual void run()
+		{
+			Chess::Board* board = m_prober->m_board;
+			if (board->setFenString(m_prober->m_fen))
+				m_prober->m_result = board->tablebaseResult();
+			else
+				m_prober->m_result = Chess::Result();
+
+			// The prober waits for the semaphore before it's
+			// destroyed, so it's still alive here
+			emit m_prober->finished();
+			m_prober->m_done.release();
+		}
+
+	private:
+		TablebaseProber* m_prober;
+};
+
+
+TablebaseProber::TablebaseProber(const QString& variant, QObject* parent)
+	: QObject(parent),
+	  m_board(Chess::BoardFactory::create(variant)),
+	  m_pending(false)
+{
+	Q_ASSERT(m_board != nullptr);
+	m_board->initialize();
+}
+
+TablebaseProber::~TablebaseProber()
+{
+	if (m_pending)
+		m_done.acquire();
+	delete m_board;
+}
+
+QThreadPool* TablebaseProber::threadPool()
+{
+	// A few threads are enough: most probes are answered by the
+	// probe cache or the OS page cache
+	static QThreadPool* pool = []()
+	{
+		auto pool = new QThreadPool;
+		pool->setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 8));
+		return pool;
+	}();
+
+	return pool;
+}
+
+bool TablebaseProber::canProbe(const Chess::Board* board)
+{
+	const int count = board->pieceCount();
+	return count <= SyzygyTablebase::maxPieces()
+	    && SyzygyTablebase::tbAvailable(count);
+}
+
+bool TablebaseProber::isPending() const
+{
+	return m_pending;
+}
+
+void TablebaseProber::probe(const Chess::Board* board)
+{
+	Q_ASSERT(!m_pending);
+
+	m_pending = true;
+	m_fen = board->fenString();
+
+	Task* task = new Task(this);
+	task->setAutoDelete(true);
+	threadPool()->start(task);
+}
+
+bool TablebaseProber::takeResult(Chess::Result* result)
+{
+	if (!m_pending || !m_done.tryAcquire())
+		return false;
+
+	m_pending = false;
+	*result = m_result;
+	return true;
+}
+
+bool TablebaseProber::waitForResult(Chess::Result* result)
+{
+	if (!m_pending)
+		return false;
+
+	m_done.acquire();
+	m_pending = false;
+	*result = m_result;
+	return true;
+}
@@ -0,0 +1,95 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TABLEBASEPROBER_H
+#define TABLEBASEPROBER_H
+
+#include <QObject>
+#include <QSemaphore>
+#include <QString>
+#include "board/result.h"
+namespace Chess { class Board; }
+class QThreadPool;
+
+
+/*!
+ * \brief Probes the tablebases for a game without blocking it
+ *
+ * TablebaseProber takes a snapshot of a position and probes it on a
+ * small thread pool shared by all games, so a slow probe (eg. from
+ * tablebases on a network drive) doesn't hold up the game's thread.
+ * The finished() signal is emitted when the result is available,
+ * and it's delivered to the prober's own thread.
+ *
+ * Only one probe per prober can be in progress at a time.
+ *
+ * \sa SyzygyTablebase, GameAdjudicator
+ */
+class LIB_EXPORT TablebaseProber : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new prober for positions of \a variant. */
+		TablebaseProber(const QString& variant, QObject* parent = nullptr);
+		/*! Waits for a running probe and destroys the prober. */
+		virtual ~TablebaseProber();
+
+		/*!
+		 * Returns true if \a board has few enough pieces to be
+		 * found in the tablebases; otherwise returns false.
+		 */
+		static bool canProbe(const Chess::Board* board);
+
+		/*! Returns true if a probe's result hasn't been taken yet. */
+		bool isPending() const;
+		/*!
+		 * Starts probing the current position of \a board.
+		 * No probe may be pending.
+		 */
+		void probe(const Chess::Board* board);
+		/*!
+		 * Takes the result of a finished probe into \a result.
+		 *
+		 * Returns false if no probe is pending or if the probe is
+		 * still running.
+		 */
+		bool takeResult(Chess::Result* result);
+		/*!
+		 * Waits for the pending probe to finish and takes its result
+		 * into \a result.
+		 *
+		 * Returns false if no probe is pending.
+		 */
+		bool waitForResult(Chess::Result* result);
+
+	signals:
+		/*! This signal is emitted when a probe has finished. */
+		void finished();
+
+	private:
+		class Task;
+		static QThreadPool* threadPool();
+
+		Chess::Board* m_board;
+		QString m_fen;
+		Chess::Result m_result;
+		bool m_pending;
+		QSemaphore m_done;
+};
+
+#endif // TABLEBASEPROBER_H
@@ -0,0 +1,118 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "throughputstats.h"
+
+ThroughputStats::ThroughputStats()
+	: m_firstStart(-1),
+	  m_gameCount(0),
+	  m_durationSum(0),
+	  m_plySum(0),
+	  m_setupSum(0),
+	  m_setupCount(0)
+{
+}
+
+void ThroughputStats::addGameStart(int number, qint64 time)
+{
+	if (m_firstStart < 0)
+		m_firstStart = time;
+	m_startTimes[number] = time;
+
+	// The sum of the setup times is the same whichever empty slot
+	// the game is paired with
+	if (!m_emptySlots.isEmpty())
+	{
+		m_setupSum += qMax(Q_INT64_C(0), time - m_emptySlots.takeFirst());
+		m_setupCount++;
+	}
+}
+
+void ThroughputStats::addGameEnd(int number, qint64 time, int plies)
+{
+	auto it = m_startTimes.find(number);
+	if (it == m_startTimes.end())
+		return;
+
+	const qint64 duration = qMax(Q_INT64_C(0), time - it.value());
+	m_startTimes.erase(it);
+
+	m_gameCount++;
+	m_durationSum += duration;
+	m_plySum += plies;
+	m_durations[duration / 1000]++;
+	m_emptySlots.append(time);
+}
+
+int ThroughputStats::gameCount() const
+{
+	return m_gameCount;
+}
+
+double ThroughputStats::gamesPerHour(qint64 time) const
+{
+	if (m_gameCount == 0 || time <= m_firstStart)
+		return 0.0;
+	return m_gameCount * 3600000.0 / (time - m_firstStart);
+}
+
+qint64 ThroughputStats::averageDuration() const
+{
+	if (m_gameCount == 0)
+		return 0;
+	return m_durationSum / m_gameCount;
+}
+
+qint64 ThroughputStats::durationPercentile(int percent) const
+{
+	if (m_gameCount == 0)
+		return 0;
+
+	// The smallest duration that covers enough of the games
+	const qint64 needed = (qint64(m_gameCount) * qBound(0, percent, 100) + 99) / 100;
+	qint64 count = 0;
+	for (auto it = m_durations.constBegin(); it != m_durations.constEnd(); ++it)
+	{
+		count += it.value();
+		if (count >= needed)
+			return it.key();
+	}
+	return m_durations.lastKey();
+}
+
+double ThroughputStats::averagePlies() const
+{
+	if (m_gameCount == 0)
+		return 0.0;
+	return double(m_plySum) / m_gameCount;
+}
+
+qint64 ThroughputStats::averageSetupTime() const
+{
+	if (m_setupCount == 0)
+		return -1;
+	return m_setupSum / m_setupCount;
+}
+
+qint64 ThroughputStats::eta(qint64 time, int remaining) const
+{
+	if (remaining <= 0)
+		return 0;
+	if (m_gameCount == 0 || time <= m_firstStart)
+		return -1;
+	return (time - m_firstStart) * remaining / m_gameCount;
+}
@@ -0,0 +1,107 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef THROUGHPUTSTATS_H
+#define THROUGHPUTSTATS_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+
+/*!
+ * \brief Throughput statistics of a tournament.
+ *
+ * ThroughputStats follows the games of a tournament as they start and
+ * finish, and keeps running totals of the games per hour, the game
+ * duration and length, and the setup time between games. Together they
+ * show whether the host is fast enough for the chosen concurrency, and
+ * when the tournament will end.
+ *
+ * The setup time is the time a game slot stays empty between the end
+ * of one game and the start of the next. Each started game takes the
+ * place of the oldest finished game that hasn't been replaced yet.
+ *
+ * All times are in milliseconds from an arbitrary starting point, eg.
+ * the elapsed time of a QElapsedTimer. Each statistic is updated in
+ * constant time, or logarithmic in the number of distinct game
+ * durations for the percentiles.
+ */
+class LIB_EXPORT ThroughputStats
+{
+	public:
+		/*! Creates empty statistics. */
+		ThroughputStats();
+
+		/*! Adds the start of game \a number at \a time. */
+		void addGameStart(int number, qint64 time);
+		/*!
+		 * Adds the end of game \a number at \a time. The game
+		 * was \a plies plies long.
+		 *
+		 * Games whose start wasn't added are ignored.
+		 */
+		void addGameEnd(int number, qint64 time, int plies);
+
+		/*! Returns the number of finished games. */
+		int gameCount() const;
+		/*!
+		 * Returns the number of games finished per hour between
+		 * the first start and \a time, or 0 if no games have
+		 * finished.
+		 */
+		double gamesPerHour(qint64 time) const;
+		/*!
+		 * Returns the average game duration, or 0 if no games
+		 * have finished.
+		 */
+		qint64 averageDuration() const;
+		/*!
+		 * Returns the game duration that \a percent percent of the
+		 * games didn't exceed, in whole seconds, or 0 if no games
+		 * have finished.
+		 */
+		qint64 durationPercentile(int percent) const;
+		/*! Returns the average number of plies per game. */
+		double averagePlies() const;
+		/*!
+		 * Returns the average setup time between two games in the
+		 * same game slot, or -1 if no slot has had two games yet.
+		 */
+		qint64 averageSetupTime() const;
+		/*!
+		 * Returns the expected time until \a remaining more games
+		 * have finished, measured at \a time, or -1 if it can't be
+		 * estimated yet.
+		 */
+		qint64 eta(qint64 time, int remaining) const;
+
+	private:
+		qint64 m_firstStart;
+		int m_gameCount;
+		qint64 m_durationSum;
+		qint64 m_plySum;
+		qint64 m_setupSum;
+		int m_setupCount;
+		// Start times of the running games by their numbers
+		QHash<int, qint64> m_startTimes;
+		// End times of the games whose slots are still empty
+		QList<qint64> m_emptySlots;
+		// Number of games by their duration in seconds
+		QMap<qint64, int> m_durations;
+};
+
+#endif // THROUGHPUTSTATS_H
@@ -52,6 +52,9 @@ TimeControl::TimeControl()
 	  m_nodeLimit(0),
 	  m_lastMoveTime(0),
 	  m_expiryMargin(0),
+	  m_latencyCompensation(0),
+	  m_timeCarry(0),
+	  m_lastMoveTimeUs(0),
 	  m_expired(false),
 	  m_infinite(false)
 {
@@ -68,6 +71,9 @@ TimeControl::TimeControl(const QString& str)
 	  m_nodeLimit(0),
 	  m_lastMoveTime(0),
 	  m_expiryMargin(0),
+	  m_latencyCompensation(0),
+	  m_timeCarry(0),
+	  m_lastMoveTimeUs(0),
 	  m_expired(false),
 	  m_infinite(false)
 {
@@ -135,6 +141,7 @@ bool TimeControl::isValid() const
 	||  m_plyLimit < 0
 	||  m_nodeLimit < 0
 	||  m_expiryMargin < 0
+	||  m_latencyCompensation < 0
 	||  (m_timePerTc == m_timePerMove && !m_infinite))
 		return false;
 	return true;
@@ -190,6 +197,9 @@ QString TimeControl::toVerboseString() const
 		str += tr(", %1 plies").arg(m_plyLimit);
 	if (m_expiryMargin != 0)
 		str += tr(", %1 msec margin").arg(m_expiryMargin);
+	if (m_latencyCompensation != 0)
+		str += tr(", %1 msec latency compensation")
+			.arg(m_latencyCompensation);
 
 	return str;
 }
@@ -198,6 +208,8 @@ void TimeControl::initialize()
 {
 	m_expired = false;
 	m_lastMoveTime = 0;
+	m_lastMoveTimeUs = 0;
+	m_timeCarry = 0;
 
 	if (m_timePerTc != 0)
 	{
@@ -258,6 +270,11 @@ int TimeControl::expiryMargin() const
 	return m_expiryMargin;
 }
 
+int TimeControl::latencyCompensation() const
+{
+	return m_latencyCompensation;
+}
+
 void TimeControl::setInfinity(bool enabled)
 {
 	m_infinite = enabled;
@@ -287,6 +304,14 @@ void TimeControl::setTimePerMove(int timePerMove)
 	m_timePerMove = timePerMove;
 }
 
+void TimeControl::scale(double factor)
+{
+	Q_ASSERT(factor > 0.0);
+	m_timePerTc = qRound(m_timePerTc * factor);
+	m_timePerMove = qRound(m_timePerMove * factor);
+	m_increment = qRound(m_increment * factor);
+}
+
 void TimeControl::setTimeLeft(int timeLeft)
 {
 	m_timeLeft = timeLeft;
@@ -316,24 +341,43 @@ void TimeControl::setExpiryMargin(int expiryMargin)
 	m_expiryMargin = expiryMargin;
 }
 
+void TimeControl::setLatencyCompensation(int msecs)
+{
+	Q_ASSERT(msecs >= 0);
+	m_latencyCompensation = msecs;
+}
+
 void TimeControl::startTimer()
 {
 	m_time.start();
 }
 
-void TimeControl::update(bool applyIncrement)
+void TimeControl::update(bool applyIncrement, int latency)
 {
+	qint64 elapsed = 0;
+	if (m_time.isValid())
+		elapsed = m_time.nsecsElapsed() / 1000;
+
+	// Don't charge the player for the time that the commands
+	// spent in transit
+	if (latency > 0 && m_latencyCompensation > 0)
+		elapsed -= qMin(qint64(latency),
+				qint64(m_latencyCompensation) * 1000);
+	m_lastMoveTimeUs = qMax(elapsed, qint64(0));
+
+	if (!m_infinite
+	&&  m_lastMoveTimeUs > qint64(m_timeLeft + m_expiryMargin) * 1000)
+		m_expired = true;
+
 	/*
+	 * The clock runs in milliseconds, so the remainder is carried
+	 * over to the next move to keep rounding errors from adding up.
 	 * This will overflow after roughly 49 days however it's unlikely
 	 * we'll ever hit that limit.
 	 */
-	if (m_time.isValid())
-		m_lastMoveTime = (int)m_time.elapsed();
-	else
-		m_lastMoveTime = 0;
-
-	if (!m_infinite && m_lastMoveTime > m_timeLeft + m_expiryMargin)
-		m_expired = true;
+	const qint64 total = m_lastMoveTimeUs + m_timeCarry;
+	m_lastMoveTime = int(total / 1000);
+	m_timeCarry = int(total % 1000);
 
 	if (m_timePerMove != 0)
 		setTimeLeft(m_timePerMove);
@@ -363,6 +407,11 @@ int TimeControl::lastMoveTime() const
 	return m_lastMoveTime;
 }
 
+qint64 TimeControl::lastMoveTimeUs() const
+{
+	return m_lastMoveTimeUs;
+}
+
 bool TimeControl::expired() const
 {
 	return m_expired;
@@ -386,6 +435,8 @@ void TimeControl::readSettings(QSettings* settings)
 	m_plyLimit = settings->value("ply_limit", m_plyLimit).toInt();
 	m_nodeLimit = settings->value("node_limit", m_nodeLimit).toInt();
 	m_expiryMargin = settings->value("expiry_margin", m_expiryMargin).toInt();
+	m_latencyCompensation = settings->value("latency_compensation",
+						m_latencyCompensation).toInt();
 	m_infinite = settings->value("infinite", m_infinite).toBool();
 
 	settings->endGroup();
@@ -402,5 +453,6 @@ void TimeControl::writeSettings(QSettings* settings)
 	settings->setValue("ply_limit", m_plyLimit);
 	settings->setValue("node_limit", m_nodeLimit);
 	settings->setValue("expiry_margin", m_expiryMargin);
+	settings->setValue("latency_compensation", m_latencyCompensation);
 	settings->setValue("infinite", m_infinite);
 }
@@ -134,6 +134,12 @@ class LIB_EXPORT TimeControl
 		 * The default value is 0.
 		 */
 		int expiryMargin() const;
+		/*!
+		 * Returns the maximum latency compensation in milliseconds.
+		 *
+		 * \sa setLatencyCompensation()
+		 */
+		int latencyCompensation() const;
 
 
 		/*!
@@ -168,6 +174,23 @@ class LIB_EXPORT TimeControl
 
 		/*! Sets the expiry margin. */
 		void setExpiryMargin(int expiryMargin);
+		/*!
+		 * Sets the maximum latency compensation to \a msecs.
+		 *
+		 * The measured round-trip time of the player's connection,
+		 * up to \a msecs, is deducted from the time of each move.
+		 * The default is 0 (no compensation).
+		 */
+		void setLatencyCompensation(int msecs);
+		/*!
+		 * Multiplies the time per time control, the time per
+		 * move and the increment by \a factor.
+		 *
+		 * The expiry margin and the latency compensation aren't
+		 * changed because they depend on the communication with
+		 * the engine, not on its search.
+		 */
+		void scale(double factor);
 
 		
 		/*! Start the timer. */
@@ -179,11 +202,17 @@ class LIB_EXPORT TimeControl
 		 * \a applyIncrement is true. This is the default.
 		 * Set this value to false if no increment is necessary for
 		 * the current move, e.g. for a book move.
+		 *
+		 * \a latency is the player's round-trip time in
+		 * microseconds, which is deducted from the move time up to
+		 * latencyCompensation().
 		 */
-		void update(bool applyIncrement = true);
+		void update(bool applyIncrement = true, int latency = 0);
 
 		/*! Returns the last elapsed move time. */
 		int lastMoveTime() const;
+		/*! Returns the time spent on the last move in microseconds. */
+		qint64 lastMoveTimeUs() const;
 
 		/*! Returns true if the allotted time has expired. */
 		bool expired() const;
@@ -214,6 +243,9 @@ class LIB_EXPORT TimeControl
 		int m_nodeLimit;
 		int m_lastMoveTime;
 		int m_expiryMargin;
+		int m_latencyCompensation;
+		int m_timeCarry;
+		qint64 m_lastMoveTimeUs;
 		bool m_expired;
 		bool m_infinite;
 		QElapsedTimer m_time;
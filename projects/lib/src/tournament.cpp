@@ -17,20 +17,97 @@
 
 
 #include "tournament.h"
+#include <cmath>
 #include <QFile>
+#include <QMetaMethod>
 #include <QMultiMap>
 #include <QSet>
+#include <QTimer>
 #include "gamemanager.h"
 #include "playerbuilder.h"
 #include "enginebuilder.h"
 #include "board/boardfactory.h"
 #include "chessplayer.h"
+#include "chessengine.h"
 #include "chessgame.h"
 #include "pgnstream.h"
 #include "openingsuite.h"
+#include "openingprefetcher.h"
+#include "openingcache.h"
 #include "openingbook.h"
 #include "sprt.h"
 #include "elo.h"
+#include "ratingsolver.h"
+#include "bootstrapratings.h"
+#include "mersenne.h"
+#include "gamepool.h"
+#include "gameresultcache.h"
+#include "tracer.h"
+
+namespace {
+
+QString resultTypeName(Chess::Result::Type type)
+{
+	switch (type)
+	{
+	case Chess::Result::Win:
+		return "win";
+	case Chess::Result::Draw:
+		return "draw";
+	case Chess::Result::Resignation:
+		return "resignation";
+	case Chess::Result::Timeout:
+		return "timeout";
+	case Chess::Result::Adjudication:
+		return "adjudication";
+	case Chess::Result::IllegalMove:
+		return "illegal_move";
+	case Chess::Result::Disconnection:
+		return "disconnection";
+	case Chess::Result::StalledConnection:
+		return "stalled_connection";
+	case Chess::Result::Agreement:
+		return "agreement";
+	case Chess::Result::NoResult:
+		return "no_result";
+	default:
+		return "error";
+	}
+}
+
+// JSON has no infinity or NaN, so they are written as null
+QVariant jsonNumber(qreal value)
+{
+	if (!std::isfinite(value))
+		return QVariant();
+	return value;
+}
+
+bool stopsTournament(Sprt::StopPolicy policy, Sprt::Result result)
+{
+	switch (policy)
+	{
+	case Sprt::StopOnDecision:
+		return result != Sprt::Continue;
+	case Sprt::StopOnH0:
+		return result == Sprt::AcceptH0;
+	case Sprt::StopOnH1:
+		return result == Sprt::AcceptH1;
+	default:
+		return false;
+	}
+}
+
+// Returns a string with every limit of time control \a tc,
+// including the ones that TimeControl::toString() leaves out
+QString timeControlKey(const TimeControl& tc)
+{
+	return QString("%1 nodes=%2 plies=%3 margin=%4")
+		.arg(tc.toString()).arg(tc.nodeLimit())
+		.arg(tc.plyLimit()).arg(tc.expiryMargin());
+}
+
+} // anonymous namespace
 
 Tournament::Tournament(GameManager* gameManager, EngineManager* engineManager,
 					   QObject *parent)
@@ -38,6 +115,7 @@ Tournament::Tournament(GameManager* gameManager, EngineManager* engineManager,
 	  m_gameManager(gameManager),
 	  m_engineManager(engineManager),
 	  m_lastGame(nullptr),
+	  m_timeControlScale(1.0),
 	  m_variant("standard"),
 	  m_round(0),
 	  m_nextGameNumber(0),
@@ -53,22 +131,36 @@ Tournament::Tournament(GameManager* gameManager, EngineManager* engineManager,
 	  m_openingRepetitions(1),
 	  m_recover(false),
 	  m_pgnCleanup(true),
+	  m_pgnOrdered(true),
 	  m_finished(false),
 	  m_bookOwnership(false),
+	  m_dataSkipFlags(TrainingData::BookMove),
+	  m_dataSampleRate(1.0),
 	  m_openingSuite(nullptr),
-	  m_sprt(new Sprt),
+	  m_openingPrefetcher(nullptr),
+	  m_gamePool(new GamePool),
+	  m_openingCache(new OpeningCache),
+	  m_ratingSolver(new RatingSolver),
+	  m_bootstrap(new BootstrapRatings),
+	  m_bootstrapSamples(0),
+	  m_resultCache(nullptr),
+	  m_resultsValid(false),
 	  m_repetitionCounter(0),
+	  m_openingCounter(0),
 	  m_swapSides(true),
-	  m_pgnOutMode(PgnGame::Verbose),
 	  m_pair(nullptr),
-	  m_livePgnOutMode(PgnGame::Verbose),
+	  m_pgnMemory(MemoryStats::PgnBuffer),
 	  m_resumeGameNumber(0),
+	  m_replayGame(0),
+	  m_seed(0),
 	  m_bergerSchedule(false),
 	  m_reloadEngines(false)
 {
 	Q_ASSERT(gameManager != nullptr);
 	Q_ASSERT(engineManager != nullptr);
 
+	m_sprts.append({ QString(), new Sprt, Sprt::StopOnDecision });
+
 	connect(engineManager, SIGNAL(engineUpdated(int)), this,
 		SLOT(onEngineUpdated(int)));
 }
@@ -79,7 +171,8 @@ Tournament::~Tournament()
 		qWarning("Tournament: Destroyed while games are still running.");
 
 	qDeleteAll(m_gameData);
-	qDeleteAll(m_pairs);
+	qDeleteAll(m_pairTable);
+	qDeleteAll(m_byePairs);
 
 	QSet<const OpeningBook*> books;
 	// TODO: use qAsConst() from Qt 5.7
@@ -89,17 +182,19 @@ Tournament::~Tournament()
 		delete player.builder();
 	}
 
+	// Shared books are released with m_sharedBooks
+	for (const auto& book : m_sharedBooks)
+		books.remove(book.data());
 	if (m_bookOwnership)
 		qDeleteAll(books);
 
+	delete m_openingPrefetcher;
 	delete m_openingSuite;
-	delete m_sprt;
-
-	if (m_pgnFile.isOpen())
-		m_pgnFile.close();
-
-	if (m_epdFile.isOpen())
-		m_epdFile.close();
+	for (const SprtMonitor& monitor : m_sprts)
+		delete monitor.sprt;
+	delete m_ratingSolver;
+	delete m_bootstrap;
+	delete m_resultCache;
 }
 
 GameManager* Tournament::gameManager() const
@@ -132,6 +227,11 @@ QString Tournament::site() const
 	return m_site;
 }
 
+double Tournament::timeControlScale() const
+{
+	return m_timeControlScale;
+}
+
 QString Tournament::variant() const
 {
 	return m_variant;
@@ -179,7 +279,42 @@ int Tournament::seedCount() const
 
 Sprt* Tournament::sprt() const
 {
-	return m_sprt;
+	return m_sprts.first().sprt;
+}
+
+Sprt* Tournament::addSprt(const QString& name, Sprt::StopPolicy policy)
+{
+	if (name.isEmpty())
+	{
+		SprtMonitor& monitor = m_sprts.first();
+		if (!monitor.sprt->isNull())
+			return nullptr;
+		monitor.policy = policy;
+		return monitor.sprt;
+	}
+
+	for (const SprtMonitor& monitor : m_sprts)
+	{
+		if (monitor.name == name)
+			return nullptr;
+	}
+	m_sprts.append({ name, new Sprt, policy });
+	return m_sprts.last().sprt;
+}
+
+int Tournament::sprtCount() const
+{
+	return m_sprts.size();
+}
+
+Sprt* Tournament::sprtAt(int index) const
+{
+	return m_sprts.at(index).sprt;
+}
+
+QString Tournament::sprtName(int index) const
+{
+	return m_sprts.at(index).name;
 }
 
 bool Tournament::swapSides() const
@@ -212,6 +347,12 @@ void Tournament::setSite(const QString& site)
 	m_site = site;
 }
 
+void Tournament::setTimeControlScale(double factor)
+{
+	Q_ASSERT(factor > 0.0);
+	m_timeControlScale = factor;
+}
+
 void Tournament::setVariant(const QString& variant)
 {
 	Q_ASSERT(Chess::BoardFactory::variants().contains(variant));
@@ -265,6 +406,8 @@ void Tournament::setAdjudicator(const GameAdjudicator& adjudicator)
 
 void Tournament::setOpeningSuite(OpeningSuite *suite)
 {
+	delete m_openingPrefetcher;
+	m_openingPrefetcher = nullptr;
 	delete m_openingSuite;
 	m_openingSuite = suite;
 }
@@ -281,12 +424,22 @@ void Tournament::setSeedCount(int seedCount)
 
 void Tournament::setPgnOutput(const QString& fileName, PgnGame::PgnMode mode)
 {
-	if (fileName != m_pgnFile.fileName())
-	{
-		m_pgnFile.close();
-		m_pgnFile.setFileName(fileName);
-	}
-	m_pgnOutMode = mode;
+	m_writer.setPgnOutput(fileName, mode);
+}
+
+void Tournament::setPgnOutputOrdered(bool ordered)
+{
+	m_pgnOrdered = ordered;
+}
+
+void Tournament::setBinaryOutput(const QString& fileName)
+{
+	m_writer.setBinaryOutput(fileName);
+}
+
+void Tournament::setOutputSyncPolicy(GameWriter::SyncPolicy policy)
+{
+	m_writer.setSyncPolicy(policy);
 }
 
 void Tournament::setPgnCleanupEnabled(bool enabled)
@@ -294,19 +447,62 @@ void Tournament::setPgnCleanupEnabled(bool enabled)
 	m_pgnCleanup = enabled;
 }
 
-void Tournament::setEpdOutput(const QString& fileName)
+void Tournament::setEpdOutput(const QString& fileName,
+			      const QList<int>& plies,
+			      bool unique)
 {
-	if (fileName != m_epdFile.fileName())
-	{
-		m_epdFile.close();
-		m_epdFile.setFileName(fileName);
-	}
+	m_writer.setEpdOutput(fileName, plies, unique);
+}
+
+void Tournament::setDataOutput(const QString& fileName,
+			       int skipFlags,
+			       double sampleRate)
+{
+	m_writer.setDataOutput(fileName);
+	m_dataSkipFlags = skipFlags;
+	m_dataSampleRate = sampleRate;
 }
 
 void Tournament::setLivePgnOutput(const QString& fileName, PgnGame::PgnMode mode)
 {
-	m_livePgnOut = fileName;
-	m_livePgnOutMode = mode;
+	m_writer.setLivePgnOutput(fileName, mode);
+}
+
+void Tournament::setLivePgnInterval(int msecs)
+{
+	m_writer.setLivePgnInterval(msecs);
+}
+
+void Tournament::setLiveEventOutput(const QString& fileName)
+{
+	m_writer.setLiveEventOutput(fileName);
+}
+
+void Tournament::setEventLogOutput(const QString& fileName)
+{
+	m_writer.setEventLogOutput(fileName);
+}
+
+void Tournament::setResultCache(const QString& fileName)
+{
+	delete m_resultCache;
+	m_resultCache = fileName.isEmpty()
+		? nullptr : new GameResultCache(fileName);
+}
+
+void Tournament::setOpeningStatsOutput(const QString& fileName)
+{
+	m_openingStatsOutput = fileName;
+}
+
+void Tournament::setBootstrapSamples(int count)
+{
+	m_bootstrapSamples = count;
+}
+
+const BootstrapRatings* Tournament::bootstrapRatings() const
+{
+	return m_bootstrap;
 }
 
 void Tournament::setOpeningRepetitions(int count)
@@ -340,6 +536,27 @@ void Tournament::setResume(int nextGameNumber)
 	m_resumeGameNumber = nextGameNumber;
 }
 
+void Tournament::setSeed(quint32 seed)
+{
+	m_seed = seed;
+}
+
+void Tournament::setReplayGame(int number)
+{
+	Q_ASSERT(number >= 0);
+	m_replayGame = number;
+}
+
+void Tournament::seedGame(ChessGame* game)
+{
+	if (m_seed == 0)
+		return;
+
+	const quint32 seed = Mersenne::streamSeed(m_seed, m_nextGameNumber + 1);
+	Mersenne::seedThread(seed);
+	game->pgn()->setTag("GameSeed", QString::number(seed));
+}
+
 void Tournament::addPlayer(PlayerBuilder* builder,
 			   const TimeControl& timeControl,
 			   const OpeningBook* book,
@@ -349,6 +566,17 @@ void Tournament::addPlayer(PlayerBuilder* builder,
 
 	TournamentPlayer player(builder, timeControl, book, bookDepth);
 	m_players.append(player);
+	m_resultsValid = false;
+}
+
+void Tournament::addPlayer(PlayerBuilder* builder,
+			   const TimeControl& timeControl,
+			   const QSharedPointer<const OpeningBook>& book,
+			   int bookDepth)
+{
+	addPlayer(builder, timeControl, book.data(), bookDepth);
+	if (!book.isNull() && !m_sharedBooks.contains(book))
+		m_sharedBooks.append(book);
 }
 
 TournamentPair* Tournament::currentPair() const
@@ -360,24 +588,47 @@ TournamentPair* Tournament::pair(int player1, int player2)
 {
 	Q_ASSERT(player1 || player2);
 
-	const QPair<int,int> pairs[] = {
-		qMakePair(player1, player2),
-		qMakePair(player2, player1)
-	};
+	if (player1 < 0 || player2 < 0)
+	{
+		TournamentPair*& ret = m_byePairs[qMax(player1, player2)];
+		if (ret == nullptr)
+			ret = new TournamentPair(player1, player2);
+		return ret;
+	}
+	Q_ASSERT(player1 != player2);
 
-	for (const auto& p: pairs)
+	// Players added after the first pairing need a bigger table
+	const int count = m_players.size();
+	if (m_pairTable.size() != count * (count - 1) / 2)
 	{
-		if (m_pairs.contains(p))
-			return m_pairs[p];
+		const QVector<TournamentPair*> oldTable(m_pairTable);
+		m_pairTable.fill(nullptr, count * (count - 1) / 2);
+		for (TournamentPair* oldPair : oldTable)
+		{
+			if (oldPair != nullptr)
+				m_pairTable[pairIndex(oldPair->firstPlayer(),
+						      oldPair->secondPlayer())] = oldPair;
+		}
 	}
 
-	// Existing pair not found -> create a new one
-	auto ret = new TournamentPair(player1, player2);
-	m_pairs[pairs[0]] = ret;
+	// Create the pair if it doesn't exist yet
+	TournamentPair*& ret = m_pairTable[pairIndex(player1, player2)];
+	if (ret == nullptr)
+		ret = new TournamentPair(player1, player2);
 
 	return ret;
 }
 
+int Tournament::pairIndex(int player1, int player2) const
+{
+	const int first = qMin(player1, player2);
+	const int second = qMax(player1, player2);
+	const int count = m_players.size();
+	Q_ASSERT(first >= 0 && second < count);
+
+	return first * (2 * count - first - 1) / 2 + second - first - 1;
+}
+
 bool Tournament::areAllGamesFinished() const
 {
 	return m_finishedGameCount >= m_finalGameCount;
@@ -391,6 +642,7 @@ bool Tournament::hasGauntletRatingsOrder() const
 void Tournament::startGame(TournamentPair* pair)
 {
 	Q_ASSERT(pair->isValid());
+	TraceSpan span("tournament", "schedule game");
 
 	// Reload the engines
 	if (m_reloadEngines)
@@ -410,25 +662,37 @@ void Tournament::startGame(TournamentPair* pair)
 	const TournamentPlayer& white = m_players[m_pair->firstPlayer()];
 	const TournamentPlayer& black = m_players[m_pair->secondPlayer()];
 
-	Chess::Board* board = Chess::BoardFactory::create(m_variant);
+	// The boards and PGN games of finished games are reused
+	Chess::Board* board = m_gamePool->takeBoard(m_variant);
 	Q_ASSERT(board != nullptr);
-	ChessGame* game = new ChessGame(board, new PgnGame());
+	ChessGame* game = new ChessGame(board, m_gamePool->takePgn());
+	game->setGamePool(m_gamePool);
 
 	connect(game, SIGNAL(started(ChessGame*)),
 		this, SLOT(onGameStarted(ChessGame*)));
 	connect(game, SIGNAL(finished(ChessGame*)),
 		this, SLOT(onGameFinished(ChessGame*)));
-	connect(game, SIGNAL(pgnMove()),
-		this, SLOT(onPgnMove()));
+	// Headless runs without live output don't need the per-move
+	// signals at all
+	static const QMetaMethod moveAddedSignal =
+		QMetaMethod::fromSignal(&Tournament::moveAdded);
+	const bool moveSignals = isSignalConnected(moveAddedSignal);
+	if (m_writer.hasLiveOutput() || moveSignals)
+		connect(game, SIGNAL(pgnMove()),
+			this, SLOT(onPgnMove()));
 
 	game->setTimeControl(white.timeControl(), Chess::Side::White);
 	game->setTimeControl(black.timeControl(), Chess::Side::Black);
 
 	game->setOpeningBook(white.book(), Chess::Side::White, white.bookDepth());
 	game->setOpeningBook(black.book(), Chess::Side::Black, black.bookDepth());
+	game->setLiveComments(m_writer.hasLiveEventOutput() || moveSignals);
+	game->setTrainingData(m_writer.hasDataOutput());
+	seedGame(game);
 
 	if (usesBerger)
 	{
+		game->setOpeningCache(m_openingCache, openingIndex());
 		QPair<QVector<Chess::Move>, QString>& cycleGame =
 						m_cycleOpenings[m_nextGameNumber % gamesPerCycle()];
 		if (m_nextGameNumber / gamesPerCycle() % m_openingRepetitions)
@@ -442,7 +706,7 @@ void Tournament::startGame(TournamentPair* pair)
 		{
 			if (m_openingSuite != nullptr)
 			{
-				if (!game->setMoves(m_openingSuite->nextGame(m_openingDepth)))
+				if (!game->setMoves(nextOpening()))
 					qWarning("The opening suite is incompatible with the "
 					"current chess variant");
 			}
@@ -470,14 +734,16 @@ void Tournament::startGame(TournamentPair* pair)
 		else
 		{
 			m_repetitionCounter = 1;
+			m_openingCounter++;
 			if (m_openingSuite != nullptr)
 			{
-				if (!game->setMoves(m_openingSuite->nextGame(m_openingDepth)))
+				if (!game->setMoves(nextOpening()))
 					qWarning("The opening suite is incompatible with the "
 					"current chess variant");
 			}
 		}
 
+		game->setOpeningCache(m_openingCache, openingIndex());
 		game->generateOpening();
 		if (m_repetitionCounter < m_openingRepetitions)
 		{
@@ -491,8 +757,17 @@ void Tournament::startGame(TournamentPair* pair)
 		}
 	}
 
+	// A random starting position is picked from the game's stream
+	// here instead of in the game's thread
+	if (m_seed != 0 && game->startingFen().isEmpty()
+	&&  board->isRandomVariant())
+		game->setStartingFen(board->defaultFenString());
+
 	game->pgn()->setEvent(m_name);
 	game->pgn()->setSite(m_site);
+	if (m_timeControlScale != 1.0)
+		game->pgn()->setTag("TimeControlScale",
+				    QString::number(m_timeControlScale, 'f', 3));
 
 	const int gpr = gamesPerRound();
 	const int gameNo = gpr ? m_nextGameNumber % gpr + 1 : 0;
@@ -502,11 +777,32 @@ void Tournament::startGame(TournamentPair* pair)
 	game->setAdjudicator(m_adjudicator);
 
 	GameData* data = new GameData;
+	data->openingIndex = openingIndex();
 	data->number = ++m_nextGameNumber;
 	data->whiteIndex = m_pair->firstPlayer();
 	data->blackIndex = m_pair->secondPlayer();
+	data->cached = false;
 	m_gameData[game] = data;
 
+	if (!m_openingStats.contains(data->openingIndex))
+	{
+		// The board is reset when the game starts, so it can be
+		// used to find the opening position. A random variant
+		// without a starting position gets one only then.
+		const QString fen(game->startingFen().isEmpty()
+			? board->defaultFenString() : game->startingFen());
+		OpeningStats stats = { data->openingIndex, 0, QString(), 0, 0, 0, 0 };
+		if ((!board->isRandomVariant() || !game->startingFen().isEmpty())
+		&&  board->setFenString(fen))
+		{
+			for (const Chess::Move& move : game->moves())
+				board->makeMove(move);
+			stats.key = board->key();
+			stats.fen = board->fenString();
+		}
+		m_openingStats[data->openingIndex] = stats;
+	}
+
 	// Some tournament types may require more games than expected
 	if (m_nextGameNumber > m_finalGameCount)
 		m_finalGameCount = m_nextGameNumber;
@@ -519,13 +815,110 @@ void Tournament::startGame(TournamentPair* pair)
 	auto whiteBuilder = white.builder();
 	auto blackBuilder = black.builder();
 	onGameAboutToStart(game, whiteBuilder, blackBuilder);
+
+	// A game that was already played isn't played again
+	if (m_resultCache != nullptr)
+	{
+		data->cacheKey = resultCacheKey(game, white, black);
+		if (!data->cacheKey.isEmpty() && finishCachedGame(game, data))
+			return;
+	}
+
 	connect(game, SIGNAL(startFailed(ChessGame*)),
 		this, SLOT(onGameStartFailed(ChessGame*)));
 	m_gameManager->newGame(game,
 			       whiteBuilder,
 			       blackBuilder,
 			       GameManager::Enqueue,
-			       GameManager::ReusePlayers);
+			       GameManager::ReusePlayers,
+			       this);
+}
+
+QString Tournament::resultCacheKey(ChessGame* game,
+				   const TournamentPlayer& white,
+				   const TournamentPlayer& black)
+{
+	// Book moves depend on the contents of the book, and a random
+	// starting position isn't known before the game starts
+	if (white.book() != nullptr || black.book() != nullptr
+	||  (game->startingFen().isEmpty() && game->board()->isRandomVariant()))
+		return QString();
+
+	auto whiteBuilder = dynamic_cast<const EngineBuilder*>(white.builder());
+	auto blackBuilder = dynamic_cast<const EngineBuilder*>(black.builder());
+	if (whiteBuilder == nullptr || blackBuilder == nullptr)
+		return QString();
+
+	QStringList moves;
+	for (const Chess::Move& move : game->moves())
+		moves << QString("%1-%2-%3").arg(move.sourceSquare())
+			 .arg(move.targetSquare()).arg(move.promotion());
+
+	QStringList fields;
+	fields << m_variant
+	       << game->startingFen()
+	       << moves.join(' ')
+	       << timeControlKey(white.timeControl())
+	       << timeControlKey(black.timeControl())
+	       << m_adjudicator.settingsString()
+	       << game->pgn()->tagValue("GameSeed");
+
+	return GameResultCache::gameKey(
+		m_resultCache->engineKey(whiteBuilder->configuration()),
+		m_resultCache->engineKey(blackBuilder->configuration()),
+		fields);
+}
+
+bool Tournament::finishCachedGame(ChessGame* game, GameData* data)
+{
+	const GameResultCache::Entry entry(m_resultCache->entry(data->cacheKey));
+	if (entry.result.isNone())
+		return false;
+
+	// The cached game replaces everything but the tags that
+	// belong to this tournament
+	PgnGame* pgn = game->pgn();
+	const PgnGame header(*pgn);
+	const QByteArray text(entry.pgn.toUtf8());
+	PgnStream in(&text, m_variant);
+	in.setTrustedMoves(true);
+	if (!pgn->read(in))
+	{
+		qWarning("Invalid game in result cache file %s",
+			 qPrintable(m_resultCache->fileName()));
+		*pgn = header;
+		return false;
+	}
+	pgn->setEvent(header.event());
+	pgn->setSite(header.site());
+	pgn->setTag("Round", header.tagValue("Round"));
+	pgn->setDate(QDate::currentDate());
+	pgn->setTag("CachedResult", data->cacheKey);
+	data->cached = true;
+
+	// The game doesn't take a slot from the game manager, so the
+	// next game is started right after it
+	const Chess::Result result(entry.result);
+	QTimer::singleShot(0, game, [=]()
+	{
+		game->finishWithResult(result);
+		if (!m_finished && !areAllGamesFinished())
+			startNextGame();
+	});
+
+	return true;
+}
+
+void Tournament::storeCachedGame(ChessGame* game, const GameData* data)
+{
+	GameResultCache::Entry entry;
+	entry.result = game->result();
+
+	QTextStream out(&entry.pgn);
+	game->pgn()->write(out);
+	out.flush();
+
+	m_resultCache->setEntry(data->cacheKey, entry);
 }
 
 void Tournament::onGameAboutToStart(ChessGame *game,
@@ -545,7 +938,7 @@ int Tournament::playerIndex(ChessGame* game, Chess::Side side) const
 
 void Tournament::startNextGame()
 {
-	if (m_stopping)
+	if (m_stopping || (m_replayGame > 0 && m_nextGameNumber >= m_replayGame))
 		return;
 
 	TournamentPair* pair(nextPair(m_nextGameNumber));
@@ -561,91 +954,102 @@ void Tournament::startNextGame()
 	startGame(pair);
 }
 
-bool Tournament::writePgn(PgnGame* pgn, int gameNumber)
+void Tournament::writePgn(PgnGame* pgn, int gameNumber)
 {
 	Q_ASSERT(pgn != nullptr);
 	Q_ASSERT(gameNumber > 0);
+	TraceSpan span("tournament", "write pgn");
 
-	if (m_pgnFile.fileName().isEmpty())
-		return true;
-
-	bool isOpen = m_pgnFile.isOpen();
-	if (!isOpen || !m_pgnFile.exists())
+	if (!m_pgnOrdered)
 	{
-		if (isOpen)
-		{
-			qWarning("PGN file %s does not exist. Reopening...",
-				 qPrintable(m_pgnFile.fileName()));
-			m_pgnFile.close();
-		}
-
-		if (!m_pgnFile.open(QIODevice::WriteOnly | QIODevice::Append))
-		{
-			qWarning("Could not open PGN file %s",
-				 qPrintable(m_pgnFile.fileName()));
-			return false;
-		}
-		m_pgnOut.setDevice(&m_pgnFile);
+		PgnGame game(*pgn);
+		game.setTag("GameNumber", QString::number(gameNumber));
+		m_writer.writeGame(game);
+		m_savedGameCount++;
+		return;
 	}
 
-	bool ok = true;
+	// Games are passed to the writer in the order they were started
+	// A slow game holds back the games that finish after it
 	m_pgnGames[gameNumber] = *pgn;
+	qint64 bytes = m_pgnMemory.bytes() + pgn->memoryUsage();
 	while (m_pgnGames.contains(m_savedGameCount + 1))
 	{
-		PgnGame tmp = m_pgnGames.take(++m_savedGameCount);
-		if (!tmp.write(m_pgnOut, m_pgnOutMode)
-		||  m_pgnFile.error() != QFile::NoError)
-		{
-			ok = false;
-			qWarning("Could not write PGN game %d", m_savedGameCount);
-		}
+		const PgnGame game(m_pgnGames.take(++m_savedGameCount));
+		bytes -= game.memoryUsage();
+		m_writer.writeGame(game);
 	}
-
-	return ok;
+	m_pgnMemory.setBytes(m_pgnGames.isEmpty()
+			     ? 0 : qMax(Q_INT64_C(0), bytes));
 }
 
-bool Tournament::writeEpd(ChessGame *game)
+void Tournament::writeEpd(ChessGame *game)
 {
 	Q_ASSERT(game != nullptr);
+	m_writer.writeEpd(*game->pgn());
+}
 
-	if (m_epdFile.fileName().isEmpty())
-		return true;
+void Tournament::writeTrainingData(ChessGame* game)
+{
+	Q_ASSERT(game != nullptr);
 
-	bool isOpen = m_epdFile.isOpen();
-	if (!isOpen || !m_epdFile.exists())
-	{
-		if (isOpen)
-		{
-			qWarning("EPD file %s does not exist. Reopening...",
-				 qPrintable(m_epdFile.fileName()));
-			m_epdFile.close();
-		}
+	const Chess::Result& result = game->result();
+	if (!m_writer.hasDataOutput()
+	||  (!result.isDraw() && result.winner().isNull()))
+		return;
 
-		if (!m_epdFile.open(QIODevice::WriteOnly | QIODevice::Append))
-		{
-			qWarning("Could not open EPD file %s",
-				 qPrintable(m_epdFile.fileName()));
-			return false;
-		}
-		m_epdOut.setDevice(&m_epdFile);
-	}
+	TrainingData::Result dataResult = TrainingData::Draw;
+	if (result.winner() == Chess::Side::White)
+		dataResult = TrainingData::WhiteWin;
+	else if (result.winner() == Chess::Side::Black)
+		dataResult = TrainingData::BlackWin;
 
-	const QString& epdPos = game->board()->fenString();
-	m_epdOut << epdPos << "\n";
-	m_epdOut.flush();
-	bool ok = true;
-	if (m_epdFile.error() != QFile::NoError)
+	QVector<TrainingData::Position> positions;
+	const auto& gamePositions = game->trainingData();
+	for (const TrainingData::Position& pos : gamePositions)
 	{
-		ok = false;
-		qWarning("Could not write EPD position");
-	}
+		if ((pos.flags & m_dataSkipFlags) != 0
+		||  (m_dataSampleRate < 1.0
+		&&   Mersenne::random() >= m_dataSampleRate * 4294967295.0))
+			continue;
 
-	return ok;
+		positions.append(pos);
+		positions.last().result = dataResult;
+	}
+	m_writer.writeTrainingData(positions);
 }
 
 void Tournament::addScore(int player, int score)
 {
 	m_players[player].addScore(score);
+	m_resultsValid = false;
+}
+
+void Tournament::watchEngine(ChessPlayer* player, int index)
+{
+	auto engine = qobject_cast<ChessEngine*>(player);
+	if (engine == nullptr || m_engineIndex.contains(engine))
+		return;
+
+	// The engine lives in its game's thread and may outlive the game
+	m_engineIndex[engine] = index;
+	connect(engine, SIGNAL(stopMeasured(int, bool)),
+		this, SLOT(onEngineStopMeasured(int, bool)));
+	connect(engine, SIGNAL(destroyed(QObject*)),
+		this, SLOT(onEngineDestroyed(QObject*)));
+}
+
+void Tournament::onEngineStopMeasured(int msecs, bool timedOut)
+{
+	auto it = m_engineIndex.constFind(sender());
+	if (it != m_engineIndex.constEnd())
+		m_players[it.value()].addStopLatency(msecs, timedOut);
+}
+
+void Tournament::onEngineDestroyed(QObject* engine)
+{
+	// Only the address is used, the engine is already destroyed
+	m_engineIndex.remove(engine);
 }
 
 void Tournament::onGameStarted(ChessGame* game)
@@ -658,23 +1062,51 @@ void Tournament::onGameStarted(ChessGame* game)
 	int iBlack = data->blackIndex;
 	m_players[iWhite].setName(game->player(Chess::Side::White)->name());
 	m_players[iBlack].setName(game->player(Chess::Side::Black)->name());
+	m_resultsValid = false;
+	watchEngine(game->player(Chess::Side::White), iWhite);
+	watchEngine(game->player(Chess::Side::Black), iBlack);
 
 	emit gameStarted(game, data->number, iWhite, iBlack);
 
+	m_writer.writeLiveEvent(data->number, QStringList()
+		<< "start" << m_players[iWhite].name() << m_players[iBlack].name());
+	data->timer.start();
+	if (m_writer.hasEventLogOutput())
+	{
+		QVariantMap event;
+		event["game"] = data->number;
+		event["round"] = m_round;
+		event["opening"] = data->openingIndex;
+		event["white"] = m_players[iWhite].name();
+		event["black"] = m_players[iBlack].name();
+		event["fen"] = game->startingFen().isEmpty()
+			? game->board()->defaultFenString() : game->startingFen();
+		m_writer.writeEventLog("game_start", event);
+	}
 	onPgnMove();
 }
 
 void Tournament::onPgnMove()
 {
-	if (m_livePgnOut.isEmpty()) return;
-
 	ChessGame* sender = qobject_cast<ChessGame*>(QObject::sender());
 	Q_ASSERT(sender != 0);
 
-	PgnGame* pgn(sender->pgn());
+	// One live PGN rewrite covers the whole batch of moves
+	m_writer.writeLiveGame(*sender->pgn());
 
-	QFile::resize(m_livePgnOut, 0);
-	pgn->write(m_livePgnOut, m_livePgnOutMode);
+	const auto events = sender->takeMoveEvents();
+	if (events.isEmpty() || !m_gameData.contains(sender))
+		return;
+
+	const int gameNumber = m_gameData[sender]->number;
+	for (const auto& event : events)
+	{
+		m_writer.writeLiveEvent(gameNumber, QStringList()
+			<< "move" << QString::number(event.ply)
+			<< event.moveString << event.comment);
+		emit moveAdded(gameNumber, event.ply,
+			       event.moveString, event.comment);
+	}
 }
 
 void Tournament::onEngineUpdated(int engineIndex)
@@ -694,6 +1126,7 @@ void Tournament::onEngineUpdated(int engineIndex)
 void Tournament::onGameFinished(ChessGame* game)
 {
 	Q_ASSERT(game != nullptr);
+	TraceSpan span("tournament", "game finished");
 
 	PgnGame* pgn(game->pgn());
 	Chess::Result result(game->result());
@@ -713,17 +1146,20 @@ void Tournament::onGameFinished(ChessGame* game)
 	const auto blackName = pgn->playerName(Chess::Side::Black);
 	if (!blackName.isEmpty())
 		m_players[iBlack].setName(blackName);
+	m_resultsValid = false;
 
 	switch (game->result().winner())
 	{
 	case Chess::Side::White:
 		addScore(iWhite, 2);
 		addScore(iBlack, 0);
+		m_ratingSolver->addGame(iWhite, iBlack, 2);
 		sprtResult = (iWhite == 0) ? Sprt::Win : Sprt::Loss;
 		break;
 	case Chess::Side::Black:
 		addScore(iBlack, 2);
 		addScore(iWhite, 0);
+		m_ratingSolver->addGame(iWhite, iBlack, 0);
 		sprtResult = (iBlack == 0) ? Sprt::Win : Sprt::Loss;
 		break;
 	default:
@@ -731,38 +1167,198 @@ void Tournament::onGameFinished(ChessGame* game)
 		{
 			addScore(iWhite, 1);
 			addScore(iBlack, 1);
+			m_ratingSolver->addGame(iWhite, iBlack, 1);
 			sprtResult = Sprt::Draw;
 		}
 		break;
 	}
 
+	if (m_bootstrapSamples > 0 && (!result.winner().isNull() || result.isDraw()))
+	{
+		const int points = result.isDraw() ? 1
+			: (result.winner() == Chess::Side::White ? 2 : 0);
+		m_bootstrap->addGame(data->openingIndex, iWhite, iBlack, points);
+	}
+
+	auto stats = m_openingStats.find(data->openingIndex);
+	if (stats != m_openingStats.end()
+	&&  (!result.winner().isNull() || result.isDraw()))
+	{
+		stats->games++;
+		if (result.winner() == Chess::Side::White)
+			stats->whiteWins++;
+		else if (result.winner() == Chess::Side::Black)
+			stats->blackWins++;
+		else
+			stats->draws++;
+	}
+
+	// Book moves and moves without a search report aren't counted
+	Chess::Side side = pgn->startingSide();
+	qint64 thinkingTime[2] = { 0, 0 };
+	for (const PgnGame::MoveData& move : pgn->moves())
+	{
+		const PgnGame::EvalData& eval = move.eval;
+		if (!eval.isNull())
+			thinkingTime[side] += qMax(0, eval.moveTime);
+		if (!eval.isNull() && eval.nodes > 0)
+		{
+			const int index = (side == Chess::Side::White) ? iWhite : iBlack;
+			m_players[index].addMoveStats(eval.nodes, eval.moveTime,
+						      eval.depth);
+		}
+		side = side.opposite();
+	}
+	m_players[iWhite].addPonderStats(game->ponderedMoves(Chess::Side::White),
+					 game->ponderHits(Chess::Side::White));
+	m_players[iBlack].addPonderStats(game->ponderedMoves(Chess::Side::Black),
+					 game->ponderHits(Chess::Side::Black));
+	m_players[iWhite].addTimeStats(game->timeStats(Chess::Side::White));
+	m_players[iBlack].addTimeStats(game->timeStats(Chess::Side::Black));
+
 	writeEpd(game);
+	writeTrainingData(game);
 	writePgn(pgn, gameNumber);
+	m_writer.writeLiveEvent(gameNumber, QStringList()
+		<< "result" << result.toShortString() << result.description());
 
 	Chess::Result::Type resultType(game->result().type());
 	bool crashed = (resultType == Chess::Result::Disconnection ||
 			resultType == Chess::Result::StalledConnection);
+
+	if (m_resultCache != nullptr && !data->cached
+	&&  !data->cacheKey.isEmpty() && !crashed
+	&&  (!result.winner().isNull() || result.isDraw()))
+		storeCachedGame(game, data);
+
+	if (m_writer.hasEventLogOutput())
+	{
+		QVariantMap event;
+		event["game"] = gameNumber;
+		event["white"] = m_players[iWhite].name();
+		event["black"] = m_players[iBlack].name();
+		event["result"] = result.toShortString();
+		event["termination"] = resultTypeName(resultType);
+		event["reason"] = result.description();
+		event["plies"] = pgn->moves().size();
+		event["duration_ms"] = data->timer.isValid()
+			? data->timer.elapsed() : qint64(0);
+		event["white_time_ms"] = thinkingTime[Chess::Side::White];
+		event["black_time_ms"] = thinkingTime[Chess::Side::Black];
+		if (data->cached)
+			event["cached"] = true;
+		m_writer.writeEventLog("game_end", event);
+
+		// The loser of a disconnected or stalled game is the
+		// engine that crashed
+		const Chess::Side winner = result.winner();
+		if (crashed && !winner.isNull())
+		{
+			const Chess::Side loser = winner.opposite();
+			QVariantMap crash;
+			crash["game"] = gameNumber;
+			crash["engine"] = m_players[loser == Chess::Side::White
+				? iWhite : iBlack].name();
+			crash["reason"] = result.description();
+			crash["restart"] = m_recover;
+			m_writer.writeEventLog("engine_crash", crash);
+		}
+	}
+
 	if (!m_recover && crashed)
 		stop();
 
-	if (!m_sprt->isNull() && sprtResult != Sprt::NoResult)
+	// The pair is complete when the other game of the opening
+	// has finished
+	bool pentanomial = false;
+	for (const SprtMonitor& monitor : m_sprts)
 	{
-		m_sprt->addGameResult(sprtResult);
-		if (m_sprt->status().result != Sprt::Continue)
-			QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+		if (!monitor.sprt->isNull()
+		&&  monitor.sprt->model() == Sprt::Pentanomial)
+			pentanomial = true;
 	}
+	bool pairFinished = false;
+	Sprt::GameResult pairResult = Sprt::NoResult;
+	if (pentanomial)
+	{
+		auto it = m_sprtPairs.find(data->openingIndex);
+		if (it == m_sprtPairs.end())
+			m_sprtPairs[data->openingIndex] = sprtResult;
+		else
+		{
+			pairFinished = true;
+			pairResult = it.value();
+			m_sprtPairs.erase(it);
+		}
+	}
+
+	// Every monitor sees the same results. A decided monitor keeps
+	// its final status while the others go on.
+	bool stopTournament = false;
+	for (const SprtMonitor& monitor : m_sprts)
+	{
+		Sprt* sprt = monitor.sprt;
+		if (sprt->isNull() || sprt->status().result != Sprt::Continue)
+			continue;
+
+		if (sprt->model() == Sprt::Pentanomial)
+		{
+			if (!pairFinished)
+				continue;
+			sprt->addGamePair(pairResult, sprtResult);
+		}
+		else if (sprtResult != Sprt::NoResult)
+			sprt->addGameResult(sprtResult);
+		else
+			continue;
+
+		m_resultsValid = false;
+		const Sprt::Status status = sprt->status();
+		if (stopsTournament(monitor.policy, status.result))
+			stopTournament = true;
+
+		if (m_writer.hasEventLogOutput())
+		{
+			QVariantMap event;
+			event["game"] = gameNumber;
+			if (!monitor.name.isEmpty())
+				event["name"] = monitor.name;
+			event["llr"] = jsonNumber(status.llr);
+			event["lower_bound"] = jsonNumber(status.lBound);
+			event["upper_bound"] = jsonNumber(status.uBound);
+			if (status.result == Sprt::AcceptH0)
+				event["result"] = "H0";
+			else if (status.result == Sprt::AcceptH1)
+				event["result"] = "H1";
+			else
+				event["result"] = "continue";
+			m_writer.writeEventLog("sprt", event);
+		}
+	}
+	if (stopTournament)
+		QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+
+	if (m_writer.hasEventLogOutput())
+		writeRatingEvent();
 
 	emit gameFinished(game, gameNumber, iWhite, iBlack);
 
 	if (m_pgnCleanup)
-		delete pgn;
+		m_gamePool->recyclePgn(pgn);
 
-	if (areAllGamesFinished() || (m_stopping && m_gameData.isEmpty()))
+	if (areAllGamesFinished()
+	||  ((m_stopping || m_replayGame > 0) && m_gameData.isEmpty()))
 	{
 		m_stopping = false;
-		m_lastGame = game;
-		connect(m_gameManager, SIGNAL(gameDestroyed(ChessGame*)),
-			this, SLOT(onGameDestroyed(ChessGame*)));
+		// A cached game never reaches the game manager
+		if (data->cached)
+			QTimer::singleShot(0, this, [this]() { onFinished(); });
+		else
+		{
+			m_lastGame = game;
+			connect(m_gameManager, SIGNAL(gameDestroyed(ChessGame*)),
+				this, SLOT(onGameDestroyed(ChessGame*)));
+		}
 	}
 
 	delete data;
@@ -782,15 +1378,56 @@ void Tournament::onGameStartFailed(ChessGame* game)
 {
 	m_error = game->errorString();
 
-	delete game->pgn();
+	m_gamePool->recyclePgn(game->pgn());
 	game->deleteLater();
 	m_gameData.remove(game);
 
 	stop();
 }
 
+int Tournament::openingIndex() const
+{
+	// Games that repeat an opening share its index
+	if (usesBergerSchedule())
+	{
+		const int cycle = m_nextGameNumber / gamesPerCycle();
+		return (cycle / m_openingRepetitions) * gamesPerCycle()
+		       + m_nextGameNumber % gamesPerCycle();
+	}
+
+	return m_openingCounter;
+}
+
+PgnGame Tournament::nextOpening()
+{
+	Q_ASSERT(m_openingSuite != nullptr);
+
+	// The openings are read and validated ahead of time on
+	// another thread, so starting a game doesn't wait for file I/O
+	if (m_openingPrefetcher == nullptr)
+		m_openingPrefetcher = new OpeningPrefetcher(m_openingSuite,
+							    m_variant,
+							    m_openingDepth);
+	return m_openingPrefetcher->takeOpening();
+}
+
 void Tournament::onFinished()
 {
+	if (m_openingPrefetcher != nullptr)
+		m_openingPrefetcher->stop();
+	if (!m_openingStatsOutput.isEmpty() && !writeOpeningStats())
+		qWarning("Could not write opening statistics to %s",
+			 qPrintable(m_openingStatsOutput));
+	updateBootstrapRatings();
+	if (m_writer.hasEventLogOutput())
+	{
+		QVariantMap event;
+		event["games"] = m_finishedGameCount;
+		if (!m_error.isEmpty())
+			event["error"] = m_error;
+		m_writer.writeEventLog("tournament_end", event);
+	}
+	m_writer.finish();
 	m_gameManager->cleanupIdleThreads();
 	m_finished = true;
 	emit finished();
@@ -809,6 +1446,15 @@ void Tournament::start()
 
 	m_gameData.clear();
 	m_pgnGames.clear();
+	m_pgnMemory.setBytes(0);
+	m_sprtPairs.clear();
+	m_openingStats.clear();
+	m_resultsValid = false;
+	m_openingCounter = 0;
+	m_openingCache->clear();
+	m_ratingSolver->reset(playerCount());
+	m_bootstrap->reset(playerCount(), m_openingRepetitions);
+	m_writer.start();
 	m_startFen.clear();
 	m_openingMoves.clear();
 	const bool usesBerger = usesBergerSchedule();
@@ -823,6 +1469,24 @@ void Tournament::start()
 	initializePairing();
 	m_finalGameCount = gamesPerCycle() * gamesPerEncounter() * roundMultiplier();
 
+	if (m_writer.hasEventLogOutput())
+	{
+		QStringList players;
+		for (const TournamentPlayer& player : m_players)
+			players << player.name();
+
+		QVariantMap event;
+		event["type"] = type();
+		event["variant"] = m_variant;
+		event["players"] = players;
+		event["games"] = m_finalGameCount;
+		m_writer.writeEventLog("tournament_start", event);
+	}
+
+	// Replaying a game skips the games before it
+	if (m_replayGame > 0)
+		m_resumeGameNumber = m_replayGame - 1;
+
 	if (m_resumeGameNumber)
 	{
 		for(int nextGame = m_resumeGameNumber; nextGame; --nextGame)
@@ -854,6 +1518,7 @@ void Tournament::start()
 
 			game->setOpeningBook(white.book(), Chess::Side::White, white.bookDepth());
 			game->setOpeningBook(black.book(), Chess::Side::Black, black.bookDepth());
+			seedGame(game);
 
 			if (usesBerger)
 			{
@@ -870,7 +1535,7 @@ void Tournament::start()
 				{
 					if (m_openingSuite != nullptr)
 					{
-						if (!game->setMoves(m_openingSuite->nextGame(m_openingDepth)))
+						if (!game->setMoves(nextOpening()))
 							qWarning("The opening suite is incompatible with the "
 							"current chess variant");
 					}
@@ -898,9 +1563,10 @@ void Tournament::start()
 				else
 				{
 					m_repetitionCounter = 1;
+					m_openingCounter++;
 					if (m_openingSuite != nullptr)
 					{
-						if (!game->setMoves(m_openingSuite->nextGame(m_openingDepth)))
+						if (!game->setMoves(nextOpening()))
 							qWarning("The opening suite is incompatible with the "
 							"current chess variant");
 					}
@@ -921,6 +1587,8 @@ void Tournament::start()
 
 			++m_nextGameNumber;
 			++m_finishedGameCount;
+			// The game was saved by the earlier run, if at all
+			++m_savedGameCount;
 
 			if (m_nextGameNumber > m_finalGameCount)
 				m_finalGameCount = m_nextGameNumber;
@@ -955,11 +1623,122 @@ void Tournament::stop()
 		QMetaObject::invokeMethod(game, "stop", Qt::QueuedConnection);
 }
 
+QList<Tournament::OpeningStats> Tournament::openingStats() const
+{
+	return m_openingStats.values();
+}
+
+bool Tournament::writeOpeningStats() const
+{
+	QFile file(m_openingStatsOutput);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QTextStream out(&file);
+	out << "index\tkey\tgames\twhite_wins\tblack_wins\tdraws\tflag\tfen\n";
+	for (const OpeningStats& stats : m_openingStats)
+	{
+		QString flag("-");
+		if (stats.isAlwaysDrawn())
+			flag = "drawn";
+		else if (stats.isAlwaysDecisive())
+			flag = "decisive";
+
+		out << stats.index << '\t'
+		    << QString::number(stats.key, 16).rightJustified(16, '0') << '\t'
+		    << stats.games << '\t'
+		    << stats.whiteWins << '\t'
+		    << stats.blackWins << '\t'
+		    << stats.draws << '\t'
+		    << flag << '\t'
+		    << stats.fen << '\n';
+	}
+	out.flush();
+
+	return out.status() == QTextStream::Ok && file.error() == QFile::NoError;
+}
+
+void Tournament::writeRatingEvent()
+{
+	const bool useSolver = playerCount() > 2
+			    && m_ratingSolver->playerCount() == playerCount();
+	if (useSolver)
+		m_ratingSolver->solve();
+
+	QVariantList players;
+	for (int i = 0; i < playerCount(); i++)
+	{
+		const TournamentPlayer& player(playerAt(i));
+		Elo elo(player.wins(), player.losses(), player.draws());
+
+		QVariantMap data;
+		data["name"] = player.name();
+		data["games"] = player.gamesFinished();
+		data["score"] = jsonNumber(elo.pointRatio());
+		if (useSolver && m_ratingSolver->games(i) > 0)
+		{
+			data["rating"] = jsonNumber(m_ratingSolver->rating(i));
+			data["error_margin"] = jsonNumber(m_ratingSolver->errorMargin(i));
+		}
+		else if (player.gamesFinished() > 0)
+		{
+			data["rating"] = jsonNumber(elo.diff());
+			data["error_margin"] = jsonNumber(elo.errorMargin());
+		}
+		players << data;
+	}
+
+	QVariantMap event;
+	event["players"] = players;
+	m_writer.writeEventLog("ratings", event);
+}
+
+bool Tournament::updateBootstrapRatings()
+{
+	TraceSpan span("tournament", "bootstrap");
+
+	if (m_bootstrapSamples <= 0
+	||  m_bootstrap->playerCount() != playerCount()
+	||  !m_bootstrap->run(m_bootstrapSamples, Mersenne::random()))
+		return false;
+
+	if (m_writer.hasEventLogOutput())
+	{
+		QVariantList players;
+		for (int i = 0; i < playerCount(); i++)
+		{
+			QVariantMap data;
+			data["name"] = playerAt(i).name();
+			data["p2_5"] = jsonNumber(m_bootstrap->percentile(i, 2.5));
+			data["p50"] = jsonNumber(m_bootstrap->percentile(i, 50.0));
+			data["p97_5"] = jsonNumber(m_bootstrap->percentile(i, 97.5));
+			players << data;
+		}
+
+		QVariantMap event;
+		event["samples"] = m_bootstrap->sampleCount();
+		event["players"] = players;
+		m_writer.writeEventLog("bootstrap", event);
+	}
+
+	return true;
+}
+
 QString Tournament::results() const
 {
+	if (m_resultsValid)
+		return m_results;
+
 	QMultiMap<qreal, RankingData> ranking;
 	QString ret;
 
+	// With more than two players the ratings are fitted to the
+	// results of all pairs of players, starting from the last fit
+	const bool useSolver = playerCount() > 2
+			    && m_ratingSolver->playerCount() == playerCount();
+	if (useSolver)
+		m_ratingSolver->solve();
+
 	for (int i = 0; i < playerCount(); i++)
 	{
 		const TournamentPlayer& player(playerAt(i));
@@ -973,23 +1752,32 @@ QString Tournament::results() const
 			break;
 		}
 
-		RankingData data = { player.name(),
+		RankingData data = { i,
+				     player.name(),
 				     player.gamesFinished(),
 				     elo.pointRatio(),
 				     elo.drawRatio(),
 				     elo.errorMargin(),
 				     elo.diff() };
+		if (useSolver && m_ratingSolver->games(i) > 0)
+		{
+			data.errorMargin = m_ratingSolver->errorMargin(i);
+			data.eloDiff = m_ratingSolver->rating(i);
+		}
 		// Order players like this:
 		// 1. Gauntlet player (if any)
-		// 2. Players with finished games, sorted by point ratio
+		// 2. Players with finished games, sorted by rating
+		//    (or by point ratio without the rating fit)
 		// 3. Players without finished games
-		qreal key = -1.0;
+		qreal key = -1.0e9;
 		if (i > 0 || !hasGauntletRatingsOrder())
 		{
-			if (data.games)
-				key = 1.0 - data.score;
+			if (!data.games)
+				key = 1.0e9;
+			else if (useSolver)
+				key = -data.eloDiff;
 			else
-				key = 2.0;
+				key = 1.0 - data.score;
 		}
 		ranking.insert(key, data);
 	}
@@ -1018,12 +1806,48 @@ QString Tournament::results() const
 			.arg(data.draws * 100.0, 6, 'f', 1);
 	}
 
-	Sprt::Status sprtStatus = sprt()->status();
-	if (sprtStatus.llr != 0.0
-	||  sprtStatus.lBound != 0.0
-	||  sprtStatus.uBound != 0.0)
+	// Likelihood of superiority of each player (row) over
+	// the others (columns), in percent
+	if (useSolver && ranking.size() > 2)
+	{
+		const int firstRank = hasGauntletRatingsOrder() ? 0 : 1;
+		ret += QString("\n\n%1 %2").arg("LOS", 4).arg("", -25);
+		for (int col = 0; col < ranking.size(); col++)
+			ret += QString("%1").arg(firstRank + col, 5);
+
+		rank = firstRank - 1;
+		for (auto it = ranking.constBegin(); it != ranking.constEnd(); ++it)
+		{
+			const RankingData& data = it.value();
+			ret += QString("\n%1 %2").arg(++rank, 4).arg(data.name, -25);
+			for (auto jt = ranking.constBegin(); jt != ranking.constEnd(); ++jt)
+			{
+				const int opponent = jt.value().index;
+				if (opponent == data.index
+				||  !m_ratingSolver->games(data.index)
+				||  !m_ratingSolver->games(opponent))
+				{
+					ret += QString("%1").arg("-", 5);
+					continue;
+				}
+				const double los = m_ratingSolver->superiority(
+					data.index, opponent);
+				ret += QString("%1").arg(los * 100.0, 5, 'f', 0);
+			}
+		}
+	}
+
+	for (const SprtMonitor& monitor : m_sprts)
 	{
-		QString sprtStr = QString("SPRT: llr %1, lbound %2, ubound %3")
+		Sprt::Status sprtStatus = monitor.sprt->status();
+		if (sprtStatus.llr == 0.0
+		&&  sprtStatus.lBound == 0.0
+		&&  sprtStatus.uBound == 0.0)
+			continue;
+
+		QString sprtStr = monitor.name.isEmpty()
+			? QString("SPRT: ") : QString("SPRT %1: ").arg(monitor.name);
+		sprtStr += QString("llr %1, lbound %2, ubound %3")
 			.arg(sprtStatus.llr, 0, 'g', 3)
 			.arg(sprtStatus.lBound, 0, 'g', 3)
 			.arg(sprtStatus.uBound, 0, 'g', 3);
@@ -1035,5 +1859,7 @@ QString Tournament::results() const
 		ret += "\n" + sprtStr;
 	}
 
+	m_results = ret;
+	m_resultsValid = true;
 	return ret;
 }
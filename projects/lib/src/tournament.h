@@ -23,21 +23,32 @@
 #include <QList>
 #include <QVector>
 #include <QMap>
+#include <QHash>
+#include <QSharedPointer>
 #include <QFile>
 #include <QTextStream>
+#include <QElapsedTimer>
 #include "board/move.h"
 #include "timecontrol.h"
 #include "pgngame.h"
+#include "gamewriter.h"
 #include "gameadjudicator.h"
 #include "tournamentplayer.h"
 #include "tournamentpair.h"
 #include "enginemanager.h"
+#include "sprt.h"
+#include "memorystats.h"
 class GameManager;
 class PlayerBuilder;
 class ChessGame;
 class OpeningBook;
 class OpeningSuite;
-class Sprt;
+class OpeningPrefetcher;
+class GamePool;
+class OpeningCache;
+class RatingSolver;
+class BootstrapRatings;
+class GameResultCache;
 
 /*!
  * \brief Base class for chess tournaments
@@ -47,6 +58,47 @@ class LIB_EXPORT Tournament : public QObject
 	Q_OBJECT
 
 	public:
+		/*!
+		 * The results of the games played from one opening.
+		 *
+		 * Games that repeat an opening (see
+		 * setOpeningRepetitions()) are counted together.
+		 */
+		struct OpeningStats
+		{
+			/*! The index of the opening in the tournament. */
+			int index;
+			/*! The Zobrist key of the opening position. */
+			quint64 key;
+			/*! The FEN string of the opening position. */
+			QString fen;
+			/*! Games with a result. */
+			int games;
+			/*! Games won by White. */
+			int whiteWins;
+			/*! Games won by Black. */
+			int blackWins;
+			/*! Drawn games. */
+			int draws;
+
+			/*!
+			 * Returns true if the opening has been played by
+			 * both colors and every game was drawn.
+			 */
+			bool isAlwaysDrawn() const
+			{
+				return games > 1 && draws == games;
+			}
+			/*!
+			 * Returns true if the opening has been played by
+			 * both colors and no game was drawn.
+			 */
+			bool isAlwaysDecisive() const
+			{
+				return games > 1 && draws == 0;
+			}
+		};
+
 		/*!
 		 * Creates a new tournament that uses \a gameManager
 		 * to manage the games.
@@ -85,6 +137,13 @@ class LIB_EXPORT Tournament : public QObject
 		QString name() const;
 		/*! Returns the tournament site, ie. the "Site" tag's value. */
 		QString site() const;
+		/*!
+		 * Returns the factor by which the players' time controls
+		 * were scaled to the speed of the host.
+		 *
+		 * \sa setTimeControlScale()
+		 */
+		double timeControlScale() const;
 		/*! Returns the games' chess variant. */
 		QString variant() const;
 		/*! Returns the currently executing round of the tournament. */
@@ -125,6 +184,24 @@ class LIB_EXPORT Tournament : public QObject
 		 * stopping criterion.
 		 */
 		Sprt* sprt() const;
+		/*!
+		 * Adds an SPRT monitor named \a name whose decision stops the
+		 * tournament according to \a policy, and returns its SPRT
+		 * object for initialization.
+		 *
+		 * All monitors are fed from the same results of the first
+		 * player, so one match can test several hypotheses. An empty
+		 * \a name refers to the default monitor of sprt(). Returns
+		 * nullptr if the monitor is already initialized.
+		 */
+		Sprt* addSprt(const QString& name,
+			      Sprt::StopPolicy policy = Sprt::StopOnDecision);
+		/*! Returns the number of SPRT monitors, including sprt(). */
+		int sprtCount() const;
+		/*! Returns the SPRT of monitor \a index; 0 is sprt(). */
+		Sprt* sprtAt(int index) const;
+		/*! Returns the name of monitor \a index. */
+		QString sprtName(int index) const;
 		/*! Returns true if the players swap sides in an encounter. */
 		bool swapSides() const;
 		/*! Returns true if the tournament wants Berger/Schurig scheduling. */
@@ -138,6 +215,15 @@ class LIB_EXPORT Tournament : public QObject
 		void setName(const QString& name);
 		/*! Sets the tournament's site to \a site. */
 		void setSite(const QString& site);
+		/*!
+		 * Records that the time controls of the players were
+		 * scaled by \a factor to match the speed of the host.
+		 * The factor is saved in the "TimeControlScale" tag of
+		 * the games. The default is 1.0 (no scaling).
+		 *
+		 * \sa HostCalibration
+		 */
+		void setTimeControlScale(double factor);
 		/*! Sets the games' chess variant to \a variant. */
 		void setVariant(const QString& variant);
 		/*!
@@ -201,6 +287,37 @@ class LIB_EXPORT Tournament : public QObject
 		 */
 		void setPgnOutput(const QString& fileName,
 				  PgnGame::PgnMode mode = PgnGame::Verbose);
+		/*!
+		 * Sets the order in which the games are saved.
+		 *
+		 * If \a ordered is true (the default) then the games are
+		 * saved in the order they were started. Games that finish
+		 * early are held in memory until all the games before them
+		 * are finished. Otherwise the games are saved as soon as
+		 * they finish, with the game number in a "GameNumber" tag.
+		 */
+		void setPgnOutputOrdered(bool ordered);
+
+		/*!
+		 * Sets the binary archive output file for the games to
+		 * \a fileName.
+		 *
+		 * The games are appended to the archive in the same order
+		 * as they are written to the PGN output file. If no archive
+		 * output file is set (default) then the games won't be
+		 * archived.
+		 *
+		 * \sa GameArchive
+		 */
+		void setBinaryOutput(const QString& fileName);
+
+		/*!
+		 * Sets the sync policy of the game, archive and EPD output
+		 * files to \a policy.
+		 *
+		 * The default policy is GameWriter::NoSync.
+		 */
+		void setOutputSyncPolicy(GameWriter::SyncPolicy policy);
 
 		/*!
 		 * Sets PgnGame cleanup mode to \a enabled.
@@ -211,12 +328,35 @@ class LIB_EXPORT Tournament : public QObject
 		void setPgnCleanupEnabled(bool enabled);
 
 		/*!
-		 * Sets the EPD output file for the end positions to \a fileName.
+		 * Sets the EPD output file for the positions to \a fileName.
+		 *
+		 * The positions at \a plies of each game are saved, or the
+		 * end positions if \a plies is empty. If \a unique is true
+		 * then duplicate positions are skipped.
+		 * See GameWriter::setEpdOutput() for details.
 		 *
 		 * If no EPD output file is set (default) then the positions
 		 * will not be saved.
 		 */
-		void setEpdOutput(const QString& fileName);
+		void setEpdOutput(const QString& fileName,
+				  const QList<int>& plies = QList<int>(),
+				  bool unique = false);
+		/*!
+		 * Sets the training data output file to \a fileName.
+		 *
+		 * The position before every move the players make is saved
+		 * with the mover's score and search depth, the move and
+		 * the result of the game. Positions that have any of the
+		 * TrainingData::Flag values in \a skipFlags are left out,
+		 * and of the others a random fraction \a sampleRate is
+		 * saved.
+		 *
+		 * If no training data output file is set (default) then
+		 * the positions will not be saved.
+		 */
+		void setDataOutput(const QString& fileName,
+				   int skipFlags = TrainingData::BookMove,
+				   double sampleRate = 1.0);
 
  		/*!
  		 * Sets the live PGN output file for the games to \a fileName.
@@ -227,6 +367,109 @@ class LIB_EXPORT Tournament : public QObject
  		 */
 		void setLivePgnOutput(const QString& fileName,
 				  PgnGame::PgnMode mode = PgnGame::Verbose);
+		/*!
+		 * Sets the minimum interval between two rewrites of the
+		 * live PGN output file to \a msecs milliseconds.
+		 *
+		 * The default interval is 0, which rewrites the file after
+		 * every move.
+		 */
+		void setLivePgnInterval(int msecs);
+		/*!
+		 * Sets the live event output file to \a fileName.
+		 *
+		 * The start, every move and the result of each game are
+		 * appended to the file as tab-separated lines that begin
+		 * with the game number:
+		 * - start: "N start WHITE BLACK"
+		 * - move: "N move PLY SAN COMMENT"
+		 * - result: "N result RESULT DESCRIPTION"
+		 *
+		 * If no live event output file is set (default) then no
+		 * events are written.
+		 */
+		void setLiveEventOutput(const QString& fileName);
+		/*!
+		 * Sets the event log output file to \a fileName.
+		 *
+		 * The event log is a JSON lines file with one object per
+		 * event. Every object has an "event" member with the event
+		 * type and a "time" member with the UTC time:
+		 * - tournament_start: the tournament type, variant, players
+		 *   and the planned number of games
+		 * - game_start: the game number, round, opening index,
+		 *   players and the starting position
+		 * - game_end: the game number, players, result, termination
+		 *   type and reason, number of plies, the game duration and
+		 *   the thinking time of both players in milliseconds, and
+		 *   a "cached" flag if the game came from the result cache
+		 * - engine_crash: the game number, the crashed engine and
+		 *   whether the engine is restarted for the next game
+		 * - sprt: the name of a named monitor, the log-likelihood
+		 *   ratio, its bounds and the test result
+		 * - ratings: games, score, rating and error margin of every
+		 *   player, written after each game
+		 * - bootstrap: the number of resamples and the 2.5th, 50th
+		 *   and 97.5th percentile of every player's rating
+		 * - tournament_end: the number of finished games and the
+		 *   error message, if any
+		 *
+		 * If no event log file is set (default) then no events
+		 * are written.
+		 */
+		void setEventLogOutput(const QString& fileName);
+		/*!
+		 * Sets the opening statistics output file to \a fileName.
+		 *
+		 * When the tournament finishes, the results of every
+		 * opening are written to the file as tab-separated lines
+		 * with the opening index, the key and FEN of the opening
+		 * position, the number of games, white wins, black wins
+		 * and draws, and "drawn" or "decisive" if every game of
+		 * the opening was drawn or decisive.
+		 */
+		void setOpeningStatsOutput(const QString& fileName);
+		/*!
+		 * Takes the games that were already played from the result
+		 * cache in \a fileName, and adds the new games to it.
+		 *
+		 * A game whose engines, options, opening, colors, time
+		 * controls, adjudication settings and random seed match a
+		 * cached game is finished with the cached moves and result
+		 * without starting the engines, and gets a "CachedResult"
+		 * tag. Games with opening books or human players aren't
+		 * cached.
+		 *
+		 * The cache is only correct for engines that always play
+		 * the same moves in the same situation, eg. engines that
+		 * search a fixed number of nodes. An empty \a fileName
+		 * disables the cache, which is the default.
+		 *
+		 * \sa GameResultCache
+		 */
+		void setResultCache(const QString& fileName);
+		/*!
+		 * Sets the number of bootstrap resamples of the ratings
+		 * to \a count.
+		 *
+		 * If \a count is positive, the bootstrap confidence
+		 * intervals of the ratings are computed when the tournament
+		 * finishes and on updateBootstrapRatings(). The games that
+		 * repeat an opening are resampled together. The default is
+		 * 0 (no bootstrap).
+		 * \sa BootstrapRatings
+		 */
+		void setBootstrapSamples(int count);
+		/*!
+		 * Computes the bootstrap ratings of the current results
+		 * and writes them to the event log.
+		 *
+		 * Returns false if the bootstrap is disabled or there are
+		 * no games yet.
+		 */
+		bool updateBootstrapRatings();
+		/*! Returns the bootstrap ratings of the last update. */
+		const BootstrapRatings* bootstrapRatings() const;
 
 		/*!
 		 * Sets the number of opening repetitions to \a count.
@@ -263,6 +506,28 @@ class LIB_EXPORT Tournament : public QObject
 		 * repeated and randomly chosen openings, will resume as well.
 		 */
 		void setResume(int nextGameNumber);
+		/*!
+		 * Sets the seed of the per-game random number streams
+		 * to \a seed.
+		 *
+		 * If \a seed is not 0, each game's opening, book moves and
+		 * random starting position are picked from a stream seeded
+		 * with Mersenne::streamSeed(\a seed, game number), so the
+		 * setup of a game doesn't depend on the games before it.
+		 * The stream's seed is saved in the GameSeed tag of the
+		 * PGN. The default is 0.
+		 */
+		void setSeed(quint32 seed);
+		/*!
+		 * Plays only game number \a number of the tournament.
+		 *
+		 * The earlier games are skipped like in a resumed
+		 * tournament, and the tournament finishes after the game.
+		 * With the same seed and options the game has the same
+		 * setup as in the full tournament.
+		 * \sa setSeed()
+		 */
+		void setReplayGame(int number);
 		/*!
 		 * Sets the tournament to Berger/Schurig scheduling if \a enabled.
 		 */
@@ -284,11 +549,30 @@ class LIB_EXPORT Tournament : public QObject
 			       const TimeControl& timeControl,
 			       const OpeningBook* book = nullptr,
 			       int bookDepth = 256);
+		/*!
+		 * Adds player \a builder to the tournament with a shared
+		 * opening \a book.
+		 *
+		 * The tournament keeps a reference to \a book for as long
+		 * as it exists, regardless of the book ownership setting.
+		 */
+		void addPlayer(PlayerBuilder* builder,
+			       const TimeControl& timeControl,
+			       const QSharedPointer<const OpeningBook>& book,
+			       int bookDepth = 256);
 		/*!
 		 * Returns tournament results as a string.
 		 * The default implementation works for most tournament types.
+		 *
+		 * The results are computed again only if the scores or the
+		 * player names have changed since the last call.
 		 */
 		virtual QString results() const;
+		/*!
+		 * Returns the results of the openings played so far,
+		 * ordered by their index.
+		 */
+		QList<OpeningStats> openingStats() const;
 
 	public slots:
 		/*! Starts the tournament. */
@@ -332,6 +616,20 @@ class LIB_EXPORT Tournament : public QObject
 				  int number,
 				  int whiteIndex,
 				  int blackIndex);
+		/*!
+		 * This signal is emitted when move \a move is added to game
+		 * \a number at ply \a ply, with the PGN \a comment of the
+		 * move and its evaluation.
+		 *
+		 * The moves come in batches from the game's thread, so the
+		 * signal can be late, but every move of a started game is
+		 * reported, including the opening moves. The signal must be
+		 * connected before a game starts to get its moves.
+		 */
+		void moveAdded(int number,
+			       int ply,
+			       const QString& move,
+			       const QString& comment);
 		/*!
 		 * This signal is emitted when all of the tournament's games
 		 * have been played or after the tournament was stopped.
@@ -438,14 +736,17 @@ class LIB_EXPORT Tournament : public QObject
 
 	private slots:
 		void startNextGame();
-		bool writePgn(PgnGame* pgn, int gameNumber);
-		bool writeEpd(ChessGame* game);
+		void writePgn(PgnGame* pgn, int gameNumber);
+		void writeEpd(ChessGame* game);
+		void writeTrainingData(ChessGame* game);
 		void onGameStarted(ChessGame* game);
 		void onGameFinished(ChessGame* game);
 		void onGameDestroyed(ChessGame* game);
 		void onGameStartFailed(ChessGame* game);
 		void onPgnMove();
 		void onEngineUpdated(int engineIndex);
+		void onEngineStopMeasured(int msecs, bool timedOut);
+		void onEngineDestroyed(QObject* engine);
 
 	private:
 		struct GameData
@@ -453,9 +754,15 @@ class LIB_EXPORT Tournament : public QObject
 			int number;
 			int whiteIndex;
 			int blackIndex;
+			int openingIndex;
+			QElapsedTimer timer;
+			// An empty key means that the game isn't cached
+			QString cacheKey;
+			bool cached;
 		};
 		struct RankingData
 		{
+			int index;
 			QString name;
 			int games;
 			qreal score;
@@ -464,12 +771,33 @@ class LIB_EXPORT Tournament : public QObject
 			qreal eloDiff;
 		};
 
+		struct SprtMonitor
+		{
+			QString name;
+			Sprt* sprt;
+			Sprt::StopPolicy policy;
+		};
+
+		PgnGame nextOpening();
+		int openingIndex() const;
+		void seedGame(ChessGame* game);
+		void watchEngine(ChessPlayer* player, int index);
+		int pairIndex(int player1, int player2) const;
+		void writeRatingEvent();
+		bool writeOpeningStats() const;
+		QString resultCacheKey(ChessGame* game,
+				       const TournamentPlayer& white,
+				       const TournamentPlayer& black);
+		bool finishCachedGame(ChessGame* game, GameData* data);
+		void storeCachedGame(ChessGame* game, const GameData* data);
+
 		GameManager* m_gameManager;
 		EngineManager* m_engineManager;
 		ChessGame* m_lastGame;
 		QString m_error;
 		QString m_name;
 		QString m_site;
+		double m_timeControlScale;
 		QString m_variant;
 		int m_round;
 		int m_nextGameNumber;
@@ -485,29 +813,49 @@ class LIB_EXPORT Tournament : public QObject
 		int m_openingRepetitions;
 		bool m_recover;
 		bool m_pgnCleanup;
+		bool m_pgnOrdered;
 		bool m_finished;
 		bool m_bookOwnership;
+		int m_dataSkipFlags;
+		double m_dataSampleRate;
+		QList< QSharedPointer<const OpeningBook> > m_sharedBooks;
+		QSharedPointer<GamePool> m_gamePool;
+		QSharedPointer<OpeningCache> m_openingCache;
 		GameAdjudicator m_adjudicator;
 		OpeningSuite* m_openingSuite;
-		Sprt* m_sprt;
-		QFile m_pgnFile;
-		QTextStream m_pgnOut;
-		QFile m_epdFile;
-		QTextStream m_epdOut;
+		OpeningPrefetcher* m_openingPrefetcher;
+		// The default monitor is the first one
+		QList<SprtMonitor> m_sprts;
+		RatingSolver* m_ratingSolver;
+		BootstrapRatings* m_bootstrap;
+		int m_bootstrapSamples;
+		GameResultCache* m_resultCache;
+		QMap<int, OpeningStats> m_openingStats;
+		mutable QString m_results;
+		mutable bool m_resultsValid;
+		QString m_openingStatsOutput;
+		GameWriter m_writer;
 		QString m_startFen;
 		int m_repetitionCounter;
+		int m_openingCounter;
 		int m_swapSides;
-		PgnGame::PgnMode m_pgnOutMode;
 		TournamentPair* m_pair;
-		QMap< QPair<int, int>, TournamentPair* > m_pairs;
+		// Pairs of real players in a triangular array, and pairs
+		// with a BYE by player index
+		QVector<TournamentPair*> m_pairTable;
+		QHash<int, TournamentPair*> m_byePairs;
 		QList<TournamentPlayer> m_players;
 		QMap<int, PgnGame> m_pgnGames;
-		QMap<ChessGame*, GameData*> m_gameData;
+		MemoryAccount m_pgnMemory;
+		QHash<ChessGame*, GameData*> m_gameData;
+		// Player indexes of the engines whose stops are measured
+		QHash<const QObject*, int> m_engineIndex;
+		QMap<int, Sprt::GameResult> m_sprtPairs;
 		QVector<Chess::Move> m_openingMoves;
-		QString m_livePgnOut;
-		PgnGame::PgnMode m_livePgnOutMode;
 		QString m_eventDate;
 		int m_resumeGameNumber;
+		int m_replayGame;
+		quint32 m_seed;
 		bool m_bergerSchedule;
 		QVector<QPair<QVector<Chess::Move>, QString> > m_cycleOpenings;
 		bool m_reloadEngines;
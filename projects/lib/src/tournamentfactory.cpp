@@ -19,6 +19,8 @@
 #include "roundrobintournament.h"
 #include "gauntlettournament.h"
 #include "knockouttournament.h"
+#include "selectiontournament.h"
+#include "swisstournament.h"
 
 Tournament* TournamentFactory::create(const QString& type,
 				      GameManager* gameManager,
@@ -31,6 +33,10 @@ Tournament* TournamentFactory::create(const QString& type,
 		return new GauntletTournament(gameManager, engineManager, parent);
 	if (type == "knockout")
 		return new KnockoutTournament(gameManager, engineManager, parent);
+	if (type == "selection")
+		return new SelectionTournament(gameManager, engineManager, parent);
+	if (type == "swiss")
+		return new SwissTournament(gameManager, engineManager, parent);
 
 	return nullptr;
 }
@@ -28,7 +28,18 @@ TournamentPlayer::TournamentPlayer(PlayerBuilder* builder,
 	  m_bookDepth(bookDepth),
 	  m_wins(0),
 	  m_draws(0),
-	  m_losses(0)
+	  m_losses(0),
+	  m_searchedMoves(0),
+	  m_nodeCount(0),
+	  m_searchTime(0),
+	  m_limitOvershoots(0),
+	  m_maxNodeOvershoot(0),
+	  m_ponderedMoves(0),
+	  m_ponderHits(0),
+	  m_stopCount(0),
+	  m_stopLatency(0),
+	  m_maxStopLatency(0),
+	  m_stopTimeouts(0)
 {
 	Q_ASSERT(builder != nullptr);
 }
@@ -112,3 +123,111 @@ int TournamentPlayer::gamesFinished() const
 {
 	return m_wins + m_draws + m_losses;
 }
+
+void TournamentPlayer::addMoveStats(quint64 nodes, int moveTime, int depth)
+{
+	m_searchedMoves++;
+	m_nodeCount += nodes;
+	m_searchTime += qMax(moveTime, 0);
+
+	const quint64 nodeLimit = quint64(qMax(m_timeControl.nodeLimit(), 0));
+	const int plyLimit = m_timeControl.plyLimit();
+	const bool nodeOvershoot = (nodeLimit > 0 && nodes > nodeLimit);
+
+	if (nodeOvershoot)
+		m_maxNodeOvershoot = qMax(m_maxNodeOvershoot, nodes - nodeLimit);
+	if (nodeOvershoot || (plyLimit > 0 && depth > plyLimit))
+		m_limitOvershoots++;
+}
+
+int TournamentPlayer::searchedMoves() const
+{
+	return m_searchedMoves;
+}
+
+quint64 TournamentPlayer::nodeCount() const
+{
+	return m_nodeCount;
+}
+
+qint64 TournamentPlayer::searchTime() const
+{
+	return m_searchTime;
+}
+
+quint64 TournamentPlayer::nps() const
+{
+	if (m_searchTime <= 0)
+		return 0;
+	return m_nodeCount * 1000 / quint64(m_searchTime);
+}
+
+int TournamentPlayer::limitOvershoots() const
+{
+	return m_limitOvershoots;
+}
+
+quint64 TournamentPlayer::maxNodeOvershoot() const
+{
+	return m_maxNodeOvershoot;
+}
+
+void TournamentPlayer::addPonderStats(int moves, int hits)
+{
+	Q_ASSERT(hits <= moves);
+
+	m_ponderedMoves += moves;
+	m_ponderHits += hits;
+}
+
+int TournamentPlayer::ponderedMoves() const
+{
+	return m_ponderedMoves;
+}
+
+int TournamentPlayer::ponderHits() const
+{
+	return m_ponderHits;
+}
+
+void TournamentPlayer::addStopLatency(int msecs, bool timedOut)
+{
+	msecs = qMax(msecs, 0);
+	m_stopCount++;
+	m_stopLatency += msecs;
+	m_maxStopLatency = qMax(m_maxStopLatency, msecs);
+	if (timedOut)
+		m_stopTimeouts++;
+}
+
+int TournamentPlayer::stopCount() const
+{
+	return m_stopCount;
+}
+
+int TournamentPlayer::averageStopLatency() const
+{
+	if (m_stopCount == 0)
+		return 0;
+	return int(m_stopLatency / m_stopCount);
+}
+
+int TournamentPlayer::maxStopLatency() const
+{
+	return m_maxStopLatency;
+}
+
+int TournamentPlayer::stopTimeouts() const
+{
+	return m_stopTimeouts;
+}
+
+void TournamentPlayer::addTimeStats(const MoveTimeStats& stats)
+{
+	m_timeStats.add(stats);
+}
+
+const MoveTimeStats& TournamentPlayer::timeStats() const
+{
+	return m_timeStats;
+}
@@ -20,6 +20,7 @@
 
 #include "playerbuilder.h"
 #include "timecontrol.h"
+#include "movetimestats.h"
 
 class OpeningBook;
 
@@ -71,6 +72,64 @@ class LIB_EXPORT TournamentPlayer
 		 */
 		int gamesFinished() const;
 
+		/*!
+		 * Adds the search statistics of one of the player's moves:
+		 * \a nodes searched in \a moveTime milliseconds to a depth
+		 * of \a depth plies.
+		 *
+		 * A move that searched more nodes or plies than the time
+		 * control allows is counted as an overshoot.
+		 */
+		void addMoveStats(quint64 nodes, int moveTime, int depth);
+		/*! Returns the number of moves with search statistics. */
+		int searchedMoves() const;
+		/*! Returns the total number of nodes searched. */
+		quint64 nodeCount() const;
+		/*! Returns the total search time in milliseconds. */
+		qint64 searchTime() const;
+		/*! Returns the average search speed in nodes per second. */
+		quint64 nps() const;
+		/*!
+		 * Returns the number of moves that exceeded the time
+		 * control's node or ply limit.
+		 */
+		int limitOvershoots() const;
+		/*!
+		 * Returns the largest number of nodes by which a move
+		 * exceeded the time control's node limit.
+		 */
+		quint64 maxNodeOvershoot() const;
+
+		/*!
+		 * Adds the pondering statistics of one game: \a moves
+		 * pondered on, \a hits of which were ponder hits.
+		 */
+		void addPonderStats(int moves, int hits);
+		/*! Returns the total number of moves pondered on. */
+		int ponderedMoves() const;
+		/*! Returns the total number of ponder hits. */
+		int ponderHits() const;
+
+		/*!
+		 * Adds the time in milliseconds, \a msecs, the player took
+		 * to stop searching at the end of a game. If \a timedOut is
+		 * true the player was terminated for not stopping in time.
+		 */
+		void addStopLatency(int msecs, bool timedOut);
+		/*! Returns the number of measured stops. */
+		int stopCount() const;
+		/*! Returns the average stop latency in milliseconds. */
+		int averageStopLatency() const;
+		/*! Returns the longest stop latency in milliseconds. */
+		int maxStopLatency() const;
+		/*! Returns the number of stops that timed out. */
+		int stopTimeouts() const;
+
+		/*! Adds the time usage statistics of one game, \a stats. */
+		void addTimeStats(const MoveTimeStats& stats);
+		/*! Returns the time usage statistics of all games. */
+		const MoveTimeStats& timeStats() const;
+
 	private:
 		PlayerBuilder* m_builder;
 		TimeControl m_timeControl;
@@ -79,6 +138,18 @@ class LIB_EXPORT TournamentPlayer
 		int m_wins;
 		int m_draws;
 		int m_losses;
+		int m_searchedMoves;
+		quint64 m_nodeCount;
+		qint64 m_searchTime;
+		int m_limitOvershoots;
+		quint64 m_maxNodeOvershoot;
+		int m_ponderedMoves;
+		int m_ponderHits;
+		int m_stopCount;
+		qint64 m_stopLatency;
+		int m_maxStopLatency;
+		int m_stopTimeouts;
+		MoveTimeStats m_timeStats;
 };
 
 #endif // TOURNAMENTPLAYER_H
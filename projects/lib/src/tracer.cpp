@@ -0,0 +1,193 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadStorage>
+#include <QVector>
+
+namespace {
+
+struct TraceEvent
+{
+	char phase;
+	const char* category;
+	const char* name;
+	quint64 id;
+	qint64 timestamp;
+	qint64 duration;
+	QString detail;
+};
+
+// The events of one thread. The mutex is only contended while the
+// events are written to a file.
+struct TraceBuffer
+{
+	int threadId;
+	QString threadName;
+	QMutex mutex;
+	QVector<TraceEvent> events;
+};
+
+QMutex s_bufferMutex;
+QList<QSharedPointer<TraceBuffer> > s_buffers;
+QThreadStorage<QSharedPointer<TraceBuffer> > s_threadBuffer;
+QElapsedTimer s_clock;
+
+TraceBuffer* threadBuffer()
+{
+	if (!s_threadBuffer.hasLocalData())
+	{
+		QSharedPointer<TraceBuffer> buffer(new TraceBuffer);
+		QThread* thread = QThread::currentThread();
+		buffer->threadName = thread->objectName();
+		if (QCoreApplication::instance() != nullptr
+		&&  thread == QCoreApplication::instance()->thread())
+			buffer->threadName = "main";
+
+		// The buffer outlives its thread so that the events can be
+		// written when the run ends
+		QMutexLocker locker(&s_bufferMutex);
+		buffer->threadId = s_buffers.size() + 1;
+		if (buffer->threadName.isEmpty())
+			buffer->threadName = QString("thread %1").arg(buffer->threadId);
+		s_buffers.append(buffer);
+		s_threadBuffer.setLocalData(buffer);
+	}
+
+	return s_threadBuffer.localData().data();
+}
+
+QString escape(const QString& str)
+{
+	QString ret;
+	ret.reserve(str.size());
+	for (const QChar c : str)
+	{
+		if (c == '"' || c == '\\')
+			ret += '\\';
+		if (c.unicode() < 0x20)
+			ret += QString("\\u%1").arg(int(c.unicode()), 4, 16, QChar('0'));
+		else
+			ret += c;
+	}
+	return ret;
+}
+
+} // anonymous namespace
+
+QAtomicInt Tracer::s_enabled(0);
+
+void Tracer::setEnabled(bool enabled)
+{
+	if (enabled && !s_clock.isValid())
+		s_clock.start();
+	s_enabled.store(enabled ? 1 : 0);
+}
+
+qint64 Tracer::timestamp()
+{
+	return s_clock.isValid() ? s_clock.nsecsElapsed() / 1000 : 0;
+}
+
+void Tracer::record(char phase,
+		    const char* category,
+		    const char* name,
+		    const void* id,
+		    qint64 start,
+		    const QString& detail)
+{
+	const qint64 now = timestamp();
+	TraceEvent event;
+	event.phase = phase;
+	event.category = category;
+	event.name = name;
+	event.id = quint64(quintptr(id));
+	event.timestamp = start >= 0 ? start : now;
+	event.duration = start >= 0 ? now - start : 0;
+	event.detail = detail;
+
+	TraceBuffer* buffer = threadBuffer();
+	QMutexLocker locker(&buffer->mutex);
+	buffer->events.append(event);
+}
+
+int Tracer::eventCount()
+{
+	QMutexLocker locker(&s_bufferMutex);
+	int count = 0;
+	for (const auto& buffer : s_buffers)
+	{
+		QMutexLocker bufferLocker(&buffer->mutex);
+		count += buffer->events.size();
+	}
+	return count;
+}
+
+bool Tracer::write(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QTextStream out(&file);
+	out.setCodec("UTF-8");
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	QMutexLocker locker(&s_bufferMutex);
+	bool first = true;
+	for (const auto& buffer : s_buffers)
+	{
+		QMutexLocker bufferLocker(&buffer->mutex);
+		const QString common = QString(",\"pid\":1,\"tid\":%1")
+			.arg(buffer->threadId);
+
+		out << (first ? "" : ",\n")
+		    << "{\"name\":\"thread_name\",\"ph\":\"M\"" << common
+		    << ",\"args\":{\"name\":\"" << escape(buffer->threadName)
+		    << "\"}}";
+		first = false;
+
+		for (const TraceEvent& event : buffer->events)
+		{
+			out << ",\n{\"name\":\"" << event.name
+			    << "\",\"cat\":\"" << event.category
+			    << "\",\"ph\":\"" << event.phase
+			    << "\",\"ts\":" << event.timestamp << common;
+			if (event.phase == 'X')
+				out << ",\"dur\":" << event.duration;
+			else if (event.phase == 'i')
+				out << ",\"s\":\"t\"";
+			else
+				out << ",\"id\":\"0x" << QString::number(event.id, 16) << '"';
+			if (!event.detail.isEmpty())
+				out << ",\"args\":{\"detail\":\""
+				    << escape(event.detail) << "\"}";
+			out << '}';
+		}
+	}
+
+	out << "\n]}\n";
+	out.flush();
+	return file.error() == QFile::NoError;
+}
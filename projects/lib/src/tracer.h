@@ -0,0 +1,170 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+/*!
+ * \brief Records the phases of games for the Chrome trace viewer.
+ *
+ * When tracing is enabled, the game manager, the games, the engines
+ * and the tournament record how long each phase of a game takes:
+ * starting the engine processes, the protocol handshake, pings,
+ * replaying the opening, thinking, adjudication and writing the PGN.
+ * The events are kept in memory, in a buffer per thread so that the
+ * threads don't contend for a lock, and write() saves them in the
+ * Chrome trace event format. The file can be opened in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing.
+ *
+ * A phase that starts and ends in the same function is recorded with
+ * a TraceSpan. A phase that spans several events, eg. an engine's
+ * handshake, is recorded with begin() and end() and an id that tells
+ * the concurrent phases apart; usually the address of the object.
+ *
+ * The category and name strings must be string literals or otherwise
+ * outlive the tracer, because only the pointers are stored. When
+ * tracing is disabled (the default) every hook costs one relaxed load
+ * and a branch.
+ */
+class LIB_EXPORT Tracer
+{
+	public:
+		/*! Returns true if tracing is enabled. */
+		static bool isEnabled()
+		{
+			return s_enabled.load() != 0;
+		}
+		/*!
+		 * Enables or disables tracing. The time stamps of the
+		 * events start from the first time tracing is enabled.
+		 */
+		static void setEnabled(bool enabled);
+
+		/*! Returns the current time stamp in microseconds. */
+		static qint64 timestamp();
+
+		/*!
+		 * Records a phase that started at \a start (a timestamp())
+		 * and ends now, with \a detail in its arguments.
+		 */
+		static void complete(const char* category,
+				     const char* name,
+				     qint64 start,
+				     const QString& detail = QString())
+		{
+			if (isEnabled())
+				record('X', category, name, nullptr, start, detail);
+		}
+		/*!
+		 * Records the beginning of phase \a name of object \a id.
+		 * The phase may end in another thread.
+		 */
+		static void begin(const char* category,
+				  const char* name,
+				  const void* id,
+				  const QString& detail = QString())
+		{
+			if (isEnabled())
+				record('b', category, name, id, -1, detail);
+		}
+		/*! Records the end of a phase that began with begin(). */
+		static void end(const char* category,
+				const char* name,
+				const void* id)
+		{
+			if (isEnabled())
+				record('e', category, name, id, -1, QString());
+		}
+		/*! Records an event that has no duration. */
+		static void instant(const char* category,
+				    const char* name,
+				    const QString& detail = QString())
+		{
+			if (isEnabled())
+				record('i', category, name, nullptr, -1, detail);
+		}
+
+		/*! Returns the number of recorded events. */
+		static int eventCount();
+		/*!
+		 * Writes the recorded events to \a fileName as a Chrome
+		 * trace. Returns true if successful; otherwise returns false.
+		 */
+		static bool write(const QString& fileName);
+
+	private:
+		Tracer();
+
+		static void record(char phase,
+				   const char* category,
+				   const char* name,
+				   const void* id,
+				   qint64 start,
+				   const QString& detail);
+
+		static QAtomicInt s_enabled;
+};
+
+/*!
+ * \brief A phase recorded from its construction to its destruction.
+ *
+ * \sa Tracer::complete()
+ */
+class TraceSpan
+{
+	public:
+		/*! Starts phase \a name in \a category. */
+		TraceSpan(const char* category, const char* name)
+			: m_category(category),
+			  m_name(name),
+			  m_start(Tracer::isEnabled() ? Tracer::timestamp() : -1)
+		{
+		}
+		/*! Ends the phase. */
+		~TraceSpan()
+		{
+			if (m_start >= 0)
+				Tracer::complete(m_category, m_name, m_start, m_detail);
+		}
+
+		/*!
+		 * Returns true if the phase is recorded, ie. tracing was
+		 * enabled when it started.
+		 */
+		bool isRecorded() const
+		{
+			return m_start >= 0;
+		}
+		/*! Sets the details shown with the phase to \a detail. */
+		void setDetail(const QString& detail)
+		{
+			m_detail = detail;
+		}
+
+	private:
+		Q_DISABLE_COPY(TraceSpan)
+
+		const char* m_category;
+		const char* m_name;
+		qint64 m_start;
+		QString m_detail;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,515 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trainingdata.h"
+#include <cstring>
+#include <QStringList>
+#include <QtEndian>
+#include "gamewriter.h"
+
+namespace {
+
+// File header: magic and format version
+const char s_magic[4] = { 'C', 'C', 'T', 'D' };
+const char s_version = 1;
+const qint64 s_headerSize = 8;
+
+// Block header: payload size and position count
+const qint64 s_blockHeaderSize = 8;
+
+const char s_pieceSymbols[] = "pnbrqkr";
+const int s_rook = 3;
+const int s_king = 5;
+const int s_castlingRook = 6;
+const int s_black = 8;
+const int s_noEpSquare = 64;
+const int s_maxScore = 32000;
+
+void encode(const TrainingData::Position& pos, uchar* out)
+{
+	qToLittleEndian(pos.occupancy, out);
+	memcpy(out + 8, pos.pieces, sizeof(pos.pieces));
+	out[24] = uchar((pos.epSquare >= 0 ? pos.epSquare : s_noEpSquare)
+		      | (pos.blackToMove ? 0x80 : 0));
+	out[25] = uchar(qBound(0, pos.halfMoveClock, 255));
+	qToLittleEndian(qint16(qBound(-s_maxScore, pos.score, s_maxScore)),
+			out + 26);
+	qToLittleEndian(pos.move, out + 28);
+	out[30] = uchar(qBound(0, pos.depth, 255));
+	out[31] = uchar((pos.result & 0x3) | ((pos.flags & 0x7) << 2));
+}
+
+void decode(const uchar* data, TrainingData::Position& pos)
+{
+	pos.occupancy = qFromLittleEndian<quint64>(data);
+	memcpy(pos.pieces, data + 8, sizeof(pos.pieces));
+	pos.epSquare = data[24] & 0x7f;
+	if (pos.epSquare >= s_noEpSquare)
+		pos.epSquare = -1;
+	pos.blackToMove = (data[24] & 0x80) != 0;
+	pos.halfMoveClock = data[25];
+	pos.score = qFromLittleEndian<qint16>(data + 26);
+	pos.move = qFromLittleEndian<quint16>(data + 28);
+	pos.depth = data[30];
+	pos.result = TrainingData::Result(data[31] & 0x3);
+	pos.flags = (data[31] >> 2) & 0x7;
+}
+
+/*
+ * Returns the file of the rook at the end of \a color's castling
+ * path towards \a step, or -1 if there's none.
+ */
+int castlingRookFile(const int* board, int color, int kingFile, int step)
+{
+	const int backRank = (color == s_black) ? 56 : 0;
+	for (int file = (step > 0) ? 7 : 0; file != kingFile; file -= step)
+	{
+		const int piece = board[backRank + file];
+		if (piece == (s_rook | color) || piece == (s_castlingRook | color))
+			return file;
+	}
+	return -1;
+}
+
+int kingFile(const int* board, int color)
+{
+	const int backRank = (color == s_black) ? 56 : 0;
+	for (int file = 0; file < 8; file++)
+	{
+		if (board[backRank + file] == (s_king | color))
+			return file;
+	}
+	return -1;
+}
+
+} // anonymous namespace
+
+TrainingData::Position::Position()
+	: occupancy(0),
+	  blackToMove(false),
+	  epSquare(-1),
+	  halfMoveClock(0),
+	  score(0),
+	  depth(0),
+	  move(0),
+	  result(NoResult),
+	  flags(0)
+{
+	memset(pieces, 0, sizeof(pieces));
+}
+
+TrainingData::TrainingData()
+	: m_blockCount(0),
+	  m_readPos(0)
+{
+}
+
+TrainingData::~TrainingData()
+{
+	close();
+}
+
+bool TrainingData::packFen(const QString& fen, Position& pos)
+{
+	const QStringList fields(fen.split(' ', QString::SkipEmptyParts));
+	if (fields.size() < 2)
+		return false;
+	const QStringList ranks(fields.at(0).split('/'));
+	if (ranks.size() != 8)
+		return false;
+
+	int board[64];
+	int count = 0;
+	for (int i = 0; i < 64; i++)
+		board[i] = -1;
+
+	for (int i = 0; i < 8; i++)
+	{
+		const int rank = 7 - i;
+		int file = 0;
+		for (const QChar& c : ranks.at(i))
+		{
+			if (c >= '1' && c <= '8')
+			{
+				file += c.digitValue();
+				continue;
+			}
+
+			const char symbol = c.toLower().toLatin1();
+			const char* type = strchr(s_pieceSymbols, symbol);
+			if (symbol == 0 || type == nullptr
+			||  type - s_pieceSymbols > s_king || file >= 8)
+				return false;
+			board[rank * 8 + file] = int(type - s_pieceSymbols)
+					       | (c.isLower() ? s_black : 0);
+			file++;
+			count++;
+		}
+		if (file != 8)
+			return false;
+	}
+	if (count > 32)
+		return false;
+
+	if (fields.at(1) == "w")
+		pos.blackToMove = false;
+	else if (fields.at(1) == "b")
+		pos.blackToMove = true;
+	else
+		return false;
+
+	// Both X-FEN and Shredder-FEN castling rights are accepted
+	const QString castling(fields.value(2, "-"));
+	for (const QChar& c : castling)
+	{
+		if (c == '-')
+			continue;
+
+		const int color = c.isLower() ? s_black : 0;
+		const int backRank = color ? 56 : 0;
+		const char symbol = c.toLower().toLatin1();
+		const int king = kingFile(board, color);
+		int rookFile = -1;
+
+		if (king == -1)
+			return false;
+		if (symbol == 'k')
+			rookFile = castlingRookFile(board, color, king, 1);
+		else if (symbol == 'q')
+			rookFile = castlingRookFile(board, color, king, -1);
+		else if (symbol >= 'a' && symbol <= 'h'
+		     &&  (board[backRank + symbol - 'a'] & ~s_black) == s_rook)
+			rookFile = symbol - 'a';
+
+		if (rookFile == -1)
+			return false;
+		board[backRank + rookFile] = s_castlingRook | color;
+	}
+
+	const QString ep(fields.value(3, "-"));
+	pos.epSquare = -1;
+	if (ep != "-")
+	{
+		if (ep.size() != 2
+		||  ep.at(0) < 'a' || ep.at(0) > 'h'
+		||  ep.at(1) < '1' || ep.at(1) > '8')
+			return false;
+		pos.epSquare = (ep.at(1).digitValue() - 1) * 8
+			     + (ep.at(0).toLatin1() - 'a');
+	}
+
+	bool ok = true;
+	pos.halfMoveClock = fields.value(4, "0").toInt(&ok);
+	if (!ok || pos.halfMoveClock < 0)
+		return false;
+
+	pos.occupancy = 0;
+	memset(pos.pieces, 0, sizeof(pos.pieces));
+	int index = 0;
+	for (int sq = 0; sq < 64; sq++)
+	{
+		if (board[sq] == -1)
+			continue;
+		pos.occupancy |= Q_UINT64_C(1) << sq;
+		pos.pieces[index / 2] |= quint8(board[sq] << ((index % 2) * 4));
+		index++;
+	}
+
+	return true;
+}
+
+QString TrainingData::unpackFen(const Position& pos)
+{
+	int board[64];
+	int index = 0;
+	for (int sq = 0; sq < 64; sq++)
+	{
+		board[sq] = -1;
+		if (!(pos.occupancy & (Q_UINT64_C(1) << sq)))
+			continue;
+		board[sq] = (pos.pieces[index / 2] >> ((index % 2) * 4)) & 0xf;
+		index++;
+	}
+
+	QString fen;
+	for (int rank = 7; rank >= 0; rank--)
+	{
+		int empty = 0;
+		for (int file = 0; file < 8; file++)
+		{
+			const int piece = board[rank * 8 + file];
+			if (piece == -1)
+			{
+				empty++;
+				continue;
+			}
+			if (empty > 0)
+				fen += QString::number(empty);
+			empty = 0;
+
+			const QChar c(s_pieceSymbols[qMin(piece & 0x7, s_castlingRook)]);
+			fen += (piece & s_black) ? c : c.toUpper();
+		}
+		if (empty > 0)
+			fen += QString::number(empty);
+		if (rank > 0)
+			fen += '/';
+	}
+
+	fen += pos.blackToMove ? " b " : " w ";
+
+	// The outermost rooks use X-FEN letters, the others their files
+	QString castling;
+	for (int color = 0; color <= s_black; color += s_black)
+	{
+		const int backRank = color ? 56 : 0;
+		const int king = kingFile(board, color);
+		for (int file = 7; file >= 0; file--)
+		{
+			if (board[backRank + file] != (s_castlingRook | color))
+				continue;
+
+			QChar c(char('a' + file));
+			if (king != -1
+			&&  file == castlingRookFile(board, color, king,
+							file > king ? 1 : -1))
+				c = (file > king) ? 'k' : 'q';
+			castling += color ? c : c.toUpper();
+		}
+	}
+	fen += castling.isEmpty() ? QString("-") : castling;
+
+	if (pos.epSquare >= 0)
+		fen += ' ' + QString(QChar(char('a' + pos.epSquare % 8)))
+		     + QString::number(pos.epSquare / 8 + 1);
+	else
+		fen += " -";
+
+	fen += ' ' + QString::number(pos.halfMoveClock) + " 1";
+	return fen;
+}
+
+quint16 TrainingData::packMove(const Chess::GenericMove& move)
+{
+	const auto square = [](const Chess::Square& sq)
+	{
+		return sq.isValid() ? quint16(sq.rank() * 8 + sq.file()) : 0;
+	};
+	return square(move.sourceSquare())
+	     | quint16(square(move.targetSquare()) << 6)
+	     | quint16((move.promotion() & 0xf) << 12);
+}
+
+Chess::GenericMove TrainingData::unpackMove(quint16 move)
+{
+	const auto square = [](int sq)
+	{
+		return Chess::Square(sq % 8, sq / 8);
+	};
+	return Chess::GenericMove(square(move & 0x3f),
+				  square((move >> 6) & 0x3f),
+				  move >> 12);
+}
+
+bool TrainingData::open(const QString& fileName, QIODevice::OpenMode mode)
+{
+	close();
+	m_file.setFileName(fileName);
+
+	QIODevice::OpenMode fileMode = QIODevice::ReadOnly;
+	if (mode & QIODevice::Append)
+		fileMode = QIODevice::ReadWrite;
+	else if (mode & QIODevice::WriteOnly)
+		fileMode = QIODevice::ReadWrite | QIODevice::Truncate;
+	if (!m_file.open(fileMode))
+		return false;
+
+	if (m_file.size() == 0 && fileMode != QIODevice::ReadOnly)
+	{
+		QByteArray header(s_magic, sizeof(s_magic));
+		header.append(s_version);
+		header.append(QByteArray(int(s_headerSize) - header.size(), 0));
+		if (m_file.write(header) != header.size())
+		{
+			m_file.close();
+			return false;
+		}
+		return true;
+	}
+
+	const QByteArray header(m_file.read(s_headerSize));
+	if (header.size() != s_headerSize
+	||  !header.startsWith(QByteArray(s_magic, sizeof(s_magic)))
+	||  header.at(sizeof(s_magic)) != s_version)
+	{
+		qWarning("%s is not a valid training data file",
+			 qPrintable(fileName));
+		m_file.close();
+		return false;
+	}
+
+	if (fileMode != QIODevice::ReadOnly && !recover())
+	{
+		m_file.close();
+		return false;
+	}
+
+	return true;
+}
+
+void TrainingData::close(bool sync)
+{
+	if (!m_file.isOpen())
+		return;
+
+	if (m_file.isWritable() && !flush(sync))
+		qWarning("Could not write training data file %s",
+			 qPrintable(m_file.fileName()));
+	m_file.close();
+	m_block.clear();
+	m_blockCount = 0;
+	m_readPos = 0;
+}
+
+bool TrainingData::isOpen() const
+{
+	return m_file.isOpen();
+}
+
+QString TrainingData::fileName() const
+{
+	return m_file.fileName();
+}
+
+bool TrainingData::read(Position& pos)
+{
+	Q_ASSERT(m_file.isOpen() && !m_file.isWritable());
+
+	if (m_readPos >= m_blockCount && !readBlock())
+		return false;
+
+	decode(reinterpret_cast<const uchar*>(m_block.constData())
+	       + m_readPos * RecordSize, pos);
+	m_readPos++;
+	return true;
+}
+
+bool TrainingData::write(const Position& pos)
+{
+	Q_ASSERT(m_file.isWritable());
+
+	uchar record[RecordSize];
+	encode(pos, record);
+	m_block.append(reinterpret_cast<const char*>(record), RecordSize);
+
+	return ++m_blockCount < BlockSize || writeBlock();
+}
+
+bool TrainingData::flush(bool sync)
+{
+	Q_ASSERT(m_file.isWritable());
+
+	if (m_blockCount > 0 && !writeBlock())
+		return false;
+	if (!m_file.flush())
+		return false;
+
+	return !sync || GameWriter::syncFile(m_file);
+}
+
+bool TrainingData::readBlock()
+{
+	m_block.clear();
+	m_blockCount = 0;
+	m_readPos = 0;
+
+	uchar header[s_blockHeaderSize];
+	const qint64 n = m_file.read(reinterpret_cast<char*>(header),
+				     s_blockHeaderSize);
+	if (n == 0)
+		return false;
+
+	const quint32 size = qFromLittleEndian<quint32>(header);
+	const quint32 count = qFromLittleEndian<quint32>(header + 4);
+	QByteArray payload;
+	if (n == s_blockHeaderSize && count <= quint32(BlockSize))
+		payload = m_file.read(size);
+	if (payload.size() != int(size) || size == 0)
+	{
+		qWarning("Truncated block in training data file %s",
+			 qPrintable(m_file.fileName()));
+		return false;
+	}
+
+	m_block = qUncompress(payload);
+	if (m_block.size() != int(count) * RecordSize)
+	{
+		qWarning("Invalid block in training data file %s",
+			 qPrintable(m_file.fileName()));
+		m_block.clear();
+		return false;
+	}
+
+	m_blockCount = int(count);
+	return m_blockCount > 0 || readBlock();
+}
+
+bool TrainingData::writeBlock()
+{
+	const QByteArray payload(qCompress(m_block));
+
+	uchar header[s_blockHeaderSize];
+	qToLittleEndian(quint32(payload.size()), header);
+	qToLittleEndian(quint32(m_blockCount), header + 4);
+
+	m_block.clear();
+	m_blockCount = 0;
+
+	return m_file.write(reinterpret_cast<const char*>(header),
+			    s_blockHeaderSize) == s_blockHeaderSize
+	    && m_file.write(payload) == payload.size();
+}
+
+bool TrainingData::recover()
+{
+	// Skip the complete blocks and drop a truncated one at the end
+	qint64 end = s_headerSize;
+	const qint64 fileSize = m_file.size();
+	while (end + s_blockHeaderSize <= fileSize)
+	{
+		uchar header[s_blockHeaderSize];
+		if (!m_file.seek(end)
+		||  m_file.read(reinterpret_cast<char*>(header),
+				s_blockHeaderSize) != s_blockHeaderSize)
+			return false;
+
+		const qint64 size = qFromLittleEndian<quint32>(header);
+		if (end + s_blockHeaderSize + size > fileSize)
+			break;
+		end += s_blockHeaderSize + size;
+	}
+
+	if (end != fileSize)
+	{
+		qWarning("Dropping an incomplete block of training data file %s",
+			 qPrintable(m_file.fileName()));
+		if (!m_file.resize(end))
+			return false;
+	}
+
+	return m_file.seek(end);
+}
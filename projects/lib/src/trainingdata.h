@@ -0,0 +1,199 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include "board/genericmove.h"
+
+
+/*!
+ * \brief A compact binary file of positions for training evaluation
+ * functions.
+ *
+ * TrainingData stores the positions of played games with the search
+ * score and depth of the engine that moved, the move that was played
+ * and the result of the game. It's meant for generating NNUE training
+ * data with self-play, without parsing PGN comments afterwards.
+ *
+ * The file starts with an 8-byte header: the magic "CCTD", a format
+ * version byte and three zero bytes. It's followed by blocks that each
+ * start with two little-endian 32-bit integers: the size of the block's
+ * payload and the number of positions in it. The payload is the zlib
+ * compressed (qCompress()) array of the positions, which are stored as
+ * 32-byte records:
+ * - Bytes 0-7: little-endian occupancy bitboard, bit 8 * rank + file
+ *   is set for every occupied square (a1 = 0, h8 = 63).
+ * - Bytes 8-23: the pieces on the occupied squares in ascending square
+ *   order, one 4-bit nibble each, low nibble first. Bits 0-2 are the
+ *   piece type (0 = pawn, 1 = knight, 2 = bishop, 3 = rook, 4 = queen,
+ *   5 = king, 6 = rook that can still castle) and bit 3 is set for
+ *   black pieces.
+ * - Byte 24: bits 0-6 are the en passant square, or 64 if there's
+ *   none. Bit 7 is set if black is to move.
+ * - Byte 25: the halfmove clock, at most 255.
+ * - Bytes 26-27: the little-endian score in centipawns from the point
+ *   of view of the side to move, clamped to +-32000.
+ * - Bytes 28-29: the little-endian move: source square, target square
+ *   << 6 and promotion piece type (Chess::WesternBoard) << 12.
+ * - Byte 30: the search depth, at most 255.
+ * - Byte 31: bits 0-1 are the Result of the game, bits 2-4 the Flags
+ *   of the position.
+ *
+ * Only 8x8 boards of the standard and Fischer random piece sets can
+ * be stored. Positions are written in blocks of at most BlockSize
+ * positions, and flush() writes the pending positions as a shorter
+ * block. If the last block of a file is incomplete, eg. because the
+ * writer was interrupted, it's dropped when the file is opened for
+ * appending.
+ *
+ * \sa GameWriter
+ */
+class LIB_EXPORT TrainingData
+{
+	public:
+		/*! The result of the game from white's point of view. */
+		enum Result
+		{
+			BlackWin,	//!< Black won the game
+			Draw,		//!< The game was drawn
+			WhiteWin,	//!< White won the game
+			NoResult	//!< The result is unknown
+		};
+
+		/*! Properties of a position that can be filtered. */
+		enum Flag
+		{
+			BookMove = 1,		//!< The move came from a book
+			InCheck = 2,		//!< The side to move is in check
+			TablebaseRange = 4	//!< The position can be adjudicated with tablebases
+		};
+
+		/*! The size of a position record in bytes. */
+		static const int RecordSize = 32;
+		/*! The maximum number of positions in a block. */
+		static const int BlockSize = 4096;
+
+		/*! \brief A packed position with its search data. */
+		struct Position
+		{
+			/*! Creates an empty position. */
+			Position();
+
+			/*! The squares that are occupied by a piece. */
+			quint64 occupancy;
+			/*! The pieces on the occupied squares in 4-bit nibbles. */
+			quint8 pieces[16];
+			/*! True if black is to move. */
+			bool blackToMove;
+			/*! The en passant square, or -1 if there's none. */
+			int epSquare;
+			/*! The number of reversible halfmoves. */
+			int halfMoveClock;
+			/*! The score from the side to move's point of view. */
+			int score;
+			/*! The search depth. */
+			int depth;
+			/*! The move that was played, packed with packMove(). */
+			quint16 move;
+			/*! The result of the game. */
+			Result result;
+			/*! A combination of Flags. */
+			int flags;
+		};
+
+		/*! Creates a new, closed TrainingData object. */
+		TrainingData();
+		/*! Writes the pending positions and closes the file. */
+		~TrainingData();
+
+		/*!
+		 * Packs the position of \a fen to \a pos.
+		 *
+		 * Returns false if \a fen isn't a valid FEN string of an 8x8
+		 * board with standard pieces; otherwise returns true.
+		 */
+		static bool packFen(const QString& fen, Position& pos);
+		/*! Returns the position of \a pos as a FEN string. */
+		static QString unpackFen(const Position& pos);
+		/*! Packs \a move of an 8x8 board into 16 bits. */
+		static quint16 packMove(const Chess::GenericMove& move);
+		/*! Unpacks a move packed with packMove(). */
+		static Chess::GenericMove unpackMove(quint16 move);
+
+		/*!
+		 * Opens the file \a fileName.
+		 *
+		 * \a mode can be one of:
+		 * - QIODevice::ReadOnly: open an existing file for reading
+		 * - QIODevice::WriteOnly: create a new, empty file
+		 * - QIODevice::Append: append to an existing file, or
+		 *   create a new one if \a fileName doesn't exist
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName,
+			  QIODevice::OpenMode mode = QIODevice::ReadOnly);
+		/*!
+		 * Writes the pending positions and closes the file.
+		 *
+		 * If \a sync is true the file is flushed to stable
+		 * storage before it's closed.
+		 */
+		void close(bool sync = false);
+		/*! Returns true if the file is open. */
+		bool isOpen() const;
+		/*! Returns the name of the file. */
+		QString fileName() const;
+
+		/*!
+		 * Reads the next position of the file to \a pos.
+		 * Returns false at the end of the file or on error.
+		 */
+		bool read(Position& pos);
+		/*!
+		 * Appends \a pos to the file.
+		 *
+		 * The position is written when its block is full or
+		 * when the file is flushed or closed.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool write(const Position& pos);
+		/*!
+		 * Writes the pending positions, and flushes them to stable
+		 * storage if \a sync is true.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool flush(bool sync = false);
+
+	private:
+		bool readBlock();
+		bool writeBlock();
+		bool recover();
+
+		QFile m_file;
+		QByteArray m_block;
+		int m_blockCount;
+		int m_readPos;
+};
+
+Q_DECLARE_TYPEINFO(TrainingData::Position, Q_MOVABLE_TYPE);
+
+#endif // TRAININGDATA_H
@@ -29,6 +29,8 @@
 #include "enginecombooption.h"
 #include "enginespinoption.h"
 #include "enginetextoption.h"
+#include "engineoptionfactory.h"
+#include "enginehandshakecache.h"
 
 namespace {
 
@@ -90,7 +92,12 @@ UciEngine::UciEngine(QObject* parent)
 	  m_movesPondered(0),
 	  m_ponderHits(0),
 	  m_ignoreThinking(false),
-	  m_rePing(false)
+	  m_rePing(false),
+	  m_cachedHandshake(false),
+	  m_compactIndex(0),
+	  m_positionPending(false),
+	  m_pvKey(0),
+	  m_searchLine(0)
 {
 	addVariant("standard");
 	setName("UciEngine");
@@ -100,26 +107,118 @@ void UciEngine::startProtocol()
 {
 	// Tell the engine to turn on UCI mode
 	write("uci");
+
+	// With a cached handshake there's no need to wait for "uciok".
+	// The engine reads its input in order, so it has turned on UCI
+	// mode before it gets the options and "isready".
+	if (restoreHandshake())
+	{
+		onProtocolStart();
+		ping();
+	}
+}
+
+bool UciEngine::restoreHandshake()
+{
+	const QVariantMap entry(EngineHandshakeCache::entry(handshakeCacheKey()));
+	if (entry.isEmpty())
+		return false;
+
+	const QStringList variants(entry["variants"].toStringList());
+	if (variants.isEmpty())
+		return false;
+
+	QList<EngineOption*> options;
+	const QVariantList optionList(entry["options"].toList());
+	for (const QVariant& optionVariant : optionList)
+	{
+		EngineOption* option = EngineOptionFactory::create(
+			optionVariant.toMap());
+		if (option == nullptr)
+		{
+			qDeleteAll(options);
+			return false;
+		}
+		options.append(option);
+	}
+
+	m_idName = entry["name"].toString();
+	if (name() == "UciEngine" && !m_idName.isEmpty())
+		setName(m_idName);
+	clearVariants();
+	for (const QString& variant : variants)
+		addVariant(variant);
+	for (EngineOption* option : options)
+		addOption(option);
+	m_canPonder = entry["ponder"].toBool();
+	m_sendOpponentsName = entry["opponent"].toBool();
+	m_comboVariants = entry["comboVariants"].toStringList();
+	m_cachedHandshake = true;
+
+	return true;
 }
 
-QString UciEngine::positionString()
+void UciEngine::saveHandshake() const
+{
+	const QString key(handshakeCacheKey());
+	if (key.isEmpty())
+		return;
+
+	QVariantList optionList;
+	const auto options = this->options();
+	for (const EngineOption* option : options)
+		optionList.append(option->toVariant());
+
+	QVariantMap entry;
+	entry.insert("name", m_idName);
+	entry.insert("variants", variants());
+	entry.insert("options", optionList);
+	entry.insert("ponder", m_canPonder);
+	entry.insert("opponent", m_sendOpponentsName);
+	if (!m_comboVariants.isEmpty())
+		entry.insert("comboVariants", m_comboVariants);
+
+	EngineHandshakeCache::setEntry(key, entry);
+}
+
+QString UciEngine::positionString() const
 {
 	QString str("position");
+	QStringRef moves(&m_moveStrings);
 
-	if (board()->isRandomVariant() || m_startFen != board()->defaultFenString())
+	if (!m_compactFen.isEmpty())
+	{
+		str += QString(" fen ") + m_compactFen;
+		moves = m_moveStrings.midRef(m_compactIndex);
+	}
+	else if (board()->isRandomVariant() || m_startFen != board()->defaultFenString())
 		str += QString(" fen ") + m_startFen;
 	else
 		str += " startpos";
 
-	if (!m_moveStrings.isEmpty())
-		str += QString(" moves") + m_moveStrings;
+	if (!moves.isEmpty())
+	{
+		str.reserve(str.size() + 6 + moves.size());
+		str += QLatin1String(" moves");
+		str += moves;
+	}
 
 	return str;
 }
 
-void UciEngine::sendPosition()
+void UciEngine::updateCompactPosition()
 {
-	write(positionString());
+	// The board must be in the position that m_moveStrings leads to
+	if (!compactPositions()
+	||  m_moveStrings.isEmpty()
+	||  board()->reversibleMoveCount() != 0)
+		return;
+
+	if (board()->isRandomVariant())
+		m_compactFen = board()->fenString(Chess::Board::ShredderFen);
+	else
+		m_compactFen = board()->fenString(Chess::Board::XFen);
+	m_compactIndex = m_moveStrings.size();
 }
 
 void UciEngine::startGame()
@@ -136,6 +235,8 @@ void UciEngine::startGame()
 	m_ponderHits = 0;
 	m_bmBuffer.clear();
 	m_moveStrings.clear();
+	m_compactFen.clear();
+	m_compactIndex = 0;
 	m_useDirectPv = directPvList.contains(board()->variant());
 
 	if (board()->isRandomVariant())
@@ -157,7 +258,8 @@ void UciEngine::startGame()
 		sendOption("UCI_Opponent", value);
 	}
 
-	sendPosition();
+	// The position is sent with the first search command
+	m_positionPending = true;
 }
 
 void UciEngine::endGame(const Chess::Result& result)
@@ -208,9 +310,12 @@ void UciEngine::makeMove(const Chess::Move& move)
 		m_ponderState = NotPondering;
 		m_moveStrings += " " + board()->moveString(move, Chess::Board::LongAlgebraic);
 		if (m_ignoreThinking)
+		{
 			m_bmBuffer << positionString() << "isready";
+			m_positionPending = false;
+		}
 		else
-			sendPosition();
+			m_positionPending = true;
 	}
 }
 
@@ -247,9 +352,21 @@ void UciEngine::startThinking()
 	}
 	else
 		qFatal("Player %s doesn't have a side", qPrintable(name()));
+
+	// Send the position and the search command with one write
+	const bool ponder = pondering() && !m_ponderMove.isNull();
+	QStringList commands;
+	if (m_positionPending)
+	{
+		// The ponder move isn't on the board yet
+		if (!ponder)
+			updateCompactPosition();
+		commands << positionString();
+		m_positionPending = false;
+	}
 	
 	QString command = "go";
-	if (pondering() && !m_ponderMove.isNull())
+	if (ponder)
 	{
 		command += " ponder";
 		m_ponderState = Pondering;
@@ -279,7 +396,9 @@ void UciEngine::startThinking()
 	if (myTc->nodeLimit() > 0)
 		command += QString(" nodes %1").arg(myTc->nodeLimit());
 
-	write(command);
+	commands << command;
+	write(commands);
+	m_searchLine = inputLineCount();
 }
 
 void UciEngine::startPondering()
@@ -287,8 +406,9 @@ void UciEngine::startPondering()
 	if (!pondering() || m_ponderMove.isNull())
 		return;
 
+	updateCompactPosition();
 	m_moveStrings += " " + board()->moveString(m_ponderMove, Chess::Board::LongAlgebraic);
-	sendPosition();
+	m_positionPending = true;
 	ping();
 	startThinking();
 }
@@ -300,6 +420,16 @@ void UciEngine::clearPonderState()
 	m_ponderMoveSan.clear();
 }
 
+int UciEngine::ponderedMoves() const
+{
+	return m_movesPondered;
+}
+
+int UciEngine::ponderHits() const
+{
+	return m_ponderHits;
+}
+
 bool UciEngine::isPondering() const
 {
 	return (m_ponderState != NotPondering);
@@ -388,21 +518,25 @@ void UciEngine::parseInfo(const QVarLengthArray<QStringRef>& tokens,
 	switch (type)
 	{
 	case InfoDepth:
-		eval->setDepth(tokens[0].toString().toInt());
+		eval->setDepth(tokens[0].toInt());
 		break;
 	case InfoSelDepth:
-		eval->setSelectiveDepth(tokens[0].toString().toInt());
+		eval->setSelectiveDepth(tokens[0].toInt());
 		break;
 	case InfoTime:
-		eval->setTime(tokens[0].toString().toInt());
+		eval->setTime(tokens[0].toInt());
 		break;
 	case InfoNodes:
-		eval->setNodeCount(tokens[0].toString().toULongLong());
+		eval->setNodeCount(tokens[0].toULongLong());
 		break;
 	case InfoMultiPv:
-		eval->setPvNumber(tokens[0].toString().toInt());
+		eval->setPvNumber(tokens[0].toInt());
 		break;
 	case InfoPv:
+		// Only the primary PV is recorded in the game, so the SAN
+		// of the other lines is wasted without a listener
+		if (eval->pvNumber() > 1 && !hasThinkingListener())
+			break;
 		eval->setPv(m_useDirectPv ?  directPv(tokens) : sanPv(tokens));
 		break;
 	case InfoScore:
@@ -410,18 +544,18 @@ void UciEngine::parseInfo(const QVarLengthArray<QStringRef>& tokens,
 			int score = 0;
 			for (int i = 1; i < tokens.size(); i++)
 			{
-				if (tokens[i - 1] == "cp")
-					score = tokens[i].toString().toInt();
-				else if (tokens[i - 1] == "mate")
+				if (tokens[i - 1] == QLatin1String("cp"))
+					score = tokens[i].toInt();
+				else if (tokens[i - 1] == QLatin1String("mate"))
 				{
-					score = tokens[i].toString().toInt();
+					score = tokens[i].toInt();
 					if (score > 0)
 						score = 99000 + 1 - score * 2;
 					else if (score < 0)
 						score = -99000 - score * 2;
 				}
-				else if (tokens[i - 1] == "lowerbound"
-				     ||  tokens[i - 1] == "upperbound")
+				else if (tokens[i - 1] == QLatin1String("lowerbound")
+				     ||  tokens[i - 1] == QLatin1String("upperbound"))
 					return;
 				i++;
 			}
@@ -431,10 +565,10 @@ void UciEngine::parseInfo(const QVarLengthArray<QStringRef>& tokens,
 		}
 		break;
 	case InfoTbHits:
-		eval->setTbHits(tokens[0].toString().toULongLong());
+		eval->setTbHits(tokens[0].toULongLong());
 		break;
 	case InfoHashFull:
-		eval->setHashUsage(tokens[0].toString().toInt());
+		eval->setHashUsage(tokens[0].toInt());
 		break;
 	default:
 		break;
@@ -470,7 +604,7 @@ void UciEngine::parseInfo(const QStringRef& line)
 
 	// The "string" info is not supported and it can't be parsed
 	// like other info lines.
-	if (token == "string")
+	if (token == QLatin1String("string"))
 		return;
 
 	while (!token.isNull())
@@ -494,10 +628,10 @@ void UciEngine::parseInfo(const QStringRef& line)
 			m_currentEval.clear();
 		m_currentEval.merge(eval);
 
-		emit thinking(m_currentEval);
+		reportThinking(m_currentEval);
 	}
 	else
-		emit thinking(eval);
+		reportThinking(eval);
 }
 
 EngineOption* UciEngine::parseOption(const QStringRef& line)
@@ -653,6 +787,11 @@ void UciEngine::parseLine(const QString& line)
 			board()->undoMove();
 		}
 
+		// The engine has handled the search command, and nothing
+		// written before it needs an "isready" anymore
+		acknowledgeInput(m_searchLine);
+
+		flushThinking();
 		emitMove(move);
 	}
 	else if (command == "readyok")
@@ -670,6 +809,7 @@ void UciEngine::parseLine(const QString& line)
 	{
 		if (state() == Starting)
 		{
+			saveHandshake();
 			onProtocolStart();
 			ping();
 		}
@@ -677,8 +817,12 @@ void UciEngine::parseLine(const QString& line)
 	else if (command == "id")
 	{
 		QStringRef tag(nextToken(command));
-		if (tag == "name" && name() == "UciEngine")
-			setName(nextToken(tag, true).toString());
+		if (tag == "name")
+		{
+			m_idName = nextToken(tag, true).toString();
+			if (name() == "UciEngine")
+				setName(m_idName);
+		}
 	}
 	else if (command == "registration")
 	{
@@ -690,6 +834,10 @@ void UciEngine::parseLine(const QString& line)
 	}
 	else if (command == "option")
 	{
+		// The options are already known from the cache
+		if (m_cachedHandshake)
+			return;
+
 		EngineOption* option = parseOption(command);
 		QString variant;
 
@@ -808,7 +956,6 @@ QString UciEngine::directPv(const QVarLengthArray<QStringRef>& tokens)
 QString UciEngine::sanPv(const QVarLengthArray<QStringRef>& tokens)
 {
 	Chess::Board* board = this->board();
-	QString pv;
 	int movesMade = 0;
 
 	if (pondering() && !m_ponderMove.isNull())
@@ -817,19 +964,39 @@ QString UciEngine::sanPv(const QVarLengthArray<QStringRef>& tokens)
 		movesMade++;
 	}
 
-	for (auto token : tokens)
+	// Find out how many moves this PV shares with the previous one
+	int shared = 0;
+	if (board->key() == m_pvKey)
 	{
-		auto move = board->moveFromString(token.toString());
+		int count = qMin(tokens.size(), m_pvTokens.size());
+		while (shared < count && tokens[shared] == m_pvTokens.at(shared))
+			shared++;
+	}
+	m_pvKey = board->key();
+	m_pvTokens.erase(m_pvTokens.begin() + shared, m_pvTokens.end());
+	m_pvMoves.resize(shared);
+	m_pvSan.erase(m_pvSan.begin() + shared, m_pvSan.end());
+
+	for (int i = 0; i < shared; i++)
+	{
+		board->makeMove(m_pvMoves.at(i));
+		movesMade++;
+	}
+
+	for (int i = shared; i < tokens.size(); i++)
+	{
+		const QString token(tokens[i].toString());
+		auto move = board->moveFromString(token);
 		if (move.isNull())
 		{
 			qWarning("Illegal PV move %s from %s",
-				 qPrintable(token.toString()),
+				 qPrintable(token),
 				 qPrintable(name()));
 			break;
 		}
-		if (!pv.isEmpty())
-			pv += " ";
-		pv += board->moveString(move, Chess::Board::StandardAlgebraic);
+		m_pvTokens.append(token);
+		m_pvMoves.append(move);
+		m_pvSan.append(board->moveString(move, Chess::Board::StandardAlgebraic));
 		board->makeMove(move);
 		movesMade++;
 	}
@@ -837,7 +1004,7 @@ QString UciEngine::sanPv(const QVarLengthArray<QStringRef>& tokens)
 	for (int i = 0; i < movesMade; i++)
 		board->undoMove();
 
-	return pv;
+	return m_pvSan.join(' ');
 }
 
 void UciEngine::sendOption(const QString& name, const QVariant& value)
@@ -42,6 +42,8 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		virtual QString protocol() const;
 		virtual void startPondering();
 		virtual void clearPonderState();
+		virtual int ponderedMoves() const;
+		virtual int ponderHits() const;
 
 	protected:
 		// Inherited from ChessEngine
@@ -74,16 +76,24 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		void parseInfo(const QStringRef& line);
 		EngineOption* parseOption(const QStringRef& line);
 		void addVariantsFromOption(const EngineOption* option);
+		bool restoreHandshake();
+		void saveHandshake() const;
 		void setVariant(const QString& variant);
-		QString positionString();
-		void sendPosition();
+		QString positionString() const;
+		void updateCompactPosition();
 		void setPonderMove(const QString& moveString);
 		QString directPv(const QVarLengthArray<QStringRef>& tokens);
 		QString sanPv(const QVarLengthArray<QStringRef>& tokens);
 		
+		QString m_idName;
 		QString m_variantOption;
 		QString m_startFen;
 		QString m_moveStrings;
+		// Position after the last irreversible move and the index
+		// of the moves that follow it in m_moveStrings
+		QString m_compactFen;
+		int m_compactIndex;
+		bool m_positionPending;
 		bool m_useDirectPv;
 		// Write buffer for messages that will be flushed to the engine
 		// after it sends a "bestmove"
@@ -97,8 +107,17 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		int m_ponderHits;
 		bool m_ignoreThinking;
 		bool m_rePing;
+		bool m_cachedHandshake;
 		MoveEvaluation m_currentEval;
 		QStringList m_comboVariants;
+		// The last PV converted by sanPv(). Engines send many PVs
+		// that start with the same moves, and those moves don't
+		// need to be converted again.
+		quint64 m_pvKey;
+		quint64 m_searchLine;
+		QStringList m_pvTokens;
+		QVector<Chess::Move> m_pvMoves;
+		QStringList m_pvSan;
 };
 
 #endif // UCIENGINE_H
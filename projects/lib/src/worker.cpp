@@ -16,9 +16,30 @@
 */
 
 #include "worker.h"
+#include <QThread>
+#include <QThreadPool>
+
+CancelToken::CancelToken()
+	: m_cancelled(new QAtomicInt(0))
+{
+}
+
+void CancelToken::cancel()
+{
+	m_cancelled->storeRelease(1);
+}
+
+bool CancelToken::isCancelled() const
+{
+	return m_cancelled->loadAcquire() != 0;
+}
+
 
 Worker::Worker(const QString& title)
-	: QObject(nullptr), QRunnable(), m_cancel(false), m_title(title)
+	: QObject(nullptr),
+	  QRunnable(),
+	  m_priority(NormalPriority),
+	  m_title(title)
 {
 }
 
@@ -28,12 +49,12 @@ Worker::~Worker()
 
 void Worker::cancel()
 {
-	m_cancel = true;
+	m_cancelToken.cancel();
 }
 
 bool Worker::cancelRequested() const
 {
-	return m_cancel;
+	return m_cancelToken.isCancelled() || m_groupToken.isCancelled();
 }
 
 QTime Worker::startTime() const
@@ -46,13 +67,53 @@ QString Worker::title() const
 	return m_title;
 }
 
+Worker::Priority Worker::priority() const
+{
+	return m_priority;
+}
+
+void Worker::setPriority(Priority priority)
+{
+	m_priority = priority;
+}
+
+CancelToken Worker::cancelToken() const
+{
+	return m_cancelToken;
+}
+
+void Worker::setGroupToken(const CancelToken& token)
+{
+	m_groupToken = token;
+}
+
+void Worker::start()
+{
+	threadPool()->start(this, m_priority);
+}
+
+QThreadPool* Worker::threadPool()
+{
+	// Workers are long and mostly busy, so they get a pool of their
+	// own. QtConcurrent's short tasks in the global pool, like the
+	// filtering of game lists, never queue behind them.
+	static QThreadPool* pool = []()
+	{
+		auto pool = new QThreadPool;
+		pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+		return pool;
+	}();
+
+	return pool;
+}
+
 void Worker::run()
 {
 	m_startTime = QTime::currentTime();
 	emit started();
 
 	work();
-	if (m_cancel)
+	if (cancelRequested())
 		emit cancelled();
 
 	emit finished();
@@ -22,15 +22,52 @@
 #include <QRunnable>
 #include <QTime>
 #include <QString>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+class QThreadPool;
+
+/*!
+ * \brief A cancellation flag shared by its copies.
+ *
+ * Cancelling any copy of a token cancels all of them, so a group of
+ * workers can be given copies of one token and cancelled at once.
+ */
+class LIB_EXPORT CancelToken
+{
+	public:
+		/*! Creates a new token that isn't cancelled. */
+		CancelToken();
+
+		/*! Cancels the token and all its copies. */
+		void cancel();
+		/*! Returns true if the token has been cancelled. */
+		bool isCancelled() const;
+
+	private:
+		QSharedPointer<QAtomicInt> m_cancelled;
+};
 
 /*!
  * An abstraction of a long-running task.
+ *
+ * Workers are run by a shared thread pool with a bounded number of
+ * threads, so starting many of them doesn't start as many threads.
+ * Queued workers are started in order of priority.
  */
 class LIB_EXPORT Worker : public QObject, public QRunnable
 {
 	Q_OBJECT
 
 	public:
+		/*! The priority of a worker in the thread pool's queue. */
+		enum Priority
+		{
+			BackgroundPriority = -1,	//!< Work the user isn't waiting for
+			NormalPriority = 0,		//!< The default priority
+			InteractivePriority = 1		//!< Work the user is waiting for
+		};
+
 		/*! Creates a new Worker object with the given \a title.
 		 *
 		 * The title describes the purpose of this Worker so that it can be
@@ -44,6 +81,27 @@ class LIB_EXPORT Worker : public QObject, public QRunnable
 		/*! Returns the title of the worker. */
 		QString title() const;
 
+		/*! Returns the priority of the worker. */
+		Priority priority() const;
+		/*! Sets the priority to \a priority. */
+		void setPriority(Priority priority);
+		/*!
+		 * Returns the worker's own cancellation token, which is
+		 * cancelled by cancel().
+		 */
+		CancelToken cancelToken() const;
+		/*!
+		 * Makes the worker also cancelled when \a token is, so
+		 * that it can be cancelled along with other workers that
+		 * have copies of \a token.
+		 */
+		void setGroupToken(const CancelToken& token);
+
+		/*! Queues the worker in threadPool() with its priority. */
+		void start();
+		/*! Returns the thread pool that runs the workers. */
+		static QThreadPool* threadPool();
+
 		// Inherited from QRunnable
 		void run() override;
 
@@ -111,11 +169,16 @@ class LIB_EXPORT Worker : public QObject, public QRunnable
 		 * signals and return from the function.
 		 */
 		virtual void work() = 0;
-		/*! Returns true if the user requested cancellation of the task with the cancel() slot. */
+		/*!
+		 * Returns true if the user requested cancellation of the task
+		 * with the cancel() slot, or if the group token was cancelled.
+		 */
 		bool cancelRequested() const;
 
 	private:
-		bool m_cancel;
+		CancelToken m_cancelToken;
+		CancelToken m_groupToken;
+		Priority m_priority;
 		QString m_title;
 		QTime m_startTime;
 };
@@ -44,6 +44,12 @@ QString msToXboardTime(int ms)
 	return number;
 }
 
+// Returns true if \a c can be part of a feature name
+bool isWordChar(QChar c)
+{
+	return c.isLetterOrNumber() || c == '_';
+}
+
 QString variantFromXboard(const QString& str)
 {
 	if (str == "normal")
@@ -370,19 +376,19 @@ void XboardEngine::sendQuit()
 	write("quit");
 }
 
-EngineOption* XboardEngine::parseOption(const QString& line)
+EngineOption* XboardEngine::parseOption(const QStringRef& line)
 {
 	int start = line.indexOf(" -") + 1;
 	if (start < 2)
 		return nullptr;
 
-	QString name(line.left(start - 1));
+	QString name(line.left(start - 1).toString());
 
 	start++;
 	int end = line.indexOf(' ', start);
 	if (end == -1)
-		end = line.length();
-	QString type(line.mid(start, end - start));
+		end = line.size();
+	const QStringRef type(line.mid(start, end - start));
 
 	if (type == "button" || type == "save")
 		return new EngineButtonOption(name);
@@ -393,7 +399,7 @@ EngineOption* XboardEngine::parseOption(const QString& line)
 	}
 	if (type == "string" || type == "file" || type == "path")
 	{
-		QString value(line.mid(end + 1));
+		QString value(line.mid(end + 1).toString());
 		EngineTextOption::EditorType editorType;
 
 		if (type == "file")
@@ -407,7 +413,8 @@ EngineOption* XboardEngine::parseOption(const QString& line)
 	}
 	if (type == "spin" || type == "slider")
 	{
-		QStringList params(line.mid(end + 1).split(' ', QString::SkipEmptyParts));
+		const QVector<QStringRef> params(
+			line.mid(end + 1).split(' ', QString::SkipEmptyParts));
 		if (params.size() != 3)
 			return nullptr;
 
@@ -428,19 +435,22 @@ EngineOption* XboardEngine::parseOption(const QString& line)
 	}
 	if (type == "combo")
 	{
-		QStringList choices = line.mid(end + 1).split(" /// ", QString::SkipEmptyParts);
-		if (choices.isEmpty())
+		const QVector<QStringRef> refs(
+			line.mid(end + 1).split(" /// ", QString::SkipEmptyParts));
+		if (refs.isEmpty())
 			return nullptr;
 
 		QString value;
-		QStringList::iterator it;
-		for (it = choices.begin(); it != choices.end(); ++it)
+		QStringList choices;
+		for (const QStringRef& ref : refs)
 		{
-			if (it->startsWith('*'))
+			if (ref.startsWith('*'))
 			{
-				it->remove(0, 1);
-				value = *it;
+				choices << ref.mid(1).toString();
+				value = choices.last();
 			}
+			else
+				choices << ref.toString();
 		}
 		if (value.isEmpty())
 			value = choices.first();
@@ -451,7 +461,59 @@ EngineOption* XboardEngine::parseOption(const QString& line)
 	return nullptr;
 }
 
-void XboardEngine::setFeature(const QString& name, const QString& val)
+void XboardEngine::parseFeatures(const QStringRef& args)
+{
+	// The features are name=value pairs where the value is either a
+	// number or a quoted string, eg. 'ping=1 myname="Engine 1.0"'.
+	// Anything else on the line is skipped.
+	const QString* str = args.string();
+	const int end = args.position() + args.size();
+	int i = args.position();
+	while (i < end)
+	{
+		if (!isWordChar(str->at(i)))
+		{
+			i++;
+			continue;
+		}
+
+		const int nameStart = i;
+		while (i < end && isWordChar(str->at(i)))
+			i++;
+		const QStringRef name(str, nameStart, i - nameStart);
+
+		int j = i;
+		while (j < end && str->at(j).isSpace())
+			j++;
+		if (j >= end || str->at(j) != '=')
+			continue;
+		do
+			j++;
+		while (j < end && str->at(j).isSpace());
+		if (j >= end)
+			break;
+
+		if (str->at(j) == '"')
+		{
+			const int valStart = j + 1;
+			const int valEnd = str->indexOf('"', valStart);
+			if (valEnd == -1 || valEnd >= end)
+				continue;
+			setFeature(name, QStringRef(str, valStart, valEnd - valStart));
+			i = valEnd + 1;
+		}
+		else if (str->at(j).isDigit())
+		{
+			const int valStart = j;
+			while (j < end && str->at(j).isDigit())
+				j++;
+			setFeature(name, QStringRef(str, valStart, j - valStart));
+			i = j;
+		}
+	}
+}
+
+void XboardEngine::setFeature(const QStringRef& name, const QStringRef& val)
 {
 	if (name == "ping")
 		m_ftPing = (val == "1");
@@ -475,15 +537,15 @@ void XboardEngine::setFeature(const QString& name, const QString& val)
 	else if (name == "myname")
 	{
 		if (this->name() == "XboardEngine")
-			setName(val);
+			setName(val.toString());
 	}
 	else if (name == "variants")
 	{
 		clearVariants();
 		const auto variants = val.split(',');
-		for (const QString& str : variants)
+		for (const QStringRef& str : variants)
 		{
-			QString variant = variantFromXboard(str.trimmed());
+			QString variant = variantFromXboard(str.toString().trimmed());
 			if (!variant.isEmpty())
 				addVariant(variant);
 		}
@@ -503,9 +565,9 @@ void XboardEngine::setFeature(const QString& name, const QString& val)
 	else if (name == "egt")
 	{
 		const auto list = val.split(',');
-		for (const QString& str : list)
+		for (const QStringRef& str : list)
 		{
-			QString egtType = QString("egtpath %1").arg(str.trimmed());
+			QString egtType = QString("egtpath %1").arg(str.toString().trimmed());
 			addOption(new EngineTextOption(egtType, QString(), QString()));
 		}
 	}
@@ -529,11 +591,11 @@ void XboardEngine::setFeature(const QString& name, const QString& val)
 	}
 	else
 	{
-		write("rejected " + name, Unbuffered);
+		write("rejected " + name.toString(), Unbuffered);
 		return;
 	}
 	
-	write("accepted " + name, Unbuffered);
+	write("accepted " + name.toString(), Unbuffered);
 }
 
 // shift assumed mate scores further out
@@ -608,22 +670,22 @@ void XboardEngine::parseLine(const QString& line)
 		return;
 	}
 	else if (command.at(0).isDigit()
-	     && !command.contains("."))	// principal variation
+	     && !command.contains('.'))	// principal variation
 	{
 		bool ok = false;
 		int val = 0;
 		QStringRef ref(command);
-		
-		// Search depth
-		QString depth(ref.toString());
-		if (!(depth.cend() - 1)->isDigit())
-			depth.chop(1);
-		m_eval.setDepth(depth.toInt());
+
+		// Search depth, possibly followed by a mark like '&'
+		if (ref.at(ref.size() - 1).isDigit())
+			m_eval.setDepth(ref.toInt());
+		else
+			m_eval.setDepth(ref.left(ref.size() - 1).toInt());
 
 		// Evaluation
 		if ((ref = nextToken(ref)).isNull())
 			return;
-		val = ref.toString().toInt(&ok);
+		val = ref.toInt(&ok);
 		if (ok)
 		{
 			if (whiteEvalPov() && side() == Chess::Side::Black)
@@ -634,14 +696,14 @@ void XboardEngine::parseLine(const QString& line)
 		// Search time
 		if ((ref = nextToken(ref)).isNull())
 			return;
-		val = ref.toString().toInt(&ok);
+		val = ref.toInt(&ok);
 		if (ok)
 			m_eval.setTime(val * 10);
 
 		// Node count
 		if ((ref = nextToken(ref)).isNull())
 			return;
-		val = ref.toString().toULongLong(&ok);
+		val = ref.toULongLong(&ok);
 		if (ok)
 			m_eval.setNodeCount(val);
 
@@ -650,7 +712,7 @@ void XboardEngine::parseLine(const QString& line)
 			return;
 		m_eval.setPv(ref.toString());
 
-		emit thinking(m_eval);
+		reportThinking(m_eval);
 
 		return;
 	}
@@ -658,7 +720,7 @@ void XboardEngine::parseLine(const QString& line)
 	// move format of old CECP engines: 1. ... e2e4
 	bool testDigitAndDot = command.at(0).isDigit() && command.contains(".");
 
-	const QString args(nextToken(command, true).toString());
+	const QStringRef args(nextToken(command, true));
 	if (command == "move" || (testDigitAndDot && args.startsWith("...")))
 	{
 		if (state() != Thinking)
@@ -672,7 +734,7 @@ void XboardEngine::parseLine(const QString& line)
 
 		// remove "..." of old format if necessary
 		int mark = (args.indexOf("..."));
-		const QString movestr = mark < 0 ? args : args.mid(4);
+		const QString movestr = (mark < 0 ? args : args.mid(4)).toString();
 
 		Chess::Move move = board()->moveFromString(movestr);
 		if (move.isNull())
@@ -698,6 +760,7 @@ void XboardEngine::parseLine(const QString& line)
 			}
 		}
 
+		flushThinking();
 		emitMove(move);
 	}
 	else if (command == "pong")
@@ -706,32 +769,12 @@ void XboardEngine::parseLine(const QString& line)
 			pong();
 	}
 	else if (command == "feature")
-	{
-		QRegExp rx("\\w+\\s*=\\s*(\"[^\"]*\"|\\d+)");
-		
-		int pos = 0;
-		
-		while ((pos = rx.indexIn(args, pos)) != -1)
-		{
-			QString cap = rx.cap();
-			int index = cap.indexOf('=');
-			if (index != -1)
-			{
-				QString feature = cap.left(index).trimmed();
-				QString val = cap.mid(index + 1).trimmed();
-				val.remove('\"');
-
-				setFeature(feature, val);
-			}
-
-			pos += rx.matchedLength();
-		}
-	}
+		parseFeatures(args);
 	else if (command == "Error")
 	{
 		// If the engine complains about an unknown result command,
 		// we can assume that it's safe to finish the game.
-		QString str = args.section(':', 1).trimmed();
+		QString str = args.toString().section(':', 1).trimmed();
 		if (str.startsWith("result"))
 			finishGame();
 	}
@@ -60,8 +60,9 @@ class LIB_EXPORT XboardEngine : public ChessEngine
 		void initialize();
 
 	private:
-		EngineOption* parseOption(const QString& line);
-		void setFeature(const QString& name, const QString& val);
+		EngineOption* parseOption(const QStringRef& line);
+		void parseFeatures(const QStringRef& args);
+		void setFeature(const QStringRef& name, const QStringRef& val);
 		void setForceMode(bool enable);
 		void sendTimeLeft();
 		void finishGame();
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_bootstrapratings
+SOURCES += tst_bootstrapratings.cpp
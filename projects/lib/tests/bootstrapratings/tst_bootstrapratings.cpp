@@ -0,0 +1,133 @@
+#include <QtTest/QtTest>
+#include <cmath>
+#include <bootstrapratings.h>
+
+
+class tst_BootstrapRatings: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void noGames();
+		void twoPlayers();
+		void pairedGames();
+		void reproducible();
+		void roundRobin();
+};
+
+
+static void addMatch(BootstrapRatings& bootstrap, int games)
+{
+	// Player 0 scores 60%: two wins, a loss and two draws in
+	// every five games, each opening played twice
+	static const int points[] = { 2, 2, 0, 1, 1 };
+	for (int i = 0; i < games; i++)
+	{
+		const int result = points[i % 5];
+		if (i % 2 == 0)
+			bootstrap.addGame(i / 2, 0, 1, result);
+		else
+			bootstrap.addGame(i / 2, 1, 0, 2 - result);
+	}
+}
+
+void tst_BootstrapRatings::noGames()
+{
+	BootstrapRatings bootstrap(2);
+	QCOMPARE(bootstrap.playerCount(), 2);
+	QCOMPARE(bootstrap.gameCount(), 0);
+	QVERIFY(!bootstrap.run(100, 1));
+	QCOMPARE(bootstrap.sampleCount(), 0);
+	QVERIFY(std::isnan(bootstrap.percentile(0, 50.0)));
+}
+
+void tst_BootstrapRatings::twoPlayers()
+{
+	BootstrapRatings bootstrap(2);
+	addMatch(bootstrap, 1000);
+	QCOMPARE(bootstrap.gameCount(), 1000);
+	QVERIFY(bootstrap.run(500, 1));
+	QCOMPARE(bootstrap.sampleCount(), 500);
+
+	// A 60% score is about 70 Elo
+	const double low = bootstrap.percentile(0, 2.5);
+	const double median = bootstrap.percentile(0, 50.0);
+	const double high = bootstrap.percentile(0, 97.5);
+	QVERIFY(low < median);
+	QVERIFY(median < high);
+	QVERIFY(std::fabs(median - 70.4) < 10.0);
+	QVERIFY(high - low > 5.0);
+	QVERIFY(high - low < 80.0);
+
+	// The opponent's interval is the negation
+	QVERIFY(std::fabs(bootstrap.percentile(1, 50.0) + median) < 1.0e-9);
+	QVERIFY(std::fabs(bootstrap.percentile(1, 97.5) + low) < 1.0e-9);
+}
+
+void tst_BootstrapRatings::pairedGames()
+{
+	// The two games of each opening always have the same winner,
+	// so pairing them widens the interval
+	BootstrapRatings single(2);
+	BootstrapRatings paired(2);
+	paired.reset(2, 2);
+	for (int i = 0; i < 1000; i++)
+	{
+		const int points = ((i / 2) % 3 == 0) ? 0 : 2;
+		single.addGame(i, 0, 1, points);
+		paired.addGame(i / 2, 0, 1, points);
+	}
+	QVERIFY(single.run(1000, 7));
+	QVERIFY(paired.run(1000, 7));
+
+	const double singleWidth = single.percentile(0, 97.5)
+				 - single.percentile(0, 2.5);
+	const double pairedWidth = paired.percentile(0, 97.5)
+				 - paired.percentile(0, 2.5);
+	QVERIFY(pairedWidth > singleWidth * 1.2);
+}
+
+void tst_BootstrapRatings::reproducible()
+{
+	BootstrapRatings bootstrap(2);
+	addMatch(bootstrap, 101);
+	QVERIFY(bootstrap.run(200, 42));
+	const double low = bootstrap.percentile(0, 2.5);
+	const double high = bootstrap.percentile(0, 97.5);
+
+	// The random streams only depend on the seed
+	QVERIFY(bootstrap.run(200, 42));
+	QCOMPARE(bootstrap.percentile(0, 2.5), low);
+	QCOMPARE(bootstrap.percentile(0, 97.5), high);
+
+	bootstrap.reset(2);
+	QCOMPARE(bootstrap.gameCount(), 0);
+	QVERIFY(!bootstrap.run(200, 42));
+}
+
+void tst_BootstrapRatings::roundRobin()
+{
+	// Each player scores 2/3 against the next one, and player 3
+	// doesn't play at all
+	BootstrapRatings bootstrap(4);
+	for (int i = 0; i < 3000; i++)
+	{
+		const int player = i % 2;
+		bootstrap.addGame(i, player, player + 1, (i / 2) % 3 ? 2 : 0);
+	}
+	QVERIFY(bootstrap.run(300, 3));
+
+	for (int i = 0; i < 2; i++)
+	{
+		QVERIFY(bootstrap.percentile(i, 2.5)
+			> bootstrap.percentile(i + 1, 97.5));
+	}
+	const double sum = bootstrap.percentile(0, 50.0)
+			 + bootstrap.percentile(1, 50.0)
+			 + bootstrap.percentile(2, 50.0);
+	QVERIFY(std::fabs(sum) < 10.0);
+	QVERIFY(std::isnan(bootstrap.percentile(3, 50.0)));
+}
+
+QTEST_MAIN(tst_BootstrapRatings)
+#include "tst_bootstrapratings.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_cgroup
+SOURCES += tst_cgroup.cpp
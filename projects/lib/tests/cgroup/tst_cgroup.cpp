@@ -0,0 +1,89 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <cgroup.h>
+
+class tst_Cgroup: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void parseSize_data() const;
+		void parseSize() const;
+		void limits() const;
+		void throttledTime() const;
+};
+
+static QByteArray readFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+	return file.readAll();
+}
+
+void tst_Cgroup::parseSize_data() const
+{
+	QTest::addColumn<QString>("str");
+	QTest::addColumn<qint64>("expect");
+
+	QTest::newRow("bytes") << "4096" << Q_INT64_C(4096);
+	QTest::newRow("kilobytes") << "64K" << Q_INT64_C(65536);
+	QTest::newRow("megabytes") << "512m" << Q_INT64_C(536870912);
+	QTest::newRow("gigabytes") << "2G" << Q_INT64_C(2147483648);
+	QTest::newRow("zero") << "0" << Q_INT64_C(0);
+	QTest::newRow("negative") << "-1M" << Q_INT64_C(0);
+	QTest::newRow("garbage") << "lots" << Q_INT64_C(0);
+}
+
+void tst_Cgroup::parseSize() const
+{
+	QFETCH(QString, str);
+	QFETCH(qint64, expect);
+
+	QCOMPARE(Cgroup::parseSize(str), expect);
+}
+
+void tst_Cgroup::limits() const
+{
+	// The control files of a group are plain files elsewhere
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString path = dir.path();
+
+	QVERIFY(Cgroup::setCpuQuota(path, 150));
+	QCOMPARE(readFile(path + "/cpu.max"), QByteArray("150000 100000"));
+	QVERIFY(!Cgroup::setCpuQuota(path, 0));
+
+	QVERIFY(Cgroup::setMemoryLimit(path, Q_INT64_C(1) << 30));
+	QCOMPARE(readFile(path + "/memory.max"), QByteArray("1073741824"));
+
+	QVERIFY(Cgroup::setCpus(path, CpuAffinity::parse("0-3,8")));
+	QCOMPARE(readFile(path + "/cpuset.cpus"), QByteArray("0-3,8"));
+
+	QVERIFY(Cgroup::addProcess(path, 1234));
+	QCOMPARE(readFile(path + "/cgroup.procs"), QByteArray("1234"));
+}
+
+void tst_Cgroup::throttledTime() const
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString path = dir.path();
+
+	QCOMPARE(Cgroup::throttledTime(path), Q_INT64_C(-1));
+
+	QFile file(path + "/cpu.stat");
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write("usage_usec 5000000\n"
+		   "user_usec 4000000\n"
+		   "system_usec 1000000\n"
+		   "nr_periods 50\n"
+		   "nr_throttled 3\n"
+		   "throttled_usec 25000\n");
+	file.close();
+
+	QCOMPARE(Cgroup::throttledTime(path), Q_INT64_C(25000));
+}
+
+QTEST_MAIN(tst_Cgroup)
+#include "tst_cgroup.moc"
@@ -17,10 +17,27 @@ class tst_Board: public QObject
 		
 		void moveStrings_data() const;
 		void moveStrings();
+
+		void trustedMoveStrings_data() const;
+		void trustedMoveStrings();
+		void sanMoveStrings_data() const;
+		void sanMoveStrings();
 		
 		void results_data() const;
 		void results();
 
+		void repeatCount_data() const;
+		void repeatCount();
+
+		void snapshot_data() const;
+		void snapshot();
+
+		void pieceCount_data() const;
+		void pieceCount();
+
+		void genericMoves_data() const;
+		void genericMoves();
+
 		void perft_data() const;
 		void perft();
 
@@ -28,6 +45,7 @@ class tst_Board: public QObject
 	
 	private:
 		void setVariant(const QString& variant);
+		void verifyPieceCounts(QSet<int>& types);
 		Chess::Board* m_board;
 };
 
@@ -146,6 +164,33 @@ void tst_Board::zobristKeys_data() const
 		<< variant
 		<< "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq -"
 		<< Q_UINT64_C(0x5c3f9b829b279560);
+
+	// Fischer Random positions with standard castling rights must
+	// have the same Polyglot keys as in standard chess
+	variant = "fischerandom";
+	QTest::newRow("frc startpos")
+		<< variant
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< Q_UINT64_C(0x463b96181691fc9c);
+	QTest::newRow("frc e2e4")
+		<< variant
+		<< "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3"
+		<< Q_UINT64_C(0x823c9b50fd114196);
+	QTest::newRow("frc a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3")
+		<< variant
+		<< "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq -"
+		<< Q_UINT64_C(0x5c3f9b829b279560);
+
+	// Variants without Polyglot keys use the built-in key table,
+	// which must be the same in every build and process.
+	QTest::newRow("capablanca startpos")
+		<< "capablanca"
+		<< "rnabqkbcnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNABQKBCNR w KQkq - 0 1"
+		<< Q_UINT64_C(0x3bc23165b2d4ac07);
+	QTest::newRow("crazyhouse startpos")
+		<< "crazyhouse"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[-] w KQkq - 0 1"
+		<< Q_UINT64_C(0x0b8d2c37872f776c);
 }
 
 void tst_Board::zobristKeys()
@@ -465,6 +510,137 @@ void tst_Board::moveStrings()
 		QCOMPARE(m_board->fenString(), endfen);
 }
 
+void tst_Board::trustedMoveStrings_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("moves");
+	QTest::addColumn<QString>("startfen");
+	QTest::addColumn<QString>("endfen");
+
+	QTest::newRow("san")
+		<< "standard"
+		<< "e4 Nc6 e5 d5 exd6 Be6 Nf3 Qd7 Bb5 O-O-O dxc7 a6 O-O Qxd2 "
+		   "cxd8=N Qxc1 Bxc6 Qxd1 Nxb7 Qxf1+ Kxf1 Bxa2 Rxa2 Kc7"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< "5bnr/1Nk1pppp/p1B5/8/8/5N2/RPP2PPP/1N3K2 w - - 1 13";
+	// Two knights can reach d2, but the one on f1 is pinned
+	QTest::newRow("pinned")
+		<< "standard"
+		<< "Nd2"
+		<< "4k3/8/8/8/8/8/8/1N2KN1r w - - 0 1"
+		<< "4k3/8/8/8/8/8/3N4/4KN1r b - - 1 1";
+}
+
+void tst_Board::trustedMoveStrings()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, moves);
+	QFETCH(QString, startfen);
+	QFETCH(QString, endfen);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(startfen));
+
+	const auto moveList = moves.split(' ', QString::SkipEmptyParts);
+	for (const auto& moveStr : moveList)
+	{
+		Chess::Move move = m_board->moveFromTrustedSanString(moveStr);
+		QVERIFY(m_board->isLegalMove(move));
+		QCOMPARE(move, m_board->moveFromString(moveStr));
+		m_board->makeMove(move);
+	}
+	QCOMPARE(m_board->fenString(), endfen);
+}
+
+void tst_Board::sanMoveStrings_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QString>("move");
+	QTest::addColumn<QString>("san");
+
+	QTest::newRow("file")
+		<< "standard"
+		<< "4k3/8/8/8/8/5N2/8/1N2K3 w - - 0 1"
+		<< "b1d2"
+		<< "Nbd2";
+	QTest::newRow("rank")
+		<< "standard"
+		<< "4k3/8/8/R7/8/8/8/R3K3 w - - 0 1"
+		<< "a1a3"
+		<< "R1a3";
+	QTest::newRow("file and rank")
+		<< "standard"
+		<< "4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1"
+		<< "a1b2"
+		<< "Qa1b2";
+	QTest::newRow("pinned")
+		<< "standard"
+		<< "4k3/8/8/8/8/8/8/1N2KN1r w - - 0 1"
+		<< "b1d2"
+		<< "Nd2";
+	QTest::newRow("pinned on line")
+		<< "standard"
+		<< "4r2k/8/8/R7/8/4R3/8/4K3 w - - 0 1"
+		<< "a5e5"
+		<< "Rae5";
+	QTest::newRow("check")
+		<< "standard"
+		<< "4r2k/8/8/8/8/2N3N1/8/4K3 w - - 0 1"
+		<< "c3e2"
+		<< "Nce2";
+	QTest::newRow("blocked")
+		<< "standard"
+		<< "7k/8/8/8/8/8/8/R1N1RK2 w - - 0 1"
+		<< "e1d1"
+		<< "Rd1";
+	QTest::newRow("discovered check")
+		<< "standard"
+		<< "4k3/8/8/8/8/8/4N3/4R1K1 w - - 0 1"
+		<< "e2c3"
+		<< "Nc3+";
+	QTest::newRow("promotion check")
+		<< "standard"
+		<< "4k3/1P6/8/8/8/8/8/4K3 w - - 0 1"
+		<< "b7b8q"
+		<< "b8=Q+";
+	QTest::newRow("en passant check")
+		<< "standard"
+		<< "8/2k5/8/3pP3/8/8/8/4K3 w - d6 0 1"
+		<< "e5d6"
+		<< "exd6+";
+	QTest::newRow("castling check")
+		<< "standard"
+		<< "5k2/8/8/8/8/8/8/4K2R w K - 0 1"
+		<< "e1g1"
+		<< "O-O+";
+	QTest::newRow("mate")
+		<< "standard"
+		<< "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"
+		<< "a1a8"
+		<< "Ra8#";
+	QTest::newRow("drop check")
+		<< "crazyhouse"
+		<< "4k3/8/8/8/8/8/8/4K3[N] w - - 0 1"
+		<< "N@d6"
+		<< "N@d6+";
+}
+
+void tst_Board::sanMoveStrings()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QString, move);
+	QFETCH(QString, san);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+
+	Chess::Move m = m_board->moveFromString(move);
+	QVERIFY(m_board->isLegalMove(m));
+	QCOMPARE(m_board->moveString(m, Chess::Board::StandardAlgebraic), san);
+}
+
 void tst_Board::results_data() const
 {
 	QTest::addColumn<QString>("variant");
@@ -730,6 +906,323 @@ void tst_Board::results()
 	QCOMPARE(m_board->result().toShortString(), result);
 }
 
+void tst_Board::repeatCount_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QString>("moves");
+	QTest::addColumn<int>("count");
+
+	QString variant = "standard";
+	QString fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+	QTest::newRow("no repetition")
+		<< variant
+		<< fen
+		<< "Nf3 Nf6 Ng1"
+		<< 0;
+	QTest::newRow("one repetition")
+		<< variant
+		<< fen
+		<< "Nf3 Nf6 Ng1 Ng8"
+		<< 1;
+	QTest::newRow("two repetitions")
+		<< variant
+		<< fen
+		<< "Nf3 Nf6 Ng1 Ng8 Nf3 Nf6 Ng1 Ng8"
+		<< 2;
+	QTest::newRow("odd cycle")
+		<< variant
+		<< fen
+		<< "Nf3 Nf6 Ng5 Ng8 Nf3 Nf6 Ng1 Ng8 Nf3"
+		<< 2;
+	QTest::newRow("irreversible move")
+		<< variant
+		<< fen
+		<< "Nf3 Nf6 Ng1 Ng8 e3 e6 Nf3 Nf6 Ng1 Ng8"
+		<< 1;
+	QTest::newRow("castling rights")
+		<< variant
+		<< fen
+		<< "Nf3 Nf6 Rg1 Rg8 Rh1 Rh8 Ng1 Ng8"
+		<< 0;
+	QTest::newRow("halfmove clock")
+		<< variant
+		<< "4k3/8/8/8/8/8/8/4K3 w - - 60 80"
+		<< "Kd1 Kd8 Ke1 Ke8 Kd1 Kd8 Ke1 Ke8"
+		<< 2;
+
+	variant = "crazyhouse";
+	QTest::newRow("crazyhouse captures")
+		<< variant
+		<< "3r3k/8/8/8/8/8/8/K2R4[-] w - - 0 1"
+		<< "Rxd8+ Kg7 Rg8+ Kxg8 R@d1 R@d8 Kb1 Kh8 Ka2 Kg8 Ka1 Kh8"
+		<< 1;
+}
+
+void tst_Board::repeatCount()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QString, moves);
+	QFETCH(int, count);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+
+	// Query the count after every move like ChessGame does, so that
+	// the cached counts of the earlier positions are used
+	Chess::Move move;
+	const auto moveStrings = moves.split(' ');
+	for (const auto& str : moveStrings)
+	{
+		move = m_board->moveFromString(str);
+		QVERIFY(!move.isNull());
+		m_board->makeMove(move);
+		m_board->repeatCount();
+	}
+	QCOMPARE(m_board->repeatCount(), count);
+
+	// Without the cached count of the current position
+	m_board->undoMove();
+	m_board->makeMove(move);
+	QCOMPARE(m_board->repeatCount(), count);
+}
+
+void tst_Board::snapshot_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QString>("moves");
+	QTest::addColumn<int>("ply");
+
+	QTest::newRow("standard en passant")
+		<< "standard"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< "e4 d5 e5 f5 exf6 Nxf6 Nf3 e6 Be2 Bc5 O-O O-O"
+		<< 4;
+	QTest::newRow("standard castling")
+		<< "standard"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
+		<< "O-O-O O-O Kb1 Kh8 Rhg1 Rab8"
+		<< 2;
+	QTest::newRow("atomic explosion")
+		<< "atomic"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< "e4 e5 Nf3 Nc6 Nxe5 d6 Bb5 Bd7"
+		<< 5;
+	QTest::newRow("crazyhouse drops")
+		<< "crazyhouse"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[-] w KQkq - 0 1"
+		<< "e4 d5 exd5 Qxd5 Nc3 Qa5 P@d5 P@e4"
+		<< 4;
+	QTest::newRow("3check checks")
+		<< "3check"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 3+3 0 1"
+		<< "e4 e5 Bc4 Nc6 Bxf7+ Kxf7 Qh5+ g6 Qf3+ Nf6"
+		<< 7;
+}
+
+void tst_Board::snapshot()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QString, moves);
+	QFETCH(int, ply);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+
+	Chess::BoardSnapshot snapshot;
+	QString snapshotFen;
+	QVector<Chess::Move> moveList;
+	const auto moveStrings = moves.split(' ');
+	for (const auto& str : moveStrings)
+	{
+		if (m_board->plyCount() == ply)
+		{
+			snapshot = m_board->snapshot();
+			snapshotFen = m_board->fenString();
+		}
+		Chess::Move move = m_board->moveFromString(str);
+		QVERIFY(!move.isNull());
+		m_board->makeMove(move);
+		moveList << move;
+	}
+	QVERIFY(!snapshot.isNull());
+	QCOMPARE(snapshot.plyCount(), ply);
+	// The snapshot is not affected by the moves made after it
+	QCOMPARE(snapshot.board()->fenString(), snapshotFen);
+	QCOMPARE(snapshot.board()->key(), snapshot.key());
+	const QString endFen = m_board->fenString();
+	const quint64 endKey = m_board->key();
+
+	// Restore the snapshot on a new board, replay the rest of the
+	// moves and undo all of them
+	QScopedPointer<Chess::Board> board(Chess::BoardFactory::create(variant));
+	QVERIFY(!board->restore(Chess::BoardSnapshot()));
+	QVERIFY(board->restore(snapshot));
+	QCOMPARE(board->fenString(), snapshotFen);
+	QCOMPARE(board->key(), snapshot.key());
+	QCOMPARE(board->plyCount(), ply);
+
+	for (int i = ply; i < moveList.size(); i++)
+		board->makeMove(moveList.at(i));
+	QCOMPARE(board->fenString(), endFen);
+	QCOMPARE(board->key(), endKey);
+
+	while (board->plyCount() > 0)
+		board->undoMove();
+	QCOMPARE(board->fenString(), fen);
+
+	// Jump back on the original board
+	QVERIFY(m_board->restore(snapshot));
+	QCOMPARE(m_board->fenString(), snapshotFen);
+}
+
+void tst_Board::verifyPieceCounts(QSet<int>& types)
+{
+	QMap<int, int> counts[2];
+	for (int file = 0; file < m_board->width(); file++)
+	{
+		for (int rank = 0; rank < m_board->height(); rank++)
+		{
+			Chess::Piece piece(m_board->pieceAt(Chess::Square(file, rank)));
+			if (piece.isValid())
+			{
+				counts[piece.side()][piece.type()]++;
+				types.insert(piece.type());
+			}
+		}
+	}
+
+	// Piece types that were on the board earlier must have a
+	// count of zero when they're gone
+	int total = 0;
+	for (int side = 0; side < 2; side++)
+	{
+		int sideTotal = 0;
+		for (int type : types)
+		{
+			int count = counts[side].value(type);
+			QCOMPARE(m_board->pieceCount(Chess::Side::Type(side), type), count);
+			sideTotal += count;
+		}
+		QCOMPARE(m_board->pieceCount(Chess::Side::Type(side)), sideTotal);
+		total += sideTotal;
+	}
+	QCOMPARE(m_board->pieceCount(), total);
+}
+
+void tst_Board::pieceCount_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QString>("moves");
+
+	QTest::newRow("standard")
+		<< "standard"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< "e4 d5 exd5 Qxd5 Nc3 Qa5 d4 c6 Nf3 Bg4 Be2 e6 O-O Nd7";
+	QTest::newRow("standard promotions")
+		<< "standard"
+		<< "r3k3/1P6/8/8/8/8/6p1/4K2R w K - 0 1"
+		<< "bxa8=Q+ Ke7 Qb7+ Kd6 Kd2 gxh1=N";
+	QTest::newRow("standard en passant")
+		<< "standard"
+		<< "4k3/8/8/8/3p4/8/4P3/4K3 w - - 0 1"
+		<< "e4 dxe3 Kd1 e2+ Kd2 e1=Q+ Kxe1";
+	QTest::newRow("atomic")
+		<< "atomic"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< "e4 e5 Nf3 Nc6 Nxe5 d6 Bb5 Bd7";
+	QTest::newRow("crazyhouse")
+		<< "crazyhouse"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[-] w KQkq - 0 1"
+		<< "e4 d5 exd5 Qxd5 Nc3 Qa5 P@d5 P@e4";
+	QTest::newRow("capablanca")
+		<< "capablanca"
+		<< "rnabqkbcnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNABQKBCNR w KQkq - 0 1"
+		<< "e4 f5 exf5 Ad6 Ad3 Axf5 Axf5";
+}
+
+void tst_Board::pieceCount()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QString, moves);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+	QSet<int> types;
+	verifyPieceCounts(types);
+
+	const auto moveStrings = moves.split(' ');
+	for (const auto& str : moveStrings)
+	{
+		Chess::Move move = m_board->moveFromString(str);
+		QVERIFY(!move.isNull());
+		m_board->makeMove(move);
+		verifyPieceCounts(types);
+	}
+	while (m_board->plyCount() > 0)
+	{
+		m_board->undoMove();
+		verifyPieceCounts(types);
+	}
+}
+
+void tst_Board::genericMoves_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+
+	QTest::newRow("standard promotions")
+		<< "standard"
+		<< "r3k3/1P6/8/8/8/8/6p1/4K2R w K - 0 1";
+	QTest::newRow("crazyhouse drops")
+		<< "crazyhouse"
+		<< "r1b2rk1/pppp1ppp/2n5/2b1p3/2B1P1n1/2NP1N2/PPP2PPP/R1BQK2R[QNp] w KQ - 0 8";
+	QTest::newRow("capablanca startpos")
+		<< "capablanca"
+		<< "rnabqkbcnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNABQKBCNR w KQkq - 0 1";
+}
+
+void tst_Board::genericMoves()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+
+	setVariant(variant);
+	QVERIFY(m_board->setFenString(fen));
+
+	const auto moves = m_board->legalMoves();
+	QVERIFY(!moves.isEmpty());
+	QSet<Chess::GenericMove> seen;
+	for (const auto& move : moves)
+	{
+		Chess::GenericMove gmove = m_board->genericMove(move);
+		QVERIFY(!gmove.isNull());
+		QVERIFY(!seen.contains(gmove));
+		seen.insert(gmove);
+		QCOMPARE(Chess::GenericMove::fromData(gmove.data()), gmove);
+		if (move.sourceSquare() != 0)
+		{
+			Chess::Square source = gmove.sourceSquare();
+			QCOMPARE(source.index(m_board->width(), m_board->height()),
+				 move.sourceSquare());
+		}
+		// Drops have no source square
+		QCOMPARE(gmove.sourceSquare().isValid(),
+			 move.sourceSquare() != 0);
+		QVERIFY(gmove.targetSquare().file() < m_board->width());
+		QVERIFY(gmove.targetSquare().rank() < m_board->height());
+		QCOMPARE(gmove.promotion(), move.promotion());
+		QVERIFY(m_board->moveFromGenericMove(gmove) == move);
+	}
+	QCOMPARE(seen.size(), moves.size());
+}
+
 void tst_Board::perft_data() const
 {
 	QTest::addColumn<QString>("variant");
@@ -803,8 +1296,8 @@ void tst_Board::perft_data() const
 	QTest::newRow("atomic startpos")
 		<< variant
 		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
-		<< 5 // 3 plies: 8902, 4 plies: 197326, 5 plies: 4865037, 6 plies: 118951457
-		<< Q_UINT64_C(4865037);
+		<< 5 // 3 plies: 8902, 4 plies: 197326, 5 plies: 4865039
+		<< Q_UINT64_C(4865039);
 	QTest::newRow("atomic pos1")
 		<< variant
 		<< "8/8/8/8/8/8/3k4/rR4K1 w Q - 0 1"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_clockservice
+SOURCES += tst_clockservice.cpp
@@ -0,0 +1,85 @@
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <clockservice.h>
+
+class Receiver : public QObject
+{
+	Q_OBJECT
+
+	public:
+		QList<int> expired;
+		QList<qint64> times;
+		QElapsedTimer time;
+
+	public slots:
+		void onExpired(int id)
+		{
+			expired.append(id);
+			times.append(time.elapsed());
+		}
+};
+
+class tst_ClockService: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void expiryOrder();
+		void cancel();
+		void longClock();
+};
+
+void tst_ClockService::expiryOrder()
+{
+	auto service = ClockService::instance();
+	Receiver receiver;
+	receiver.time.start();
+
+	int id3 = service->startClock(&receiver, "onExpired", 60);
+	int id1 = service->startClock(&receiver, "onExpired", 10);
+	int id2 = service->startClock(&receiver, "onExpired", 30);
+	QVERIFY(id1 != 0 && id2 != 0 && id3 != 0);
+	QVERIFY(id1 != id2 && id2 != id3);
+
+	QTRY_COMPARE(receiver.expired.size(), 3);
+	QCOMPARE(receiver.expired, QList<int>() << id1 << id2 << id3);
+	QVERIFY(receiver.times.at(0) >= 10);
+	QVERIFY(receiver.times.at(2) >= 60);
+}
+
+void tst_ClockService::cancel()
+{
+	auto service = ClockService::instance();
+	Receiver receiver;
+	receiver.time.start();
+
+	int id1 = service->startClock(&receiver, "onExpired", 20);
+	int id2 = service->startClock(&receiver, "onExpired", 40);
+	service->cancelClock(id1);
+	// Cancelling an unknown or expired clock does nothing
+	service->cancelClock(id1);
+	service->cancelClock(0);
+
+	QTRY_COMPARE(receiver.expired.size(), 1);
+	QCOMPARE(receiver.expired.first(), id2);
+	QTest::qWait(50);
+	QCOMPARE(receiver.expired.size(), 1);
+}
+
+void tst_ClockService::longClock()
+{
+	// A clock that's more than one turn of the wheel away
+	auto service = ClockService::instance();
+	Receiver receiver;
+	receiver.time.start();
+
+	int id = service->startClock(&receiver, "onExpired", 1200);
+	QTest::qWait(1000);
+	QVERIFY(receiver.expired.isEmpty());
+	QTRY_COMPARE(receiver.expired.size(), 1);
+	QCOMPARE(receiver.expired.first(), id);
+	QVERIFY(receiver.times.first() >= 1200);
+}
+
+QTEST_MAIN(tst_ClockService)
+#include "tst_clockservice.moc"
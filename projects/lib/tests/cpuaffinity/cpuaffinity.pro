@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_cpuaffinity
+SOURCES += tst_cpuaffinity.cpp
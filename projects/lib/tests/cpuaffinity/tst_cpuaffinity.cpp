@@ -0,0 +1,89 @@
+#include <QtTest/QtTest>
+#include <cpuaffinity.h>
+
+class tst_CpuAffinity: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void parse_data() const;
+		void parse() const;
+		void split_data() const;
+		void split() const;
+		void nodes() const;
+};
+
+void tst_CpuAffinity::parse_data() const
+{
+	QTest::addColumn<QString>("str");
+	QTest::addColumn<QString>("expect");
+
+	QTest::newRow("single") << "3" << "3";
+	QTest::newRow("range") << "0-3" << "0-3";
+	QTest::newRow("mixed") << "10-11,0-3,8" << "0-3,8,10-11";
+	QTest::newRow("overlap") << "0-2,1-4" << "0-4";
+	QTest::newRow("reversed") << "3-1" << "";
+	QTest::newRow("negative") << "-1" << "";
+	QTest::newRow("garbage") << "a,b" << "";
+}
+
+void tst_CpuAffinity::parse() const
+{
+	QFETCH(QString, str);
+	QFETCH(QString, expect);
+
+	QCOMPARE(CpuAffinity::toString(CpuAffinity::parse(str)), expect);
+}
+
+void tst_CpuAffinity::split_data() const
+{
+	QTest::addColumn<QStringList>("nodes");
+	QTest::addColumn<int>("count");
+	QTest::addColumn<QStringList>("expect");
+
+	QTest::newRow("even")
+		<< (QStringList() << "0-7")
+		<< 4
+		<< (QStringList() << "0-1" << "2-3" << "4-5" << "6-7");
+	QTest::newRow("numa")
+		<< (QStringList() << "0-3" << "4-7")
+		<< 2
+		<< (QStringList() << "0-3" << "4-7");
+	QTest::newRow("no crossing")
+		<< (QStringList() << "0-4" << "5-9")
+		<< 3
+		<< (QStringList() << "0-1" << "2-3" << "5-6");
+	QTest::newRow("too many slots")
+		<< (QStringList() << "0-1")
+		<< 3
+		<< (QStringList() << "0" << "1");
+}
+
+void tst_CpuAffinity::split() const
+{
+	QFETCH(QStringList, nodes);
+	QFETCH(int, count);
+	QFETCH(QStringList, expect);
+
+	QList<CpuAffinity::CpuSet> nodeSets;
+	for (const QString& node : nodes)
+		nodeSets << CpuAffinity::parse(node);
+
+	QStringList sets;
+	const auto result = CpuAffinity::split(nodeSets, count);
+	for (const CpuAffinity::CpuSet& set : result)
+		sets << CpuAffinity::toString(set);
+
+	QCOMPARE(sets, expect);
+}
+
+void tst_CpuAffinity::nodes() const
+{
+	const auto nodes = CpuAffinity::nodes();
+	QVERIFY(!nodes.isEmpty());
+	for (const CpuAffinity::CpuSet& node : nodes)
+		QVERIFY(!node.isEmpty());
+}
+
+QTEST_MAIN(tst_CpuAffinity)
+#include "tst_cpuaffinity.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_enginehandshakecache
+SOURCES += tst_enginehandshakecache.cpp
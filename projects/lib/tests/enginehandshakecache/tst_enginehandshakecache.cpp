@@ -0,0 +1,83 @@
+#include <QtTest/QtTest>
+#include <enginehandshakecache.h>
+#include <engineconfiguration.h>
+
+class tst_EngineHandshakeCache: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void disabled();
+		void key();
+		void entries();
+
+	private:
+		EngineConfiguration config() const;
+		QTemporaryDir m_dir;
+};
+
+EngineConfiguration tst_EngineHandshakeCache::config() const
+{
+	// The test executable is as good an engine binary as any
+	EngineConfiguration config("test", QCoreApplication::applicationFilePath(),
+				   "uci");
+	return config;
+}
+
+void tst_EngineHandshakeCache::disabled()
+{
+	EngineHandshakeCache::setFileName(QString());
+	QVERIFY(!EngineHandshakeCache::isEnabled());
+	QVERIFY(EngineHandshakeCache::key(config()).isEmpty());
+}
+
+void tst_EngineHandshakeCache::key()
+{
+	QVERIFY(m_dir.isValid());
+	EngineHandshakeCache::setFileName(m_dir.path() + "/cache.json");
+	QVERIFY(EngineHandshakeCache::isEnabled());
+
+	const QString key(EngineHandshakeCache::key(config()));
+	QVERIFY(!key.isEmpty());
+	QCOMPARE(EngineHandshakeCache::key(config()), key);
+
+	EngineConfiguration other(config());
+	other.addArgument("-x");
+	QVERIFY(EngineHandshakeCache::key(other) != key);
+
+	other = config();
+	other.setProtocol("xboard");
+	QVERIFY(EngineHandshakeCache::key(other) != key);
+
+	other.setCommand(m_dir.path() + "/nonexistent");
+	QVERIFY(EngineHandshakeCache::key(other).isEmpty());
+}
+
+void tst_EngineHandshakeCache::entries()
+{
+	const QString fileName(m_dir.path() + "/entries.json");
+	EngineHandshakeCache::setFileName(fileName);
+
+	const QString key(EngineHandshakeCache::key(config()));
+	QVERIFY(EngineHandshakeCache::entry(key).isEmpty());
+
+	QVariantMap entry;
+	entry.insert("name", "Engine 1.0");
+	entry.insert("variants", QStringList() << "standard" << "fischerandom");
+	EngineHandshakeCache::setEntry(key, entry);
+	QVERIFY(QFile::exists(fileName));
+	QCOMPARE(EngineHandshakeCache::entry(key)["name"].toString(),
+		 QString("Engine 1.0"));
+
+	// The entry is read back from the file
+	EngineHandshakeCache::setFileName(fileName);
+	const QVariantMap stored(EngineHandshakeCache::entry(key));
+	QCOMPARE(stored["name"].toString(), QString("Engine 1.0"));
+	QCOMPARE(stored["variants"].toStringList(),
+		 QStringList() << "standard" << "fischerandom");
+
+	EngineHandshakeCache::setFileName(QString());
+}
+
+QTEST_MAIN(tst_EngineHandshakeCache)
+#include "tst_enginehandshakecache.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_epdrecord
+SOURCES += tst_epdrecord.cpp
@@ -0,0 +1,108 @@
+#include <QtTest/QtTest>
+#include <QTextStream>
+#include <epdrecord.h>
+
+class tst_EpdRecord: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void parse_data() const;
+		void parse() const;
+		void stream() const;
+};
+
+void tst_EpdRecord::parse_data() const
+{
+	QTest::addColumn<QString>("line");
+	QTest::addColumn<bool>("ok");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QString>("opcode");
+	QTest::addColumn<QStringList>("operands");
+
+	const QString fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3");
+
+	QTest::newRow("fen only")
+		<< fen << true << fen << "bm" << QStringList();
+	QTest::newRow("single operand")
+		<< fen + " bm e5; id \"test 1\";" << true << fen
+		<< "bm" << (QStringList() << "e5");
+	QTest::newRow("quoted operand")
+		<< fen + " bm e5; id \"test 1\";" << true << fen
+		<< "id" << (QStringList() << "test 1");
+	QTest::newRow("many operands")
+		<< fen + " am\tNf6 c5 d5; acd 20;" << true << fen
+		<< "am" << (QStringList() << "Nf6" << "c5" << "d5");
+	QTest::newRow("past 8 characters")
+		<< fen + " c0 \"Kasparov-Topalov, Wijk aan Zee 1999\";" << true << fen
+		<< "c0" << (QStringList() << "Kasparov-Topalov, Wijk aan Zee 1999");
+	QTest::newRow("quoted semicolon")
+		<< fen + " c0 \"first; second\"; bm e5;" << true << fen
+		<< "c0" << (QStringList() << "first; second");
+	QTest::newRow("repeated opcode")
+		<< fen + " bm e5; bm c5;" << true << fen
+		<< "bm" << (QStringList() << "e5" << "c5");
+	QTest::newRow("unterminated operation")
+		<< fen + " bm e5; id \"test 2\"" << true << fen
+		<< "id" << QStringList();
+	QTest::newRow("opcode prefix")
+		<< fen + " bm e5;" << true << fen
+		<< "b" << QStringList();
+	QTest::newRow("extra whitespace")
+		<< "  rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR  b\tKQkq e3 "
+		   " bm e5;" << true << fen
+		<< "bm" << (QStringList() << "e5");
+	QTest::newRow("quote in opcode")
+		<< fen + " b\"m e5;" << false << fen
+		<< "bm" << QStringList();
+	QTest::newRow("missing opcode")
+		<< fen + " bm e5; ;" << false << fen
+		<< "bm" << (QStringList() << "e5");
+	QTest::newRow("short fen")
+		<< "8/8/8/8/8/8/8/K6k w -" << false << QString()
+		<< "bm" << QStringList();
+}
+
+void tst_EpdRecord::parse() const
+{
+	QFETCH(QString, line);
+	QFETCH(bool, ok);
+	QFETCH(QString, fen);
+	QFETCH(QString, opcode);
+	QFETCH(QStringList, operands);
+
+	QString str(line + "\n");
+	QTextStream stream(&str, QIODevice::ReadOnly);
+	EpdRecord epd;
+
+	QCOMPARE(epd.parse(stream), ok);
+	QCOMPARE(epd.fen(), fen);
+	QCOMPARE(epd.hasOpcode(opcode), !operands.isEmpty());
+	QCOMPARE(epd.operands(opcode), operands);
+}
+
+void tst_EpdRecord::stream() const
+{
+	QString str("\n"
+		    "8/8/8/8/8/8/8/K6k w - - id \"one\";\r\n"
+		    "   \n"
+		    "8/8/8/8/8/8/8/K6k b - - bm Kg2;\n"
+		    "\n");
+	QTextStream stream(&str, QIODevice::ReadOnly);
+	EpdRecord epd;
+
+	QVERIFY(epd.parse(stream));
+	QCOMPARE(epd.fen(), QString("8/8/8/8/8/8/8/K6k w - -"));
+	QCOMPARE(epd.operands("id"), QStringList() << "one");
+	QVERIFY(!epd.hasOpcode("bm"));
+
+	QVERIFY(epd.parse(stream));
+	QCOMPARE(epd.fen(), QString("8/8/8/8/8/8/8/K6k b - -"));
+	QCOMPARE(epd.operands("bm"), QStringList() << "Kg2");
+
+	QVERIFY(!epd.parse(stream));
+	QVERIFY(stream.atEnd());
+}
+
+QTEST_MAIN(tst_EpdRecord)
+#include "tst_epdrecord.moc"
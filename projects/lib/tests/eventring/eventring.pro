@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_eventring
+SOURCES += tst_eventring.cpp
@@ -0,0 +1,105 @@
+#include <QtTest/QtTest>
+#include <QThread>
+#include <eventring.h>
+
+class tst_EventRing: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void pushAndDrain();
+		void overflow();
+		void threads();
+};
+
+typedef EventRing<QString> StringRing;
+
+class Producer : public QThread
+{
+	public:
+		Producer(StringRing* ring, QSemaphore* wakeups, int count)
+			: m_ring(ring), m_wakeups(wakeups), m_count(count) {}
+
+	protected:
+		virtual void run()
+		{
+			for (int i = 0; i < m_count; i++)
+			{
+				const QString str(QString::number(i));
+				StringRing::PushResult result;
+				while ((result = m_ring->push(str)) == StringRing::Dropped)
+					yieldCurrentThread();
+				if (result == StringRing::QueuedAndWake)
+					m_wakeups->release();
+			}
+		}
+
+	private:
+		StringRing* m_ring;
+		QSemaphore* m_wakeups;
+		int m_count;
+};
+
+void tst_EventRing::pushAndDrain()
+{
+	StringRing ring(4);
+	QStringList taken;
+	auto take = [&](const QString& str) { taken << str; };
+
+	QCOMPARE(ring.drain(take), 0);
+
+	// Only the first event of a batch needs a wakeup
+	QCOMPARE(ring.push("a"), StringRing::QueuedAndWake);
+	QCOMPARE(ring.push("b"), StringRing::Queued);
+	QCOMPARE(ring.drain(take), 2);
+	QCOMPARE(taken, QStringList() << "a" << "b");
+
+	QCOMPARE(ring.push("c"), StringRing::QueuedAndWake);
+	QCOMPARE(ring.drain(take), 1);
+	QCOMPARE(taken.last(), QString("c"));
+	QCOMPARE(ring.droppedCount(), 0);
+}
+
+void tst_EventRing::overflow()
+{
+	StringRing ring(3);
+	for (int i = 0; i < 4; i++)
+		QVERIFY(ring.push(QString::number(i)) != StringRing::Dropped);
+	QCOMPARE(ring.push("4"), StringRing::Dropped);
+	QCOMPARE(ring.droppedCount(), 1);
+
+	QStringList taken;
+	QCOMPARE(ring.drain([&](const QString& str) { taken << str; }), 4);
+	QCOMPARE(taken, QStringList() << "0" << "1" << "2" << "3");
+	QCOMPARE(ring.push("5"), StringRing::QueuedAndWake);
+}
+
+void tst_EventRing::threads()
+{
+	const int count = 100000;
+	StringRing ring(64);
+	QSemaphore wakeups;
+
+	Producer producer(&ring, &wakeups, count);
+	producer.start();
+
+	int next = 0;
+	bool inOrder = true;
+	while (next < count)
+	{
+		wakeups.acquire();
+		ring.drain([&](const QString& str)
+		{
+			inOrder = inOrder && str.toInt() == next;
+			next++;
+		});
+	}
+
+	producer.wait();
+
+	QVERIFY(inOrder);
+	QCOMPARE(next, count);
+}
+
+QTEST_MAIN(tst_EventRing)
+#include "tst_eventring.moc"
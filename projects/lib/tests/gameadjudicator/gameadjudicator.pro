@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_gameadjudicator
+SOURCES += tst_gameadjudicator.cpp
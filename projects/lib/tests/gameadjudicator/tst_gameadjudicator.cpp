@@ -0,0 +1,139 @@
+#include <QtTest/QtTest>
+#include <gameadjudicator.h>
+#include <moveevaluation.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+class tst_GameAdjudicator: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void init();
+		void cleanup();
+		void mateAgreement();
+		void mateDisagreement();
+		void mateDistance();
+		void mateBookMove();
+		void settingsString();
+
+	private:
+		// Plays the next move of a fixed opening and adds an
+		// evaluation with 'score' and 'depth'
+		void addEval(GameAdjudicator& adjudicator, int score, int depth = 10);
+
+		Chess::Board* m_board;
+		int m_moveIndex;
+};
+
+// Mate scores in the format of the engine classes
+static int mateIn(int moves)
+{
+	return 99000 + 1 - moves * 2;
+}
+
+static int matedIn(int moves)
+{
+	return -99000 + moves * 2;
+}
+
+void tst_GameAdjudicator::init()
+{
+	m_board = Chess::BoardFactory::create("standard");
+	m_board->reset();
+	m_moveIndex = 0;
+}
+
+void tst_GameAdjudicator::cleanup()
+{
+	delete m_board;
+}
+
+void tst_GameAdjudicator::addEval(GameAdjudicator& adjudicator,
+				  int score,
+				  int depth)
+{
+	static const char* moves[] = {
+		"e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "g8f6",
+		"d2d3", "f8c5", "b1c3", "d7d6", "c1g5", "h7h6"
+	};
+	QVERIFY(m_moveIndex < int(sizeof(moves) / sizeof(moves[0])));
+
+	m_board->makeMove(m_board->moveFromString(moves[m_moveIndex++]));
+	MoveEvaluation eval;
+	eval.setDepth(depth);
+	eval.setScore(score);
+	adjudicator.addEval(m_board, eval);
+}
+
+void tst_GameAdjudicator::mateAgreement()
+{
+	GameAdjudicator adjudicator;
+	adjudicator.setMateThreshold(2, 5);
+
+	addEval(adjudicator, mateIn(3));
+	addEval(adjudicator, matedIn(3));
+	addEval(adjudicator, mateIn(2));
+	QVERIFY(adjudicator.result().isNone());
+	addEval(adjudicator, matedIn(2));
+
+	const Chess::Result result(adjudicator.result());
+	QCOMPARE(result.type(), Chess::Result::Adjudication);
+	QCOMPARE(result.winner(), Chess::Side(Chess::Side::White));
+	QCOMPARE(result.shortDescription(), QString("Mate score rule, +M3 -M4"));
+}
+
+void tst_GameAdjudicator::mateDisagreement()
+{
+	GameAdjudicator adjudicator;
+	adjudicator.setMateThreshold(1, 5);
+
+	// Both players think they are mating
+	addEval(adjudicator, mateIn(3));
+	addEval(adjudicator, mateIn(3));
+	QVERIFY(adjudicator.result().isNone());
+
+	// Black mates
+	addEval(adjudicator, matedIn(2));
+	QCOMPARE(adjudicator.result().winner(), Chess::Side(Chess::Side::Black));
+}
+
+void tst_GameAdjudicator::mateDistance()
+{
+	GameAdjudicator adjudicator;
+	adjudicator.setMateThreshold(1, 5);
+
+	addEval(adjudicator, mateIn(6));
+	addEval(adjudicator, matedIn(6));
+	addEval(adjudicator, 500);
+	addEval(adjudicator, matedIn(5));
+	QVERIFY(adjudicator.result().isNone());
+
+	addEval(adjudicator, mateIn(5));
+	QCOMPARE(adjudicator.result().winner(), Chess::Side(Chess::Side::White));
+}
+
+void tst_GameAdjudicator::mateBookMove()
+{
+	GameAdjudicator adjudicator;
+	adjudicator.setMateThreshold(1, 5);
+
+	addEval(adjudicator, mateIn(3));
+	addEval(adjudicator, 0, 0);
+	addEval(adjudicator, mateIn(2));
+	QVERIFY(adjudicator.result().isNone());
+}
+
+void tst_GameAdjudicator::settingsString()
+{
+	GameAdjudicator adjudicator;
+	const QString settings(adjudicator.settingsString());
+	QVERIFY(!settings.contains("mate"));
+
+	adjudicator.setMateThreshold(3, 10);
+	QVERIFY(adjudicator.settingsString() != settings);
+	QVERIFY(adjudicator.settingsString().startsWith(settings));
+}
+
+QTEST_MAIN(tst_GameAdjudicator)
+#include "tst_gameadjudicator.moc"
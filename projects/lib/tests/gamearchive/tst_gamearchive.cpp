@@ -0,0 +1,170 @@
+#include <QtTest/QtTest>
+#include <gamearchive.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+
+class tst_GameArchive: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void roundTrip_data() const;
+		void roundTrip();
+		void append();
+		void evalData();
+
+	private:
+		PgnGame readPgn(const QByteArray& pgn) const;
+		void compareGames(const PgnGame& a, const PgnGame& b) const;
+};
+
+PgnGame tst_GameArchive::readPgn(const QByteArray& pgn) const
+{
+	PgnStream stream(&pgn);
+	PgnGame game;
+	game.read(stream, INT_MAX - 1, false);
+	return game;
+}
+
+void tst_GameArchive::compareGames(const PgnGame& a, const PgnGame& b) const
+{
+	QCOMPARE(b.tags(), a.tags());
+	QCOMPARE(b.initialComment(), a.initialComment());
+	QCOMPARE(b.moves().size(), a.moves().size());
+	for (int i = 0; i < a.moves().size(); i++)
+	{
+		const auto& x = a.moves().at(i);
+		const auto& y = b.moves().at(i);
+		QCOMPARE(y.key, x.key);
+		QCOMPARE(y.move, x.move);
+		QCOMPARE(y.moveString, x.moveString);
+		QCOMPARE(y.comment, x.comment);
+	}
+}
+
+void tst_GameArchive::roundTrip_data() const
+{
+	QTest::addColumn<QByteArray>("pgn");
+
+	QTest::newRow("evaluations")
+		<< QByteArray(
+		   "[Event \"Test\"]\n[Site \"?\"]\n[Date \"2018.01.01\"]\n"
+		   "[Round \"1\"]\n[White \"A\"]\n[Black \"B\"]\n"
+		   "[Result \"1-0\"]\n\n"
+		   "1. e4 {book} e5 {book} 2. Nf3 {d=12, pd=Nf6, mt=00:00:01, "
+		   "tl=00:01:02, s=1520 kN/s, n=1843201, pv=Nf3 Nf6 Nxe5, tb=0, "
+		   "R50=50, wv=0.31,} Nc6 {d=14, mt=00:00:02, tl=00:00:59, "
+		   "s=1498 kN/s, n=2910332, pv=Nc6, tb=3, R50=50, wv=-M7,} "
+		   "3. Bb5 {a plain comment} a6 {d=1, mt=00:00:00, tl=00:00:58, "
+		   "s=0 kN/s, n=0, pv=, tb=0, wv=0.00, Black resigns} 1-0\n");
+	QTest::newRow("crazyhouse drops")
+		<< QByteArray(
+		   "[Event \"?\"]\n[Site \"?\"]\n[Date \"?\"]\n[Round \"?\"]\n"
+		   "[White \"?\"]\n[Black \"?\"]\n[Result \"*\"]\n"
+		   "[Variant \"crazyhouse\"]\n\n"
+		   "{initial} 1. e4 d5 2. exd5 Qxd5 3. Nc3 Qa5 4. P@b4 Qxb4 "
+		   "5. Nf3 P@e4 *\n");
+}
+
+void tst_GameArchive::roundTrip()
+{
+	QFETCH(QByteArray, pgn);
+
+	const PgnGame game(readPgn(pgn));
+	QVERIFY(!game.isNull());
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/games.cca");
+
+	GameArchive archive;
+	QVERIFY(archive.open(fileName, QIODevice::WriteOnly));
+	QVERIFY(archive.writeGame(game));
+	archive.close();
+	QVERIFY(GameArchive::isArchive(fileName));
+
+	QVERIFY(archive.open(fileName));
+	QCOMPARE(archive.gameCount(), 1);
+	PgnGame copy;
+	QVERIFY(archive.readGame(0, copy));
+	compareGames(game, copy);
+}
+
+void tst_GameArchive::append()
+{
+	const PgnGame game(readPgn(
+		"[Event \"?\"]\n[Result \"*\"]\n\n1. d4 {book} Nf6 2. c4 *\n"));
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/games.cca");
+
+	GameArchive archive;
+	for (int i = 0; i < 3; i++)
+	{
+		QVERIFY(archive.open(fileName, QIODevice::Append));
+		QCOMPARE(archive.gameCount(), i);
+		QVERIFY(archive.writeGame(game));
+		archive.close();
+	}
+
+	// An archive without a footer is recovered by scanning it
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadWrite));
+	QVERIFY(file.resize(file.size() - 1));
+	file.close();
+
+	QVERIFY(archive.open(fileName));
+	QCOMPARE(archive.gameCount(), 3);
+	PgnGame copy;
+	QVERIFY(archive.readGame(2, copy));
+	compareGames(game, copy);
+}
+
+void tst_GameArchive::evalData()
+{
+	PgnGame game(readPgn("[Event \"?\"]\n[Result \"0-1\"]\n\n1. e4 e5 0-1\n"));
+	QCOMPARE(game.moves().size(), 2);
+
+	PgnGame::MoveData md(game.moves().at(0));
+	md.eval.score = 31;
+	md.eval.depth = 12;
+	md.eval.moveTime = 1000;
+	md.eval.timeLeft = 62000;
+	md.eval.nodes = 1843201;
+	md.eval.nps = 1520000;
+	md.eval.pv = "e2e4 e7e5 g1f3";
+	game.setMove(0, md);
+
+	md = game.moves().at(1);
+	md.eval.score = 40;
+	md.eval.depth = 5;
+	md.eval.nodes = 100;
+	game.setMove(1, md);
+	game.setResultDescription("White resigns");
+
+	const QStringList comments(game.comments());
+	QCOMPARE(comments.size(), 2);
+	QCOMPARE(comments.at(0), QString("d=12, pd=e5, mt=00:00:01, "
+		"tl=00:01:02, s=1520 kN/s, n=1843201, pv=e4 e5 Nf3, tb=0, "
+		"R50=50, wv=0.31,"));
+	QCOMPARE(comments.at(1), QString("d=5, mt=00:00:00, tl=00:00:00, "
+		"s=0 kN/s, n=100, pv=, tb=0, R50=50, wv=-0.40, White resigns"));
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/games.cca");
+
+	GameArchive archive;
+	QVERIFY(archive.open(fileName, QIODevice::WriteOnly));
+	QVERIFY(archive.writeGame(game));
+	archive.close();
+
+	QVERIFY(archive.open(fileName));
+	PgnGame copy;
+	QVERIFY(archive.readGame(0, copy));
+	QCOMPARE(copy.comments(), comments);
+}
+
+QTEST_MAIN(tst_GameArchive)
+#include "tst_gamearchive.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_gamemanager
+SOURCES += tst_gamemanager.cpp
@@ -0,0 +1,150 @@
+#include <QtTest/QtTest>
+#include <gamemanager.h>
+#include <chessgame.h>
+#include <pgngame.h>
+#include <playerbuilder.h>
+
+class MockPlayerBuilder: public PlayerBuilder
+{
+	public:
+		MockPlayerBuilder(const QString& name)
+			: PlayerBuilder(name)
+		{
+		}
+
+		virtual bool isHuman() const
+		{
+			return false;
+		}
+
+		virtual ChessPlayer* create(QObject* receiver,
+					    const char* method,
+					    QObject* parent,
+					    QString* error) const
+		{
+			Q_UNUSED(receiver);
+			Q_UNUSED(method);
+			Q_UNUSED(parent);
+			Q_UNUSED(error);
+
+			return 0;
+		}
+};
+
+class tst_GameManager: public QObject
+{
+	Q_OBJECT
+
+	public:
+		tst_GameManager();
+
+	private slots:
+		void lookahead();
+		void playerConcurrency();
+		void queueBenchmark();
+
+	private:
+		PgnGame m_pgn;
+		MockPlayerBuilder m_white;
+		MockPlayerBuilder m_black;
+};
+
+tst_GameManager::tst_GameManager()
+	: m_white("white"),
+	  m_black("black")
+{
+}
+
+void tst_GameManager::lookahead()
+{
+	// No game slots, so the games stay in the queue
+	GameManager manager;
+	manager.setConcurrency(0);
+	manager.setLookahead(3);
+	QSignalSpy spy(&manager, SIGNAL(ready()));
+
+	auto game1 = new ChessGame(nullptr, &m_pgn);
+	manager.newGame(game1, &m_white, &m_black, GameManager::Enqueue,
+			GameManager::ReusePlayers);
+	auto game2 = new ChessGame(nullptr, &m_pgn);
+	manager.newGame(game2, &m_white, &m_black, GameManager::Enqueue,
+			GameManager::ReusePlayers);
+	QCOMPARE(spy.count(), 2);
+
+	// A deleted game doesn't take room in the queue
+	delete game1;
+	auto game3 = new ChessGame(nullptr, &m_pgn);
+	manager.newGame(game3, &m_white, &m_black, GameManager::Enqueue,
+			GameManager::ReusePlayers);
+	QCOMPARE(spy.count(), 3);
+
+	auto game4 = new ChessGame(nullptr, &m_pgn);
+	manager.newGame(game4, &m_white, &m_black, GameManager::Enqueue,
+			GameManager::ReusePlayers);
+	QCOMPARE(spy.count(), 3);
+
+	delete game2;
+	delete game3;
+	delete game4;
+}
+
+void tst_GameManager::playerConcurrency()
+{
+	GameManager manager;
+	QCOMPARE(manager.playerConcurrency(&m_white), 0);
+
+	manager.setPlayerConcurrency(&m_white, 2);
+	QCOMPARE(manager.playerConcurrency(&m_white), 2);
+	QCOMPARE(manager.playerConcurrency(&m_black), 0);
+
+	// Zero removes the limit
+	manager.setPlayerConcurrency(&m_white, 0);
+	QCOMPARE(manager.playerConcurrency(&m_white), 0);
+
+	// Without game slots a limit doesn't change the queue
+	manager.setConcurrency(0);
+	manager.setLookahead(2);
+	manager.setPlayerConcurrency(&m_black, 1);
+	QSignalSpy spy(&manager, SIGNAL(ready()));
+
+	auto game1 = new ChessGame(nullptr, &m_pgn);
+	manager.newGame(game1, &m_white, &m_black, GameManager::Enqueue,
+			GameManager::ReusePlayers);
+	auto game2 = new ChessGame(nullptr, &m_pgn);
+	manager.newGame(game2, &m_white, &m_black, GameManager::Enqueue,
+			GameManager::ReusePlayers);
+	QCOMPARE(spy.count(), 1);
+	QCOMPARE(manager.queuedGameCount(), 2);
+
+	delete game1;
+	delete game2;
+}
+
+void tst_GameManager::queueBenchmark()
+{
+	const int count = 100000;
+
+	QBENCHMARK_ONCE
+	{
+		GameManager manager;
+		manager.setConcurrency(0);
+
+		QVector<ChessGame*> games;
+		games.reserve(count);
+		for (int i = 0; i < count; i++)
+		{
+			auto game = new ChessGame(nullptr, &m_pgn);
+			games << game;
+			manager.newGame(game, &m_white, &m_black,
+					GameManager::Enqueue,
+					GameManager::ReusePlayers);
+		}
+
+		// Deleting queued games from the back was quadratic
+		for (int i = count - 1; i >= 0; i--)
+			delete games.at(i);
+	}
+}
+
+QTEST_MAIN(tst_GameManager)
+#include "tst_gamemanager.moc"
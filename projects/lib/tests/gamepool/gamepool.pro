@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_gamepool
+SOURCES += tst_gamepool.cpp
@@ -0,0 +1,75 @@
+#include <QtTest/QtTest>
+#include <gamepool.h>
+#include <pgngame.h>
+#include <board/board.h>
+
+class tst_GamePool: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void boards() const;
+		void pgns() const;
+		void capacity() const;
+};
+
+void tst_GamePool::boards() const
+{
+	GamePool pool;
+	QVERIFY(pool.takeBoard("nosuchvariant") == nullptr);
+
+	Chess::Board* board = pool.takeBoard("standard");
+	QVERIFY(board != nullptr);
+	board->reset();
+	pool.recycleBoard(board);
+
+	Chess::Board* other = pool.takeBoard("atomic");
+	QVERIFY(other != board);
+	delete other;
+	Chess::Board* reused = pool.takeBoard("standard");
+	QCOMPARE(reused, board);
+	QCOMPARE(pool.reuseCount(), 1);
+
+	QVERIFY(reused->setFenString("8/8/4k3/8/8/4K3/8/8 w - - 0 1"));
+	QCOMPARE(reused->fenString(), QString("8/8/4k3/8/8/4K3/8/8 w - - 0 1"));
+	delete reused;
+}
+
+void tst_GamePool::pgns() const
+{
+	GamePool pool;
+	PgnGame* pgn = pool.takePgn();
+	pgn->setEvent("Test");
+	pgn->setInitialComment("comment");
+
+	PgnGame::MoveData md;
+	md.key = 1;
+	md.moveString = "e4";
+	pgn->addMove(md, false);
+	pool.recyclePgn(pgn);
+
+	PgnGame* reused = pool.takePgn();
+	QCOMPARE(reused, pgn);
+	QVERIFY(reused->isNull());
+	QVERIFY(reused->initialComment().isEmpty());
+	delete reused;
+}
+
+void tst_GamePool::capacity() const
+{
+	GamePool pool(1);
+	Chess::Board* a = pool.takeBoard("standard");
+	Chess::Board* b = pool.takeBoard("standard");
+	pool.recycleBoard(a);
+	pool.recycleBoard(b);
+
+	QCOMPARE(pool.takeBoard("standard"), a);
+	Chess::Board* c = pool.takeBoard("standard");
+	QVERIFY(c != a);
+	QCOMPARE(pool.reuseCount(), 1);
+	delete a;
+	delete c;
+}
+
+QTEST_MAIN(tst_GamePool)
+#include "tst_gamepool.moc"
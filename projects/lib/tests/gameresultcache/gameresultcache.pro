@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_gameresultcache
+SOURCES += tst_gameresultcache.cpp
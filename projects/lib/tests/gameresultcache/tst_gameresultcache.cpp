@@ -0,0 +1,107 @@
+#include <QtTest/QtTest>
+#include <gameresultcache.h>
+#include <engineconfiguration.h>
+
+class tst_GameResultCache: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void engineKey();
+		void gameKey();
+		void entries();
+
+	private:
+		EngineConfiguration config() const;
+		QTemporaryDir m_dir;
+};
+
+EngineConfiguration tst_GameResultCache::config() const
+{
+	// The test executable is as good an engine binary as any
+	EngineConfiguration config("test", QCoreApplication::applicationFilePath(),
+				   "uci");
+	return config;
+}
+
+void tst_GameResultCache::engineKey()
+{
+	QVERIFY(m_dir.isValid());
+	GameResultCache cache(m_dir.path() + "/keys.jsonl");
+
+	const QString key(cache.engineKey(config()));
+	QVERIFY(!key.isEmpty());
+	QCOMPARE(cache.engineKey(config()), key);
+
+	EngineConfiguration other(config());
+	other.setOption("Hash", 64);
+	QVERIFY(cache.engineKey(other) != key);
+
+	other = config();
+	other.addArgument("-x");
+	QVERIFY(cache.engineKey(other) != key);
+
+	// The error output doesn't change the games
+	other = config();
+	other.setStderrFile(m_dir.path() + "/stderr.txt");
+	QCOMPARE(cache.engineKey(other), key);
+
+	other.setCommand(m_dir.path() + "/nonexistent");
+	QVERIFY(cache.engineKey(other).isEmpty());
+}
+
+void tst_GameResultCache::gameKey()
+{
+	const QStringList fields(QStringList() << "standard" << "40/60");
+	const QString key(GameResultCache::gameKey("a", "b", fields));
+	QVERIFY(!key.isEmpty());
+	QCOMPARE(GameResultCache::gameKey("a", "b", fields), key);
+
+	// Swapping the colors makes a different game
+	QVERIFY(GameResultCache::gameKey("b", "a", fields) != key);
+	QVERIFY(GameResultCache::gameKey("a", "b", QStringList() << "standard")
+		!= key);
+	QVERIFY(GameResultCache::gameKey(QString(), "b", fields).isEmpty());
+}
+
+void tst_GameResultCache::entries()
+{
+	const QString fileName(m_dir.path() + "/entries.jsonl");
+	const QString key(GameResultCache::gameKey("a", "b", QStringList()));
+	const QString pgn("[Event \"?\"]\n\n1. e4 e5 1/2-1/2\n");
+
+	{
+		GameResultCache cache(fileName);
+		QVERIFY(cache.entry(key).result.isNone());
+
+		GameResultCache::Entry entry;
+		entry.result = Chess::Result(Chess::Result::Adjudication,
+					     Chess::Side::NoSide,
+					     "TCEC draw rule");
+		entry.pgn = pgn;
+		QVERIFY(cache.setEntry(key, entry));
+		QCOMPARE(cache.entry(key).result, entry.result);
+	}
+
+	// The entry is read back from the file
+	GameResultCache cache(fileName);
+	const GameResultCache::Entry stored(cache.entry(key));
+	QCOMPARE(stored.result.type(), Chess::Result::Adjudication);
+	QVERIFY(stored.result.isDraw());
+	QCOMPARE(stored.result.description(),
+		 QString("Adjudication: TCEC draw rule"));
+	QCOMPARE(stored.pgn, pgn);
+
+	Chess::Result win(Chess::Result::Win, Chess::Side::Black);
+	GameResultCache::Entry entry;
+	entry.result = win;
+	entry.pgn = pgn;
+	QVERIFY(cache.setEntry(key, entry));
+
+	// The last record of a key wins
+	GameResultCache reread(fileName);
+	QCOMPARE(reread.entry(key).result, win);
+}
+
+QTEST_MAIN(tst_GameResultCache)
+#include "tst_gameresultcache.moc"
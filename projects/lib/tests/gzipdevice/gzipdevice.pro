@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_gzipdevice
+SOURCES += tst_gzipdevice.cpp
@@ -0,0 +1,160 @@
+#include <QtTest/QtTest>
+#include <gzipdevice.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+
+class tst_GzipDevice: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void isGzip();
+		void readGzip();
+		void roundTrip_data() const;
+		void roundTrip();
+		void seek();
+		void truncated();
+		void pgnStream();
+
+	private:
+		QByteArray testData(int size) const;
+		QByteArray compress(const QByteArray& data) const;
+};
+
+// "[Event \"A\"]\n\n1. e4 e5 *\n" compressed with gzip
+static const char s_gzipGame[] =
+	"\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x8b\x76\x2d\x4b\xcd\x2b"
+	"\x51\x50\x72\x54\x8a\xe5\xe2\x32\xd4\x53\x48\x35\x51\x48\x35\x55"
+	"\xd0\xe2\x02\x00\x0a\x8a\xcc\xa1\x18\x00\x00\x00";
+
+QByteArray tst_GzipDevice::testData(int size) const
+{
+	QByteArray data;
+	data.reserve(size);
+	quint32 x = 12345;
+	while (data.size() < size)
+	{
+		x = x * 1103515245 + 12345;
+		// Mix compressible text with noise
+		if ((x >> 16) % 4 == 0)
+			data.append(char(x >> 24));
+		else
+			data.append("1. e4 e5 2. Nf3 Nc6 ", (x >> 16) % 20 + 1);
+	}
+	data.resize(size);
+	return data;
+}
+
+QByteArray tst_GzipDevice::compress(const QByteArray& data) const
+{
+	QByteArray out;
+	QBuffer buffer(&out);
+	buffer.open(QIODevice::WriteOnly);
+
+	GzipDevice gzip(&buffer);
+	gzip.open(QIODevice::WriteOnly);
+	gzip.write(data);
+	gzip.close();
+
+	return out;
+}
+
+void tst_GzipDevice::isGzip()
+{
+	QVERIFY(GzipDevice::isGzip(s_gzipGame, sizeof(s_gzipGame) - 1));
+	QVERIFY(!GzipDevice::isGzip("[Event", 6));
+	QVERIFY(GzipDevice::isGzipFileName("games.pgn.gz"));
+	QVERIFY(!GzipDevice::isGzipFileName("games.pgn"));
+}
+
+void tst_GzipDevice::readGzip()
+{
+	QByteArray data(s_gzipGame, sizeof(s_gzipGame) - 1);
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::ReadOnly);
+
+	GzipDevice gzip(&buffer);
+	QVERIFY(gzip.open(QIODevice::ReadOnly));
+	QCOMPARE(gzip.readAll(), QByteArray("[Event \"A\"]\n\n1. e4 e5 *\n"));
+	QVERIFY(gzip.atEnd());
+}
+
+void tst_GzipDevice::roundTrip_data() const
+{
+	QTest::addColumn<int>("size");
+
+	QTest::newRow("empty") << 0;
+	QTest::newRow("small") << 100;
+	QTest::newRow("blocks") << 300000;
+}
+
+void tst_GzipDevice::roundTrip()
+{
+	QFETCH(int, size);
+
+	const QByteArray data(testData(size));
+	QByteArray compressed(compress(data));
+	QVERIFY(GzipDevice::isGzip(compressed.constData(), compressed.size()));
+
+	QBuffer buffer(&compressed);
+	buffer.open(QIODevice::ReadOnly);
+	GzipDevice gzip(&buffer);
+	QVERIFY(gzip.open(QIODevice::ReadOnly));
+	QCOMPARE(gzip.size(), qint64(size));
+	QCOMPARE(gzip.readAll(), data);
+}
+
+void tst_GzipDevice::seek()
+{
+	const QByteArray data(testData(300000));
+	QByteArray compressed(compress(data));
+	QBuffer buffer(&compressed);
+	buffer.open(QIODevice::ReadOnly);
+
+	GzipDevice gzip(&buffer);
+	QVERIFY(gzip.open(QIODevice::ReadOnly));
+
+	const qint64 positions[] = { 250000, 10, 65279, 65280, 299990, 0 };
+	for (qint64 pos : positions)
+	{
+		QVERIFY(gzip.seek(pos));
+		QCOMPARE(gzip.pos(), pos);
+		QCOMPARE(gzip.read(10), data.mid(int(pos), 10));
+	}
+}
+
+void tst_GzipDevice::truncated()
+{
+	QByteArray compressed(compress(testData(1000)));
+	compressed.chop(40);
+
+	QBuffer buffer(&compressed);
+	buffer.open(QIODevice::ReadOnly);
+	GzipDevice gzip(&buffer);
+	QVERIFY(gzip.open(QIODevice::ReadOnly));
+
+	char data[2000];
+	qint64 n = 0;
+	qint64 count;
+	while ((count = gzip.read(data, sizeof(data))) > 0)
+		n += count;
+	QCOMPARE(count, qint64(-1));
+	QVERIFY(n < 1000);
+}
+
+void tst_GzipDevice::pgnStream()
+{
+	QByteArray data(s_gzipGame, sizeof(s_gzipGame) - 1);
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::ReadOnly);
+
+	PgnStream stream(&buffer);
+	PgnGame game;
+	QVERIFY(game.read(stream));
+	QCOMPARE(game.tagValue("Event"), QString("A"));
+	QCOMPARE(game.moves().size(), 2);
+	QVERIFY(!game.read(stream));
+}
+
+QTEST_MAIN(tst_GzipDevice)
+#include "tst_gzipdevice.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_hostcalibration
+SOURCES += tst_hostcalibration.cpp
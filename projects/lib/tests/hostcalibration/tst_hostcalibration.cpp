@@ -0,0 +1,82 @@
+#include <QtTest/QtTest>
+#include <hostcalibration.h>
+#include <timecontrol.h>
+
+class tst_HostCalibration: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void parseBenchOutput_data() const;
+		void parseBenchOutput() const;
+		void perftSpeed() const;
+		void scaleFactor() const;
+		void scaleTimeControl() const;
+};
+
+void tst_HostCalibration::parseBenchOutput_data() const
+{
+	QTest::addColumn<QByteArray>("output");
+	QTest::addColumn<qint64>("speed");
+
+	QTest::newRow("stockfish")
+		<< QByteArray("Position: 50/50 (8/8/8/8/8/8/8/8 w - - 0 1)\n"
+			      "info depth 13 seldepth 15 nodes 1234 nps 500000\n"
+			      "bestmove e2e4\n"
+			      "\n"
+			      "===========================\n"
+			      "Total time (ms) : 3000\n"
+			      "Nodes searched  : 4500000\n"
+			      "Nodes/second    : 1500000\n")
+		<< qint64(1500000);
+	QTest::newRow("nps label")
+		<< QByteArray("Time  : 1000ms\nNodes : 900000\nNPS   : 900000\n")
+		<< qint64(900000);
+	QTest::newRow("last report")
+		<< QByteArray("info nps 100\ninfo nps 200\r\n")
+		<< qint64(200);
+	QTest::newRow("no number")
+		<< QByteArray("Nodes/second: unknown\n") << qint64(0);
+	QTest::newRow("no label")
+		<< QByteArray("Nodes searched: 4500000\n") << qint64(0);
+	QTest::newRow("empty") << QByteArray() << qint64(0);
+}
+
+void tst_HostCalibration::parseBenchOutput() const
+{
+	QFETCH(QByteArray, output);
+	QFETCH(qint64, speed);
+
+	QCOMPARE(HostCalibration::parseBenchOutput(output), speed);
+}
+
+void tst_HostCalibration::perftSpeed() const
+{
+	QVERIFY(HostCalibration::perftSpeed(50) > 0);
+}
+
+void tst_HostCalibration::scaleFactor() const
+{
+	// A host at half the reference speed gets twice the time
+	QCOMPARE(HostCalibration::scaleFactor(500000, 1000000), 2.0);
+	QCOMPARE(HostCalibration::scaleFactor(2000000, 1000000), 0.5);
+}
+
+void tst_HostCalibration::scaleTimeControl() const
+{
+	TimeControl tc("40/60+0.5");
+	tc.setExpiryMargin(100);
+	tc.scale(1.5);
+	QCOMPARE(tc.movesPerTc(), 40);
+	QCOMPARE(tc.timePerTc(), 90000);
+	QCOMPARE(tc.timeIncrement(), 750);
+	QCOMPARE(tc.expiryMargin(), 100);
+
+	TimeControl moveTime;
+	moveTime.setTimePerMove(1000);
+	moveTime.scale(0.8);
+	QCOMPARE(moveTime.timePerMove(), 800);
+}
+
+QTEST_MAIN(tst_HostCalibration)
+#include "tst_hostcalibration.moc"
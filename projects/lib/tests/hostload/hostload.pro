@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_hostload
+SOURCES += tst_hostload.cpp
@@ -0,0 +1,49 @@
+#include <QtTest/QtTest>
+#include <hostload.h>
+
+class tst_HostLoad: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void null() const;
+		void sample() const;
+};
+
+void tst_HostLoad::null() const
+{
+	QVERIFY(HostLoad().isNull());
+	QCOMPARE(HostLoad().runnableThreads(), -1);
+	QCOMPARE(HostLoad().busyRatio(HostLoad()), -1.0);
+	QCOMPARE(HostLoad().stealRatio(HostLoad()), -1.0);
+}
+
+void tst_HostLoad::sample() const
+{
+#if !defined(Q_OS_WIN) && !defined(Q_OS_LINUX)
+	QSKIP("Host load is not supported on this platform");
+#endif
+	const HostLoad start = HostLoad::sample();
+	QVERIFY(!start.isNull());
+	QCOMPARE(start.busyRatio(HostLoad()), -1.0);
+
+	// Burn some CPU time
+	QElapsedTimer timer;
+	timer.start();
+	volatile quint64 x = 0;
+	while (timer.elapsed() < 100)
+		x = x + 1;
+
+	const HostLoad end = HostLoad::sample();
+	const double busy = end.busyRatio(start);
+	QVERIFY(busy > 0.0);
+	QVERIFY(busy <= 1.0);
+#ifdef Q_OS_LINUX
+	// This thread was running
+	QVERIFY(end.runnableThreads() >= 1);
+	QVERIFY(end.stealRatio(start) >= 0.0);
+#endif
+}
+
+QTEST_MAIN(tst_HostLoad)
+#include "tst_hostload.moc"
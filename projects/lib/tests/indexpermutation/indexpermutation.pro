@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_indexpermutation
+SOURCES += tst_indexpermutation.cpp
@@ -0,0 +1,71 @@
+#include <QtTest/QtTest>
+#include <indexpermutation.h>
+
+class tst_IndexPermutation: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void bijection_data() const;
+		void bijection() const;
+		void reproducible() const;
+		void seeds() const;
+};
+
+void tst_IndexPermutation::bijection_data() const
+{
+	QTest::addColumn<int>("size");
+
+	QTest::newRow("1") << 1;
+	QTest::newRow("2") << 2;
+	QTest::newRow("3") << 3;
+	QTest::newRow("64") << 64;
+	QTest::newRow("1000") << 1000;
+	QTest::newRow("4097") << 4097;
+}
+
+void tst_IndexPermutation::bijection() const
+{
+	QFETCH(int, size);
+
+	IndexPermutation permutation(size, 12345);
+	QCOMPARE(permutation.size(), quint64(size));
+
+	QVector<bool> seen(size, false);
+	for (int i = 0; i < size; i++)
+	{
+		const quint64 index = permutation.map(i);
+		QVERIFY(index < quint64(size));
+		QVERIFY(!seen.at(int(index)));
+		seen[int(index)] = true;
+	}
+}
+
+void tst_IndexPermutation::reproducible() const
+{
+	IndexPermutation a(5000, 42);
+	IndexPermutation b(5000, 42);
+	for (int i = 0; i < 5000; i++)
+		QCOMPARE(a.map(i), b.map(i));
+}
+
+void tst_IndexPermutation::seeds() const
+{
+	IndexPermutation a(5000, 1);
+	IndexPermutation b(5000, 2);
+
+	int same = 0;
+	int fixed = 0;
+	for (int i = 0; i < 5000; i++)
+	{
+		if (a.map(i) == b.map(i))
+			same++;
+		if (a.map(i) == quint64(i))
+			fixed++;
+	}
+	QVERIFY(same < 50);
+	QVERIFY(fixed < 50);
+}
+
+QTEST_MAIN(tst_IndexPermutation)
+#include "tst_indexpermutation.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_keyset
+SOURCES += tst_keyset.cpp
@@ -0,0 +1,91 @@
+#include <QtTest/QtTest>
+#include <keyset.h>
+
+class tst_KeySet: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void insert();
+		void zeroKey();
+		void collisions();
+		void growth();
+		void clear();
+};
+
+void tst_KeySet::insert()
+{
+	KeySet set;
+	QCOMPARE(set.size(), qint64(0));
+	QVERIFY(!set.contains(1));
+
+	QVERIFY(set.insert(1));
+	QVERIFY(set.insert(Q_UINT64_C(0x9d39247e33776d41)));
+	QVERIFY(!set.insert(1));
+	QCOMPARE(set.size(), qint64(2));
+	QVERIFY(set.contains(1));
+	QVERIFY(set.contains(Q_UINT64_C(0x9d39247e33776d41)));
+	QVERIFY(!set.contains(2));
+}
+
+void tst_KeySet::zeroKey()
+{
+	KeySet set;
+	QVERIFY(!set.contains(0));
+	QVERIFY(set.insert(0));
+	QVERIFY(!set.insert(0));
+	QVERIFY(set.contains(0));
+	QCOMPARE(set.size(), qint64(1));
+}
+
+void tst_KeySet::collisions()
+{
+	// Keys that differ only in their high bits
+	KeySet set;
+	for (quint64 i = 1; i <= 5000; i++)
+		QVERIFY(set.insert(i << 48));
+	for (quint64 i = 1; i <= 5000; i++)
+		QVERIFY(!set.insert(i << 48));
+
+	QCOMPARE(set.size(), qint64(5000));
+	QVERIFY(set.contains(quint64(1234) << 48));
+	QVERIFY(!set.contains(quint64(1234) << 47));
+}
+
+void tst_KeySet::growth()
+{
+	KeySet set;
+	set.reserve(100);
+
+	quint64 x = 1;
+	QList<quint64> keys;
+	for (int i = 0; i < 100000; i++)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		keys << x;
+		QVERIFY(set.insert(x));
+	}
+
+	QCOMPARE(set.size(), qint64(keys.size()));
+	for (quint64 key : keys)
+		QVERIFY(set.contains(key));
+	QVERIFY(!set.contains(2));
+}
+
+void tst_KeySet::clear()
+{
+	KeySet set;
+	set.insert(0);
+	set.insert(10);
+	set.clear();
+
+	QCOMPARE(set.size(), qint64(0));
+	QVERIFY(!set.contains(0));
+	QVERIFY(!set.contains(10));
+	QVERIFY(set.insert(10));
+}
+
+QTEST_MAIN(tst_KeySet)
+#include "tst_keyset.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_memorystats
+SOURCES += tst_memorystats.cpp
@@ -0,0 +1,68 @@
+#include <QtTest/QtTest>
+#include <memorystats.h>
+
+class tst_MemoryStats: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void account() const;
+		void copy() const;
+		void names() const;
+};
+
+void tst_MemoryStats::account() const
+{
+	const auto subsystem = MemoryStats::EcoTree;
+	const qint64 start = MemoryStats::current(subsystem);
+	{
+		MemoryAccount account(subsystem);
+		QCOMPARE(account.bytes(), Q_INT64_C(0));
+
+		account.setBytes(1000);
+		QCOMPARE(MemoryStats::current(subsystem), start + 1000);
+		account.setBytes(400);
+		QCOMPARE(MemoryStats::current(subsystem), start + 400);
+		QVERIFY(MemoryStats::peak(subsystem) >= start + 1000);
+	}
+
+	// The bytes are released with the account
+	QCOMPARE(MemoryStats::current(subsystem), start);
+	QVERIFY(MemoryStats::peak(subsystem) >= start + 1000);
+}
+
+void tst_MemoryStats::copy() const
+{
+	const auto subsystem = MemoryStats::Books;
+	const qint64 start = MemoryStats::current(subsystem);
+
+	MemoryAccount account(subsystem);
+	account.setBytes(300);
+	{
+		MemoryAccount copy(account);
+		QCOMPARE(copy.bytes(), Q_INT64_C(300));
+		QCOMPARE(MemoryStats::current(subsystem), start + 600);
+
+		MemoryAccount other(subsystem);
+		other.setBytes(50);
+		other = account;
+		QCOMPARE(MemoryStats::current(subsystem), start + 900);
+	}
+	QCOMPARE(MemoryStats::current(subsystem), start + 300);
+	QVERIFY(MemoryStats::total() >= start + 300);
+}
+
+void tst_MemoryStats::names() const
+{
+	QStringList names;
+	for (int i = 0; i < MemoryStats::SubsystemCount; i++)
+	{
+		const QString name = MemoryStats::name(MemoryStats::Subsystem(i));
+		QVERIFY(!name.isEmpty());
+		QVERIFY(!names.contains(name));
+		names << name;
+	}
+}
+
+QTEST_MAIN(tst_MemoryStats)
+#include "tst_memorystats.moc"
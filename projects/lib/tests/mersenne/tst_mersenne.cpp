@@ -1,6 +1,19 @@
 #include <QtTest/QtTest>
+#include <QThread>
 #include <mersenne.h>
 
+class RandomThread : public QThread
+{
+	public:
+		quint32 number;
+
+	protected:
+		virtual void run()
+		{
+			number = Mersenne::random();
+		}
+};
+
 class tst_Mersenne: public QObject
 {
 	Q_OBJECT
@@ -8,6 +21,7 @@ class tst_Mersenne: public QObject
 	private slots:
 		void numbers_data();
 		void numbers();
+		void threads();
 };
 
 void tst_Mersenne::numbers_data()
@@ -38,6 +52,27 @@ void tst_Mersenne::numbers()
 	QCOMPARE(Mersenne::random(), random2);
 }
 
+void tst_Mersenne::threads()
+{
+	Mersenne::initialize(0);
+
+	// Another thread has a stream of its own...
+	RandomThread thread;
+	thread.start();
+	thread.wait();
+	QCOMPARE(Mersenne::random(), quint32(2357136044U));
+	QVERIFY(thread.number != quint32(2357136044U));
+
+	// ...which is the same after reseeding
+	quint32 first = thread.number;
+	Mersenne::initialize(0);
+	RandomThread thread2;
+	thread2.start();
+	thread2.wait();
+	QCOMPARE(thread2.number, first);
+	QCOMPARE(Mersenne::random(), quint32(2357136044U));
+}
+
 
 QTEST_MAIN(tst_Mersenne)
 #include "tst_mersenne.moc"
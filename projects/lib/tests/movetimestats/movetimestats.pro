@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_movetimestats
+SOURCES += tst_movetimestats.cpp
@@ -0,0 +1,78 @@
+#include <QtTest/QtTest>
+#include <movetimestats.h>
+
+class tst_MoveTimeStats: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void empty() const;
+		void moveTimes() const;
+		void overhead() const;
+		void add() const;
+};
+
+void tst_MoveTimeStats::empty() const
+{
+	MoveTimeStats stats;
+	QCOMPARE(stats.moveCount(), 0);
+	QCOMPARE(stats.minTimeLeft(), -1);
+	QCOMPARE(stats.overheadCount(), 0);
+
+	// Moves without a clock aren't counted
+	stats.addMove(0, 100, 0);
+	QCOMPARE(stats.moveCount(), 0);
+}
+
+void tst_MoveTimeStats::moveTimes() const
+{
+	MoveTimeStats stats;
+	stats.addMove(10000, 50, 0);
+	stats.addMove(10000, 1500, 0);
+	stats.addMove(1000, 950, 0);
+	stats.addMove(1000, 1200, 0);
+
+	QCOMPARE(stats.moveCount(), 4);
+	QCOMPARE(stats.timeBucket(0), 1);
+	QCOMPARE(stats.timeBucket(4), 1);
+	QCOMPARE(stats.timeBucket(MoveTimeStats::BucketCount - 1), 2);
+	QCOMPARE(stats.nearForfeits(), 2);
+	QCOMPARE(stats.minTimeLeft(), 0);
+	QCOMPARE(stats.overheadCount(), 0);
+	QVERIFY(qAbs(stats.timeFractionSum() - 2.305) < 1e-9);
+}
+
+void tst_MoveTimeStats::overhead() const
+{
+	MoveTimeStats stats;
+	stats.addMove(60000, 1000, 1000);
+	stats.addMove(60000, 1000, 997);
+	stats.addMove(60000, 1000, 900);
+	stats.addMove(60000, 1000, 1010);
+
+	QCOMPARE(stats.overheadCount(), 4);
+	QCOMPARE(stats.overheadBucket(0), 2);
+	QCOMPARE(stats.overheadBucket(2), 1);
+	QCOMPARE(stats.overheadBucket(MoveTimeStats::BucketCount - 1), 1);
+	QCOMPARE(stats.overheadSum(), qint64(103));
+	QCOMPARE(stats.maxOverhead(), 100);
+}
+
+void tst_MoveTimeStats::add() const
+{
+	MoveTimeStats stats1;
+	stats1.addMove(10000, 100, 90);
+	MoveTimeStats stats2;
+	stats2.addMove(5000, 4950, 0);
+
+	stats1.add(stats2);
+	stats1.add(MoveTimeStats());
+	QCOMPARE(stats1.moveCount(), 2);
+	QCOMPARE(stats1.nearForfeits(), 1);
+	QCOMPARE(stats1.minTimeLeft(), 50);
+	QCOMPARE(stats1.overheadCount(), 1);
+	QCOMPARE(stats1.maxOverhead(), 10);
+}
+
+QTEST_MAIN(tst_MoveTimeStats)
+#include "tst_movetimestats.moc"
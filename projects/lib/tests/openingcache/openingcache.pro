@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_openingcache
+SOURCES += tst_openingcache.cpp
@@ -0,0 +1,115 @@
+#include <QtTest/QtTest>
+#include <openingcache.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+class tst_OpeningCache: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void findAndInsert() const;
+		void capacity() const;
+		void snapshot() const;
+
+	private:
+		OpeningCache::Entry entry(const QString& fen) const;
+};
+
+OpeningCache::Entry tst_OpeningCache::entry(const QString& fen) const
+{
+	OpeningCache::Entry entry;
+	entry.startingFen = fen;
+	return entry;
+}
+
+void tst_OpeningCache::findAndInsert() const
+{
+	OpeningCache cache;
+	OpeningCache::Entry found;
+	QVERIFY(!cache.find(1, &found));
+
+	cache.insert(1, entry("a"));
+	cache.insert(2, entry("b"));
+	QCOMPARE(cache.size(), 2);
+	QVERIFY(cache.find(1, &found));
+	QCOMPARE(found.startingFen, QString("a"));
+
+	cache.insert(1, entry("c"));
+	QCOMPARE(cache.size(), 2);
+	QVERIFY(cache.find(1, &found));
+	QCOMPARE(found.startingFen, QString("c"));
+	QCOMPARE(cache.hitCount(), 2);
+
+	cache.clear();
+	QCOMPARE(cache.size(), 0);
+	QCOMPARE(cache.hitCount(), 0);
+	QVERIFY(!cache.find(2, &found));
+}
+
+void tst_OpeningCache::capacity() const
+{
+	OpeningCache cache(2);
+	QCOMPARE(cache.capacity(), 2);
+
+	cache.insert(1, entry("a"));
+	cache.insert(2, entry("b"));
+	OpeningCache::Entry found;
+	QVERIFY(cache.find(1, &found));
+
+	// The least recently used opening is dropped first
+	cache.insert(3, entry("c"));
+	QCOMPARE(cache.size(), 2);
+	QVERIFY(cache.find(1, &found));
+	QVERIFY(!cache.find(2, &found));
+	QVERIFY(cache.find(3, &found));
+
+	cache.setCapacity(1);
+	QCOMPARE(cache.size(), 1);
+	QVERIFY(cache.find(3, &found));
+}
+
+void tst_OpeningCache::snapshot() const
+{
+	Chess::Board* board = Chess::BoardFactory::create("standard");
+	QVERIFY(board != nullptr);
+	board->reset();
+
+	OpeningCache::Entry opening;
+	const QStringList moves = QStringList() << "e4" << "e5" << "Nf3";
+	for (const QString& str : moves)
+	{
+		const Chess::Move move(board->moveFromString(str));
+		QVERIFY(!move.isNull());
+
+		PgnGame::MoveData md;
+		md.key = board->key();
+		md.move = board->genericMove(move);
+		md.moveString = str;
+		opening.moves.append(move);
+		opening.pgnMoves.append(md);
+		board->makeMove(move);
+	}
+	opening.position = board->snapshot();
+	const QString fen(board->fenString());
+	const quint64 key = board->key();
+
+	OpeningCache cache;
+	cache.insert(0, opening);
+	board->reset();
+
+	OpeningCache::Entry found;
+	QVERIFY(cache.find(0, &found));
+	QVERIFY(found.moves == opening.moves);
+	QCOMPARE(found.pgnMoves.size(), 3);
+	QCOMPARE(found.pgnMoves.at(2).moveString, QString("Nf3"));
+	QCOMPARE(found.position.key(), key);
+
+	QVERIFY(board->restore(found.position));
+	QCOMPARE(board->fenString(), fen);
+	QCOMPARE(board->plyCount(), 3);
+	delete board;
+}
+
+QTEST_MAIN(tst_OpeningCache)
+#include "tst_openingcache.moc"
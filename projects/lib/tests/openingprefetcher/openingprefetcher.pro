@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_openingprefetcher
+SOURCES += tst_openingprefetcher.cpp
@@ -0,0 +1,76 @@
+#include <QtTest/QtTest>
+#include <openingprefetcher.h>
+#include <openingsuite.h>
+
+class tst_OpeningPrefetcher: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void sequential();
+		void restart();
+
+	private:
+		bool writeSuite(QTemporaryFile& file) const;
+};
+
+static const char s_fen1[] =
+	"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq -";
+static const char s_fen2[] =
+	"rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq -";
+
+bool tst_OpeningPrefetcher::writeSuite(QTemporaryFile& file) const
+{
+	if (!file.open())
+		return false;
+
+	// The second position is invalid and should be skipped
+	QTextStream out(&file);
+	out << s_fen1 << "\n"
+	    << "rnbqkbnr/pppppppp/8 w KQkq -\n"
+	    << s_fen2 << "\n";
+	out.flush();
+	file.close();
+
+	return true;
+}
+
+void tst_OpeningPrefetcher::sequential()
+{
+	QTemporaryFile file;
+	QVERIFY(writeSuite(file));
+
+	OpeningSuite suite(file.fileName(), OpeningSuite::EpdFormat);
+	QVERIFY(suite.initialize());
+
+	OpeningPrefetcher prefetcher(&suite, "standard", 10);
+	prefetcher.setQueueSize(1);
+
+	QCOMPARE(prefetcher.takeOpening().startingFenString(), QString(s_fen1));
+	QCOMPARE(prefetcher.takeOpening().startingFenString(), QString(s_fen2));
+	// The suite starts over at the end
+	QCOMPARE(prefetcher.takeOpening().startingFenString(), QString(s_fen1));
+
+	prefetcher.stop();
+	QVERIFY(!prefetcher.isRunning());
+}
+
+void tst_OpeningPrefetcher::restart()
+{
+	QTemporaryFile file;
+	QVERIFY(writeSuite(file));
+
+	OpeningSuite suite(file.fileName(), OpeningSuite::EpdFormat);
+	QVERIFY(suite.initialize());
+
+	OpeningPrefetcher prefetcher(&suite, "standard", 10);
+	QVERIFY(!prefetcher.takeOpening().startingFenString().isEmpty());
+	prefetcher.stop();
+
+	// Taking an opening after stop() starts the thread again
+	QVERIFY(!prefetcher.takeOpening().startingFenString().isEmpty());
+	QVERIFY(prefetcher.isRunning());
+}
+
+QTEST_MAIN(tst_OpeningPrefetcher)
+#include "tst_openingprefetcher.moc"
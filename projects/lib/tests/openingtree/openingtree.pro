@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_openingtree
+SOURCES += tst_openingtree.cpp
@@ -0,0 +1,158 @@
+#include <QtTest/QtTest>
+#include <openingtree.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+#include <board/board.h>
+
+class tst_OpeningTree: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void find();
+		void maxPly();
+		void sourceModified();
+
+	private:
+		bool writeTree(OpeningTreeWriter& writer,
+			       const QString& fileName);
+
+		QTemporaryDir m_dir;
+		QString m_pgnFileName;
+		QString m_treeFileName;
+		QVector<PgnGame> m_games;
+		QVector<quint64> m_finalKeys;
+};
+
+static const OpeningTree::Continuation* findMove(
+	const QVector<OpeningTree::Continuation>& moves, quint64 childKey)
+{
+	for (const OpeningTree::Continuation& move : moves)
+	{
+		if (move.childKey == quint32(childKey))
+			return &move;
+	}
+	return nullptr;
+}
+
+bool tst_OpeningTree::writeTree(OpeningTreeWriter& writer,
+				const QString& fileName)
+{
+	for (int i = 0; i < m_games.size(); i++)
+		writer.addGame(m_games.at(i), m_finalKeys.at(i));
+	return writer.write(fileName, m_pgnFileName);
+}
+
+void tst_OpeningTree::initTestCase()
+{
+	// Game 4 is unfinished and game 5 repeats 1. Nf3
+	const QByteArray pgn(
+		"[WhiteElo \"2000\"]\n[BlackElo \"2200\"]\n\n1. e4 e5 1-0\n\n"
+		"[WhiteElo \"2400\"]\n\n1. e4 c5 0-1\n\n"
+		"[Event \"2\"]\n\n1. d4 d5 1/2-1/2\n\n"
+		"[Event \"3\"]\n\n1. e4 e5 2. Nf3 1/2-1/2\n\n"
+		"[Event \"4\"]\n\n1. e4 *\n\n"
+		"[Event \"5\"]\n\n1. Nf3 Nf6 2. Ng1 Ng8 3. Nf3 1-0\n");
+
+	QVERIFY(m_dir.isValid());
+	m_pgnFileName = m_dir.path() + "/games.pgn";
+	m_treeFileName = m_dir.path() + "/games.cot";
+
+	QFile file(m_pgnFileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	QCOMPARE(file.write(pgn), qint64(pgn.size()));
+	file.close();
+
+	PgnStream stream(&pgn);
+	PgnGame game;
+	while (game.read(stream, INT_MAX - 1, false))
+	{
+		m_games.append(game);
+		m_finalKeys.append(stream.board()->key());
+	}
+	QCOMPARE(m_games.size(), 6);
+
+	// A tiny buffer makes the writer merge several runs
+	OpeningTreeWriter writer(40, 2);
+	QVERIFY(writeTree(writer, m_treeFileName));
+}
+
+void tst_OpeningTree::find()
+{
+	OpeningTree tree;
+	QVERIFY(tree.open(m_treeFileName, m_pgnFileName));
+
+	// The start position: 1. e4, 1. d4 and 1. Nf3
+	const quint64 startKey = m_games.at(0).moves().at(0).key;
+	auto moves = tree.find(startKey);
+	QCOMPARE(moves.size(), 3);
+
+	auto move = findMove(moves, m_games.at(0).moves().at(1).key);
+	QVERIFY(move != nullptr);
+	QCOMPARE(move->games, quint32(3));
+	QCOMPARE(move->whiteWins, quint32(1));
+	QCOMPARE(move->draws, quint32(1));
+	QCOMPARE(move->blackWins(), quint32(1));
+	QCOMPARE(move->eloGames, quint32(2));
+	QCOMPARE(move->averageElo(), 2200);
+
+	move = findMove(moves, m_games.at(2).moves().at(1).key);
+	QVERIFY(move != nullptr);
+	QCOMPARE(move->games, quint32(1));
+	QCOMPARE(move->draws, quint32(1));
+	QCOMPARE(move->averageElo(), 0);
+
+	// Repeated moves are counted once per game
+	move = findMove(moves, m_games.at(5).moves().at(1).key);
+	QVERIFY(move != nullptr);
+	QCOMPARE(move->games, quint32(1));
+	QCOMPARE(move->whiteWins, quint32(1));
+
+	// After 1. e4: 1... e5 and 1... c5
+	moves = tree.find(m_games.at(0).moves().at(1).key);
+	QCOMPARE(moves.size(), 2);
+	move = findMove(moves, m_finalKeys.at(0));
+	QVERIFY(move != nullptr);
+	QCOMPARE(move->games, quint32(2));
+	QCOMPARE(move->eloGames, quint32(1));
+	QCOMPARE(move->averageElo(), 2200);
+	move = findMove(moves, m_finalKeys.at(1));
+	QVERIFY(move != nullptr);
+	QCOMPARE(move->blackWins(), quint32(1));
+
+	// The last move of a game leads to its final position
+	moves = tree.find(m_finalKeys.at(0));
+	QCOMPARE(moves.size(), 1);
+	QCOMPARE(moves.at(0).childKey, quint32(m_finalKeys.at(3)));
+
+	QVERIFY(tree.find(0).isEmpty());
+	QCOMPARE(tree.size(), qint64(3 + 2 + 1 + 1 + 3));
+}
+
+void tst_OpeningTree::maxPly()
+{
+	const QString fileName(m_dir.path() + "/maxply.cot");
+	OpeningTreeWriter writer(1);
+	QVERIFY(writeTree(writer, fileName));
+
+	OpeningTree tree;
+	QVERIFY(tree.open(fileName, m_pgnFileName));
+	QCOMPARE(tree.size(), qint64(3));
+	QVERIFY(tree.find(m_games.at(0).moves().at(1).key).isEmpty());
+}
+
+void tst_OpeningTree::sourceModified()
+{
+	QFile file(m_pgnFileName);
+	QVERIFY(file.open(QIODevice::Append));
+	QVERIFY(file.write("\n") == 1);
+	file.close();
+
+	OpeningTree tree;
+	QVERIFY(!tree.open(m_treeFileName, m_pgnFileName));
+	QVERIFY(!tree.isOpen());
+}
+
+QTEST_MAIN(tst_OpeningTree)
+#include "tst_openingtree.moc"
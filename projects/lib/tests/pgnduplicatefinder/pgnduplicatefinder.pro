@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgnduplicatefinder
+SOURCES += tst_pgnduplicatefinder.cpp
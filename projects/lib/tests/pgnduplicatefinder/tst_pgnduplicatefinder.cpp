@@ -0,0 +1,155 @@
+#include <QtTest/QtTest>
+#include <pgnduplicatefinder.h>
+#include <pgngameentry.h>
+#include <pgntagpool.h>
+#include <pgnstream.h>
+
+class tst_PgnDuplicateFinder: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+		void moveHash();
+		void duplicates();
+		void manyGroups();
+
+	private:
+		QTemporaryDir m_dir;
+		QString m_fileName;
+		PgnTagPool m_pool;
+		QList<const PgnGameEntry*> m_entries;
+};
+
+static QList<const PgnGameEntry*> readEntries(const QByteArray& pgn,
+					      PgnTagPool* pool)
+{
+	QList<const PgnGameEntry*> entries;
+	PgnStream stream(&pgn);
+	auto entry = new PgnGameEntry(pool);
+	while (entry->read(stream))
+	{
+		entries.append(entry);
+		entry = new PgnGameEntry(pool);
+	}
+	delete entry;
+
+	return entries;
+}
+
+static bool writeFile(const QString& fileName, const QByteArray& data)
+{
+	QFile file(fileName);
+	return file.open(QIODevice::WriteOnly)
+	    && file.write(data) == data.size();
+}
+
+void tst_PgnDuplicateFinder::initTestCase()
+{
+	const QByteArray pgn(
+		"[White \"A\"]\n[Black \"B\"]\n\n1. e4 e5 2. Nf3 Nc6 *\n\n"
+		"[White \"A\"]\n[Black \"B\"]\n\n"
+		"1.e4 {book} e5 2.Nf3!? (2. Nc3 Nf6) Nc6 $1 1-0\n\n"
+		"[White \"C\"]\n[Black \"B\"]\n\n1. e4 e5 2. Nf3 Nc6 *\n\n"
+		"[White \"A\"]\n[Black \"B\"]\n\n1. d4 d5 *\n\n"
+		"[White \"A\"]\n[Black \"B\"]\n\n*\n\n"
+		"[White \"A\"]\n[Black \"B\"]\n\n1. e4 e5 2. Nf3 Nc6 0-1\n");
+
+	QVERIFY(m_dir.isValid());
+	m_fileName = m_dir.path() + "/games.pgn";
+	QVERIFY(writeFile(m_fileName, pgn));
+
+	m_entries = readEntries(pgn, &m_pool);
+	QCOMPARE(m_entries.size(), 6);
+}
+
+void tst_PgnDuplicateFinder::cleanupTestCase()
+{
+	qDeleteAll(m_entries);
+}
+
+void tst_PgnDuplicateFinder::moveHash()
+{
+	// Move numbers, comments, variations and results are ignored
+	const quint64 hash = m_entries.at(0)->moveHash();
+	QVERIFY(hash != 0);
+	QCOMPARE(m_entries.at(1)->moveHash(), hash);
+	QCOMPARE(m_entries.at(2)->moveHash(), hash);
+	QCOMPARE(m_entries.at(5)->moveHash(), hash);
+	QVERIFY(m_entries.at(3)->moveHash() != hash);
+	QVERIFY(m_entries.at(3)->moveHash() != 0);
+	QCOMPARE(m_entries.at(4)->moveHash(), quint64(0));
+
+	// The tags of the next game are still read
+	QCOMPARE(m_entries.at(2)->tagValue(PgnGameEntry::WhiteTag),
+		 QString("C"));
+}
+
+void tst_PgnDuplicateFinder::duplicates()
+{
+	PgnDuplicateFinder finder;
+	for (const PgnGameEntry* entry : m_entries)
+		finder.addGame(m_fileName, entry->pos(), entry->lineNumber(),
+			       entry->moveHash());
+	QCOMPARE(finder.gameCount(), m_entries.size());
+
+	// The game with other players isn't a duplicate
+	QCOMPARE(finder.run(), 2);
+	QCOMPARE(finder.originalOf(0), -1);
+	QCOMPARE(finder.originalOf(1), 0);
+	QCOMPARE(finder.originalOf(2), -1);
+	QCOMPARE(finder.originalOf(3), -1);
+	QCOMPARE(finder.originalOf(4), -1);
+	QCOMPARE(finder.originalOf(5), 0);
+	QVERIFY(finder.isDuplicate(5));
+	QVERIFY(!finder.isDuplicate(2));
+}
+
+void tst_PgnDuplicateFinder::manyGroups()
+{
+	// Enough candidate groups to be confirmed by several threads,
+	// in two files
+	QByteArray pgn[2];
+	const char* moves[4][8] = {
+		{ "a3", "a4", "b3", "b4", "c3", "c4", "d3", "d4" },
+		{ "a6", "a5", "b6", "b5", "c6", "c5", "d6", "d5" },
+		{ "e3", "e4", "f3", "f4", "g3", "g4", "h3", "h4" },
+		{ "e6", "e5", "f6", "f5", "g6", "g5", "h6", "h5" }
+	};
+	for (int i = 0; i < 2000; i++)
+	{
+		const QByteArray game = QByteArray("[White \"W")
+			+ QByteArray::number(i) + "\"]\n\n1. "
+			+ moves[0][i % 8] + ' ' + moves[1][i / 8 % 8] + " 2. "
+			+ moves[2][i / 64 % 8] + ' ' + moves[3][i / 512] + " *\n\n";
+		pgn[0] += game;
+		if (i % 2 == 0)
+			pgn[1] += game;
+	}
+
+	PgnDuplicateFinder finder;
+	PgnTagPool pool;
+	for (int i = 0; i < 2; i++)
+	{
+		const QString fileName(m_dir.path()
+			+ QString("/many%1.pgn").arg(i));
+		QVERIFY(writeFile(fileName, pgn[i]));
+		const auto entries = readEntries(pgn[i], &pool);
+		for (const PgnGameEntry* entry : entries)
+			finder.addGame(fileName, entry->pos(),
+				       entry->lineNumber(), entry->moveHash());
+		qDeleteAll(entries);
+	}
+
+	// Every game of the second file repeats one of the first
+	QCOMPARE(finder.gameCount(), 3000);
+	QCOMPARE(finder.run(), 1000);
+	for (int i = 0; i < 1000; i++)
+		QCOMPARE(finder.originalOf(2000 + i), 2 * i);
+	for (int i = 0; i < 2000; i++)
+		QVERIFY(!finder.isDuplicate(i));
+}
+
+QTEST_MAIN(tst_PgnDuplicateFinder)
+#include "tst_pgnduplicatefinder.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgnentryindex
+SOURCES += tst_pgnentryindex.cpp
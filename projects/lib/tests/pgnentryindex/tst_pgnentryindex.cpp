@@ -0,0 +1,145 @@
+#include <QtTest/QtTest>
+#include <pgnentryindex.h>
+#include <pgngameentry.h>
+#include <pgntagpool.h>
+#include <pgnstream.h>
+
+class tst_PgnEntryIndex: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+		void entries();
+		void sortedRows();
+		void readEntries();
+		void sourceModified();
+
+	private:
+		QTemporaryDir m_dir;
+		QString m_pgnFileName;
+		QString m_indexFileName;
+		PgnTagPool m_pool;
+		QList<const PgnGameEntry*> m_entries;
+};
+
+void tst_PgnEntryIndex::initTestCase()
+{
+	const QByteArray pgn(
+		"[Event \"b\"]\n[White \"carlsen\"]\n[Black \"Anand\"]\n\n1. e4 *\n\n"
+		"[Event \"a\"]\n[White \"Anand\"]\n[Black \"Carlsen\"]\n\n1. d4 *\n\n"
+		"[Event \"b\"]\n[White \"Zeta\"]\n\n1. c4 *\n\n"
+		"[Event \"a\"]\n[White \"anand\"]\n[Black \"Carlsen\"]\n\n1. Nf3 *\n");
+
+	QVERIFY(m_dir.isValid());
+	m_pgnFileName = m_dir.path() + "/games.pgn";
+	m_indexFileName = m_dir.path() + "/games.cei";
+
+	QFile file(m_pgnFileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	QCOMPARE(file.write(pgn), qint64(pgn.size()));
+	file.close();
+
+	PgnStream stream(&pgn);
+	auto entry = new PgnGameEntry(&m_pool);
+	while (entry->read(stream))
+	{
+		m_entries.append(entry);
+		entry = new PgnGameEntry(&m_pool);
+	}
+	delete entry;
+	QCOMPARE(m_entries.size(), 4);
+	QVERIFY(PgnEntryIndex::write(m_indexFileName, m_entries,
+				     m_pgnFileName));
+}
+
+void tst_PgnEntryIndex::cleanupTestCase()
+{
+	qDeleteAll(m_entries);
+}
+
+void tst_PgnEntryIndex::entries()
+{
+	PgnEntryIndex index;
+	QVERIFY(index.open(m_indexFileName, m_pgnFileName));
+	QCOMPARE(index.count(), m_entries.size());
+
+	for (int i = 0; i < m_entries.size(); i++)
+	{
+		const PgnGameEntry* entry = m_entries.at(i);
+		QCOMPARE(index.pos(i), entry->pos());
+		QCOMPARE(index.lineNumber(i), entry->lineNumber());
+		QVERIFY(entry->moveHash() != 0);
+		QCOMPARE(index.moveHash(i), entry->moveHash());
+
+		for (int j = 0; j <= PgnGameEntry::VariantTag; j++)
+		{
+			const auto type = PgnGameEntry::TagType(j);
+			QCOMPARE(index.tagValue(i, type), entry->tagValue(type));
+		}
+	}
+	QVERIFY(index.tagValue(2, PgnGameEntry::BlackTag).isEmpty());
+}
+
+void tst_PgnEntryIndex::sortedRows()
+{
+	PgnEntryIndex index;
+	QVERIFY(index.open(m_indexFileName, m_pgnFileName));
+
+	// The sort is case insensitive and keeps the order of equal tags
+	const int white[] = { 1, 3, 0, 2 };
+	const int black[] = { 2, 0, 1, 3 };
+	const int event[] = { 1, 3, 0, 2 };
+	for (int i = 0; i < 4; i++)
+	{
+		QCOMPARE(index.sortedRow(PgnGameEntry::WhiteTag, i), white[i]);
+		QCOMPARE(index.sortedRow(PgnGameEntry::BlackTag, i), black[i]);
+		QCOMPARE(index.sortedRow(PgnGameEntry::EventTag, i), event[i]);
+		QCOMPARE(index.sortedRow(PgnGameEntry::VariantTag, i), i);
+	}
+}
+
+void tst_PgnEntryIndex::readEntries()
+{
+	PgnEntryIndex index;
+	QVERIFY(index.open(m_indexFileName, m_pgnFileName));
+
+	// A pool that already has values gives the tags new IDs
+	PgnTagPool pool;
+	pool.intern("foo");
+	const auto entries = index.entries(&pool);
+	QCOMPARE(entries.size(), m_entries.size());
+
+	for (int i = 0; i < entries.size(); i++)
+	{
+		const PgnGameEntry* entry = entries.at(i);
+		QCOMPARE(entry->tagPool(), &pool);
+		QCOMPARE(entry->pos(), m_entries.at(i)->pos());
+		QCOMPARE(entry->lineNumber(), m_entries.at(i)->lineNumber());
+		QCOMPARE(entry->moveHash(), m_entries.at(i)->moveHash());
+
+		for (int j = 0; j <= PgnGameEntry::VariantTag; j++)
+		{
+			const auto type = PgnGameEntry::TagType(j);
+			QCOMPARE(entry->tagValue(type),
+				 m_entries.at(i)->tagValue(type));
+		}
+	}
+	qDeleteAll(entries);
+}
+
+void tst_PgnEntryIndex::sourceModified()
+{
+	QFile file(m_pgnFileName);
+	QVERIFY(file.open(QIODevice::Append));
+	QVERIFY(file.write("\n") == 1);
+	file.close();
+
+	PgnEntryIndex index;
+	QVERIFY(!index.open(m_indexFileName, m_pgnFileName));
+	QVERIFY(!index.isOpen());
+}
+
+QTEST_MAIN(tst_PgnEntryIndex)
+#include "tst_pgnentryindex.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgntaglist
+SOURCES += tst_pgntaglist.cpp
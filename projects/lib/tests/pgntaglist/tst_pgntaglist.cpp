@@ -0,0 +1,95 @@
+#include <QtTest/QtTest>
+#include <pgntaglist.h>
+
+typedef QList< QPair<QString, QString> > TagPairs;
+
+class tst_PgnTagList: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void empty() const;
+		void roster() const;
+		void order() const;
+		void remove() const;
+		void copy() const;
+};
+
+void tst_PgnTagList::empty() const
+{
+	PgnTagList tags;
+	QVERIFY(tags.isEmpty());
+	QVERIFY(!tags.contains("Event"));
+	QVERIFY(tags.value("FEN").isEmpty());
+
+	const TagPairs list(tags.toList());
+	QCOMPARE(list.size(), int(PgnTagList::RosterSize));
+	QCOMPARE(list.first(), qMakePair(QString("Event"), QString("?")));
+	QCOMPARE(list.last(), qMakePair(QString("Result"), QString("?")));
+
+	// Removing a tag that doesn't exist adds nothing
+	tags.setValue("NoSuchTag", QString());
+	QVERIFY(tags.isEmpty());
+}
+
+void tst_PgnTagList::roster() const
+{
+	PgnTagList tags;
+	tags.setValue("White", "Alice");
+	tags.setValue(PgnTagList::Result, "1-0");
+
+	QVERIFY(!tags.isEmpty());
+	QCOMPARE(tags.value(PgnTagList::White), QString("Alice"));
+	QCOMPARE(tags.value("Result"), QString("1-0"));
+	QCOMPARE(PgnTagList::tagId("Black"), int(PgnTagList::Black));
+	QCOMPARE(PgnTagList::tagName(PgnTagList::Site), QString("Site"));
+}
+
+void tst_PgnTagList::order() const
+{
+	PgnTagList tags;
+	tags.setValue("Variant", "atomic");
+	tags.setValue("ECO", "B01");
+	tags.setValue("Event", "Test");
+	tags.setValue("FEN", "8/8/8/8/8/8/8/8 w - - 0 1");
+
+	const TagPairs list(tags.toList());
+	QCOMPARE(list.size(), PgnTagList::RosterSize + 3);
+	QCOMPARE(list.at(0).second, QString("Test"));
+	QCOMPARE(list.at(PgnTagList::RosterSize).first, QString("ECO"));
+	QCOMPARE(list.at(PgnTagList::RosterSize + 1).first, QString("FEN"));
+	QCOMPARE(list.at(PgnTagList::RosterSize + 2).first, QString("Variant"));
+}
+
+void tst_PgnTagList::remove() const
+{
+	PgnTagList tags;
+	tags.setValue("ECO", "B01");
+	tags.setValue("Site", "Here");
+	QVERIFY(tags.contains("ECO"));
+
+	tags.setValue("ECO", QString());
+	tags.setValue("Site", QString());
+	QVERIFY(!tags.contains("ECO"));
+	QVERIFY(tags.isEmpty());
+	QCOMPARE(tags.toList().size(), int(PgnTagList::RosterSize));
+}
+
+void tst_PgnTagList::copy() const
+{
+	PgnTagList a;
+	a.setValue("Event", "Test");
+	a.setValue("ECO", "B01");
+
+	PgnTagList b(a);
+	b.setValue("ECO", "C00");
+	b.setValue("Event", QString());
+
+	QCOMPARE(a.value("ECO"), QString("B01"));
+	QCOMPARE(a.value(PgnTagList::Event), QString("Test"));
+	QCOMPARE(b.value("ECO"), QString("C00"));
+	QVERIFY(b.value(PgnTagList::Event).isEmpty());
+}
+
+QTEST_MAIN(tst_PgnTagList)
+#include "tst_pgntaglist.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgntagpool
+SOURCES += tst_pgntagpool.cpp
@@ -0,0 +1,74 @@
+#include <QtTest/QtTest>
+#include <pgntagpool.h>
+
+class tst_PgnTagPool: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void find_data() const;
+		void find() const;
+		void intern() const;
+};
+
+void tst_PgnTagPool::find_data() const
+{
+	QTest::addColumn<QByteArray>("value");
+	QTest::addColumn<QByteArray>("pattern");
+	QTest::addColumn<bool>("matches");
+
+	QTest::newRow("empty pattern") << QByteArray("Carlsen") << QByteArray() << true;
+	QTest::newRow("exact") << QByteArray("Carlsen") << QByteArray("Carlsen") << true;
+	QTest::newRow("case") << QByteArray("Carlsen, Magnus") << QByteArray("mAGNUS") << true;
+	QTest::newRow("prefix") << QByteArray("Carlsen") << QByteArray("car") << true;
+	QTest::newRow("too long") << QByteArray("Carl") << QByteArray("Carlsen") << false;
+	QTest::newRow("no match") << QByteArray("Carlsen") << QByteArray("Caruana") << false;
+	QTest::newRow("punctuation") << QByteArray("Nakamura, H.") << QByteArray("A, h.") << true;
+	QTest::newRow("utf-8")
+		<< QByteArray("Ding Li\xc3\xa9ren") << QByteArray("LI\xc3\xa9R") << true;
+	QTest::newRow("utf-8 case")
+		<< QByteArray("Ding Li\xc3\xa9ren") << QByteArray("LI\xc3\x89R") << false;
+	QTest::newRow("past 16 bytes")
+		<< QByteArray("Tata Steel Masters Wijk aan Zee")
+		<< QByteArray("wijk AAN zee") << true;
+	QTest::newRow("across 16 bytes")
+		<< QByteArray("Tata Steel Masters Wijk aan Zee")
+		<< QByteArray("masters wijk") << true;
+	QTest::newRow("near miss at the end")
+		<< QByteArray("Tata Steel Masters Wijk aan Zee")
+		<< QByteArray("aan zeer") << false;
+	QTest::newRow("repeated prefix")
+		<< QByteArray("aaaaaaaaaaaaaaaaaaaaaaaaaaaaab")
+		<< QByteArray("AAAB") << true;
+}
+
+void tst_PgnTagPool::find() const
+{
+	QFETCH(QByteArray, value);
+	QFETCH(QByteArray, pattern);
+	QFETCH(bool, matches);
+
+	PgnTagPool pool;
+	const quint32 id = pool.intern(value);
+	const QBitArray bits(pool.find(pattern));
+
+	QCOMPARE(bits.size(), pool.size());
+	QCOMPARE(bits.testBit(int(id)), matches);
+	// The empty string only matches the empty pattern
+	QCOMPARE(bits.testBit(0), pattern.isEmpty());
+}
+
+void tst_PgnTagPool::intern() const
+{
+	PgnTagPool pool;
+	QCOMPARE(pool.intern(QByteArray()), quint32(0));
+
+	const quint32 id = pool.intern("Carlsen");
+	QCOMPARE(pool.intern("Carlsen"), id);
+	QVERIFY(pool.intern("carlsen") != id);
+	QCOMPARE(pool.value(id), QByteArray("Carlsen"));
+	QCOMPARE(pool.size(), 3);
+}
+
+QTEST_MAIN(tst_PgnTagPool)
+#include "tst_pgntagpool.moc"
@@ -34,7 +34,7 @@ void tst_Pipereader::initTestCase()
 	sa.bInheritHandle = TRUE;
 	sa.lpSecurityDescriptor = NULL;
 
-	CreatePipe(&m_read, &m_write, &sa, 0);
+	QVERIFY(PipeReader::createPipe(&m_read, &m_write, &sa));
 
 	m_reader = new PipeReader(m_read, this);
 	m_reader->start();
@@ -47,6 +47,8 @@ void tst_Pipereader::cleanupTestCase()
 
 	while (!spy.count())
 		QTest::qWait(50);
+	QVERIFY(m_reader->isFinished());
+	delete m_reader;
 	CloseHandle(m_read);
 }
 
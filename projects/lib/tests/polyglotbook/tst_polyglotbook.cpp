@@ -1,6 +1,8 @@
 #include <QtTest/QtTest>
 #include <QMap>
 #include <polyglotbook.h>
+#include <mersenne.h>
+#include <openingbookregistry.h>
 #include <board/standardboard.h>
 
 class tst_PolyglotBook: public QObject
@@ -10,6 +12,9 @@ class tst_PolyglotBook: public QObject
 	private slots:
 		void initialValues();
 		void startPos();
+		void weightedMoves_data();
+		void weightedMoves();
+		void registry();
 
 	private:
 		QMap<QString,quint16> entries(const OpeningBook* book,
@@ -72,6 +77,85 @@ void tst_PolyglotBook::startPos()
 
 	entries = this->entries(&book, &board);
 	QCOMPARE(entries, expect);
+
+	// Same test with a mapped book, which is shared by its copies
+	book = PolyglotBook(OpeningBook::Mapped);
+	QVERIFY(book.read("book_small.bin"));
+
+	entries = this->entries(&book, &board);
+	QCOMPARE(entries, expect);
+	QVERIFY(book.entries(1234).isEmpty());
+	QVERIFY(book.entries(Q_UINT64_C(0xffffffffffffffff)).isEmpty());
+
+	const PolyglotBook copy(book);
+	book = PolyglotBook(OpeningBook::Ram);
+	entries = this->entries(&copy, &board);
+	QCOMPARE(entries, expect);
+}
+
+void tst_PolyglotBook::weightedMoves_data()
+{
+	QTest::addColumn<int>("mode");
+
+	QTest::newRow("ram") << int(OpeningBook::Ram);
+	QTest::newRow("disk") << int(OpeningBook::Disk);
+	QTest::newRow("mapped") << int(OpeningBook::Mapped);
+}
+
+void tst_PolyglotBook::weightedMoves()
+{
+	QFETCH(int, mode);
+
+	auto book = PolyglotBook(OpeningBook::AccessMode(mode));
+	QVERIFY(book.read("book_small.bin"));
+
+	Chess::StandardBoard board;
+	board.initialize();
+	board.setFenString(board.defaultFenString());
+	const auto weights = entries(&book, &board);
+
+	// The picks follow the weights of the moves
+	Mersenne::initialize(1);
+	QMap<QString, int> picks;
+	for (int i = 0; i < 2000; i++)
+	{
+		const auto move = board.moveFromGenericMove(book.move(board.key()));
+		QVERIFY(!move.isNull());
+		picks[board.moveString(move, Chess::Board::StandardAlgebraic)]++;
+	}
+	for (auto it = picks.constBegin(); it != picks.constEnd(); ++it)
+		QVERIFY(weights.contains(it.key()));
+	QVERIFY(picks.value("e4") > 600);
+	QVERIFY(picks.value("d4") > 600);
+	QVERIFY(picks.value("b4") < 20);
+
+	QVERIFY(book.move(1234).isNull());
+	QVERIFY(book.move(1234).isNull());
+}
+
+void tst_PolyglotBook::registry()
+{
+	QCOMPARE(OpeningBookRegistry::bookCount(), 0);
+	QVERIFY(OpeningBookRegistry::polyglotBook("foo.bin").isNull());
+
+	auto book1 = OpeningBookRegistry::polyglotBook("book_small.bin");
+	QVERIFY(!book1.isNull());
+	auto book2 = OpeningBookRegistry::polyglotBook("./book_small.bin");
+	QCOMPARE(book2.data(), book1.data());
+	QCOMPARE(OpeningBookRegistry::bookCount(), 1);
+
+	// A different access mode needs its own instance
+	auto book3 = OpeningBookRegistry::polyglotBook("book_small.bin",
+						       OpeningBook::Mapped);
+	QVERIFY(!book3.isNull());
+	QVERIFY(book3.data() != book1.data());
+	QCOMPARE(OpeningBookRegistry::bookCount(), 2);
+
+	book1.clear();
+	QCOMPARE(OpeningBookRegistry::bookCount(), 2);
+	book2.clear();
+	book3.clear();
+	QCOMPARE(OpeningBookRegistry::bookCount(), 0);
 }
 
 QTEST_MAIN(tst_PolyglotBook)
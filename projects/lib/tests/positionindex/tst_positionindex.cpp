@@ -0,0 +1,102 @@
+#include <QtTest/QtTest>
+#include <positionindex.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+#include <board/board.h>
+
+class tst_PositionIndex: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void find();
+		void sourceModified();
+
+	private:
+		QTemporaryDir m_dir;
+		QString m_pgnFileName;
+		QString m_indexFileName;
+		QVector<PgnGame> m_games;
+		QVector<quint64> m_finalKeys;
+};
+
+void tst_PositionIndex::initTestCase()
+{
+	// Games 0 and 1 transpose, and game 3 repeats the start position
+	const QByteArray pgn(
+		"[Event \"0\"]\n\n1. Nf3 Nf6 2. Nc3 *\n\n"
+		"[Event \"1\"]\n\n1. Nc3 Nf6 2. Nf3 *\n\n"
+		"[Event \"2\"]\n\n1. d4 d5 *\n\n"
+		"[Event \"3\"]\n\n1. Nf3 Nf6 2. Ng1 Ng8 3. Nf3 *\n");
+
+	QVERIFY(m_dir.isValid());
+	m_pgnFileName = m_dir.path() + "/games.pgn";
+	m_indexFileName = m_dir.path() + "/games.cpi";
+
+	QFile file(m_pgnFileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	QCOMPARE(file.write(pgn), qint64(pgn.size()));
+	file.close();
+
+	// A tiny run size makes the writer merge several runs
+	PositionIndexWriter writer(2);
+	PgnStream stream(&pgn);
+	PgnGame game;
+	while (game.read(stream, INT_MAX - 1, false))
+	{
+		m_games.append(game);
+		m_finalKeys.append(stream.board()->key());
+		writer.addGame(quint32(m_games.size() - 1), game,
+			       m_finalKeys.last());
+	}
+	QCOMPARE(m_games.size(), 4);
+	QCOMPARE(writer.positionCount(), qint64(4 + 4 + 3 + 4));
+	QVERIFY(writer.write(m_indexFileName, m_pgnFileName));
+}
+
+void tst_PositionIndex::find()
+{
+	PositionIndex index;
+	QVERIFY(index.open(m_indexFileName, m_pgnFileName));
+	QCOMPARE(index.positionCount(), qint64(15));
+
+	auto hits = index.find(m_games.at(0).moves().at(0).key);
+	QCOMPARE(hits.size(), 4);
+	for (int i = 0; i < hits.size(); i++)
+	{
+		QCOMPARE(hits.at(i).game, quint32(i));
+		QCOMPARE(hits.at(i).ply, quint32(0));
+	}
+
+	hits = index.find(m_finalKeys.at(0));
+	QCOMPARE(hits.size(), 2);
+	QCOMPARE(hits.at(0).game, quint32(0));
+	QCOMPARE(hits.at(0).ply, quint32(3));
+	QCOMPARE(hits.at(1).game, quint32(1));
+	QCOMPARE(hits.at(1).ply, quint32(3));
+
+	// The position after 1. Nf3 occurs twice in game 3
+	hits = index.find(m_games.at(0).moves().at(1).key);
+	QCOMPARE(hits.size(), 2);
+	QCOMPARE(hits.at(0).game, quint32(0));
+	QCOMPARE(hits.at(1).game, quint32(3));
+	QCOMPARE(hits.at(1).ply, quint32(1));
+
+	QVERIFY(index.find(0).isEmpty());
+}
+
+void tst_PositionIndex::sourceModified()
+{
+	QFile file(m_pgnFileName);
+	QVERIFY(file.open(QIODevice::Append));
+	QVERIFY(file.write("\n") == 1);
+	file.close();
+
+	PositionIndex index;
+	QVERIFY(!index.open(m_indexFileName, m_pgnFileName));
+	QVERIFY(!index.isOpen());
+}
+
+QTEST_MAIN(tst_PositionIndex)
+#include "tst_positionindex.moc"
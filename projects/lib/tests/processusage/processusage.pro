@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_processusage
+SOURCES += tst_processusage.cpp
@@ -0,0 +1,52 @@
+#include <QtTest/QtTest>
+#include <processusage.h>
+
+class tst_ProcessUsage: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void null() const;
+		void sample() const;
+};
+
+void tst_ProcessUsage::null() const
+{
+	QVERIFY(ProcessUsage().isNull());
+	QVERIFY(ProcessUsage::sample(0).isNull());
+	QVERIFY(ProcessUsage().since(ProcessUsage()).isNull());
+}
+
+void tst_ProcessUsage::sample() const
+{
+#if !defined(Q_OS_WIN) && !defined(Q_OS_LINUX)
+	QSKIP("Process usage is not supported on this platform");
+#endif
+	const qint64 pid = QCoreApplication::applicationPid();
+	const ProcessUsage start = ProcessUsage::sample(pid);
+	QVERIFY(!start.isNull());
+	QVERIFY(start.cpuTime() >= 0);
+	QVERIFY(start.peakMemory() > 0);
+
+	// Burn some CPU time
+	QElapsedTimer timer;
+	timer.start();
+	volatile quint64 x = 0;
+	while (timer.elapsed() < 100)
+		x = x + 1;
+
+	const ProcessUsage end = ProcessUsage::sample(pid);
+	QVERIFY(end.cpuTime() >= start.cpuTime());
+
+	const ProcessUsage usage = end.since(start);
+	QVERIFY(usage.cpuTime() >= 0);
+	QVERIFY(usage.cpuTime() <= end.cpuTime());
+	QCOMPARE(usage.peakMemory(), end.peakMemory());
+#ifdef Q_OS_LINUX
+	QVERIFY(usage.voluntarySwitches() >= 0);
+	QVERIFY(usage.involuntarySwitches() >= 0);
+#endif
+}
+
+QTEST_MAIN(tst_ProcessUsage)
+#include "tst_processusage.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_ratingsdatabase
+SOURCES += tst_ratingsdatabase.cpp
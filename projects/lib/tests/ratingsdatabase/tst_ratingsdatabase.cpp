@@ -0,0 +1,126 @@
+#include <QtTest/QtTest>
+#include <cmath>
+#include <ratingsdatabase.h>
+#include <ratingsolver.h>
+
+class tst_RatingsDatabase: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void addGames();
+		void solve();
+		void saveAndLoad();
+		void invalidFile();
+
+	private:
+		QTemporaryDir m_dir;
+};
+
+void tst_RatingsDatabase::addGames()
+{
+	RatingsDatabase db;
+	const Chess::Result whiteWins(Chess::Result::Win, Chess::Side::White);
+	const Chess::Result draw(Chess::Result::Draw);
+
+	QVERIFY(db.addGame("run1", 1, "A", "B", whiteWins));
+	QVERIFY(db.addGame("run1", 2, "B", "A", draw));
+	// The same game again, and an unfinished game
+	QVERIFY(!db.addGame("run1", 1, "A", "B", whiteWins));
+	QVERIFY(!db.addGame("run1", 3, "A", "B", Chess::Result()));
+	QVERIFY(db.addGame("run2", 1, "B", "C", whiteWins));
+
+	QCOMPARE(db.gameCount(), 3);
+	QCOMPARE(db.playerCount(), 3);
+
+	const RatingsDatabase::Player& a = db.player(db.playerIndex("A"));
+	QCOMPARE(a.games, 2);
+	QCOMPARE(a.points, 3);
+	QCOMPARE(a.draws, 1);
+	const RatingsDatabase::Player& b = db.player(db.playerIndex("B"));
+	QCOMPARE(b.games, 3);
+	QCOMPARE(b.points, 3);
+	QCOMPARE(db.playerIndex("D"), -1);
+}
+
+void tst_RatingsDatabase::solve()
+{
+	RatingsDatabase db;
+	RatingSolver solver(3);
+	const Chess::Result whiteWins(Chess::Result::Win, Chess::Side::White);
+	const Chess::Result draw(Chess::Result::Draw);
+
+	int index = 0;
+	for (int i = 0; i < 30; i++)
+	{
+		db.addGame("run", ++index, "A", "B", whiteWins);
+		db.addGame("run", ++index, "B", "C", i % 3 ? whiteWins : draw);
+		db.addGame("run", ++index, "A", "C", draw);
+		solver.addGame(0, 1, 2);
+		solver.addGame(1, 2, i % 3 ? 2 : 1);
+		solver.addGame(0, 2, 1);
+	}
+	QVERIFY(db.solve());
+	QVERIFY(solver.solve());
+
+	for (int i = 0; i < 3; i++)
+		QVERIFY(std::fabs(db.player(i).rating - solver.rating(i)) < 0.01);
+	QCOMPARE(db.ranking(), QVector<int>() << 0 << 1 << 2);
+
+	// A new game refits from the previous ratings
+	const double rating = db.player(0).rating;
+	db.addGame("run", ++index, "C", "A", whiteWins);
+	QVERIFY(db.solve());
+	QVERIFY(db.player(0).rating < rating);
+}
+
+void tst_RatingsDatabase::saveAndLoad()
+{
+	QVERIFY(m_dir.isValid());
+	const QString fileName(m_dir.path() + "/ratings.bin");
+	const Chess::Result whiteWins(Chess::Result::Win, Chess::Side::White);
+	const Chess::Result blackWins(Chess::Result::Win, Chess::Side::Black);
+
+	RatingsDatabase db;
+	QVERIFY(db.load(fileName));
+	QCOMPARE(db.playerCount(), 0);
+
+	db.addGame("run", 1, "A", "B", whiteWins);
+	db.addGame("run", 2, "B", "A", blackWins);
+	db.addGame("run", 3, "C", "A", whiteWins);
+	db.solve();
+	QVERIFY(db.save(fileName));
+
+	RatingsDatabase loaded;
+	QVERIFY(loaded.load(fileName));
+	QCOMPARE(loaded.playerCount(), 3);
+	QCOMPARE(loaded.gameCount(), 3);
+	for (int i = 0; i < 3; i++)
+	{
+		QCOMPARE(loaded.player(i).name, db.player(i).name);
+		QCOMPARE(loaded.player(i).rating, db.player(i).rating);
+		QCOMPARE(loaded.player(i).games, db.player(i).games);
+		QCOMPARE(loaded.player(i).points, db.player(i).points);
+	}
+
+	// The added games are remembered
+	QVERIFY(!loaded.addGame("run", 2, "B", "A", blackWins));
+	QVERIFY(loaded.addGame("run", 4, "B", "A", blackWins));
+}
+
+void tst_RatingsDatabase::invalidFile()
+{
+	QVERIFY(m_dir.isValid());
+	const QString fileName(m_dir.path() + "/invalid.bin");
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write("not a ratings database");
+	file.close();
+
+	RatingsDatabase db;
+	QVERIFY(!db.load(fileName));
+}
+
+QTEST_MAIN(tst_RatingsDatabase)
+#include "tst_ratingsdatabase.moc"
@@ -0,0 +1,124 @@
+#include <QtTest/QtTest>
+#include <cmath>
+#include <ratingsolver.h>
+
+
+class tst_RatingSolver: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initialValues();
+		void twoPlayers();
+		void roundRobin();
+		void warmStart();
+		void separateGroups();
+};
+
+
+void tst_RatingSolver::initialValues()
+{
+	RatingSolver solver(3);
+	QCOMPARE(solver.playerCount(), 3);
+	QVERIFY(solver.solve());
+	QCOMPARE(solver.games(0), 0);
+	QCOMPARE(solver.rating(0), 0.0);
+	QCOMPARE(solver.errorMargin(0), 0.0);
+	QCOMPARE(solver.superiority(0, 1), 0.5);
+}
+
+void tst_RatingSolver::twoPlayers()
+{
+	// 75% score, 300 games plus one virtual draw
+	RatingSolver solver(2);
+	for (int i = 0; i < 100; i++)
+	{
+		solver.addGame(0, 1, 2);
+		solver.addGame(0, 1, 2);
+		solver.addGame(1, 0, 2);
+	}
+	QVERIFY(solver.solve());
+	QCOMPARE(solver.games(0), 300);
+
+	const double diff = solver.rating(0) - solver.rating(1);
+	const double p = 200.5 / 301.0;
+	QVERIFY(std::fabs(diff - 400.0 * std::log10(p / (1.0 - p))) < 0.01);
+	QVERIFY(std::fabs(solver.rating(0) + solver.rating(1)) < 0.01);
+	QVERIFY(solver.errorMargin(0) > 10.0);
+	QVERIFY(solver.errorMargin(0) < 50.0);
+	QVERIFY(solver.superiority(0, 1) > 0.999);
+	QVERIFY(std::fabs(solver.superiority(0, 1)
+			  + solver.superiority(1, 0) - 1.0) < 1.0e-9);
+}
+
+void tst_RatingSolver::roundRobin()
+{
+	// Every player scores 2/3 against the next one; the parallel
+	// updates are used with this many players
+	const int count = 20;
+	RatingSolver solver(count);
+	for (int i = 0; i + 1 < count; i++)
+	{
+		for (int j = 0; j < 100; j++)
+		{
+			solver.addGame(i, i + 1, 2);
+			solver.addGame(i, i + 1, 2);
+			solver.addGame(i + 1, i, 2);
+		}
+	}
+	QVERIFY(solver.solve());
+
+	double sum = 0.0;
+	for (int i = 0; i < count; i++)
+		sum += solver.rating(i);
+	QVERIFY(std::fabs(sum) < 0.1);
+
+	for (int i = 0; i + 1 < count; i++)
+	{
+		const double diff = solver.rating(i) - solver.rating(i + 1);
+		QVERIFY(diff > 110.0);
+		QVERIFY(diff < 125.0);
+		QVERIFY(solver.superiority(i, i + 1) > 0.99);
+	}
+	// The players at the ends have met only one opponent
+	QVERIFY(solver.errorMargin(0) > solver.errorMargin(count / 2));
+}
+
+void tst_RatingSolver::warmStart()
+{
+	RatingSolver solver(3);
+	solver.addGame(0, 1, 2);
+	solver.addGame(1, 2, 1);
+	solver.addGame(2, 0, 0);
+	QVERIFY(solver.solve());
+	const double rating = solver.rating(0);
+	const double margin = solver.errorMargin(0);
+
+	// Solving the same results again gives the same ratings
+	QVERIFY(solver.solve());
+	QVERIFY(std::fabs(solver.rating(0) - rating) < 0.01);
+
+	solver.addGame(0, 2, 0);
+	QVERIFY(solver.solve());
+	QVERIFY(solver.rating(0) < rating);
+	// The error margin follows the new game
+	QVERIFY(solver.errorMargin(0) < margin);
+
+	solver.reset(3);
+	QCOMPARE(solver.games(0), 0);
+	QCOMPARE(solver.rating(0), 0.0);
+}
+
+void tst_RatingSolver::separateGroups()
+{
+	RatingSolver solver(4);
+	solver.addGame(0, 1, 2);
+	solver.addGame(2, 3, 0);
+	solver.solve();
+
+	QVERIFY(std::isinf(solver.errorMargin(0)));
+	QCOMPARE(solver.superiority(0, 2), 0.5);
+}
+
+QTEST_MAIN(tst_RatingSolver)
+#include "tst_ratingsolver.moc"
@@ -9,6 +9,8 @@ class tst_Sprt: public QObject
 	private slots:
 		void sprt_data() const;
 		void sprt();
+		void pentanomial_data() const;
+		void pentanomial();
 
 	private:
 		bool fuzzyCompare(double val1, double val2);
@@ -100,5 +102,75 @@ void tst_Sprt::sprt()
 	QVERIFY(fuzzyCompare(status.uBound, ubound));
 }
 
+void tst_Sprt::pentanomial_data() const
+{
+	QTest::addColumn<double>("elo0");
+	QTest::addColumn<double>("elo1");
+	QTest::addColumn<QList<int> >("pairs");
+	QTest::addColumn<double>("llr");
+	QTest::addColumn<int>("result");
+
+	QTest::newRow("h1")
+		<< 0.0
+		<< 5.0
+		<< (QList<int>() << 50 << 400 << 1100 << 450 << 60)
+		<< 1.86
+		<< int(Sprt::Continue);
+
+	QTest::newRow("wide")
+		<< 0.0
+		<< 10.0
+		<< (QList<int>() << 300 << 400 << 600 << 400 << 300)
+		<< -2.07
+		<< int(Sprt::Continue);
+
+	QTest::newRow("h0")
+		<< 0.0
+		<< 5.0
+		<< (QList<int>() << 100 << 600 << 1400 << 500 << 90)
+		<< -6.56
+		<< int(Sprt::AcceptH0);
+
+	QTest::newRow("empty")
+		<< 0.0
+		<< 5.0
+		<< (QList<int>() << 0 << 0 << 0 << 0 << 0)
+		<< 0.0
+		<< int(Sprt::Continue);
+}
+
+void tst_Sprt::pentanomial()
+{
+	QFETCH(double, elo0);
+	QFETCH(double, elo1);
+	QFETCH(QList<int>, pairs);
+	QFETCH(double, llr);
+	QFETCH(int, result);
+
+	Sprt sprt;
+	sprt.initialize(elo0, elo1, 0.05, 0.05);
+	sprt.setModel(Sprt::Pentanomial);
+
+	// One pair for each score from 0 to 2 points
+	const Sprt::GameResult pairResults[5][2] = {
+		{ Sprt::Loss, Sprt::Loss },
+		{ Sprt::Loss, Sprt::Draw },
+		{ Sprt::Draw, Sprt::Draw },
+		{ Sprt::Draw, Sprt::Win },
+		{ Sprt::Win, Sprt::Win }
+	};
+	for (int i = 0; i < 5; i++)
+	{
+		for (int j = 0; j < pairs.at(i); j++)
+			sprt.addGamePair(pairResults[i][0], pairResults[i][1]);
+	}
+	// Incomplete pairs are ignored
+	sprt.addGamePair(Sprt::Win, Sprt::NoResult);
+
+	Sprt::Status status = sprt.status();
+	QVERIFY(fuzzyCompare(status.llr, llr));
+	QCOMPARE(int(status.result), result);
+}
+
 QTEST_MAIN(tst_Sprt)
 #include "tst_sprt.moc"
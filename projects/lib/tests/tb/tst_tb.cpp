@@ -110,6 +110,25 @@ void tst_Tb::positions()
 	unsigned int tbDtz = 0;
 	QCOMPARE(m_board.tablebaseResult(&tbDtz).toShortString(), result);
 	QCOMPARE(int(tbDtz), dtz);
+
+	// The board probes with its bitboards, which must give the
+	// same result as a list of the pieces
+	SyzygyTablebase::PieceList pieces;
+	for (int rank = 0; rank < 8; rank++)
+	{
+		for (int file = 0; file < 8; file++)
+		{
+			const Chess::Square square(file, rank);
+			const Chess::Piece piece(m_board.pieceAt(square));
+			if (piece.isValid())
+				pieces.append(qMakePair(square, piece));
+		}
+	}
+	const Chess::Result listResult = SyzygyTablebase::result(
+		m_board.sideToMove(), Chess::Square(), 0,
+		m_board.reversibleMoveCount(), pieces);
+	QCOMPARE(listResult.toShortString(),
+		 m_board.tablebaseResult().toShortString());
 }
 
 QTEST_MAIN(tst_Tb)
@@ -1,5 +1,14 @@
 TEMPLATE = subdirs
-SUBDIRS = chessboard tb sprt mersenne tournamentplayer tournamentpair polyglotbook
+SUBDIRS = chessboard tb sprt mersenne tournamentplayer tournamentpair polyglotbook \
+          gamearchive gzipdevice positionindex keyset openingprefetcher \
+          enginehandshakecache cpuaffinity processusage \
+          hostload gamemanager eventring clockservice ratingsolver \
+          pgnentryindex worker movetimestats indexpermutation \
+          trainingdata gamepool pgntaglist cgroup \
+          throughputstats tracer memorystats bootstrapratings\
+          pgnduplicatefinder openingtree gameresultcache pgntagpool\
+          ratingsdatabase hostcalibration gameadjudicator epdrecord \
+          openingcache
 win32 {
     SUBDIRS += pipereader
 }
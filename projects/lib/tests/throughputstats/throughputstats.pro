@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_throughputstats
+SOURCES += tst_throughputstats.cpp
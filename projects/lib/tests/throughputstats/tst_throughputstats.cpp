@@ -0,0 +1,80 @@
+#include <QtTest/QtTest>
+#include <throughputstats.h>
+
+class tst_ThroughputStats: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void empty() const;
+		void games() const;
+		void percentiles() const;
+		void setupTime() const;
+};
+
+void tst_ThroughputStats::empty() const
+{
+	ThroughputStats stats;
+	QCOMPARE(stats.gameCount(), 0);
+	QCOMPARE(stats.gamesPerHour(1000), 0.0);
+	QCOMPARE(stats.averageDuration(), Q_INT64_C(0));
+	QCOMPARE(stats.durationPercentile(50), Q_INT64_C(0));
+	QCOMPARE(stats.averageSetupTime(), Q_INT64_C(-1));
+	QCOMPARE(stats.eta(1000, 10), Q_INT64_C(-1));
+	QCOMPARE(stats.eta(1000, 0), Q_INT64_C(0));
+
+	// A game that never started isn't counted
+	stats.addGameEnd(1, 5000, 40);
+	QCOMPARE(stats.gameCount(), 0);
+}
+
+void tst_ThroughputStats::games() const
+{
+	// Two slots, each playing a game per 10 minutes
+	ThroughputStats stats;
+	stats.addGameStart(1, 0);
+	stats.addGameStart(2, 0);
+	stats.addGameEnd(1, 600000, 80);
+	stats.addGameEnd(2, 600000, 120);
+
+	QCOMPARE(stats.gameCount(), 2);
+	QCOMPARE(stats.gamesPerHour(600000), 12.0);
+	QCOMPARE(stats.averageDuration(), Q_INT64_C(600000));
+	QCOMPARE(stats.averagePlies(), 100.0);
+	QCOMPARE(stats.eta(600000, 8), Q_INT64_C(2400000));
+}
+
+void tst_ThroughputStats::percentiles() const
+{
+	ThroughputStats stats;
+	for (int i = 1; i <= 10; i++)
+	{
+		stats.addGameStart(i, 0);
+		stats.addGameEnd(i, i * 1000, 0);
+	}
+
+	QCOMPARE(stats.durationPercentile(0), Q_INT64_C(1));
+	QCOMPARE(stats.durationPercentile(50), Q_INT64_C(5));
+	QCOMPARE(stats.durationPercentile(90), Q_INT64_C(9));
+	QCOMPARE(stats.durationPercentile(95), Q_INT64_C(10));
+	QCOMPARE(stats.durationPercentile(100), Q_INT64_C(10));
+}
+
+void tst_ThroughputStats::setupTime() const
+{
+	ThroughputStats stats;
+	stats.addGameStart(1, 0);
+	stats.addGameStart(2, 0);
+	QCOMPARE(stats.averageSetupTime(), Q_INT64_C(-1));
+
+	stats.addGameEnd(1, 1000, 0);
+	stats.addGameEnd(2, 2000, 0);
+	stats.addGameStart(3, 1500);
+	stats.addGameStart(4, 2100);
+
+	// 500 and 100 ms, whichever slot each game took
+	QCOMPARE(stats.averageSetupTime(), Q_INT64_C(300));
+}
+
+QTEST_MAIN(tst_ThroughputStats)
+#include "tst_throughputstats.moc"
@@ -63,6 +63,8 @@ class tst_TournamentPlayer: public QObject
 		void initialValues();
 		void setName();
 		void addScore();
+		void addPonderStats();
+		void addStopLatency();
 
 		void cleanupTestCase();
 
@@ -99,6 +101,8 @@ void tst_TournamentPlayer::initialValues()
 	QCOMPARE(m_player->draws(), 0);
 	QCOMPARE(m_player->losses(), 0);
 	QCOMPARE(m_player->gamesFinished(), 0);
+	QCOMPARE(m_player->ponderedMoves(), 0);
+	QCOMPARE(m_player->ponderHits(), 0);
 }
 
 void tst_TournamentPlayer::setName()
@@ -133,5 +137,28 @@ void tst_TournamentPlayer::addScore()
 	QCOMPARE(m_player->losses(), 1);
 }
 
+void tst_TournamentPlayer::addPonderStats()
+{
+	m_player->addPonderStats(30, 12);
+	m_player->addPonderStats(0, 0);
+	m_player->addPonderStats(20, 18);
+	QCOMPARE(m_player->ponderedMoves(), 50);
+	QCOMPARE(m_player->ponderHits(), 30);
+}
+
+void tst_TournamentPlayer::addStopLatency()
+{
+	QCOMPARE(m_player->stopCount(), 0);
+	QCOMPARE(m_player->averageStopLatency(), 0);
+
+	m_player->addStopLatency(10, false);
+	m_player->addStopLatency(50, false);
+	m_player->addStopLatency(3000, true);
+	QCOMPARE(m_player->stopCount(), 3);
+	QCOMPARE(m_player->averageStopLatency(), 1020);
+	QCOMPARE(m_player->maxStopLatency(), 3000);
+	QCOMPARE(m_player->stopTimeouts(), 1);
+}
+
 QTEST_MAIN(tst_TournamentPlayer)
 #include "tst_tournamentplayer.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_tracer
+SOURCES += tst_tracer.cpp
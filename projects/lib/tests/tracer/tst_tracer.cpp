@@ -0,0 +1,115 @@
+#include <QtTest/QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <tracer.h>
+
+class tst_Tracer: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void disabled() const;
+		void write() const;
+};
+
+static QJsonArray readEvents(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return QJsonArray();
+
+	QJsonParseError error;
+	const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+	if (error.error != QJsonParseError::NoError)
+		return QJsonArray();
+	return doc.object().value("traceEvents").toArray();
+}
+
+static QJsonObject findEvent(const QJsonArray& events, const QString& name)
+{
+	for (const QJsonValue& value : events)
+	{
+		const QJsonObject event = value.toObject();
+		if (event.value("name").toString() == name)
+			return event;
+	}
+	return QJsonObject();
+}
+
+void tst_Tracer::disabled() const
+{
+	QVERIFY(!Tracer::isEnabled());
+	{
+		TraceSpan span("test", "span");
+		QVERIFY(!span.isRecorded());
+	}
+	Tracer::begin("test", "async", this);
+	Tracer::end("test", "async", this);
+	Tracer::instant("test", "instant");
+	QCOMPARE(Tracer::eventCount(), 0);
+}
+
+void tst_Tracer::write() const
+{
+	Tracer::setEnabled(true);
+	{
+		TraceSpan span("test", "span");
+		QVERIFY(span.isRecorded());
+		span.setDetail("a \"quoted\"\tdetail");
+	}
+	Tracer::begin("test", "async", this);
+	Tracer::end("test", "async", this);
+
+	// The events of another thread go to a buffer of their own
+	QThread thread;
+	thread.setObjectName("worker");
+	connect(&thread, &QThread::started, [&thread]()
+	{
+		Tracer::instant("test", "instant");
+		thread.quit();
+	});
+	thread.start();
+	QVERIFY(thread.wait(5000));
+
+	Tracer::setEnabled(false);
+	Tracer::instant("test", "ignored");
+	QCOMPARE(Tracer::eventCount(), 4);
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path() + "/trace.json";
+	QVERIFY(Tracer::write(fileName));
+
+	const QJsonArray events = readEvents(fileName);
+	QCOMPARE(events.size(), 6);
+
+	const QJsonObject span = findEvent(events, "span");
+	QCOMPARE(span.value("ph").toString(), QString("X"));
+	QCOMPARE(span.value("cat").toString(), QString("test"));
+	QVERIFY(span.value("dur").toDouble() >= 0);
+	QCOMPARE(span.value("args").toObject().value("detail").toString(),
+		 QString("a \"quoted\"\tdetail"));
+
+	const QJsonObject async = findEvent(events, "async");
+	QCOMPARE(async.value("ph").toString(), QString("b"));
+	QVERIFY(!async.value("id").toString().isEmpty());
+
+	const QJsonObject instant = findEvent(events, "instant");
+	QCOMPARE(instant.value("ph").toString(), QString("i"));
+	QVERIFY(instant.value("tid").toInt() != span.value("tid").toInt());
+
+	QStringList threadNames;
+	for (const QJsonValue& value : events)
+	{
+		const QJsonObject event = value.toObject();
+		if (event.value("ph").toString() == "M")
+			threadNames << event.value("args").toObject()
+					    .value("name").toString();
+	}
+	QCOMPARE(threadNames, QStringList() << "main" << "worker");
+	QVERIFY(findEvent(events, "ignored").isEmpty());
+}
+
+QTEST_MAIN(tst_Tracer)
+#include "tst_tracer.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_trainingdata
+SOURCES += tst_trainingdata.cpp
@@ -0,0 +1,161 @@
+#include <QtTest/QtTest>
+#include <trainingdata.h>
+
+class tst_TrainingData: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void packFen_data() const;
+		void packFen() const;
+		void invalidFen_data() const;
+		void invalidFen() const;
+		void packMove() const;
+		void roundTrip();
+		void append();
+};
+
+void tst_TrainingData::packFen_data() const
+{
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QString>("expected");
+
+	QTest::newRow("start")
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	QTest::newRow("en passant")
+		<< "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w Kq f6 0 3"
+		<< "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w Kq f6 0 1";
+	QTest::newRow("endgame")
+		<< "8/8/4k3/8/2R5/8/4K3/8 b - - 37 80"
+		<< "8/8/4k3/8/2R5/8/4K3/8 b - - 37 1";
+	QTest::newRow("shredder")
+		<< "rk2r3/8/8/8/8/8/8/RK1R4 w DAe - 0 1"
+		<< "rk2r3/8/8/8/8/8/8/RK1R4 w KQk - 0 1";
+	QTest::newRow("inner rook")
+		<< "1r1k2rr/8/8/8/8/8/8/1R1K2RR w Gb - 0 1"
+		<< "1r1k2rr/8/8/8/8/8/8/1R1K2RR w Gq - 0 1";
+}
+
+void tst_TrainingData::packFen() const
+{
+	QFETCH(QString, fen);
+	QFETCH(QString, expected);
+
+	TrainingData::Position pos;
+	QVERIFY(TrainingData::packFen(fen, pos));
+	QCOMPARE(TrainingData::unpackFen(pos), expected);
+}
+
+void tst_TrainingData::invalidFen_data() const
+{
+	QTest::addColumn<QString>("fen");
+
+	QTest::newRow("empty") << "";
+	QTest::newRow("ranks") << "8/8/8/8/8/8/8 w - - 0 1";
+	QTest::newRow("width") << "9/8/8/8/8/8/8/8 w - - 0 1";
+	QTest::newRow("side") << "8/8/8/8/8/8/8/8 x - - 0 1";
+	QTest::newRow("piece") << "a7/8/8/8/8/8/8/8 w - - 0 1";
+	QTest::newRow("castling") << "4k3/8/8/8/8/8/8/4K3 w K - 0 1";
+	QTest::newRow("holdings")
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[] w KQkq - 0 1";
+}
+
+void tst_TrainingData::invalidFen() const
+{
+	QFETCH(QString, fen);
+
+	TrainingData::Position pos;
+	QVERIFY(!TrainingData::packFen(fen, pos));
+}
+
+void tst_TrainingData::packMove() const
+{
+	const Chess::GenericMove move(Chess::Square(4, 6),
+				      Chess::Square(4, 7), 5);
+	const quint16 packed = TrainingData::packMove(move);
+	QCOMPARE(packed, quint16(52 | (60 << 6) | (5 << 12)));
+	QCOMPARE(TrainingData::unpackMove(packed), move);
+}
+
+void tst_TrainingData::roundTrip()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/data.cctd");
+
+	const int count = TrainingData::BlockSize + 10;
+	TrainingData data;
+	QVERIFY(data.open(fileName, QIODevice::WriteOnly));
+	for (int i = 0; i < count; i++)
+	{
+		TrainingData::Position pos;
+		QVERIFY(TrainingData::packFen(
+			"8/8/4k3/8/2R5/8/4K3/8 b - - 37 80", pos));
+		pos.score = (i % 2) ? i : -i;
+		pos.depth = i % 300;
+		pos.move = quint16(i);
+		pos.result = TrainingData::Result(i % 4);
+		pos.flags = i % 8;
+		QVERIFY(data.write(pos));
+	}
+	data.close();
+
+	QVERIFY(data.open(fileName));
+	TrainingData::Position pos;
+	for (int i = 0; i < count; i++)
+	{
+		QVERIFY(data.read(pos));
+		QCOMPARE(pos.score, qBound(-32000, (i % 2) ? i : -i, 32000));
+		QCOMPARE(pos.depth, qMin(i % 300, 255));
+		QCOMPARE(pos.move, quint16(i));
+		QCOMPARE(int(pos.result), i % 4);
+		QCOMPARE(pos.flags, i % 8);
+		QCOMPARE(pos.halfMoveClock, 37);
+		QVERIFY(pos.blackToMove);
+	}
+	QVERIFY(!data.read(pos));
+}
+
+void tst_TrainingData::append()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/data.cctd");
+
+	TrainingData::Position pos;
+	QVERIFY(TrainingData::packFen(
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", pos));
+
+	TrainingData data;
+	for (int i = 0; i < 3; i++)
+	{
+		QVERIFY(data.open(fileName, QIODevice::Append));
+		pos.score = i;
+		QVERIFY(data.write(pos));
+		data.close();
+	}
+
+	// An incomplete block at the end is dropped
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::Append));
+	QCOMPARE(file.write("\x40\0\0\0\x01\0\0\0xyz", 11), qint64(11));
+	file.close();
+	QVERIFY(data.open(fileName, QIODevice::Append));
+	pos.score = 3;
+	QVERIFY(data.write(pos));
+	data.close();
+
+	QVERIFY(data.open(fileName));
+	for (int i = 0; i < 4; i++)
+	{
+		QVERIFY(data.read(pos));
+		QCOMPARE(pos.score, i);
+		QCOMPARE(TrainingData::unpackFen(pos),
+			 QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+	}
+	QVERIFY(!data.read(pos));
+}
+
+QTEST_MAIN(tst_TrainingData)
+#include "tst_trainingdata.moc"
@@ -0,0 +1,108 @@
+#include <QtTest/QtTest>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <worker.h>
+
+class TestWorker : public Worker
+{
+	public:
+		TestWorker(const QString& title,
+			   QStringList* log,
+			   QMutex* mutex,
+			   QSemaphore* gate = nullptr)
+			: Worker(title),
+			  m_log(log),
+			  m_mutex(mutex),
+			  m_gate(gate)
+		{
+		}
+
+	protected:
+		void work() override
+		{
+			if (m_gate != nullptr)
+				m_gate->acquire();
+
+			QMutexLocker locker(m_mutex);
+			m_log->append(cancelRequested() ? title() + "*" : title());
+		}
+
+	private:
+		QStringList* m_log;
+		QMutex* m_mutex;
+		QSemaphore* m_gate;
+};
+
+class tst_Worker: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void cancelTokens();
+		void priorities();
+};
+
+void tst_Worker::cancelTokens()
+{
+	CancelToken token;
+	const CancelToken copy(token);
+	QVERIFY(!copy.isCancelled());
+	token.cancel();
+	QVERIFY(copy.isCancelled());
+	QVERIFY(!CancelToken().isCancelled());
+
+	QStringList log;
+	QMutex mutex;
+	CancelToken group;
+	TestWorker a("a", &log, &mutex);
+	TestWorker b("b", &log, &mutex);
+	TestWorker c("c", &log, &mutex);
+	a.setAutoDelete(false);
+	b.setAutoDelete(false);
+	c.setAutoDelete(false);
+	a.setGroupToken(group);
+	b.setGroupToken(group);
+
+	// Cancelling one worker doesn't cancel the rest of its group
+	c.cancel();
+	c.run();
+	a.run();
+	group.cancel();
+	b.run();
+	QCOMPARE(log, QStringList() << "c*" << "a" << "b*");
+}
+
+void tst_Worker::priorities()
+{
+	QThreadPool* pool = Worker::threadPool();
+	QVERIFY(pool->maxThreadCount() >= 1);
+	const int maxThreads = pool->maxThreadCount();
+	pool->setMaxThreadCount(1);
+
+	QStringList log;
+	QMutex mutex;
+	QSemaphore gate;
+
+	// The first worker keeps the only thread busy until the rest
+	// are queued
+	(new TestWorker("first", &log, &mutex, &gate))->start();
+
+	auto background = new TestWorker("background", &log, &mutex);
+	background->setPriority(Worker::BackgroundPriority);
+	background->start();
+	(new TestWorker("normal", &log, &mutex))->start();
+	auto interactive = new TestWorker("interactive", &log, &mutex);
+	interactive->setPriority(Worker::InteractivePriority);
+	interactive->start();
+
+	gate.release();
+	QVERIFY(pool->waitForDone(10000));
+	pool->setMaxThreadCount(maxThreads);
+
+	QCOMPARE(log, QStringList() << "first" << "interactive"
+				    << "normal" << "background");
+}
+
+QTEST_MAIN(tst_Worker)
+#include "tst_worker.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_worker
+SOURCES += tst_worker.cpp
@@ -1,7 +1,7 @@
 CONFIG += ordered
 
 TEMPLATE = subdirs
-SUBDIRS = lib gui cli
+SUBDIRS = lib gui cli agent
 
 cli.depends = lib
 gui.depends = lib